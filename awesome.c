@@ -22,19 +22,26 @@
 #include "awesome.h"
 
 #include "banning.h"
+#include "bytecode.h"
 #include "common/atoms.h"
 #include "common/backtrace.h"
 #include "common/version.h"
 #include "common/xutil.h"
+#include "control.h"
 #include "xkb.h"
 #include "dbus.h"
 #include "event.h"
 #include "ewmh.h"
 #include "globalconf.h"
 #include "objects/client.h"
+#include "objects/drawable.h"
+#include "mouse.h"
 #include "objects/screen.h"
+#include "profile.h"
+#include "property.h"
 #include "spawn.h"
 #include "systray.h"
+#include "thumbnail.h"
 #include "xwindow.h"
 
 #include <getopt.h>
@@ -44,6 +51,7 @@
 #include <unistd.h>
 #include <signal.h>
 #include <sys/time.h>
+#include <time.h>
 
 #include <xcb/bigreq.h>
 #include <xcb/randr.h>
@@ -53,6 +61,8 @@
 #include <xcb/xinerama.h>
 #include <xcb/xtest.h>
 #include <xcb/shape.h>
+#include <xcb/composite.h>
+#include <xcb/damage.h>
 
 #include <glib-unix.h>
 
@@ -79,6 +89,8 @@ awesome_atexit(bool restart)
     lua_pushboolean(L, restart);
     signal_object_emit(L, &global_signals, "exit", 1);
 
+    profile_dump();
+
     /* Move clients where we want them to be and keep the stacking order intact */
     foreach(c, globalconf.stack)
     {
@@ -98,6 +110,8 @@ awesome_atexit(bool restart)
 
     a_dbus_cleanup();
 
+    control_cleanup();
+
     systray_cleanup();
 
     /* Close Lua */
@@ -115,6 +129,8 @@ awesome_atexit(bool restart)
 
     xkb_free();
 
+    arena_wipe(&globalconf.arena);
+
     /* Disconnect *after* closing lua */
     xcb_cursor_context_free(globalconf.cursor_ctx);
     xcb_disconnect(globalconf.connection);
@@ -153,24 +169,30 @@ restore_client_order(xcb_get_property_cookie_t prop_cookie)
     p_delete(&reply);
 }
 
+/** Number of windows scan() sends requests for at once */
+#define SCAN_BATCH_SIZE 32
+
 /** Scan X to find windows to manage.
  */
 static void
 scan(xcb_query_tree_cookie_t tree_c)
 {
-    int i, tree_c_len;
+    int i, tree_c_len, managed = 0;
     xcb_query_tree_reply_t *tree_r;
     xcb_window_t *wins = NULL;
-    xcb_get_window_attributes_reply_t *attr_r;
-    xcb_get_geometry_reply_t *geom_r;
     xcb_get_property_cookie_t prop_cookie;
 
+    profile_scan_begin();
+
     tree_r = xcb_query_tree_reply(globalconf.connection,
                                   tree_c,
                                   NULL);
 
     if(!tree_r)
+    {
+        profile_scan_end(0);
         return;
+    }
 
     /* This gets the property and deletes it */
     prop_cookie = xcb_get_property_unchecked(globalconf.connection, true,
@@ -195,33 +217,59 @@ scan(xcb_query_tree_cookie_t tree_c)
         geom_wins[i] = xcb_get_geometry_unchecked(globalconf.connection, wins[i]);
     }
 
-    for(i = 0; i < tree_c_len; i++)
+    /* Manage the windows in batches: first send the requests for all windows
+     * of a batch, then process the replies. This avoids a round trip per
+     * property and window. */
+    for(int start = 0; start < tree_c_len; start += SCAN_BATCH_SIZE)
     {
-        attr_r = xcb_get_window_attributes_reply(globalconf.connection,
-                                                 attr_wins[i],
-                                                 NULL);
-        geom_r = xcb_get_geometry_reply(globalconf.connection, geom_wins[i], NULL);
-
-        long state = xwindow_get_state_reply(state_wins[i]);
+        int end = MIN(start + SCAN_BATCH_SIZE, tree_c_len);
+        xcb_get_window_attributes_reply_t *attr_r[SCAN_BATCH_SIZE];
+        xcb_get_geometry_reply_t *geom_r[SCAN_BATCH_SIZE];
+        client_manage_cookies_t manage_c[SCAN_BATCH_SIZE];
 
-        if(!geom_r || !attr_r || attr_r->override_redirect
-           || attr_r->map_state == XCB_MAP_STATE_UNMAPPED
-           || state == XCB_ICCCM_WM_STATE_WITHDRAWN)
+        for(i = start; i < end; i++)
         {
-            p_delete(&attr_r);
-            p_delete(&geom_r);
-            continue;
+            int j = i - start;
+
+            attr_r[j] = xcb_get_window_attributes_reply(globalconf.connection,
+                                                        attr_wins[i],
+                                                        NULL);
+            geom_r[j] = xcb_get_geometry_reply(globalconf.connection, geom_wins[i], NULL);
+
+            long state = xwindow_get_state_reply(state_wins[i]);
+
+            if(!geom_r[j] || !attr_r[j] || attr_r[j]->override_redirect
+               || attr_r[j]->map_state == XCB_MAP_STATE_UNMAPPED
+               || state == XCB_ICCCM_WM_STATE_WITHDRAWN)
+            {
+                p_delete(&attr_r[j]);
+                p_delete(&geom_r[j]);
+                continue;
+            }
+
+            manage_c[j] = client_manage_request(wins[i]);
         }
 
-        client_manage(wins[i], geom_r, attr_r);
+        for(i = start; i < end; i++)
+        {
+            int j = i - start;
+
+            if(!attr_r[j])
+                continue;
+
+            client_manage(wins[i], geom_r[j], attr_r[j], &manage_c[j]);
+            managed++;
 
-        p_delete(&attr_r);
-        p_delete(&geom_r);
+            p_delete(&attr_r[j]);
+            p_delete(&geom_r[j]);
+        }
     }
 
     p_delete(&tree_r);
 
     restore_client_order(prop_cookie);
+
+    profile_scan_end(managed);
 }
 
 static void
@@ -357,39 +405,62 @@ static void
 a_xcb_check(void)
 {
     xcb_generic_event_t *mouse = NULL, *event;
+    event_array_t events;
+
+    event_array_init(&events);
 
+    /* Handling events can cause new ones to be read, so drain the queue until
+     * it is really empty. */
     while((event = poll_for_event()))
     {
-        /* We will treat mouse events later.
-         * We cannot afford to treat all mouse motion events,
-         * because that would be too much CPU intensive, so we just
-         * take the last we get after a bunch of events. */
-        if(XCB_EVENT_RESPONSE_TYPE(event) == XCB_MOTION_NOTIFY)
-        {
-            p_delete(&mouse);
-            mouse = event;
-        }
-        else
+        do
+            event_array_append(&events, event);
+        while((event = poll_for_event()));
+
+        if(globalconf.event_coalescing)
+            event_coalesce(&events);
+
+        foreach(_event, events)
         {
-            uint8_t type = XCB_EVENT_RESPONSE_TYPE(event);
-            if(mouse && (type == XCB_ENTER_NOTIFY || type == XCB_LEAVE_NOTIFY
-                        || type == XCB_BUTTON_PRESS || type == XCB_BUTTON_RELEASE))
+            event = *_event;
+            *_event = NULL;
+
+            /* We will treat mouse events later.
+             * We cannot afford to treat all mouse motion events,
+             * because that would be too much CPU intensive, so we just
+             * take the last we get after a bunch of events. */
+            if(XCB_EVENT_RESPONSE_TYPE(event) == XCB_MOTION_NOTIFY)
             {
-                /* Make sure enter/motion/leave/press/release events are handled
-                 * in the correct order */
-                event_handle(mouse);
                 p_delete(&mouse);
+                mouse = event;
+            }
+            else
+            {
+                uint8_t type = XCB_EVENT_RESPONSE_TYPE(event);
+                if(mouse && (type == XCB_ENTER_NOTIFY || type == XCB_LEAVE_NOTIFY
+                            || type == XCB_BUTTON_PRESS || type == XCB_BUTTON_RELEASE))
+                {
+                    /* Make sure enter/motion/leave/press/release events are handled
+                     * in the correct order */
+                    event_handle(mouse);
+                    p_delete(&mouse);
+                }
+                event_handle(event);
+                p_delete(&event);
             }
-            event_handle(event);
-            p_delete(&event);
         }
+        events.len = 0;
     }
+    event_array_wipe(&events);
 
     if(mouse)
     {
         event_handle(mouse);
         p_delete(&mouse);
     }
+
+    luaA_sync_fences_run(globalconf_get_lua_State());
+    drawable_fences_poll();
 }
 
 static gboolean
@@ -415,6 +486,9 @@ a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
 
     /* Do all deferred work now */
     awesome_refresh();
+    arena_reset(&globalconf.arena);
+    if (globalconf.gc_step > 0)
+        lua_gc(L, LUA_GCSTEP, globalconf.gc_step);
 
     /* Check if the Lua stack is the way it should be */
     if (lua_gettop(L) != 0) {
@@ -423,11 +497,27 @@ a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
         lua_settop(L, 0);
     }
 
-    /* Don't sleep if there is a pending event */
-    assert(globalconf.pending_event == NULL);
-    globalconf.pending_event = xcb_poll_for_event(globalconf.connection);
+    /* Don't sleep if there is a pending event. Lua might already have read
+     * one with awesome.has_pending_events(). */
+    if (globalconf.pending_event == NULL)
+        globalconf.pending_event = xcb_poll_for_event(globalconf.connection);
     if (globalconf.pending_event != NULL)
         timeout = 0;
+    /* Lua has more work queued in gears.scheduler */
+    if (globalconf.refresh_requested)
+    {
+        globalconf.refresh_requested = false;
+        timeout = 0;
+    }
+    /* A workarea was marked as outdated after it was recomputed */
+    if (screen_need_workarea_refresh())
+        timeout = 0;
+    /* The reply to an after_sync() request might already have been read */
+    if (luaA_sync_fences_poll())
+        timeout = 0;
+    /* Threaded drawables whose fence reply was read meanwhile; the worker
+     * thread wakes the main loop up once it is done */
+    drawable_fences_poll();
 
     /* Check how long this main loop iteration took */
     gettimeofday(&now, NULL);
@@ -443,6 +533,8 @@ a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
     res = g_poll(ufds, nfsd, timeout);
     saved_errno = errno;
     gettimeofday(&last_wakeup, NULL);
+    /* The pointer might have moved while we were sleeping */
+    mouse_pointer_invalidate();
     a_xcb_check();
     errno = saved_errno;
 
@@ -457,13 +549,19 @@ signal_fatal(int signum)
     fatal("signal %d, dumping backtrace\n%s", signum, buf.s);
 }
 
-/* Signal handler for SIGCHLD. Causes reap_children() to be called. */
+/* Signal handler for SIGCHLD. Causes reap_children() to be called.
+ * The time of the signal is passed along to measure the reap latency; it uses
+ * the clock of g_get_monotonic_time(), which is not async-signal-safe itself.
+ */
 static void
 signal_child(int signum)
 {
     assert(signum == SIGCHLD);
-    int res = write(sigchld_pipe[1], " ", 1);
-    assert(res == 1);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t now = (int64_t) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+    int res = write(sigchld_pipe[1], &now, sizeof(now));
+    assert(res == sizeof(now));
 }
 
 /* There was a SIGCHLD signal. Read from sigchld_pipe and reap children. */
@@ -472,16 +570,23 @@ reap_children(GIOChannel *channel, GIOCondition condition, gpointer user_data)
 {
     pid_t child;
     int status;
-    char buffer[1024];
+    int64_t buffer[128];
+    spawn_exit_array_t exits;
     ssize_t result = read(sigchld_pipe[0], &buffer[0], sizeof(buffer));
     if (result < 0)
         fatal("Error reading from signal pipe: %s", strerror(errno));
 
-    while ((child = waitpid(-1, &status, WNOHANG)) > 0) {
-        spawn_child_exited(child, status);
-    }
+    /* Reap everything first and then run all exit callbacks at once */
+    spawn_exit_array_init(&exits);
+    while ((child = waitpid(-1, &status, WNOHANG)) > 0)
+        spawn_exit_array_append(&exits, (spawn_exit_t) { .pid = child, .status = status });
     if (child < 0 && errno != ECHILD)
         warn("waitpid(-1) failed: %s", strerror(errno));
+
+    /* The oldest signal is the one the first child caused */
+    spawn_children_exited(&exits, result >= (ssize_t) sizeof(buffer[0])
+                          ? buffer[0] : g_get_monotonic_time());
+    spawn_exit_array_wipe(&exits);
     return TRUE;
 }
 
@@ -513,6 +618,16 @@ restart_on_signal(gpointer data)
     return TRUE;
 }
 
+/** Function to print the X reply statistics on SIGUSR2.
+ * \param data currently unused
+ */
+static gboolean
+xtrace_dump_on_signal(gpointer data)
+{
+    xtrace_dump(stderr);
+    return TRUE;
+}
+
 static bool
 true_config_callback(const char *unused)
 {
@@ -534,7 +649,11 @@ exit_help(int exit_code)
       --search DIR       add a directory to the library search path\n\
   -k, --check            check configuration file syntax\n\
   -a, --no-argb          disable client transparency support\n\
-  -r, --replace          replace an existing window manager\n");
+  -r, --replace          replace an existing window manager\n\
+      --profile          count X requests per refresh stage, trace X\n\
+                         replies and print a timing histogram on exit\n\
+      --no-bytecode-cache\n\
+                         always compile Lua files from source\n");
     exit(exit_code);
 }
 
@@ -553,6 +672,8 @@ main(int argc, char **argv)
     bool no_argb = false;
     bool run_test = false;
     bool replace_wm = false;
+    bool profile_enabled = false;
+    bool bytecode_cache = true;
     xcb_query_tree_cookie_t tree_c;
     static struct option long_options[] =
     {
@@ -563,6 +684,8 @@ main(int argc, char **argv)
         { "search",  1, NULL, 's' },
         { "no-argb", 0, NULL, 'a' },
         { "replace", 0, NULL, 'r' },
+        { "profile", 0, NULL, 'p' },
+        { "no-bytecode-cache", 0, NULL, '\2' },
         { "reap",    1, NULL, '\1' },
         { NULL,      0, NULL, 0 }
     };
@@ -613,6 +736,12 @@ main(int argc, char **argv)
           case 'r':
             replace_wm = true;
             break;
+          case 'p':
+            profile_enabled = true;
+            break;
+          case '\2':
+            bytecode_cache = false;
+            break;
           case '\1':
             /* Silently ignore --reap and its argument */
             break;
@@ -681,6 +810,7 @@ main(int argc, char **argv)
     g_unix_signal_add(SIGINT, exit_on_signal, NULL);
     g_unix_signal_add(SIGTERM, exit_on_signal, NULL);
     g_unix_signal_add(SIGHUP, restart_on_signal, NULL);
+    g_unix_signal_add(SIGUSR2, xtrace_dump_on_signal, NULL);
 
     struct sigaction sa = { .sa_handler = signal_fatal, .sa_flags = SA_RESETHAND };
     sigemptyset(&sa.sa_mask);
@@ -695,12 +825,18 @@ main(int argc, char **argv)
     sa.sa_flags = SA_NOCLDSTOP | SA_RESTART;
     sigaction(SIGCHLD, &sa, 0);
 
+    profile_init(profile_enabled);
+    bytecode_cache_init(&xdg, bytecode_cache);
+
     /* We have no clue where the input focus is right now */
     globalconf.focus.need_update = true;
 
     /* set the default preferred icon size */
     globalconf.preferred_icon_size = 0;
 
+    globalconf.event_coalescing = true;
+    globalconf.enter_leave_grab = true;
+
     /* X stuff */
     globalconf.connection = xcb_connect(NULL, &globalconf.default_screen);
     if(xcb_connection_has_error(globalconf.connection))
@@ -732,6 +868,8 @@ main(int argc, char **argv)
     xcb_prefetch_extension_data(globalconf.connection, &xcb_randr_id);
     xcb_prefetch_extension_data(globalconf.connection, &xcb_xinerama_id);
     xcb_prefetch_extension_data(globalconf.connection, &xcb_shape_id);
+    xcb_prefetch_extension_data(globalconf.connection, &xcb_composite_id);
+    xcb_prefetch_extension_data(globalconf.connection, &xcb_damage_id);
 
     if (xcb_cursor_context_new(globalconf.connection, globalconf.screen, &globalconf.cursor_ctx) < 0)
         fatal("Failed to initialize xcb-cursor");
@@ -793,6 +931,9 @@ main(int argc, char **argv)
         p_delete(&reply);
     }
 
+    /* check for composite and damage extensions */
+    thumbnail_init();
+
     event_init();
 
     /* Allocate the key symbols */
@@ -800,6 +941,7 @@ main(int argc, char **argv)
 
     /* init atom cache */
     atoms_init(globalconf.connection);
+    property_init();
 
     ewmh_init();
     systray_init();
@@ -135,6 +135,9 @@ set(AWESOME_DEPENDENCIES
     xcb-xtest
     xcb-xinerama
     xcb-shape
+    xcb-shm
+    xcb-composite
+    xcb-damage
     xcb-util
     xcb-util>=0.3.8
     xcb-keysyms
@@ -22,45 +22,85 @@
 #include "banning.h"
 #include "globalconf.h"
 #include "objects/client.h"
+#include "objects/tag.h"
 
-/** Reban windows following current selected tags.
+/** Clients whose visibility might have changed since the last refresh */
+static client_array_t banning_dirty;
+
+/** Reban a client whose visibility might have changed.
+ * \param c The client.
  */
 void
-banning_need_update(void)
+banning_client_need_update(client_t *c)
 {
-    /* We update the complete banning only once per main loop to avoid
-     * excessive updates...  */
-    globalconf.need_lazy_banning = true;
+    /* The client is being unmanaged */
+    if(c->window == XCB_NONE)
+        return;
 
-    /* But if a client will be banned in our next update we unfocus it now. */
-    foreach(_c, globalconf.clients)
+    if(!c->banning_dirty)
     {
-        client_t *c = *_c;
-
-        if(!client_isvisible(c))
-            client_ban_unfocus(c);
+        c->banning_dirty = true;
+        client_array_append(&banning_dirty, c);
     }
+
+    /* If the client will be banned in our next update we unfocus it now. */
+    if(!client_isvisible(c))
+        client_ban_unfocus(c);
 }
 
-/** Check all clients if they need to rebanned
+/** Reban all clients of a tag, for example because it was (de)selected.
+ * \param t The tag.
  */
 void
-banning_refresh(void)
+banning_tag_need_update(tag_t *t)
+{
+    foreach(c, t->clients)
+        banning_client_need_update(*c);
+}
+
+/** Drop a client which is being unmanaged from the pending updates.
+ * \param c The client.
+ */
+void
+banning_client_forget(client_t *c)
 {
-    if (!globalconf.need_lazy_banning)
+    if(!c->banning_dirty)
         return;
 
-    globalconf.need_lazy_banning = false;
+    c->banning_dirty = false;
+    foreach(elem, banning_dirty)
+        if(*elem == c)
+        {
+            client_array_remove(&banning_dirty, elem);
+            break;
+        }
+}
 
-    foreach(c, globalconf.clients)
+/** Check the clients whose visibility might have changed if they need to be
+ * rebanned.
+ */
+void
+banning_refresh(void)
+{
+    client_array_t dirty = banning_dirty;
+
+    /* Unbanning emits signals, so clients can be marked again while we
+     * process them. These end up in a new set which is handled next time. */
+    client_array_init(&banning_dirty);
+    foreach(c, dirty)
+        (*c)->banning_dirty = false;
+
+    foreach(c, dirty)
         if(client_isvisible(*c))
             client_unban(*c);
 
     /* Some people disliked the short flicker of background, so we first unban everything.
      * Afterwards we ban everything we don't want. This should avoid that. */
-    foreach(c, globalconf.clients)
+    foreach(c, dirty)
         if(!client_isvisible(*c))
             client_ban(*c);
+
+    client_array_wipe(&dirty);
 }
 
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
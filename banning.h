@@ -22,7 +22,12 @@
 #ifndef AWESOME_BANNING_H
 #define AWESOME_BANNING_H
 
-void banning_need_update(void);
+typedef struct client_t client_t;
+typedef struct tag tag_t;
+
+void banning_client_need_update(client_t *);
+void banning_tag_need_update(tag_t *);
+void banning_client_forget(client_t *);
 void banning_refresh(void);
 
 #endif
@@ -0,0 +1,282 @@
+/*
+ * bytecode.c - Lua bytecode cache
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* The configuration file and the Lua modules found through package.path are
+ * compiled once and their bytecode is kept in $XDG_CACHE_HOME/awesome/bytecode.
+ * Every cache file starts with a text header naming the Lua release, the
+ * source file and its modification time and size. A cache file whose header
+ * does not match the source file exactly, or whose bytecode cannot be loaded,
+ * is ignored and replaced after the source file was compiled again.
+ */
+
+#include "bytecode.h"
+#include "luaa.h"
+#include "common/buffer.h"
+
+#include <basedir_fs.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** The cache directory, NULL if the cache is disabled */
+static char *bytecode_dir;
+
+/** Enable the bytecode cache.
+ * \param xdg An xdg handle to use to get XDG basedir.
+ * \param enabled False if --no-bytecode-cache was given.
+ */
+void
+bytecode_cache_init(xdgHandle *xdg, bool enabled)
+{
+    if(!enabled)
+        return;
+
+    buffer_t buf;
+    buffer_init(&buf);
+    buffer_addf(&buf, "%s/awesome/bytecode", xdgCacheHome(xdg));
+    if(xdgMakePath(buf.s, S_IRWXU) && errno != EEXIST)
+    {
+        warn("cannot create bytecode cache directory %s: %s",
+             buf.s, strerror(errno));
+        buffer_wipe(&buf);
+        return;
+    }
+    bytecode_dir = buffer_detach(&buf);
+}
+
+static int
+bytecode_writer(lua_State *L, const void *p, size_t size, void *ud)
+{
+    buffer_add(ud, p, size);
+    return 0;
+}
+
+/** Read a cache file and load its bytecode if it matches a header.
+ * \param L The Lua VM state.
+ * \param cachepath The cache file.
+ * \param header The header the cache file must start with.
+ * \param path The source file, used as chunk name.
+ * \return True if the chunk was pushed on the stack.
+ */
+static bool
+bytecode_load(lua_State *L, const char *cachepath, buffer_t *header, const char *path)
+{
+    FILE *file = fopen(cachepath, "rb");
+    struct stat st;
+    bool ret = false;
+
+    if(!file)
+        return false;
+
+    if(fstat(fileno(file), &st) == 0 && st.st_size > (off_t) header->len)
+    {
+        size_t len = st.st_size;
+        char *data = p_new(char, len);
+
+        if(fread(data, 1, len, file) == len
+           && !memcmp(data, header->s, header->len))
+        {
+            buffer_t chunkname;
+            buffer_init(&chunkname);
+            buffer_addf(&chunkname, "@%s", path);
+#if LUA_VERSION_NUM >= 502
+            ret = !luaL_loadbufferx(L, data + header->len, len - header->len,
+                                    chunkname.s, "b");
+#else
+            ret = *(data + header->len) == LUA_SIGNATURE[0]
+                && !luaL_loadbuffer(L, data + header->len, len - header->len,
+                                    chunkname.s);
+#endif
+            if(!ret)
+                lua_pop(L, 1);
+            buffer_wipe(&chunkname);
+        }
+        p_delete(&data);
+    }
+
+    fclose(file);
+    return ret;
+}
+
+/** Write the bytecode of the function on top of the stack to a cache file.
+ * The file is written under a temporary name and then renamed, so that
+ * another instance never reads a partially written file.
+ * \param L The Lua VM state.
+ * \param cachepath The cache file.
+ * \param header The header to start the cache file with.
+ */
+static void
+bytecode_store(lua_State *L, const char *cachepath, buffer_t *header)
+{
+    buffer_t data, tmppath;
+    FILE *file;
+
+    buffer_init(&data);
+    buffer_add(&data, header->s, header->len);
+#if LUA_VERSION_NUM >= 503
+    lua_dump(L, bytecode_writer, &data, 0);
+#else
+    lua_dump(L, bytecode_writer, &data);
+#endif
+
+    buffer_init(&tmppath);
+    buffer_addf(&tmppath, "%s.%d", cachepath, (int) getpid());
+    if((file = fopen(tmppath.s, "wb")))
+    {
+        bool written = fwrite(data.s, 1, data.len, file) == (size_t) data.len;
+        if(fclose(file) || !written || rename(tmppath.s, cachepath))
+            unlink(tmppath.s);
+    }
+
+    buffer_wipe(&tmppath);
+    buffer_wipe(&data);
+}
+
+/** Load a Lua file, using its cached bytecode if it is up to date.
+ * This behaves like luaL_loadfile().
+ * \param L The Lua VM state.
+ * \param path The file to load.
+ * \return 0 and the chunk pushed on the stack, or an error code and the
+ * error message pushed on the stack.
+ */
+int
+luaA_loadfile_cached(lua_State *L, const char *path)
+{
+    struct stat st;
+
+    if(!bytecode_dir || stat(path, &st) || !S_ISREG(st.st_mode))
+        return luaL_loadfile(L, path);
+
+    buffer_t cachepath, header;
+    buffer_init(&cachepath);
+    buffer_addf(&cachepath, "%s/%08lx.luac", bytecode_dir,
+                a_strhash((const unsigned char *) path) & 0xffffffff);
+    buffer_init(&header);
+    buffer_addf(&header, "awesome bytecode\n%s %d\n%s\n%lld.%09ld %lld\n",
+                LUA_RELEASE, LUA_VERSION_NUM, path,
+                (long long) st.st_mtim.tv_sec, (long) st.st_mtim.tv_nsec,
+                (long long) st.st_size);
+
+    int ret = 0;
+    if(!bytecode_load(L, cachepath.s, &header, path)
+       && !(ret = luaL_loadfile(L, path)))
+        bytecode_store(L, cachepath.s, &header);
+
+    buffer_wipe(&header);
+    buffer_wipe(&cachepath);
+    return ret;
+}
+
+/** A package searcher looking for Lua modules in package.path, like Lua's
+ * own searcher, but loading them with luaA_loadfile_cached().
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_bytecode_searcher(lua_State *L)
+{
+    const char *name = luaL_checkstring(L, 1);
+    const char *path;
+
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "path");
+    path = lua_tostring(L, -1);
+    if(!path)
+        return 0;
+
+    /* Turn "a.b" into "a/b" */
+    buffer_t modpath, filename;
+    buffer_init(&modpath);
+    for(const char *c = name; *c; c++)
+        buffer_addc(&modpath, *c == '.' ? '/' : *c);
+
+    int ret = 0;
+    for(const char *end; *path; path = *end ? end + 1 : end)
+    {
+        if(!(end = strchr(path, ';')))
+            end = path + a_strlen(path);
+        if(end == path)
+            continue;
+
+        buffer_init(&filename);
+        for(const char *c = path; c < end; c++)
+            if(*c == '?')
+                buffer_add(&filename, modpath.s, modpath.len);
+            else
+                buffer_addc(&filename, *c);
+
+        if(!access(filename.s, R_OK))
+        {
+            if(luaA_loadfile_cached(L, filename.s))
+            {
+                lua_pushfstring(L, "error loading module '%s' from file '%s':\n\t%s",
+                                name, filename.s, lua_tostring(L, -1));
+                buffer_wipe(&filename);
+                buffer_wipe(&modpath);
+                return lua_error(L);
+            }
+            lua_pushstring(L, filename.s);
+            ret = 2;
+        }
+
+        buffer_wipe(&filename);
+        if(ret)
+            break;
+    }
+
+    buffer_wipe(&modpath);
+    return ret;
+}
+
+/** Install the bytecode searcher just after the preload searcher.
+ * Modules which are not found let the standard searchers run, so that C
+ * modules and custom searchers keep working.
+ * \param L The Lua VM state.
+ */
+void
+luaA_bytecode_cache_setup(lua_State *L)
+{
+    if(!bytecode_dir)
+        return;
+
+    lua_getglobal(L, "package");
+#if LUA_VERSION_NUM >= 502
+    lua_getfield(L, -1, "searchers");
+#else
+    lua_getfield(L, -1, "loaders");
+#endif
+    if(lua_istable(L, -1))
+    {
+        int n = luaA_rawlen(L, -1);
+        for(int i = n; i >= 2; i--)
+        {
+            lua_rawgeti(L, -1, i);
+            lua_rawseti(L, -2, i + 1);
+        }
+        lua_pushcfunction(L, luaA_bytecode_searcher);
+        lua_rawseti(L, -2, n >= 1 ? 2 : 1);
+    }
+    lua_pop(L, 2);
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
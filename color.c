@@ -22,6 +22,7 @@
 
 #include "color.h"
 #include "globalconf.h"
+#include "common/hash.h"
 
 #include <ctype.h>
 
@@ -29,6 +30,15 @@
 #define RGB_8TO16(i) (((i) & 0xff)   * 0x101)
 #define RGB_16TO8(i) (((i) & 0xffff) / 0x101)
 
+/** Maximum number of colors in allocated_colors */
+#define COLOR_CACHE_SIZE 256
+
+/** Colors allocated in the default colormap, indexed by 0xRRGGBB. Colors are
+ * never freed, so the same pixel can be used again without asking the X server.
+ */
+DO_HASH(uint32_t, color_t, allocated_color, a_inthash, a_inteq)
+static allocated_color_hash_t allocated_colors;
+
 /** Parse an hexadecimal color string to its component.
  * \param colstr The color string.
  * \param len The color string length.
@@ -158,6 +168,18 @@ color_init_unchecked(color_t *color, const char *colstr, ssize_t len, xcb_visual
         req.color->initialized = true;
         return req;
     }
+
+    req.rgb = (uint32_t) red << 16 | (uint32_t) green << 8 | blue;
+    color_t *cached = allocated_color_hash_lookup(&allocated_colors, req.rgb);
+    if (cached)
+    {
+        *req.color = *cached;
+        return req;
+    }
+
+    /* The color might have been used before, color_init_reply() must wait for
+     * the reply */
+    req.color->initialized = false;
     req.cookie_hexa = xcb_alloc_color_unchecked(globalconf.connection,
                                                 globalconf.default_cmap,
                                                 RGB_8TO16(red),
@@ -192,6 +214,10 @@ color_init_reply(color_init_request_t req)
         req.color->alpha = 0xffff;
         req.color->initialized = true;
         p_delete(&hexa_color);
+
+        if (allocated_colors.len >= COLOR_CACHE_SIZE)
+            allocated_color_hash_clear(&allocated_colors);
+        allocated_color_hash_insert(&allocated_colors, req.rgb, *req.color);
         return true;
     }
 
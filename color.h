@@ -43,6 +43,8 @@ typedef struct
     color_t *color;
     bool has_error;
     const char *colstr;
+    /** The requested color as 0xRRGGBB */
+    uint32_t rgb;
 } color_init_request_t;
 
 color_init_request_t color_init_unchecked(color_t *, const char *, ssize_t, xcb_visualtype_t *visual);
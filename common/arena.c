@@ -0,0 +1,108 @@
+/*
+ * arena.c - per main loop iteration allocator
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "common/arena.h"
+
+/** Smallest chunk which is allocated */
+#define ARENA_CHUNK_SIZE 16384
+
+/** Allocate zeroed memory which lives until the next arena_reset().
+ * \param arena The arena.
+ * \param size The number of bytes.
+ * \return The memory, suitably aligned for any type.
+ */
+void *
+arena_alloc(arena_t *arena, size_t size)
+{
+    arena_chunk_t *chunk = arena->chunks;
+
+    size = (size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+    if(!chunk || chunk->size - chunk->used < size)
+    {
+        size_t chunk_size = MAX(size, ARENA_CHUNK_SIZE);
+        chunk = xmalloc(sizeof(arena_chunk_t) + chunk_size);
+        chunk->size = chunk_size;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    void *res = chunk->data + chunk->used;
+    chunk->used += size;
+    arena->used += size;
+    arena->allocations++;
+    return memset(res, 0, size);
+}
+
+/** Copy a string into an arena.
+ * \param arena The arena.
+ * \param s The string.
+ * \param len The length of the string, without the trailing NUL.
+ * \return The NUL-terminated copy.
+ */
+char *
+arena_strndup(arena_t *arena, const char *s, size_t len)
+{
+    char *res = arena_alloc(arena, len + 1);
+    memcpy(res, s, len);
+    return res;
+}
+
+/** Release everything allocated from an arena.
+ * \param arena The arena.
+ */
+void
+arena_reset(arena_t *arena)
+{
+    arena_chunk_t *largest = arena->chunks;
+
+    for(arena_chunk_t *chunk = arena->chunks; chunk; chunk = chunk->next)
+        if(chunk->size > largest->size)
+            largest = chunk;
+
+    for(arena_chunk_t *chunk = arena->chunks, *next; chunk; chunk = next)
+    {
+        next = chunk->next;
+        if(chunk != largest)
+            p_delete(&chunk);
+    }
+
+    if(largest)
+    {
+        largest->next = NULL;
+        largest->used = 0;
+    }
+    arena->chunks = largest;
+    arena->peak = MAX(arena->peak, arena->used);
+    arena->used = 0;
+}
+
+/** Free all memory of an arena.
+ * \param arena The arena.
+ */
+void
+arena_wipe(arena_t *arena)
+{
+    arena_reset(arena);
+    p_delete(&arena->chunks);
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
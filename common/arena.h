@@ -0,0 +1,68 @@
+/*
+ * arena.h - per main loop iteration allocator header
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef AWESOME_COMMON_ARENA_H
+#define AWESOME_COMMON_ARENA_H
+
+#include <stddef.h>
+
+#include "common/util.h"
+
+/** Alignment of all allocations, enough for any type */
+#define ARENA_ALIGNMENT 16
+
+/** One block of memory of an arena */
+typedef struct arena_chunk_t
+{
+    struct arena_chunk_t *next;
+    size_t size, used;
+    char data[] __attribute__((aligned(ARENA_ALIGNMENT)));
+} arena_chunk_t;
+
+/** A bump allocator for temporary memory.
+ * Allocations are never freed individually; everything is released at once
+ * by arena_reset(). The largest chunk is kept around for reuse, so that an
+ * arena which is reset regularly settles down to a single chunk and does not
+ * allocate at all.
+ */
+typedef struct
+{
+    arena_chunk_t *chunks;
+    /** Bytes handed out since the last reset */
+    size_t used;
+    /** Most bytes handed out between two resets */
+    size_t peak;
+    /** Number of allocations since the arena was created */
+    unsigned long allocations;
+} arena_t;
+
+void *arena_alloc(arena_t *, size_t);
+char *arena_strndup(arena_t *, const char *, size_t);
+void arena_reset(arena_t *);
+void arena_wipe(arena_t *);
+
+/** Allocate zeroed objects from an arena. */
+#define arena_new(arena, type, count) \
+    ((type *) arena_alloc((arena), sizeof(type) * (count)))
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
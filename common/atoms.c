@@ -21,6 +21,7 @@
 
 #include "common/atoms.h"
 #include "common/util.h"
+#include "common/xtrace.h"
 
 typedef struct
 {
@@ -0,0 +1,119 @@
+/*
+ * bitset.h - small bit set handling header
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_COMMON_BITSET_H
+#define AWESOME_COMMON_BITSET_H
+
+#include <stdint.h>
+
+#include "common/util.h"
+
+#define BITSET_WORD_BITS 64
+
+/** A set of small integers.
+ * The first 64 bits are stored inline, so that the common case does not need
+ * any allocation and set operations are a single instruction.
+ */
+typedef struct
+{
+    /** Bits 0 to 63 */
+    uint64_t bits;
+    /** Bits 64 and up, or NULL */
+    uint64_t *ext;
+    /** Number of words in ext */
+    int ext_len;
+} bitset_t;
+
+static inline void
+bitset_wipe(bitset_t *b)
+{
+    p_delete(&b->ext);
+    p_clear(b, 1);
+}
+
+static inline bool
+bitset_test(const bitset_t *b, int i)
+{
+    if(i < BITSET_WORD_BITS)
+        return (b->bits >> i) & 1;
+
+    int w = i / BITSET_WORD_BITS - 1;
+    return w < b->ext_len && ((b->ext[w] >> (i % BITSET_WORD_BITS)) & 1);
+}
+
+static inline void
+bitset_set(bitset_t *b, int i)
+{
+    if(i < BITSET_WORD_BITS)
+    {
+        b->bits |= UINT64_C(1) << i;
+        return;
+    }
+
+    int w = i / BITSET_WORD_BITS - 1;
+    if(w >= b->ext_len)
+    {
+        p_realloc(&b->ext, w + 1);
+        p_clear(b->ext + b->ext_len, w + 1 - b->ext_len);
+        b->ext_len = w + 1;
+    }
+    b->ext[w] |= UINT64_C(1) << (i % BITSET_WORD_BITS);
+}
+
+static inline void
+bitset_unset(bitset_t *b, int i)
+{
+    if(i < BITSET_WORD_BITS)
+        b->bits &= ~(UINT64_C(1) << i);
+    else if(i / BITSET_WORD_BITS - 1 < b->ext_len)
+        b->ext[i / BITSET_WORD_BITS - 1] &= ~(UINT64_C(1) << (i % BITSET_WORD_BITS));
+}
+
+/** Check if two sets have at least one element in common. */
+static inline bool
+bitset_intersects(const bitset_t *a, const bitset_t *b)
+{
+    if(a->bits & b->bits)
+        return true;
+
+    for(int w = 0; w < MIN(a->ext_len, b->ext_len); w++)
+        if(a->ext[w] & b->ext[w])
+            return true;
+
+    return false;
+}
+
+/** Get the smallest integer which is not in the set. */
+static inline int
+bitset_first_unset(const bitset_t *b)
+{
+    if(~b->bits)
+        return __builtin_ctzll(~b->bits);
+
+    for(int w = 0; w < b->ext_len; w++)
+        if(~b->ext[w])
+            return (w + 1) * BITSET_WORD_BITS + __builtin_ctzll(~b->ext[w]);
+
+    return (b->ext_len + 1) * BITSET_WORD_BITS;
+}
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,165 @@
+/*
+ * hash.h - open addressing hash table handling header
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_COMMON_HASH_H
+#define AWESOME_COMMON_HASH_H
+
+#include <stdint.h>
+
+#include "common/util.h"
+
+/** Mix the bits of a 32 bit integer key (Murmur3 finalizer).
+ * X11 resource ids share their high bits per client connection, so using the
+ * raw value as a hash would only populate a few buckets.
+ */
+static inline uint32_t
+a_inthash(uint32_t key)
+{
+    key ^= key >> 16;
+    key *= 0x85ebca6b;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35;
+    key ^= key >> 16;
+    return key;
+}
+
+/** Hash a pointer value. */
+static inline uint32_t
+a_ptrhash(const void *ptr)
+{
+    uintptr_t key = (uintptr_t) ptr;
+    return a_inthash((uint32_t) (key ^ (key >> 16 >> 16)));
+}
+
+#define a_inteq(a, b) ((a) == (b))
+
+/** Common open addressing hash type.
+ * The table size is always zero or a power of two, so that the probe position
+ * can be computed with a mask.
+ */
+#define HASH_TYPE(key_t, value_t, pfx)                                      \
+    typedef struct pfx##_hash_slot_t {                                      \
+        key_t key;                                                          \
+        value_t value;                                                      \
+        bool used;                                                          \
+    } pfx##_hash_slot_t;                                                    \
+    typedef struct pfx##_hash_t {                                           \
+        pfx##_hash_slot_t *tab;                                             \
+        int len, size;                                                      \
+    } pfx##_hash_t;
+
+#define hash_foreach(var, hash)                                             \
+    for(typeof((hash).tab) var = (hash).tab;                                \
+        var && var < (hash).tab + (hash).size; var++)                       \
+        if(var->used)
+
+/** Hash functions using linear probing and backward shift deletion.
+ * This means that there are no tombstones: a lookup stops at the first free
+ * slot and removing many entries does not degrade lookups.
+ */
+#define HASH_FUNCS(key_t, value_t, pfx, hashfn, eqfn)                       \
+    static inline void pfx##_hash_init(pfx##_hash_t *h) {                   \
+        p_clear(h, 1);                                                      \
+    }                                                                       \
+    static inline void pfx##_hash_wipe(pfx##_hash_t *h) {                   \
+        p_delete(&h->tab);                                                  \
+        h->len = h->size = 0;                                               \
+    }                                                                       \
+    /** Remove all entries, but keep the allocated table. */                \
+    static inline void pfx##_hash_clear(pfx##_hash_t *h) {                  \
+        if(h->tab)                                                          \
+            p_clear(h->tab, h->size);                                       \
+        h->len = 0;                                                         \
+    }                                                                       \
+    static inline pfx##_hash_slot_t *                                       \
+    pfx##_hash_slot(pfx##_hash_t *h, key_t key)                             \
+    {                                                                       \
+        int mask = h->size - 1;                                             \
+        for(int i = hashfn(key) & mask; ; i = (i + 1) & mask)               \
+            if(!h->tab[i].used || eqfn(h->tab[i].key, key))                 \
+                return &h->tab[i];                                          \
+    }                                                                       \
+    static inline value_t *                                                 \
+    pfx##_hash_lookup(pfx##_hash_t *h, key_t key)                           \
+    {                                                                       \
+        if(!h->len)                                                         \
+            return NULL;                                                    \
+        pfx##_hash_slot_t *slot = pfx##_hash_slot(h, key);                  \
+        return slot->used ? &slot->value : NULL;                            \
+    }                                                                       \
+    static inline void                                                      \
+    pfx##_hash_resize(pfx##_hash_t *h, int size)                            \
+    {                                                                       \
+        pfx##_hash_slot_t *old = h->tab;                                    \
+        int old_size = h->size;                                             \
+        h->tab = p_new(pfx##_hash_slot_t, size);                            \
+        h->size = size;                                                     \
+        for(int i = 0; i < old_size; i++)                                   \
+            if(old[i].used)                                                 \
+                *pfx##_hash_slot(h, old[i].key) = old[i];                   \
+        p_delete(&old);                                                     \
+    }                                                                       \
+    /** Insert or replace the value associated with key. */                 \
+    static inline void                                                      \
+    pfx##_hash_insert(pfx##_hash_t *h, key_t key, value_t value)            \
+    {                                                                       \
+        /* Keep the load factor below 1/2 */                                \
+        if((h->len + 1) * 2 > h->size)                                      \
+            pfx##_hash_resize(h, h->size ? h->size * 2 : 16);               \
+        pfx##_hash_slot_t *slot = pfx##_hash_slot(h, key);                  \
+        if(!slot->used)                                                     \
+            h->len++;                                                       \
+        slot->key = key;                                                    \
+        slot->value = value;                                                \
+        slot->used = true;                                                  \
+    }                                                                       \
+    /** Remove key from the hash. Returns true if it was present. */        \
+    static inline bool                                                      \
+    pfx##_hash_remove(pfx##_hash_t *h, key_t key)                           \
+    {                                                                       \
+        if(!h->len)                                                         \
+            return false;                                                   \
+        pfx##_hash_slot_t *slot = pfx##_hash_slot(h, key);                  \
+        if(!slot->used)                                                     \
+            return false;                                                   \
+        int mask = h->size - 1;                                             \
+        int hole = slot - h->tab;                                           \
+        /* Move back entries whose probe sequence passes over the hole */   \
+        for(int i = (hole + 1) & mask; h->tab[i].used; i = (i + 1) & mask)  \
+        {                                                                   \
+            int home = hashfn(h->tab[i].key) & mask;                        \
+            if(((i - home) & mask) >= ((i - hole) & mask))                  \
+            {                                                               \
+                h->tab[hole] = h->tab[i];                                   \
+                hole = i;                                                   \
+            }                                                               \
+        }                                                                   \
+        p_clear(&h->tab[hole], 1);                                          \
+        h->len--;                                                           \
+        return true;                                                        \
+    }
+
+#define DO_HASH(key_t, value_t, pfx, hashfn, eqfn)                          \
+    HASH_TYPE(key_t, value_t, pfx)                                          \
+    HASH_FUNCS(key_t, value_t, pfx, hashfn, eqfn)
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -38,6 +38,15 @@ DO_ARRAY(lua_class_t *, lua_class, DO_NOTHING)
 
 static lua_class_array_t luaA_classes;
 
+/** Incremented whenever a property is added to any class. This invalidates
+ * the property caches of all classes, since they include the properties of
+ * their parents and point into the property arrays. */
+static unsigned int luaA_class_properties_generation;
+
+/** Markers for the special 'valid' and 'data' properties in property caches */
+static lua_class_property_t luaA_class_property_valid = { .name = "valid" };
+static lua_class_property_t luaA_class_property_data = { .name = "data" };
+
 /** Convert a object to a udata if possible.
  * \param L The Lua VM state.
  * \param ud The index.
@@ -161,6 +170,7 @@ luaA_class_add_property(lua_class_t *lua_class,
                                         .index = cb_index,
                                         .newindex = cb_newindex
                                     });
+    luaA_class_properties_generation++;
 }
 
 /** Newindex meta function for objects after they were GC'd.
@@ -197,10 +207,12 @@ static int
 luaA_class_gc(lua_State *L)
 {
     lua_object_t *item = lua_touserdata(L, 1);
-    signal_array_wipe(&item->signals);
     /* Get the object class */
     lua_class_t *class = luaA_class_get(L, 1);
     class->instances--;
+    foreach(sig, item->signals)
+        class->instance_handlers -= sig->sigfuncs.len;
+    signal_array_wipe(&item->signals);
     /* Call the collector function of the class, and all its parent classes */
     for(; class; class = class->parent)
         if(class->collector)
@@ -282,12 +294,35 @@ luaA_class_setup(lua_State *L, lua_class_t *class,
     class->parent = parent;
     class->tostring = NULL;
     class->instances = 0;
+    class->instance_handlers = 0;
     class->index_miss_handler = LUA_REFNIL;
     class->newindex_miss_handler = LUA_REFNIL;
+    class->properties_cache = LUA_REFNIL;
 
     lua_class_array_append(&luaA_classes, class);
 }
 
+/** Push a table with the number of live instances of each class and of the
+ * signal handlers connected to them, indexed by class name.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_class_stats(lua_State *L)
+{
+    lua_createtable(L, 0, luaA_classes.len);
+    foreach(class, luaA_classes)
+    {
+        lua_createtable(L, 0, 2);
+        lua_pushinteger(L, (*class)->instances);
+        lua_setfield(L, -2, "instances");
+        lua_pushinteger(L, (*class)->instance_handlers);
+        lua_setfield(L, -2, "signal_handlers");
+        lua_setfield(L, -2, (*class)->name);
+    }
+    return 1;
+}
+
 void
 luaA_class_connect_signal(lua_State *L, lua_class_t *lua_class, const char *name, lua_CFunction fn)
 {
@@ -356,12 +391,77 @@ luaA_usemetatable(lua_State *L, int idxobj, int idxfield)
     return 0;
 }
 
+/** Add the properties of a class and of all its parents to the table on top
+ * of the stack. Properties of subclasses override those of their parents.
+ * \param L The Lua VM state.
+ * \param lua_class The Lua class.
+ */
+static void
+luaA_class_property_cache_fill(lua_State *L, lua_class_t *lua_class)
+{
+    if(lua_class->parent)
+        luaA_class_property_cache_fill(L, lua_class->parent);
+
+    foreach(prop, lua_class->properties)
+    {
+        lua_pushstring(L, prop->name);
+        lua_pushlightuserdata(L, prop);
+        lua_rawset(L, -3);
+    }
+}
+
+/** Push the property cache of a class, building it if needed.
+ * \param L The Lua VM state.
+ * \param lua_class The Lua class.
+ */
+static void
+luaA_class_property_cache_push(lua_State *L, lua_class_t *lua_class)
+{
+    if(lua_class->properties_cache != LUA_REFNIL
+       && lua_class->properties_generation == luaA_class_properties_generation)
+    {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, lua_class->properties_cache);
+        return;
+    }
+
+    lua_newtable(L);
+    luaA_class_property_cache_fill(L, lua_class);
+
+    /* The special properties are available on all objects and take
+     * precedence over everything else */
+    lua_pushliteral(L, "valid");
+    lua_pushlightuserdata(L, &luaA_class_property_valid);
+    lua_rawset(L, -3);
+    lua_pushliteral(L, "data");
+    lua_pushlightuserdata(L, &luaA_class_property_data);
+    lua_rawset(L, -3);
+
+    luaA_register(L, -1, &lua_class->properties_cache);
+    lua_class->properties_generation = luaA_class_properties_generation;
+}
+
+/** Look up a property by name, including the special properties.
+ * Lua strings are interned, so this is a single hash lookup without any
+ * string comparison.
+ * \param L The Lua VM state.
+ * \param lua_class The Lua class.
+ * \param fieldidx The index of the field name.
+ * \return The property if found, NULL otherwise.
+ */
 static lua_class_property_t *
-lua_class_property_array_getbyname(lua_class_property_array_t *arr,
-                                   const char *name)
+luaA_class_property_lookup(lua_State *L, lua_class_t *lua_class, int fieldidx)
 {
-    lua_class_property_t lookup_prop = { .name = name };
-    return lua_class_property_array_lookup(arr, &lookup_prop);
+    fieldidx = luaA_absindex(L, fieldidx);
+    /* Raise an error for non-string keys and convert numbers to strings */
+    luaL_checkstring(L, fieldidx);
+
+    luaA_class_property_cache_push(L, lua_class);
+    lua_pushvalue(L, fieldidx);
+    lua_rawget(L, -2);
+    lua_class_property_t *prop = lua_touserdata(L, -1);
+    lua_pop(L, 2);
+
+    return prop;
 }
 
 /** Get a property of a object.
@@ -373,20 +473,13 @@ lua_class_property_array_getbyname(lua_class_property_array_t *arr,
 static lua_class_property_t *
 luaA_class_property_get(lua_State *L, lua_class_t *lua_class, int fieldidx)
 {
-    /* Lookup the property using token */
-    const char *attr = luaL_checkstring(L, fieldidx);
+    lua_class_property_t *prop = luaA_class_property_lookup(L, lua_class, fieldidx);
 
-    /* Look for the property in the class; if not found, go in the parent class. */
-    for(; lua_class; lua_class = lua_class->parent)
-    {
-        lua_class_property_t *prop =
-            lua_class_property_array_getbyname(&lua_class->properties, attr);
-
-        if(prop)
-            return prop;
-    }
+    /* The special properties are only handled by luaA_class_index() */
+    if(prop == &luaA_class_property_valid || prop == &luaA_class_property_data)
+        return NULL;
 
-    return NULL;
+    return prop;
 }
 
 /** Generic index meta function for objects.
@@ -402,10 +495,11 @@ luaA_class_index(lua_State *L)
 
     lua_class_t *class = luaA_class_get(L, 1);
 
+    lua_class_property_t *prop = luaA_class_property_lookup(L, class, 2);
+
     /* Is this the special 'valid' property? This is the only property
      * accessible for invalid objects and thus needs special handling. */
-    const char *attr = luaL_checkstring(L, 2);
-    if (A_STREQ(attr, "valid"))
+    if (prop == &luaA_class_property_valid)
     {
         void *p = luaA_toudata(L, 1, class);
         if (class->checker)
@@ -415,12 +509,10 @@ luaA_class_index(lua_State *L)
         return 1;
     }
 
-    lua_class_property_t *prop = luaA_class_property_get(L, class, 2);
-
     /* Is this the special 'data' property? This is available on all objects and
      * thus not implemented as a lua_class_property_t.
      */
-    if (A_STREQ(attr, "data"))
+    if (prop == &luaA_class_property_data)
     {
         luaA_checkudata(L, 1, class);
         luaA_getuservalue(L, 1);
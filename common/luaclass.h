@@ -72,12 +72,19 @@ struct lua_class_t
     lua_class_checker_t checker;
     /** Number of instances of this class in lua */
     unsigned int instances;
+    /** Number of signal handlers connected to instances of this class */
+    unsigned int instance_handlers;
     /** Class tostring method */
     lua_class_propfunc_t tostring;
     /** Function to call on index misses */
     int index_miss_handler;
     /** Function to call on newindex misses */
     int newindex_miss_handler;
+    /** Registry reference to a table mapping property names to properties,
+     * including the parents' properties. */
+    int properties_cache;
+    /** Value of the properties generation when properties_cache was built */
+    unsigned int properties_generation;
 };
 
 const char * luaA_typename(lua_State *, int);
@@ -102,6 +109,7 @@ int luaA_usemetatable(lua_State *, int, int);
 int luaA_class_index(lua_State *);
 int luaA_class_newindex(lua_State *);
 int luaA_class_new(lua_State *, lua_class_t *);
+int luaA_class_stats(lua_State *);
 
 void * luaA_checkudata(lua_State *, int, lua_class_t *);
 void * luaA_toudata(lua_State *L, int ud, lua_class_t *);
@@ -20,6 +20,8 @@
 #include "common/lualib.h"
 #include "luaa.h"
 
+unsigned int lualib_dofunction_count;
+
 void luaA_checkfunction(lua_State *L, int idx)
 {
     if(!lua_isfunction(L, idx))
@@ -30,6 +30,10 @@
 /** Lua function to call on dofunction() error */
 lua_CFunction lualib_dofunction_on_error;
 
+/** Number of Lua functions called through luaA_dofunction() and
+ * luaA_call_handler(), used for profiling */
+extern unsigned int lualib_dofunction_count;
+
 void luaA_checkfunction(lua_State *, int);
 void luaA_checktable(lua_State *, int);
 
@@ -73,6 +77,7 @@ luaA_dofunction(lua_State *L, int nargs, int nret)
     /* Move error handling function before args and function */
     lua_insert(L, - nargs - 2);
     int error_func_pos = lua_gettop(L) - nargs - 1;
+    lualib_dofunction_count++;
     if(lua_pcall(L, nargs, nret, - nargs - 2))
     {
         warn("%s", lua_tostring(L, -1));
@@ -107,6 +112,7 @@ int luaA_call_handler(lua_State *L, int handler)
     lua_rawgeti(L, LUA_REGISTRYINDEX, handler);
     lua_insert(L, - nargs - 1);
 
+    lualib_dofunction_count++;
     if(lua_pcall(L, nargs, LUA_MULTRET, error_func_pos))
     {
         warn("%s", lua_tostring(L, -1));
@@ -30,14 +30,21 @@
 #include "common/luaobject.h"
 #include "common/backtrace.h"
 
+int luaA_object_registry_ref = LUA_NOREF;
+
+const char *signal_current_name;
+
+/** The slot of the table of objects in a batch in the Lua registry */
+static int object_batch_ref = LUA_REFNIL;
+/** The number of objects in a batch */
+static int object_batch_count;
+
 /** Setup the object system at startup.
  * \param L The Lua VM state.
  */
 void
 luaA_object_setup(lua_State *L)
 {
-    /* Push identification string */
-    lua_pushliteral(L, LUAA_OBJECT_REGISTRY_KEY);
     /* Create an empty table */
     lua_newtable(L);
     /* Create an empty metatable */
@@ -46,7 +53,11 @@ luaA_object_setup(lua_State *L)
      * It's used to store the number of reference on stored objects. */
     lua_setmetatable(L, -2);
     /* Register table inside registry */
-    lua_rawset(L, LUA_REGISTRYINDEX);
+    luaA_object_registry_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    /* Objects in a batch -> their deferred signals */
+    lua_newtable(L);
+    object_batch_ref = luaL_ref(L, LUA_REGISTRYINDEX);
 }
 
 /** Increment a object reference in its store table.
@@ -206,7 +217,10 @@ luaA_object_connect_signal_from_stack(lua_State *L, int oud,
 {
     luaA_checkfunction(L, ud);
     lua_object_t *obj = lua_touserdata(L, oud);
+    lua_class_t *class = luaA_class_get(L, oud);
     signal_connect(&obj->signals, name, luaA_object_ref_item(L, oud, ud));
+    if(class)
+        class->instance_handlers++;
 }
 
 /** Remove a signal to an object.
@@ -223,39 +237,213 @@ luaA_object_disconnect_signal_from_stack(lua_State *L, int oud,
     lua_object_t *obj = lua_touserdata(L, oud);
     void *ref = (void *) lua_topointer(L, ud);
     if (signal_disconnect(&obj->signals, name, ref))
+    {
+        lua_class_t *class = luaA_class_get(L, oud);
+        if(class)
+            class->instance_handlers--;
         luaA_object_unref_item(L, oud, ref);
+    }
     lua_remove(L, ud);
 }
 
+/** Call all handlers of a signal.
+ * The arguments are the nargs values on top of the stack; they are left there.
+ * \param L The Lua VM state.
+ * \param sig The signal.
+ * \param name The signal name, reported by the sampler while the handlers run.
+ * \param oud The index of the object owning the handlers, or 0 if they are
+ * referenced in the object registry. The object is also passed as first
+ * argument.
+ * \param nargs The number of arguments.
+ */
+static void
+signal_call_handlers(lua_State *L, signal_t *sig, const char *name, int oud, int nargs)
+{
+    int args = lua_gettop(L) - nargs + 1;
+    int nobj = oud ? 1 : 0;
+    const char *outer_name = signal_current_name;
+
+    int nbfunc = sig->sigfuncs.len;
+
+    luaL_checkstack(L, nbfunc + nargs + nobj + 1, "too much signal");
+
+    /* Push all functions and then execute, because this list can change
+     * while executing funcs. Referencing them from the stack also keeps
+     * disconnected handlers alive until they were called. */
+    int first_func = lua_gettop(L) + 1;
+    foreach(func, sig->sigfuncs)
+        if(oud)
+            luaA_object_push_item(L, oud, *func);
+        else
+            luaA_object_push(L, *func);
+
+    signal_current_name = name;
+
+    for(int i = 0; i < nbfunc; i++)
+    {
+        if(oud)
+            lua_pushvalue(L, oud);
+        for(int j = 0; j < nargs; j++)
+            lua_pushvalue(L, args + j);
+        lua_pushvalue(L, first_func + i);
+        luaA_dofunction(L, nargs + nobj, 0);
+    }
+
+    signal_current_name = outer_name;
+    lua_pop(L, nbfunc);
+}
+
 void
 signal_object_emit(lua_State *L, signal_array_t *arr, const char *name, int nargs)
 {
     signal_t *sigfound = signal_array_getbyname(arr, name);
 
     if(sigfound)
+        signal_call_handlers(L, sigfound, name, 0, nargs);
+
+    /* remove args */
+    lua_pop(L, nargs);
+}
+
+/** Record a signal emitted on an object in a batch.
+ * \param L The Lua VM state.
+ * \param oud The object index on the stack, which must be absolute.
+ * \param name The signal name.
+ * \return False if the object is not in a batch.
+ */
+static bool
+object_batch_defer(lua_State *L, int oud, const char *name)
+{
+    lua_rawgeti(L, LUA_REGISTRYINDEX, object_batch_ref);
+    lua_pushvalue(L, oud);
+    lua_rawget(L, -2);
+    if(lua_isnil(L, -1))
     {
-        int nbfunc = sigfound->sigfuncs.len;
-        luaL_checkstack(L, nbfunc + nargs + 1, "too much signal");
-        /* Push all functions and then execute, because this list can change
-         * while executing funcs. */
-        foreach(func, sigfound->sigfuncs)
-            luaA_object_push(L, *func);
+        lua_pop(L, 2);
+        return false;
+    }
+
+    /* The names are kept in emission order and as a set */
+    lua_getfield(L, -1, "names");
+    lua_getfield(L, -1, name);
+    if(lua_isnil(L, -1))
+    {
+        lua_pushboolean(L, true);
+        lua_setfield(L, -3, name);
+        lua_pushstring(L, name);
+        lua_rawseti(L, -3, luaA_rawlen(L, -3) + 1);
+    }
+    lua_pop(L, 4);
+    return true;
+}
+
+/** Emit the signals deferred by a batch, once each, followed by
+ * property::changed.
+ * \param L The Lua VM state.
+ * \param oud The object index on the stack, which must be absolute.
+ * \param pud The index of the batch table on the stack, which must be absolute.
+ */
+static void
+object_batch_flush(lua_State *L, int oud, int pud)
+{
+    lua_class_t *lua_class = luaA_class_get(L, oud);
+
+    lua_getfield(L, pud, "names");
+    int names = lua_gettop(L);
+    int len = luaA_rawlen(L, names);
+    if(len == 0)
+    {
+        lua_pop(L, 1);
+        return;
+    }
 
-        for(int i = 0; i < nbfunc; i++)
+    lua_newtable(L);
+    int changed = lua_gettop(L);
+    for(int i = 1; i <= len; i++)
+    {
+        /* A handler might have made the object invalid, e.g. by unmanaging it */
+        if(lua_class->checker && !lua_class->checker(luaA_toudata(L, oud, lua_class)))
         {
-            /* push all args */
-            for(int j = 0; j < nargs; j++)
-                lua_pushvalue(L, - nargs - nbfunc + i);
-            /* push first function */
-            lua_pushvalue(L, - nargs - nbfunc + i);
-            /* remove this first function */
-            lua_remove(L, - nargs - nbfunc - 1 + i);
-            luaA_dofunction(L, nargs, 0);
+            lua_pop(L, 2);
+            return;
         }
+        lua_rawgeti(L, names, i);
+        const char *name = lua_tostring(L, -1);
+        luaA_object_emit_signal(L, oud, name, 0);
+        lua_pushboolean(L, true);
+        lua_setfield(L, changed, name + 10);
+        lua_pop(L, 1);
     }
 
-    /* remove args */
-    lua_pop(L, nargs);
+    if(!lua_class->checker || lua_class->checker(luaA_toudata(L, oud, lua_class)))
+    {
+        lua_pushvalue(L, changed);
+        luaA_object_emit_signal(L, oud, "property::changed", 1);
+    }
+    lua_pop(L, 2);
+}
+
+/** Defer the property signals of the object while a function runs.
+ *
+ * Every `property::` signal emitted without arguments on the object while
+ * `func` runs is emitted only once after it returned, in the order the
+ * signals were first emitted. Then `property::changed` is emitted with a
+ * table whose keys are the names of the changed properties, e.g.
+ * `{ x = true, geometry = true }`.
+ *
+ * Batches can be nested, the signals are emitted when the outermost one
+ * ends. Errors raised by `func` are raised again after the signals were
+ * emitted.
+ * @tparam function func The function to call.
+ * @function batch
+ */
+int
+luaA_object_batch(lua_State *L)
+{
+    lua_class_t *lua_class = luaA_class_get(L, 1);
+    if(!lua_class)
+        luaA_typerror(L, 1, "object");
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+    lua_settop(L, 2);
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, object_batch_ref);
+    lua_pushvalue(L, 1);
+    lua_rawget(L, 3);
+    if(lua_isnil(L, -1))
+    {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_newtable(L);
+        lua_setfield(L, -2, "names");
+        lua_pushvalue(L, 1);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, 3);
+        object_batch_count++;
+    }
+
+    lua_getfield(L, 4, "depth");
+    int depth = lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    lua_pushinteger(L, depth + 1);
+    lua_setfield(L, 4, "depth");
+
+    lua_pushvalue(L, 2);
+    int error = lua_pcall(L, 0, 0, 0);
+
+    lua_pushinteger(L, depth);
+    lua_setfield(L, 4, "depth");
+    if(depth == 0)
+    {
+        lua_pushvalue(L, 1);
+        lua_pushnil(L);
+        lua_rawset(L, 3);
+        object_batch_count--;
+        object_batch_flush(L, 1, 4);
+    }
+
+    if(error)
+        lua_error(L);
+    return 0;
 }
 
 /** Emit a signal.
@@ -278,35 +466,30 @@ luaA_object_emit_signal(lua_State *L, int oud,
         luaA_warn(L, "Trying to emit signal '%s' on invalid object", name);
         return;
     }
-    signal_t *sigfound = signal_array_getbyname(&obj->signals, name);
+
+    if(object_batch_count > 0 && nargs == 0
+       && a_strncmp(name, "property::", 10) == 0 && A_STRNEQ(name, "property::changed")
+       && object_batch_defer(L, oud_abs, name))
+        return;
+
+    signal_t sig = { .id = a_strhash((const unsigned char *) NONULL(name)) };
+    signal_t *sigfound = signal_array_lookup(&obj->signals, &sig);
+
     if(sigfound)
+        signal_call_handlers(L, sigfound, name, oud_abs, nargs);
+
+    /* Then emit signal on the class, with the object as first argument.
+     * Look it up only now, the handlers above might have connected signals. */
+    signal_t *classfound = signal_array_lookup(&lua_class->signals, &sig);
+    if(classfound)
     {
-        int nbfunc = sigfound->sigfuncs.len;
-        luaL_checkstack(L, nbfunc + nargs + 2, "too much signal");
-        /* Push all functions and then execute, because this list can change
-         * while executing funcs. */
-        foreach(func, sigfound->sigfuncs)
-            luaA_object_push_item(L, oud_abs, *func);
-
-        for(int i = 0; i < nbfunc; i++)
-        {
-            /* push object */
-            lua_pushvalue(L, oud_abs);
-            /* push all args */
-            for(int j = 0; j < nargs; j++)
-                lua_pushvalue(L, - nargs - nbfunc - 1 + i);
-            /* push first function */
-            lua_pushvalue(L, - nargs - nbfunc - 1 + i);
-            /* remove this first function */
-            lua_remove(L, - nargs - nbfunc - 2 + i);
-            luaA_dofunction(L, nargs + 1, 0);
-        }
+        lua_pushvalue(L, oud_abs);
+        lua_insert(L, - nargs - 1);
+        signal_call_handlers(L, classfound, name, 0, nargs + 1);
+        nargs++;
     }
 
-    /* Then emit signal on the class */
-    lua_pushvalue(L, oud);
-    lua_insert(L, - nargs - 1);
-    luaA_class_emit_signal(L, luaA_class_get(L, - nargs - 1), name, nargs + 1);
+    lua_pop(L, nargs);
 }
 
 int
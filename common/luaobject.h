@@ -25,7 +25,8 @@
 #include "common/luaclass.h"
 #include "luaa.h"
 
-#define LUAA_OBJECT_REGISTRY_KEY "awesome.object.registry"
+/** The slot of the object registry in the Lua registry */
+extern int luaA_object_registry_ref;
 
 int luaA_settype(lua_State *, lua_class_t *);
 void luaA_object_setup(lua_State *);
@@ -85,11 +86,15 @@ luaA_object_push_item(lua_State *L, int ud, const void *pointer)
     return 1;
 }
 
+/** Push the object registry.
+ * It lives in an integer slot of the Lua registry, so that this is an array
+ * access instead of a string lookup.
+ * \param L The Lua VM state.
+ */
 static inline void
 luaA_object_registry_push(lua_State *L)
 {
-    lua_pushliteral(L, LUAA_OBJECT_REGISTRY_KEY);
-    lua_rawget(L, LUA_REGISTRYINDEX);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, luaA_object_registry_ref);
 }
 
 /** Reference an object and return a pointer to it.
@@ -149,8 +154,27 @@ luaA_object_push(lua_State *L, const void *pointer)
     return 1;
 }
 
+/** The name of the innermost signal whose handlers are running, or NULL */
+extern const char *signal_current_name;
+
 void signal_object_emit(lua_State *, signal_array_t *, const char *, int);
 
+/** Check if emitting a signal on an object would call any handler.
+ * The object does not need to be on the Lua stack, so that frequent signals
+ * can be skipped without pushing it.
+ * \param lua_class The class of the object.
+ * \param obj The object.
+ * \param name The signal name.
+ * \return True if the object or its class have handlers for the signal.
+ */
+static inline bool
+luaA_object_has_signal(lua_class_t *lua_class, void *obj, const char *name)
+{
+    signal_t sig = { .id = a_strhash((const unsigned char *) name) };
+    return signal_array_lookup(&((lua_object_t *) obj)->signals, &sig)
+        || signal_array_lookup(&lua_class->signals, &sig);
+}
+
 void luaA_object_connect_signal(lua_State *, int, const char *, lua_CFunction);
 void luaA_object_disconnect_signal(lua_State *, int, const char *, lua_CFunction);
 void luaA_object_connect_signal_from_stack(lua_State *, int, const char *, int);
@@ -160,6 +184,7 @@ void luaA_object_emit_signal(lua_State *, int, const char *, int);
 int luaA_object_connect_signal_simple(lua_State *);
 int luaA_object_disconnect_signal_simple(lua_State *);
 int luaA_object_emit_signal_simple(lua_State *);
+int luaA_object_batch(lua_State *);
 
 #define LUA_OBJECT_FUNCS(lua_class, type, prefix)                              \
     LUA_CLASS_FUNCS(prefix, lua_class)                                         \
@@ -212,7 +237,8 @@ int luaA_object_tostring(lua_State *);
     { "__tostring", luaA_object_tostring }, \
     { "connect_signal", luaA_object_connect_signal_simple }, \
     { "disconnect_signal", luaA_object_disconnect_signal_simple }, \
-    { "emit_signal", luaA_object_emit_signal_simple },
+    { "emit_signal", luaA_object_emit_signal_simple }, \
+    { "batch", luaA_object_batch },
 
 #endif
 
@@ -0,0 +1,162 @@
+/*
+ * objectset.h - shared, immutable arrays of Lua objects
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_COMMON_OBJECTSET_H
+#define AWESOME_COMMON_OBJECTSET_H
+
+#include "common/array.h"
+#include "common/luaobject.h"
+
+/** A reference counted, immutable array of objects.
+ * Owners which are given the same objects in the same order share one set,
+ * so that e.g. the key bindings of all clients are only stored once.
+ * Changing the objects of an owner means getting another set; a set itself
+ * never changes.
+ *
+ * A set does not keep its objects alive; every owner references them in its
+ * uservalue table instead, like with a plain array. A binding whose function
+ * refers to its owner thus does not keep the owner alive.
+ */
+#define OBJECT_SET_TYPE(type_t, pfx)                                        \
+    typedef struct pfx##_set_t                                              \
+    {                                                                       \
+        int refcount;                                                       \
+        pfx##_array_t items;                                                \
+    } pfx##_set_t;                                                          \
+                                                                            \
+    pfx##_set_t *luaA_##pfx##_set_get(lua_State *, int, int);               \
+    void pfx##_set_unref(lua_State *, int, pfx##_set_t **);                 \
+    int luaA_##pfx##_set_push(lua_State *, int, pfx##_set_t *);             \
+                                                                            \
+    /** Get the objects of a set, which may be NULL for no objects. */      \
+    static inline pfx##_array_t *                                           \
+    pfx##_set_items(pfx##_set_t *set)                                       \
+    {                                                                       \
+        static pfx##_array_t empty;                                         \
+        return set ? &set->items : &empty;                                  \
+    }
+
+/** Implement the functions of a set type.
+ * \param freed A statement run when a set is freed.
+ */
+#define OBJECT_SET_FUNCS(type_t, pfx, lua_class, freed)                     \
+    DO_ARRAY(pfx##_set_t *, pfx##_set, DO_NOTHING)                          \
+                                                                            \
+    /** All live sets */                                                    \
+    static pfx##_set_array_t pfx##_sets;                                    \
+                                                                            \
+    /** Get the set of the objects in a table.                              \
+     * \param L The Lua VM state.                                           \
+     * \param oidx The index of the owner, which references the objects.    \
+     * \param idx The table index on the stack.                             \
+     * \return A new reference to the set.                                  \
+     */                                                                     \
+    pfx##_set_t *                                                           \
+    luaA_##pfx##_set_get(lua_State *L, int oidx, int idx)                   \
+    {                                                                       \
+        pfx##_array_t items;                                                \
+                                                                            \
+        oidx = luaA_absindex(L, oidx);                                      \
+        idx = luaA_absindex(L, idx);                                        \
+        luaA_checktable(L, idx);                                            \
+                                                                            \
+        pfx##_array_init(&items);                                           \
+        lua_pushnil(L);                                                     \
+        while(lua_next(L, idx))                                             \
+        {                                                                   \
+            if(luaA_toudata(L, -1, &lua_class))                             \
+            {                                                               \
+                type_t *item = luaA_object_ref_item(L, oidx, -1);           \
+                pfx##_array_append(&items, item);                           \
+            }                                                               \
+            else                                                            \
+                lua_pop(L, 1);                                              \
+        }                                                                   \
+                                                                            \
+        foreach(set, pfx##_sets)                                            \
+            if((*set)->items.len == items.len                               \
+               && !memcmp((*set)->items.tab, items.tab,                     \
+                          items.len * sizeof(*items.tab)))                  \
+            {                                                               \
+                pfx##_array_wipe(&items);                                   \
+                (*set)->refcount++;                                         \
+                return *set;                                                \
+            }                                                               \
+                                                                            \
+        pfx##_set_t *set = p_new(pfx##_set_t, 1);                           \
+        set->refcount = 1;                                                  \
+        set->items = items;                                                 \
+        pfx##_set_array_append(&pfx##_sets, set);                           \
+        return set;                                                         \
+    }                                                                       \
+                                                                            \
+    /** Drop a reference to a set.                                          \
+     * \param L The Lua VM state.                                           \
+     * \param oidx The index of the owner, or 0 when the owner is being     \
+     * collected and its references go away anyway.                         \
+     * \param set The set, may point to NULL. Set to NULL.                  \
+     */                                                                     \
+    void                                                                    \
+    pfx##_set_unref(lua_State *L, int oidx, pfx##_set_t **set)              \
+    {                                                                       \
+        if(*set && oidx)                                                    \
+        {                                                                   \
+            oidx = luaA_absindex(L, oidx);                                  \
+            foreach(item, (*set)->items)                                    \
+                luaA_object_unref_item(L, oidx, *item);                     \
+        }                                                                   \
+        if(*set && --(*set)->refcount == 0)                                 \
+        {                                                                   \
+            foreach(elem, pfx##_sets)                                       \
+                if(*elem == *set)                                           \
+                {                                                           \
+                    pfx##_set_array_remove(&pfx##_sets, elem);              \
+                    break;                                                  \
+                }                                                           \
+            pfx##_array_wipe(&(*set)->items);                               \
+            p_delete(set);                                                  \
+            freed;                                                          \
+        }                                                                   \
+        *set = NULL;                                                        \
+    }                                                                       \
+                                                                            \
+    /** Push the objects of a set as a table.                               \
+     * \param L The Lua VM state.                                           \
+     * \param oidx The index of the owner.                                  \
+     * \param set The set, may be NULL.                                     \
+     * \return The number of elements pushed on stack.                      \
+     */                                                                     \
+    int                                                                     \
+    luaA_##pfx##_set_push(lua_State *L, int oidx, pfx##_set_t *set)         \
+    {                                                                       \
+        pfx##_array_t *items = pfx##_set_items(set);                        \
+        oidx = luaA_absindex(L, oidx);                                      \
+        lua_createtable(L, items->len, 0);                                  \
+        for(int i = 0; i < items->len; i++)                                 \
+        {                                                                   \
+            luaA_object_push_item(L, oidx, items->tab[i]);                  \
+            lua_rawseti(L, -2, i + 1);                                      \
+        }                                                                   \
+        return 1;                                                           \
+    }
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,366 @@
+/*
+ * pixels.c - pixel format conversion
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* All implementations compute round(c * a / 255) for every color channel, so
+ * they give the same results. Opaque pixels are copied without multiplying.
+ *
+ * SSE2 is always available on x86-64 and NEON on AArch64. AVX2 is used if
+ * the CPU supports it, which is checked once at runtime.
+ */
+
+#include "common/pixels.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#define PIXELS_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__clang__) || __GNUC__ >= 5)
+#define PIXELS_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON) \
+    && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PIXELS_NEON
+#include <arm_neon.h>
+#endif
+
+/* {{{ Scalar */
+
+/** Premultiply one native-endian ARGB pixel.
+ * Red and blue are multiplied together in the same 32 bit integer.
+ */
+static inline uint32_t
+premultiply_pixel(uint32_t p)
+{
+    uint32_t a = p >> 24;
+    if(a == 0xff)
+        return p;
+    if(a == 0)
+        return 0;
+
+    uint32_t rb = (p & 0xff00ff) * a + 0x800080;
+    rb = ((rb + ((rb >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+    uint32_t g = (p & 0xff00) * a + 0x8000;
+    g = ((g + (g >> 8)) >> 8) & 0xff00;
+    return (a << 24) | rb | g;
+}
+
+static void
+premultiply_argb_scalar(uint32_t *dst, const uint32_t *src, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+        dst[i] = premultiply_pixel(src[i]);
+}
+
+static void
+premultiply_rgba_scalar(uint32_t *dst, const uint8_t *src, size_t n)
+{
+    for(size_t i = 0; i < n; i++, src += 4)
+        dst[i] = premultiply_pixel((uint32_t) src[3] << 24 | (uint32_t) src[0] << 16
+                                   | (uint32_t) src[1] << 8 | src[2]);
+}
+
+static void
+convert_rgb_scalar(uint32_t *dst, const uint8_t *src, size_t n)
+{
+    for(size_t i = 0; i < n; i++, src += 3)
+        dst[i] = (uint32_t) src[0] << 16 | (uint32_t) src[1] << 8 | src[2];
+}
+
+/* }}} */
+
+/* {{{ SSE2 */
+#ifdef PIXELS_SSE2
+
+/** Multiply the 16 bit color channels of two pixels with their alpha.
+ * The alpha channel itself is garbage afterwards.
+ */
+static inline __m128i
+premultiply_sse2_16(__m128i v)
+{
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)),
+                                    _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(v, a), _mm_set1_epi16(0x80));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/** Premultiply four native-endian ARGB pixels */
+static inline __m128i
+premultiply_sse2(__m128i v)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    __m128i lo = premultiply_sse2_16(_mm_unpacklo_epi8(v, zero));
+    __m128i hi = premultiply_sse2_16(_mm_unpackhi_epi8(v, zero));
+    return _mm_or_si128(_mm_andnot_si128(alpha, _mm_packus_epi16(lo, hi)),
+                        _mm_and_si128(alpha, v));
+}
+
+/** Check if four pixels are opaque */
+static inline int
+opaque_sse2(__m128i v)
+{
+    __m128i ones = _mm_cmpeq_epi32(v, v);
+    __m128i a = _mm_or_si128(v, _mm_set1_epi32(0x00ffffff));
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(a, ones)) == 0xffff;
+}
+
+/** Swap the red and blue bytes of four pixels */
+static inline __m128i
+swap_rb_sse2(__m128i v)
+{
+    __m128i ag = _mm_and_si128(v, _mm_set1_epi32(0xff00ff00));
+    __m128i r = _mm_and_si128(_mm_slli_epi32(v, 16), _mm_set1_epi32(0x00ff0000));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), _mm_set1_epi32(0x000000ff));
+    return _mm_or_si128(ag, _mm_or_si128(r, b));
+}
+
+static void
+premultiply_argb_sse2(uint32_t *dst, const uint32_t *src, size_t n)
+{
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        if(!opaque_sse2(v))
+            v = premultiply_sse2(v);
+        _mm_storeu_si128((__m128i *) (dst + i), v);
+    }
+    premultiply_argb_scalar(dst + i, src + i, n - i);
+}
+
+static void
+premultiply_rgba_sse2(uint32_t *dst, const uint8_t *src, size_t n)
+{
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128i v = swap_rb_sse2(_mm_loadu_si128((const __m128i *) (src + i * 4)));
+        if(!opaque_sse2(v))
+            v = premultiply_sse2(v);
+        _mm_storeu_si128((__m128i *) (dst + i), v);
+    }
+    premultiply_rgba_scalar(dst + i, src + i * 4, n - i);
+}
+
+#endif
+/* }}} */
+
+/* {{{ AVX2 */
+#ifdef PIXELS_AVX2
+
+#define AVX2 __attribute__((target("avx2")))
+
+/** Premultiply eight native-endian ARGB pixels */
+static inline AVX2 __m256i
+premultiply_avx2(__m256i v)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha = _mm256_set1_epi32(0xff000000);
+    const __m256i round = _mm256_set1_epi16(0x80);
+    __m256i lo = _mm256_unpacklo_epi8(v, zero);
+    __m256i hi = _mm256_unpackhi_epi8(v, zero);
+    __m256i alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)),
+                                         _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)),
+                                         _MM_SHUFFLE(3, 3, 3, 3));
+    lo = _mm256_add_epi16(_mm256_mullo_epi16(lo, alo), round);
+    hi = _mm256_add_epi16(_mm256_mullo_epi16(hi, ahi), round);
+    lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+    /* Unpacking and packing both work per 128 bit lane, so the order is kept */
+    return _mm256_or_si256(_mm256_andnot_si256(alpha, _mm256_packus_epi16(lo, hi)),
+                           _mm256_and_si256(alpha, v));
+}
+
+static inline AVX2 int
+opaque_avx2(__m256i v)
+{
+    __m256i ones = _mm256_cmpeq_epi32(v, v);
+    __m256i a = _mm256_or_si256(v, _mm256_set1_epi32(0x00ffffff));
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, ones)) == -1;
+}
+
+static AVX2 void
+premultiply_argb_avx2(uint32_t *dst, const uint32_t *src, size_t n)
+{
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+        if(!opaque_avx2(v))
+            v = premultiply_avx2(v);
+        _mm256_storeu_si256((__m256i *) (dst + i), v);
+    }
+    premultiply_argb_scalar(dst + i, src + i, n - i);
+}
+
+static AVX2 void
+premultiply_rgba_avx2(uint32_t *dst, const uint8_t *src, size_t n)
+{
+    const __m256i swap = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                          2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i * 4));
+        v = _mm256_shuffle_epi8(v, swap);
+        if(!opaque_avx2(v))
+            v = premultiply_avx2(v);
+        _mm256_storeu_si256((__m256i *) (dst + i), v);
+    }
+    premultiply_rgba_scalar(dst + i, src + i * 4, n - i);
+}
+
+static AVX2 void
+convert_rgb_avx2(uint32_t *dst, const uint8_t *src, size_t n)
+{
+    const __m128i expand = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    size_t i = 0;
+    /* Every load reads 16 bytes, but only 12 are used */
+    for(; i + 6 <= n; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i * 3));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_shuffle_epi8(v, expand));
+    }
+    convert_rgb_scalar(dst + i, src + i * 3, n - i);
+}
+
+#undef AVX2
+
+#endif
+/* }}} */
+
+/* {{{ NEON */
+#ifdef PIXELS_NEON
+
+/** Compute round(c * a / 255) for 16 channels */
+static inline uint8x16_t
+premultiply_neon(uint8x16_t c, uint8x16_t a)
+{
+    uint16x8_t lo = vmull_u8(vget_low_u8(c), vget_low_u8(a));
+    uint16x8_t hi = vmull_u8(vget_high_u8(c), vget_high_u8(a));
+    return vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)),
+                       vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+}
+
+/** Premultiply 16 pixels whose channels are in B, G, R, A order */
+static inline uint8x16x4_t
+premultiply_bgra_neon(uint8x16x4_t v)
+{
+    if(vminvq_u8(v.val[3]) != 0xff)
+        for(int c = 0; c < 3; c++)
+            v.val[c] = premultiply_neon(v.val[c], v.val[3]);
+    return v;
+}
+
+static void
+premultiply_argb_neon(uint32_t *dst, const uint32_t *src, size_t n)
+{
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+        vst4q_u8((uint8_t *) (dst + i),
+                 premultiply_bgra_neon(vld4q_u8((const uint8_t *) (src + i))));
+    premultiply_argb_scalar(dst + i, src + i, n - i);
+}
+
+static void
+premultiply_rgba_neon(uint32_t *dst, const uint8_t *src, size_t n)
+{
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        uint8x16x4_t v = vld4q_u8(src + i * 4);
+        uint8x16_t r = v.val[0];
+        v.val[0] = v.val[2];
+        v.val[2] = r;
+        vst4q_u8((uint8_t *) (dst + i), premultiply_bgra_neon(v));
+    }
+    premultiply_rgba_scalar(dst + i, src + i * 4, n - i);
+}
+
+static void
+convert_rgb_neon(uint32_t *dst, const uint8_t *src, size_t n)
+{
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        uint8x16x3_t v = vld3q_u8(src + i * 3);
+        uint8x16x4_t out = { { v.val[2], v.val[1], v.val[0], vdupq_n_u8(0) } };
+        vst4q_u8((uint8_t *) (dst + i), out);
+    }
+    convert_rgb_scalar(dst + i, src + i * 3, n - i);
+}
+
+#endif
+/* }}} */
+
+/** All implementations, the best one last */
+static const pixels_kernels_t kernels[] =
+{
+    { "scalar", premultiply_argb_scalar, premultiply_rgba_scalar, convert_rgb_scalar },
+#ifdef PIXELS_SSE2
+    { "sse2", premultiply_argb_sse2, premultiply_rgba_sse2, convert_rgb_scalar },
+#endif
+#ifdef PIXELS_AVX2
+    { "avx2", premultiply_argb_avx2, premultiply_rgba_avx2, convert_rgb_avx2 },
+#endif
+#ifdef PIXELS_NEON
+    { "neon", premultiply_argb_neon, premultiply_rgba_neon, convert_rgb_neon },
+#endif
+};
+
+/** Get the implementations which can be used on this CPU.
+ * \param n Where to store the number of implementations.
+ * \return The implementations, the best one last.
+ */
+const pixels_kernels_t *
+pixels_kernels_all(size_t *n)
+{
+    *n = sizeof(kernels) / sizeof(kernels[0]);
+#ifdef PIXELS_AVX2
+    __builtin_cpu_init();
+    if(!__builtin_cpu_supports("avx2"))
+        (*n)--;
+#endif
+    return kernels;
+}
+
+/** Get the best implementation for this CPU.
+ * \return The implementation.
+ */
+const pixels_kernels_t *
+pixels_kernels(void)
+{
+    static const pixels_kernels_t *best;
+
+    if(!best)
+    {
+        size_t n;
+        best = &pixels_kernels_all(&n)[n - 1];
+    }
+    return best;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,79 @@
+/*
+ * pixels.h - pixel format conversion header
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_COMMON_PIXELS_H
+#define AWESOME_COMMON_PIXELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Conversions to cairo's native-endian, premultiplied ARGB32 pixels */
+typedef struct
+{
+    /** The name of the implementation, for benchmarks */
+    const char *name;
+    /** Premultiply native-endian ARGB pixels */
+    void (*premultiply_argb)(uint32_t *, const uint32_t *, size_t);
+    /** Premultiply and swizzle R, G, B, A bytes (GdkPixbuf with alpha) */
+    void (*premultiply_rgba)(uint32_t *, const uint8_t *, size_t);
+    /** Swizzle R, G, B bytes (GdkPixbuf without alpha) */
+    void (*convert_rgb)(uint32_t *, const uint8_t *, size_t);
+} pixels_kernels_t;
+
+const pixels_kernels_t *pixels_kernels(void);
+const pixels_kernels_t *pixels_kernels_all(size_t *);
+
+/** Premultiply native-endian ARGB pixels.
+ * \param dst Where to store the n premultiplied pixels.
+ * \param src The n pixels to convert.
+ * \param n The number of pixels.
+ */
+static inline void
+pixels_premultiply_argb(uint32_t *dst, const uint32_t *src, size_t n)
+{
+    pixels_kernels()->premultiply_argb(dst, src, n);
+}
+
+/** Premultiply pixels stored as R, G, B, A bytes.
+ * \param dst Where to store the n premultiplied pixels.
+ * \param src The n * 4 bytes to convert.
+ * \param n The number of pixels.
+ */
+static inline void
+pixels_premultiply_rgba(uint32_t *dst, const uint8_t *src, size_t n)
+{
+    pixels_kernels()->premultiply_rgba(dst, src, n);
+}
+
+/** Convert pixels stored as R, G, B bytes.
+ * \param dst Where to store the n pixels.
+ * \param src The n * 3 bytes to convert.
+ * \param n The number of pixels.
+ */
+static inline void
+pixels_convert_rgb(uint32_t *dst, const uint8_t *src, size_t n)
+{
+    pixels_kernels()->convert_rgb(dst, src, n);
+}
+
+#endif
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
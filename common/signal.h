@@ -94,12 +94,16 @@ signal_disconnect(signal_array_t *arr, const char *name, const void *ref)
     signal_t *sigfound = signal_array_getbyname(arr, name);
     if(sigfound)
     {
-        foreach(func, sigfound->sigfuncs)
-            if(ref == *func)
+        cptr_array_t *funcs = &sigfound->sigfuncs;
+        for(int i = 0; i < funcs->len; i++)
+            if(ref == funcs->tab[i])
             {
-                cptr_array_remove(&sigfound->sigfuncs, func);
-                if(sigfound->sigfuncs.len == 0)
+                cptr_array_take(funcs, i);
+                if(funcs->len == 0)
+                {
+                    signal_wipe(sigfound);
                     signal_array_remove(arr, sigfound);
+                }
                 return true;
             }
     }
@@ -30,6 +30,8 @@
 #include <errno.h>
 #include <time.h>
 
+unsigned long a_alloc_count;
+
 const char *
 a_current_time_str(void)
 {
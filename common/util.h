@@ -95,6 +95,9 @@
 #define unlikely(expr)  expr
 #endif
 
+/** Number of allocations done through xmalloc() and xrealloc() */
+extern unsigned long a_alloc_count;
+
 static inline void * __attribute__ ((malloc)) xmalloc(ssize_t size)
 {
     void *ptr;
@@ -102,6 +105,8 @@ static inline void * __attribute__ ((malloc)) xmalloc(ssize_t size)
     if(size <= 0)
         return NULL;
 
+    a_alloc_count++;
+
     ptr = calloc(1, size);
 
     if(!ptr)
@@ -117,6 +122,7 @@ xrealloc(void **ptr, ssize_t newsize)
         p_delete(ptr);
     else
     {
+        a_alloc_count++;
         *ptr = realloc(*ptr, newsize);
         if(!*ptr)
             abort();
@@ -23,6 +23,7 @@
 #include "common/xembed.h"
 #include "common/util.h"
 #include "common/atoms.h"
+#include "common/xtrace.h"
 
 /* I should really include the correct header instead... */
 void luaA_systray_invalidate(void);
@@ -42,6 +42,11 @@ struct xembed_window
 {
     xcb_window_t win;
     xembed_info_t info;
+    /** Position and size last given by the systray, size 0 if none yet */
+    int16_t x, y;
+    uint16_t size;
+    /** Did the systray last map the window? */
+    bool mapped;
 };
 
 DO_ARRAY(xembed_window_t, xembed_window, DO_NOTHING)
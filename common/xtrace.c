@@ -0,0 +1,148 @@
+/*
+ * xtrace.c - X request/reply tracing
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Every place waiting for an X reply gets a static xtrace_site_t through the
+ * macros in xtrace.h. While tracing is enabled, a reply is first polled for
+ * without flushing the output buffer: if it is not there yet, awesome has to
+ * wait for a round trip to the X server, which is counted as blocking
+ * together with the time spent waiting.
+ */
+
+#define XTRACE_IMPLEMENTATION
+
+#include "common/xtrace.h"
+#include "common/util.h"
+
+#include <time.h>
+#include <xcb/xcbext.h>
+
+bool xtrace_enabled;
+xtrace_site_t *xtrace_sites;
+
+static uint64_t
+xtrace_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+xtrace_register(xtrace_site_t *site)
+{
+    if(site->registered)
+        return;
+    site->registered = true;
+    site->next = xtrace_sites;
+    xtrace_sites = site;
+}
+
+/** Wait for a reply, like xcb_wait_for_reply().
+ * \param site The site waiting for the reply.
+ * \param c The connection.
+ * \param request The sequence number of the request.
+ * \param e Where to store an error, or NULL.
+ * \return The reply or NULL.
+ */
+void *
+xtrace_wait_for_reply(xtrace_site_t *site, xcb_connection_t *c,
+                      unsigned int request, xcb_generic_error_t **e)
+{
+    void *reply = NULL;
+
+    if(!xtrace_enabled)
+        return xcb_wait_for_reply(c, request, e);
+
+    xtrace_register(site);
+    site->replies++;
+
+    if(e)
+        *e = NULL;
+    if(xcb_poll_for_reply(c, request, &reply, e))
+        return reply;
+
+    uint64_t start = xtrace_now();
+    reply = xcb_wait_for_reply(c, request, e);
+    site->blocking++;
+    site->wait_ns += xtrace_now() - start;
+    return reply;
+}
+
+/** Check a request for errors, like xcb_request_check().
+ * This always costs a round trip unless it was already answered.
+ * \param site The site checking the request.
+ * \param c The connection.
+ * \param cookie The cookie of the request.
+ * \return The error or NULL.
+ */
+xcb_generic_error_t *
+xtrace_request_check(xtrace_site_t *site, xcb_connection_t *c, xcb_void_cookie_t cookie)
+{
+    if(!xtrace_enabled)
+        return xcb_request_check(c, cookie);
+
+    xtrace_register(site);
+    site->replies++;
+    site->blocking++;
+
+    uint64_t start = xtrace_now();
+    xcb_generic_error_t *error = xcb_request_check(c, cookie);
+    site->wait_ns += xtrace_now() - start;
+    return error;
+}
+
+/** Reset the statistics of all sites. */
+void
+xtrace_reset(void)
+{
+    for(xtrace_site_t *site = xtrace_sites; site; site = site->next)
+    {
+        site->replies = site->blocking = 0;
+        site->wait_ns = 0;
+    }
+}
+
+/** Print the statistics of all sites.
+ * \param file Where to print them.
+ */
+void
+xtrace_dump(FILE *file)
+{
+    unsigned long replies = 0, blocking = 0;
+    uint64_t wait_ns = 0;
+
+    fprintf(file, "X replies%s:\n", xtrace_enabled ? "" : " (tracing disabled)");
+    for(xtrace_site_t *site = xtrace_sites; site; site = site->next)
+    {
+        if(!site->replies)
+            continue;
+        fprintf(file, "  %-22s %s:%d: %lu replies, %lu blocking, %.3f ms waiting\n",
+                site->request, site->file, site->line, site->replies,
+                site->blocking, site->wait_ns / 1e6);
+        replies += site->replies;
+        blocking += site->blocking;
+        wait_ns += site->wait_ns;
+    }
+    fprintf(file, "  total: %lu replies, %lu blocking, %.3f ms waiting\n",
+            replies, blocking, wait_ns / 1e6);
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,104 @@
+/*
+ * xtrace.h - X request/reply tracing header
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_COMMON_XTRACE_H
+#define AWESOME_COMMON_XTRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+
+/** The statistics of one place in the code waiting for X replies */
+typedef struct xtrace_site_t
+{
+    /** The X request, e.g. "GetProperty" */
+    const char *request;
+    const char *file;
+    int line;
+    /** Number of replies asked for */
+    unsigned long replies;
+    /** Number of them which were not received yet, so that awesome had to
+     * wait for the X server */
+    unsigned long blocking;
+    /** Time spent waiting */
+    uint64_t wait_ns;
+    /** Next site in xtrace_sites */
+    struct xtrace_site_t *next;
+    bool registered;
+} xtrace_site_t;
+
+/** Is tracing enabled? */
+extern bool xtrace_enabled;
+/** All sites which were used while tracing was enabled */
+extern xtrace_site_t *xtrace_sites;
+
+void *xtrace_wait_for_reply(xtrace_site_t *, xcb_connection_t *, unsigned int, xcb_generic_error_t **);
+xcb_generic_error_t *xtrace_request_check(xtrace_site_t *, xcb_connection_t *, xcb_void_cookie_t);
+void xtrace_reset(void);
+void xtrace_dump(FILE *);
+
+/** A site for the place where this is expanded */
+#define XTRACE_SITE(name) \
+    ({ \
+        static xtrace_site_t xtrace_site_ = { .request = name, .file = __FILE__, .line = __LINE__ }; \
+        &xtrace_site_; \
+    })
+
+#define XTRACE_REPLY(type, name, c, cookie, e) \
+    ((type *) xtrace_wait_for_reply(XTRACE_SITE(name), (c), (cookie).sequence, (e)))
+
+/* Route the replies used by awesome through the tracing layer. These are
+ * exactly what XCB's generated functions do, plus the accounting. */
+#ifndef XTRACE_IMPLEMENTATION
+#define xcb_get_property_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_get_property_reply_t, "GetProperty", c, cookie, e)
+#define xcb_get_geometry_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_get_geometry_reply_t, "GetGeometry", c, cookie, e)
+#define xcb_get_window_attributes_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_get_window_attributes_reply_t, "GetWindowAttributes", c, cookie, e)
+#define xcb_query_tree_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_query_tree_reply_t, "QueryTree", c, cookie, e)
+#define xcb_query_pointer_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_query_pointer_reply_t, "QueryPointer", c, cookie, e)
+#define xcb_translate_coordinates_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_translate_coordinates_reply_t, "TranslateCoordinates", c, cookie, e)
+#define xcb_intern_atom_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_intern_atom_reply_t, "InternAtom", c, cookie, e)
+#define xcb_get_atom_name_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_get_atom_name_reply_t, "GetAtomName", c, cookie, e)
+#define xcb_get_selection_owner_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_get_selection_owner_reply_t, "GetSelectionOwner", c, cookie, e)
+#define xcb_get_input_focus_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_get_input_focus_reply_t, "GetInputFocus", c, cookie, e)
+#define xcb_grab_pointer_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_grab_pointer_reply_t, "GrabPointer", c, cookie, e)
+#define xcb_grab_keyboard_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_grab_keyboard_reply_t, "GrabKeyboard", c, cookie, e)
+#define xcb_alloc_color_reply(c, cookie, e) \
+    XTRACE_REPLY(xcb_alloc_color_reply_t, "AllocColor", c, cookie, e)
+#define xcb_request_check(c, cookie) \
+    xtrace_request_check(XTRACE_SITE("RequestCheck"), (c), (cookie))
+#endif
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
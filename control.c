@@ -0,0 +1,621 @@
+/*
+ * control.c - control socket for running Lua code
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* The control socket is a Unix domain socket for programs which run many
+ * small pieces of Lua code, e.g. to query the clients, and for which the
+ * D-Bus round trips of awful.remote are too slow.
+ *
+ * Requests and replies are frames: a 32 bit big-endian length followed by
+ * that many bytes. A request is Lua code, optionally followed by a NUL byte
+ * and NUL separated arguments, which the code gets as strings in `...`.
+ * Compiled code is cached, so that repeating a request with different
+ * arguments does not compile it again.
+ *
+ * A reply is a JSON object: {"ok":true,"result":[...]} with the values
+ * returned by the code, or {"ok":false,"error":"..."}.
+ *
+ * Requests can be sent without waiting for the replies of the previous ones;
+ * the replies come in the same order. Requests which arrive together are run
+ * in one go and their replies are sent with a single write.
+ */
+
+#define _GNU_SOURCE
+
+#include "control.h"
+#include "globalconf.h"
+#include "luaa.h"
+#include "common/array.h"
+#include "common/buffer.h"
+
+#include <lauxlib.h>
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <glib-unix.h>
+
+/** Bytes read from a connection at once */
+#define CONTROL_READ_SIZE 65536
+/** Connections sending larger requests are closed */
+#define CONTROL_MAX_FRAME (16 << 20)
+/** Requests are not read while more reply bytes wait for the client */
+#define CONTROL_MAX_PENDING_OUTPUT (4 << 20)
+/** Compiled chunks cached before the cache is started over */
+#define CONTROL_CHUNK_CACHE_SIZE 256
+/** Deeper tables are sent as null, which also stops at cycles */
+#define CONTROL_MAX_DEPTH 32
+
+typedef struct control_connection_t
+{
+    int fd;
+    /** Received bytes which do not form a complete request yet */
+    buffer_t in;
+    /** Reply bytes not written yet */
+    buffer_t out;
+    guint in_source, out_source;
+    /** The client closed its side, close once the replies were written */
+    bool closing;
+} control_connection_t;
+
+DO_ARRAY(control_connection_t *, control_connection, DO_NOTHING)
+
+static struct
+{
+    /** The listening socket, or -1 */
+    int fd;
+    char *path;
+    guint source;
+    control_connection_array_t connections;
+    /** Registry reference of the table mapping code to compiled chunks */
+    int chunks_ref;
+    int chunks_count;
+} control = { .fd = -1, .chunks_ref = LUA_NOREF };
+
+static gboolean control_connection_readable(gint, GIOCondition, gpointer);
+
+static void
+control_connection_close(control_connection_t *c)
+{
+    foreach(item, control.connections)
+        if(*item == c)
+        {
+            control_connection_array_remove(&control.connections, item);
+            break;
+        }
+    if(c->in_source)
+        g_source_remove(c->in_source);
+    if(c->out_source)
+        g_source_remove(c->out_source);
+    close(c->fd);
+    buffer_wipe(&c->in);
+    buffer_wipe(&c->out);
+    p_delete(&c);
+}
+
+/** Push the compiled chunk for some code, from the cache if possible.
+ * \return True on success, false if the code could not be compiled. The
+ * chunk or the error message is on top of the stack.
+ */
+static bool
+control_push_chunk(lua_State *L, const char *code, size_t length)
+{
+    if(control.chunks_ref == LUA_NOREF)
+    {
+        lua_newtable(L);
+        control.chunks_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, control.chunks_ref);
+    lua_pushlstring(L, code, length);
+    lua_pushvalue(L, -1);
+    lua_rawget(L, -3);
+    if(lua_isfunction(L, -1))
+    {
+        /* Remove the cache and the code */
+        lua_replace(L, -3);
+        lua_pop(L, 1);
+        return true;
+    }
+    lua_pop(L, 1);
+
+    if(luaL_loadbuffer(L, code, length, "=control"))
+    {
+        lua_replace(L, -3);
+        lua_pop(L, 1);
+        return false;
+    }
+
+    if(control.chunks_count >= CONTROL_CHUNK_CACHE_SIZE)
+    {
+        /* Start over instead of keeping track of which chunks are used */
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, LUA_REGISTRYINDEX, control.chunks_ref);
+        lua_replace(L, -4);
+        control.chunks_count = 0;
+    }
+
+    /* cache[code] = chunk */
+    lua_pushvalue(L, -2);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, -5);
+    control.chunks_count++;
+
+    lua_replace(L, -3);
+    lua_pop(L, 1);
+    return true;
+}
+
+static void
+control_encode_string(buffer_t *out, const char *s, size_t length)
+{
+    const char *end = s + length, *run = s;
+
+    buffer_addc(out, '"');
+    for(; s < end; s++)
+    {
+        unsigned char c = *s;
+        if(c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        buffer_add(out, run, s - run);
+        if(c == '"' || c == '\\')
+        {
+            buffer_addc(out, '\\');
+            buffer_addc(out, c);
+        }
+        else
+            buffer_addf(out, "\\u%04x", c);
+        run = s + 1;
+    }
+    buffer_add(out, run, s - run);
+    buffer_addc(out, '"');
+}
+
+static void control_encode(lua_State *, int, buffer_t *, int);
+
+static void
+control_encode_table(lua_State *L, int idx, buffer_t *out, int depth)
+{
+    size_t length = luaA_rawlen(L, idx), count = 0;
+    bool first = true;
+
+    lua_pushnil(L);
+    while(lua_next(L, idx))
+    {
+        count++;
+        lua_pop(L, 1);
+    }
+
+    /* Sequences, including empty tables, are arrays */
+    if(count == length)
+    {
+        buffer_addc(out, '[');
+        for(size_t i = 1; i <= length; i++)
+        {
+            if(i > 1)
+                buffer_addc(out, ',');
+            lua_rawgeti(L, idx, i);
+            control_encode(L, lua_gettop(L), out, depth + 1);
+            lua_pop(L, 1);
+        }
+        buffer_addc(out, ']');
+        return;
+    }
+
+    /* Other tables are objects, keys which are no strings or numbers are
+     * skipped */
+    buffer_addc(out, '{');
+    lua_pushnil(L);
+    while(lua_next(L, idx))
+    {
+        int type = lua_type(L, -2);
+        if(type == LUA_TSTRING || type == LUA_TNUMBER)
+        {
+            size_t key_length;
+            if(!first)
+                buffer_addc(out, ',');
+            first = false;
+            /* Converting the key itself would confuse lua_next() */
+            lua_pushvalue(L, -2);
+            const char *key = lua_tolstring(L, -1, &key_length);
+            control_encode_string(out, key, key_length);
+            lua_pop(L, 1);
+            buffer_addc(out, ':');
+            control_encode(L, lua_gettop(L), out, depth + 1);
+        }
+        lua_pop(L, 1);
+    }
+    buffer_addc(out, '}');
+}
+
+/** Append the JSON representation of a Lua value.
+ * Values without one, e.g. objects, are sent as the result of tostring().
+ * \param L The Lua VM state.
+ * \param idx The absolute index of the value.
+ * \param out The buffer to append to.
+ * \param depth The number of enclosing tables.
+ */
+static void
+control_encode(lua_State *L, int idx, buffer_t *out, int depth)
+{
+    const char *s;
+    size_t length;
+    double number;
+
+    switch(lua_type(L, idx))
+    {
+      case LUA_TBOOLEAN:
+        buffer_adds(out, lua_toboolean(L, idx) ? "true" : "false");
+        break;
+      case LUA_TNUMBER:
+        number = lua_tonumber(L, idx);
+        if(!isfinite(number))
+            buffer_adds(out, "null");
+        else if(number == floor(number) && fabs(number) < 1e15)
+            buffer_addf(out, "%.0f", number);
+        else
+            buffer_addf(out, "%.17g", number);
+        break;
+      case LUA_TSTRING:
+        s = lua_tolstring(L, idx, &length);
+        control_encode_string(out, s, length);
+        break;
+      case LUA_TTABLE:
+        if(depth < CONTROL_MAX_DEPTH && lua_checkstack(L, 4))
+            control_encode_table(L, idx, out, depth);
+        else
+            buffer_addsl(out, "null");
+        break;
+      case LUA_TNIL:
+      case LUA_TNONE:
+        buffer_addsl(out, "null");
+        break;
+      default:
+        lua_getglobal(L, "tostring");
+        lua_pushvalue(L, idx);
+        if(lua_pcall(L, 1, 1, 0) == 0 && lua_isstring(L, -1))
+        {
+            s = lua_tolstring(L, -1, &length);
+            control_encode_string(out, s, length);
+        }
+        else
+            buffer_addsl(out, "null");
+        lua_pop(L, 1);
+        break;
+    }
+}
+
+/** Run one request and append its reply frame.
+ * \param L The Lua VM state.
+ * \param payload The request.
+ * \param length The length of the request.
+ * \param out The buffer to append the reply to.
+ */
+static void
+control_run(lua_State *L, const char *payload, size_t length, buffer_t *out)
+{
+    const char *code_end = memchr(payload, '\0', length);
+    size_t code_length = code_end ? (size_t) (code_end - payload) : length;
+    int top = lua_gettop(L);
+    int nargs = 0;
+
+    /* The length is filled in once the reply is complete */
+    buffer_add(out, "\0\0\0\0", 4);
+    int start = out->len;
+
+    if(!control_push_chunk(L, payload, code_length))
+        goto error;
+
+    for(const char *arg = code_end, *end = payload + length; arg; nargs++)
+    {
+        const char *next;
+        arg++;
+        next = memchr(arg, '\0', end - arg);
+        if(!lua_checkstack(L, 1))
+        {
+            lua_settop(L, top);
+            lua_pushliteral(L, "too many arguments");
+            goto error;
+        }
+        lua_pushlstring(L, arg, (next ? next : end) - arg);
+        arg = next;
+    }
+
+    if(lua_pcall(L, nargs, LUA_MULTRET, 0))
+        goto error;
+
+    buffer_addsl(out, "{\"ok\":true,\"result\":[");
+    for(int i = top + 1; i <= lua_gettop(L); i++)
+    {
+        if(i > top + 1)
+            buffer_addc(out, ',');
+        control_encode(L, i, out, 0);
+    }
+    buffer_addsl(out, "]}");
+    goto done;
+
+error:
+    buffer_addsl(out, "{\"ok\":false,\"error\":");
+    if(lua_isstring(L, -1))
+    {
+        const char *message = lua_tolstring(L, -1, &length);
+        control_encode_string(out, message, length);
+    }
+    else
+        buffer_addsl(out, "\"(error object is not a string)\"");
+    buffer_addc(out, '}');
+
+done:
+    lua_settop(L, top);
+
+    unsigned char *header = (unsigned char *) out->s + start - 4;
+    uint32_t reply_length = out->len - start;
+    header[0] = reply_length >> 24;
+    header[1] = reply_length >> 16;
+    header[2] = reply_length >> 8;
+    header[3] = reply_length;
+}
+
+/** Run the complete requests received on a connection.
+ * \return False if the connection has to be closed.
+ */
+static bool
+control_connection_process(control_connection_t *c)
+{
+    lua_State *L = globalconf_get_lua_State();
+    int pos = 0;
+
+    while(c->in.len - pos >= 4)
+    {
+        const unsigned char *header = (const unsigned char *) c->in.s + pos;
+        uint32_t length = (uint32_t) header[0] << 24 | (uint32_t) header[1] << 16
+                        | (uint32_t) header[2] << 8 | header[3];
+        if(length > CONTROL_MAX_FRAME)
+        {
+            warn("Closing control connection: request of %u bytes is too large", length);
+            return false;
+        }
+        if((uint32_t) (c->in.len - pos - 4) < length)
+            break;
+        control_run(L, c->in.s + pos + 4, length, &c->out);
+        pos += 4 + length;
+    }
+
+    buffer_splice(&c->in, 0, pos, "", 0);
+    return true;
+}
+
+static gboolean
+control_connection_writable(gint fd, GIOCondition condition, gpointer data);
+
+/** Write as much of the replies as possible without blocking.
+ * \return False if the connection has to be closed.
+ */
+static bool
+control_connection_flush(control_connection_t *c)
+{
+    while(c->out.len)
+    {
+        ssize_t written = send(c->fd, c->out.s, c->out.len, MSG_NOSIGNAL);
+        if(written < 0 && errno == EINTR)
+            continue;
+        if(written < 0 && errno == EAGAIN)
+            break;
+        if(written < 0)
+            return false;
+        buffer_splice(&c->out, 0, written, "", 0);
+    }
+
+    if(c->out.len && !c->out_source)
+        c->out_source = g_unix_fd_add(c->fd, G_IO_OUT, control_connection_writable, c);
+    return true;
+}
+
+static gboolean
+control_connection_writable(gint fd, GIOCondition condition, gpointer data)
+{
+    control_connection_t *c = data;
+
+    /* The flush adds a new source as long as replies are left */
+    c->out_source = 0;
+    if(!control_connection_flush(c) || (c->closing && !c->out.len))
+    {
+        control_connection_close(c);
+        return G_SOURCE_REMOVE;
+    }
+
+    /* Continue reading once the client caught up */
+    if(!c->closing && !c->in_source && c->out.len <= CONTROL_MAX_PENDING_OUTPUT)
+        c->in_source = g_unix_fd_add(c->fd, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                     control_connection_readable, c);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+control_connection_readable(gint fd, GIOCondition condition, gpointer data)
+{
+    control_connection_t *c = data;
+    ssize_t length;
+
+    buffer_ensure(&c->in, c->in.len + CONTROL_READ_SIZE);
+    length = read(fd, c->in.s + c->in.len, CONTROL_READ_SIZE);
+    if(length < 0 && (errno == EAGAIN || errno == EINTR))
+        return G_SOURCE_CONTINUE;
+
+    if(length > 0)
+    {
+        c->in.len += length;
+        c->in.s[c->in.len] = '\0';
+        if(control_connection_process(c) && control_connection_flush(c))
+        {
+            if(c->out.len <= CONTROL_MAX_PENDING_OUTPUT)
+                return G_SOURCE_CONTINUE;
+            /* The client does not read its replies, stop reading requests */
+            c->in_source = 0;
+            return G_SOURCE_REMOVE;
+        }
+    }
+    else if(length == 0)
+    {
+        /* The client might only have closed its side after the requests */
+        c->closing = true;
+        if(c->out.len)
+        {
+            c->in_source = 0;
+            return G_SOURCE_REMOVE;
+        }
+    }
+
+    c->in_source = 0;
+    control_connection_close(c);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+control_accept(gint fd, GIOCondition condition, gpointer data)
+{
+    int client = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(client < 0)
+    {
+        if(errno != EAGAIN && errno != EINTR && errno != ECONNABORTED)
+            warn("Cannot accept control connection: %s", strerror(errno));
+        return G_SOURCE_CONTINUE;
+    }
+
+    control_connection_t *c = p_new(control_connection_t, 1);
+    c->fd = client;
+    buffer_init(&c->in);
+    buffer_init(&c->out);
+    c->in_source = g_unix_fd_add(client, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                 control_connection_readable, c);
+    control_connection_array_append(&control.connections, c);
+    return G_SOURCE_CONTINUE;
+}
+
+/** Stop accepting connections, the existing ones stay open. */
+static void
+control_stop_listening(void)
+{
+    if(control.fd < 0)
+        return;
+    g_source_remove(control.source);
+    close(control.fd);
+    unlink(control.path);
+    p_delete(&control.path);
+    control.fd = -1;
+}
+
+/** Close the control socket and all its connections. */
+void
+control_cleanup(void)
+{
+    control_stop_listening();
+    while(control.connections.len)
+        control_connection_close(control.connections.tab[0]);
+    control_connection_array_wipe(&control.connections);
+}
+
+/** Listen for requests on a control socket.
+ *
+ * Programs connecting to the socket can run Lua code with a lower overhead
+ * than `awesome-client`. Every request is a 32 bit big-endian length followed
+ * by the Lua code, optionally followed by NUL separated string arguments which
+ * the code gets as `...`. Every reply is a length followed by a JSON object:
+ * `{"ok":true,"result":[...]}` with the returned values, or
+ * `{"ok":false,"error":"..."}`.
+ *
+ * A previous control socket is closed. The socket is only accessible to the
+ * user running awesome.
+ *
+ * @tparam string path The path of the socket. An existing socket at this
+ *   path is replaced.
+ * @treturn[1] boolean True if awesome is listening.
+ * @treturn[2] nil
+ * @treturn[2] string The error message.
+ * @function control_listen
+ * @see awful.control
+ */
+int
+luaA_control_listen(lua_State *L)
+{
+    const char *path = luaL_checkstring(L, 1);
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    struct stat st;
+    int fd;
+
+    if(a_strlen(path) >= (ssize_t) sizeof(addr.sun_path))
+    {
+        lua_pushnil(L);
+        lua_pushfstring(L, "%s: path too long", path);
+        return 2;
+    }
+    a_strcpy(addr.sun_path, sizeof(addr.sun_path), path);
+
+    control_stop_listening();
+
+    /* Replace the socket of a previous instance, but nothing else */
+    if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd >= 0)
+    {
+        mode_t mask = umask(0077);
+        int res = bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+        umask(mask);
+        if(res == 0 && listen(fd, SOMAXCONN) == 0)
+        {
+            control.fd = fd;
+            control.path = a_strdup(path);
+            control.source = g_unix_fd_add(fd, G_IO_IN, control_accept, NULL);
+            lua_pushboolean(L, true);
+            return 1;
+        }
+    }
+
+    int saved_errno = errno;
+    if(fd >= 0)
+        close(fd);
+    lua_pushnil(L);
+    lua_pushfstring(L, "%s: %s", path, strerror(saved_errno));
+    return 2;
+}
+
+/** Stop listening on the control socket.
+ *
+ * The socket file is removed. Connections which are already open stay open
+ * until the programs close them.
+ *
+ * @function control_close
+ * @see control_listen
+ */
+int
+luaA_control_close(lua_State *L)
+{
+    control_stop_listening();
+    return 0;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -46,6 +46,42 @@ static GSource *system_source = NULL;
 
 static signal_array_t dbus_signals;
 
+/** Name of the metatable of lazily decoded message arguments */
+#define DBUS_ARGS_METATABLE "awesome.dbus.args"
+
+/** What a signal receiver wants to get */
+typedef struct
+{
+    char *interface;
+    /** Only messages with this member, or NULL */
+    char *member;
+    /** Only messages whose first argument is this string, or NULL */
+    char *arg0;
+    /** Pass the arguments as one lazily decoded object */
+    bool lazy;
+} dbus_filter_t;
+
+static void
+dbus_filter_wipe(dbus_filter_t *filter)
+{
+    p_delete(&filter->interface);
+    p_delete(&filter->member);
+    p_delete(&filter->arg0);
+}
+
+DO_ARRAY(dbus_filter_t, dbus_filter, dbus_filter_wipe)
+
+static dbus_filter_array_t dbus_filters;
+
+static dbus_filter_t *
+dbus_filter_getbyname(const char *interface)
+{
+    foreach(filter, dbus_filters)
+        if(A_STREQ(filter->interface, interface))
+            return filter;
+    return NULL;
+}
+
 /** Clean up the D-Bus connection data members
  * \param dbus_connection The D-Bus connection to clean up
  * \param source The D-Bus source
@@ -66,51 +102,142 @@ a_dbus_cleanup_bus(DBusConnection *dbus_connection, GSource **source)
     dbus_connection_unref(dbus_connection);
 }
 
-/** Iterate through the D-Bus messages counting each or traverse each sub message.
+static int a_dbus_message_iter(lua_State *, DBusMessageIter *);
+
+/** Push the value an iterator points to, traversing its sub messages.
  * \param L The Lua VM state.
  * \param iter The D-Bus message iterator pointer
- * \return The number of arguments in the iterator
+ * \return The number of values, 0 at the end of the iterator
  */
 static int
-a_dbus_message_iter(lua_State *L, DBusMessageIter *iter)
+a_dbus_message_iter_value(lua_State *L, DBusMessageIter *iter)
 {
     int nargs = 0;
 
-    do
+    switch(dbus_message_iter_get_arg_type(iter))
     {
-        switch(dbus_message_iter_get_arg_type(iter))
+      default:
+        lua_pushnil(L);
+        nargs++;
+        break;
+      case DBUS_TYPE_INVALID:
+        break;
+      case DBUS_TYPE_VARIANT:
         {
-          default:
-            lua_pushnil(L);
-            nargs++;
-            break;
-          case DBUS_TYPE_INVALID:
-            break;
-          case DBUS_TYPE_VARIANT:
+            DBusMessageIter subiter;
+            dbus_message_iter_recurse(iter, &subiter);
+            a_dbus_message_iter(L, &subiter);
+        }
+        nargs++;
+        break;
+      case DBUS_TYPE_DICT_ENTRY:
+        {
+            DBusMessageIter subiter;
+
+            /* initialize a sub iterator */
+            dbus_message_iter_recurse(iter, &subiter);
+            /* create a new table to store the dict */
+            a_dbus_message_iter(L, &subiter);
+        }
+        nargs++;
+        break;
+      case DBUS_TYPE_STRUCT:
+        {
+            DBusMessageIter subiter;
+            /* initialize a sub iterator */
+            dbus_message_iter_recurse(iter, &subiter);
+
+            int n = a_dbus_message_iter(L, &subiter);
+
+            /* create a new table to store all the value */
+            lua_createtable(L, n, 0);
+            /* move the table before array elements */
+            lua_insert(L, - n - 1);
+
+            for(int i = n; i > 0; i--)
+                lua_rawseti(L, - i - 1, i);
+        }
+        nargs++;
+        break;
+      case DBUS_TYPE_ARRAY:
+        {
+            int array_type = dbus_message_iter_get_element_type(iter);
+
+            if(dbus_type_is_fixed(array_type))
             {
-                DBusMessageIter subiter;
-                dbus_message_iter_recurse(iter, &subiter);
-                a_dbus_message_iter(L, &subiter);
+                DBusMessageIter sub;
+                dbus_message_iter_recurse(iter, &sub);
+
+                switch(array_type)
+                {
+                  int datalen;
+#define DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(type, dbustype, pusher) \
+                  case dbustype: \
+                    { \
+                        const type *data; \
+                        dbus_message_iter_get_fixed_array(&sub, &data, &datalen); \
+                        lua_createtable(L, datalen, 0); \
+                        for(int i = 0; i < datalen; i++) \
+                        { \
+                            pusher(L, data[i]); \
+                            lua_rawseti(L, -2, i + 1); \
+                        } \
+                    } \
+                    break;
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int16_t, DBUS_TYPE_INT16, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int32_t, DBUS_TYPE_INT32, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int64_t, DBUS_TYPE_INT64, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(double, DBUS_TYPE_DOUBLE, lua_pushnumber)
+#undef DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT
+                  case DBUS_TYPE_BYTE:
+                    {
+                        const char *c;
+                        dbus_message_iter_get_fixed_array(&sub, &c, &datalen);
+                        lua_pushlstring(L, c, datalen);
+                    }
+                    break;
+                  case DBUS_TYPE_BOOLEAN:
+                    {
+                        const dbus_bool_t *b;
+                        dbus_message_iter_get_fixed_array(&sub, &b, &datalen);
+                        lua_createtable(L, datalen, 0);
+                        for(int i = 0; i < datalen; i++)
+                        {
+                            lua_pushboolean(L, b[i]);
+                            lua_rawseti(L, -2, i + 1);
+                        }
+                    }
+                    break;
+                }
             }
-            nargs++;
-            break;
-          case DBUS_TYPE_DICT_ENTRY:
+            else if(array_type == DBUS_TYPE_DICT_ENTRY)
             {
                 DBusMessageIter subiter;
-
                 /* initialize a sub iterator */
                 dbus_message_iter_recurse(iter, &subiter);
-                /* create a new table to store the dict */
-                a_dbus_message_iter(L, &subiter);
+
+                /* get the keys and the values
+                 * n is the number of entry in dict */
+                int n = a_dbus_message_iter(L, &subiter);
+
+                /* create a new table to store all the value */
+                lua_createtable(L, n, 0);
+                /* move the table before array elements */
+                lua_insert(L, - (n * 2) - 1);
+
+                for(int i = 0; i < n; i ++)
+                    lua_rawset(L, - (n * 2) - 1 + i * 2);
             }
-            nargs++;
-            break;
-          case DBUS_TYPE_STRUCT:
+            else
             {
                 DBusMessageIter subiter;
-                /* initialize a sub iterator */
+                /* prepare to dig into the array*/
                 dbus_message_iter_recurse(iter, &subiter);
 
+                /* now iterate over every element of the array */
                 int n = a_dbus_message_iter(L, &subiter);
 
                 /* create a new table to store all the value */
@@ -121,145 +248,176 @@ a_dbus_message_iter(lua_State *L, DBusMessageIter *iter)
                 for(int i = n; i > 0; i--)
                     lua_rawseti(L, - i - 1, i);
             }
-            nargs++;
-            break;
-          case DBUS_TYPE_ARRAY:
-            {
-                int array_type = dbus_message_iter_get_element_type(iter);
+        }
+        nargs++;
+        break;
+      case DBUS_TYPE_BOOLEAN:
+        {
+            dbus_bool_t b;
+            dbus_message_iter_get_basic(iter, &b);
+            lua_pushboolean(L, b);
+        }
+        nargs++;
+        break;
+      case DBUS_TYPE_BYTE:
+        {
+            char c;
+            dbus_message_iter_get_basic(iter, &c);
+            lua_pushlstring(L, &c, 1);
+        }
+        nargs++;
+        break;
+#define DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(type, dbustype, pusher) \
+      case dbustype: \
+        { \
+            type ui; \
+            dbus_message_iter_get_basic(iter, &ui); \
+            pusher(L, ui); \
+        } \
+        nargs++; \
+        break;
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int16_t, DBUS_TYPE_INT16, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int32_t, DBUS_TYPE_INT32, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int64_t, DBUS_TYPE_INT64, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(double, DBUS_TYPE_DOUBLE, lua_pushnumber)
+#undef DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT
+      case DBUS_TYPE_STRING:
+        {
+            char *s;
+            dbus_message_iter_get_basic(iter, &s);
+            lua_pushstring(L, s);
+        }
+        nargs++;
+        break;
+    }
 
-                if(dbus_type_is_fixed(array_type))
-                {
-                    DBusMessageIter sub;
-                    dbus_message_iter_recurse(iter, &sub);
+    return nargs;
+}
 
-                    switch(array_type)
-                    {
-                      int datalen;
-#define DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(type, dbustype, pusher) \
-                      case dbustype: \
-                        { \
-                            const type *data; \
-                            dbus_message_iter_get_fixed_array(&sub, &data, &datalen); \
-                            lua_createtable(L, datalen, 0); \
-                            for(int i = 0; i < datalen; i++) \
-                            { \
-                                pusher(L, data[i]); \
-                                lua_rawseti(L, -2, i + 1); \
-                            } \
-                        } \
-                        break;
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int16_t, DBUS_TYPE_INT16, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int32_t, DBUS_TYPE_INT32, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int64_t, DBUS_TYPE_INT64, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(double, DBUS_TYPE_DOUBLE, lua_pushnumber)
-#undef DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT
-                      case DBUS_TYPE_BYTE:
-                        {
-                            const char *c;
-                            dbus_message_iter_get_fixed_array(&sub, &c, &datalen);
-                            lua_pushlstring(L, c, datalen);
-                        }
-                        break;
-                      case DBUS_TYPE_BOOLEAN:
-                        {
-                            const dbus_bool_t *b;
-                            dbus_message_iter_get_fixed_array(&sub, &b, &datalen);
-                            lua_createtable(L, datalen, 0);
-                            for(int i = 0; i < datalen; i++)
-                            {
-                                lua_pushboolean(L, b[i]);
-                                lua_rawseti(L, -2, i + 1);
-                            }
-                        }
-                        break;
-                    }
-                }
-                else if(array_type == DBUS_TYPE_DICT_ENTRY)
-                {
-                    DBusMessageIter subiter;
-                    /* initialize a sub iterator */
-                    dbus_message_iter_recurse(iter, &subiter);
+/** Iterate through the D-Bus messages counting each or traverse each sub message.
+ * \param L The Lua VM state.
+ * \param iter The D-Bus message iterator pointer
+ * \return The number of arguments in the iterator
+ */
+static int
+a_dbus_message_iter(lua_State *L, DBusMessageIter *iter)
+{
+    int nargs = 0;
 
-                    /* get the keys and the values
-                     * n is the number of entry in dict */
-                    int n = a_dbus_message_iter(L, &subiter);
+    do
+        nargs += a_dbus_message_iter_value(L, iter);
+    while(dbus_message_iter_next(iter));
 
-                    /* create a new table to store all the value */
-                    lua_createtable(L, n, 0);
-                    /* move the table before array elements */
-                    lua_insert(L, - (n * 2) - 1);
+    return nargs;
+}
 
-                    for(int i = 0; i < n; i ++)
-                        lua_rawset(L, - (n * 2) - 1 + i * 2);
-                }
-                else
-                {
-                    DBusMessageIter subiter;
-                    /* prepare to dig into the array*/
-                    dbus_message_iter_recurse(iter, &subiter);
+/** Decode one argument of a lazily decoded message.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_dbus_args_index(lua_State *L)
+{
+    DBusMessage **msg = luaL_checkudata(L, 1, DBUS_ARGS_METATABLE);
+    DBusMessageIter iter;
 
-                    /* now iterate over every element of the array */
-                    int n = a_dbus_message_iter(L, &subiter);
+    if(!lua_isnumber(L, 2))
+        return 0;
 
-                    /* create a new table to store all the value */
-                    lua_createtable(L, n, 0);
-                    /* move the table before array elements */
-                    lua_insert(L, - n - 1);
+    int n = lua_tointeger(L, 2);
+    if(n < 1 || !dbus_message_iter_init(*msg, &iter))
+        return 0;
+    while(--n)
+        if(!dbus_message_iter_next(&iter))
+            return 0;
 
-                    for(int i = n; i > 0; i--)
-                        lua_rawseti(L, - i - 1, i);
-                }
-            }
-            nargs++;
-            break;
-          case DBUS_TYPE_BOOLEAN:
-            {
-                dbus_bool_t b;
-                dbus_message_iter_get_basic(iter, &b);
-                lua_pushboolean(L, b);
-            }
-            nargs++;
-            break;
-          case DBUS_TYPE_BYTE:
-            {
-                char c;
-                dbus_message_iter_get_basic(iter, &c);
-                lua_pushlstring(L, &c, 1);
-            }
-            nargs++;
-            break;
-#define DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(type, dbustype, pusher) \
-          case dbustype: \
-            { \
-                type ui; \
-                dbus_message_iter_get_basic(iter, &ui); \
-                pusher(L, ui); \
-            } \
-            nargs++; \
-            break;
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int16_t, DBUS_TYPE_INT16, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int32_t, DBUS_TYPE_INT32, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int64_t, DBUS_TYPE_INT64, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(double, DBUS_TYPE_DOUBLE, lua_pushnumber)
-#undef DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT
-          case DBUS_TYPE_STRING:
-            {
-                char *s;
-                dbus_message_iter_get_basic(iter, &s);
-                lua_pushstring(L, s);
-            }
-            nargs++;
-            break;
-        }
-    } while(dbus_message_iter_next(iter));
+    return a_dbus_message_iter_value(L, &iter);
+}
 
-    return nargs;
+/** Count the arguments of a lazily decoded message.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_dbus_args_len(lua_State *L)
+{
+    DBusMessage **msg = luaL_checkudata(L, 1, DBUS_ARGS_METATABLE);
+    DBusMessageIter iter;
+    int n = 0;
+
+    if(dbus_message_iter_init(*msg, &iter))
+        do
+            n++;
+        while(dbus_message_iter_next(&iter));
+
+    lua_pushinteger(L, n);
+    return 1;
+}
+
+static int
+luaA_dbus_args_gc(lua_State *L)
+{
+    DBusMessage **msg = luaL_checkudata(L, 1, DBUS_ARGS_METATABLE);
+    dbus_message_unref(*msg);
+    return 0;
+}
+
+/** Push an object giving access to the arguments of a message.
+ * The message is kept alive until the object is collected.
+ * \param L The Lua VM state.
+ * \param msg The message.
+ */
+static void
+luaA_dbus_args_push(lua_State *L, DBusMessage *msg)
+{
+    DBusMessage **udata = lua_newuserdata(L, sizeof(*udata));
+    *udata = dbus_message_ref(msg);
+
+    if(luaL_newmetatable(L, DBUS_ARGS_METATABLE))
+    {
+        lua_pushcfunction(L, luaA_dbus_args_index);
+        lua_setfield(L, -2, "__index");
+        lua_pushcfunction(L, luaA_dbus_args_len);
+        lua_setfield(L, -2, "__len");
+        lua_pushcfunction(L, luaA_dbus_args_gc);
+        lua_setfield(L, -2, "__gc");
+    }
+    lua_setmetatable(L, -2);
+}
+
+/** Check if a message passes the filter of its receiver.
+ * This only looks at the header and the first argument, so that ignored
+ * messages are never converted to Lua values.
+ * \param filter The filter, may be NULL.
+ * \param msg The message.
+ * \return True if the message should be handled.
+ */
+static bool
+a_dbus_filter_match(dbus_filter_t *filter, DBusMessage *msg)
+{
+    if(!filter)
+        return true;
+
+    if(filter->member && A_STRNEQ(filter->member, dbus_message_get_member(msg)))
+        return false;
+
+    if(filter->arg0)
+    {
+        DBusMessageIter iter;
+        const char *arg0;
+
+        if(!dbus_message_iter_init(msg, &iter)
+           || dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_STRING)
+            return false;
+        dbus_message_iter_get_basic(&iter, &arg0);
+        if(A_STRNEQ(filter->arg0, arg0))
+            return false;
+    }
+
+    return true;
 }
 
 static bool
@@ -355,6 +513,12 @@ a_dbus_process_request(DBusConnection *dbus_connection, DBusMessage *msg)
     const char *interface = dbus_message_get_interface(msg);
     lua_State *L = globalconf_get_lua_State();
     int old_top = lua_gettop(L);
+    dbus_filter_t *filter = dbus_filter_getbyname(interface);
+
+    /* Nobody would see the message, don't even decode it */
+    if(!signal_array_getbyname(&dbus_signals, interface)
+       || !a_dbus_filter_match(filter, msg))
+        return;
 
     lua_createtable(L, 0, 5);
 
@@ -406,7 +570,12 @@ a_dbus_process_request(DBusConnection *dbus_connection, DBusMessage *msg)
     DBusMessageIter iter;
     int nargs = 1;
 
-    if(dbus_message_iter_init(msg, &iter))
+    if(filter && filter->lazy)
+    {
+        luaA_dbus_args_push(L, msg);
+        nargs++;
+    }
+    else if(dbus_message_iter_init(msg, &iter))
         nargs += a_dbus_message_iter(L, &iter);
 
     if(dbus_message_get_no_reply(msg))
@@ -749,9 +918,19 @@ luaA_dbus_remove_match(lua_State *L)
 }
 
 /** Add a signal receiver on the D-Bus.
+ *
+ * Messages which do not pass the filter are dropped before any of their
+ * arguments are converted to Lua values.
  *
  * @param interface A string with the interface name.
  * @param func The function to call.
+ * @tparam[opt] table filter Only receive some messages of the interface.
+ * @tparam[opt] string filter.member Only messages with this member.
+ * @tparam[opt] string filter.arg0 Only messages whose first argument is this
+ *   string.
+ * @tparam[opt=false] boolean filter.lazy Instead of all arguments, pass a
+ *   single object to the function after the message table. Indexing it with
+ *   `n` decodes the nth argument and `#` gives the number of arguments.
  * @return true on success, nil + error if the signal could not be connected
  * because another function is already connected.
  * @function connect_signal
@@ -761,6 +940,8 @@ luaA_dbus_connect_signal(lua_State *L)
 {
     const char *name = luaL_checkstring(L, 1);
     luaA_checkfunction(L, 2);
+    if(!lua_isnoneornil(L, 3))
+        luaA_checktable(L, 3);
     signal_t *sig = signal_array_getbyname(&dbus_signals, name);
     if(sig) {
         luaA_warn(L, "cannot add signal %s on D-Bus, already existing", name);
@@ -768,6 +949,22 @@ luaA_dbus_connect_signal(lua_State *L)
         lua_pushfstring(L, "cannot add signal %s on D-Bus, already existing", name);
         return 2;
     } else {
+        if(!lua_isnoneornil(L, 3))
+        {
+            dbus_filter_t filter = { .interface = a_strdup(name) };
+
+            lua_getfield(L, 3, "member");
+            if(!lua_isnil(L, -1))
+                filter.member = a_strdup(luaL_checkstring(L, -1));
+            lua_getfield(L, 3, "arg0");
+            if(!lua_isnil(L, -1))
+                filter.arg0 = a_strdup(luaL_checkstring(L, -1));
+            lua_getfield(L, 3, "lazy");
+            filter.lazy = lua_toboolean(L, -1);
+            lua_pop(L, 3);
+
+            dbus_filter_array_append(&dbus_filters, filter);
+        }
         signal_connect(&dbus_signals, name, luaA_object_ref(L, 2));
         lua_pushboolean(L, 1);
         return 1;
@@ -787,7 +984,16 @@ luaA_dbus_disconnect_signal(lua_State *L)
     luaA_checkfunction(L, 2);
     const void *func = lua_topointer(L, 2);
     if (signal_disconnect(&dbus_signals, name, func))
+    {
         luaA_object_unref(L, func);
+
+        dbus_filter_t *filter = dbus_filter_getbyname(name);
+        if(filter)
+        {
+            dbus_filter_t removed = dbus_filter_array_remove(&dbus_filters, filter);
+            dbus_filter_wipe(&removed);
+        }
+    }
     return 0;
 }
 
@@ -22,6 +22,7 @@
 #include "config.h"
 #include "draw.h"
 #include "globalconf.h"
+#include "common/pixels.h"
 
 #include <langinfo.h>
 #include <errno.h>
@@ -50,20 +51,11 @@ cairo_surface_t *
 draw_surface_from_data(int width, int height, uint32_t *data)
 {
     unsigned long int len = width * height;
-    unsigned long int i;
     uint32_t *buffer = p_new(uint32_t, len);
     cairo_surface_t *surface;
 
     /* Cairo wants premultiplied alpha, meh :( */
-    for(i = 0; i < len; i++)
-    {
-        uint8_t a = (data[i] >> 24) & 0xff;
-        double alpha = a / 255.0;
-        uint8_t r = ((data[i] >> 16) & 0xff) * alpha;
-        uint8_t g = ((data[i] >>  8) & 0xff) * alpha;
-        uint8_t b = ((data[i] >>  0) & 0xff) * alpha;
-        buffer[i] = (a << 24) | (r << 16) | (g << 8) | b;
-    }
+    pixels_premultiply_argb(buffer, data, len);
 
     surface =
         cairo_image_surface_create_for_data((unsigned char *) buffer,
@@ -77,6 +69,18 @@ draw_surface_from_data(int width, int height, uint32_t *data)
     return surface;
 }
 
+/** Get the surface of an icon, decoding it if this was not done yet.
+ * \param icon The icon.
+ * \return The surface, still owned by the icon.
+ */
+cairo_surface_t *
+draw_icon_get_surface(draw_icon_t *icon)
+{
+    if(!icon->surface)
+        icon->surface = draw_surface_from_data(icon->width, icon->height, icon->data);
+    return icon->surface;
+}
+
 /** Create a surface object from this pixbuf
  * \param buf The pixbuf
  * \return Number of items pushed on the lua stack.
@@ -104,27 +108,11 @@ draw_surface_from_pixbuf(GdkPixbuf *buf)
 
     for (int y = 0; y < height; y++)
     {
-        guchar *row = pixels;
         uint32_t *cairo = (uint32_t *) cairo_pixels;
-        for (int x = 0; x < width; x++) {
-            if (channels == 3)
-            {
-                uint8_t r = *row++;
-                uint8_t g = *row++;
-                uint8_t b = *row++;
-                *cairo++ = (r << 16) | (g << 8) | b;
-            } else {
-                uint8_t r = *row++;
-                uint8_t g = *row++;
-                uint8_t b = *row++;
-                uint8_t a = *row++;
-                double alpha = a / 255.0;
-                r = r * alpha;
-                g = g * alpha;
-                b = b * alpha;
-                *cairo++ = (a << 24) | (r << 16) | (g << 8) | b;
-            }
-        }
+        if (channels == 3)
+            pixels_convert_rgb(cairo, pixels, width);
+        else
+            pixels_premultiply_rgba(cairo, pixels, width);
         pixels += pix_stride;
         cairo_pixels += cairo_stride;
     }
@@ -57,6 +57,29 @@ cairo_surface_array_destroy_surface(cairo_surface_t **s)
 }
 DO_ARRAY(cairo_surface_t *, cairo_surface, cairo_surface_array_destroy_surface)
 
+/** One size of an icon.
+ * Icons coming from a window property are only converted to a cairo surface
+ * when they are first used, see draw_icon_get_surface().
+ */
+typedef struct
+{
+    uint32_t width, height;
+    /** Non-premultiplied ARGB data owned by the caller, or NULL */
+    uint32_t *data;
+    /** The decoded icon, or NULL if it was not used yet */
+    cairo_surface_t *surface;
+} draw_icon_t;
+
+static inline void
+draw_icon_wipe(draw_icon_t *icon)
+{
+    if(icon->surface)
+        cairo_surface_destroy(icon->surface);
+}
+DO_ARRAY(draw_icon_t, draw_icon, draw_icon_wipe)
+
+cairo_surface_t *draw_icon_get_surface(draw_icon_t *);
+
 cairo_surface_t *draw_surface_from_data(int width, int height, uint32_t *data);
 cairo_surface_t *draw_dup_image_surface(cairo_surface_t *surface);
 cairo_surface_t *draw_load_image(lua_State *L, const char *path, GError **error);
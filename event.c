@@ -28,23 +28,199 @@
 #include "ewmh.h"
 #include "objects/client.h"
 #include "keygrabber.h"
+#include "mouse.h"
 #include "mousegrabber.h"
 #include "luaa.h"
 #include "systray.h"
 #include "xkb.h"
+#include "thumbnail.h"
 #include "objects/screen.h"
 #include "common/atoms.h"
+#include "common/hash.h"
 #include "common/xutil.h"
 
 #include <xcb/xcb.h>
 #include <xcb/randr.h>
 #include <xcb/shape.h>
+#include <xcb/composite.h>
+#include <xcb/damage.h>
 #include <xcb/xcb_atom.h>
 #include <xcb/xcb_icccm.h>
 #include <xcb/xcb_event.h>
 #include <xcb/xkb.h>
+#include <cairo.h>
 
-#define DO_EVENT_HOOK_CALLBACK(type, xcbtype, xcbeventprefix, arraytype, match) \
+static inline uint32_t
+event_uint64_hash(uint64_t key)
+{
+    return a_inthash(key ^ a_inthash(key >> 32));
+}
+
+/** Binding arrays shorter than this are searched linearly. */
+#define BINDING_INDEX_MIN_LEN 8
+
+/** The key of a binding in a binding index.
+ * \param kind Which code this is, e.g. keycode or keysym.
+ * \param code The code.
+ * \param modifiers The exact modifiers.
+ */
+#define BINDING_KEY(kind, code, modifiers) \
+    (((uint64_t) (kind) << 48) | ((uint64_t) (modifiers) << 32) | (uint32_t) (code))
+
+/** Get the keys under which a binding has to be found, see BINDING_KEY().
+ * Returns the number of keys, 0 if the binding has to be tested for every
+ * event.
+ */
+typedef int (event_binding_keys_t)(void *, uint64_t *);
+
+DO_HASH(uint64_t, int, event_binding, event_uint64_hash, a_inteq)
+
+/** An entry of a binding index chain */
+typedef struct
+{
+    /** The binding's index in its array */
+    int item;
+    /** The next entry with the same key, or -1 */
+    int next;
+} event_binding_entry_t;
+
+/** An index over the key or button bindings of an array */
+typedef struct
+{
+    /** The array content this index was built for */
+    void **tab;
+    int len;
+    /** The first entry for each key */
+    event_binding_hash_t first;
+    /** Up to two entries per binding */
+    event_binding_entry_t *entries;
+    /** The bindings without a key, in array order */
+    int *wildcards;
+    int wildcards_len;
+} event_binding_index_t;
+
+static void
+event_binding_index_delete(event_binding_index_t **index)
+{
+    event_binding_hash_wipe(&(*index)->first);
+    p_delete(&(*index)->entries);
+    p_delete(&(*index)->wildcards);
+    p_delete(index);
+}
+
+DO_HASH(const void *, event_binding_index_t *, event_binding_index, a_ptrhash, a_inteq)
+
+/** The binding indexes, by the address of their array */
+static event_binding_index_hash_t binding_indexes;
+/** The value of globalconf.bindings_generation for binding_indexes */
+static unsigned int binding_indexes_generation;
+
+/** Get the index of a binding array, building it if needed.
+ * \param array The address of the array, used as cache key.
+ * \param tab The array content.
+ * \param len The array length.
+ * \param item_keys Get the keys of a binding.
+ * \return The index.
+ */
+static event_binding_index_t *
+event_binding_index_get(const void *array, void **tab, int len,
+                        event_binding_keys_t *item_keys)
+{
+    if(binding_indexes_generation != globalconf.bindings_generation)
+    {
+        hash_foreach(slot, binding_indexes)
+            event_binding_index_delete(&slot->value);
+        event_binding_index_hash_clear(&binding_indexes);
+        binding_indexes_generation = globalconf.bindings_generation;
+    }
+
+    event_binding_index_t **found = event_binding_index_hash_lookup(&binding_indexes, array);
+    if(found && (*found)->tab == tab && (*found)->len == len)
+        return *found;
+    if(found)
+        event_binding_index_delete(found);
+
+    event_binding_index_t *index = p_new(event_binding_index_t, 1);
+    int nentries = 0;
+    index->tab = tab;
+    index->len = len;
+    index->entries = p_new(event_binding_entry_t, 2 * len);
+    index->wildcards = p_new(int, len);
+
+    /* Go backwards so that the chains and the wildcards are in array order */
+    for(int i = len - 1; i >= 0; i--)
+    {
+        uint64_t keys[2];
+        int nkeys = item_keys(tab[i], keys);
+
+        if(nkeys == 0)
+            index->wildcards[len - 1 - index->wildcards_len++] = i;
+        for(int k = 0; k < nkeys; k++)
+        {
+            int *first = event_binding_hash_lookup(&index->first, keys[k]);
+            index->entries[nentries].item = i;
+            index->entries[nentries].next = first ? *first : -1;
+            event_binding_hash_insert(&index->first, keys[k], nentries++);
+        }
+    }
+    memmove(index->wildcards, index->wildcards + len - index->wildcards_len,
+            index->wildcards_len * sizeof(*index->wildcards));
+
+    event_binding_index_hash_insert(&binding_indexes, array, index);
+    return index;
+}
+
+/** Find the bindings of an array which may match an event.
+ * \param array The address of the array.
+ * \param tab The array content.
+ * \param len The array length.
+ * \param item_keys Get the keys of a binding.
+ * \param keys The keys of the event.
+ * \param nkeys The number of keys of the event.
+ * \param candidates Filled with the candidates' indexes in array order, must
+ * have space for len values.
+ * \return The number of candidates.
+ */
+static int
+event_binding_candidates(const void *array, void **tab, int len,
+                         event_binding_keys_t *item_keys,
+                         const uint64_t *keys, int nkeys, int *candidates)
+{
+    int count = 0;
+
+    if(len < BINDING_INDEX_MIN_LEN)
+    {
+        for(int i = 0; i < len; i++)
+            candidates[count++] = i;
+        return count;
+    }
+
+    event_binding_index_t *index = event_binding_index_get(array, tab, len, item_keys);
+
+    for(int i = 0; i < index->wildcards_len; i++)
+        candidates[count++] = index->wildcards[i];
+    for(int k = 0; k < nkeys; k++)
+    {
+        int *first = event_binding_hash_lookup(&index->first, keys[k]);
+        for(int e = first ? *first : -1; e >= 0; e = index->entries[e].next)
+        {
+            /* Insert sorted, there are only a few candidates */
+            int item = index->entries[e].item, pos = count;
+            while(pos > 0 && candidates[pos - 1] > item)
+                pos--;
+            if(pos > 0 && candidates[pos - 1] == item)
+                continue;
+            memmove(&candidates[pos + 1], &candidates[pos],
+                    (count - pos) * sizeof(*candidates));
+            candidates[pos] = item;
+            count++;
+        }
+    }
+    return count;
+}
+
+#define DO_EVENT_HOOK_CALLBACK(type, xcbtype, xcbeventprefix, arraytype, match, \
+                               item_keys, event_keys) \
     static void \
     event_##xcbtype##_callback(xcb_##xcbtype##_press_event_t *ev, \
                                arraytype *arr, \
@@ -55,15 +231,23 @@
     { \
         int abs_oud = oud < 0 ? ((lua_gettop(L) + 1) + oud) : oud; \
         int item_matching = 0; \
-        foreach(item, *arr) \
-            if(match(ev, *item, data)) \
+        uint64_t keys[2]; \
+        int nkeys = event_keys(ev, data, keys); \
+        int *candidates = p_alloca(int, arr->len); \
+        int ncandidates = event_binding_candidates(arr, (void **) arr->tab, arr->len, \
+                                                   item_keys, keys, nkeys, candidates); \
+        for(int c = 0; c < ncandidates; c++) \
+        { \
+            type *item = arr->tab[candidates[c]]; \
+            if(match(ev, item, data)) \
             { \
                 if(oud) \
-                    luaA_object_push_item(L, abs_oud, *item); \
+                    luaA_object_push_item(L, abs_oud, item); \
                 else \
-                    luaA_object_push(L, *item); \
+                    luaA_object_push(L, item); \
                 item_matching++; \
             } \
+        } \
         for(; item_matching > 0; item_matching--) \
         { \
             switch(ev->response_type) \
@@ -101,8 +285,52 @@ event_button_match(xcb_button_press_event_t *ev, button_t *b, void *data)
             && (b->modifiers == XCB_BUTTON_MASK_ANY || b->modifiers == ev->state));
 }
 
-DO_EVENT_HOOK_CALLBACK(button_t, button, XCB_BUTTON, button_array_t, event_button_match)
-DO_EVENT_HOOK_CALLBACK(keyb_t, key, XCB_KEY, key_array_t, event_key_match)
+static int
+event_key_keys(void *item, uint64_t *keys)
+{
+    keyb_t *k = item;
+    int nkeys = 0;
+
+    if(k->modifiers == XCB_BUTTON_MASK_ANY)
+        return 0;
+    if(k->keycode)
+        keys[nkeys++] = BINDING_KEY(0, k->keycode, k->modifiers);
+    if(k->keysym)
+        keys[nkeys++] = BINDING_KEY(1, k->keysym, k->modifiers);
+    return nkeys;
+}
+
+static int
+event_key_event_keys(xcb_key_press_event_t *ev, void *data, uint64_t *keys)
+{
+    xcb_keysym_t keysym = *(xcb_keysym_t *) data;
+    keys[0] = BINDING_KEY(0, ev->detail, ev->state);
+    keys[1] = BINDING_KEY(1, keysym, ev->state);
+    return 2;
+}
+
+static int
+event_button_keys(void *item, uint64_t *keys)
+{
+    button_t *b = item;
+
+    if(b->modifiers == XCB_BUTTON_MASK_ANY || !b->button)
+        return 0;
+    keys[0] = BINDING_KEY(0, b->button, b->modifiers);
+    return 1;
+}
+
+static int
+event_button_event_keys(xcb_button_press_event_t *ev, void *data, uint64_t *keys)
+{
+    keys[0] = BINDING_KEY(0, ev->detail, ev->state);
+    return 1;
+}
+
+DO_EVENT_HOOK_CALLBACK(button_t, button, XCB_BUTTON, button_array_t, event_button_match,
+                       event_button_keys, event_button_event_keys)
+DO_EVENT_HOOK_CALLBACK(keyb_t, key, XCB_KEY, key_array_t, event_key_match,
+                       event_key_keys, event_key_event_keys)
 
 /** Handle an event with mouse grabber if needed
  * \param x The x coordinate.
@@ -183,6 +411,7 @@ event_handle_button(xcb_button_press_event_t *ev)
             state |= change;
         else
             state &= ~change;
+        mouse_pointer_update(ev->root_x, ev->root_y, state, ev->same_screen);
         if(event_handle_mousegrabber(ev->root_x, ev->root_y, state))
             return;
     }
@@ -211,7 +440,7 @@ event_handle_button(xcb_button_press_event_t *ev)
         event_emit_button(L, ev);
         lua_pop(L, 1);
         /* check if any button object matches */
-        event_button_callback(ev, &drawin->buttons, L, -1, 1, NULL);
+        event_button_callback(ev, button_set_items(drawin->buttons), L, -1, 1, NULL);
         /* Either we are receiving this due to ButtonPress/Release on the root
          * window or because we grabbed the button on the window. In the later
          * case we have to call AllowEvents.
@@ -259,7 +488,7 @@ event_handle_button(xcb_button_press_event_t *ev)
                 }
             }
             /* then check if any button objects match */
-            event_button_callback(ev, &c->buttons, L, -1, 1, NULL);
+            event_button_callback(ev, button_set_items(c->buttons), L, -1, 1, NULL);
         }
         xcb_allow_events(globalconf.connection,
                          XCB_ALLOW_REPLAY_POINTER,
@@ -392,6 +621,7 @@ event_handle_configurerequest(xcb_configure_request_event_t *ev)
         }
 
         c->got_configure_request = true;
+        c->geometry_need_refresh = true;
 
         /* Request the changes to be applied */
         luaA_object_push(L, c);
@@ -463,7 +693,7 @@ event_handle_configurenotify(xcb_configure_notify_event_t *ev)
     xcb_screen_t *screen = globalconf.screen;
 
     if(ev->window == screen->root)
-        globalconf.screen_need_refresh = true;
+        screen_schedule_refresh();
 
     /* Copy what XRRUpdateConfiguration() would do: Update the configuration */
     if(ev->window == screen->root) {
@@ -510,6 +740,9 @@ event_drawable_under_mouse(lua_State *L, int ud)
 
     if (globalconf.drawable_under_mouse != NULL)
     {
+        /* Motion held back by its rate limit would come after the leave */
+        drawable_cancel_motion(L, globalconf.drawable_under_mouse);
+
         /* Emit leave on previous drawable */
         luaA_object_push(L, globalconf.drawable_under_mouse);
         luaA_object_emit_signal(L, -1, "mouse::leave", 0);
@@ -541,39 +774,50 @@ event_handle_motionnotify(xcb_motion_notify_event_t *ev)
 
     globalconf.timestamp = ev->time;
 
+    mouse_pointer_update(ev->root_x, ev->root_y, ev->state, ev->same_screen);
     if(event_handle_mousegrabber(ev->root_x, ev->root_y, ev->state))
         return;
 
+    /* Motion is frequent and most objects do not listen to it. Nothing is
+     * pushed for objects without handlers, unless the pointer moved onto a
+     * new drawable. */
     if((c = client_getbyframewin(ev->event)))
     {
-        luaA_object_push(L, c);
-        lua_pushinteger(L, ev->event_x);
-        lua_pushinteger(L, ev->event_y);
-        luaA_object_emit_signal(L, -3, "mouse::move", 2);
-
         /* now check if a titlebar was "hit" */
         int x = ev->event_x, y = ev->event_y;
         drawable_t *d = client_get_drawable_offset(c, &x, &y);
-        if (d)
+        bool emit = luaA_object_has_signal(&client_class, c, "mouse::move");
+
+        if (d && d == globalconf.drawable_under_mouse && !drawable_wants_motion(d))
+            d = NULL;
+
+        if (emit || d)
         {
-            luaA_object_push_item(L, -1, d);
-            event_drawable_under_mouse(L, -1);
-            lua_pushinteger(L, x);
-            lua_pushinteger(L, y);
-            luaA_object_emit_signal(L, -3, "mouse::move", 2);
+            luaA_object_push(L, c);
+            if (emit)
+            {
+                lua_pushinteger(L, ev->event_x);
+                lua_pushinteger(L, ev->event_y);
+                luaA_object_emit_signal(L, -3, "mouse::move", 2);
+            }
+            if (d)
+            {
+                luaA_object_push_item(L, -1, d);
+                event_drawable_under_mouse(L, -1);
+                drawable_emit_motion(L, -1, x, y);
+                lua_pop(L, 1);
+            }
             lua_pop(L, 1);
         }
-        lua_pop(L, 1);
     }
 
-    if((w = drawin_getbywin(ev->event)))
+    if((w = drawin_getbywin(ev->event))
+       && (w->drawable != globalconf.drawable_under_mouse || drawable_wants_motion(w->drawable)))
     {
         luaA_object_push(L, w);
         luaA_object_push_item(L, -1, w->drawable);
         event_drawable_under_mouse(L, -1);
-        lua_pushinteger(L, ev->event_x);
-        lua_pushinteger(L, ev->event_y);
-        luaA_object_emit_signal(L, -3, "mouse::move", 2);
+        drawable_emit_motion(L, -1, ev->event_x, ev->event_y);
         lua_pop(L, 2);
     }
 }
@@ -589,6 +833,9 @@ event_handle_leavenotify(xcb_leave_notify_event_t *ev)
 
     globalconf.timestamp = ev->time;
 
+    /* Bit 1 of same_screen_focus is the same-screen flag */
+    mouse_pointer_update(ev->root_x, ev->root_y, ev->state, ev->same_screen_focus & 2);
+
     if(ev->mode != XCB_NOTIFY_MODE_NORMAL)
         return;
 
@@ -619,6 +866,9 @@ event_handle_enternotify(xcb_enter_notify_event_t *ev)
 
     globalconf.timestamp = ev->time;
 
+    /* Bit 1 of same_screen_focus is the same-screen flag */
+    mouse_pointer_update(ev->root_x, ev->root_y, ev->state, ev->same_screen_focus & 2);
+
     if(ev->mode != XCB_NOTIFY_MODE_NORMAL)
         return;
 
@@ -721,6 +971,9 @@ event_handle_key(xcb_key_press_event_t *ev)
     lua_State *L = globalconf_get_lua_State();
     globalconf.timestamp = ev->time;
 
+    /* Key bindings often look for the screen under the pointer */
+    mouse_pointer_update(ev->root_x, ev->root_y, ev->state, ev->same_screen);
+
     if(globalconf.keygrabber != LUA_REFNIL)
     {
         if(keygrabber_handlekpress(L, ev))
@@ -742,7 +995,7 @@ event_handle_key(xcb_key_press_event_t *ev)
         if((c = client_getbywin(ev->event)) || (c = client_getbynofocuswin(ev->event)))
         {
             luaA_object_push(L, c);
-            event_key_callback(ev, &c->keys, L, -1, 1, &keysym);
+            event_key_callback(ev, key_set_items(c->keys), L, -1, 1, &keysym);
         }
         else
             event_key_callback(ev, &globalconf.keys, L, 0, 0, &keysym);
@@ -798,13 +1051,15 @@ event_handle_maprequest(xcb_map_request_event_t *ev)
     else
     {
         geom_c = xcb_get_geometry_unchecked(globalconf.connection, ev->window);
+        client_manage_cookies_t manage_c = client_manage_request(ev->window);
 
         if(!(geom_r = xcb_get_geometry_reply(globalconf.connection, geom_c, NULL)))
         {
+            client_manage_discard(&manage_c);
             goto bailout;
         }
 
-        client_manage(ev->window, geom_r, wa_r);
+        client_manage(ev->window, geom_r, wa_r, &manage_c);
 
         p_delete(&geom_r);
     }
@@ -848,7 +1103,7 @@ event_handle_randr_screen_change_notify(xcb_randr_screen_change_notify_event_t *
         globalconf.screen->height_in_millimeters = ev->mheight;;
     }
 
-    globalconf.screen_need_refresh = true;
+    screen_schedule_refresh();
 }
 
 /** XRandR event handler for RRNotify subtype XRROutputChangeNotifyEvent
@@ -991,8 +1246,15 @@ event_handle_selectionclear(xcb_selection_clear_event_t *ev)
 static void
 xerror(xcb_generic_error_t *e)
 {
+    const xcb_query_extension_reply_t *composite =
+        xcb_get_extension_data(globalconf.connection, &xcb_composite_id);
+
     /* ignore this */
     if(e->error_code == XCB_WINDOW
+       /* A thumbnail's window stopped being viewable before its pixmap
+        * was named */
+       || (e->error_code == XCB_MATCH && composite && composite->present
+           && e->major_code == composite->major_opcode)
        || (e->error_code == XCB_MATCH
            && e->major_code == XCB_SET_INPUT_FOCUS)
        || (e->error_code == XCB_VALUE
@@ -1010,30 +1272,69 @@ xerror(xcb_generic_error_t *e)
     return;
 }
 
+/** Ignore the enter and leave events generated by a range of requests.
+ * A range which starts right after the previous one ends is merged into it.
+ * \param begin The first request of the range.
+ * \param end The last request of the range.
+ */
+void
+event_ignore_enterleave(xcb_void_cookie_t begin, xcb_void_cookie_t end)
+{
+    sequence_ring_t *ring = &globalconf.ignore_enter_leave_events;
+
+    if (ring->len > 0) {
+        sequence_pair_t *last = &ring->tab[(ring->first + ring->len - 1) % ring->size];
+        /* Events caused by other clients after an UngrabServer carry its
+         * sequence number, so only directly adjacent ranges are merged */
+        if (begin.sequence - last->end.sequence <= 1) {
+            last->end = end;
+            return;
+        }
+    }
+
+    if (ring->len == ring->size) {
+        int size = MAX(ring->size * 2, 8);
+        sequence_pair_t *tab = p_new(sequence_pair_t, size);
+        for (int i = 0; i < ring->len; i++)
+            tab[i] = ring->tab[(ring->first + i) % ring->size];
+        p_delete(&ring->tab);
+        ring->tab = tab;
+        ring->first = 0;
+        ring->size = size;
+    }
+
+    sequence_pair_t *pair = &ring->tab[(ring->first + ring->len) % ring->size];
+    pair->begin = begin;
+    pair->end = end;
+    ring->len++;
+}
+
 static bool
 should_ignore(xcb_generic_event_t *event)
 {
     uint8_t response_type = XCB_EVENT_RESPONSE_TYPE(event);
+    sequence_ring_t *ring = &globalconf.ignore_enter_leave_events;
 
     /* Remove completed sequences */
     uint32_t sequence = event->full_sequence;
-    while (globalconf.ignore_enter_leave_events.len > 0) {
-        uint32_t end = globalconf.ignore_enter_leave_events.tab[0].end.sequence;
+    while (ring->len > 0) {
+        uint32_t end = ring->tab[ring->first].end.sequence;
         /* Do if (end >= sequence) break;, but handle wrap-around: The above is
          * equivalent to end-sequence > 0 (assuming unlimited precision). With
          * int32_t, this would mean that the sign bit is cleared, which means:
          */
         if (end - sequence < UINT32_MAX / 2)
             break;
-        sequence_pair_array_take(&globalconf.ignore_enter_leave_events, 0);
+        ring->first = (ring->first + 1) % ring->size;
+        ring->len--;
     }
 
     /* Check if this event should be ignored */
     if ((response_type == XCB_ENTER_NOTIFY || response_type == XCB_LEAVE_NOTIFY)
-            && globalconf.ignore_enter_leave_events.len > 0) {
-        uint32_t begin = globalconf.ignore_enter_leave_events.tab[0].begin.sequence;
-        uint32_t end   = globalconf.ignore_enter_leave_events.tab[0].end.sequence;
-        if (sequence >= begin && sequence <= end)
+            && ring->len > 0) {
+        uint32_t begin = ring->tab[ring->first].begin.sequence;
+        uint32_t end   = ring->tab[ring->first].end.sequence;
+        if (sequence - begin <= end - begin)
             return true;
     }
 
@@ -1086,9 +1387,177 @@ void event_handle(xcb_generic_event_t *event)
     EXTENSION_EVENT(randr, XCB_RANDR_NOTIFY, event_handle_randr_output_change_notify);
     EXTENSION_EVENT(shape, XCB_SHAPE_NOTIFY, event_handle_shape_notify);
     EXTENSION_EVENT(xkb, 0, event_handle_xkb_notify);
+    EXTENSION_EVENT(damage, XCB_DAMAGE_NOTIFY, thumbnail_handle_damage);
 #undef EXTENSION_EVENT
 }
 
+DO_HASH(uint64_t, bool, event_property, event_uint64_hash, a_inteq)
+DO_HASH(xcb_window_t, int, event_window, a_inthash, a_inteq)
+
+/** Merge the values of an older configure request into a newer one.
+ * \param ev The newer request.
+ * \param old The older request.
+ */
+static void
+event_merge_configure_request(xcb_configure_request_event_t *ev,
+                              xcb_configure_request_event_t *old)
+{
+    uint16_t missing = old->value_mask & ~ev->value_mask;
+
+#define MERGE(mask, field) \
+    if(missing & (mask)) \
+        ev->field = old->field
+    MERGE(XCB_CONFIG_WINDOW_X, x);
+    MERGE(XCB_CONFIG_WINDOW_Y, y);
+    MERGE(XCB_CONFIG_WINDOW_WIDTH, width);
+    MERGE(XCB_CONFIG_WINDOW_HEIGHT, height);
+    MERGE(XCB_CONFIG_WINDOW_BORDER_WIDTH, border_width);
+#undef MERGE
+
+    /* A sibling is only meaningful together with its stack mode */
+    if(!(ev->value_mask & (XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE)))
+    {
+        ev->sibling = old->sibling;
+        ev->stack_mode = old->stack_mode;
+    }
+    else
+        missing &= ~(XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE);
+
+    ev->value_mask |= missing;
+}
+
+/** Drop redundant events from a batch of events read from the X server.
+ * Only the last PropertyNotify per window and atom is kept, since the handlers
+ * read the current value anyway. Configure requests for a window are merged
+ * into the last one and the areas of Expose events for a window are unified
+ * into a region. Nothing is merged across events changing the window tree,
+ * like map, unmap or destroy notifications, so their ordering is preserved.
+ * \param events The events. Dropped events are freed.
+ */
+void
+event_coalesce(event_array_t *events)
+{
+    /* Kept allocated between calls, only cleared */
+    static event_property_hash_t properties;
+    static event_window_hash_t configures, exposes;
+    cairo_region_t **regions = NULL;
+    bool dropped = false;
+
+    /* Walk backwards, so that the event which is kept is seen first */
+    for(int i = events->len - 1; i >= 0; i--)
+    {
+        xcb_generic_event_t *event = events->tab[i];
+        int *later;
+
+        switch(XCB_EVENT_RESPONSE_TYPE(event))
+        {
+          case XCB_PROPERTY_NOTIFY:
+            {
+                xcb_property_notify_event_t *ev = (void *) event;
+                uint64_t key = (uint64_t) ev->window << 32 | ev->atom;
+                if(!event_property_hash_lookup(&properties, key))
+                {
+                    event_property_hash_insert(&properties, key, true);
+                    continue;
+                }
+            }
+            break;
+          case XCB_CONFIGURE_REQUEST:
+            {
+                xcb_configure_request_event_t *ev = (void *) event;
+                if(!(later = event_window_hash_lookup(&configures, ev->window)))
+                {
+                    event_window_hash_insert(&configures, ev->window, i);
+                    continue;
+                }
+                event_merge_configure_request((void *) events->tab[*later], ev);
+            }
+            break;
+          case XCB_EXPOSE:
+            {
+                xcb_expose_event_t *ev = (void *) event;
+                if(!(later = event_window_hash_lookup(&exposes, ev->window)))
+                {
+                    event_window_hash_insert(&exposes, ev->window, i);
+                    continue;
+                }
+                if(!regions)
+                    regions = arena_new(&globalconf.arena, cairo_region_t *, events->len);
+                if(!regions[*later])
+                {
+                    xcb_expose_event_t *lev = (void *) events->tab[*later];
+                    regions[*later] = cairo_region_create_rectangle(&(cairo_rectangle_int_t) {
+                            .x = lev->x, .y = lev->y, .width = lev->width, .height = lev->height });
+                }
+                cairo_region_union_rectangle(regions[*later], &(cairo_rectangle_int_t) {
+                        .x = ev->x, .y = ev->y, .width = ev->width, .height = ev->height });
+            }
+            break;
+          case XCB_CREATE_NOTIFY:
+          case XCB_DESTROY_NOTIFY:
+          case XCB_MAP_REQUEST:
+          case XCB_MAP_NOTIFY:
+          case XCB_UNMAP_NOTIFY:
+          case XCB_REPARENT_NOTIFY:
+            event_property_hash_clear(&properties);
+            event_window_hash_clear(&configures);
+            event_window_hash_clear(&exposes);
+            continue;
+          default:
+            continue;
+        }
+
+        p_delete(&events->tab[i]);
+        dropped = true;
+    }
+
+    event_property_hash_clear(&properties);
+    event_window_hash_clear(&configures);
+    event_window_hash_clear(&exposes);
+
+    if(!dropped)
+        return;
+
+    /* Remove the dropped events and split the merged exposes into the
+     * rectangles of their region */
+    event_array_t result;
+    event_array_init(&result);
+    event_array_grow(&result, events->len);
+    for(int i = 0; i < events->len; i++)
+    {
+        if(!events->tab[i])
+            continue;
+
+        if(!regions || !regions[i])
+        {
+            event_array_append(&result, events->tab[i]);
+            continue;
+        }
+
+        int count = cairo_region_num_rectangles(regions[i]);
+        for(int r = 0; r < count; r++)
+        {
+            xcb_expose_event_t *ev = (void *) events->tab[i];
+            cairo_rectangle_int_t rect;
+
+            if(r > 0)
+                ev = (void *) p_dup(events->tab[i], 1);
+            cairo_region_get_rectangle(regions[i], r, &rect);
+            ev->x = rect.x;
+            ev->y = rect.y;
+            ev->width = rect.width;
+            ev->height = rect.height;
+            ev->count = count - r - 1;
+            event_array_append(&result, (xcb_generic_event_t *) ev);
+        }
+        cairo_region_destroy(regions[i]);
+    }
+
+    /* The events now belong to result */
+    p_delete(&events->tab);
+    *events = result;
+}
+
 void event_init(void)
 {
     const xcb_query_extension_reply_t *reply;
@@ -1104,6 +1573,10 @@ void event_init(void)
     reply = xcb_get_extension_data(globalconf.connection, &xcb_xkb_id);
     if (reply && reply->present)
         globalconf.event_base_xkb = reply->first_event;
+
+    reply = xcb_get_extension_data(globalconf.connection, &xcb_damage_id);
+    if (globalconf.have_composite && reply && reply->present)
+        globalconf.event_base_damage = reply->first_event;
 }
 
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
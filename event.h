@@ -24,12 +24,17 @@
 
 #include "banning.h"
 #include "globalconf.h"
+#include "profile.h"
 #include "stack.h"
 
 #include <xcb/xcb.h>
 
 /* luaa.c */
 void luaA_emit_refresh(void);
+void luaA_emit_refreshed(void);
+
+/* objects/drawable.c */
+void drawable_refresh(void);
 
 /* objects/drawin.c */
 void drawin_refresh(void);
@@ -48,19 +53,27 @@ void xkb_refresh(void);
 static inline int
 awesome_refresh(void)
 {
-    xkb_refresh();
-    screen_refresh();
-    luaA_emit_refresh();
-    drawin_refresh();
-    client_refresh();
-    banning_refresh();
-    stack_refresh();
-    client_destroy_later();
+    profile_cycle_begin();
+    PROFILE_STAGE(PROFILE_STAGE_XKB, xkb_refresh());
+    PROFILE_STAGE(PROFILE_STAGE_SCREEN, screen_refresh());
+    PROFILE_STAGE(PROFILE_STAGE_LUA_REFRESH, luaA_emit_refresh());
+    PROFILE_STAGE(PROFILE_STAGE_DRAWIN, drawin_refresh());
+    PROFILE_STAGE(PROFILE_STAGE_CLIENT, client_refresh());
+    PROFILE_STAGE(PROFILE_STAGE_DRAWABLE, drawable_refresh());
+    PROFILE_STAGE(PROFILE_STAGE_BANNING, banning_refresh());
+    PROFILE_STAGE(PROFILE_STAGE_STACK, stack_refresh());
+    PROFILE_STAGE(PROFILE_STAGE_DESTROY_LATER, client_destroy_later());
+    PROFILE_STAGE(PROFILE_STAGE_LUA_REFRESHED, luaA_emit_refreshed());
+    profile_cycle_end();
     return xcb_flush(globalconf.connection);
 }
 
+DO_ARRAY(xcb_generic_event_t *, event, p_delete)
+
 void event_init(void);
+void event_ignore_enterleave(xcb_void_cookie_t, xcb_void_cookie_t);
 void event_handle(xcb_generic_event_t *);
+void event_coalesce(event_array_t *);
 void event_drawable_under_mouse(lua_State *, int);
 
 #endif
@@ -21,6 +21,7 @@
 
 #include "ewmh.h"
 #include "objects/client.h"
+#include "objects/screen.h"
 #include "objects/tag.h"
 #include "common/atoms.h"
 #include "xwindow.h"
@@ -89,20 +90,68 @@ ewmh_update_net_active_window(lua_State *L)
     return 0;
 }
 
+/** The windows last written to _NET_CLIENT_LIST and _NET_CLIENT_LIST_STACKING */
+static window_array_t net_client_list, net_client_list_stacking;
+static bool need_net_client_list_update = false;
+
 static int
 ewmh_update_net_client_list(lua_State *L)
 {
+    need_net_client_list_update = true;
+    return 0;
+}
+
+/** Write a list of windows to a root window property, if it changed.
+ * When the new list only adds windows at the end of the old one, only the
+ * new windows are sent.
+ * \param cache The windows last written to the property, updated.
+ * \param atom The property.
+ * \param wins The windows.
+ * \param n The number of windows.
+ */
+static void
+ewmh_update_window_list(window_array_t *cache, xcb_atom_t atom,
+                        xcb_window_t *wins, int n)
+{
+    int common = MIN(cache->len, n);
+
+    if(common && memcmp(cache->tab, wins, common * sizeof(*wins)))
+        common = 0;
+    else if(common == n && cache->len == n)
+        return;
+
+    if(common == cache->len && common > 0)
+        xcb_change_property(globalconf.connection, XCB_PROP_MODE_APPEND,
+                            globalconf.screen->root,
+                            atom, XCB_ATOM_WINDOW, 32, n - common, wins + common);
+    else
+        xcb_change_property(globalconf.connection, XCB_PROP_MODE_REPLACE,
+                            globalconf.screen->root,
+                            atom, XCB_ATOM_WINDOW, 32, n, wins);
+
+    window_array_grow(cache, n);
+    if(n)
+        memcpy(cache->tab, wins, n * sizeof(*wins));
+    cache->len = n;
+}
+
+/** Set the client list, if clients were managed or unmanaged since the
+ * last refresh.
+ */
+void
+ewmh_refresh_client_list(void)
+{
+    if(!need_net_client_list_update)
+        return;
+    need_net_client_list_update = false;
+
     xcb_window_t *wins = p_alloca(xcb_window_t, globalconf.clients.len);
 
     int n = 0;
     foreach(client, globalconf.clients)
         wins[n++] = (*client)->window;
 
-    xcb_change_property(globalconf.connection, XCB_PROP_MODE_REPLACE,
-                        globalconf.screen->root,
-                        _NET_CLIENT_LIST, XCB_ATOM_WINDOW, 32, n, wins);
-
-    return 0;
+    ewmh_update_window_list(&net_client_list, _NET_CLIENT_LIST, wins, n);
 }
 
 static int
@@ -274,9 +323,8 @@ ewmh_update_net_client_list_stacking(void)
     foreach(client, globalconf.stack)
         wins[n++] = (*client)->window;
 
-    xcb_change_property(globalconf.connection, XCB_PROP_MODE_REPLACE,
-			globalconf.screen->root,
-			_NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW, 32, n, wins);
+    ewmh_update_window_list(&net_client_list_stacking,
+                            _NET_CLIENT_LIST_STACKING, wins, n);
 }
 
 void
@@ -304,8 +352,11 @@ void
 ewmh_update_net_desktop_names(void)
 {
     buffer_t buf;
+    int len = 1;
 
-    buffer_inita(&buf, BUFSIZ);
+    foreach(tag, globalconf.tags)
+        len += a_strlen(tag_get_name(*tag)) + 1;
+    buffer_init_buf(&buf, arena_alloc(&globalconf.arena, len), len);
 
     foreach(tag, globalconf.tags)
     {
@@ -569,27 +620,41 @@ ewmh_update_window_type(xcb_window_t window, uint32_t type)
                         window, _NET_WM_WINDOW_TYPE, XCB_ATOM_ATOM, 32, 1, &type);
 }
 
+/** Send the requests for the EWMH hints of a new client.
+ * \param window The client window.
+ * \return The cookies to pass to ewmh_client_process_hints().
+ */
+ewmh_client_hints_cookies_t
+ewmh_client_get_hints(xcb_window_t window)
+{
+    ewmh_client_hints_cookies_t cookies;
+
+    cookies.desktop = xcb_get_property_unchecked(globalconf.connection, false, window,
+                                                 _NET_WM_DESKTOP, XCB_GET_PROPERTY_TYPE_ANY, 0, 1);
+
+    cookies.state = xcb_get_property_unchecked(globalconf.connection, false, window,
+                                               _NET_WM_STATE, XCB_ATOM_ATOM, 0, UINT32_MAX);
+
+    cookies.window_type = xcb_get_property_unchecked(globalconf.connection, false, window,
+                                                     _NET_WM_WINDOW_TYPE, XCB_ATOM_ATOM, 0, UINT32_MAX);
+
+    return cookies;
+}
+
+/** Apply the EWMH hints of a new client.
+ * \param c The client.
+ * \param cookies The cookies returned by ewmh_client_get_hints().
+ */
 void
-ewmh_client_check_hints(client_t *c)
+ewmh_client_process_hints(client_t *c, ewmh_client_hints_cookies_t cookies)
 {
     xcb_atom_t *state;
     void *data = NULL;
-    xcb_get_property_cookie_t c0, c1, c2;
     xcb_get_property_reply_t *reply;
     bool is_h_max = false;
     bool is_v_max = false;
 
-    /* Send the GetProperty requests which will be processed later */
-    c0 = xcb_get_property_unchecked(globalconf.connection, false, c->window,
-                                    _NET_WM_DESKTOP, XCB_GET_PROPERTY_TYPE_ANY, 0, 1);
-
-    c1 = xcb_get_property_unchecked(globalconf.connection, false, c->window,
-                                    _NET_WM_STATE, XCB_ATOM_ATOM, 0, UINT32_MAX);
-
-    c2 = xcb_get_property_unchecked(globalconf.connection, false, c->window,
-                                    _NET_WM_WINDOW_TYPE, XCB_ATOM_ATOM, 0, UINT32_MAX);
-
-    reply = xcb_get_property_reply(globalconf.connection, c0, NULL);
+    reply = xcb_get_property_reply(globalconf.connection, cookies.desktop, NULL);
     if(reply && reply->value_len && (data = xcb_get_property_value(reply)))
     {
         ewmh_process_desktop(c, *(uint32_t *) data);
@@ -597,7 +662,7 @@ ewmh_client_check_hints(client_t *c)
 
     p_delete(&reply);
 
-    reply = xcb_get_property_reply(globalconf.connection, c1, NULL);
+    reply = xcb_get_property_reply(globalconf.connection, cookies.state, NULL);
     if(reply && (data = xcb_get_property_value(reply)))
     {
         state = (xcb_atom_t *) data;
@@ -634,7 +699,7 @@ ewmh_client_check_hints(client_t *c)
 
     p_delete(&reply);
 
-    reply = xcb_get_property_reply(globalconf.connection, c2, NULL);
+    reply = xcb_get_property_reply(globalconf.connection, cookies.window_type, NULL);
     if(reply && (data = xcb_get_property_value(reply)))
     {
         c->has_NET_WM_WINDOW_TYPE = true;
@@ -660,17 +725,36 @@ ewmh_client_check_hints(client_t *c)
     p_delete(&reply);
 }
 
+/** Send the request for the WM strut of a client.
+ * \param window The client window.
+ * \return The cookie to pass to ewmh_process_client_strut_reply().
+ */
+xcb_get_property_cookie_t
+ewmh_get_client_strut(xcb_window_t window)
+{
+    return xcb_get_property_unchecked(globalconf.connection, false, window,
+                                      _NET_WM_STRUT_PARTIAL, XCB_ATOM_CARDINAL, 0, 12);
+}
+
 /** Process the WM strut of a client.
  * \param c The client.
  */
 void
 ewmh_process_client_strut(client_t *c)
+{
+    ewmh_process_client_strut_reply(c, ewmh_get_client_strut(c->window));
+}
+
+/** Process the WM strut of a client.
+ * \param c The client.
+ * \param strut_q The cookie returned by ewmh_get_client_strut().
+ */
+void
+ewmh_process_client_strut_reply(client_t *c, xcb_get_property_cookie_t strut_q)
 {
     void *data;
     xcb_get_property_reply_t *strut_r;
 
-    xcb_get_property_cookie_t strut_q = xcb_get_property_unchecked(globalconf.connection, false, c->window,
-                                                                   _NET_WM_STRUT_PARTIAL, XCB_ATOM_CARDINAL, 0, 12);
     strut_r = xcb_get_property_reply(globalconf.connection, strut_q, NULL);
 
     if(strut_r
@@ -705,6 +789,8 @@ ewmh_process_client_strut(client_t *c)
             c->strut.bottom_start_x = strut[10];
             c->strut.bottom_end_x = strut[11];
 
+            screen_strut_client_changed(c);
+
             lua_State *L = globalconf_get_lua_State();
             luaA_object_push(L, c);
             luaA_object_emit_signal(L, -1, "property::struts", 0);
@@ -726,15 +812,14 @@ ewmh_window_icon_get_unchecked(xcb_window_t w)
                                     _NET_WM_ICON, XCB_ATOM_CARDINAL, 0, UINT32_MAX);
 }
 
-static cairo_surface_t *
-ewmh_window_icon_from_reply_next(uint32_t **data, uint32_t *data_end)
+static bool
+ewmh_window_icon_from_reply_next(uint32_t **data, uint32_t *data_end, draw_icon_t *icon)
 {
     uint32_t width, height;
     uint64_t data_len;
-    uint32_t *icon_data;
 
     if(data_end - *data <= 2)
-        return NULL;
+        return false;
 
     width = (*data)[0];
     height = (*data)[1];
@@ -742,21 +827,24 @@ ewmh_window_icon_from_reply_next(uint32_t **data, uint32_t *data_end)
     /* Check that we have enough data, handling overflow */
     data_len = width * (uint64_t) height;
     if (width < 1 || height < 1 || data_len > (uint64_t) (data_end - *data) - 2)
-        return NULL;
+        return false;
 
-    icon_data = *data + 2;
+    icon->width = width;
+    icon->height = height;
+    icon->data = *data + 2;
+    icon->surface = NULL;
     *data += 2 + data_len;
-    return draw_surface_from_data(width, height, icon_data);
+    return true;
 }
 
-static cairo_surface_array_t
+static draw_icon_array_t
 ewmh_window_icon_from_reply(xcb_get_property_reply_t *r)
 {
     uint32_t *data, *data_end;
-    cairo_surface_array_t result;
-    cairo_surface_t *s;
+    draw_icon_array_t result;
+    draw_icon_t icon;
 
-    cairo_surface_array_init(&result);
+    draw_icon_array_init(&result);
     if(!r || r->type != XCB_ATOM_CARDINAL || r->format != 32)
         return result;
 
@@ -765,24 +853,31 @@ ewmh_window_icon_from_reply(xcb_get_property_reply_t *r)
     if(!data)
         return result;
 
-    while ((s = ewmh_window_icon_from_reply_next(&data, data_end)) != NULL) {
-        cairo_surface_array_push(&result, s);
+    while (ewmh_window_icon_from_reply_next(&data, data_end, &icon)) {
+        draw_icon_array_push(&result, icon);
     }
 
     return result;
 }
 
 /** Get NET_WM_ICON.
+ * Only the sizes of the icons are parsed. Their data points into the returned
+ * reply, which must be kept alive as long as the icons are used.
  * \param cookie The cookie.
- * \return An array of icons.
+ * \param icons The array to fill with the icons.
+ * \return The reply, or NULL if it did not contain any icon.
  */
-cairo_surface_array_t
-ewmh_window_icon_get_reply(xcb_get_property_cookie_t cookie)
+xcb_get_property_reply_t *
+ewmh_window_icon_get_reply(xcb_get_property_cookie_t cookie, draw_icon_array_t *icons)
 {
     xcb_get_property_reply_t *r = xcb_get_property_reply(globalconf.connection, cookie, NULL);
-    cairo_surface_array_t result = ewmh_window_icon_from_reply(r);
-    p_delete(&r);
-    return result;
+    *icons = ewmh_window_icon_from_reply(r);
+    if(icons->len == 0)
+    {
+        draw_icon_array_wipe(icons);
+        p_delete(&r);
+    }
+    return r;
 }
 
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -35,7 +35,10 @@
 
 #include "objects/key.h"
 #include "common/xembed.h"
+#include "common/arena.h"
 #include "common/buffer.h"
+#include "common/bitset.h"
+#include "common/xtrace.h"
 
 #define ROOT_WINDOW_EVENT_MASK \
     (const uint32_t []) { \
@@ -62,13 +65,20 @@ struct sequence_pair {
 };
 typedef struct sequence_pair sequence_pair_t;
 
+/** A ring buffer of sequence_pair_t, oldest first */
+typedef struct
+{
+    sequence_pair_t *tab;
+    /** Index of the oldest element, number of elements, allocated size */
+    int first, len, size;
+} sequence_ring_t;
+
 ARRAY_TYPE(button_t *, button)
 ARRAY_TYPE(tag_t *, tag)
 ARRAY_TYPE(screen_t *, screen)
 ARRAY_TYPE(client_t *, client)
 ARRAY_TYPE(drawin_t *, drawin)
 ARRAY_TYPE(xproperty_t, xproperty)
-DO_ARRAY(sequence_pair_t, sequence_pair, DO_NOTHING)
 DO_ARRAY(xcb_window_t, window, DO_NOTHING)
 
 /** Main configuration structure */
@@ -92,6 +102,8 @@ typedef struct
     key_array_t keys;
     /** Root window mouse bindings */
     button_array_t buttons;
+    /** Incremented whenever a key or button binding (array) changes */
+    unsigned int bindings_generation;
     /** Atom for WM_Sn */
     xcb_atom_t selection_atom;
     /** Window owning the WM_Sn selection */
@@ -110,9 +122,12 @@ typedef struct
     bool have_input_shape;
     /** Check for XKB extension */
     bool have_xkb;
+    /** Check for Composite 0.2 and Damage extensions, used for thumbnails */
+    bool have_composite;
     uint8_t event_base_shape;
     uint8_t event_base_xkb;
     uint8_t event_base_randr;
+    uint8_t event_base_damage;
     /** Clients list */
     client_array_t clients;
     /** Embedded windows */
@@ -125,6 +140,8 @@ typedef struct
     } L;
     /** All errors messages from loading config files */
     buffer_t startup_errors;
+    /** Temporary memory, released after each refresh */
+    arena_t arena;
     /** main loop that awesome is running on */
     GMainLoop *loop;
     /** The key grabber function */
@@ -161,6 +178,10 @@ typedef struct
         drawin_t *parent;
         /** Background color */
         uint32_t background_pixel;
+        /** Geometry last given to the systray window */
+        int x, y, width, height;
+        /** Is the systray window mapped? */
+        bool mapped;
     } systray;
     /** The monitor of startup notifications */
     SnMonitorContext *snmonitor;
@@ -176,10 +197,10 @@ typedef struct
     uint8_t default_depth;
     /** Our default color map */
     xcb_colormap_t default_cmap;
-    /** Do we have to reban clients? */
-    bool need_lazy_banning;
     /** Tag list */
     tag_array_t tags;
+    /** Indexes of the activated tags which are selected */
+    bitset_t selected_tags;
     /** List of registered xproperties */
     xproperty_array_t xproperties;
     /* xkb context */
@@ -194,11 +215,36 @@ typedef struct
     bool xkb_group_changed;
     /** The preferred size of client icons for this screen */
     uint32_t preferred_icon_size;
+    /** Merge redundant events before handling them? */
+    bool event_coalescing;
+    /** Did Lua ask for another main loop iteration without sleeping? */
+    bool refresh_requested;
+    /** Last known pointer position on the root window, see mouse.c */
+    struct
+    {
+        bool valid;
+        int16_t x, y;
+        uint16_t mask;
+    } pointer;
+    /** Always ask the X server for the pointer position? */
+    bool pointer_strict;
+    /** Size of the Lua garbage collection step run after each refresh, in
+     * KiB, or 0 to leave the collector alone */
+    int gc_step;
     /** Cached wallpaper information */
     cairo_surface_t *wallpaper;
+    /** The pixmap and size of the cached wallpaper */
+    xcb_pixmap_t wallpaper_pixmap;
+    uint16_t wallpaper_width, wallpaper_height;
+    /** Was the pixmap of the wallpaper created by this awesome instance? */
+    bool wallpaper_owned;
+    /** Incremented whenever the wallpaper changes */
+    unsigned int wallpaper_generation;
     /** List of enter/leave events to ignore */
-    sequence_pair_array_t ignore_enter_leave_events;
+    sequence_ring_t ignore_enter_leave_events;
     xcb_void_cookie_t pending_enter_leave_begin;
+    /** Grab the server while enter/leave events are ignored */
+    bool enter_leave_grab;
     /** List of windows to be destroyed later */
     window_array_t destroy_later_windows;
     /** Pending event that still needs to be handled */
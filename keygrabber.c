@@ -32,6 +32,26 @@
 #include "keygrabber.h"
 #include "globalconf.h"
 
+/** The events a running keygrabber is interested in.
+ * Filtering is done before anything is pushed to Lua, so that e.g. the
+ * release events and key repeats a prompt ignores do not cost a callback.
+ */
+static struct
+{
+    /** Do not report modifier keys like Shift_L or ISO_Level3_Shift */
+    bool ignore_modifiers;
+    /** Do not report key releases */
+    bool ignore_release;
+    /** Do not report the presses generated by auto-repeat */
+    bool ignore_repeat;
+    /** Only report these keys, if any */
+    string_array_t keys;
+    /** Always report these keys, whatever the other settings are */
+    string_array_t stop_keys;
+    /** The keycodes currently held down, to detect auto-repeat */
+    uint8_t pressed[32];
+} keygrabber_filter;
+
 /** Grab the keyboard.
  * \return True if keyboard was grabbed.
  */
@@ -71,16 +91,75 @@ is_control(char *buf)
     return (buf[0] >= 0 && buf[0] < 0x20) || buf[0] == 0x7f;
 }
 
+/** Check if a keysym belongs to a modifier key.
+ * \param keysym The keysym, ignoring all modifiers.
+ * \return True for Shift, Control, Lock, Alt, Super and the XKB level and
+ * group keys.
+ */
+static bool
+is_modifier(xcb_keysym_t keysym)
+{
+    return (keysym >= XKB_KEY_Shift_L && keysym <= XKB_KEY_Hyper_R)
+        || (keysym >= XKB_KEY_ISO_Lock && keysym <= XKB_KEY_ISO_Level5_Lock)
+        || keysym == XKB_KEY_Mode_switch || keysym == XKB_KEY_Num_Lock;
+}
+
+static bool
+keygrabber_filter_has(string_array_t *keys, const char *key)
+{
+    foreach(k, *keys)
+        if(A_STREQ(*k, key))
+            return true;
+    return false;
+}
+
+/** Check an event against the keygrabber filter and update the state of the
+ * pressed keys.
+ * \param e The event.
+ * \param keysym The keysym of the event, ignoring all modifiers.
+ * \param key The key name which would be reported.
+ * \return True if the event must be passed to the keygrabber.
+ */
+static bool
+keygrabber_filter_check(xcb_key_press_event_t *e, xcb_keysym_t keysym, const char *key)
+{
+    uint8_t bit = 1 << (e->detail % 8);
+    uint8_t *pressed = &keygrabber_filter.pressed[e->detail / 8];
+    bool is_press = e->response_type == XCB_KEY_PRESS;
+    bool is_repeat = is_press && (*pressed & bit);
+
+    if(is_press)
+        *pressed |= bit;
+    else
+        *pressed &= ~bit;
+
+    if(keygrabber_filter_has(&keygrabber_filter.stop_keys, key))
+        return true;
+    if(keygrabber_filter.ignore_release && !is_press)
+        return false;
+    if(keygrabber_filter.ignore_repeat && is_repeat)
+        return false;
+    if(keygrabber_filter.ignore_modifiers && is_modifier(keysym))
+        return false;
+    if(keygrabber_filter.keys.len && !keygrabber_filter_has(&keygrabber_filter.keys, key))
+        return false;
+    return true;
+}
+
 /** Handle keypress event.
  * \param L Lua stack to push the key pressed.
  * \param e Received XKeyEvent.
- * \return True if a key was successfully retrieved, false otherwise.
+ * \return True if a key was successfully retrieved, false if there is none or
+ * the keygrabber filter discarded it.
  */
 bool
 keygrabber_handlekpress(lua_State *L, xcb_key_press_event_t *e)
 {
     /* convert keysym to string */
     char buf[MAX(MB_LEN_MAX, 32)];
+    /* get keysym ignoring all modifiers */
+    xcb_keysym_t keysym = xcb_key_symbols_get_keysym(globalconf.keysyms,
+                                                     e->detail, 0);
 
     /* snprintf-like return value could be used here, but that should not be
      * necessary, as we have buffer big enough */
@@ -89,11 +168,12 @@ keygrabber_handlekpress(lua_State *L, xcb_key_press_event_t *e)
     if (is_control(buf))
     {
         /* Use text names for control characters, ignoring all modifiers. */
-        xcb_keysym_t keysym = xcb_key_symbols_get_keysym(globalconf.keysyms,
-                                                         e->detail, 0);
         xkb_keysym_get_name(keysym, buf, countof(buf));
     }
 
+    if(!keygrabber_filter_check(e, keysym, buf))
+        return false;
+
     luaA_pushmodifiers(L, e->state);
     lua_pushstring(L, buf);
 
@@ -109,11 +189,76 @@ keygrabber_handlekpress(lua_State *L, xcb_key_press_event_t *e)
     return true;
 }
 
+/** Read an array of key names from a filter table field.
+ * \param L The Lua VM state.
+ * \param idx The absolute index of the filter table.
+ * \param field The field name.
+ * \param keys The array to fill.
+ */
+static void
+keygrabber_filter_keys(lua_State *L, int idx, const char *field, string_array_t *keys)
+{
+    string_array_wipe(keys);
+    string_array_init(keys);
+
+    lua_getfield(L, idx, field);
+    if(lua_istable(L, -1))
+    {
+        lua_pushnil(L);
+        while(lua_next(L, -2))
+        {
+            const char *key = lua_tostring(L, -1);
+            if(key)
+                string_array_append(keys, a_strdup(key));
+            lua_pop(L, 1);
+        }
+    }
+    else if(!lua_isnil(L, -1))
+        luaL_error(L, "keygrabber filter: %s must be a table", field);
+    lua_pop(L, 1);
+}
+
+/** Replace the keygrabber filter with the one described by a table.
+ * \param L The Lua VM state.
+ * \param idx The index of the table, or of nil for no filter.
+ */
+static void
+keygrabber_filter_set(lua_State *L, int idx)
+{
+    idx = luaA_absindex(L, idx);
+    if(lua_isnoneornil(L, idx))
+    {
+        keygrabber_filter.ignore_modifiers = false;
+        keygrabber_filter.ignore_release = false;
+        keygrabber_filter.ignore_repeat = false;
+        string_array_wipe(&keygrabber_filter.keys);
+        string_array_init(&keygrabber_filter.keys);
+        string_array_wipe(&keygrabber_filter.stop_keys);
+        string_array_init(&keygrabber_filter.stop_keys);
+        return;
+    }
+
+    luaA_checktable(L, idx);
+    lua_getfield(L, idx, "ignore_modifiers");
+    keygrabber_filter.ignore_modifiers = lua_toboolean(L, -1);
+    lua_getfield(L, idx, "ignore_release");
+    keygrabber_filter.ignore_release = lua_toboolean(L, -1);
+    lua_getfield(L, idx, "ignore_repeat");
+    keygrabber_filter.ignore_repeat = lua_toboolean(L, -1);
+    lua_pop(L, 3);
+    keygrabber_filter_keys(L, idx, "keys", &keygrabber_filter.keys);
+    keygrabber_filter_keys(L, idx, "stop_keys", &keygrabber_filter.stop_keys);
+}
+
 /* Grab keyboard input and read pressed keys, calling a callback function at
  * each keypress, until `keygrabber.stop` is called.
  * The callback function receives three arguments:
  *
+ * The optional filter table restricts the events passed to the callback, see
+ * `keygrabber.filter`.
+ *
  * @param callback A callback function as described above.
+ * @tparam[opt] table filter The events to report.
  * @deprecated keygrabber.run
  */
 static int
@@ -122,6 +267,9 @@ luaA_keygrabber_run(lua_State *L)
     if(globalconf.keygrabber != LUA_REFNIL)
         luaL_error(L, "keygrabber already running");
 
+    keygrabber_filter_set(L, 2);
+    p_clear(keygrabber_filter.pressed, countof(keygrabber_filter.pressed));
+    lua_settop(L, 1);
     luaA_registerfct(L, 1, &globalconf.keygrabber);
 
     if(!keygrabber_grab())
@@ -141,6 +289,34 @@ luaA_keygrabber_stop(lua_State *L)
 {
     xcb_ungrab_keyboard(globalconf.connection, XCB_CURRENT_TIME);
     luaA_unregister(L, &globalconf.keygrabber);
+    lua_pushnil(L);
+    keygrabber_filter_set(L, -1);
+    lua_pop(L, 1);
+    return 0;
+}
+
+/** Restrict the events passed to the running keygrabber.
+ *
+ * The events are filtered before calling Lua, so that a keygrabber which
+ * ignores most events does not slow down under key repeat. The filter table
+ * can have the following fields:
+ *
+ * * `ignore_modifiers`: do not report modifier keys like `Shift_L`.
+ * * `ignore_release`: do not report key releases.
+ * * `ignore_repeat`: do not report key presses generated by auto-repeat.
+ * * `keys`: an array of key names; only these keys are reported.
+ * * `stop_keys`: an array of key names which are always reported, for
+ *   example the keys the keygrabber stops on.
+ *
+ * The filter is removed when the keygrabber stops.
+ *
+ * @tparam[opt] table filter The filter, or nil to report all events.
+ * @function keygrabber.filter
+ */
+static int
+luaA_keygrabber_filter(lua_State *L)
+{
+    keygrabber_filter_set(L, 1);
     return 0;
 }
 
@@ -160,6 +336,7 @@ const struct luaL_Reg awesome_keygrabber_lib[] =
 {
     { "run", luaA_keygrabber_run },
     { "stop", luaA_keygrabber_stop },
+    { "filter", luaA_keygrabber_filter },
     { "isrunning", luaA_keygrabber_isrunning },
     { "__index", luaA_default_index },
     { "__newindex", luaA_default_newindex },
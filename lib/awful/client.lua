@@ -116,12 +116,9 @@ end
 -- @tparam[opt=false] boolean stacked Use stacking order? (top to bottom)
 -- @treturn table A table with all visible clients.
 function client.visible(s, stacked)
-    local cls = capi.client.get(s, stacked)
     local vcls = {}
-    for _, c in pairs(cls) do
-        if c:isvisible() then
-            table.insert(vcls, c)
-        end
+    for c in capi.client.iterate({ visible = true }, s, stacked) do
+        table.insert(vcls, c)
     end
     return vcls
 end
@@ -134,12 +131,10 @@ end
 -- @tparam[opt=false] boolean stacked Use stacking order? (top to bottom)
 -- @treturn table A table with all visible and tiled clients.
 function client.tiled(s, stacked)
-    local clients = client.visible(s, stacked)
     local tclients = {}
     -- Remove floating clients
-    for _, c in pairs(clients) do
-        if not client.object.get_floating(c)
-            and not c.fullscreen
+    for c in capi.client.iterate({ visible = true, floating = false }, s, stacked) do
+        if not c.fullscreen
             and not c.maximized
             and not c.maximized_vertical
             and not c.maximized_horizontal then
@@ -36,22 +36,55 @@ do
     })
 end
 
-local focus = {history = {list = {}}}
+local focus = {history = {}}
 
 local function get_screen(s)
     return s and capi.screen[s]
 end
 
+-- The focus history is a doubly linked list of nodes, the most recently
+-- focused client first. The node of a client is found through `nodes`, so
+-- that adding and removing clients does not need to search the list.
+local nodes = setmetatable({}, { __mode = "k" })
+local head = nil
+
+local function unlink(node)
+    if node.prev then
+        node.prev.next = node.next
+    else
+        head = node.next
+    end
+    if node.next then
+        node.next.prev = node.prev
+    end
+    node.prev, node.next = nil, nil
+end
+
+-- `focus.history.list` used to be the history itself. It is now built when
+-- it is accessed, so changing it has no effect.
+setmetatable(focus.history, {
+    __index = function(_, key)
+        if key == "list" then
+            local list = {}
+            local node = head
+            while node do
+                table.insert(list, node.client)
+                node = node.next
+            end
+            return list
+        end
+    end
+})
+
 --- Remove a client from the focus history
 --
 -- @client c The client that must be removed.
 -- @function awful.client.focus.history.delete
 function focus.history.delete(c)
-    for k, v in ipairs(focus.history.list) do
-        if v == c then
-            table.remove(focus.history.list, k)
-            break
-        end
+    local node = nodes[c]
+    if node then
+        unlink(node)
+        nodes[c] = nil
     end
 end
 
@@ -90,10 +123,23 @@ end
 -- @client c The client that has been focused.
 -- @function awful.client.focus.history.add
 function focus.history.add(c)
+    local node = nodes[c]
+    if node and node == head then
+        return
+    end
     -- Remove the client if its in stack
-    focus.history.delete(c)
+    if node then
+        unlink(node)
+    else
+        node = { client = c }
+        nodes[c] = node
+    end
     -- Record the client has latest focused
-    table.insert(focus.history.list, 1, c)
+    node.next = head
+    if head then
+        head.prev = node
+    end
+    head = node
 end
 
 --- Get the latest focused client for a screen in history.
@@ -110,28 +156,27 @@ function focus.history.get(s, idx, filter)
     s = get_screen(s)
     -- When this counter is equal to idx, we return the client
     local counter = 0
-    local vc = client.visible(s, true)
-    for _, c in ipairs(focus.history.list) do
+    -- Walk the history from the most recent client, so that the usual
+    -- queries for one of the last clients stop early
+    local node = head
+    while node do
+        local c = node.client
         if get_screen(c.screen) == s then
-            if not filter or filter(c) then
-                for _, vcc in ipairs(vc) do
-                    if vcc == c then
-                        if counter == idx then
-                            return c
-                        end
-                        -- We found one, increment the counter only.
-                        counter = counter + 1
-                        break
-                    end
+            if (not filter or filter(c)) and c:isvisible() then
+                if counter == idx then
+                    return c
                 end
+                -- We found one, increment the counter only.
+                counter = counter + 1
             end
         end
+        node = node.next
     end
     -- Argh nobody found in history, give the first one visible if there is one
     -- that passes the filter.
     filter = filter or focus.filter
     if counter == 0 then
-        for _, v in ipairs(vc) do
+        for v in capi.client.iterate({ visible = true }, s, true) do
             if filter(v) then
                 return v
             end
@@ -17,13 +17,16 @@ local capi =
 local shape = {}
 shape.update = {}
 
---- Get one of a client's shapes and transform it to include window decorations.
--- @function awful.client.shape.get_transformed
--- @client c The client whose shape should be retrieved
--- @tparam string shape_name Either "bounding" or "clip"
-function shape.get_transformed(c, shape_name)
+-- Shapes of clients which did not set a shape themselves only depend on the
+-- shape function and the sizes, so they are computed once for all clients.
+-- Shape function -> { count = number, [key] = surface }
+local shape_cache = setmetatable({}, { __mode = "k" })
+
+-- Maximum number of sizes that are kept per shape function
+local shape_cache_size = 32
+
+local function transform(c, shape_name, shape_img)
     local border = shape_name == "bounding" and c.border_width or 0
-    local shape_img = surface.load_silently(c["client_shape_" .. shape_name], false)
     local _shape = c._shape
     if not (shape_img or _shape) then return end
 
@@ -89,6 +92,39 @@ function shape.get_transformed(c, shape_name)
     return result
 end
 
+--- Get one of a client's shapes and transform it to include window decorations.
+-- @function awful.client.shape.get_transformed
+-- @client c The client whose shape should be retrieved
+-- @tparam string shape_name Either "bounding" or "clip"
+function shape.get_transformed(c, shape_name)
+    return transform(c, shape_name, surface.load_silently(c["client_shape_" .. shape_name], false))
+end
+
+-- Get a client's shape, possibly from the cache. The second return value is
+-- true if the result is shared and must not be finished.
+local function get_shape(c, shape_name)
+    local shape_img = surface.load_silently(c["client_shape_" .. shape_name], false)
+    local _shape = c._shape
+    if shape_img or not _shape then
+        return transform(c, shape_name, shape_img), false
+    end
+
+    local geom = c:geometry()
+    local key = shape_name .. ":" .. geom.width .. "x" .. geom.height .. ":" .. c.border_width
+    local entries = shape_cache[_shape]
+    if not entries or entries.count >= shape_cache_size then
+        entries = { count = 0 }
+        shape_cache[_shape] = entries
+    end
+    local result = entries[key]
+    if not result then
+        result = transform(c, shape_name, nil)
+        entries[key] = result
+        entries.count = entries.count + 1
+    end
+    return result, true
+end
+
 --- Update all of a client's shapes from the shapes the client set itself.
 -- @function awful.client.shape.update.all
 -- @client c The client to act on
@@ -101,10 +137,10 @@ end
 -- @function awful.client.shape.update.bounding
 -- @client c The client to act on
 function shape.update.bounding(c)
-    local res = shape.get_transformed(c, "bounding")
+    local res, shared = get_shape(c, "bounding")
     c.shape_bounding = res and res._native
     -- Free memory
-    if res then
+    if res and not shared then
         res:finish()
     end
 end
@@ -113,10 +149,10 @@ end
 -- @function awful.client.shape.update.clip
 -- @client c The client to act on
 function shape.update.clip(c)
-    local res = shape.get_transformed(c, "clip")
+    local res, shared = get_shape(c, "clip")
     c.shape_clip = res and res._native
     -- Free memory
-    if res then
+    if res and not shared then
         res:finish()
     end
 end
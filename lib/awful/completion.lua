@@ -10,6 +10,7 @@
 ---------------------------------------------------------------------------
 
 local gfs = require("gears.filesystem")
+local Gio = require("lgi").Gio
 
 -- Grab environment we need
 local io = io
@@ -19,6 +20,7 @@ local math = math
 local print = print
 local pairs = pairs
 local string = string
+local ipairs = ipairs
 
 local gears_debug = require("gears.debug")
 local gstring = require("gears.string")
@@ -61,6 +63,107 @@ end
 
 completion.default_shell = nil
 
+-- Names of aliases, builtins, functions and reserved words, by shell
+local shell_names = {}
+
+-- Directory of $PATH -> { mtime = number, names = list of executables }
+local path_listings = {}
+
+--- Get the command names a shell knows besides the executables in $PATH.
+-- These do not change, so the shell is only asked once.
+-- @tparam string shell "bash" or "zsh".
+-- @treturn table The list of names.
+local function get_shell_names(shell)
+    if not shell_names[shell] then
+        local shell_cmd
+        if shell == 'zsh' then
+            shell_cmd = "/usr/bin/env zsh -c 'print -ln -- "..
+            "\"${(k)aliases[@]}\" \"${(k)builtins[@]}\" \"${(k)functions[@]}\" "..
+            "\"${(k)reswords[@]}\"'"
+        else
+            shell_cmd = "/usr/bin/env bash -c 'compgen -A alias -A builtin -A function -A keyword'"
+        end
+        local names = {}
+        local c, err = io.popen(shell_cmd)
+        if c then
+            for line in c:lines() do
+                if line ~= "" then
+                    table.insert(names, line)
+                end
+            end
+            c:close()
+        else
+            print(err)
+        end
+        shell_names[shell] = names
+    end
+    return shell_names[shell]
+end
+
+--- Get the executables in a directory.
+-- The directory is only read again when its modification time changed.
+-- @tparam string dir The directory.
+-- @treturn table The list of names.
+local function get_executables(dir)
+    local gfile = Gio.File.new_for_path(dir)
+    local info = gfile:query_info("time::modified,time::modified-usec",
+                                  Gio.FileQueryInfoFlags.NONE)
+    if not info then
+        return {}
+    end
+    local mtime = info:get_attribute_uint64("time::modified") * 1000000
+        + info:get_attribute_uint32("time::modified-usec")
+
+    local listing = path_listings[dir]
+    if listing and listing.mtime == mtime then
+        return listing.names
+    end
+
+    listing = { mtime = mtime, names = {} }
+    local enum = gfile:enumerate_children(
+        "standard::name,standard::type,access::can-execute", Gio.FileQueryInfoFlags.NONE)
+    if enum then
+        local child = enum:next_file()
+        while child do
+            if child:get_file_type() ~= "DIRECTORY"
+                    and child:get_attribute_boolean("access::can-execute") then
+                table.insert(listing.names, child:get_name())
+            end
+            child = enum:next_file()
+        end
+        enum:close()
+    end
+    path_listings[dir] = listing
+    return listing.names
+end
+
+--- Complete a command name without running a shell.
+-- This gives the same names as the command completion of the shell.
+-- @tparam string word The beginning of the command name.
+-- @tparam string shell "bash" or "zsh".
+-- @treturn table The sorted list of matches.
+local function complete_command_name(word, shell)
+    local seen, output = {}, {}
+    local function add(name)
+        if not seen[name] and name:sub(1, #word) == word then
+            seen[name] = true
+            table.insert(output, name)
+        end
+    end
+
+    for _, name in ipairs(get_shell_names(shell)) do
+        add(name)
+    end
+    for dir in (os.getenv("PATH") or ""):gmatch("[^:]+") do
+        for _, name in ipairs(get_executables(dir)) do
+            add(name)
+        end
+    end
+
+    table.sort(output)
+    return output
+end
+
 --- Use shell completion system to complete commands and filenames.
 -- @tparam string command The command line.
 -- @tparam number cur_pos The cursor position.
@@ -104,7 +207,7 @@ function completion.shell(command, cur_pos, ncomp, shell)
         comptype = "command"
     end
 
-    local shell_cmd
+    local shell_cmd, output
     if not shell then
         if not completion.default_shell then
             local env_shell = os.getenv('SHELL')
@@ -119,7 +222,15 @@ function completion.shell(command, cur_pos, ncomp, shell)
         end
         shell = completion.default_shell
     end
-    if shell == 'zsh' then
+    if comptype == "command" and not words[cword_index]:find("/", 1, true)
+            and (shell == 'zsh' or not bashcomp_funcs[words[1]]) then
+        -- Command names only depend on $PATH, they are completed from the
+        -- cached directory listings
+        output = {}
+        for _, name in ipairs(complete_command_name(words[cword_index], shell)) do
+            table.insert(output, bash_escape(name))
+        end
+    elseif shell == 'zsh' then
         if comptype == "file" then
             -- NOTE: ${~:-"..."} turns on GLOB_SUBST, useful for expansion of
             -- "~/" ($HOME).  ${:-"foo"} is the string "foo" as var.
@@ -151,8 +262,11 @@ function completion.shell(command, cur_pos, ncomp, shell)
                 .. string.format('%q', words[cword_index]) .. "'"
         end
     end
-    local c, err = io.popen(shell_cmd .. " | sort -u")
-    local output = {}
+    local c, err
+    if not output then
+        output = {}
+        c, err = io.popen(shell_cmd .. " | sort -u")
+    end
     if c then
         while true do
             local line = c:read("*line")
@@ -164,7 +278,7 @@ function completion.shell(command, cur_pos, ncomp, shell)
         end
 
         c:close()
-    else
+    elseif err then
         print(err)
     end
 
@@ -0,0 +1,67 @@
+---------------------------------------------------------------------------
+--- Run Lua code from other programs through a Unix domain socket.
+--
+-- This is a faster alternative to `awful.remote` and `awesome-client` for
+-- programs which run many small queries. Loading this module makes awesome
+-- listen on `awful.control.path`:
+--
+--    require("awful.control")
+--
+-- Every request is a 32 bit big-endian length followed by that many bytes of
+-- Lua code. The code can be followed by a NUL byte and NUL separated
+-- arguments, which it gets as strings in `...`. Compiled code is cached, so
+-- that queries should pass what changes as arguments instead of putting it
+-- into the code.
+--
+-- Every reply is a 32 bit big-endian length followed by a JSON object,
+-- `{"ok":true,"result":[...]}` with the values returned by the code, or
+-- `{"ok":false,"error":"..."}`. Objects like clients are sent as the result of
+-- `tostring`.
+--
+-- Requests can be sent without waiting for the previous replies; the replies
+-- come in the same order. For example in Python:
+--
+--    import json, socket, struct
+--
+--    def frame(code, *args):
+--        data = "\0".join((code,) + args).encode()
+--        return struct.pack(">I", len(data)) + data
+--
+--    s = socket.socket(socket.AF_UNIX)
+--    s.connect(path)
+--    s.sendall(frame("return #client.get()")
+--              + frame("return client.focus and client.focus.name"))
+--    f = s.makefile("rb")
+--    for _ in range(2):
+--        length, = struct.unpack(">I", f.read(4))
+--        print(json.loads(f.read(length)))
+--
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+-- @module awful.control
+---------------------------------------------------------------------------
+
+local capi = { awesome = awesome }
+local os = os
+local glib = require("lgi").GLib
+local gdebug = require("gears.debug")
+
+local control = {}
+
+local display = (os.getenv("DISPLAY") or ""):gsub("[^%w.:_-]", "_")
+
+--- The path of the control socket.
+--
+-- It is `awesome-$DISPLAY.sock` in the user's runtime directory, usually
+-- `$XDG_RUNTIME_DIR`. Use `awesome.control_listen` to listen on another path.
+-- @tfield string awful.control.path
+control.path = glib.get_user_runtime_dir() .. "/awesome-" .. display .. ".sock"
+
+local ok, err = capi.awesome.control_listen(control.path)
+if not ok then
+    gdebug.print_warning("awful.control: cannot listen: " .. err)
+end
+
+return control
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
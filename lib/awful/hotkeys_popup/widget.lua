@@ -7,11 +7,14 @@
 ---------------------------------------------------------------------------
 
 local capi = {
+    awesome = awesome,
     screen = screen,
     client = client,
 }
 local awful = require("awful")
+local GLib = require("lgi").GLib
 local gtable = require("gears.table")
+local protected_call = require("gears.protected_call")
 local gstring = require("gears.string")
 local wibox = require("wibox")
 local beautiful = require("beautiful")
@@ -179,6 +182,9 @@ function widget.new(args)
         _additional_hotkeys = {},
         _cached_wiboxes = {},
         _cached_awful_keys = nil,
+        _awful_keys_count = 0,
+        _group_items = {},
+        _label_widths = {},
         _colors_counter = {},
         _group_list = {},
         _widget_settings_loaded = false,
@@ -279,9 +285,16 @@ function widget.new(args)
 
 
     function widget_instance:_import_awful_keys()
-        if self._cached_awful_keys then
+        if self._cached_awful_keys and self._awful_keys_count == #awful.key.hotkeys then
             return
         end
+        if self._cached_awful_keys then
+            -- New keys were created since the last import
+            for group in pairs(self._cached_awful_keys) do
+                self:_invalidate_group(group)
+            end
+        end
+        self._awful_keys_count = #awful.key.hotkeys
         self._cached_awful_keys = {}
         for _, data in pairs(awful.key.hotkeys) do
             self:_add_hotkey(data.key, data, self._cached_awful_keys)
@@ -290,6 +303,105 @@ function widget.new(args)
     end
 
 
+    -- Forget everything rendered for a group.
+    function widget_instance:_invalidate_group(group)
+        self._group_items[group] = nil
+        for _, wiboxes in pairs(self._cached_wiboxes) do
+            for joined_groups, help_wibox in pairs(wiboxes) do
+                if help_wibox.groups[group] then
+                    wiboxes[joined_groups] = nil
+                end
+            end
+        end
+    end
+
+
+    -- Get the markup of a hotkey and its length in characters.
+    function widget_instance:_render_hotkey(key)
+        local length = string.len(key.key or '') + string.len(key.description or '')
+        local modifiers = key.mod
+        if not modifiers or modifiers == "none" then
+            modifiers = ""
+        else
+            length = length + string.len(modifiers) + 1 -- +1 for "+" character
+            modifiers = markup.fg(self.modifiers_fg, modifiers.."+")
+        end
+        local rendered_hotkey = markup.font(self.font,
+            modifiers .. (key.key or "") .. " "
+        ) .. markup.font(self.description_font,
+            key.description or ""
+        )
+        return { key = key, label = rendered_hotkey, length = length }
+    end
+
+
+    -- Get the rendered hotkeys of a group. They are kept until the keys of
+    -- the group change.
+    function widget_instance:_get_group_items(group)
+        local items = self._group_items[group]
+        if items then
+            return items
+        end
+
+        local keys = gtable.join(self._cached_awful_keys[group], self._additional_hotkeys[group])
+        local descriptions = {}
+        items = {}
+        for i, key in ipairs(keys) do
+            items[i] = self:_render_hotkey(key)
+            descriptions[i] = key.description
+        end
+        items.line_count = gstring.linecount(table.concat(descriptions, "\n"))
+        self._group_items[group] = items
+        return items
+    end
+
+
+    -- Get the widths of rendered hotkeys on a screen. The widths are kept
+    -- for each DPI.
+    function widget_instance:_get_label_widths(labels, s)
+        local dpi = get_screen(s).dpi
+        local widths = self._label_widths[dpi]
+        if not widths then
+            widths = {}
+            self._label_widths[dpi] = widths
+        end
+
+        local missing, seen = {}, {}
+        for _, label in ipairs(labels) do
+            if not widths[label] and not seen[label] then
+                seen[label] = true
+                table.insert(missing, label)
+            end
+        end
+        if #missing > 0 then
+            local sizes = wibox.widget.textbox.get_preferred_sizes(missing, s)
+            for i, label in ipairs(missing) do
+                widths[label] = sizes[i].width
+            end
+        end
+        return widths
+    end
+
+
+    -- Render and measure the hotkeys of all groups, so that the first
+    -- show_help() does not have to.
+    function widget_instance:_prerender()
+        local s = awful.screen.focused()
+        if not s then return end
+
+        self:_import_awful_keys()
+        self:_load_widget_settings()
+
+        local labels = {}
+        for group, _ in pairs(self._group_list) do
+            for _, item in ipairs(self:_get_group_items(group)) do
+                table.insert(labels, item.label)
+            end
+        end
+        self:_get_label_widths(labels, s)
+    end
+
+
     function widget_instance:_group_label(group, color)
         local textbox = wibox.widget.textbox(
             markup.font(self.font,
@@ -323,13 +435,9 @@ function widget.new(args)
         local max_height_px = height - group_label_height
         local column_layouts = {}
         for _, group in ipairs(available_groups) do
-            local keys = gtable.join(self._cached_awful_keys[group], self._additional_hotkeys[group])
-            local joined_descriptions = ""
-            for i, key in ipairs(keys) do
-                joined_descriptions = joined_descriptions .. key.description .. (i~=#keys and "\n" or "")
-            end
+            local keys = self:_get_group_items(group)
             -- +1 for group label:
-            local items_height = gstring.linecount(joined_descriptions) * line_height + group_label_height
+            local items_height = keys.line_count * line_height + group_label_height
             local current_column
             local available_height_px = max_height_px
             local add_new_column = true
@@ -353,7 +461,7 @@ function widget.new(args)
                     table.insert(((i<available_height_items) and new_keys or overlap_leftovers), keys[i])
                 end
                 keys = new_keys
-                table.insert(keys, {key=markup.fg(self.modifiers_fg, "▽"), description=""})
+                table.insert(keys, self:_render_hotkey({key=markup.fg(self.modifiers_fg, "▽"), description=""}))
             end
             if not current_column then
                 current_column = {layout=wibox.layout.fixed.vertical()}
@@ -363,29 +471,17 @@ function widget.new(args)
             local function insert_keys(_keys, _add_new_column)
                 local max_label_width = 0
                 local max_label_content = ""
-                local joined_labels = ""
-                for i, key in ipairs(_keys) do
-                    local length = string.len(key.key or '') + string.len(key.description or '')
-                    local modifiers = key.mod
-                    if not modifiers or modifiers == "none" then
-                        modifiers = ""
-                    else
-                        length = length + string.len(modifiers) + 1 -- +1 for "+" character
-                        modifiers = markup.fg(self.modifiers_fg, modifiers.."+")
-                    end
-                    local rendered_hotkey = markup.font(self.font,
-                        modifiers .. (key.key or "") .. " "
-                    ) .. markup.font(self.description_font,
-                        key.description or ""
-                    )
-                    if length > max_label_width then
-                        max_label_width = length
-                        max_label_content = rendered_hotkey
-                    end
-                    joined_labels = joined_labels .. rendered_hotkey .. (i~=#_keys and "\n" or "")
+                local labels = {}
+                for i, item in ipairs(_keys) do
+                    if item.length > max_label_width then
+                        max_label_width = item.length
+                        max_label_content = item.label
                     end
+                    labels[i] = item.label
+                end
+                local joined_labels = table.concat(labels, "\n")
                 current_column.layout:add(wibox.widget.textbox(joined_labels))
-                local max_width, _ = wibox.widget.textbox(max_label_content):get_preferred_size(s)
+                local max_width = self:_get_label_widths({ max_label_content }, s)[max_label_content]
                 max_width = max_width + self.group_margin
                 if not current_column.max_width or max_width > current_column.max_width then
                     current_column.max_width = max_width
@@ -454,6 +550,10 @@ function widget.new(args)
         ))
 
         local widget_obj = {}
+        widget_obj.groups = {}
+        for _, group in ipairs(available_groups) do
+            widget_obj.groups[group] = true
+        end
         widget_obj.current_page = 1
         widget_obj.wibox = mywibox
         function widget_obj.page_next(_self)
@@ -508,7 +608,8 @@ function widget.new(args)
             if not need_match then table.insert(available_groups, group) end
         end
 
-        local joined_groups = join_plus_sort(available_groups)
+        -- The rendered sizes depend on the DPI of the screen
+        local joined_groups = join_plus_sort(available_groups) .. "@" .. tostring(get_screen(s).dpi)
         if not self._cached_wiboxes[s] then
             self._cached_wiboxes[s] = {}
         end
@@ -530,7 +631,7 @@ function widget.new(args)
                     help_wibox:hide()
                 end
             end
-        end)
+        end, { ignore_release = true })
     end
 
     --- Add hotkey descriptions for third-party applications.
@@ -538,6 +639,7 @@ function widget.new(args)
     -- see `awful.hotkeys_popup.key.vim` as an example.
     function widget_instance:add_hotkeys(hotkeys)
         for group, bindings in pairs(hotkeys) do
+            self:_invalidate_group(group)
             for _, binding in ipairs(bindings) do
                 local modifiers = binding.modifiers
                 local keys = binding.keys
@@ -560,8 +662,17 @@ function widget.new(args)
     -- see `awful.hotkeys_popup.key.vim` as an example.
     function widget_instance:add_group_rules(group, data)
         self.group_rules[group] = data
+        self:_invalidate_group(group)
     end
 
+    -- Render the hotkeys once awesome is idle after startup
+    capi.awesome.connect_signal("startup", function()
+        GLib.idle_add(GLib.PRIORITY_LOW, function()
+            protected_call(widget_instance._prerender, widget_instance)
+            return false
+        end)
+    end)
+
     return widget_instance
 end
 
@@ -35,31 +35,36 @@ util.pread = function()
     return ""
 end
 
-return
+local lazy_require = require("gears.lazy_require")
+
+-- Modules connecting signal handlers when they are loaded are loaded right
+-- away, everything else only once it is used.
+return lazy_require(
 {
     client = require("awful.client");
-    completion = require("awful.completion");
     layout = require("awful.layout");
-    placement = require("awful.placement");
-    prompt = require("awful.prompt");
-    screen = require("awful.screen");
     tag = require("awful.tag");
-    util = require("awful.util");
-    widget = require("awful.widget");
-    keygrabber = require("awful.keygrabber");
-    menu = require("awful.menu");
+    util = util;
     mouse = require("awful.mouse");
     remote = require("awful.remote");
-    key = require("awful.key");
-    button = require("awful.button");
-    wibar = require("awful.wibar");
-    wibox = require("awful.wibox");
     startup_notification = require("awful.startup_notification");
-    tooltip = require("awful.tooltip");
     ewmh = require("awful.ewmh");
-    titlebar = require("awful.titlebar");
     rules = require("awful.rules");
     spawn = spawn;
-}
+}, {
+    completion = "awful.completion";
+    placement = "awful.placement";
+    prompt = "awful.prompt";
+    screen = "awful.screen";
+    widget = "awful.widget";
+    keygrabber = "awful.keygrabber";
+    menu = "awful.menu";
+    key = "awful.key";
+    button = "awful.button";
+    wibar = "awful.wibar";
+    wibox = "awful.wibox";
+    tooltip = "awful.tooltip";
+    titlebar = "awful.titlebar";
+})
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
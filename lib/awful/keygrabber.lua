@@ -78,6 +78,7 @@ local keygrab = {}
 
 -- Private data
 local grabbers = {}
+local filters = setmetatable({}, { __mode = "k" })
 local keygrabbing = false
 
 local keygrabber = {
@@ -158,6 +159,14 @@ end
 
 --END hack
 
+-- The filter of a grabber is only applied when it is alone on the stack,
+-- since the grabbers below would get the events it does not want.
+local function update_filter()
+    if keygrabbing then
+        capi.keygrabber.filter(#grabbers == 1 and filters[grabbers[1]] or nil)
+    end
+end
+
 local function grabber(mod, key, event)
     for _, keygrabber_function in ipairs(grabbers) do
         -- continue if the grabber explicitly returns false
@@ -284,6 +293,8 @@ function keygrab.stop(g)
     if #grabbers == 0 then
         keygrabbing = false
         capi.keygrabber.stop()
+    else
+        update_filter()
     end
 end
 
@@ -729,8 +740,13 @@ end
 -- A callback can return `false` to pass the events to the next
 -- keygrabber in the stack.
 --
+-- The optional `filter` avoids calling the callback for events it is not
+-- interested in, see `keygrabber.filter` for its fields. It is only a hint:
+-- while other callbacks are on the stack, all events are passed.
+--
 -- @param g The key grabber callback that will get the key events until it
 --  will be deleted or a new grabber is added.
+-- @tparam[opt] table filter The events the callback is interested in.
 -- @return the given callback `g`.
 -- @usage
 -- -- The following function can be bound to a key, and be used to resize a
@@ -750,17 +766,20 @@ end
 --   end)
 -- end
 -- @function awful.keygrabber.run
-function keygrab.run(g)
+function keygrab.run(g, filter)
     -- Remove the grabber if it is in the stack.
     keygrab.stop(g)
 
     -- Record the grabber that has been added most recently.
     table.insert(grabbers, 1, g)
+    filters[g] = filter
 
     -- Start the keygrabber if it is not running already.
     if not keygrabbing then
         keygrabbing = true
-        capi.keygrabber.run(grabber)
+        capi.keygrabber.run(grabber, filter)
+    else
+        update_filter()
     end
 
     return g
@@ -79,6 +79,9 @@ layout.layouts = {
 local arrange_lock = false
 -- Delay one arrange call per screen.
 local delayed_arrange = {}
+-- The screens to arrange, in request order, by a single delayed call.
+local pending_arrange = {}
+local arrange_queued = false
 
 --- Get the current layout.
 -- @param screen The screen.
@@ -189,43 +192,58 @@ function layout.parameters(t, screen)
     return p
 end
 
+local function arrange_screen(screen)
+    if not screen.valid then
+        -- Screen was removed
+        delayed_arrange[screen] = nil
+        return
+    end
+    if arrange_lock then return end
+    arrange_lock = true
+
+    -- protected call to ensure that arrange_lock will be reset
+    protected_call(function()
+        local p = layout.parameters(nil, screen)
+
+        local useless_gap = p.useless_gap
+
+        p.geometries = setmetatable({}, {__mode = "k"})
+        layout.get(screen).arrange(p)
+
+        -- This removes the border and the gap and skips the clients which
+        -- already have their geometry.
+        capi.client.apply_layout(p.geometries, useless_gap)
+    end)
+    arrange_lock = false
+    delayed_arrange[screen] = nil
+
+    screen:emit_signal("arrange")
+end
+
+local function arrange_pending()
+    local screens = pending_arrange
+    pending_arrange, arrange_queued = {}, false
+
+    for _, screen in ipairs(screens) do
+        arrange_screen(screen)
+    end
+end
+
 --- Arrange a screen using its current layout.
+--
+-- This is delayed until the end of the current main loop iteration, and a
+-- screen is arranged only once, however often this is called.
 -- @param screen The screen to arrange.
 function layout.arrange(screen)
     screen = get_screen(screen)
     if not screen or delayed_arrange[screen] then return end
     delayed_arrange[screen] = true
+    table.insert(pending_arrange, screen)
 
-    timer.delayed_call(function()
-        if not screen.valid then
-            -- Screen was removed
-            delayed_arrange[screen] = nil
-            return
-        end
-        if arrange_lock then return end
-        arrange_lock = true
-
-        -- protected call to ensure that arrange_lock will be reset
-        protected_call(function()
-            local p = layout.parameters(nil, screen)
-
-            local useless_gap = p.useless_gap
-
-            p.geometries = setmetatable({}, {__mode = "k"})
-            layout.get(screen).arrange(p)
-            for c, g in pairs(p.geometries) do
-                g.width = math.max(1, g.width - c.border_width * 2 - useless_gap * 2)
-                g.height = math.max(1, g.height - c.border_width * 2 - useless_gap * 2)
-                g.x = g.x + useless_gap
-                g.y = g.y + useless_gap
-                c:geometry(g)
-            end
-        end)
-        arrange_lock = false
-        delayed_arrange[screen] = nil
-
-        screen:emit_signal("arrange")
-    end)
+    if not arrange_queued then
+        arrange_queued = true
+        timer.delayed_call(arrange_pending)
+    end
 end
 
 --- Get the current layout name.
@@ -242,19 +260,26 @@ local function arrange_prop_nf(obj)
     end
 end
 
+-- Changes to a client which is not visible do not affect the layout.
+local function arrange_prop_visible(obj)
+    if obj:isvisible() then
+        arrange_prop_nf(obj)
+    end
+end
+
 local function arrange_prop(obj) layout.arrange(obj.screen) end
 
-capi.client.connect_signal("property::size_hints_honor", arrange_prop_nf)
+capi.client.connect_signal("property::size_hints_honor", arrange_prop_visible)
 capi.client.connect_signal("property::struts", arrange_prop)
 capi.client.connect_signal("property::minimized", arrange_prop_nf)
 capi.client.connect_signal("property::sticky", arrange_prop_nf)
-capi.client.connect_signal("property::fullscreen", arrange_prop_nf)
-capi.client.connect_signal("property::maximized_horizontal", arrange_prop_nf)
-capi.client.connect_signal("property::maximized_vertical", arrange_prop_nf)
-capi.client.connect_signal("property::border_width", arrange_prop_nf)
+capi.client.connect_signal("property::fullscreen", arrange_prop_visible)
+capi.client.connect_signal("property::maximized_horizontal", arrange_prop_visible)
+capi.client.connect_signal("property::maximized_vertical", arrange_prop_visible)
+capi.client.connect_signal("property::border_width", arrange_prop_visible)
 capi.client.connect_signal("property::hidden", arrange_prop_nf)
 capi.client.connect_signal("property::floating", arrange_prop)
-capi.client.connect_signal("property::geometry", arrange_prop_nf)
+capi.client.connect_signal("property::geometry", arrange_prop_visible)
 capi.client.connect_signal("property::screen", function(c, old_screen)
     if old_screen then
         layout.arrange(old_screen)
@@ -266,15 +291,22 @@ local function arrange_tag(t)
     layout.arrange(t.screen)
 end
 
-capi.tag.connect_signal("property::master_width_factor", arrange_tag)
-capi.tag.connect_signal("property::master_count", arrange_tag)
-capi.tag.connect_signal("property::column_count", arrange_tag)
-capi.tag.connect_signal("property::layout", arrange_tag)
-capi.tag.connect_signal("property::windowfact", arrange_tag)
+-- The layout parameters of a tag which is not selected are not used.
+local function arrange_selected_tag(t)
+    if t.selected then
+        layout.arrange(t.screen)
+    end
+end
+
+capi.tag.connect_signal("property::master_width_factor", arrange_selected_tag)
+capi.tag.connect_signal("property::master_count", arrange_selected_tag)
+capi.tag.connect_signal("property::column_count", arrange_selected_tag)
+capi.tag.connect_signal("property::layout", arrange_selected_tag)
+capi.tag.connect_signal("property::windowfact", arrange_selected_tag)
 capi.tag.connect_signal("property::selected", arrange_tag)
 capi.tag.connect_signal("property::activated", arrange_tag)
-capi.tag.connect_signal("property::useless_gap", arrange_tag)
-capi.tag.connect_signal("property::master_fill_policy", arrange_tag)
+capi.tag.connect_signal("property::useless_gap", arrange_selected_tag)
+capi.tag.connect_signal("property::master_fill_policy", arrange_selected_tag)
 capi.tag.connect_signal("tagged", arrange_tag)
 
 capi.screen.connect_signal("property::workarea", layout.arrange)
@@ -9,16 +9,17 @@
 ---------------------------------------------------------------------------
 
 -- Grab environment we need
-local tag = require("awful.tag")
-local client = require("awful.client")
-local ipairs = ipairs
-local math = math
 local capi =
 {
+    client = client,
     mouse = mouse,
     screen = screen,
     mousegrabber = mousegrabber
 }
+local tag = require("awful.tag")
+local client = require("awful.client")
+local ipairs = ipairs
+local math = math
 
 local tile = {}
 
@@ -158,70 +159,12 @@ local function mouse_resize_handler(c, _, _, _, orientation)
                           end, cursor)
 end
 
-local function apply_size_hints(c, width, height, useless_gap)
-    local bw = c.border_width
-    width, height = width - 2 * bw - useless_gap, height - 2 * bw - useless_gap
-    width, height = c:apply_size_hints(math.max(1, width), math.max(1, height))
-    return width + 2 * bw + useless_gap, height + 2 * bw + useless_gap
-end
-
+-- Tiling a group needs the size hints and border of every client, so this is
+-- done in C, see `client.tile_group`.
 local function tile_group(gs, cls, wa, orientation, fact, group, useless_gap)
-    -- get our orientation right
-    local height = "height"
-    local width = "width"
-    local x = "x"
-    local y = "y"
-    if orientation == "top" or orientation == "bottom" then
-        height = "width"
-        width = "height"
-        x = "y"
-        y = "x"
-    end
-
-    -- make this more generic (not just width)
-    local available = wa[width] - (group.coord - wa[x])
-
-    -- find our total values
-    local total_fact = 0
-    local min_fact = 1
-    local size = group.size
-    for c = group.first,group.last do
-        -- determine the width/height based on the size_hint
-        local i = c - group.first +1
-        local size_hints = cls[c].size_hints
-        local size_hint = size_hints["min_"..width] or size_hints["base_"..width] or 0
-        size = math.max(size_hint, size)
-
-        -- calculate the height
-        if not fact[i] then
-            fact[i] = min_fact
-        else
-            min_fact = math.min(fact[i],min_fact)
-        end
-        total_fact = total_fact + fact[i]
-    end
-    size = math.max(1, math.min(size, available))
-
-    local coord = wa[y]
-    local used_size = 0
-    local unused = wa[height]
-    for c = group.first,group.last do
-        local geom = {}
-        local hints = {}
-        local i = c - group.first +1
-        geom[width] = size
-        geom[height] = math.max(1, math.floor(unused * fact[i] / total_fact))
-        geom[x] = group.coord
-        geom[y] = coord
-        gs[cls[c]] = geom
-        hints.width, hints.height = apply_size_hints(cls[c], geom.width, geom.height, useless_gap)
-        coord = coord + hints[height]
-        unused = unused - hints[height]
-        total_fact = total_fact - fact[i]
-        used_size = math.max(used_size, hints[width])
-    end
-
-    return used_size
+    local vertical = orientation == "top" or orientation == "bottom"
+    return capi.client.tile_group(gs, cls, wa, vertical, fact, group.first, group.last,
+                                  group.coord, group.size, useless_gap)
 end
 
 local function do_tile(param, orientation)
@@ -12,10 +12,12 @@
 local aplace = require("awful.placement")
 local capi = {mousegrabber = mousegrabber}
 local beautiful = require("beautiful")
+local gtimer = require("gears.timer")
 
 local module = {}
 
 local mode      = "live"
+local frame_rate = nil
 local req       = "request::geometry"
 local callbacks = {enter={}, move={}, leave={}}
 
@@ -55,6 +57,20 @@ function module.set_mode(m)
     mode = m
 end
 
+--- Limit how often the geometry is updated while the mouse moves.
+-- Pointer motion can arrive much more often than the screen refreshes. With a
+-- frame rate, the motion events in between are dropped and the geometry for
+-- the latest position is applied once per frame. The final geometry is always
+-- applied when the mouse is released.
+--
+-- @function awful.mouse.resize.set_frame_rate
+-- @tparam[opt=nil] number fps The maximum number of updates per second, or nil
+--   to handle every motion event (the default).
+function module.set_frame_rate(fps)
+    assert(fps == nil or fps > 0)
+    frame_rate = fps
+end
+
 --- Add an initialization callback.
 -- This callback will be executed before the mouse grabbing starts.
 -- @function awful.mouse.resize.add_enter_callback
@@ -153,9 +169,7 @@ local function handler(_, client, context, args) --luacheck: no unused_args
         or "fleur"
 
     -- Execute the placement function and use request::geometry
-    capi.mousegrabber.run(function (_mouse)
-        if not client.valid then return end
-
+    local function motion()
         -- Resize everytime the mouse moves (default behavior) in live mode,
         -- otherwise keep the current geometry
         geo = setmetatable(
@@ -191,10 +205,59 @@ local function handler(_, client, context, args) --luacheck: no unused_args
             -- Ask the resizing handler to resize the client
             client:emit_signal(req, context, geo)
         end
+    end
 
-        -- Quit when the button is released
+    local frame_timer, pending, active = nil, false, true
+    local function start_frame_timer()
+        frame_timer = gtimer.start_new(1 / frame_rate, function()
+            frame_timer = nil
+            if pending and active and client.valid and capi.mousegrabber.isrunning() then
+                pending = false
+                if motion() == false then
+                    active = false
+                    capi.mousegrabber.stop()
+                else
+                    start_frame_timer()
+                end
+            end
+            return false
+        end)
+    end
+
+    capi.mousegrabber.run(function (_mouse)
+        if not client.valid then
+            active = false
+            return
+        end
+
+        local pressed = false
         for _,v in pairs(_mouse.buttons) do
-            if v then return true end
+            if v then pressed = true end
+        end
+
+        -- Wait for the next frame
+        if pressed and frame_timer then
+            pending = true
+            return true
+        end
+
+        if motion() == false then
+            active = false
+            return false
+        end
+
+        -- Quit when the button is released
+        if pressed then
+            if frame_rate then
+                start_frame_timer()
+            end
+            return true
+        end
+
+        active = false
+        if frame_timer then
+            frame_timer:stop()
+            frame_timer = nil
         end
 
         -- Only resize after the mouse is released, this avoids losing content
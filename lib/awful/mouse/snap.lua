@@ -184,15 +184,30 @@ local function snap_inside(g, sg, snap)
     end
 end
 
---- Snap a client to the closest client or screen edge.
--- @function awful.mouse.snap
--- @param c The client to snap.
--- @param snap The pixel to snap clients.
--- @param x The client x coordinate.
--- @param y The client y coordinate.
--- @param fixed_x True if the client isn't allowed to move in the x direction.
--- @param fixed_y True if the client isn't allowed to move in the y direction.
-function module.snap(c, snap, x, y, fixed_x, fixed_y)
+-- Get the geometries, including borders and gaps, of the clients that `c` can
+-- snap to.
+local function get_snapper_geometries(c)
+    local snapper_gap = beautiful.snapper_gap or 0
+    local result = {}
+    for _, snapper in ipairs(aclient.visible(c.screen)) do
+        if snapper ~= c then
+            local snapper_geom = snapper:geometry()
+            snapper_geom.x = snapper_geom.x - snapper_gap
+            snapper_geom.y = snapper_geom.y - snapper_gap
+            snapper_geom.width = snapper_geom.width + (2 * snapper.border_width) + (2 * snapper_gap)
+            snapper_geom.height = snapper_geom.height + (2 * snapper.border_width) + (2 * snapper_gap)
+            table.insert(result, snapper_geom)
+        end
+    end
+    return result
+end
+
+-- The snapper geometries for the client being moved with the mouse, and the
+-- screen they are for. They are computed when the move starts and when the
+-- client is dragged to another screen instead of on every motion event.
+local move_snappers, move_snappers_screen = nil, nil
+
+local function snap_client(c, snap, x, y, fixed_x, fixed_y, snappers)
     snap = snap or module.default_distance
     c = c or capi.client.focus
     local cur_geom = c:geometry()
@@ -225,15 +240,8 @@ function module.snap(c, snap, x, y, fixed_x, fixed_y)
         c:struts(struts)
     end
 
-    for _, snapper in ipairs(aclient.visible(c.screen)) do
-        if snapper ~= c then
-            local snapper_geom = snapper:geometry()
-            snapper_geom.x = snapper_geom.x - snapper_gap
-            snapper_geom.y = snapper_geom.y - snapper_gap
-            snapper_geom.width = snapper_geom.width + (2 * snapper.border_width) + (2 * snapper_gap)
-            snapper_geom.height = snapper_geom.height + (2 * snapper.border_width) + (2 * snapper_gap)
-            geom = snap_outside(geom, snapper_geom, snap)
-        end
+    for _, snapper_geom in ipairs(snappers or get_snapper_geometries(c)) do
+        geom = snap_outside(geom, snapper_geom, snap)
     end
 
     geom.x = geom.x + snapper_gap
@@ -248,6 +256,23 @@ function module.snap(c, snap, x, y, fixed_x, fixed_y)
     return geom
 end
 
+--- Snap a client to the closest client or screen edge.
+-- @function awful.mouse.snap
+-- @param c The client to snap.
+-- @param snap The pixel to snap clients.
+-- @param x The client x coordinate.
+-- @param y The client y coordinate.
+-- @param fixed_x True if the client isn't allowed to move in the x direction.
+-- @param fixed_y True if the client isn't allowed to move in the y direction.
+function module.snap(c, snap, x, y, fixed_x, fixed_y)
+    return snap_client(c, snap, x, y, fixed_x, fixed_y)
+end
+
+resize.add_enter_callback(function(c)
+    move_snappers = get_snapper_geometries(c)
+    move_snappers_screen = c.screen
+end, "mouse.move")
+
 -- Enable edge snapping
 resize.add_move_callback(function(c, geo, args)
     -- Screen edge snapping (areosnap)
@@ -259,12 +284,17 @@ resize.add_move_callback(function(c, geo, args)
     -- Snapping between clients
     if (module.client_enabled ~= false)
       and args and (args.snap == nil or args.snap) then
-        return module.snap(c, args.snap, geo.x, geo.y)
+        if c.screen ~= move_snappers_screen then
+            move_snappers = get_snapper_geometries(c)
+            move_snappers_screen = c.screen
+        end
+        return snap_client(c, args.snap, geo.x, geo.y, nil, nil, move_snappers)
     end
 end, "mouse.move")
 
 -- Apply the aerosnap
 resize.add_leave_callback(function(c, _, args)
+    move_snappers, move_snappers_screen = nil, nil
     if module.edge_enabled == false then return end
     return apply_areasnap(c, args)
 end, "mouse.move")
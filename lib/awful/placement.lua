@@ -89,7 +89,7 @@ local capi =
     mouse = mouse,
     client = client
 }
-local client = require("awful.client")
+require("awful.client") -- Provides c.floating
 local layout = require("awful.layout")
 local a_screen = require("awful.screen")
 local grect = require("gears.geometry").rectangle
@@ -884,17 +884,17 @@ function placement.no_overlap(c, args)
     args = add_context(args, "no_overlap")
     local geometry = geometry_common(c, args)
     local screen   = get_screen(c.screen or a_screen.getbycoord(geometry.x, geometry.y))
-    local cls = client.visible(screen)
     local curlay = layout.get()
-    local areas = { screen.workarea }
-    for _, cl in pairs(cls) do
+    local taken = {}
+    for cl in capi.client.iterate({ visible = true }, screen) do
         if cl ~= c
            and cl.type ~= "desktop"
            and (cl.floating or curlay == layout.suit.floating)
            and not (cl.maximized or cl.fullscreen) then
-            areas = grect.area_remove(areas, area_common(cl))
+            table.insert(taken, area_common(cl))
         end
     end
+    local areas = grect.free_areas(screen.workarea, taken)
 
     -- Look for available space
     local found = false
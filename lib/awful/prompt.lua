@@ -144,29 +144,43 @@ local function itera (inc,a, i)
 end
 
 --- Load history file in history table
+-- The history file is a log to which each executed command is appended, so
+-- only the last occurrence of a command counts.
 -- @param id The data.history identifier which is the path to the filename.
 -- @param[opt] max The maximum number of entries in file.
 local function history_check_load(id, max)
     if id and id ~= "" and not data.history[id] then
-        data.history[id] = { max = 50, table = {} }
-
-        if max then
-            data.history[id].max = max
-        end
+        -- items is the set of commands in table, lines the number of lines
+        -- of the history file
+        local history = { max = max or 50, table = {}, items = {}, lines = 0 }
+        data.history[id] = history
 
         local f = io.open(id, "r")
         if not f then return end
 
         -- Read history file
+        local lines = {}
         for line in f:lines() do
-            if gtable.hasitem(data.history[id].table, line) == nil then
-                table.insert(data.history[id].table, line)
-                if #data.history[id].table >= data.history[id].max then
+            table.insert(lines, line)
+        end
+        f:close()
+        history.lines = #lines
+
+        -- Keep the newest entries, most recent last
+        local newest = {}
+        for i = #lines, 1, -1 do
+            local line = lines[i]
+            if not history.items[line] then
+                history.items[line] = true
+                table.insert(newest, line)
+                if #newest >= history.max then
                     break
                 end
             end
         end
-        f:close()
+        for i = #newest, 1, -1 do
+            table.insert(history.table, newest[i])
+        end
     end
 end
 
@@ -207,15 +221,30 @@ local function cword_end(s, pos)
 end
 
 --- Save history table in history file
+-- This rewrites the whole file and thus compacts the log.
 -- @param id The data.history identifier
 local function history_save(id)
-    if data.history[id] then
+    local history = data.history[id]
+    if history then
         assert(gfs.make_parent_directories(id))
         local f = assert(io.open(id, "w"))
-        for i = 1, math.min(#data.history[id].table, data.history[id].max) do
-            f:write(data.history[id].table[i] .. "\n")
+        local count = math.min(#history.table, history.max)
+        for i = 1, count do
+            f:write(history.table[i] .. "\n")
         end
-       f:close()
+        f:close()
+        history.lines = count
+        history.dirty = false
+    end
+end
+
+--- Compact the history file if it has too many stale entries, or if entries
+-- were removed from the history table.
+-- @param id The data.history identifier
+local function history_compact(id)
+    local history = data.history[id]
+    if history and (history.dirty or history.lines > 2 * history.max) then
+        history_save(id)
     end
 end
 
@@ -234,26 +263,49 @@ end
 -- @param id The data.history identifier
 -- @param command The command to add
 local function history_add(id, command)
-    if data.history[id] and command ~= "" then
-        local index = gtable.hasitem(data.history[id].table, command)
-        if index == nil then
-            table.insert(data.history[id].table, command)
-
-            -- Do not exceed our max_cmd
-            if #data.history[id].table > data.history[id].max then
-                table.remove(data.history[id].table, 1)
+    local history = data.history[id]
+    if history and command ~= "" then
+        if history.items[command] then
+            -- Bump this command to the end of history, it is most likely
+            -- a recent one
+            for i = #history.table, 1, -1 do
+                if history.table[i] == command then
+                    table.remove(history.table, i)
+                    break
+                end
             end
+        else
+            history.items[command] = true
+        end
+        table.insert(history.table, command)
 
+        -- Do not exceed our max_cmd
+        if #history.table > history.max then
+            history.items[table.remove(history.table, 1)] = nil
+        end
+
+        if history.dirty or history.lines >= 2 * history.max then
             history_save(id)
         else
-            -- Bump this command to the end of history
-            table.remove(data.history[id].table, index)
-            table.insert(data.history[id].table, command)
-            history_save(id)
+            assert(gfs.make_parent_directories(id))
+            local f = assert(io.open(id, "a"))
+            f:write(command .. "\n")
+            f:close()
+            history.lines = history.lines + 1
         end
     end
 end
 
+--- Remove an entry from the history table
+-- The history file is rewritten when the prompt is closed.
+-- @param id The data.history identifier
+-- @param index The index of the entry in the history table
+local function history_remove(id, index)
+    local history = data.history[id]
+    history.items[table.remove(history.table, index)] = nil
+    history.dirty = true
+end
+
 
 --- Draw the prompt text with a cursor.
 -- @tparam table args The table of arguments.
@@ -639,7 +691,7 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
             or (not mod.Control and key == "Escape") then
             keygrabber.stop(grabber)
             textbox:set_markup("")
-            history_save(history_path)
+            history_compact(history_path)
             if done_callback then done_callback() end
             return false
         elseif (mod.Control and (key == "j" or key == "m"))
@@ -722,7 +774,7 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
             elseif key == "Up" then
                 search_term = command:sub(1, cur_pos - 1) or ""
                 for i,v in (function(a,i) return itera(-1,a,i) end), data.history[history_path].table, history_index do
-                    if v:find(search_term,1,true) == 1 then
+                    if v:sub(1, #search_term) == search_term then
                         command=v
                         history_index=i
                         break
@@ -731,7 +783,7 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
             elseif key == "Down" then
                 search_term = command:sub(1, cur_pos - 1) or ""
                 for i,v in (function(a,i) return itera(1,a,i) end), data.history[history_path].table, history_index do
-                    if v:find(search_term,1,true) == 1 then
+                    if v:sub(1, #search_term) == search_term then
                         command=v
                         history_index=i
                         break
@@ -759,7 +811,7 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
                 --  we are not dealing with a new command
                 --  the user has not edited an existing entry
                 if command == data.history[history_path].table[history_index] then
-                    table.remove(data.history[history_path].table, history_index)
+                    history_remove(history_path, history_index)
                     if history_index <= history_items(history_path) then
                         command = data.history[history_path].table[history_index]
                         cur_pos = #command + 2
@@ -904,7 +956,7 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
         if changed_callback then
             changed_callback(command)
         end
-    end)
+    end, { ignore_release = not args.keyreleased_callback })
 end
 
 return prompt
@@ -182,6 +182,217 @@ function rules.matches(c, entry)
         (not rules.match(c, entry.except) and not rules.match_any(c, entry.except_any))
 end
 
+-- Rule lists are compiled into an index, so that a client is only checked
+-- against the rules which can possibly match it.
+--
+-- Every `rule` table is a conjunction, so one of its conditions (a key) must
+-- hold for the rule to match, and a `rule_any` table needs at least one of its
+-- conditions to hold. The distinct conditions of all rules are evaluated once
+-- per client, anchored literal patterns like "^Firefox$" through a hash
+-- lookup, and the rules whose keys hold are then checked with `rules.matches`.
+
+-- The properties preferred as keys, since clients usually have them.
+local key_properties = { class = 1, instance = 2, role = 3, type = 4 }
+
+-- Is the value a pattern without magic characters?
+local function is_plain(value)
+    return type(value) == "string" and not value:find("[%^%$%(%)%%%.%[%]%*%+%-%?]")
+end
+
+-- Return the literal of an anchored literal pattern like "^Firefox$".
+local function exact_literal(value)
+    if type(value) == "string" and value:sub(1, 1) == "^" and value:sub(-1) == "$" then
+        local literal = value:sub(2, -2)
+        if is_plain(literal) then return literal end
+    end
+end
+
+local function is_indexable(value)
+    local t = type(value)
+    return t == "string" or t == "number" or t == "boolean"
+end
+
+-- Copy the part of an entry the index depends on, see `index_is_valid`.
+local function snapshot_table(t, nested)
+    if not t then return nil end
+    local copy, n = {}, 0
+    for k, v in pairs(t) do
+        if nested and type(v) == "table" then
+            v = { table = v, unpack(v) }
+        end
+        copy[k], n = v, n + 1
+    end
+    copy[0] = n
+    return copy
+end
+
+local function snapshot_is_valid(t, copy, nested)
+    if not t or not copy then return t == copy end
+    local n = 0
+    for k, v in pairs(t) do
+        local c = copy[k]
+        if nested and type(v) == "table" then
+            if type(c) ~= "table" or c.table ~= v or #c ~= #v then return false end
+            for i = 1, #v do
+                if c[i] ~= v[i] then return false end
+            end
+        elseif c ~= v then
+            return false
+        end
+        n = n + 1
+    end
+    return n == copy[0]
+end
+
+-- Rules can be modified at any time, so check that the index still
+-- describes them. This only compares values and never accesses the client.
+local function index_is_valid(index, _rules)
+    if #index.entries ~= #_rules then return false end
+    for i, entry in ipairs(_rules) do
+        local snapshot = index.entries[i]
+        if snapshot.entry ~= entry
+          or not snapshot_is_valid(entry.rule, snapshot.rule)
+          or not snapshot_is_valid(entry.rule_any, snapshot.rule_any, true) then
+            return false
+        end
+    end
+    return true
+end
+
+local function compile_index(_rules)
+    local index = {
+        entries    = {},
+        -- Rules which are always checked
+        always     = {},
+        -- Distinct conditions: { field = ..., value = ..., plain = ..., rules = {...} }
+        conditions = {},
+        -- field -> literal -> condition, for anchored literal patterns
+        exact      = {},
+    }
+    local by_key = {}
+
+    local function add_condition(field, value, pos)
+        local literal = exact_literal(value)
+        local key = field .. "\0" .. type(value) .. "\0" .. tostring(value)
+        local cond = by_key[key]
+        if not cond then
+            cond = { field = field, value = value, plain = is_plain(value), rules = {} }
+            by_key[key] = cond
+            if literal then
+                -- A property can also be equal to the pattern itself.
+                index.exact[field] = index.exact[field] or {}
+                index.exact[field][literal] = cond
+                index.exact[field][value] = cond
+            else
+                table.insert(index.conditions, cond)
+            end
+        end
+        table.insert(cond.rules, pos)
+    end
+
+    for pos, entry in ipairs(_rules) do
+        index.entries[pos] = {
+            entry    = entry,
+            rule     = snapshot_table(entry.rule),
+            rule_any = snapshot_table(entry.rule_any, true),
+        }
+
+        -- Pick the key of the `rule` part, preferring exact class names.
+        local key_field, key_value, key_score
+        for field, value in pairs(entry.rule or {}) do
+            if is_indexable(value) then
+                local score = (exact_literal(value) and 0 or 10) + (key_properties[field] or 5)
+                if not key_score or score < key_score then
+                    key_field, key_value, key_score = field, value, score
+                end
+            end
+        end
+
+        local always = entry.rule ~= nil and not key_field
+        for _, values in pairs(entry.rule_any or {}) do
+            for _, value in ipairs(values) do
+                always = always or not is_indexable(value)
+            end
+        end
+
+        if always then
+            table.insert(index.always, pos)
+        else
+            if key_field then
+                add_condition(key_field, key_value, pos)
+            end
+            for field, values in pairs(entry.rule_any or {}) do
+                for _, value in ipairs(values) do
+                    add_condition(field, value, pos)
+                end
+            end
+        end
+    end
+
+    return index
+end
+
+local indexes = setmetatable({}, { __mode = "k" })
+
+local function get_index(_rules)
+    local index = indexes[_rules]
+    if not index or not index_is_valid(index, _rules) then
+        index = compile_index(_rules)
+        indexes[_rules] = index
+    end
+    return index
+end
+
+-- Get the positions of the rules which might match a client, in order.
+local function candidate_rules(c, _rules)
+    local index = get_index(_rules)
+    local props, seen, result = {}, {}, {}
+
+    local function prop(field)
+        local v = props[field]
+        if v == nil then
+            v = c[field] or false
+            props[field] = v
+        end
+        return v
+    end
+
+    local function add(positions)
+        for _, pos in ipairs(positions) do
+            if not seen[pos] then
+                seen[pos] = true
+                table.insert(result, pos)
+            end
+        end
+    end
+
+    add(index.always)
+
+    for field, literals in pairs(index.exact) do
+        local v = prop(field)
+        local cond = v and literals[v]
+        if cond then add(cond.rules) end
+    end
+
+    for _, cond in ipairs(index.conditions) do
+        local v = prop(cond.field)
+        local holds = false
+        if v then
+            if type(v) ~= "string" then
+                holds = v == cond.value
+            elseif cond.plain then
+                holds = v:find(cond.value, 1, true) ~= nil
+            else
+                holds = v == cond.value or v:match(cond.value) ~= nil
+            end
+        end
+        if holds then add(cond.rules) end
+    end
+
+    table.sort(result)
+    return result
+end
+
 --- Get list of matching rules for a client.
 -- @client c The client.
 -- @tab _rules The rules to check. List with "rule", "rule_any", "except" and
@@ -189,7 +400,8 @@ end
 -- @treturn table The list of matched rules.
 function rules.matching_rules(c, _rules)
     local result = {}
-    for _, entry in ipairs(_rules) do
+    for _, pos in ipairs(candidate_rules(c, _rules)) do
+        local entry = _rules[pos]
         if (rules.matches(c, entry)) then
             table.insert(result, entry)
         end
@@ -203,8 +415,8 @@ end
 --   `except` and `except_any` keys.
 -- @treturn bool True if at least one rule is matched, false otherwise.
 function rules.matches_list(c, _rules)
-    for _, entry in ipairs(_rules) do
-        if (rules.matches(c, entry)) then
+    for _, pos in ipairs(candidate_rules(c, _rules)) do
+        if (rules.matches(c, _rules[pos])) then
             return true
         end
     end
@@ -646,24 +858,27 @@ function rules.execute(c, props, callbacks)
     end
 
     -- Apply the remaining properties (after known race conditions are handled).
-    for property, value in pairs(props) do
-        if property ~= "focus" and type(value) == "function" then
-            value = value(c, props)
-        end
+    -- Their signals are emitted once all of them are set.
+    c:batch(function()
+        for property, value in pairs(props) do
+            if property ~= "focus" and type(value) == "function" then
+                value = value(c, props)
+            end
 
-        local ignore = rules.high_priority_properties[property] or
-            rules.delayed_properties[property] or force_ignore[property]
+            local ignore = rules.high_priority_properties[property] or
+                rules.delayed_properties[property] or force_ignore[property]
 
-        if not ignore then
-            if rules.extra_properties[property] then
-                rules.extra_properties[property](c, value, props)
-            elseif type(c[property]) == "function" then
-                c[property](c, value)
-            else
-                c[property] = value
+            if not ignore then
+                if rules.extra_properties[property] then
+                    rules.extra_properties[property](c, value, props)
+                elseif type(c[property]) == "function" then
+                    c[property](c, value)
+                else
+                    c[property] = value
+                end
             end
         end
-    end
+    end)
 
     -- Apply all callbacks.
     if callbacks then
@@ -345,12 +345,9 @@ end
 -- @tparam[opt=true] boolean stacked Use stacking order? (top to bottom)
 -- @treturn table The clients list.
 function screen.object.get_clients(s, stacked)
-    local cls = capi.client.get(s, stacked == nil and true or stacked)
     local vcls = {}
-    for _, c in pairs(cls) do
-        if c:isvisible() then
-            table.insert(vcls, c)
-        end
+    for c in capi.client.iterate({ visible = true }, s, stacked == nil and true or stacked) do
+        table.insert(vcls, c)
     end
     return vcls
 end
@@ -366,12 +363,9 @@ end
 -- @see client.get
 
 function screen.object.get_hidden_clients(s)
-    local cls = capi.client.get(s, true)
     local vcls = {}
-    for _, c in pairs(cls) do
-        if not c:isvisible() then
-            table.insert(vcls, c)
-        end
+    for c in capi.client.iterate({ visible = false }, s, true) do
+        table.insert(vcls, c)
     end
     return vcls
 end
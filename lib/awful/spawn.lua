@@ -314,19 +314,17 @@ function spawn.with_line_callback(cmd, callbacks)
         end
     end
     if have_stdout then
-        spawn.read_lines(Gio.UnixInputStream.new(stdout, true),
-                stdout_callback, step_done, true)
+        capi.awesome.spawn_read(stdout, stdout_callback, step_done)
     end
     if have_stderr then
-        spawn.read_lines(Gio.UnixInputStream.new(stderr, true),
-                stderr_callback, step_done, true)
+        capi.awesome.spawn_read(stderr, stderr_callback, step_done)
     end
     assert(stdin == nil)
     return pid
 end
 
 --- Asynchronously spawn a program and capture its output.
--- (wraps `spawn.with_line_callback`).
+-- The output is collected without calling into Lua for each line.
 -- @tparam string|table cmd The command.
 -- @tab callback Function with the following arguments
 --   @tparam string callback.stdout Output on stdout.
@@ -338,41 +336,44 @@ end
 -- @treturn[2] string Error message.
 -- @see spawn.with_line_callback
 function spawn.easy_async(cmd, callback)
-    local stdout = ''
-    local stderr = ''
+    local stdout, stderr
     local exitcode, exitreason
-    local function parse_stdout(str)
-        stdout = stdout .. str .. "\n"
-    end
-    local function parse_stderr(str)
-        stderr = stderr .. str .. "\n"
-    end
-    local function done_callback()
-        return callback(stdout, stderr, exitreason, exitcode)
+    local pending = 3
+    local function step_done()
+        pending = pending - 1
+        if pending == 0 then
+            return callback(stdout, stderr, exitreason, exitcode)
+        end
     end
-    local exit_callback_fired = false
-    local output_done_callback_fired = false
     local function exit_callback(reason, code)
         exitcode = code
         exitreason = reason
-        exit_callback_fired = true
-        if output_done_callback_fired then
-            return done_callback()
-        end
+        return step_done()
     end
-    local function output_done_callback()
-        output_done_callback_fired = true
-        if exit_callback_fired then
-            return done_callback()
+    -- Like with line callbacks, the last line is always terminated
+    local function terminate(output)
+        if output ~= "" and output:sub(-1) ~= "\n" then
+            return output .. "\n"
         end
+        return output
     end
-    return spawn.with_line_callback(
-        cmd, {
-        stdout=parse_stdout,
-        stderr=parse_stderr,
-        exit=exit_callback,
-        output_done=output_done_callback
-    })
+
+    local pid, _, _, stdout_fd, stderr_fd = capi.awesome.spawn(cmd,
+            false, false, true, true, exit_callback)
+    if type(pid) == "string" then
+        -- Error
+        return pid
+    end
+
+    capi.awesome.spawn_read(stdout_fd, nil, function(output)
+        stdout = terminate(output)
+        return step_done()
+    end)
+    capi.awesome.spawn_read(stderr_fd, nil, function(output)
+        stderr = terminate(output)
+        return step_done()
+    end)
+    return pid
 end
 
 --- Call `spawn.easy_async` with a shell.
@@ -391,6 +392,195 @@ function spawn.easy_async_with_shell(cmd, callback)
     return spawn.easy_async({ util.shell, "-c", cmd or "" }, callback)
 end
 
+local pool = {}
+
+-- Finish the job of a worker and start the next queued job.
+local function pool_finish(self, worker, reason, code)
+    local job = worker.job
+    worker.job = nil
+    if job.timer then
+        job.timer:stop()
+    end
+    self.running = self.running - 1
+    if not worker.dead then
+        table.insert(self.idle, worker)
+    end
+
+    local function output(lines)
+        return #lines > 0 and table.concat(lines, "\n") .. "\n" or ""
+    end
+    protected_call(job.callback, output(job.stdout), output(job.stderr), reason, code)
+    pool.dispatch(self)
+end
+
+local function pool_kill(self, worker)
+    worker.dead = true
+    self.workers[worker] = nil
+    for k, w in ipairs(self.idle) do
+        if w == worker then
+            table.remove(self.idle, k)
+            break
+        end
+    end
+    -- The shell started its own session, so this also kills its commands.
+    capi.awesome.kill(-worker.pid, 9)
+    worker.stdin:close()
+end
+
+local function pool_start_worker(self)
+    local worker = {}
+    local marker = self.marker
+
+    local pid, _, stdin, stdout, stderr = capi.awesome.spawn({ "/bin/sh" },
+            false, true, true, true, function(reason, code)
+                if not worker.dead then
+                    pool_kill(self, worker)
+                end
+                if worker.job then
+                    pool_finish(self, worker, reason, code)
+                end
+            end)
+    if type(pid) == "string" then
+        return nil, pid
+    end
+    worker.pid = pid
+    self.workers[worker] = true
+    worker.stdin = Gio.UnixOutputStream.new(stdin, true)
+
+    -- The marker follows the output of a command, possibly on the same line.
+    capi.awesome.spawn_read(stdout, function(line)
+        local job = worker.job
+        if not job then return end
+        local prefix, code = line:match("^(.-)" .. marker .. " (%d+)$")
+        if code then
+            if prefix ~= "" then table.insert(job.stdout, prefix) end
+            job.code = tonumber(code)
+            if job.stderr_done then
+                pool_finish(self, worker, "exit", job.code)
+            end
+        else
+            table.insert(job.stdout, line)
+        end
+    end)
+    capi.awesome.spawn_read(stderr, function(line)
+        local job = worker.job
+        if not job then return end
+        local prefix = line:match("^(.-)" .. marker .. "$")
+        if prefix then
+            if prefix ~= "" then table.insert(job.stderr, prefix) end
+            job.stderr_done = true
+            if job.code then
+                pool_finish(self, worker, "exit", job.code)
+            end
+        else
+            table.insert(job.stderr, line)
+        end
+    end)
+
+    return worker
+end
+
+--- Start queued jobs while the pool has free workers.
+-- @tparam table self The pool.
+-- @function awful.spawn.pool.dispatch
+function pool.dispatch(self)
+    while #self.queue > 0 and self.running < self.size do
+        local job = table.remove(self.queue, 1)
+        local worker, err = table.remove(self.idle), nil
+        if not worker then
+            worker, err = pool_start_worker(self)
+        end
+
+        if not worker then
+            protected_call(job.callback, "", err .. "\n", "exit", 127)
+        else
+            self.running = self.running + 1
+            worker.job = job
+            worker.stdin:write_all(string.format(
+                "(\n%s\n) </dev/null\nprintf '%%s %%d\\n' %s $?\nprintf '%%s\\n' %s >&2\n",
+                job.cmd, self.marker, self.marker))
+            if self.timeout then
+                job.timer = timer.start_new(self.timeout, function()
+                    job.timer = nil
+                    if worker.job == job then
+                        pool_kill(self, worker)
+                        pool_finish(self, worker, "timeout", nil)
+                    end
+                    return false
+                end)
+            end
+        end
+    end
+end
+
+--- Run a shell command in the pool.
+-- The callback is called like the one of `awful.spawn.easy_async`. When the
+-- command did not finish within the timeout of the pool, the exit reason is
+-- "timeout" and the output is what the command produced until then.
+-- @tparam table self The pool.
+-- @tparam string cmd The command, run by `/bin/sh` in a subshell.
+-- @tparam function callback Function with the arguments stdout, stderr,
+--   exitreason and exitcode.
+-- @function awful.spawn.pool.run
+function pool.run(self, cmd, callback)
+    table.insert(self.queue, {
+        cmd = cmd, callback = callback, stdout = {}, stderr = {}
+    })
+    pool.dispatch(self)
+end
+
+--- Stop all workers of a pool.
+-- Running commands are killed and their callbacks are called with the exit
+-- reason "timeout". Queued commands are dropped.
+-- @tparam table self The pool.
+-- @function awful.spawn.pool.stop
+function pool.stop(self)
+    self.queue = {}
+    for worker in pairs(self.workers) do
+        pool_kill(self, worker)
+        if worker.job then
+            pool_finish(self, worker, "timeout", nil)
+        end
+    end
+end
+
+--- Create a pool of persistent shells which run commands.
+--
+-- Spawning a new process for every command can be expensive when the same
+-- commands are run very often, e.g. by many `awful.widget.watch` widgets.
+-- A pool keeps up to `size` shell processes around and streams commands to
+-- them, so that a command only costs a fork of the already running shell.
+--
+-- Each command runs in its own subshell without input, so it cannot change
+-- the environment or working directory of later commands.
+--
+--    local pool = awful.spawn.pool { size = 2, timeout = 10 }
+--    pool:run("sensors | grep Core", function(stdout, stderr, reason, code)
+--        naughty.notify { text = stdout }
+--    end)
+--
+-- @tparam[opt={}] table args
+-- @tparam[opt=1] integer args.size The number of commands which may run
+--   at the same time. Further commands are queued.
+-- @tparam[opt=nil] number args.timeout Kill commands which are running for
+--   longer than this many seconds.
+-- @treturn table The pool, with the methods `run` and `stop`.
+-- @function awful.spawn.pool
+setmetatable(pool, { __call = function(_, args)
+    args = args or {}
+    return setmetatable({
+        size = args.size or 1,
+        timeout = args.timeout,
+        queue = {},
+        idle = {},
+        workers = {},
+        running = 0,
+        marker = string.format("AWESOMEPOOL%x%x", math.random(0, 0x7fffffff), os.time()),
+    }, { __index = pool })
+end })
+
+spawn.pool = pool
+
 --- Read lines from a Gio input stream
 -- @tparam Gio.InputStream input_stream The input stream to read from.
 -- @tparam function line_callback Function that is called with each line
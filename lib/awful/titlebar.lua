@@ -14,6 +14,9 @@
 
 local error = error
 local type = type
+local setmetatable = setmetatable
+local math = math
+local cairo = require("lgi").cairo
 local gmath = require("gears.math")
 local abutton = require("awful.button")
 local aclient = require("awful.client")
@@ -425,8 +428,67 @@ local titlebar = {
 --- Show tooltips when hover on titlebar buttons (defaults to 'true')
 titlebar.enable_tooltip = true
 
+--- Render titlebar background image functions once and share the result.
+--
+-- When enabled, a `bgimage` function (e.g. `beautiful.titlebar_bgimage_focus`)
+-- is called once for each focus state, position, DPI, height and width
+-- bucket. Its result is kept and painted by all titlebars which use it, so
+-- that the function does not run again for every titlebar redraw.
+--
+-- The function is called without `context.client` and for a width rounded
+-- up to `awful.titlebar.shared_bgimage_bucket`, so it must not depend on the
+-- client. Background colors and image surfaces are not affected.
+titlebar.shared_bgimage = false
+
+--- The width in pixels titlebar widths are rounded up to when sharing
+-- background images, see `awful.titlebar.shared_bgimage`.
+titlebar.shared_bgimage_bucket = 64
+
 local all_titlebars = setmetatable({}, { __mode = 'k' })
 
+-- bgimage function -> state key -> painting function
+local shared_bgimages = setmetatable({}, { __mode = 'k' })
+
+-- Get a function painting the shared rendering of a bgimage function.
+local function get_shared_bgimage(func, state, position)
+    local painters = shared_bgimages[func]
+    if not painters then
+        painters = {}
+        shared_bgimages[func] = painters
+    end
+
+    local state_key = state .. ":" .. position
+    local painter = painters[state_key]
+    if painter then
+        return painter
+    end
+
+    -- Size key -> image surface
+    local images = {}
+    painter = function(context, cr, width, height)
+        local bucket = titlebar.shared_bgimage_bucket
+        local w = math.ceil(width / bucket) * bucket
+        local key = w .. "x" .. height .. "@" .. (context.dpi or 0)
+        local img = images[key]
+        if not img then
+            img = cairo.ImageSurface.create(cairo.Format.ARGB32, w, height)
+            local shared_context = {
+                screen = context.screen,
+                dpi = context.dpi,
+                position = position,
+                focus = state == "focus"
+            }
+            func(shared_context, cairo.Context(img), w, height)
+            img:flush()
+            images[key] = img
+        end
+        cr:set_source_surface(img, 0, 0)
+        cr:paint()
+    end
+    painters[state_key] = painter
+    return painter
+end
+
 -- Get a color for a titlebar, this tests many values from the array and the theme
 local function get_color(name, c, args)
     local suffix = "_normal"
@@ -488,11 +550,29 @@ local function new(c, args)
         }
         ret = drawable(d, context, "awful.titlebar")
         ret:_inform_visible(true)
+
+        -- Only apply what changed, every change repaints the whole titlebar
+        local applied = {}
         local function update_colors()
             local args_ = bars[position].args
-            ret:set_bg(get_color("bg", c, args_))
-            ret:set_fg(get_color("fg", c, args_))
-            ret:set_bgimage(get_color("bgimage", c, args_))
+            local bg = get_color("bg", c, args_)
+            local fg = get_color("fg", c, args_)
+            local bgimage = get_color("bgimage", c, args_)
+            if titlebar.shared_bgimage and type(bgimage) == "function" then
+                local state = capi.client.focus == c and "focus" or "normal"
+                bgimage = get_shared_bgimage(bgimage, state, position)
+            end
+
+            if not applied.done or applied.bg ~= bg then
+                ret:set_bg(bg)
+            end
+            if not applied.done or applied.fg ~= fg then
+                ret:set_fg(fg)
+            end
+            if not applied.done or applied.bgimage ~= bgimage then
+                ret:set_bgimage(bgimage)
+            end
+            applied.done, applied.bg, applied.fg, applied.bgimage = true, bg, fg, bgimage
         end
 
         bars[position] = {
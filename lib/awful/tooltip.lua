@@ -51,10 +51,17 @@ local beautiful = require("beautiful")
 local dpi = require("beautiful").xresources.apply_dpi
 local setmetatable = setmetatable
 local ipairs = ipairs
+local table = table
 local capi = {mouse=mouse, awesome=awesome}
 
 local tooltip = { mt = {} }
 
+-- Wiboxes of hidden tooltips, used by the next tooltip to show. Tooltips
+-- only have a wibox of their own while they are visible, unless it was
+-- asked for with `tooltip.wibox`.
+local wibox_pool = {}
+local max_pooled_wiboxes = 4
+
 -- The mouse point is 1x1, so anything aligned based on it as parent
 -- geometry will go out of bound. To get the desired placement, it is
 -- necessary to swap left with right and top with bottom
@@ -108,7 +115,7 @@ local offset = {
 -- @see gears.shape
 
 local function apply_mouse_mode(self)
-    local w              = self:get_wibox()
+    local w              = self._private.wibox
     local align          = self._private.align
     local real_placement = align_convert[align]
 
@@ -119,7 +126,7 @@ local function apply_mouse_mode(self)
 end
 
 local function apply_outside_mode(self)
-    local w = self:get_wibox()
+    local w = self._private.wibox
 
     local _, position = a_placement.next_to(w, {
         geometry            = self._private.widget_geometry,
@@ -139,7 +146,7 @@ local function set_geometry(self)
     n_w = n_w + self.marginbox.left + self.marginbox.right
     n_h = n_h + self.marginbox.top + self.marginbox.bottom
 
-    local w = self:get_wibox()
+    local w = self._private.wibox
     w:geometry({ width = n_w, height = n_h })
 
     local mode = self.mode
@@ -153,20 +160,67 @@ local function set_geometry(self)
     a_placement.no_offscreen(w)
 end
 
+-- Give a tooltip a wibox, from the pool if possible.
+--
+-- @tparam tooltip self A tooltip object.
+-- @treturn wibox The wibox of the tooltip.
+local function acquire_wibox(self)
+    local wb = self._private.wibox
+    if wb then
+        return wb
+    end
+
+    wb = table.remove(wibox_pool)
+    if wb then
+        for k, v in pairs(self.wibox_properties) do
+            wb[k] = v
+        end
+    else
+        wb = wibox(self.wibox_properties)
+    end
+    wb:set_widget(self.widget)
+
+    -- Close the tooltip when clicking it.  This gets done on release, to not
+    -- emit the release event on an underlying object, e.g. the titlebar icon.
+    self._private.buttons = self._private.buttons or a_button({}, 1, nil, self.hide)
+    wb:buttons(self._private.buttons)
+
+    self._private.wibox = wb
+
+    return wb
+end
+
+-- Put the wibox of a hidden tooltip back into the pool.
+--
+-- @tparam tooltip self A tooltip object.
+local function release_wibox(self)
+    local wb = self._private.wibox
+    if not wb or self._private.own_wibox or #wibox_pool >= max_pooled_wiboxes then
+        return
+    end
+
+    wb:set_widget(nil)
+    wb:buttons({})
+    self._private.wibox = nil
+    table.insert(wibox_pool, wb)
+end
+
 -- Show a tooltip.
 --
 -- @tparam tooltip self The tooltip to show.
 local function show(self)
     -- do nothing if the tooltip is already shown
     if self._private.visible then return end
-    if self.timer then
-        if not self.timer.started then
+    local t = self.timer
+    if t then
+        if not t.started then
             self:timer_function()
-            self.timer:start()
+            t:start()
         end
     end
+    local wb = acquire_wibox(self)
     set_geometry(self)
-    self.wibox.visible = true
+    wb.visible = true
     self._private.visible = true
     self:emit_signal("property::visible")
 end
@@ -177,35 +231,99 @@ end
 local function hide(self)
     -- do nothing if the tooltip is already hidden
     if not self._private.visible then return end
-    if self.timer then
-        if self.timer.started then
-            self.timer:stop()
+    local t = self._private.timer
+    if t then
+        if t.started then
+            t:stop()
         end
     end
-    self.wibox.visible = false
+    self._private.wibox.visible = false
     self._private.visible = false
+    release_wibox(self)
     self:emit_signal("property::visible")
 end
 
 --- The wibox containing the tooltip widgets.
+--
+-- Tooltips share a few wiboxes between them while they are hidden. Asking
+-- for the wibox gives the tooltip a wibox of its own.
 -- @property wibox
 -- @param `wibox`
 
 function tooltip:get_wibox()
-    if self._private.wibox then
-        return self._private.wibox
+    self._private.own_wibox = true
+    return acquire_wibox(self)
+end
+
+-- Build the widgets of a tooltip when they are first needed.
+--
+-- @tparam tooltip self A tooltip object.
+local function build_widget(self)
+    local p = self._private
+    if p.widget then return end
+
+    p.widget = wibox.widget {
+        {
+            {
+                id = 'text_role',
+                font = p.font,
+                widget = wibox.widget.textbox,
+            },
+            id = 'margin_role',
+            left = p.margins.left,
+            right = p.margins.right,
+            top = p.margins.top,
+            bottom = p.margins.bottom,
+            widget = wibox.container.margin,
+        },
+        id = 'background_role',
+        bg = p.bg,
+        shape = p.shape,
+        shape_border_width = p.border_width,
+        shape_border_color = p.border_color,
+        widget = wibox.container.background,
+    }
+    p.textbox = p.widget:get_children_by_id('text_role')[1]
+    p.marginbox = p.widget:get_children_by_id('margin_role')[1]
+    p.backgroundbox = p.widget:get_children_by_id('background_role')[1]
+    p.margins = nil
+
+    if p.markup then
+        p.textbox:set_markup(p.markup)
+    elseif p.text then
+        p.textbox:set_text(p.text)
     end
+    p.markup, p.text = nil, nil
+end
 
-    local wb = wibox(self.wibox_properties)
-    wb:set_widget(self.widget)
+function tooltip:get_widget()
+    build_widget(self)
+    return self._private.widget
+end
 
-    -- Close the tooltip when clicking it.  This gets done on release, to not
-    -- emit the release event on an underlying object, e.g. the titlebar icon.
-    wb:buttons(a_button({}, 1, nil, self.hide))
+function tooltip:get_textbox()
+    build_widget(self)
+    return self._private.textbox
+end
 
-    self._private.wibox = wb
+function tooltip:get_marginbox()
+    build_widget(self)
+    return self._private.marginbox
+end
 
-    return wb
+function tooltip:get_backgroundbox()
+    build_widget(self)
+    return self._private.backgroundbox
+end
+
+-- The timer calling `timer_function`, created when it is first needed.
+function tooltip:get_timer()
+    local p = self._private
+    if not p.timer and self.timer_function then
+        p.timer = timer { timeout = p.timeout }
+        p.timer:connect_signal("timeout", self.timer_function)
+    end
+    return p.timer
 end
 
 --- Is the tooltip visible?
@@ -258,7 +376,9 @@ function tooltip:set_align(value)
 
     self._private.align = value
 
-    set_geometry(self)
+    if self._private.visible then
+        set_geometry(self)
+    end
     self:emit_signal("property::align")
 end
 
@@ -276,7 +396,10 @@ end
 -- @see gears.shape
 
 function tooltip:set_shape(s)
-    self.backgroundbox:set_shape(s)
+    self._private.shape = s
+    if self._private.widget then
+        self._private.backgroundbox:set_shape(s)
+    end
 end
 
 --- Set the tooltip positioning mode.
@@ -295,7 +418,9 @@ end
 function tooltip:set_mode(mode)
     self._private.mode = mode
 
-    set_geometry(self)
+    if self._private.visible then
+        set_geometry(self)
+    end
     self:emit_signal("property::mode")
 end
 
@@ -323,7 +448,9 @@ end
 function tooltip:set_preferred_positions(value)
     self._private.preferred_positions = value
 
-    set_geometry(self)
+    if self._private.visible then
+        set_geometry(self)
+    end
 end
 
 --- Change displayed text.
@@ -335,7 +462,11 @@ end
 -- @see wibox.widget.textbox
 
 function tooltip:set_text(text)
-    self.textbox:set_text(text)
+    if not self._private.widget then
+        self._private.text, self._private.markup = text, nil
+        return
+    end
+    self._private.textbox:set_text(text)
     if self._private.visible then
         set_geometry(self)
     end
@@ -350,7 +481,11 @@ end
 -- @see wibox.widget.textbox
 
 function tooltip:set_markup(text)
-    self.textbox:set_markup(text)
+    if not self._private.widget then
+        self._private.text, self._private.markup = nil, text
+        return
+    end
+    self._private.textbox:set_markup(text)
     if self._private.visible then
         set_geometry(self)
     end
@@ -363,8 +498,9 @@ end
 -- @tparam number timeout The timeout value.
 
 function tooltip:set_timeout(timeout)
-    if self.timer then
-        self.timer.timeout = timeout
+    self._private.timeout = timeout
+    if self._private.timer then
+        self._private.timer.timeout = timeout
     end
 end
 
@@ -375,7 +511,12 @@ end
 -- @tparam number New margins value
 
 function tooltip:set_margins(val)
-    self.marginbox:set_margins(val)
+    local margins = self._private.margins
+    if margins then
+        margins.left, margins.right, margins.top, margins.bottom = val, val, val, val
+    else
+        self._private.marginbox:set_margins(val)
+    end
 end
 
 --- Set the margins around the left and right of the tooltip textbox
@@ -385,8 +526,9 @@ end
 -- @tparam number New margins value
 
 function tooltip:set_margin_leftright(val)
-    self.marginbox.left = val
-    self.marginbox.right = val
+    local margins = self._private.margins or self._private.marginbox
+    margins.left = val
+    margins.right = val
 end
 
 --- Set the margins around the top and bottom of the tooltip textbox
@@ -396,8 +538,9 @@ end
 -- @tparam number New margins value
 
 function tooltip:set_margin_topbottom(val)
-    self.marginbox.top = val
-    self.marginbox.bottom = val
+    local margins = self._private.margins or self._private.marginbox
+    margins.top = val
+    margins.bottom = val
 end
 
 --- Add tooltip to an object.
@@ -480,12 +623,6 @@ function tooltip.new(args)
     if args.delay_show then
         local delay_timeout
 
-        delay_timeout = timer { timeout = args.delay_show }
-        delay_timeout:connect_signal("timeout", function ()
-            show(self)
-            delay_timeout:stop()
-        end)
-
         function self.show(other, geo)
             -- Auto detect clients and wiboxes
             if other.drawable or other.pid then
@@ -495,12 +632,19 @@ function tooltip.new(args)
             -- Cache the geometry in case it is needed later
             self._private.widget_geometry = get_parent_geometry(other, geo)
 
+            if not delay_timeout then
+                delay_timeout = timer {
+                    timeout     = args.delay_show,
+                    single_shot = true,
+                    callback    = function() show(self) end,
+                }
+            end
             if not delay_timeout.started then
                 delay_timeout:start()
             end
         end
         function self.hide()
-            if delay_timeout.started then
+            if delay_timeout and delay_timeout.started then
                 delay_timeout:stop()
             end
             hide(self)
@@ -525,13 +669,12 @@ function tooltip.new(args)
     -- export functions
     gtable.crush(self, tooltip, true)
 
-    -- setup the timer action only if needed
+    -- setup the timer action only if needed, the timer is created on show
     if args.timer_function then
-        self.timer = timer { timeout = args.timeout and args.timeout or 1 }
+        self._private.timeout = args.timeout and args.timeout or 1
         self.timer_function = function()
                 self:set_markup(args.timer_function())
             end
-        self.timer:connect_signal("timeout", self.timer_function)
     end
 
     -- collect tooltip properties
@@ -561,30 +704,12 @@ function tooltip.new(args)
         type = "tooltip",
     }
 
-    self.widget = wibox.widget {
-        {
-            {
-                id = 'text_role',
-                font = font,
-                widget = wibox.widget.textbox,
-            },
-            id = 'margin_role',
-            left = m_lr,
-            right = m_lr,
-            top = m_tb,
-            bottom = m_tb,
-            widget = wibox.container.margin,
-        },
-        id = 'background_role',
-        bg = bg,
-        shape = self._private.shape,
-        shape_border_width = border_width,
-        shape_border_color = border_color,
-        widget = wibox.container.background,
-    }
-    self.textbox = self.widget:get_children_by_id('text_role')[1]
-    self.marginbox = self.widget:get_children_by_id('margin_role')[1]
-    self.backgroundbox = self.widget:get_children_by_id('background_role')[1]
+    -- The widgets are built by build_widget() when they are first needed
+    self._private.font = font
+    self._private.margins = { left = m_lr, right = m_lr, top = m_tb, bottom = m_tb }
+    self._private.bg = bg
+    self._private.border_width = border_width
+    self._private.border_color = border_color
 
     -- Add tooltip to objects
     if args.objects then
@@ -84,7 +84,54 @@ local function custom_template(args)
     }
 end
 
+-- Update the widgets of an object from its label.
+local function update_item(cache, o, label)
+    local text, bg, bg_image, icon, item_args = label(o, cache.tb)
+    item_args = item_args or {}
+
+    -- The text might be invalid, so use pcall.
+    if cache.tbm and (text == nil or text == "") then
+        cache.tbm:set_margins(0)
+    elseif cache.tb then
+        if not cache.tb:set_markup_silently(text) then
+            cache.tb:set_markup("<i>&lt;Invalid text&gt;</i>")
+        end
+    end
+
+    if cache.bgb then
+        cache.bgb:set_bg(bg)
+
+        --TODO v5 remove this if, it existed only for a removed and
+        -- undocumented API
+        if type(bg_image) ~= "function" then
+            cache.bgb:set_bgimage(bg_image)
+        else
+            gdebug.deprecate("If you read this, you used an undocumented API"..
+                " which has been replaced by the new awful.widget.common "..
+                "templating system, please migrate now. This feature is "..
+                "already staged for removal", {
+                deprecated_in = 4
+            })
+        end
+
+        cache.bgb.shape              = item_args.shape
+        cache.bgb.shape_border_width = item_args.shape_border_width
+        cache.bgb.shape_border_color = item_args.shape_border_color
+
+    end
+
+    if cache.ib and icon then
+        cache.ib:set_image(icon)
+    elseif cache.ibm then
+        cache.ibm:set_margins(0)
+    end
+end
+
 --- Common update method.
+--
+-- The widgets of an object are created once and kept in `data`, so that
+-- calling this again only updates them. The layout is only refilled when the
+-- displayed objects or their order changed.
 -- @param w The widget.
 -- @tab buttons
 -- @func label Function to generate label parameters from an object.
@@ -95,7 +142,8 @@ end
 -- @tparam[opt={}] table args
 function common.list_update(w, buttons, label, data, objects, args)
     -- update the widgets, creating them if needed
-    w:reset()
+    local children = w:get_children()
+    local unchanged = #children == #objects
     for i, o in ipairs(objects) do
         local cache = data[o]
 
@@ -114,48 +162,39 @@ function common.list_update(w, buttons, label, data, objects, args)
             cache.update_callback(cache.primary, o, i, objects)
         end
 
-        local text, bg, bg_image, icon, item_args = label(o, cache.tb)
-        item_args = item_args or {}
+        update_item(cache, o, label)
 
-        -- The text might be invalid, so use pcall.
-        if cache.tbm and (text == nil or text == "") then
-            cache.tbm:set_margins(0)
-        elseif cache.tb then
-            if not cache.tb:set_markup_silently(text) then
-                cache.tb:set_markup("<i>&lt;Invalid text&gt;</i>")
-            end
-        end
-
-        if cache.bgb then
-            cache.bgb:set_bg(bg)
-
-            --TODO v5 remove this if, it existed only for a removed and
-            -- undocumented API
-            if type(bg_image) ~= "function" then
-                cache.bgb:set_bgimage(bg_image)
-            else
-                gdebug.deprecate("If you read this, you used an undocumented API"..
-                    " which has been replaced by the new awful.widget.common "..
-                    "templating system, please migrate now. This feature is "..
-                    "already staged for removal", {
-                    deprecated_in = 4
-                })
-            end
-
-            cache.bgb.shape              = item_args.shape
-            cache.bgb.shape_border_width = item_args.shape_border_width
-            cache.bgb.shape_border_color = item_args.shape_border_color
+        unchanged = unchanged and children[i] == cache.primary
+    end
 
+    if not unchanged then
+        w:reset()
+        for _, o in ipairs(objects) do
+            w:add(data[o].primary)
         end
+    end
+end
 
-        if cache.ib and icon then
-            cache.ib:set_image(icon)
-        elseif cache.ibm then
-            cache.ibm:set_margins(0)
-        end
+--- Update the widgets of a single object displayed by `list_update`.
+--
+-- This is equivalent to calling `list_update` again with the same objects
+-- when only the label of `o` changed.
+-- @tab data The data/cache given to `list_update`.
+-- @func label The label function given to `list_update`.
+-- @param o The object.
+-- @tparam number index The position of `o` in `objects`.
+-- @tab objects The objects given to `list_update`.
+-- @treturn boolean False if `o` has no widgets, it then needs a full update.
+function common.list_update_item(data, label, o, index, objects)
+    local cache = data[o]
+    if not cache then return false end
+
+    if cache.update_callback then
+        cache.update_callback(cache.primary, o, index, objects)
+    end
+    update_item(cache, o, label)
 
-        w:add(cache.primary)
-   end
+    return true
 end
 
 return common
@@ -50,7 +50,7 @@ local tag = require("awful.tag")
 local beautiful = require("beautiful")
 local fixed = require("wibox.layout.fixed")
 local surface = require("gears.surface")
-local timer = require("gears.timer")
+local scheduler = require("gears.scheduler")
 local gcolor = require("gears.color")
 local gstring = require("gears.string")
 local gdebug = require("gears.debug")
@@ -384,6 +384,10 @@ function taglist.taglist_label(t, args)
     return text, bg_color, bg_image, not taglist_disable_icon and icon or nil, other_args
 end
 
+local function taglist_shows(t, filter)
+    return not tag.getproperty(t, "hide") and filter(t)
+end
+
 local function taglist_update(s, w, buttons, filter, data, style, update_function, args)
     local tags = {}
 
@@ -391,7 +395,7 @@ local function taglist_update(s, w, buttons, filter, data, style, update_functio
     local list   = source and source(s, args) or s.tags
 
     for _, t in ipairs(list) do
-        if not tag.getproperty(t, "hide") and filter(t) then
+        if taglist_shows(t, filter) then
             table.insert(tags, t)
         end
     end
@@ -399,6 +403,8 @@ local function taglist_update(s, w, buttons, filter, data, style, update_functio
     local function label(c) return taglist.taglist_label(c, style) end
 
     update_function(w, buttons, label, data, tags, args)
+
+    return tags
 end
 
 --- Create a new taglist widget. The last two arguments (update_function
@@ -496,9 +502,20 @@ function taglist.new(args, filter, buttons, style, update_function, base_widget)
 
     local queued_update = {}
 
+    -- The displayed tags and their position, to update a single tag.
+    local shown, shown_index = {}, {}
+    local queued_tags = {}
+
+    local function label(t) return taglist.taglist_label(t, args.style) end
+
     function w._do_taglist_update_now()
+        queued_tags = {}
         if screen.valid then
-            taglist_update(screen, w, args.buttons, args.filter, data, args.style, uf, args)
+            shown = taglist_update(screen, w, args.buttons, args.filter, data, args.style, uf, args)
+            shown_index = {}
+            for i, t in ipairs(shown) do
+                shown_index[t] = i
+            end
         end
         queued_update[screen] = false
     end
@@ -506,10 +523,43 @@ function taglist.new(args, filter, buttons, style, update_function, base_widget)
     function w._do_taglist_update()
         -- Add a delayed callback for the first update.
         if not queued_update[screen] then
-            timer.delayed_call(w._do_taglist_update_now)
+            scheduler.queue("after_paint", w._do_taglist_update_now)
             queued_update[screen] = true
         end
     end
+
+    local function update_tags_now()
+        local tags = queued_tags
+        queued_tags = {}
+
+        -- A full update is pending anyway.
+        if queued_update[screen] or not screen.valid then return end
+
+        for t in pairs(tags) do
+            local index = shown_index[t]
+            local visible = t.activated and taglist_shows(t, args.filter) and true or false
+
+            -- Tags appearing or disappearing need the list to be rebuilt.
+            if (index ~= nil) ~= visible
+              or (index and not common.list_update_item(data, label, t, index, shown)) then
+                return w._do_taglist_update()
+            end
+        end
+    end
+
+    -- Update the entry of a tag whose state changed. Only the default source
+    -- and update function allow to do this without rebuilding the whole
+    -- list: a custom one may depend on anything.
+    function w._do_taglist_update_tag(t)
+        if args.source or uf ~= common.list_update then
+            return w._do_taglist_update()
+        end
+
+        if not next(queued_tags) then
+            scheduler.queue("after_paint", update_tags_now)
+        end
+        queued_tags[t] = true
+    end
     if instances == nil then
         instances = setmetatable({}, { __mode = "k" })
         local function u(s)
@@ -522,22 +572,36 @@ function taglist.new(args, filter, buttons, style, update_function, base_widget)
         end
         local uc = function (c) return u(c.screen) end
         local ut = function (t) return u(t.screen) end
-        capi.client.connect_signal("focus", uc)
-        capi.client.connect_signal("unfocus", uc)
-        tag.attached_connect_signal(nil, "property::selected", ut)
-        tag.attached_connect_signal(nil, "property::icon", ut)
+        -- Changes which only affect the entry of a tag, if any.
+        local function utag(t)
+            local i = t.screen and instances[get_screen(t.screen)]
+            if i then
+                for _, tlist in pairs(i) do
+                    tlist._do_taglist_update_tag(t)
+                end
+            end
+        end
+        local function uctags(c)
+            for _, t in ipairs(c:tags()) do
+                utag(t)
+            end
+        end
+        capi.client.connect_signal("focus", uctags)
+        capi.client.connect_signal("unfocus", uctags)
+        tag.attached_connect_signal(nil, "property::selected", utag)
+        tag.attached_connect_signal(nil, "property::icon", utag)
         tag.attached_connect_signal(nil, "property::hide", ut)
-        tag.attached_connect_signal(nil, "property::name", ut)
+        tag.attached_connect_signal(nil, "property::name", utag)
         tag.attached_connect_signal(nil, "property::activated", ut)
         tag.attached_connect_signal(nil, "property::screen", ut)
         tag.attached_connect_signal(nil, "property::index", ut)
-        tag.attached_connect_signal(nil, "property::urgent", ut)
+        tag.attached_connect_signal(nil, "property::urgent", utag)
         capi.client.connect_signal("property::screen", function(c, old_screen)
             u(c.screen)
             u(old_screen)
         end)
-        capi.client.connect_signal("tagged", uc)
-        capi.client.connect_signal("untagged", uc)
+        capi.client.connect_signal("tagged", function(_, t) utag(t) end)
+        capi.client.connect_signal("untagged", function(_, t) utag(t) end)
         capi.client.connect_signal("unmanage", uc)
         capi.screen.connect_signal("removed", function(s)
             instances[get_screen(s)] = nil
@@ -83,7 +83,7 @@ local common = require("awful.widget.common")
 local beautiful = require("beautiful")
 local tag = require("awful.tag")
 local flex = require("wibox.layout.flex")
-local timer = require("gears.timer")
+local scheduler = require("gears.scheduler")
 local gcolor = require("gears.color")
 local gstring = require("gears.string")
 local gdebug = require("gears.debug")
@@ -399,6 +399,12 @@ local function tasklist_label(c, args, tb)
     return text, bg, bg_image, not tasklist_disable_icon and c.icon or nil, other_args
 end
 
+local function tasklist_shows(c, s, filter)
+    return not (c.skip_taskbar or c.hidden
+        or c.type == "splash" or c.type == "dock" or c.type == "desktop")
+        and filter(c, s)
+end
+
 local function tasklist_update(s, w, buttons, filter, data, style, update_function, args)
     local clients = {}
 
@@ -406,9 +412,7 @@ local function tasklist_update(s, w, buttons, filter, data, style, update_functi
     local list   = source and source(s, args) or capi.client.get()
 
     for _, c in ipairs(list) do
-        if not (c.skip_taskbar or c.hidden
-            or c.type == "splash" or c.type == "dock" or c.type == "desktop")
-            and filter(c, s) then
+        if tasklist_shows(c, s, filter) then
             table.insert(clients, c)
         end
     end
@@ -416,6 +420,8 @@ local function tasklist_update(s, w, buttons, filter, data, style, update_functi
     local function label(c, tb) return tasklist_label(c, style, tb) end
 
     update_function(w, buttons, label, data, clients, args)
+
+    return clients
 end
 
 --- Create a new tasklist widget.
@@ -519,21 +525,66 @@ function tasklist.new(args, filter, buttons, style, update_function, base_widget
 
     local queued_update = false
 
+    -- The displayed clients and their position, to update a single client.
+    local shown, shown_index = {}, {}
+    local queued_clients = {}
+
+    local function label(c, tb) return tasklist_label(c, args.style, tb) end
+
     -- For the tests
     function w._do_tasklist_update_now()
         queued_update = false
+        queued_clients = {}
         if screen.valid then
-            tasklist_update(screen, w, args.buttons, args.filter, data, args.style, uf, args)
+            shown = tasklist_update(screen, w, args.buttons, args.filter, data, args.style, uf, args)
+            shown_index = {}
+            for i, c in ipairs(shown) do
+                shown_index[c] = i
+            end
         end
     end
 
     function w._do_tasklist_update()
         -- Add a delayed callback for the first update.
         if not queued_update then
-            timer.delayed_call(w._do_tasklist_update_now)
+            scheduler.queue("after_paint", w._do_tasklist_update_now)
             queued_update = true
         end
     end
+
+    local function update_clients_now()
+        local clients = queued_clients
+        queued_clients = {}
+
+        -- A full update is pending anyway.
+        if queued_update or not screen.valid then return end
+
+        for c in pairs(clients) do
+            local index = shown_index[c]
+            local visible = c.valid and tasklist_shows(c, screen, args.filter) and true or false
+
+            -- Clients appearing or disappearing need the list to be rebuilt.
+            if (index ~= nil) ~= visible
+              or (index and not common.list_update_item(data, label, c, index, shown)) then
+                return w._do_tasklist_update()
+            end
+        end
+    end
+
+    -- Update the entry of a client whose properties changed. Only the default
+    -- source and update function allow to do this without rebuilding the
+    -- whole list: a custom one may depend on anything.
+    function w._do_tasklist_update_client(c)
+        if args.source or uf ~= common.list_update then
+            return w._do_tasklist_update()
+        end
+
+        if not next(queued_clients) then
+            scheduler.queue("after_paint", update_clients_now)
+        end
+        queued_clients[c] = true
+    end
+
     function w._unmanage(c)
         data[c] = nil
     end
@@ -554,28 +605,38 @@ function tasklist.new(args, filter, buttons, style, update_function, base_widget
                 end
             end
         end
+        -- Properties which only change the entry of the client, if any.
+        local function uc(c)
+            for s, i in pairs(instances) do
+                if s.valid then
+                    for _, tlist in pairs(i) do
+                        tlist._do_tasklist_update_client(c)
+                    end
+                end
+            end
+        end
 
         tag.attached_connect_signal(nil, "property::selected", u)
         tag.attached_connect_signal(nil, "property::activated", u)
-        capi.client.connect_signal("property::urgent", u)
-        capi.client.connect_signal("property::sticky", u)
-        capi.client.connect_signal("property::ontop", u)
-        capi.client.connect_signal("property::above", u)
-        capi.client.connect_signal("property::below", u)
-        capi.client.connect_signal("property::floating", u)
-        capi.client.connect_signal("property::maximized_horizontal", u)
-        capi.client.connect_signal("property::maximized_vertical", u)
-        capi.client.connect_signal("property::maximized", u)
-        capi.client.connect_signal("property::minimized", u)
-        capi.client.connect_signal("property::name", u)
-        capi.client.connect_signal("property::icon_name", u)
-        capi.client.connect_signal("property::icon", u)
-        capi.client.connect_signal("property::skip_taskbar", u)
+        capi.client.connect_signal("property::urgent", uc)
+        capi.client.connect_signal("property::sticky", uc)
+        capi.client.connect_signal("property::ontop", uc)
+        capi.client.connect_signal("property::above", uc)
+        capi.client.connect_signal("property::below", uc)
+        capi.client.connect_signal("property::floating", uc)
+        capi.client.connect_signal("property::maximized_horizontal", uc)
+        capi.client.connect_signal("property::maximized_vertical", uc)
+        capi.client.connect_signal("property::maximized", uc)
+        capi.client.connect_signal("property::minimized", uc)
+        capi.client.connect_signal("property::name", uc)
+        capi.client.connect_signal("property::icon_name", uc)
+        capi.client.connect_signal("property::icon", uc)
+        capi.client.connect_signal("property::skip_taskbar", uc)
         capi.client.connect_signal("property::screen", function(c, old_screen)
             us(c.screen)
             us(old_screen)
         end)
-        capi.client.connect_signal("property::hidden", u)
+        capi.client.connect_signal("property::hidden", uc)
         capi.client.connect_signal("tagged", u)
         capi.client.connect_signal("untagged", u)
         capi.client.connect_signal("unmanage", function(c)
@@ -587,8 +648,8 @@ function tasklist.new(args, filter, buttons, style, update_function, base_widget
             end
         end)
         capi.client.connect_signal("list", u)
-        capi.client.connect_signal("focus", u)
-        capi.client.connect_signal("unfocus", u)
+        capi.client.connect_signal("focus", uc)
+        capi.client.connect_signal("unfocus", uc)
         capi.screen.connect_signal("removed", function(s)
             instances[get_screen(s)] = nil
         end)
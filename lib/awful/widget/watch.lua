@@ -31,15 +31,139 @@
 ---------------------------------------------------------------------------
 
 local setmetatable = setmetatable
+local pairs = pairs
+local type = type
 local textbox = require("wibox.widget.textbox")
+local hierarchy = require("wibox.hierarchy")
+local drawable = require("wibox.drawable")
 local timer = require("gears.timer")
 local spawn = require("awful.spawn")
+local protected_call = require("gears.protected_call")
+local glib = require("lgi").GLib
 
 local watch = { mt = {} }
 
+--- The time in seconds between the first runs of different commands.
+--
+-- Watches created together, e.g. the widgets of all wibars at startup, would
+-- otherwise run all their commands at the same time, every time.
+-- @tfield number awful.widget.watch.stagger
+watch.stagger = 0.05
+
+-- Commands run by watches, by command and timeout. Watches of the same
+-- command with the same timeout share a job, which runs the command once for
+-- all of them.
+local jobs = setmetatable({}, { __mode = "v" })
+
+-- When the next unused start time for a new job is
+local next_start = 0
+
+local function now()
+    return glib.get_monotonic_time() / 1000000
+end
+
+local function job_key(command, timeout)
+    if type(command) == "table" then
+        command = table.concat(command, "\0")
+    end
+    return command .. "\1" .. timeout
+end
+
+-- Can the widget of a watch be seen? Only widgets which were shown before and
+-- are hidden now are not. Others could be placed somewhere awesome does not
+-- know about, e.g. widgets which are not widgets or not placed yet.
+local function is_shown(sub)
+    local widget = sub.widget
+    if type(widget) ~= "table" or not widget._private then
+        return true
+    end
+    if widget._private.visible ~= false and drawable.is_widget_shown(widget) then
+        sub.was_shown = true
+        return true
+    end
+    return not sub.was_shown
+end
+
+-- Watches whose timer was stopped are no longer subscribed
+local function is_subscribed(sub)
+    return sub.timer.started
+end
+
+local function deliver(sub)
+    local result = sub.job.result
+    -- The next run is one timeout after the result
+    sub.timer:again()
+    protected_call(sub.callback, sub.widget, result.stdout, result.stderr,
+                   result.exitreason, result.exitcode)
+end
+
+local function run(job)
+    job.running = true
+    spawn.easy_async(job.command, function(stdout, stderr, exitreason, exitcode)
+        job.running = false
+        job.result = { stdout = stdout, stderr = stderr,
+                       exitreason = exitreason, exitcode = exitcode }
+        for sub in pairs(job.subscribers) do
+            if is_subscribed(sub) then
+                deliver(sub)
+            end
+        end
+    end)
+end
+
+-- A watch's timer fired
+local function request(sub)
+    local job = sub.job
+    if job.running or job.pending then
+        -- Everyone gets the result of this run
+        return
+    end
+
+    if job.result then
+        -- Nobody would see the result
+        local shown = false
+        for other in pairs(job.subscribers) do
+            if is_subscribed(other) and is_shown(other) then
+                shown = true
+                break
+            end
+        end
+        if not shown then
+            return
+        end
+    end
+
+    run(job)
+end
+
+-- Run a new job, a bit after jobs started just before
+local function start(job)
+    local time = now()
+    local delay = math.max(0, next_start - time)
+    next_start = time + delay + watch.stagger
+    if delay == 0 then
+        run(job)
+        return
+    end
+    job.pending = true
+    timer.start_new(delay, function()
+        job.pending = false
+        if not job.running then
+            run(job)
+        end
+        return false
+    end)
+end
+
 --- Create a textbox that shows the output of a command
 -- and updates it at a given time interval.
 --
+-- Watches of the same command with the same timeout share its runs: the
+-- command is run once and its output is given to all of them, e.g. to the
+-- copies of a widget on the wibars of all screens. The command is not run
+-- while all of these widgets were shown before and are hidden now. The first
+-- runs of different commands are spread out by `awful.widget.watch.stagger`.
+--
 -- @tparam string|table command The command.
 --
 -- @tparam[opt=5] integer timeout The time interval at which the textbox
@@ -63,23 +187,47 @@ local watch = { mt = {} }
 -- @param[opt=wibox.widget.textbox()] base_widget Base widget.
 --
 -- @return The widget used by this watch.
--- @return Its gears.timer.
+-- @return Its gears.timer. Stopping it unsubscribes the watch, emitting its
+--   `timeout` signal runs the command now.
 function watch.new(command, timeout, callback, base_widget)
     timeout = timeout or 5
     base_widget = base_widget or textbox()
     callback = callback or function(widget, stdout, stderr, exitreason, exitcode) -- luacheck: no unused args
         widget:set_text(stdout)
     end
-    local t = timer { timeout = timeout }
+
+    if type(base_widget) == "table" and base_widget._private then
+        -- Needed to find out whether the widget is shown
+        hierarchy.count_widget(base_widget)
+    end
+
+    local key = job_key(command, timeout)
+    local job = jobs[key]
+    local new_job = not job
+    if new_job then
+        job = {
+            command = command,
+            timeout = timeout,
+            subscribers = setmetatable({}, { __mode = "k" }),
+        }
+        jobs[key] = job
+    end
+
+    local t = timer { timeout = timeout, slack = math.min(timeout / 10, 1) }
+    -- The subscription lives as long as the timer, which references the job
+    local sub = { job = job, widget = base_widget, callback = callback, timer = t }
+    job.subscribers[sub] = true
     t:connect_signal("timeout", function()
-        t:stop()
-        spawn.easy_async(command, function(stdout, stderr, exitreason, exitcode)
-          callback(base_widget, stdout, stderr, exitreason, exitcode)
-          t:again()
-        end)
+        request(sub)
     end)
     t:start()
-    t:emit_signal("timeout")
+
+    if new_job then
+        start(job)
+    elseif job.result then
+        -- Share the last result right away
+        deliver(sub)
+    end
     return base_widget, t
 end
 
@@ -0,0 +1,502 @@
+---------------------------------------------------------------------------
+--- Run asynchronous work as coroutines.
+--
+-- A task is a function running in a coroutine. It waits for asynchronous
+-- operations with the functions of this module, which suspend it until the
+-- result is there. The task is resumed from the callback of the operation,
+-- which is called by the GLib main loop, so it never blocks awesome:
+--
+--    async.run(function()
+--        local out = async.spawn({ "uname", "-r" })
+--        async.sleep(1)
+--        mytextbox.text = out
+--    end)
+--
+-- These functions can only be used inside of a task. They raise the error
+-- `gears.async.cancelled` when the task is cancelled while it waits, so that
+-- `gears.async.pcall` can be used to clean up. Otherwise, an error ends the
+-- task and is printed. The plain `pcall` cannot be used around them, Lua 5.1
+-- cannot yield across it:
+--
+--    async.run(function()
+--        local ok, err = async.pcall(async.sleep, 10)
+--        if not ok and err == async.cancelled then
+--            mytextbox.text = ""
+--        end
+--    end)
+--
+-- A group limits how many of its tasks run at the same time. Updating a
+-- widget from a group with a limit of 1 and the `"replace"` policy means
+-- only the newest update is kept in flight:
+--
+--    local updates = async.group { limit = 1, policy = "replace" }
+--    mybutton:connect_signal("button::press", function()
+--        updates:run(function() ... end)
+--    end)
+--
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+-- @module gears.async
+---------------------------------------------------------------------------
+
+local capi = { awesome = awesome }
+local assert = assert
+local coroutine = coroutine
+local error = error
+local ipairs = ipairs
+local math = math
+local select = select
+local setmetatable = setmetatable
+local table = table
+local tostring = tostring
+local type = type
+local traceback = debug.traceback
+local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
+local lgi = require("lgi")
+local glib = lgi.GLib
+local gio = lgi.Gio
+local gdebug = require("gears.debug")
+local protected_call = require("gears.protected_call")
+
+local async = {}
+
+--- The error raised inside of a task which was cancelled while waiting.
+-- @field gears.async.cancelled
+async.cancelled = setmetatable({}, { __tostring = function() return "task cancelled" end })
+
+local task = {}
+task.__index = task
+
+-- Coroutine -> task running in it
+local tasks = setmetatable({}, { __mode = "k" })
+
+local function pack(...)
+    return { n = select("#", ...), ... }
+end
+
+local function finish(self, status, ...)
+    self.status = status
+    self.result = pack(...)
+    self.co = nil
+    local callbacks = self.callbacks
+    self.callbacks = {}
+    for _, callback in ipairs(callbacks) do
+        protected_call(callback, self)
+    end
+end
+
+-- Resume the coroutine of a task and handle it ending.
+local function step(self, ...)
+    local co = self.co
+    local result = pack(coroutine.resume(co, ...))
+    if coroutine.status(co) ~= "dead" then
+        return
+    end
+
+    if result[1] then
+        finish(self, "done", unpack(result, 2, result.n))
+    elseif result[2] == async.cancelled then
+        finish(self, "cancelled")
+    else
+        gdebug.print_error(traceback(co, "Error in an async task: " .. tostring(result[2])))
+        finish(self, "failed", result[2])
+    end
+end
+
+local function start(self)
+    self.status = "running"
+    self.co = coroutine.create(self.func)
+    tasks[self.co] = self
+    step(self, unpack(self.args, 1, self.args.n))
+end
+
+local function new_task(func, ...)
+    assert(type(func) == "function", "func must be a function, got: " .. type(func))
+    return setmetatable({
+        func = func,
+        args = pack(...),
+        status = "pending",
+        callbacks = {},
+    }, task)
+end
+
+--- Start a task.
+-- The function runs right away until it has to wait for the first time.
+-- @tparam function func The function to run.
+-- @param ... Arguments to the function.
+-- @treturn gears.async.task The task.
+-- @function gears.async.run
+function async.run(func, ...)
+    local self = new_task(func, ...)
+    start(self)
+    return self
+end
+
+--- The state of the task: `"pending"` (queued in a group), `"running"`,
+-- `"done"`, `"failed"` or `"cancelled"`.
+-- @tfield string status
+
+--- Check if the task ended.
+-- @treturn boolean True unless the task is pending or running.
+-- @method is_finished
+function task:is_finished()
+    return self.status ~= "pending" and self.status ~= "running"
+end
+
+--- Call a function when the task ends.
+-- If it already ended, the function is called right away.
+-- @tparam function callback The function, called with the task.
+-- @method on_finished
+function task:on_finished(callback)
+    if self:is_finished() then
+        protected_call(callback, self)
+    else
+        table.insert(self.callbacks, callback)
+    end
+end
+
+--- Get the return values of a finished task.
+-- @return The values returned by the function, or the error of a failed
+--   task.
+-- @method get_result
+function task:get_result()
+    local result = self.result or { n = 0 }
+    return unpack(result, 1, result.n)
+end
+
+--- Cancel the task.
+-- A pending task never runs. A running task gets the
+-- `gears.async.cancelled` error from the operation it waits for, which is
+-- cancelled as well, e.g. a spawned command is terminated.
+-- @method cancel
+function task:cancel()
+    if self.status == "pending" then
+        finish(self, "cancelled")
+    elseif self.status == "running" and not self.cancelling then
+        self.cancelling = true
+        local co = coroutine.running()
+        if co and tasks[co] == self then
+            error(async.cancelled, 0)
+        end
+        local cancel = self.wait_cancel
+        self.wait_cancel = nil
+        if cancel then
+            protected_call(cancel)
+        end
+        if self.waiting then
+            self.waiting = false
+            step(self, false)
+        end
+    end
+end
+
+local function current_task()
+    local co = coroutine.running()
+    local self = co and tasks[co]
+    if not self then
+        error("this can only be used inside of a gears.async task", 3)
+    end
+    return self
+end
+
+--- Wait for a callback based operation.
+-- This is used to implement the other operations. `start_op` is called with
+-- a function which has to be called with the results once the operation is
+-- done. It may return a function which cancels the operation.
+-- @tparam function start_op The function starting the operation.
+-- @return The values given to the result function.
+-- @function gears.async.await
+function async.await(start_op)
+    local self = current_task()
+    if self.cancelling then
+        error(async.cancelled, 0)
+    end
+
+    local done, result = false, nil
+    local function resume(...)
+        if done then
+            return
+        end
+        done = true
+        if self.waiting then
+            self.waiting = false
+            self.wait_cancel = nil
+            step(self, true, ...)
+        else
+            -- The operation finished before start_op returned
+            result = pack(...)
+        end
+    end
+
+    local cancel = start_op(resume)
+    if result then
+        return unpack(result, 1, result.n)
+    end
+
+    self.waiting = true
+    self.wait_cancel = cancel
+    local function continue(ok, ...)
+        if not ok then
+            done = true
+            error(async.cancelled, 0)
+        end
+        return ...
+    end
+    return continue(coroutine.yield())
+end
+
+--- Call a function in protected mode inside of a task.
+-- Unlike `pcall`, the function can wait. It runs in its own coroutine,
+-- whose waits are passed on to the coroutine of the task.
+-- @tparam function func The function to call.
+-- @param ... Arguments to the function.
+-- @treturn boolean False if the function raised an error.
+-- @return The values returned by the function, or the error, which is
+--   `gears.async.cancelled` if the task was cancelled meanwhile.
+-- @function gears.async.pcall
+function async.pcall(func, ...)
+    local self = current_task()
+    local co = coroutine.create(func)
+    tasks[co] = self
+
+    local result = pack(coroutine.resume(co, ...))
+    while coroutine.status(co) ~= "dead" do
+        result = pack(coroutine.resume(co, coroutine.yield(unpack(result, 2, result.n))))
+    end
+    tasks[co] = nil
+    return unpack(result, 1, result.n)
+end
+
+--- Wait some time.
+-- @tparam number seconds The time to wait.
+-- @function gears.async.sleep
+function async.sleep(seconds)
+    async.await(function(resume)
+        local source = glib.timeout_add(glib.PRIORITY_DEFAULT, math.ceil(seconds * 1000), function()
+            resume()
+            return false
+        end)
+        return function() glib.source_remove(source) end
+    end)
+end
+
+--- Wait for another task to end.
+-- @tparam gears.async.task other The task.
+-- @treturn string The status of the task.
+-- @return The values returned by the task.
+-- @function gears.async.wait
+function async.wait(other)
+    if not other:is_finished() then
+        async.await(function(resume)
+            other:on_finished(function() resume() end)
+        end)
+    end
+    return other.status, other:get_result()
+end
+
+--- Spawn a command and wait for it to exit.
+-- The command is terminated when the task is cancelled.
+-- @tparam string|table cmd The command, as for `awful.spawn`.
+-- @treturn string|nil The output on stdout, or nil if the command could not
+--   be started.
+-- @treturn string The output on stderr, or the error message.
+-- @treturn string The exit reason (`"exit"` or `"signal"`).
+-- @treturn integer The exit code or signal number.
+-- @function gears.async.spawn
+function async.spawn(cmd)
+    return async.await(function(resume)
+        local stdout, stderr, reason, code
+        local pending = 3
+        local function step_done()
+            pending = pending - 1
+            if pending == 0 then
+                resume(stdout, stderr, reason, code)
+            end
+        end
+
+        local pid, _, _, stdout_fd, stderr_fd = capi.awesome.spawn(cmd, false, false, true, true,
+            function(r, c)
+                reason, code = r, c
+                step_done()
+            end)
+        if type(pid) == "string" then
+            resume(nil, pid)
+            return
+        end
+
+        capi.awesome.spawn_read(stdout_fd, nil, function(output)
+            stdout = output
+            step_done()
+        end)
+        capi.awesome.spawn_read(stderr_fd, nil, function(output)
+            stderr = output
+            step_done()
+        end)
+        return function()
+            if reason == nil then
+                capi.awesome.kill(pid, 15)
+            end
+        end
+    end)
+end
+
+-- Start a Gio operation with a cancellable and wait for it.
+local function await_gio(start_op)
+    return async.await(function(resume)
+        local cancellable = gio.Cancellable()
+        start_op(cancellable, resume)
+        return function() cancellable:cancel() end
+    end)
+end
+
+--- Read a file.
+-- @tparam string path The path of the file.
+-- @treturn string|nil The contents of the file, or nil on error.
+-- @treturn string|nil The error message.
+-- @function gears.async.read
+function async.read(path)
+    return await_gio(function(cancellable, resume)
+        gio.File.new_for_path(path):load_contents_async(cancellable, function(file, res)
+            local ok, contents = file:load_contents_finish(res)
+            if ok then
+                resume(contents)
+            else
+                resume(nil, tostring(contents))
+            end
+        end)
+    end)
+end
+
+--- Call a D-Bus method.
+-- @tparam table args
+-- @tparam[opt="session"] string args.bus `"session"` or `"system"`.
+-- @tparam string args.name The bus name of the peer.
+-- @tparam string args.path The object path.
+-- @tparam string args.interface The interface of the method.
+-- @tparam string args.method The method.
+-- @tparam[opt] GLib.Variant args.args A tuple with the arguments.
+-- @tparam[opt] string args.reply_type The type of the reply, e.g. `"(s)"`.
+-- @tparam[opt=-1] number args.timeout The timeout in seconds, -1 for the
+--   default one.
+-- @treturn GLib.Variant|nil The reply, or nil on error.
+-- @treturn string|nil The error message.
+-- @function gears.async.dbus_call
+function async.dbus_call(args)
+    local bus = (args.bus or "session"):upper()
+    local conn, err = await_gio(function(cancellable, resume)
+        gio.bus_get(gio.BusType[bus], cancellable, function(_, res)
+            local c, e = gio.bus_get_finish(res)
+            resume(c, e and tostring(e))
+        end)
+    end)
+    if not conn then
+        return nil, err
+    end
+
+    local timeout = args.timeout or -1
+    return await_gio(function(cancellable, resume)
+        conn:call(args.name, args.path, args.interface, args.method, args.args,
+                  args.reply_type and glib.VariantType.new(args.reply_type),
+                  gio.DBusCallFlags.NONE, timeout < 0 and -1 or timeout * 1000,
+                  cancellable, function(c, res)
+            local reply, e = c:call_finish(res)
+            resume(reply, e and tostring(e))
+        end)
+    end)
+end
+
+local group = {}
+group.__index = group
+
+--- Create a group of tasks.
+--
+-- The policy decides what happens to a task started while `limit` tasks
+-- of the group run:
+--
+--  * `"queue"`: It waits until one of them ended.
+--  * `"coalesce"`: It waits, but replaces any other waiting task.
+--  * `"replace"`: The oldest running task is cancelled and it starts right
+--    away.
+--
+-- @tparam table args
+-- @tparam[opt=1] integer args.limit How many tasks may run at the same time.
+-- @tparam[opt="queue"] string args.policy `"queue"`, `"coalesce"` or
+--   `"replace"`.
+-- @treturn gears.async.group The group.
+-- @function gears.async.group
+function async.group(args)
+    args = args or {}
+    local policy = args.policy or "queue"
+    assert(policy == "queue" or policy == "coalesce" or policy == "replace",
+           "invalid policy: " .. tostring(policy))
+    return setmetatable({
+        limit = args.limit or 1,
+        policy = policy,
+        running = {},
+        queued = {},
+    }, group)
+end
+
+local function group_dispatch(self)
+    while #self.running < self.limit and #self.queued > 0 do
+        local t = table.remove(self.queued, 1)
+        if t.status == "pending" then
+            table.insert(self.running, t)
+            start(t)
+        end
+    end
+end
+
+-- Cancel tasks of a list, which changes while doing so
+local function cancel_all(list)
+    for _, t in ipairs({ unpack(list) }) do
+        t:cancel()
+    end
+end
+
+local function group_remove(list, t)
+    for i, v in ipairs(list) do
+        if v == t then
+            table.remove(list, i)
+            return
+        end
+    end
+end
+
+--- Start a task in the group.
+-- @tparam function func The function to run.
+-- @param ... Arguments to the function.
+-- @treturn gears.async.task The task, which might still be pending.
+-- @method run
+function group:run(func, ...)
+    local t = new_task(func, ...)
+    t:on_finished(function()
+        group_remove(self.running, t)
+        group_remove(self.queued, t)
+        group_dispatch(self)
+    end)
+
+    if #self.running >= self.limit and self.policy ~= "queue" then
+        cancel_all(self.queued)
+    end
+    table.insert(self.queued, t)
+
+    if #self.running >= self.limit and self.policy == "replace" then
+        -- This frees a slot once the task ended, which starts the new one
+        self.running[1]:cancel()
+    else
+        group_dispatch(self)
+    end
+    return t
+end
+
+--- Cancel all tasks of the group.
+-- @method cancel
+function group:cancel()
+    cancel_all(self.queued)
+    cancel_all(self.running)
+end
+
+return async
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
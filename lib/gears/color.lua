@@ -58,6 +58,37 @@ local surface = require("gears.surface")
 local color = { mt = {} }
 local pattern_cache
 
+-- A cache which keeps at least the last `size` and at most the last `2 * size`
+-- used entries. When the recent generation is full, it becomes the old one
+-- and entries which are used again are moved back to the recent generation.
+local function bounded_cache(size)
+    return { size = size, count = 0, recent = {}, old = {} }
+end
+
+local function bounded_cache_set(cache, key, value)
+    if cache.count >= cache.size then
+        cache.old, cache.recent, cache.count = cache.recent, {}, 0
+    end
+    cache.recent[key] = value
+    cache.count = cache.count + 1
+end
+
+local function bounded_cache_get(cache, key)
+    local value = cache.recent[key]
+    if value == nil then
+        value = cache.old[key]
+        if value ~= nil then
+            cache.old[key] = nil
+            bounded_cache_set(cache, key, value)
+        end
+    end
+    return value
+end
+
+-- Caches for colors and patterns given as strings
+local parsed_colors = bounded_cache(256)
+local string_patterns = bounded_cache(256)
+
 --- Parse a HTML-color.
 -- This function can parse colors like `#rrggbb` and `#rrggbbaa` and also `red`.
 -- Max 4 chars per channel.
@@ -68,11 +99,32 @@ local pattern_cache
 -- @usage -- This will return 0, 1, 0, 1
 -- gears.color.parse_color("#00ff00ff")
 function color.parse_color(col)
-    local rgb = {}
+    local rgb = bounded_cache_get(parsed_colors, col)
+    if rgb then
+        return unpack(rgb)
+    end
+
+    rgb = {}
     if string.match(col, "^#%x+$") then
         local hex_str = col:sub(2, #col)
         local channels
-        if #hex_str % 3 == 0 then
+        if #hex_str == 6 or #hex_str == 8 then
+            -- The usual #rrggbb and #rrggbbaa, parsed as a single number
+            local num = tonumber(hex_str, 16)
+            local alpha = 0xff
+            if #hex_str == 8 then
+                alpha = num % 0x100
+                num = math.floor(num / 0x100)
+            end
+            rgb = {
+                math.floor(num / 0x10000) / 0xff,
+                math.floor(num / 0x100) % 0x100 / 0xff,
+                num % 0x100 / 0xff,
+                alpha / 0xff
+            }
+            bounded_cache_set(parsed_colors, col, rgb)
+            return unpack(rgb)
+        elseif #hex_str % 3 == 0 then
             channels = 3
         elseif #hex_str % 4 == 0 then
             channels = 4
@@ -104,6 +156,7 @@ function color.parse_color(col)
         }
     end
     assert(#rgb == 4, col)
+    bounded_cache_set(parsed_colors, col, rgb)
     return unpack(rgb)
 end
 
@@ -277,7 +330,16 @@ function color.create_pattern(col)
     if cairo.Pattern:is_type_of(col) then
         return col
     end
-    return pattern_cache:get(col or "#000000")
+    col = col or "#000000"
+    if type(col) == "string" then
+        local pattern = bounded_cache_get(string_patterns, col)
+        if not pattern then
+            pattern = color.create_pattern_uncached(col)
+            bounded_cache_set(string_patterns, col, pattern)
+        end
+        return pattern
+    end
+    return pattern_cache:get(col)
 end
 
 --- Check if a pattern is opaque.
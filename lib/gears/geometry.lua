@@ -240,6 +240,62 @@ function gears.geometry.rectangle.area_remove(areas, elem)
     return areas
 end
 
+local function area_contains(a, b)
+    return b.x >= a.x and b.y >= a.y
+        and b.x + b.width <= a.x + a.width
+        and b.y + b.height <= a.y + a.height
+end
+
+--- Get the free space of an area after removing some rectangles from it.
+-- Like repeatedly calling `area_remove`, the result is a list of possibly
+-- overlapping rectangles covering the free space. Only maximal rectangles are
+-- kept: no rectangle in the result is contained in another one. This keeps
+-- the list short instead of growing with every removed rectangle.
+-- @tparam table area The area to start from.
+-- @tparam table elems A list of rectangles to remove.
+-- @treturn table The list of free rectangles.
+function gears.geometry.rectangle.free_areas(area, elems)
+    local areas = {{ x = area.x, y = area.y, width = area.width, height = area.height }}
+    for _, elem in ipairs(elems) do
+        local kept, added = {}, {}
+        for _, r in ipairs(areas) do
+            if gears.geometry.rectangle.area_intersect_area(r, elem) then
+                for _, piece in ipairs(gears.geometry.rectangle.area_remove({ r }, elem)) do
+                    table.insert(added, piece)
+                end
+            else
+                table.insert(kept, r)
+            end
+        end
+
+        -- No kept rectangle can be inside a new one, since the new ones are
+        -- inside the old rectangles they were split from. Drop the new ones
+        -- which are inside another rectangle, keeping one of equal ones.
+        areas = kept
+        for i, r in ipairs(added) do
+            local redundant = false
+            for _, other in ipairs(kept) do
+                if area_contains(other, r) then
+                    redundant = true
+                    break
+                end
+            end
+            for j = 1, #added do
+                if redundant then
+                    break
+                end
+                local other = added[j]
+                redundant = j ~= i and area_contains(other, r)
+                    and (j < i or not area_contains(r, other))
+            end
+            if not redundant then
+                table.insert(areas, r)
+            end
+        end
+    end
+    return areas
+end
+
 return gears.geometry
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
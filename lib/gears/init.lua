@@ -4,25 +4,27 @@
 -- @module gears
 ---------------------------------------------------------------------------
 
+local lazy_require = require("gears.lazy_require")
 
-return
-{
-    color = require("gears.color");
-    debug = require("gears.debug");
-    object = require("gears.object");
-    surface = require("gears.surface");
-    wallpaper = require("gears.wallpaper");
-    timer = require("gears.timer");
-    cache = require("gears.cache");
-    matrix = require("gears.matrix");
-    shape = require("gears.shape");
-    protected_call = require("gears.protected_call");
-    geometry = require("gears.geometry");
-    math = require("gears.math");
-    table = require("gears.table");
-    string = require("gears.string");
-    sort = require("gears.sort");
-    filesystem = require("gears.filesystem");
-}
+return lazy_require({ lazy_require = lazy_require }, {
+    color = "gears.color";
+    debug = "gears.debug";
+    object = "gears.object";
+    surface = "gears.surface";
+    wallpaper = "gears.wallpaper";
+    timer = "gears.timer";
+    scheduler = "gears.scheduler";
+    async = "gears.async";
+    cache = "gears.cache";
+    matrix = "gears.matrix";
+    shape = "gears.shape";
+    protected_call = "gears.protected_call";
+    geometry = "gears.geometry";
+    math = "gears.math";
+    table = "gears.table";
+    string = "gears.string";
+    sort = "gears.sort";
+    filesystem = "gears.filesystem";
+})
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,52 @@
+---------------------------------------------------------------------------
+--- Require the submodules of a module table when they are first used.
+--
+-- This is used by the `init.lua` files of the libraries, so that e.g.
+-- `require("awful")` does not load `awful.menu` and everything it depends on
+-- before the configuration actually uses `awful.menu`.
+--
+-- Submodules which were not used yet are not returned by `pairs`.
+--
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+-- @module gears.lazy_require
+---------------------------------------------------------------------------
+
+local getmetatable = getmetatable
+local setmetatable = setmetatable
+local rawset = rawset
+local require = require
+local type = type
+
+--- Make a table require modules on first access.
+--
+-- Indexing `t` with a key of `modules` requires the module named by its value
+-- and stores it in `t`, so that it is only looked up once. An existing
+-- metatable of `t` is kept and its `__index` is used for all other keys.
+-- @tparam table t The module table.
+-- @tparam table modules A table mapping keys of `t` to module names.
+-- @treturn table The table `t`.
+-- @function gears.lazy_require
+local function lazy_require(t, modules)
+    local mt = getmetatable(t) or {}
+    local index = mt.__index
+
+    mt.__index = function(self, key)
+        local name = modules[key]
+        if name then
+            local module = require(name)
+            rawset(self, key, module)
+            return module
+        end
+        if type(index) == "function" then
+            return index(self, key)
+        end
+        return index and index[key]
+    end
+
+    return setmetatable(t, mt)
+end
+
+return lazy_require
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -12,6 +12,12 @@ local matrix = {}
 -- Metatable for matrix instances. This is set up near the end of the file.
 local matrix_mt = {}
 
+-- Most matrices in widget hierarchies only translate, so treat them specially.
+-- This also accepts cairo matrices.
+local function is_translation(m)
+    return m.xx == 1 and m.yx == 0 and m.xy == 0 and m.yy == 1
+end
+
 --- Create a new matrix instance
 -- @tparam number xx The xx transformation part.
 -- @tparam number yx The yx transformation part.
@@ -98,6 +104,9 @@ end
 -- @return A new matrix describing the inverse transformation.
 function matrix:invert()
     -- Beware of math! (I just copied the algorithm from cairo's source code)
+    if is_translation(self) then
+        return matrix.create_translate(-self.x0, -self.y0)
+    end
     local a, b, c, d, x0, y0 = self.xx, self.yx, self.xy, self.yy, self.x0, self.y0
     local inv_det = 1/(a*d - b*c)
     return matrix.create(inv_det * d, inv_det * -b,
@@ -113,6 +122,9 @@ end
 -- @tparam gears.matrix|cairo.Matrix other The other matrix to multiply with.
 -- @return The multiplication result.
 function matrix:multiply(other)
+    if is_translation(self) and is_translation(other) then
+        return matrix.create_translate(self.x0 + other.x0, self.y0 + other.y0)
+    end
     local ret = matrix.create(self.xx * other.xx + self.yx * other.xy,
         self.xx * other.yx + self.yx * other.yy,
         self.xy * other.xx + self.yy * other.xy,
@@ -129,12 +141,9 @@ end
 -- @tparam gears.matrix|cairo.Matrix other The matrix to compare with.
 -- @return True if this and the other matrix are equal.
 function matrix:equals(other)
-    for _, k in pairs{ "xx", "xy", "yx", "yy", "x0", "y0" } do
-        if self[k] ~= other[k] then
-            return false
-        end
-    end
-    return true
+    return rawequal(self, other) or (self.xx == other.xx and self.xy == other.xy
+        and self.yx == other.yx and self.yy == other.yy
+        and self.x0 == other.x0 and self.y0 == other.y0)
 end
 
 --- Get a string representation of this matrix
@@ -176,6 +185,10 @@ end
 -- @treturn number Width of the bounding rectangle.
 -- @treturn number Height of the bounding rectangle.
 function matrix:transform_rectangle(x, y, width, height)
+    if is_translation(self) and width >= 0 and height >= 0 then
+        return x + self.x0, y + self.y0, width, height
+    end
+
     -- Transform all four corners of the rectangle
     local x1, y1 = self:transform_point(x, y)
     local x2, y2 = self:transform_point(x, y + height)
@@ -118,26 +118,61 @@ end
 --   function receives the object as first argument and then any extra arguments
 --   that are given to emit_signal()
 function object:emit_signal(name, ...)
-    local sig = find_signal(self, name)
-    for func in pairs(sig.strong) do
-        func(self, ...)
-    end
-    for func in pairs(sig.weak) do
-        func(self, ...)
+    check(self)
+    -- Most signals are emitted without anything connected to them, do not
+    -- create their tables then
+    local sig = self._signals[name]
+    if sig then
+        for func in pairs(sig.strong) do
+            func(self, ...)
+        end
+        for func in pairs(sig.weak) do
+            func(self, ...)
+        end
+    else
+        assert(type(name) == "string", "name must be a string, got: " .. type(name))
     end
     for _, func in ipairs(self._global_receivers) do
         func(name, self, ...)
     end
 end
 
+-- Build "get_" .. key and "set_" .. key only once for every key, instead of
+-- on every property access. Strings are never collected from weak tables, so
+-- the tables are emptied once they hold too many names instead.
+local max_names = 1024
+local function make_names(prefix)
+    local count = 0
+    return setmetatable({}, {
+        __index = function(names, key)
+            if count >= max_names then
+                for k in pairs(names) do
+                    names[k] = nil
+                end
+                count = 0
+            end
+            local name = prefix .. key
+            names[key] = name
+            count = count + 1
+            return name
+        end
+    })
+end
+local getter_names = make_names("get_")
+local setter_names = make_names("set_")
+
 local function get_miss(self, key)
     local class = rawget(self, "_class")
+    local name = getter_names[key]
 
-    if rawget(self, "get_"..key) then
-        return rawget(self, "get_"..key)(self)
-    elseif class and class["get_"..key] then
-        return class["get_"..key](self)
+    local getter = rawget(self, name)
+    if getter then
+        return getter(self)
     elseif class then
+        getter = class[name]
+        if getter then
+            return getter(self)
+        end
         return class[key]
     end
 
@@ -145,11 +180,11 @@ end
 
 local function set_miss(self, key, value)
     local class = rawget(self, "_class")
+    local name = setter_names[key]
 
-    if rawget(self, "set_"..key) then
-        return rawget(self, "set_"..key)(self, value)
-    elseif class and class["set_"..key] then
-        return class["set_"..key](self, value)
+    local setter = rawget(self, name) or (class and class[name])
+    if setter then
+        return setter(self, value)
     elseif rawget(self, "_enable_auto_signals") then
         local changed = class[key] ~= value
         class[key] = value
@@ -157,8 +192,8 @@ local function set_miss(self, key, value)
         if changed then
             self:emit_signal("property::"..key, value)
         end
-    elseif (not rawget(self, "get_"..key))
-        and not (class and class["get_"..key]) then
+    elseif (not rawget(self, getter_names[key]))
+        and not (class and class[getter_names[key]]) then
         return rawset(self, key, value)
     else
         error("Cannot set '" .. tostring(key) .. "' on " .. tostring(self)
@@ -0,0 +1,200 @@
+---------------------------------------------------------------------------
+--- Run deferred work at the end of main loop iterations.
+--
+-- Work is queued with one of three priorities:
+--
+--  * `"before_paint"`: Run before drawing, in the same main loop iteration.
+--    All of it is run, however long it takes. `gears.timer.delayed_call` uses
+--    this priority.
+--  * `"after_paint"`: Run once drawing was sent to the X server, e.g. updates
+--    of widgets which are not needed to show the result of the user's action.
+--  * `"idle"`: Run after all `"after_paint"` work, e.g. writing caches.
+--
+-- `"after_paint"` and `"idle"` work only runs for `gears.scheduler.budget`
+-- seconds per main loop iteration and stops early when X events are waiting,
+-- so that a burst of queued work does not delay input. What is left runs in
+-- the next iterations, which happen right away instead of waiting for the
+-- next event. At least one function runs per iteration, so work cannot be
+-- starved by a flood of events.
+--
+-- Work with a key is only queued once: queuing it again replaces the
+-- function and arguments of the queued work, which keeps its place in the
+-- queue. A higher priority moves it to the end of that priority's queue.
+--
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+-- @module gears.scheduler
+---------------------------------------------------------------------------
+
+local capi = { awesome = awesome }
+local assert = assert
+local ipairs = ipairs
+local select = select
+local tostring = tostring
+local type = type
+local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
+local glib = require("lgi").GLib
+local protected_call = require("gears.protected_call")
+
+local scheduler = {}
+
+local priorities = { "before_paint", "after_paint", "idle" }
+local rank = {}
+for i, name in ipairs(priorities) do
+    rank[name] = i
+end
+
+--- The time in seconds the work of a priority may take per main loop
+-- iteration.
+--
+-- `before_paint` work cannot be limited, all of it is always run.
+-- @table gears.scheduler.budget
+-- @tfield number after_paint Defaults to 0.004.
+-- @tfield number idle Defaults to 0.004.
+scheduler.budget = {
+    after_paint = 0.004,
+    idle = 0.004,
+}
+
+-- Priority -> FIFO of work items { callback, args, n, priority, key }. Items
+-- are set to false when their work moved to another priority.
+local queues = {}
+for _, name in ipairs(priorities) do
+    queues[name] = { first = 1, last = 0 }
+end
+
+-- Key -> queued work item
+local keyed = {}
+
+local function now()
+    return glib.get_monotonic_time() / 1e6
+end
+
+local function push(priority, item)
+    local queue = queues[priority]
+    queue.last = queue.last + 1
+    queue[queue.last] = item
+end
+
+local function is_empty(queue)
+    return queue.first > queue.last
+end
+
+local function queue_work(priority, key, callback, ...)
+    assert(rank[priority], "invalid priority: " .. tostring(priority))
+    assert(type(callback) == "function", "callback must be a function, got: " .. type(callback))
+
+    local item = key ~= nil and keyed[key]
+    if item then
+        item.callback, item.args, item.n = callback, { ... }, select("#", ...)
+        if rank[priority] < rank[item.priority] then
+            local queue = queues[item.priority]
+            for i = queue.first, queue.last do
+                if queue[i] == item then
+                    queue[i] = false
+                    break
+                end
+            end
+            item.priority = priority
+            push(priority, item)
+        end
+        return
+    end
+
+    item = { callback = callback, args = { ... }, n = select("#", ...),
+             priority = priority, key = key }
+    if key ~= nil then
+        keyed[key] = item
+    end
+    push(priority, item)
+end
+
+--- Queue a function.
+-- @tparam string priority `"before_paint"`, `"after_paint"` or `"idle"`.
+-- @tparam function callback The function to call.
+-- @param ... Arguments to the function.
+-- @function gears.scheduler.queue
+function scheduler.queue(priority, callback, ...)
+    queue_work(priority, nil, callback, ...)
+end
+
+--- Queue a function unless work with the same key is already queued.
+-- @tparam string priority `"before_paint"`, `"after_paint"` or `"idle"`.
+-- @param key The key identifying the work, e.g. the object it updates.
+-- @tparam function callback The function to call.
+-- @param ... Arguments to the function.
+-- @function gears.scheduler.queue_unique
+function scheduler.queue_unique(priority, key, callback, ...)
+    assert(key ~= nil, "key must not be nil")
+    queue_work(priority, key, callback, ...)
+end
+
+--- Check if work is queued.
+-- @tparam[opt] string priority Only check this priority.
+-- @treturn boolean True if some work is queued.
+-- @function gears.scheduler.is_pending
+function scheduler.is_pending(priority)
+    if priority then
+        return not is_empty(queues[priority])
+    end
+    for _, name in ipairs(priorities) do
+        if not is_empty(queues[name]) then
+            return true
+        end
+    end
+    return false
+end
+
+-- Run the work of a priority, including work queued meanwhile. Limited work
+-- stops once the budget is used up or an event is waiting. Returns whether
+-- anything ran.
+local function run(priority, limited)
+    local queue = queues[priority]
+    local deadline = limited and now() + scheduler.budget[priority]
+    local ran = false
+
+    while not is_empty(queue) do
+        if ran and limited and (now() >= deadline or capi.awesome.has_pending_events()) then
+            break
+        end
+
+        local item = queue[queue.first]
+        queue[queue.first] = nil
+        queue.first = queue.first + 1
+
+        if item then
+            if item.key ~= nil then
+                keyed[item.key] = nil
+            end
+            ran = true
+            protected_call(item.callback, unpack(item.args, 1, item.n))
+        end
+    end
+
+    if is_empty(queue) then
+        queue.first, queue.last = 1, 0
+    end
+
+    return ran
+end
+
+capi.awesome.connect_signal("refresh", function()
+    run("before_paint", false)
+end)
+
+capi.awesome.connect_signal("refreshed", function()
+    local ran = run("after_paint", true)
+    if is_empty(queues.after_paint) then
+        ran = run("idle", true) or ran
+    end
+
+    -- The work might have changed what is shown, and what is left has to
+    -- run without waiting for the next event.
+    if ran or scheduler.is_pending() then
+        capi.awesome.request_refresh()
+    end
+end)
+
+return scheduler
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -6,11 +6,13 @@
 
 local setmetatable = setmetatable
 local type = type
+local ipairs = ipairs
 local capi = { awesome = awesome }
 local cairo = require("lgi").cairo
 local GdkPixbuf = require("lgi").GdkPixbuf
 local color = nil
 local gdebug = require("gears.debug")
+local protected_call = require("gears.protected_call")
 local hierarchy = require("wibox.hierarchy")
 
 -- Keep this in sync with build-utils/lgi-check.c!
@@ -22,6 +24,72 @@ end
 local surface = { mt = {} }
 local surface_cache = setmetatable({}, { __mode = 'v' })
 
+--- The memory, in bytes, of the loaded images which are kept for later.
+-- Images loaded by file name stay cached as long as they are used anywhere.
+-- Up to this much memory of the most recently used ones is also kept when no
+-- longer used, so that showing them again does not decode them again.
+-- @tfield integer gears.surface.cache_budget
+surface.cache_budget = 32 * 1024 * 1024
+
+-- Least recently used list of the kept images, most recent first. Every node
+-- is { key = ..., surface = ..., bytes = ..., prev = ..., next = ... }.
+local lru = { nodes = {}, bytes = 0 }
+
+local function lru_unlink(node)
+    if node.prev then node.prev.next = node.next else lru.head = node.next end
+    if node.next then node.next.prev = node.prev else lru.tail = node.prev end
+    node.prev, node.next = nil, nil
+    lru.nodes[node.key] = nil
+    lru.bytes = lru.bytes - node.bytes
+end
+
+-- Mark a cached surface as used.
+local function lru_touch(key, surf)
+    local node = lru.nodes[key]
+    if node then
+        if node.surface == surf and lru.head == node then
+            return
+        end
+        lru_unlink(node)
+    end
+
+    local bytes = 0
+    if cairo.ImageSurface:is_type_of(surf) then
+        bytes = surf.stride * surf.height
+    end
+    node = { key = key, surface = surf, bytes = bytes, next = lru.head }
+    if lru.head then lru.head.prev = node else lru.tail = node end
+    lru.head = node
+    lru.nodes[key] = node
+    lru.bytes = lru.bytes + bytes
+
+    while lru.bytes > surface.cache_budget and lru.tail do
+        lru_unlink(lru.tail)
+    end
+end
+
+-- The cache key of an image file decoded at a size.
+local function cache_key(path, width, height)
+    if not width and not height then
+        return path
+    end
+    return path .. "\0" .. (width or "") .. "x" .. (height or "")
+end
+
+-- Get an image file from the cache.
+local function cache_get(key)
+    local cached = surface_cache[key]
+    if cached then
+        lru_touch(key, cached)
+    end
+    return cached
+end
+
+local function cache_put(key, surf)
+    surface_cache[key] = surf
+    lru_touch(key, surf)
+end
+
 local function get_default(arg)
     if type(arg) == 'nil' then
         return cairo.ImageSurface(cairo.Format.ARGB32, 0, 0)
@@ -74,20 +142,98 @@ end
 -- @return An error message, or nil on success
 function surface.load_silently(_surface, default)
     if type(_surface) == "string" then
-        local cache = surface_cache[_surface]
+        local cache = cache_get(_surface)
         if cache then
             return cache
         end
         local result, err = surface.load_uncached_silently(_surface, default)
         if not err then
             -- Cache the file
-            surface_cache[_surface] = result
+            cache_put(_surface, result)
         end
         return result, err
     end
     return surface.load_uncached_silently(_surface, default)
 end
 
+-- Key -> list of callbacks waiting for the image
+local pending_loads = {}
+
+-- Scale an image to fit into width x height, keeping its aspect ratio, like
+-- the C core does when it decodes an image at a size.
+local function scale_to_fit(surf, width, height)
+    local w, h = surface.get_size(surf)
+    local scale = math.min((width or 0) > 0 and width / w or math.huge,
+                           (height or 0) > 0 and height / h or math.huge)
+    if scale == math.huge then
+        return surf
+    end
+    local ret = cairo.ImageSurface(cairo.Format.ARGB32,
+                                   math.max(1, math.floor(w * scale + 0.5)),
+                                   math.max(1, math.floor(h * scale + 0.5)))
+    local cr = cairo.Context(ret)
+    cr:scale(scale, scale)
+    cr:set_source_surface(surf, 0, 0)
+    cr:paint()
+    return ret
+end
+
+--- Load an image file without blocking awesome.
+--
+-- The image is decoded by a worker thread and shares the cache of
+-- `surface.load`. The callback is called from the main loop once the image
+-- is ready, or right away if it was already cached. Several requests for the
+-- same image are only decoded once.
+-- @tparam string path The file name.
+-- @tparam function callback Called with the surface, or with nil and an
+--   error message.
+-- @tparam[opt] table args
+-- @tparam[opt] integer args.width The width to decode the image at. Vector
+--   images are rendered at this size. The aspect ratio is kept.
+-- @tparam[opt] integer args.height The height to decode the image at.
+-- @function gears.surface.load_async
+function surface.load_async(path, callback, args)
+    args = args or {}
+    local key = cache_key(path, args.width, args.height)
+    local cached = cache_get(key)
+    if cached then
+        return callback(cached)
+    end
+
+    if pending_loads[key] then
+        table.insert(pending_loads[key], callback)
+        return
+    end
+
+    if not capi.awesome.load_image_async then
+        -- Without the C core (e.g. in the unit tests), decode right away
+        local result, err = surface.load_silently(path, false)
+        if not result then
+            return callback(nil, err)
+        end
+        if args.width or args.height then
+            result = scale_to_fit(result, args.width, args.height)
+            cache_put(key, result)
+        end
+        return callback(result)
+    end
+
+    pending_loads[key] = { callback }
+    capi.awesome.load_image_async(path, function(ptr, err)
+        local callbacks = pending_loads[key]
+        pending_loads[key] = nil
+
+        local result
+        if ptr then
+            result = cairo.Surface(ptr, true)
+            cache_put(key, result)
+        end
+        for _, cb in ipairs(callbacks) do
+            protected_call(cb, result, err)
+        end
+    end, args.width, args.height)
+end
+
 local function do_load_and_handle_errors(_surface, func)
     if type(_surface) == 'nil' then
         return get_default()
@@ -53,13 +53,14 @@ local capi = { awesome = awesome }
 local ipairs = ipairs
 local pairs = pairs
 local setmetatable = setmetatable
+local math = math
 local table = table
 local tonumber = tonumber
 local traceback = debug.traceback
-local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
 local glib = require("lgi").GLib
 local object = require("gears.object")
 local protected_call = require("gears.protected_call")
+local scheduler = require("gears.scheduler")
 
 --- Timer objects. This type of object is useful when triggering events repeatedly.
 -- The timer will emit the "timeout" signal every N seconds, N being the timeout
@@ -67,6 +68,8 @@ local protected_call = require("gears.protected_call")
 -- to enable garbage collection.
 -- @tfield number timeout Interval in seconds to emit the timeout signal.
 --   Can be any value, including floating point ones (e.g. 1.5 seconds).
+-- @tfield number slack How late in seconds the timeout signal may be emitted,
+--   so that it can happen together with other timers.
 -- @tfield boolean started Read-only boolean field indicating if the timer has been
 --   started.
 -- @table timer
@@ -82,16 +85,86 @@ local protected_call = require("gears.protected_call")
 
 local timer = { mt = {} }
 
+-- Timers with a slack share a single GLib source instead of waking up the main
+-- loop on their own. It fires when the first of them cannot be delayed any
+-- longer and then runs every timer which is due, so that timers with similar
+-- deadlines all run in the same main loop iteration.
+local slack_timers = {}
+local slack_source, slack_wakeup
+
+local function monotonic_time()
+    return glib.get_monotonic_time() / 1000000
+end
+
+local schedule_slack_timers
+
+local function run_slack_timers()
+    slack_source, slack_wakeup = nil, nil
+
+    local now = monotonic_time()
+    local due = {}
+    for t in pairs(slack_timers) do
+        if t.data.deadline <= now then
+            table.insert(due, t)
+        end
+    end
+    table.sort(due, function(a, b) return a.data.deadline < b.data.deadline end)
+
+    for _, t in ipairs(due) do
+        -- A previous callback might have stopped or restarted the timer.
+        if slack_timers[t] and t.data.deadline <= now then
+            -- Keep the period, unless the timer fell too much behind.
+            t.data.deadline = t.data.deadline + t.data.timeout
+            if t.data.deadline <= now then
+                t.data.deadline = now + t.data.timeout
+            end
+            protected_call(t.emit_signal, t, "timeout")
+        end
+    end
+
+    schedule_slack_timers()
+    return false
+end
+
+function schedule_slack_timers()
+    local wakeup
+    for t in pairs(slack_timers) do
+        local latest = t.data.deadline + t.data.slack
+        if not wakeup or latest < wakeup then
+            wakeup = latest
+        end
+    end
+
+    if slack_source and wakeup == slack_wakeup then return end
+    if slack_source then
+        glib.source_remove(slack_source)
+        slack_source = nil
+    end
+
+    slack_wakeup = wakeup
+    if wakeup then
+        local delay = math.max(0, math.ceil((wakeup - monotonic_time()) * 1000))
+        slack_source = glib.timeout_add(glib.PRIORITY_DEFAULT, delay, run_slack_timers)
+    end
+end
+
 --- Start the timer.
 function timer:start()
     if self.data.source_id ~= nil then
         print(traceback("timer already started"))
         return
     end
-    self.data.source_id = glib.timeout_add(glib.PRIORITY_DEFAULT, self.data.timeout * 1000, function()
-        protected_call(self.emit_signal, self, "timeout")
-        return true
-    end)
+    if self.data.slack > 0 then
+        self.data.source_id = false
+        self.data.deadline = monotonic_time() + self.data.timeout
+        slack_timers[self] = true
+        schedule_slack_timers()
+    else
+        self.data.source_id = glib.timeout_add(glib.PRIORITY_DEFAULT, self.data.timeout * 1000, function()
+            protected_call(self.emit_signal, self, "timeout")
+            return true
+        end)
+    end
     self:emit_signal("start")
 end
 
@@ -101,7 +174,12 @@ function timer:stop()
         print(traceback("timer not started"))
         return
     end
-    glib.source_remove(self.data.source_id)
+    if slack_timers[self] then
+        slack_timers[self] = nil
+        schedule_slack_timers()
+    else
+        glib.source_remove(self.data.source_id)
+    end
     self.data.source_id = nil
     self:emit_signal("stop")
 end
@@ -125,10 +203,20 @@ end
 -- @property timeout
 -- @param number
 
+--- How late the timeout may happen, in seconds.
+-- A timer with a slack can be delayed up to this long so that it runs together
+-- with other timers instead of waking up awesome on its own. This takes effect
+-- when the timer is started.
+-- **Signal:** property::slack
+-- @property slack
+-- @param number
+
 local timer_instance_mt = {
     __index = function(self, property)
         if property == "timeout" then
             return self.data.timeout
+        elseif property == "slack" then
+            return self.data.slack
         elseif property == "started" then
             return self.data.source_id ~= nil
         end
@@ -140,6 +228,9 @@ local timer_instance_mt = {
         if property == "timeout" then
             self.data.timeout = tonumber(value)
             self:emit_signal("property::timeout")
+        elseif property == "slack" then
+            self.data.slack = tonumber(value) or 0
+            self:emit_signal("property::slack")
         end
     end
 }
@@ -152,13 +243,15 @@ local timer_instance_mt = {
 -- @tparam[opt=nil] function args.callback Callback function to connect to the
 --  "timeout" signal.
 -- @tparam[opt=false] boolean args.single_shot Run only once then stop.
+-- @tparam[opt=0] number args.slack How late in seconds the timeout may happen,
+--  so that it runs together with other timers.
 -- @treturn timer
 -- @function gears.timer
 function timer.new(args)
     args = args or {}
     local ret = object()
 
-    ret.data = { timeout = 0 } --TODO v5 rename to ._private
+    ret.data = { timeout = 0, slack = 0 } --TODO v5 rename to ._private
     setmetatable(ret, timer_instance_mt)
 
     for k, v in pairs(args) do
@@ -225,21 +318,14 @@ function timer.weak_start_new(timeout, callback)
     end)
 end
 
-local delayed_calls = {}
-capi.awesome.connect_signal("refresh", function()
-    for _, callback in ipairs(delayed_calls) do
-        protected_call(unpack(callback))
-    end
-    delayed_calls = {}
-end)
-
 --- Call the given function at the end of the current main loop iteration
+-- This is `gears.scheduler.queue` with the `"before_paint"` priority.
 -- @tparam function callback The function that should be called
 -- @param ... Arguments to the callback function
 -- @function gears.timer.delayed_call
+-- @see gears.scheduler
 function timer.delayed_call(callback, ...)
-    assert(type(callback) == "function", "callback must be a function, got: " .. type(callback))
-    table.insert(delayed_calls, { callback, ... })
+    scheduler.queue("before_paint", callback, ...)
 end
 
 function timer.mt.__call(_, ...)
@@ -18,18 +18,26 @@
 --
 --     gears.wallpaper.maximized("path/to/image.png", s)
 --
+-- Setting the wallpaper of one screen only replaces its area of the wallpaper.
+-- Setting the same image file with the same arguments on a screen again does
+-- nothing while the file was not changed, so it is cheap to set the
+-- wallpapers of all screens whenever one of them changes.
+--
 -- @author Uli Schlachter
 -- @copyright 2012 Uli Schlachter
 -- @module gears.wallpaper
 ---------------------------------------------------------------------------
 
 local cairo = require("lgi").cairo
+local Gio = require("lgi").Gio
 local color = require("gears.color")
 local surface = require("gears.surface")
 local timer = require("gears.timer")
 local debug = require("gears.debug")
 local root = root
 
+local capi = { awesome = awesome }
+
 local wallpaper = { mt = {} }
 
 local function root_geometry()
@@ -37,68 +45,273 @@ local function root_geometry()
     return { x = 0, y = 0, width = width, height = height }
 end
 
--- Information about a pending wallpaper change, see prepare_context()
+-- Information about a pending wallpaper change of all screens, see
+-- prepare_context()
 local pending_wallpaper = nil
 
+-- Pending changes of single screens, a list of tables with the surface for the
+-- area and its geometry
+local pending_screens = {}
+
+local flush_scheduled = false
+
+-- What the functions below have drawn to each screen, to skip drawing the same
+-- again. Drawing anything else through prepare_context() forgets it.
+local drawn = setmetatable({}, { __mode = "k" })
+
+-- Is the wallpaper being set by this module?
+local setting = false
+
+capi.awesome.connect_signal("wallpaper_changed", function()
+    if not setting then
+        -- Someone else set a wallpaper
+        drawn = setmetatable({}, { __mode = "k" })
+    end
+end)
+
 local function get_screen(s)
     return s and screen[s]
 end
 
---- Prepare the needed state for setting a wallpaper.
--- This function returns a cairo context through which a wallpaper can be drawn.
--- The context is only valid for a short time and should not be saved in a
--- global variable.
--- @param s The screen to set the wallpaper on or nil for all screens
--- @return[1] The available geometry (table with entries width and height)
--- @return[1] A cairo context that the wallpaper should be drawn to
-function wallpaper.prepare_context(s)
-    s = get_screen(s)
+local function intersects(a, b)
+    return a.x < b.x + b.width and b.x < a.x + a.width
+        and a.y < b.y + b.height and b.y < a.y + a.height
+end
+
+-- Forget what was drawn to all screens overlapping geom
+local function forget_drawn(geom)
+    for s, entry in pairs(drawn) do
+        if intersects(entry.geometry, geom) then
+            drawn[s] = nil
+        end
+    end
+end
 
+-- Get a string telling apart the versions of a file, or nil if it cannot be
+-- read
+local function file_version(path)
+    local info = Gio.File.new_for_path(path):query_info(
+        "standard::size,time::modified,time::modified-usec", Gio.FileQueryInfoFlags.NONE)
+    return info and info:get_size() .. "," .. info:get_attribute_uint64("time::modified")
+        .. "." .. info:get_attribute_uint32("time::modified-usec")
+end
+
+-- Get a key for a wallpaper drawn with the given arguments. Only wallpapers
+-- loaded from files and drawn with plain arguments are remembered. The key
+-- changes when the file is changed.
+local function cache_key(name, surf, ...)
+    if type(surf) ~= "string" then
+        return nil
+    end
+    local version = file_version(surf)
+    if not version then
+        return nil
+    end
+    local parts = { name, surf, version }
+    for i = 1, select("#", ...) do
+        local arg = select(i, ...)
+        if type(arg) == "table" and arg.x and arg.y then
+            arg = arg.x .. "," .. arg.y
+        elseif type(arg) == "table" or type(arg) == "userdata" then
+            return nil
+        end
+        table.insert(parts, tostring(arg))
+    end
+    return table.concat(parts, "\0")
+end
+
+-- Is the wallpaper with this key already drawn to the screen?
+local function is_drawn(s, key)
+    local entry = s and key and drawn[s]
+    if not entry or entry.key ~= key then
+        return false
+    end
+    local geom, old = s.geometry, entry.geometry
+    return geom.x == old.x and geom.y == old.y
+        and geom.width == old.width and geom.height == old.height
+end
+
+local function set_drawn(s, key)
+    if s and key then
+        local geom = s.geometry
+        drawn[s] = {
+            key = key,
+            geometry = { x = geom.x, y = geom.y, width = geom.width, height = geom.height },
+        }
+    end
+end
+
+local function set_root_wallpaper(...)
+    setting = true
+    local ok, result = pcall(root.wallpaper, ...)
+    setting = false
+    if not ok then
+        error(result, 0)
+    end
+    return result
+end
+
+-- Paint pending screens to the surface of a change of all screens
+local function paint_screens(cr, screens)
+    cr:save()
+    cr.operator = cairo.Operator.SOURCE
+    for _, area in ipairs(screens) do
+        local geom = area.geometry
+        cr:set_source_surface(area.surface, geom.x, geom.y)
+        cr:rectangle(geom.x, geom.y, geom.width, geom.height)
+        cr:fill()
+        area.surface:finish()
+    end
+    cr:restore()
+end
+
+local get_full_target
+
+local function flush()
+    flush_scheduled = false
+
+    local screens = pending_screens
+    pending_screens = {}
+    for i, area in ipairs(screens) do
+        local geom = area.geometry
+        local pattern = cairo.Pattern.create_for_surface(area.surface)
+        if not set_root_wallpaper(pattern._native, geom.x, geom.y, geom.width, geom.height) then
+            -- The root window changed, set a wallpaper for all screens
+            for j = i, #screens do
+                table.insert(pending_screens, screens[j])
+            end
+            get_full_target()
+            break
+        end
+        area.surface:finish()
+    end
+
+    if pending_wallpaper then
+        local paper = pending_wallpaper
+        pending_wallpaper = nil
+        set_root_wallpaper(cairo.Pattern.create_for_surface(paper.surface)._native)
+        paper.surface:finish()
+    end
+end
+
+local function schedule_flush()
+    if not flush_scheduled then
+        flush_scheduled = true
+        timer.delayed_call(flush)
+    end
+end
+
+-- Get the surface of a pending change of all screens
+function get_full_target()
     local root_width, root_height = root.size()
-    local geom = s and s.geometry or root_geometry()
-    local source, target, cr
+    local source, target
 
     if not pending_wallpaper then
         -- Prepare a pending wallpaper
         source = surface(root.wallpaper())
         target = source:create_similar(cairo.Content.COLOR, root_width, root_height)
-
-        -- Set the wallpaper (delayed)
-        timer.delayed_call(function()
-            local paper = pending_wallpaper
-            pending_wallpaper = nil
-            wallpaper.set(paper.surface)
-            paper.surface:finish()
-        end)
     elseif root_width > pending_wallpaper.width or root_height > pending_wallpaper.height then
         -- The root window was resized while a wallpaper is pending
         source = pending_wallpaper.surface
         target = source:create_similar(cairo.Content.COLOR, root_width, root_height)
     else
         -- Draw to the already-pending wallpaper
-        source = nil
-        target = pending_wallpaper.surface
+        return pending_wallpaper.surface
     end
 
-    cr = cairo.Context(target)
+    local cr = cairo.Context(target)
 
-    if source then
-        -- Copy the old wallpaper to the new one
-        cr:save()
-        cr.operator = cairo.Operator.SOURCE
-        cr:set_source_surface(source, 0, 0)
-        cr:paint()
-        cr:restore()
-    end
+    -- Copy the old wallpaper to the new one
+    cr:save()
+    cr.operator = cairo.Operator.SOURCE
+    cr:set_source_surface(source, 0, 0)
+    cr:paint()
+    cr:restore()
+
+    -- Pending changes of single screens are set with this one
+    paint_screens(cr, pending_screens)
+    pending_screens = {}
 
     pending_wallpaper = {
         surface = target,
         width = root_width,
         height = root_height
     }
+    schedule_flush()
+
+    return target
+end
+
+-- Get the surface of a pending change of a single screen, or nil if the whole
+-- wallpaper has to be set
+local function get_screen_target(geom)
+    if pending_wallpaper then
+        return nil
+    end
+
+    for _, area in ipairs(pending_screens) do
+        local old = area.geometry
+        if old.x == geom.x and old.y == geom.y
+            and old.width == geom.width and old.height == geom.height then
+            return area.surface
+        end
+    end
+
+    -- Only the area of a wallpaper covering the root window can be set
+    local current = root.wallpaper()
+    if not current then
+        return nil
+    end
+    current = surface(current)
+    local width, height = surface.get_size(current)
+    local root_width, root_height = root.size()
+    if width ~= root_width or height ~= root_height then
+        return nil
+    end
+
+    -- The area starts with the old wallpaper. The copy stays in the X server.
+    local target = current:create_similar(cairo.Content.COLOR, geom.width, geom.height)
+    local cr = cairo.Context(target)
+    cr.operator = cairo.Operator.SOURCE
+    cr:set_source_surface(current, -geom.x, -geom.y)
+    cr:paint()
+
+    table.insert(pending_screens, {
+        surface = target,
+        geometry = { x = geom.x, y = geom.y, width = geom.width, height = geom.height },
+    })
+    schedule_flush()
+
+    return target
+end
+
+--- Prepare the needed state for setting a wallpaper.
+-- This function returns a cairo context through which a wallpaper can be drawn.
+-- The context is only valid for a short time and should not be saved in a
+-- global variable.
+--
+-- When only one screen is drawn to, only its area of the wallpaper is
+-- replaced. The wallpaper of the other screens stays as it is.
+-- @param s The screen to set the wallpaper on or nil for all screens
+-- @return[1] The available geometry (table with entries width and height)
+-- @return[1] A cairo context that the wallpaper should be drawn to
+function wallpaper.prepare_context(s)
+    s = get_screen(s)
+
+    local geom = s and s.geometry or root_geometry()
+    local target = s and get_screen_target(geom)
+    local cr
+
+    forget_drawn(geom)
+
+    if target then
+        cr = cairo.Context(target)
+    else
+        cr = cairo.Context(get_full_target())
+        cr:translate(geom.x, geom.y)
+    end
 
     -- Only draw to the selected area
-    cr:translate(geom.x, geom.y)
     cr:rectangle(0, 0, geom.width, geom.height)
     cr:clip()
 
@@ -119,7 +332,8 @@ function wallpaper.set(pattern)
     if not cairo.Pattern:is_type_of(pattern) then
         error("wallpaper.set() called with an invalid argument")
     end
-    root.wallpaper(pattern._native)
+    drawn = setmetatable({}, { __mode = "k" })
+    set_root_wallpaper(pattern._native)
 end
 
 --- Set a centered wallpaper.
@@ -131,6 +345,12 @@ end
 -- @param scale The scale factor for the wallpaper. Default is 1 (original size).
 -- @see gears.color
 function wallpaper.centered(surf, s, background, scale)
+    s = get_screen(s)
+    local key = cache_key("centered", surf, background, scale)
+    if is_drawn(s, key) then
+        return
+    end
+
     local geom, cr = wallpaper.prepare_context(s)
     local original_surf = surf
     surf = surface.load_uncached(surf)
@@ -161,6 +381,8 @@ function wallpaper.centered(surf, s, background, scale)
     end
     if cr.status ~= "SUCCESS" then
         debug.print_warning("Cairo context entered error state: " .. cr.status)
+    else
+        set_drawn(s, key)
     end
 end
 
@@ -170,6 +392,12 @@ end
 --   all screens are set.
 -- @param offset This can be set to a table with entries x and y.
 function wallpaper.tiled(surf, s, offset)
+    s = get_screen(s)
+    local key = cache_key("tiled", surf, offset)
+    if is_drawn(s, key) then
+        return
+    end
+
     local _, cr = wallpaper.prepare_context(s)
 
     if offset then
@@ -188,6 +416,8 @@ function wallpaper.tiled(surf, s, offset)
     end
     if cr.status ~= "SUCCESS" then
         debug.print_warning("Cairo context entered error state: " .. cr.status)
+    else
+        set_drawn(s, key)
     end
 end
 
@@ -199,6 +429,12 @@ end
 --   The default is to honor the aspect ratio.
 -- @param offset This can be set to a table with entries x and y.
 function wallpaper.maximized(surf, s, ignore_aspect, offset)
+    s = get_screen(s)
+    local key = cache_key("maximized", surf, ignore_aspect, offset)
+    if is_drawn(s, key) then
+        return
+    end
+
     local geom, cr = wallpaper.prepare_context(s)
     local original_surf = surf
     surf = surface.load_uncached(surf)
@@ -228,6 +464,8 @@ function wallpaper.maximized(surf, s, ignore_aspect, offset)
     end
     if cr.status ~= "SUCCESS" then
         debug.print_warning("Cairo context entered error state: " .. cr.status)
+    else
+        set_drawn(s, key)
     end
 end
 
@@ -239,6 +477,12 @@ end
 --   gears.color. The default is black.
 -- @see gears.color
 function wallpaper.fit(surf, s, background)
+    s = get_screen(s)
+    local key = cache_key("fit", surf, background)
+    if is_drawn(s, key) then
+        return
+    end
+
     local geom, cr = wallpaper.prepare_context(s)
     local original_surf = surf
     surf = surface.load_uncached(surf)
@@ -266,6 +510,8 @@ function wallpaper.fit(surf, s, background)
     end
     if cr.status ~= "SUCCESS" then
         debug.print_warning("Cairo context entered error state: " .. cr.status)
+    else
+        set_drawn(s, key)
     end
 end
 
@@ -0,0 +1,78 @@
+---------------------------------------------------------------------------
+--- Cached listings of the directories searched for icons.
+--
+-- Looking up an icon means probing many theme directories for several file
+-- extensions. Instead of querying the filesystem for every candidate file,
+-- each directory is read once and the result is kept in memory until the
+-- directory's modification time changes.
+--
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+-- @module menubar.icon_index
+---------------------------------------------------------------------------
+
+local Gio = require("lgi").Gio
+
+local icon_index = {}
+
+-- Directory path -> { mtime = number, files = { [name] = true } }
+local listings = {}
+
+local function get_mtime(gfile)
+    local info = gfile:query_info("time::modified,time::modified-usec",
+                                  Gio.FileQueryInfoFlags.NONE)
+    return info and info:get_attribute_uint64("time::modified") * 1000000
+        + info:get_attribute_uint32("time::modified-usec")
+end
+
+local function read_directory(dir)
+    local gfile = Gio.File.new_for_path(dir)
+    local listing = { mtime = get_mtime(gfile), files = {} }
+
+    local enum = listing.mtime and gfile:enumerate_children(
+        "standard::name,standard::type", Gio.FileQueryInfoFlags.NONE)
+    if enum then
+        local info = enum:next_file()
+        while info do
+            if info:get_file_type() ~= "DIRECTORY" then
+                listing.files[info:get_name()] = true
+            end
+            info = enum:next_file()
+        end
+        enum:close()
+    end
+
+    return listing
+end
+
+--- Check if a directory contains a file.
+--
+-- Directories which do not exist or cannot be read contain no files.
+-- @tparam string dir The directory, without a trailing slash.
+-- @tparam string name The file name, without any directory part.
+-- @treturn boolean True if the file exists and is not a directory.
+-- @function menubar.icon_index.has_file
+function icon_index.has_file(dir, name)
+    local listing = listings[dir]
+    if not listing then
+        listing = read_directory(dir)
+        listings[dir] = listing
+    end
+    return listing.files[name] == true
+end
+
+--- Forget the listings of all directories which changed since they were read.
+--
+-- This checks the modification time of every directory read so far.
+-- @function menubar.icon_index.revalidate
+function icon_index.revalidate()
+    for dir, listing in pairs(listings) do
+        if get_mtime(Gio.File.new_for_path(dir)) ~= listing.mtime then
+            listings[dir] = nil
+        end
+    end
+end
+
+return icon_index
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -14,6 +14,7 @@ local beautiful = require("beautiful")
 local gfs = require("gears.filesystem")
 local GLib = require("lgi").GLib
 local index_theme = require("menubar.index_theme")
+local icon_index = require("menubar.icon_index")
 
 local ipairs = ipairs
 local setmetatable = setmetatable
@@ -150,10 +151,9 @@ local lookup_icon = function(self, icon_name, icon_size)
         for _, basedir in ipairs(self.base_directories) do
             for _, ext in ipairs(self.extensions) do
                 if directory_matches_size(self, subdir, icon_size) then
-                    local filename = string.format("%s/%s/%s/%s.%s",
-                                                   basedir, self.icon_theme_name, subdir,
-                                                   icon_name, ext)
-                    if gfs.file_readable(filename) then
+                    local dir = string.format("%s/%s/%s", basedir, self.icon_theme_name, subdir)
+                    local filename = string.format("%s/%s.%s", dir, icon_name, ext)
+                    if icon_index.has_file(dir, icon_name .. "." .. ext) then
                         return filename
                     else
                         checked_already[filename] = true
@@ -170,11 +170,10 @@ local lookup_icon = function(self, icon_name, icon_size)
         if dist < minimal_size then
             for _, basedir in ipairs(self.base_directories) do
                 for _, ext in ipairs(self.extensions) do
-                    local filename = string.format("%s/%s/%s/%s.%s",
-                                                   basedir, self.icon_theme_name, subdir,
-                                                   icon_name, ext)
+                    local dir = string.format("%s/%s/%s", basedir, self.icon_theme_name, subdir)
+                    local filename = string.format("%s/%s.%s", dir, icon_name, ext)
                     if not checked_already[filename] then
-                        if gfs.file_readable(filename) then
+                        if icon_index.has_file(dir, icon_name .. "." .. ext) then
                             closest_filename = filename
                             minimal_size = dist
                         end
@@ -207,11 +206,8 @@ end
 local lookup_fallback_icon = function(self, icon_name)
     for _, dir in ipairs(self.base_directories) do
         for _, ext in ipairs(self.extensions) do
-            local filename = string.format("%s/%s.%s",
-                                           dir,
-                                           icon_name, ext)
-            if gfs.file_readable(filename) then
-                return filename
+            if icon_index.has_file(dir, icon_name .. "." .. ext) then
+                return string.format("%s/%s.%s", dir, icon_name, ext)
             end
         end
     end
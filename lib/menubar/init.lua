@@ -21,6 +21,7 @@
 
 -- Grab environment we need
 local capi = {
+    awesome = awesome,
     client = client,
     mouse = mouse,
     screen = screen
@@ -32,8 +33,12 @@ local common = require("awful.widget.common")
 local theme = require("beautiful")
 local wibox = require("wibox")
 local gcolor = require("gears.color")
+local Gio = require("lgi").Gio
 local gstring = require("gears.string")
 local gdebug = require("gears.debug")
+local gtimer = require("gears.timer")
+local icon_index = require("menubar.icon_index")
+local search_index = require("menubar.search_index")
 
 local function get_screen(s)
     return s and capi.screen[s]
@@ -53,6 +58,12 @@ local compute_text_width = menubar.utils.compute_text_width
 -- @tfield[opt=true] boolean cache_entries
 menubar.cache_entries = true
 
+--- When true the directories with .desktop files are watched, and the
+-- entries are reloaded shortly after one of them changed. Only files directly
+-- in these directories are watched, not the ones in subdirectories.
+-- @tfield[opt=false] boolean watch_entries
+menubar.watch_entries = false
+
 --- When true the categories will be shown alongside application
 -- entries.
 -- @tfield[opt=true] boolean show_categories
@@ -99,6 +110,8 @@ local previous_item = nil
 local current_category = nil
 local shownitems = nil
 local instance = nil
+-- The search index over menubar.menu_entries
+local menu_index = nil
 
 local common_args = { w = wibox.layout.fixed.horizontal(),
                       data = setmetatable({}, { __mode = 'kv' }) }
@@ -127,29 +140,40 @@ local function label(o)
            o.icon
 end
 
+-- The use counts of the entries by name. The count file is only read once,
+-- and written back shortly after the counts changed.
+local count_table = nil
+local count_table_dirty = false
+local count_table_timer = nil
+
+local function get_count_file_name()
+    return gfs.get_cache_dir() .. "/menu_count_file"
+end
+
 local function load_count_table()
-    if instance.count_table then
-        return instance.count_table
+    if count_table then
+        return count_table
     end
-    instance.count_table = {}
-    local count_file_name = gfs.get_cache_dir() .. "/menu_count_file"
-    local count_file = io.open (count_file_name, "r")
+    count_table = {}
+    local count_file = io.open (get_count_file_name(), "r")
     if count_file then
         for line in count_file:lines() do
             local name, count = string.match(line, "([^;]+);([^;]+)")
-            if name ~= nil and count ~= nil then
-                instance.count_table[name] = count
+            if name ~= nil and tonumber(count) ~= nil then
+                count_table[name] = tonumber(count)
             end
         end
         count_file:close()
     end
-    return instance.count_table
+    return count_table
 end
 
-local function write_count_table(count_table)
-    count_table = count_table or instance.count_table
-    local count_file_name = gfs.get_cache_dir() .. "/menu_count_file"
-    local count_file = assert(io.open(count_file_name, "w"))
+local function write_count_table()
+    if not count_table_dirty then
+        return
+    end
+    count_table_dirty = false
+    local count_file = assert(io.open(get_count_file_name(), "w"))
     for name, count in pairs(count_table) do
         local str = string.format("%s;%d\n", name, count)
         count_file:write(str)
@@ -157,6 +181,20 @@ local function write_count_table(count_table)
     count_file:close()
 end
 
+local function schedule_count_table_write()
+    count_table_dirty = true
+    if not count_table_timer then
+        count_table_timer = gtimer {
+            timeout = 1,
+            single_shot = true,
+            callback = write_count_table,
+        }
+        -- Do not lose the last counts when awesome exits or restarts
+        capi.awesome.connect_signal("exit", write_count_table)
+    end
+    count_table_timer:again()
+end
+
 --- Perform an action for the given menu item.
 -- @param o The menu item.
 -- @return if the function processed the callback, new awful.prompt command, new awful.prompt prompt text.
@@ -170,13 +208,12 @@ local function perform_action(o)
         return true, "", new_prompt
     elseif shownitems[current_item].cmdline then
         awful.spawn(shownitems[current_item].cmdline)
-        -- load count_table from cache file
-        local count_table = load_count_table()
         -- increase count
+        local counts = load_count_table()
         local curname = shownitems[current_item].name
-        count_table[curname] = (count_table[curname] or 0) + 1
+        counts[curname] = (counts[curname] or 0) + 1
         -- write updated count table to cache file
-        write_count_table(count_table)
+        schedule_count_table_write()
         -- Let awful.prompt execute dummy exec_callback and
         -- done_callback to stop the keygrabber properly.
         return false
@@ -203,12 +240,22 @@ local function get_current_page(all_items, query, scr)
         menubar.right_label_width - menubar.left_label_width -
         compute_text_width(query, scr) - instance.prompt.width
 
+    -- Measure all items which were not measured yet in one go
+    local unmeasured, names = {}, {}
+    for _, item in ipairs(all_items) do
+        if not item.width then
+            table.insert(unmeasured, item)
+            names[#unmeasured] = item.name or ""
+        end
+    end
+    for i, width in ipairs(menubar.utils.compute_text_widths(names, scr)) do
+        local item = unmeasured[i]
+        item.width = width + (item.icon and instance.geometry.height or 0) + list_interspace
+    end
+
     local width_sum = 0
     local current_page = {}
     for i, item in ipairs(all_items) do
-        item.width = item.width or
-            compute_text_width(item.name, scr) +
-            (item.icon and instance.geometry.height or 0) + list_interspace
         if width_sum + item.width > available_space then
             if current_item < i then
                 table.insert(current_page, { name = menubar.right_label, icon = nil })
@@ -228,6 +275,10 @@ end
 -- @tparam number|screen scr Screen
 local function menulist_update(scr)
     local query = instance.query or ""
+    -- Only the previously shown entries can be focused
+    for _, v in ipairs(shownitems or {}) do
+        v.focused = false
+    end
     shownitems = {}
     local pattern = gstring.query_to_pattern(query)
 
@@ -239,7 +290,7 @@ local function menulist_update(scr)
     -- displayed first. Afterwards the non-category entries are added.
     -- All entries are weighted according to the number of times they
     -- have been executed previously (stored in count_table).
-    local count_table = load_count_table()
+    local counts = load_count_table()
     local command_list = {}
 
     local PRIO_NONE = 0
@@ -259,8 +310,8 @@ local function menulist_update(scr)
 
                     -- get use count from count_table if present
                     -- and use it as weight
-                    if string.len(pattern) > 0 and count_table[v.name] ~= nil then
-                        v.weight = tonumber(count_table[v.name])
+                    if string.len(pattern) > 0 and counts[v.name] ~= nil then
+                        v.weight = counts[v.name]
                     end
 
                     -- check for prefix match
@@ -277,36 +328,30 @@ local function menulist_update(scr)
         end
     end
 
-    -- Add the applications according to their name and cmdline
-    for _, v in ipairs(menubar.menu_entries) do
-        v.focused = false
+    -- Add the applications according to their name, generic name, keywords
+    -- and cmdline
+    if not menu_index or menu_index.entries ~= menubar.menu_entries then
+        menu_index = search_index.new(menubar.menu_entries)
+    end
+    local matches, prefix_matches = menu_index:search(query)
+    for _, v in ipairs(matches) do
         if not current_category or v.category == current_category then
+            v.weight = 0
 
-            -- check if the query matches either the name or the commandline
-            -- of some entry
-            if string.match(v.name, pattern)
-                or string.match(v.cmdline, pattern) then
+            -- get use count from count_table if present
+            -- and use it as weight
+            if string.len(query) > 0 and counts[v.name] ~= nil then
+                v.weight = counts[v.name]
+            end
 
-                v.weight = 0
+            -- increase default priority for prefix matches
+            if prefix_matches[v] then
+                v.prio = PRIO_NONE + 1
+            else
                 v.prio = PRIO_NONE
-
-                -- get use count from count_table if present
-                -- and use it as weight
-                if string.len(pattern) > 0 and count_table[v.name] ~= nil then
-                    v.weight = tonumber(count_table[v.name])
-                end
-
-                -- check for prefix match
-                if string.match(v.name, "^" .. pattern)
-                    or string.match(v.cmdline, "^" .. pattern) then
-                    -- increase default priority
-                    v.prio = PRIO_NONE + 1
-                else
-                    v.prio = PRIO_NONE
-                end
-
-                table.insert (command_list, v)
             end
+
+            table.insert (command_list, v)
         end
     end
 
@@ -339,10 +384,40 @@ local function menulist_update(scr)
                        get_current_page(shownitems, query, scr))
 end
 
+-- The Gio.FileMonitor of each watched directory
+local monitors = nil
+local monitor_timer = nil
+
+local function watch_menu_dirs()
+    monitors = {}
+    monitor_timer = gtimer {
+        timeout = 1,
+        single_shot = true,
+        callback = function() menubar.refresh() end,
+    }
+    for _, dir in ipairs(menubar.menu_gen.all_menu_dirs) do
+        local monitor = Gio.File.new_for_path(dir):monitor_directory(
+            Gio.FileMonitorFlags.NONE)
+        if monitor then
+            -- Reload once after a burst of changes, e.g. a package upgrade
+            function monitor.on_changed()
+                monitor_timer:again()
+            end
+            table.insert(monitors, monitor)
+        end
+    end
+end
+
 --- Refresh menubar's cache by reloading .desktop files.
+-- Only the .desktop files which changed since they were last parsed are read
+-- again.
 -- @tparam[opt] screen scr Screen.
 function menubar.refresh(scr)
     scr = get_screen(scr or awful.screen.focused() or 1)
+    if menubar.watch_entries and not monitors then
+        watch_menu_dirs()
+    end
+    icon_index.revalidate()
     menubar.menu_gen.generate(function(entries)
         menubar.menu_entries = entries
         if instance then
@@ -420,7 +495,6 @@ function menubar.show(scr)
             widget = common_args.w,
             prompt = awful.widget.prompt(),
             query = nil,
-            count_table = nil,
         }
         local layout = wibox.layout.fixed.horizontal()
         layout:add(instance.prompt)
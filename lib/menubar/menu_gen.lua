@@ -114,6 +114,8 @@ function menu_gen.generate(callback)
                         table.insert(result, { name = name,
                                      cmdline = cmdline,
                                      icon = icon,
+                                     generic_name = entry.GenericName,
+                                     keywords = entry.Keywords,
                                      category = target_category })
                         unique_entries[unique_key] = true
                     end
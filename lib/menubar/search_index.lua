@@ -0,0 +1,150 @@
+---------------------------------------------------------------------------
+--- In-memory search index over the menubar entries.
+--
+-- Every entry is searched by its name, generic name, keywords and command
+-- line. An index from all trigrams of these strings to the entries containing
+-- them limits the entries which have to be checked for a query. When a query
+-- extends the previous one, only the results of the previous query are
+-- checked, so typing a query character by character stays cheap.
+--
+-- Matching is case-insensitive and finds the query anywhere in the strings,
+-- like the pattern built by `gears.string.query_to_pattern`.
+--
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+-- @module menubar.search_index
+---------------------------------------------------------------------------
+
+local ipairs = ipairs
+local setmetatable = setmetatable
+
+local search_index = {}
+search_index.__index = search_index
+
+--- Create an index for a list of entries.
+--
+-- The entries are not copied, so the index has to be created again when an
+-- entry changes.
+-- @tparam table entries A list of entries with `name` and `cmdline` fields and
+--   optional `generic_name` and `keywords` fields.
+-- @treturn menubar.search_index The new index.
+-- @function menubar.search_index.new
+function search_index.new(entries)
+    local self = setmetatable({
+        entries = entries,
+        -- Lower-case strings all searches are done on, by entry index
+        names = {},
+        cmdlines = {},
+        texts = {},
+        -- Trigram -> ascending list of entry indices
+        trigrams = {},
+        -- Stack of { query = string, result = list of entry indices }, each
+        -- query extending the one below it
+        history = {},
+    }, search_index)
+
+    for i, entry in ipairs(entries) do
+        local name = (entry.name or ""):lower()
+        local cmdline = (entry.cmdline or ""):lower()
+        local parts = { name, cmdline, (entry.generic_name or ""):lower() }
+        for _, keyword in ipairs(entry.keywords or {}) do
+            table.insert(parts, keyword:lower())
+        end
+        local text = table.concat(parts, "\n")
+
+        self.names[i] = name
+        self.cmdlines[i] = cmdline
+        self.texts[i] = text
+
+        local trigrams = self.trigrams
+        for j = 1, #text - 2 do
+            local trigram = text:sub(j, j + 2)
+            local list = trigrams[trigram]
+            if not list then
+                trigrams[trigram] = { i }
+            elseif list[#list] ~= i then
+                list[#list + 1] = i
+            end
+        end
+    end
+
+    return self
+end
+
+-- Get the smallest list of entry indices which contains all matches of a
+-- lower-case query, or nil if all entries have to be checked.
+local function get_candidates(self, query)
+    local history = self.history
+
+    -- Drop the results of queries this one does not extend
+    while #history > 0 do
+        local top = history[#history]
+        if query:sub(1, #top.query) == top.query then
+            break
+        end
+        history[#history] = nil
+    end
+
+    local best = history[#history]
+    best = best and best.result
+
+    for j = 1, #query - 2 do
+        local list = self.trigrams[query:sub(j, j + 2)]
+        if not list then
+            return {}
+        end
+        if not best or #list < #best then
+            best = list
+        end
+    end
+
+    return best
+end
+
+--- Find the entries matching a query.
+-- @tparam string query The query.
+-- @treturn table The matching entries, in the order of the indexed list.
+-- @treturn table A set of the matching entries whose name or command line
+--   starts with the query.
+-- @method search
+function search_index:search(query)
+    query = (query or ""):lower()
+
+    local top = self.history[#self.history]
+    local result
+    if top and top.query == query then
+        result = top.result
+    else
+        local candidates = get_candidates(self, query)
+        result = {}
+        if candidates then
+            for _, i in ipairs(candidates) do
+                if self.texts[i]:find(query, 1, true) then
+                    result[#result + 1] = i
+                end
+            end
+        else
+            for i, text in ipairs(self.texts) do
+                if text:find(query, 1, true) then
+                    result[#result + 1] = i
+                end
+            end
+        end
+        table.insert(self.history, { query = query, result = result })
+    end
+
+    local matches, prefix = {}, {}
+    for k, i in ipairs(result) do
+        local entry = self.entries[i]
+        matches[k] = entry
+        if self.names[i]:sub(1, #query) == query
+            or self.cmdlines[i]:sub(1, #query) == query then
+            prefix[entry] = true
+        end
+    end
+    return matches, prefix
+end
+
+return search_index
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
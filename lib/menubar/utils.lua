@@ -12,6 +12,7 @@ local ipairs = ipairs
 local string = string
 local screen = screen
 local gfs = require("gears.filesystem")
+local icon_index = require("menubar.icon_index")
 local theme = require("beautiful")
 local lgi = require("lgi")
 local gio = lgi.Gio
@@ -20,6 +21,7 @@ local w_textbox = require("wibox.widget.textbox")
 local gdebug = require("gears.debug")
 local protected_call = require("gears.protected_call")
 local gstring = require("gears.string")
+local scheduler = require("gears.scheduler")
 local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
 
 local utils = {}
@@ -284,18 +286,23 @@ function utils.lookup_icon_uncached(icon_file)
         -- supported, do not perform a lookup.
         return gfs.file_readable(icon_file) and icon_file or nil
     else
+        -- Relative paths with a directory part cannot be looked up in the
+        -- directory listings
+        local has_file = icon_file:find("/", 1, true) and function(dir, name)
+            return gfs.file_readable(dir .. "/" .. name)
+        end or icon_index.has_file
+
         for _, directory in ipairs(get_icon_lookup_path()) do
             if is_format_supported(icon_file) and
-                    gfs.file_readable(directory .. "/" .. icon_file) then
+                    has_file(directory, icon_file) then
                 return directory .. "/" .. icon_file
             else
                 -- Icon is probably specified without path and format,
                 -- like 'firefox'. Try to add supported extensions to
                 -- it and see if such file exists.
                 for _, format in ipairs(icon_formats) do
-                    local possible_file = directory .. "/" .. icon_file .. "." .. format
-                    if gfs.file_readable(possible_file) then
-                        return possible_file
+                    if has_file(directory, icon_file .. "." .. format) then
+                        return directory .. "/" .. icon_file .. "." .. format
                     end
                 end
             end
@@ -315,12 +322,10 @@ function utils.lookup_icon(icon)
     return lookup_icon_cache[icon] or default_icon
 end
 
---- Parse a .desktop file.
+-- Read the keys of the [Desktop Entry] group of a .desktop file.
 -- @param file The .desktop file.
--- @return A table with file entries.
-function utils.parse_desktop_file(file)
-    local program = { show = true, file = file }
-
+-- @return A table with the values of the keys, or nil.
+local function read_desktop_keys(file)
     -- Parse the .desktop file.
     -- We are interested in [Desktop Entry] group only.
     local keyfile = glib.KeyFile()
@@ -333,11 +338,29 @@ function utils.parse_desktop_file(file)
         return nil
     end
 
+    local keys = {}
     for _, key in pairs(keyfile:get_keys("Desktop Entry")) do
         local getter = keys_getters[key] or function(kf, k)
             return kf:get_string("Desktop Entry", k)
         end
-        program[key] = getter(keyfile, key)
+        keys[key] = getter(keyfile, key)
+    end
+    return keys
+end
+
+-- Build the menu entry of a .desktop file from the values of its keys.
+-- @param file The .desktop file.
+-- @tparam table keys The values returned by read_desktop_keys().
+-- @return A table with file entries.
+local function program_from_keys(file, keys)
+    local program = { show = true, file = file }
+
+    -- The keys may come from the cache, do not share its lists
+    for key, value in pairs(keys) do
+        if type(value) == "table" then
+            value = { unpack(value) }
+        end
+        program[key] = value
     end
 
     -- In case the (required) 'Name' entry was not found
@@ -407,6 +430,131 @@ function utils.parse_desktop_file(file)
     return program
 end
 
+--- Parse a .desktop file.
+-- @param file The .desktop file.
+-- @return A table with file entries.
+function utils.parse_desktop_file(file)
+    local keys = read_desktop_keys(file)
+    return keys and program_from_keys(file, keys)
+end
+
+-- The keys of all .desktop files parsed so far. This is a table mapping the
+-- path of a file to a table with the modification time of the file and the
+-- values of its keys, or false if it is not a valid .desktop file. It is
+-- loaded from and saved to the cache directory.
+local desktop_cache = nil
+local desktop_cache_dirty = false
+local desktop_cache_write_scheduled = false
+
+local function get_desktop_cache_path()
+    return gfs.get_cache_dir() .. "/menubar_desktop_cache"
+end
+
+-- The localized values depend on the locale, so the cache does too
+local function get_desktop_cache_tag()
+    return "1 " .. table.concat(glib.get_language_names(), ":")
+end
+
+local function load_desktop_cache()
+    if desktop_cache then
+        return desktop_cache
+    end
+    desktop_cache = {}
+
+    local cache_file = io.open(get_desktop_cache_path(), "r")
+    if not cache_file then
+        return desktop_cache
+    end
+    local data = cache_file:read("*a")
+    cache_file:close()
+
+    -- The cache is a Lua table constructor which is run without access to
+    -- any global variable
+    local chunk
+    if setfenv then -- luacheck: globals setfenv loadstring (compatibility with Lua 5.1)
+        chunk = loadstring(data, "menubar desktop cache")
+        if chunk then setfenv(chunk, {}) end
+    else
+        chunk = load(data, "menubar desktop cache", "t", {})
+    end
+    local success, cache = false, nil
+    if chunk then
+        success, cache = pcall(chunk)
+    end
+    if success and type(cache) == "table" and cache.tag == get_desktop_cache_tag()
+            and type(cache.files) == "table" then
+        for path, entry in pairs(cache.files) do
+            desktop_cache[path] = { mtime = entry[1], keys = entry[2] }
+        end
+    end
+    return desktop_cache
+end
+
+local function serialize_value(value)
+    if type(value) == "string" then
+        return string.format("%q", value)
+    elseif type(value) == "boolean" then
+        return tostring(value)
+    elseif type(value) == "table" then
+        local items = {}
+        for i, item in ipairs(value) do
+            items[i] = string.format("%q", tostring(item))
+        end
+        return "{" .. table.concat(items, ",") .. "}"
+    end
+end
+
+local function write_desktop_cache()
+    desktop_cache_write_scheduled = false
+    if not desktop_cache_dirty then
+        return
+    end
+    desktop_cache_dirty = false
+
+    local lines = { string.format("return { tag = %q, files = {", get_desktop_cache_tag()) }
+    for path, entry in pairs(desktop_cache) do
+        local keys = "false"
+        if entry.keys then
+            local fields = {}
+            for key, value in pairs(entry.keys) do
+                value = serialize_value(value)
+                if value then
+                    table.insert(fields, string.format("[%q]=%s", key, value))
+                end
+            end
+            keys = "{" .. table.concat(fields, ",") .. "}"
+        end
+        table.insert(lines, string.format("[%q]={%.0f,%s},", path, entry.mtime, keys))
+    end
+    table.insert(lines, "} }\n")
+
+    -- Write to a temporary file first, so that the cache is never truncated
+    local cache_path = get_desktop_cache_path()
+    local tmp_path = cache_path .. ".tmp"
+    local cache_file = io.open(tmp_path, "w")
+    if not cache_file then
+        return
+    end
+    local written = cache_file:write(table.concat(lines, "\n"))
+    cache_file:close()
+    if not written or not os.rename(tmp_path, cache_path) then
+        os.remove(tmp_path)
+    end
+end
+
+-- Parse a .desktop file, unless the cache has its keys for this modification
+-- time.
+local function parse_desktop_file_cached(file, mtime)
+    local cache = load_desktop_cache()
+    local entry = cache[file]
+    if not entry or entry.mtime ~= mtime then
+        entry = { mtime = mtime, keys = read_desktop_keys(file) or false }
+        cache[file] = entry
+        desktop_cache_dirty = true
+    end
+    return entry.keys and program_from_keys(file, entry.keys)
+end
+
 --- Parse a directory with .desktop files recursively.
 -- @tparam string dir_path The directory path.
 -- @tparam function callback Will be fired when all the files were parsed
@@ -418,9 +566,13 @@ function utils.parse_dir(dir_path, callback)
         return file:get_path() or file:get_uri()
     end
 
+    -- The .desktop files found in this directory
+    local seen = {}
+
     local function parser(file, programs)
         -- Except for "NONE" there is also NOFOLLOW_SYMLINKS
         local query = gio.FILE_ATTRIBUTE_STANDARD_NAME .. "," .. gio.FILE_ATTRIBUTE_STANDARD_TYPE
+            .. "," .. gio.FILE_ATTRIBUTE_TIME_MODIFIED .. "," .. gio.FILE_ATTRIBUTE_TIME_MODIFIED_USEC
         local enum, err = file:async_enumerate_children(query, gio.FileQueryInfoFlags.NONE)
         if not enum then
             gdebug.print_warning(get_readable_path(file) .. ": " .. tostring(err))
@@ -439,7 +591,10 @@ function utils.parse_dir(dir_path, callback)
                 if file_type == 'REGULAR' then
                     local path = file_child:get_path()
                     if path then
-                        local success, program = pcall(utils.parse_desktop_file, path)
+                        local mtime = info:get_attribute_uint64(gio.FILE_ATTRIBUTE_TIME_MODIFIED) * 1000000
+                            + info:get_attribute_uint32(gio.FILE_ATTRIBUTE_TIME_MODIFIED_USEC)
+                        seen[path] = true
+                        local success, program = pcall(parse_desktop_file_cached, path, mtime)
                         if not success then
                             gdebug.print_error("Error while reading '" .. path .. "': " .. program)
                         elseif program then
@@ -460,6 +615,21 @@ function utils.parse_dir(dir_path, callback)
     gio.Async.start(do_protected_call)(function()
         local result = {}
         parser(gio.File.new_for_path(dir_path), result)
+
+        -- Forget about the files which were removed
+        local prefix = dir_path:gsub("/*$", "") .. "/"
+        local cache = load_desktop_cache()
+        for path in pairs(cache) do
+            if not seen[path] and path:sub(1, #prefix) == prefix then
+                cache[path] = nil
+                desktop_cache_dirty = true
+            end
+        end
+        if desktop_cache_dirty and not desktop_cache_write_scheduled then
+            desktop_cache_write_scheduled = true
+            scheduler.queue("idle", write_desktop_cache)
+        end
+
         call_callback(callback, result)
     end)
 end
@@ -476,8 +646,23 @@ end
 -- @tparam number|screen s Screen
 -- @treturn int Text width.
 function utils.compute_text_width(text, s)
-    local w, _ = w_textbox(gstring.xml_escape(text)):get_preferred_size(s)
-    return w
+    return utils.compute_text_widths({ text }, s)[1]
+end
+
+--- Compute the widths of several texts at once.
+-- @tparam table texts An array of texts.
+-- @tparam number|screen s Screen
+-- @treturn table An array with the width of each text.
+function utils.compute_text_widths(texts, s)
+    local escaped = {}
+    for i, text in ipairs(texts) do
+        escaped[i] = gstring.xml_escape(text)
+    end
+    local widths = {}
+    for i, size in ipairs(w_textbox.get_preferred_sizes(escaped, s)) do
+        widths[i] = size.width
+    end
+    return widths
 end
 
 return utils
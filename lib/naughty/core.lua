@@ -10,6 +10,8 @@
 
 -- Package environment
 local pairs = pairs
+local ipairs = ipairs
+local setmetatable = setmetatable
 local table = table
 local type = type
 local string = string
@@ -276,12 +278,9 @@ end
 -- @param[opt] width Popup width.
 -- @param height Popup height
 -- @return Absolute position and index in { x = X, y = Y, idx = I } table
-local function get_offset(s, position, idx, width, height)
-    s = get_screen(s)
-    local ws = s.workarea
+-- Position of a popup below (or above) existing popups of the given height.
+local function get_position(ws, position, existing, width, height)
     local v = {}
-    idx = idx or #naughty.notifications[s][position] + 1
-    width = width or naughty.notifications[s][position][idx].width
 
     -- calculate x
     if position:match("left") then
@@ -292,12 +291,6 @@ local function get_offset(s, position, idx, width, height)
         v.x = ws.x + ws.width - (width + naughty.config.padding)
     end
 
-    -- calculate existing popups' height
-    local existing = 0
-    for i = 1, idx-1, 1 do
-        existing = existing + naughty.notifications[s][position][i].height + naughty.config.spacing
-    end
-
     -- calculate y
     if position:match("top") then
         v.y = ws.y + naughty.config.padding + existing
@@ -305,25 +298,47 @@ local function get_offset(s, position, idx, width, height)
         v.y = ws.y + ws.height - (naughty.config.padding + height + existing)
     end
 
-    -- Find old notification to replace in case there is not enough room.
-    -- This tries to skip permanent notifications (without a timeout),
-    -- e.g. critical ones.
-    local find_old_to_replace = function()
-        for i = 1, idx-1 do
-            local n = naughty.notifications[s][position][i]
-            if n.timeout > 0 then
-                return n
-            end
+    return v
+end
+
+-- Find old notification to replace in case there is not enough room.
+-- This tries to skip permanent notifications (without a timeout),
+-- e.g. critical ones.
+local function find_old_to_replace(list, idx)
+    for i = 1, idx-1 do
+        local n = list[i]
+        if n.timeout > 0 then
+            return n
         end
-        -- Fallback to first one.
-        return naughty.notifications[s][position][1]
     end
+    -- Fallback to first one.
+    return list[1]
+end
+
+local function get_offset(s, position, idx, width, height)
+    s = get_screen(s)
+    local ws = s.workarea
+    idx = idx or #naughty.notifications[s][position] + 1
+    width = width or naughty.notifications[s][position][idx].width
+
+    -- calculate existing popups' height
+    local existing = 0
+    for i = 1, idx-1, 1 do
+        existing = existing + naughty.notifications[s][position][i].height + naughty.config.spacing
+    end
+
+    local v = get_position(ws, position, existing, width, height)
 
     -- if positioned outside workarea, destroy oldest popup and recalculate
-    if v.y + height > ws.y + ws.height or v.y < ws.y then
-        naughty.destroy(find_old_to_replace())
-        idx = idx - 1
-        v = get_offset(s, position, idx, width, height)
+    if (v.y + height > ws.y + ws.height or v.y < ws.y) and idx > 1 then
+        local list = naughty.notifications[s][position]
+        local count = #list
+        naughty.destroy(find_old_to_replace(list, idx))
+        -- Stop if nothing could be destroyed to make room
+        if #list < count then
+            idx = idx - 1
+            v = get_offset(s, position, idx, width, height)
+        end
     end
     if not v.idx then v.idx = idx end
 
@@ -332,17 +347,63 @@ end
 
 --- Re-arrange notifications according to their position and index - internal
 --
+-- Only the popups which actually moved get a new geometry.
 -- @return None
 local function arrange(s)
-    for p in pairs(naughty.notifications[s]) do
-        for i,notification in pairs(naughty.notifications[s][p]) do
-            local offset = get_offset(s, p, i, notification.width, notification.height)
-            notification.box:geometry({ x = offset.x, y = offset.y })
-            notification.idx = offset.idx
+    local ws = get_screen(s).workarea
+    for p, list in pairs(naughty.notifications[s]) do
+        local i, existing = 1, 0
+        while i <= #list do
+            local notification = list[i]
+            local v = get_position(ws, p, existing, notification.width, notification.height)
+            local count = #list
+            if i > 1 and (v.y + notification.height > ws.y + ws.height or v.y < ws.y) then
+                -- Make room by destroying an older popup and start over
+                naughty.destroy(find_old_to_replace(list, i))
+            end
+            if #list < count then
+                i, existing = 1, 0
+            else
+                -- Either it fits or nothing could be destroyed
+                local box = notification.box
+                if box.x ~= v.x or box.y ~= v.y then
+                    box:geometry({ x = v.x, y = v.y })
+                end
+                notification.idx = i
+                existing = existing + notification.height + naughty.config.spacing
+                i = i + 1
+            end
         end
     end
 end
 
+-- Screens whose notifications have to be arranged
+local pending_arrange = {}
+
+--- Arrange the notifications of a screen at the end of the main loop iteration
+-- - internal
+--
+-- This way, a burst of new or destroyed notifications only moves every popup
+-- once.
+-- @return None
+local function arrange_later(s)
+    if pending_arrange[s] then return end
+    pending_arrange[s] = true
+    timer.delayed_call(function()
+        pending_arrange[s] = nil
+        if s.valid and naughty.notifications[s] then
+            arrange(s)
+        end
+    end)
+end
+
+-- Hidden wiboxes of destroyed notifications, for reuse by new ones
+local box_pool = {}
+local box_pool_size = 8
+
+-- Notification -> the "mouse::enter" handler connected to its box
+local hover_callbacks = setmetatable({}, { __mode = "k" })
+
 --- Destroy notification by notification object
 --
 -- @param notification Notification object to be destroyed
@@ -350,7 +411,8 @@ end
 -- @param[opt=false] keep_visible If true, keep the notification visible
 -- @return True if the popup was successfully destroyed, nil otherwise
 function naughty.destroy(notification, reason, keep_visible)
-    if notification and notification.box.visible then
+    if notification and not notification.destroyed and notification.box.visible then
+        notification.destroyed = true
         if suspended then
             for k, v in pairs(naughty.notifications.suspended) do
                 if v.box == notification.box then
@@ -365,9 +427,20 @@ function naughty.destroy(notification, reason, keep_visible)
             notification.timer:stop()
         end
 
+        if hover_callbacks[notification] then
+            notification.box:disconnect_signal("mouse::enter", hover_callbacks[notification])
+            hover_callbacks[notification] = nil
+        end
+
         if not keep_visible then
             notification.box.visible = false
-            arrange(scr)
+            if #box_pool < box_pool_size then
+                table.insert(box_pool, notification.box)
+                -- The box now belongs to the next notification, the caller
+                -- might still hold on to this one
+                notification.box = nil
+            end
+            arrange_later(scr)
         end
 
         if notification.destroy_cb and reason ~= naughty.notificationClosedReason.silent then
@@ -538,6 +611,10 @@ local function update_size(notification)
     -- set size in notification object
     n.height = height + 2*border_width
     n.width = width + 2*border_width
+
+    -- A destroyed notification might have given its box to another one
+    if n.destroyed then return end
+
     local offset = get_offset(n.screen, n.position, n.idx, n.width, n.height)
     n.box:geometry({
         width = width,
@@ -548,7 +625,7 @@ local function update_size(notification)
     n.idx = offset.idx
 
     -- update positions of other notifications
-    arrange(n.screen)
+    arrange_later(n.screen)
 end
 
 --- Replace title and text of an existing notification.
@@ -803,11 +880,8 @@ function naughty.notify(args)
     notification.iconbox = iconbox
 
     -- create container wibox
-    if not reuse_box then
-        notification.box = wibox({ type = "notification" })
-    else
-        notification.box = reuse_box
-    end
+    notification.box = reuse_box or table.remove(box_pool)
+        or wibox({ type = "notification" })
     notification.box.fg = fg
     notification.box.bg = bg
     notification.box.border_color = border_color
@@ -816,7 +890,10 @@ function naughty.notify(args)
     notification.box.shape_border_width = shape and border_width
     notification.box.shape = shape
 
-    if hover_timeout then notification.box:connect_signal("mouse::enter", hover_destroy) end
+    if hover_timeout then
+        notification.box:connect_signal("mouse::enter", hover_destroy)
+        hover_callbacks[notification] = hover_destroy
+    end
 
     notification.size_info = {
         width = width,
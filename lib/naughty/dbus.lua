@@ -18,6 +18,7 @@ local capi = { awesome = awesome,
 local gtable = require("gears.table")
 local gsurface = require("gears.surface")
 local cairo = require("lgi").cairo
+local glib = require("lgi").GLib
 
 local schar = string.char
 local sbyte = string.byte
@@ -51,6 +52,103 @@ dbus.config.mapping = {
     {{urgency = urgency.critical}, naughty.config.presets.critical}
 }
 
+--- Limit the rate of notifications per application.
+-- Every application has a bucket of `burst` tokens which refills by `rate`
+-- tokens per second; a notification without a token left is dropped. This is
+-- disabled when `nil`.
+-- @tfield number rate Tokens added per second.
+-- @tfield number burst The size of the bucket.
+-- @table config.rate_limit
+dbus.config.rate_limit = nil
+
+--- Collapse duplicate notifications.
+-- A notification with the same application, title and text as one which is
+-- still shown and arrived less than this many seconds ago updates a counter
+-- on that one instead of opening a new popup. This is disabled when `nil`.
+-- @field config.dedup_window
+dbus.config.dedup_window = nil
+
+--- Statistics about notifications which were not shown.
+-- @tfield integer dropped Notifications dropped by the rate limit.
+-- @tfield integer merged Notifications merged into an existing duplicate.
+-- @table stats
+dbus.stats = { dropped = 0, merged = 0 }
+
+-- appname -> { tokens = number, time = number }
+local buckets = {}
+
+-- appname, title and text -> { notification, count, time, title, text }
+local recent = {}
+
+local function now()
+    return glib.get_monotonic_time() / 1000000
+end
+
+-- Take a token from the bucket of an application.
+local function rate_limit_allow(appname)
+    local limit = dbus.config.rate_limit
+    if not limit then return true end
+
+    local t = now()
+    local bucket = buckets[appname]
+    if not bucket then
+        bucket = { tokens = limit.burst, time = t }
+        buckets[appname] = bucket
+    end
+    bucket.tokens = math.min(limit.burst, bucket.tokens + (t - bucket.time) * limit.rate)
+    bucket.time = t
+
+    if bucket.tokens < 1 then
+        return false
+    end
+    bucket.tokens = bucket.tokens - 1
+    return true
+end
+
+local function dedup_alive(entry, t)
+    return t - entry.time <= dbus.config.dedup_window
+        and not entry.notification.destroyed
+end
+
+-- Find a shown notification with the same content and count the duplicate.
+local function dedup_merge(appname, title, text)
+    if not dbus.config.dedup_window then return nil end
+
+    local entry = recent[appname .. "\0" .. title .. "\0" .. text]
+    if not entry or not dedup_alive(entry, now()) then return nil end
+
+    entry.count = entry.count + 1
+    entry.time = now()
+    local badge = " (" .. entry.count .. ")"
+    if entry.title then
+        naughty.replace_text(entry.notification, entry.title .. badge, entry.text)
+    else
+        naughty.replace_text(entry.notification, nil, entry.text .. badge)
+    end
+    if entry.notification.timeout > 0 then
+        naughty.reset_timeout(entry.notification)
+    end
+    return entry.notification
+end
+
+local function dedup_remember(notification, appname, title, text)
+    if not dbus.config.dedup_window then return end
+
+    local t = now()
+    for key, entry in pairs(recent) do
+        if not dedup_alive(entry, t) then
+            recent[key] = nil
+        end
+    end
+    recent[appname .. "\0" .. title .. "\0" .. text] = {
+        notification = notification,
+        count = 1,
+        time = t,
+        title = title ~= "" and text ~= "" and title or nil,
+        text = text ~= "" and text or title,
+    }
+end
+
 local function sendActionInvoked(notificationId, action)
     if capi.dbus then
         capi.dbus.emit_signal("session", "/org/freedesktop/Notifications",
@@ -117,6 +215,19 @@ capi.dbus.connect_signal("org.freedesktop.Notifications",
     function (data, appname, replaces_id, icon, title, text, actions, hints, expire)
         local args = { }
         if data.member == "Notify" then
+            -- Handle floods before doing any work for the notification
+            if not rate_limit_allow(appname) then
+                dbus.stats.dropped = dbus.stats.dropped + 1
+                return "u", "0"
+            end
+            if not replaces_id or replaces_id == "" or replaces_id == 0 then
+                local duplicate = dedup_merge(appname, title, text)
+                if duplicate then
+                    dbus.stats.merged = dbus.stats.merged + 1
+                    return "u", duplicate.id
+                end
+            end
+
             if text ~= "" then
                 args.text = text
                 if title ~= "" then
@@ -191,6 +302,9 @@ capi.dbus.connect_signal("org.freedesktop.Notifications",
                 end
                 args.freedesktop_hints = hints
                 notification = naughty.notify(args)
+                if notification then
+                    dedup_remember(notification, appname, title, text)
+                end
                 return "u", notification.id
             end
             return "u", "0"
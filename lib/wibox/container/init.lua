@@ -6,17 +6,19 @@
 -- @classmod wibox.container
 ---------------------------------------------------------------------------
 local base = require("wibox.widget.base")
+local lazy_require = require("gears.lazy_require")
 
-return setmetatable({
-    rotate = require("wibox.container.rotate");
-    margin = require("wibox.container.margin");
-    mirror = require("wibox.container.mirror");
-    constraint = require("wibox.container.constraint");
-    scroll = require("wibox.container.scroll");
-    background = require("wibox.container.background");
-    radialprogressbar = require("wibox.container.radialprogressbar");
-    arcchart = require("wibox.container.arcchart");
-    place = require("wibox.container.place");
-}, {__call = function(_, args) return base.make_widget_declarative(args) end})
+return lazy_require(setmetatable({},
+    {__call = function(_, args) return base.make_widget_declarative(args) end}), {
+    rotate = "wibox.container.rotate";
+    margin = "wibox.container.margin";
+    mirror = "wibox.container.mirror";
+    constraint = "wibox.container.constraint";
+    scroll = "wibox.container.scroll";
+    background = "wibox.container.background";
+    radialprogressbar = "wibox.container.radialprogressbar";
+    arcchart = "wibox.container.arcchart";
+    place = "wibox.container.place";
+})
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -71,7 +71,7 @@ local function do_redraw(self)
     if not surf then return end
     local cr = cairo.Context(surf)
     local geom = self.drawable:geometry();
-    local x, y, width, height = geom.x, geom.y, geom.width, geom.height
+    local width, height = geom.width, geom.height
     local context = get_widget_context(self)
 
     -- Relayout
@@ -110,9 +110,11 @@ local function do_redraw(self)
     if self._dirty_area:is_empty() then
         return
     end
+    local damage = {}
     for i = 0, self._dirty_area:num_rectangles() - 1 do
         local rect = self._dirty_area:get_rectangle(i)
         cr:rectangle(rect.x, rect.y, rect.width, rect.height)
+        damage[i + 1] = { x = rect.x, y = rect.y, width = rect.width, height = rect.height }
     end
     self._dirty_area = cairo.Region.create()
     cr:clip()
@@ -121,11 +123,12 @@ local function do_redraw(self)
     cr:save()
 
     if not capi.awesome.composite_manager_running then
-        -- This is pseudo-transparency: We draw the wallpaper in the background
-        local wallpaper = surface.load_silently(capi.root.wallpaper(), false)
+        -- This is pseudo-transparency: We draw the wallpaper in the background.
+        -- The C side keeps the part of the wallpaper below us around.
+        local wallpaper = surface.load_silently(self.drawable:backdrop(), false)
         cr.operator = cairo.Operator.SOURCE
         if wallpaper then
-            cr:set_source_surface(wallpaper, -x, -y)
+            cr:set_source_surface(wallpaper, 0, 0)
         else
             cr:set_source_rgb(0, 0, 0)
         end
@@ -160,7 +163,7 @@ local function do_redraw(self)
         self._widget_hierarchy:draw(context, cr)
     end
 
-    self.drawable:refresh()
+    self.drawable:refresh(damage)
 
     assert(cr.status == "SUCCESS", "Cairo context entered error state: " .. cr.status)
 end
@@ -193,7 +196,7 @@ local function find_widgets(_drawable, result, _hierarchy, x, y)
             hierarchy = _hierarchy
         })
     end
-    for _, child in ipairs(_hierarchy:get_children()) do
+    for _, child in ipairs(_hierarchy:get_children_at(x, y)) do
         find_widgets(_drawable, result, child, x, y)
     end
 end
@@ -310,17 +313,13 @@ function drawable:_inform_visible(visible)
 end
 
 local function emit_difference(name, list, skip)
-    local function in_table(table, val)
-        for _, v in pairs(table) do
-            if v.widget == val.widget then
-                return true
-            end
-        end
-        return false
+    local skip_widgets = {}
+    for _, v in pairs(skip) do
+        skip_widgets[v.widget] = true
     end
 
     for _, v in pairs(list) do
-        if not in_table(skip, v) then
+        if not skip_widgets[v.widget] then
             v.widget:emit_signal(name,v)
         end
     end
@@ -483,6 +482,21 @@ function drawable.new(d, widget_context_skeleton, drawable_name)
     return ret
 end
 
+--- Check if a widget is shown by any visible drawable.
+-- Only widgets registered with `wibox.hierarchy.count_widget` are found.
+-- @param widget The widget.
+-- @treturn boolean Whether the widget is shown.
+-- @function wibox.drawable.is_widget_shown
+function drawable.is_widget_shown(widget)
+    for d in pairs(visible_drawables) do
+        local h = d._widget_hierarchy
+        if h and h:get_count(widget) > 0 then
+            return true
+        end
+    end
+    return false
+end
+
 -- Redraw all drawables when the wallpaper changes
 capi.awesome.connect_signal("wallpaper_changed", function()
     for d in pairs(visible_drawables) do
@@ -18,6 +18,12 @@ local hierarchy = {}
 
 local widgets_to_count = setmetatable({}, { __mode = "k" })
 
+-- Hierarchies with fewer children are hit tested without an index
+local hit_index_min_children = 8
+
+-- Number of hierarchies which had to be updated in the running update
+local updated_count = 0
+
 --- Add a widget to the list of widgets for which hierarchies should count their
 -- occurrences. Note that for correct operations, the widget must not yet be
 -- visible in any hierarchy.
@@ -46,12 +52,26 @@ local function hierarchy_new(redraw_callback, layout_callback, callback_arg)
             width = 0,
             height = 0
         },
+        _device_extents = {
+            x = 0,
+            y = 0,
+            width = 0,
+            height = 0
+        },
         _parent = nil,
         _children = {},
         _widget_counts = {},
+        _node_count = 1,
+        _last_update_count = 0,
     }
 
     function result._redraw()
+        -- The retained surfaces of us and our parents are outdated
+        local h = result
+        while h do
+            h._cache = nil
+            h = h._parent
+        end
         redraw_callback(result, callback_arg)
     end
     function result._layout()
@@ -81,6 +101,17 @@ local function hierarchy_new(redraw_callback, layout_callback, callback_arg)
     return result
 end
 
+--- Free the retained surfaces of a hierarchy and all its children.
+local function drop_caches(self)
+    if self._cache then
+        self._cache.surface:finish()
+        self._cache = nil
+    end
+    for _, child in ipairs(self._children) do
+        drop_caches(child)
+    end
+end
+
 local hierarchy_update
 function hierarchy_update(self, context, widget, width, height, region, matrix_to_parent, matrix_to_device)
     if (not self._need_update) and self._widget == widget and
@@ -93,6 +124,8 @@ function hierarchy_update(self, context, widget, width, height, region, matrix_t
     end
 
     self._need_update = false
+    self._cache = nil
+    updated_count = updated_count + 1
 
     local old_x, old_y, old_width, old_height
     local old_widget = self._widget
@@ -126,18 +159,59 @@ function hierarchy_update(self, context, widget, width, height, region, matrix_t
         widget:weak_connect_signal("widget::emit_recursive", self._emit_recursive)
     end
 
-    -- Update children
+    -- Update children. Old child hierarchies are reused for the same widget,
+    -- so that e.g. inserting a widget at the front of a layout does not change
+    -- the hierarchies of all the other widgets. Only then the remaining old
+    -- hierarchies are reused in order.
     local old_children = self._children
-    local layout_result = base.layout_widget(no_parent, context, widget, width, height)
-    self._children = {}
-    for _, w in ipairs(layout_result or {}) do
-        local r = table.remove(old_children, 1)
+    local layout_result = base.layout_widget(no_parent, context, widget, width, height) or {}
+    local by_widget = {}
+    for _, child in ipairs(old_children) do
+        local list = by_widget[child._widget]
+        if not list then
+            list = { next = 1 }
+            by_widget[child._widget] = list
+        end
+        table.insert(list, child)
+    end
+
+    local children, reused = {}, {}
+    for i, w in ipairs(layout_result) do
+        local list = by_widget[w._widget]
+        if list and list[list.next] then
+            children[i] = list[list.next]
+            reused[children[i]] = true
+            list.next = list.next + 1
+        end
+    end
+
+    local spare, next_spare = {}, 1
+    for _, child in ipairs(old_children) do
+        if not reused[child] then
+            table.insert(spare, child)
+        end
+    end
+
+    self._children = children
+    self._node_count = 1
+    for i, w in ipairs(layout_result) do
+        local r = children[i]
         if not r then
-            r = hierarchy_new(self._redraw_callback, self._layout_callback, self._callback_arg)
-            r._parent = self
+            r = spare[next_spare]
+            if r then
+                next_spare = next_spare + 1
+            else
+                r = hierarchy_new(self._redraw_callback, self._layout_callback, self._callback_arg)
+                r._parent = self
+            end
+            children[i] = r
         end
         hierarchy_update(r, context, w._widget, w._width, w._height, region, w._matrix, w._matrix * matrix_to_device)
-        table.insert(self._children, r)
+        self._node_count = self._node_count + r._node_count
+    end
+    old_children = {}
+    for i = next_spare, #spare do
+        table.insert(old_children, spare[i])
     end
 
     -- Calculate the draw extents
@@ -154,6 +228,10 @@ function hierarchy_update(self, context, widget, width, height, region, matrix_t
         width = x2 - x1,
         height = y2 - y1
     }
+    local dx, dy, dw, dh = matrix.transform_rectangle(matrix_to_device, x1, y1, x2 - x1, y2 - y1)
+    self._device_extents = { x = dx, y = dy, width = dw, height = dh }
+    self._matrix_from_device = nil
+    self._hit_index = nil
 
     -- Update widget counts
     self._widget_counts = {}
@@ -175,6 +253,7 @@ function hierarchy_update(self, context, widget, width, height, region, matrix_t
             x = x, y = y, width = w, height = h
         })
         child._parent = nil
+        drop_caches(child)
     end
 
     -- Did we change and need to be redrawn?
@@ -219,10 +298,24 @@ end
 --   argument or a new, internally created region).
 function hierarchy:update(context, widget, width, height, region)
     region = region or cairo.Region.create()
+    local outer_count = updated_count
+    updated_count = 0
     hierarchy_update(self, context, widget, width, height, region, self._matrix, self._matrix_to_device)
+    self._last_update_count = updated_count
+    updated_count = outer_count
     return region
 end
 
+--- Get statistics about the last call to `update`.
+-- Hierarchies whose widget, size and position did not change are not
+-- revisited, so `updated / nodes` is the fraction of the tree that had to
+-- be laid out again.
+-- @return A table with the number of `updated` hierarchies and the number of
+--   `nodes` in the whole hierarchy.
+function hierarchy:get_update_stats()
+    return { updated = self._last_update_count, nodes = self._node_count }
+end
+
 --- Get the widget that this hierarchy manages.
 function hierarchy:get_widget()
     return self._widget
@@ -256,8 +349,10 @@ end
 -- hierarchy is applied upon) into this hierarchy's coordinate system.
 -- @return A matrix describing the transformation.
 function hierarchy:get_matrix_from_device()
-    local m = self:get_matrix_to_device()
-    return m:invert()
+    if not self._matrix_from_device then
+        self._matrix_from_device = self:get_matrix_to_device():invert()
+    end
+    return self._matrix_from_device
 end
 
 --- Get the extents that this hierarchy possibly draws to (in the current coordinate space).
@@ -282,6 +377,96 @@ function hierarchy:get_children()
     return self._children
 end
 
+local function extents_contain(e, x, y)
+    return x >= e.x and x <= e.x + e.width and y >= e.y and y <= e.y + e.height
+end
+
+-- Sort the children along the axis on which they are spread out most. Since
+-- `reach[i]` is the furthest end of the first `i` children in that order, the
+-- children containing a point are found with a binary search.
+local function build_hit_index(self)
+    local min_x, min_y, max_x, max_y = math.huge, math.huge, -math.huge, -math.huge
+    for _, child in ipairs(self._children) do
+        local e = child._device_extents
+        min_x, min_y = math.min(min_x, e.x), math.min(min_y, e.y)
+        max_x, max_y = math.max(max_x, e.x + e.width), math.max(max_y, e.y + e.height)
+    end
+    local axis, size = "x", "width"
+    if max_y - min_y > max_x - min_x then
+        axis, size = "y", "height"
+    end
+
+    local children, order = self._children, {}
+    for i = 1, #children do
+        order[i] = i
+    end
+    table.sort(order, function(a, b)
+        return children[a]._device_extents[axis] < children[b]._device_extents[axis]
+    end)
+
+    local reach, far = {}, -math.huge
+    for i, idx in ipairs(order) do
+        local e = children[idx]._device_extents
+        far = math.max(far, e[axis] + e[size])
+        reach[i] = far
+    end
+
+    return { axis = axis, order = order, reach = reach }
+end
+
+--- Get the children whose draw extents possibly contain a point.
+-- This uses an axis-aligned bounding box of each child in device space, so the
+-- result can include children which do not really contain the point, e.g.
+-- because they are rotated.
+-- @param x The x coordinate of the point in device space.
+-- @param y The y coordinate of the point in device space.
+-- @return List of children hierarchies, in the order of `get_children`.
+function hierarchy:get_children_at(x, y)
+    local children, result = self._children, {}
+    if #children < hit_index_min_children then
+        for _, child in ipairs(children) do
+            if extents_contain(child._device_extents, x, y) then
+                table.insert(result, child)
+            end
+        end
+        return result
+    end
+
+    if not self._hit_index then
+        self._hit_index = build_hit_index(self)
+    end
+    local index = self._hit_index
+    local order, reach = index.order, index.reach
+    local pos = index.axis == "x" and x or y
+
+    -- Find the last child which starts before the point
+    local lo, hi = 1, #order
+    while lo <= hi do
+        local mid = math.floor((lo + hi) / 2)
+        if children[order[mid]]._device_extents[index.axis] <= pos then
+            lo = mid + 1
+        else
+            hi = mid - 1
+        end
+    end
+
+    -- Only earlier children can reach up to the point
+    local found = {}
+    for i = hi, 1, -1 do
+        if reach[i] < pos then
+            break
+        end
+        if extents_contain(children[order[i]]._device_extents, x, y) then
+            table.insert(found, order[i])
+        end
+    end
+    table.sort(found)
+    for _, idx in ipairs(found) do
+        table.insert(result, children[idx])
+    end
+    return result
+end
+
 --- Count how often this widget is visible inside this hierarchy. This function
 -- only works with widgets registered via `count_widget`.
 -- @param widget The widget that should be counted
@@ -296,9 +481,113 @@ local function empty_clip(cr)
     return width == 0 or height == 0
 end
 
+--- Draw a widget and its children to some cairo context.
+-- The context has to be already transformed into the hierarchy's coordinate
+-- system.
+local function draw_widget(self, context, cr)
+    local widget = self:get_widget()
+    local opacity = widget:get_opacity()
+    local function call(func, extra_arg1, extra_arg2)
+        if not func then return end
+        if not extra_arg2 then
+            protected_call(func, widget, context, cr, self:get_size())
+        else
+            protected_call(func, widget, context, extra_arg1, extra_arg2, cr, self:get_size())
+        end
+    end
+
+    -- Prepare opacity handling
+    if opacity ~= 1 then
+        cr:push_group()
+    end
+
+    -- Draw the widget
+    cr:save()
+    cr:rectangle(0, 0, self:get_size())
+    cr:clip()
+    call(widget.draw)
+    cr:restore()
+
+    -- Draw its children (We already clipped to the draw extents above)
+    call(widget.before_draw_children)
+    for i, wi in ipairs(self:get_children()) do
+        call(widget.before_draw_child, i, wi:get_widget())
+        wi:draw(context, cr)
+        call(widget.after_draw_child, i, wi:get_widget())
+    end
+    call(widget.after_draw_children)
+
+    -- Apply opacity
+    if opacity ~= 1 then
+        cr:pop_group_to_source()
+        cr.operator = cairo.Operator.OVER
+        cr:paint_with_alpha(opacity)
+    end
+end
+
+--- Draw a retained widget through its cached surface.
+-- The surface covers the device pixels of the draw extents. It is kept until
+-- the widget or one of its children needs a redraw or a relayout, or until the
+-- size, DPI or transformation (apart from whole pixel translations) changes.
+-- @return false if the widget cannot be cached and has to be drawn directly.
+local function draw_retained(self, context, cr)
+    -- Widgets draw with the source of their parent, so it has to be recorded
+    local source = cr:get_source()
+    if source:get_type() ~= "SOLID" then
+        return false
+    end
+    local _, r, g, b, a = source:get_rgba()
+
+    local m = cr:get_matrix()
+    local x, y, width, height = matrix.transform_rectangle(matrix.from_cairo_matrix(m),
+        self:get_draw_extents())
+    local x1, y1 = math.floor(x), math.floor(y)
+    local x2, y2 = math.ceil(x + width), math.ceil(y + height)
+    local key = {
+        width = x2 - x1, height = y2 - y1, dpi = context.dpi,
+        xx = m.xx, yx = m.yx, xy = m.xy, yy = m.yy,
+        x0 = m.x0 - x1, y0 = m.y0 - y1,
+        r = r, g = g, b = b, a = a
+    }
+    if key.width <= 0 or key.height <= 0 then
+        return true
+    end
+
+    local cache = self._cache
+    local valid = cache ~= nil
+    for k, v in pairs(key) do
+        valid = valid and cache.key[k] == v
+    end
+
+    if not valid then
+        if cache then
+            cache.surface:finish()
+        end
+        local surf = cr:get_target():create_similar(cairo.Content.COLOR_ALPHA,
+            key.width, key.height)
+        local cache_cr = cairo.Context(surf)
+        cache_cr:set_matrix(matrix.create(m.xx, m.yx, m.xy, m.yy, key.x0, key.y0):to_cairo_matrix())
+        cache_cr:set_source_rgba(r, g, b, a)
+        draw_widget(self, context, cache_cr)
+        cache = { key = key, surface = surf }
+        self._cache = cache
+    end
+
+    -- Copy the surface in device space, so that no resampling takes place
+    cr:save()
+    cr:identity_matrix()
+    cr:set_source_surface(cache.surface, x1, y1)
+    cr:paint()
+    cr:restore()
+    return true
+end
+
 --- Draw a hierarchy to some cairo context.
 -- This function draws the widgets in this widget hierarchy to the given cairo
 -- context. The context's clip is used to skip parts that aren't visible.
+--
+-- Widgets with `retained` set are drawn once into a surface which is reused
+-- until they emit `widget::redraw_needed` or `widget::layout_changed`.
 -- @param context The context in which widgets are drawn.
 -- @param cr The cairo context that is used for drawing.
 function hierarchy:draw(context, cr)
@@ -316,42 +605,8 @@ function hierarchy:draw(context, cr)
 
     -- Draw if needed
     if not empty_clip(cr) then
-        local opacity = widget:get_opacity()
-        local function call(func, extra_arg1, extra_arg2)
-            if not func then return end
-            if not extra_arg2 then
-                protected_call(func, widget, context, cr, self:get_size())
-            else
-                protected_call(func, widget, context, extra_arg1, extra_arg2, cr, self:get_size())
-            end
-        end
-
-        -- Prepare opacity handling
-        if opacity ~= 1 then
-            cr:push_group()
-        end
-
-        -- Draw the widget
-        cr:save()
-        cr:rectangle(0, 0, self:get_size())
-        cr:clip()
-        call(widget.draw)
-        cr:restore()
-
-        -- Draw its children (We already clipped to the draw extents above)
-        call(widget.before_draw_children)
-        for i, wi in ipairs(self:get_children()) do
-            call(widget.before_draw_child, i, wi:get_widget())
-            wi:draw(context, cr)
-            call(widget.after_draw_child, i, wi:get_widget())
-        end
-        call(widget.after_draw_children)
-
-        -- Apply opacity
-        if opacity ~= 1 then
-            cr:pop_group_to_source()
-            cr.operator = cairo.Operator.OVER
-            cr:paint_with_alpha(opacity)
+        if not (widget._private.retained and draw_retained(self, context, cr)) then
+            draw_widget(self, context, cr)
         end
     end
 
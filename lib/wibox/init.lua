@@ -237,6 +237,10 @@ end
 --- Create a wibox.
 -- @tparam[opt=nil] table args
 --@DOC_wibox_constructor_COMMON@
+-- @tparam[opt] string args.backend How the wibox is rendered, `"xcb"`,
+--   `"image"` or `"threaded"`. See `awesome.set_drawable_backend`.
+-- @tparam[opt] integer args.motion_rate The maximum number of `mouse::move`
+--   signals per second, see the `motion_rate` of `drawable`.
 -- @treturn wibox The new wibox
 -- @function .wibox
 
@@ -250,6 +254,12 @@ local function new(args)
     end
 
     ret.drawin = w
+    if args.backend then
+        w.drawable.backend = args.backend
+    end
+    if args.motion_rate then
+        w.drawable.motion_rate = args.motion_rate
+    end
     ret._drawable = wibox.drawable(w.drawable, { wibox = ret },
         "wibox drawable (" .. object.modulename(3) .. ")")
 
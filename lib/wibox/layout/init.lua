@@ -6,20 +6,22 @@
 -- @classmod wibox.layout
 ---------------------------------------------------------------------------
 local base = require("wibox.widget.base")
+local lazy_require = require("gears.lazy_require")
 
-return setmetatable({
-    fixed = require("wibox.layout.fixed");
-    align = require("wibox.layout.align");
-    flex = require("wibox.layout.flex");
-    rotate = require("wibox.layout.rotate");
-    manual = require("wibox.layout.manual");
-    margin = require("wibox.layout.margin");
-    mirror = require("wibox.layout.mirror");
-    constraint = require("wibox.layout.constraint");
-    scroll = require("wibox.layout.scroll");
-    ratio = require("wibox.layout.ratio");
-    stack = require("wibox.layout.stack");
-    grid = require("wibox.layout.grid");
-}, {__call = function(_, args) return base.make_widget_declarative(args) end})
+return lazy_require(setmetatable({},
+    {__call = function(_, args) return base.make_widget_declarative(args) end}), {
+    fixed = "wibox.layout.fixed";
+    align = "wibox.layout.align";
+    flex = "wibox.layout.flex";
+    rotate = "wibox.layout.rotate";
+    manual = "wibox.layout.manual";
+    margin = "wibox.layout.margin";
+    mirror = "wibox.layout.mirror";
+    constraint = "wibox.layout.constraint";
+    scroll = "wibox.layout.scroll";
+    ratio = "wibox.layout.ratio";
+    stack = "wibox.layout.stack";
+    grid = "wibox.layout.grid";
+})
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -68,6 +68,29 @@ function base.widget:get_opacity()
     return self._private.opacity
 end
 
+--- Set whether the widget is retained.
+-- A retained widget is drawn once into an offscreen surface, which is then
+-- reused for later redraws until the widget or one of its children emits
+-- `widget::redraw_needed` or `widget::layout_changed`. This helps for static
+-- widgets like images and separators, but widgets drawing something else
+-- than what they signal must not be retained.
+-- @tparam boolean retained Whether the widget is retained.
+-- @function set_retained
+function base.widget:set_retained(retained)
+    retained = retained or false
+    if retained ~= self._private.retained then
+        self._private.retained = retained
+        self:emit_signal("widget::redraw_needed")
+    end
+end
+
+--- Is the widget retained?
+-- @treturn boolean
+-- @function get_retained
+function base.widget:get_retained()
+    return self._private.retained or false
+end
+
 --- Set the widget's forced width.
 -- @tparam[opt] number width With `nil` the default mechanism of calling the
 --   `:fit` method is used.
@@ -209,8 +232,17 @@ end
 
 -- {{{ Caches
 
--- Indexes are widgets, allow them to be garbage-collected.
-local widget_dependencies = setmetatable({}, { __mode = "kv" })
+-- Indexes are widgets, allow them to be garbage-collected. For each child,
+-- this maps the parents whose layout depends on it to what they used: the
+-- results of `fit` calls, or (if `layout` is set) the child's layout. A widget
+-- does not keep its parents alive.
+--
+-- When a widget changes, its own caches are cleared and its ancestors are only
+-- marked as suspects. Before the cache of a suspect is used, the fit results
+-- its children gave it are checked again. Only if one of them changed, its
+-- caches are cleared, too. Thus a textbox whose text changes, but not its
+-- size, does not cause its whole wibar to be fit again.
+local widget_dependencies = setmetatable({}, { __mode = "k" })
 
 -- Get the cache of the given kind for this widget. This returns a gears.cache
 -- that calls the callback of kind `kind` on the widget.
@@ -230,7 +262,7 @@ end
 base.no_parent_I_know_what_I_am_doing = {}
 
 -- Record a dependency from parent to child: The layout of `parent` depends on
--- the layout of `child`.
+-- the layout of `child`. Returns the record of what `parent` used from `child`.
 local function record_dependency(parent, child)
     if parent == base.no_parent_I_know_what_I_am_doing then
         return
@@ -239,19 +271,115 @@ local function record_dependency(parent, child)
     base.check_widget(parent)
     base.check_widget(child)
 
-    local deps = widget_dependencies[child] or {}
-    deps[parent] = true
-    widget_dependencies[child] = deps
+    local deps = widget_dependencies[child]
+    if not deps then
+        deps = setmetatable({}, { __mode = "k" })
+        widget_dependencies[child] = deps
+    end
+
+    -- What the parent used before its caches were cleared does not matter
+    local parent_generation = parent._private.cache_generation or 0
+    local dep = deps[parent]
+    if not dep or dep.parent_generation ~= parent_generation then
+        dep = {
+            parent_generation = parent_generation,
+            generation = child._private.cache_generation or 0,
+            fits = {},
+        }
+        deps[parent] = dep
+    end
+    return dep
 end
 
--- Clear the caches for `widget` and all widgets that depend on it.
-local clear_caches
-function clear_caches(widget)
-    local deps = widget_dependencies[widget] or {}
-    widget_dependencies[widget] = {}
+-- Remember that `parent` got `w, h` from fitting `child`.
+local function record_fit(dep, context, width, height, w, h)
+    if not dep then
+        return
+    end
+    local by_width = dep.fits[context]
+    if not by_width then
+        by_width = {}
+        dep.fits[context] = by_width
+    end
+    local by_height = by_width[width]
+    if not by_height then
+        by_height = {}
+        by_width[width] = by_height
+    end
+    by_height[height] = { w, h }
+end
+
+-- Clear the caches of `widget`.
+local function clear_caches(widget)
     widget._private.widget_caches = {}
-    for w in pairs(deps) do
-        clear_caches(w)
+    widget._private.cache_generation = (widget._private.cache_generation or 0) + 1
+end
+
+-- Mark all widgets that depend on `widget` as suspects.
+local mark_suspects
+function mark_suspects(widget)
+    for parent in pairs(widget_dependencies[widget] or {}) do
+        local suspects = parent._private.suspects
+        if not suspects then
+            suspects = {}
+            parent._private.suspects = suspects
+        end
+        if not suspects[widget] then
+            suspects[widget] = true
+            mark_suspects(parent)
+        end
+    end
+end
+
+-- Check if what `parent` used from `child` is still valid.
+local validate_caches
+local function dependency_valid(parent, child)
+    validate_caches(child)
+
+    local deps = widget_dependencies[child]
+    local dep = deps and deps[parent]
+    if not dep or dep.parent_generation ~= (parent._private.cache_generation or 0) then
+        -- The parent did not use the child since its caches were cleared
+        return true
+    end
+    local generation = child._private.cache_generation or 0
+    if dep.generation == generation then
+        return true
+    end
+    if dep.layout then
+        return false
+    end
+
+    local no_parent = base.no_parent_I_know_what_I_am_doing
+    for context, by_width in pairs(dep.fits) do
+        for width, by_height in pairs(by_width) do
+            for height, size in pairs(by_height) do
+                local w, h = base.fit_widget(no_parent, context, child, width, height)
+                if w ~= size[1] or h ~= size[2] then
+                    return false
+                end
+            end
+        end
+    end
+    dep.generation = generation
+    return true
+end
+
+-- Clear the caches of `widget` if one of the children it depends on changed.
+function validate_caches(widget)
+    local suspects = widget._private.suspects
+    if not suspects or not next(suspects) then
+        return
+    end
+    widget._private.suspects = {}
+
+    -- Check all suspects, so that none stays marked below a valid widget
+    local valid = true
+    for child in pairs(suspects) do
+        valid = dependency_valid(widget, child) and valid
+    end
+    if not valid then
+        clear_caches(widget)
     end
 end
 
@@ -280,15 +408,18 @@ end
 -- @treturn number The height that the widget wants to use.
 -- @function wibox.widget.base.fit_widget
 function base.fit_widget(parent, context, widget, width, height)
-    record_dependency(parent, widget)
+    local dep = record_dependency(parent, widget)
+
+    -- Sanitize the input. This also filters out e.g. NaN.
+    width = math.max(0, width)
+    height = math.max(0, height)
 
     if not widget._private.visible then
+        record_fit(dep, context, width, height, 0, 0)
         return 0, 0
     end
 
-    -- Sanitize the input. This also filters out e.g. NaN.
-    width = math.max(0, width)
-    height = math.max(0, height)
+    validate_caches(widget)
 
     local w, h = 0, 0
     if widget.fit then
@@ -310,6 +441,7 @@ function base.fit_widget(parent, context, widget, width, height)
     -- Also sanitize the output.
     w = math.max(0, math.min(w, width))
     h = math.max(0, math.min(h, height))
+    record_fit(dep, context, width, height, w, h)
     return w, h
 end
 
@@ -328,12 +460,17 @@ end
 -- @treturn[opt] table The result from the widget's `:layout` callback.
 -- @function wibox.widget.base.layout_widget
 function base.layout_widget(parent, context, widget, width, height)
-    record_dependency(parent, widget)
+    local dep = record_dependency(parent, widget)
+    if dep then
+        dep.layout = true
+    end
 
     if not widget._private.visible then
         return
     end
 
+    validate_caches(widget)
+
     -- Sanitize the input. This also filters out e.g. NaN.
     width = math.max(0, width)
     height = math.max(0, height)
@@ -686,6 +823,7 @@ function base.make_widget(proxy, widget_name, args)
     clear_caches(ret)
     ret:connect_signal("widget::layout_changed", function()
         clear_caches(ret)
+        mark_suspects(ret)
     end)
 
     -- Add functions.
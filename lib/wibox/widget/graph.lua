@@ -19,9 +19,8 @@
 local setmetatable = setmetatable
 local ipairs = ipairs
 local math = math
-local table = table
-local type = type
 local color = require("gears.color")
+local cairo = require("lgi").cairo
 local base = require("wibox.widget.base")
 local beautiful = require("beautiful")
 
@@ -109,16 +108,152 @@ local properties = { "width", "height", "border_color", "stack",
                      "max_value", "scale", "min_value", "step_shape",
                      "step_spacing", "step_width" }
 
+-- Values are stored in ring buffers holding up to one value per pixel column,
+-- so that adding a value does not move all the others.
+local function ring_new()
+    return { data = {}, first = 1, len = 0, capacity = 0 }
+end
+
+--- Get the i-th newest value of a ring (starting with 0).
+local function ring_get_newest(ring, i)
+    return ring.data[(ring.first + ring.len - i - 2) % ring.capacity + 1]
+end
+
+--- Change the capacity of a ring, keeping the newest values.
+local function ring_resize(ring, capacity)
+    local len = math.min(ring.len, capacity)
+    local data = {}
+    for i = 1, len do
+        data[i] = ring_get_newest(ring, len - i)
+    end
+    ring.data, ring.first, ring.len, ring.capacity = data, 1, len, capacity
+end
+
+local function ring_push(ring, value, capacity)
+    if ring.capacity ~= capacity then
+        ring_resize(ring, capacity)
+    end
+    if capacity <= 0 then
+        return
+    end
+    if ring.len < capacity then
+        ring.data[(ring.first + ring.len - 1) % capacity + 1] = value
+        ring.len = ring.len + 1
+    else
+        ring.data[ring.first] = value
+        ring.first = ring.first % capacity + 1
+    end
+end
+
+--- Draw the columns for the values first..last (counted from the newest, which
+-- is 0) of a non-stacked graph.
+local function draw_columns(_graph, cr, first, last, height, min_value, max_value)
+    local values = _graph._private.values
+    local step_shape = _graph._private.step_shape
+    local step_spacing = _graph._private.step_spacing or 0
+    local step_width = _graph._private.step_width or 1
+
+    for i = first, last do
+        local value = ring_get_newest(values, i)
+        if value >= 0 then
+            local x = i*step_width + ((i-1)*step_spacing) + 0.5
+            value = (value - min_value) / max_value
+            cr:move_to(x, height * (1 - value))
+
+            if step_shape then
+                cr:translate(step_width + (i>1 and step_spacing or 0), height * (1 - value))
+                step_shape(cr, step_width, height)
+                cr:translate(0, -(height * (1 - value)))
+            elseif step_width > 1 then
+                cr:rectangle(x, height * (1 - value), step_width, height)
+            else
+                cr:line_to(x, height)
+            end
+        end
+    end
+    cr:set_source(color(_graph._private.color or beautiful.graph_fg or "#ff0000"))
+
+    if step_shape or step_width > 1 then
+        cr:fill()
+    else
+        cr:stroke()
+    end
+end
+
+--- Draw a non-stacked graph through a cached surface.
+-- When only new values were added since the last draw, the old content is
+-- scrolled by one step per new value and only the new columns are drawn.
+-- @return false if the graph cannot be cached in the current state.
+local function draw_cached(_graph, cr, width, height, min_value, max_value)
+    local p = _graph._private
+    local step_spacing = p.step_spacing or 0
+    local step_width = p.step_width or 1
+    local pitch = step_width + step_spacing
+
+    -- Only whole pixel steps and translations can be scrolled exactly
+    local m = cr:get_matrix()
+    if p.step_shape or pitch % 1 ~= 0 or m.xx ~= 1 or m.yy ~= 1 or m.xy ~= 0
+            or m.yx ~= 0 or m.x0 % 1 ~= 0 or m.y0 % 1 ~= 0 then
+        return false
+    end
+
+    local key = {
+        width = width, height = height, min_value = min_value, max_value = max_value,
+        color = p.color or beautiful.graph_fg or "#ff0000",
+        step_width = step_width, step_spacing = step_spacing
+    }
+    local cache = p.cache
+    local valid = cache ~= nil
+    for k, v in pairs(key) do
+        valid = valid and cache.key[k] == v
+    end
+
+    local added = valid and (p.values_added - cache.values_added) or math.huge
+    if added > 0 then
+        local surf = cr:get_target():create_similar(cairo.Content.COLOR_ALPHA, width, height)
+        local cache_cr = cairo.Context(surf)
+        local shift = added * pitch
+        local last_column
+        if shift < width then
+            -- Reuse the old content, moved to the right. Columns are drawn
+            -- with a half pixel offset, so the pixel column between the new
+            -- and the old content is drawn again, too.
+            cache_cr:set_source_surface(cache.surface, shift, 0)
+            cache_cr:paint()
+            cache_cr:rectangle(0, 0, shift + 1, height)
+            cache_cr:clip()
+            cache_cr.operator = cairo.Operator.CLEAR
+            cache_cr:paint()
+            cache_cr.operator = cairo.Operator.OVER
+            last_column = added
+        else
+            last_column = p.values.len - 1
+        end
+        if cache then
+            cache.surface:finish()
+        end
+
+        cache_cr:set_line_width(1)
+        if p.values.len ~= 0 then
+            draw_columns(_graph, cache_cr, 0, math.min(last_column, p.values.len - 1),
+                height, min_value, max_value)
+        end
+
+        cache = { key = key, surface = surf, values_added = p.values_added }
+        p.cache = cache
+    end
+
+    cr:set_source_surface(cache.surface, 0, 0)
+    cr:paint()
+    return true
+end
+
 function graph.draw(_graph, _, cr, width, height)
     local max_value = _graph._private.max_value
     local min_value = _graph._private.min_value or (
         _graph._private.scale and math.huge or 0)
     local values = _graph._private.values
 
-    local step_shape = _graph._private.step_shape
-    local step_spacing = _graph._private.step_spacing or 0
-    local step_width = _graph._private.step_width or 1
-
     cr:set_line_width(1)
 
     -- Draw the background first
@@ -134,10 +269,12 @@ function graph.draw(_graph, _, cr, width, height)
 
     -- Draw a stacked graph
     if _graph._private.stack then
+        local stacks = _graph._private.stacks
 
         if _graph._private.scale then
-            for _, v in ipairs(values) do
-                for _, sv in ipairs(v) do
+            for _, v in pairs(stacks) do
+                for i = 0, v.len - 1 do
+                    local sv = ring_get_newest(v, i)
                     if sv > max_value then
                         max_value = sv
                     end
@@ -154,9 +291,9 @@ function graph.draw(_graph, _, cr, width, height)
 
             if _graph._private.stack_colors then
                 for idx, col in ipairs(_graph._private.stack_colors) do
-                    local stack_values = values[idx]
-                    if stack_values and i < #stack_values then
-                        local value = stack_values[#stack_values - i] + rel_i
+                    local stack_values = stacks[idx]
+                    if stack_values and i < stack_values.len then
+                        local value = ring_get_newest(stack_values, i) + rel_i
                         cr:move_to(rel_x, height * (1 - (rel_i / max_value)))
                         cr:line_to(rel_x, height * (1 - (value / max_value)))
                         cr:set_source(color(col or beautiful.graph_fg or "#ff0000"))
@@ -168,7 +305,8 @@ function graph.draw(_graph, _, cr, width, height)
         end
     else
         if _graph._private.scale then
-            for _, v in ipairs(values) do
+            for i = 0, values.len - 1 do
+                local v = ring_get_newest(values, i)
                 if v > max_value then
                     max_value = v
                 end
@@ -178,36 +316,12 @@ function graph.draw(_graph, _, cr, width, height)
             end
         end
 
-        -- Draw the background on no value
-        if #values ~= 0 then
-            -- Draw reverse
-            for i = 0, #values - 1 do
-                local value = values[#values - i]
-                if value >= 0 then
-                    local x = i*step_width + ((i-1)*step_spacing) + 0.5
-                    value = (value - min_value) / max_value
-                    cr:move_to(x, height * (1 - value))
-
-                    if step_shape then
-                        cr:translate(step_width + (i>1 and step_spacing or 0), height * (1 - value))
-                        step_shape(cr, step_width, height)
-                        cr:translate(0, -(height * (1 - value)))
-                    elseif step_width > 1 then
-                        cr:rectangle(x, height * (1 - value), step_width, height)
-                    else
-                        cr:line_to(x, height)
-                    end
-                end
-            end
-            cr:set_source(color(_graph._private.color or beautiful.graph_fg or "#ff0000"))
-
-            if step_shape or step_width > 1 then
-                cr:fill()
-            else
-                cr:stroke()
+        if not draw_cached(_graph, cr, width, height, min_value, max_value) then
+            -- Draw the background on no value
+            if values.len ~= 0 then
+                draw_columns(_graph, cr, 0, values.len - 1, height, min_value, max_value)
             end
         end
-
     end
 
     -- Undo the cr:translate() for the border and step shapes
@@ -243,22 +357,19 @@ function graph:add_value(value, group)
     end
 
     if self._private.stack and group then
-        if not  self._private.values[group]
-        or type(self._private.values[group]) ~= "table"
-        then
-            self._private.values[group] = {}
+        if not self._private.stacks[group] then
+            self._private.stacks[group] = ring_new()
         end
-        values = self._private.values[group]
+        values = self._private.stacks[group]
+    else
+        self._private.values_added = self._private.values_added + 1
     end
-    table.insert(values, value)
 
     local border_width = 0
     if self._private.border_color then border_width = 2 end
 
     -- Ensure we never have more data than we can draw
-    while #values > self._private.width - border_width do
-        table.remove(values, 1)
-    end
+    ring_push(values, value, self._private.width - border_width)
 
     self:emit_signal("widget::redraw_needed")
     return self
@@ -266,7 +377,9 @@ end
 
 --- Clear the graph.
 function graph:clear()
-    self._private.values = {}
+    self._private.values = ring_new()
+    self._private.stacks = {}
+    self._private.cache = nil
     self:emit_signal("widget::redraw_needed")
     return self
 end
@@ -326,7 +439,9 @@ function graph.new(args)
 
     _graph._private.width     = width
     _graph._private.height    = height
-    _graph._private.values    = {}
+    _graph._private.values    = ring_new()
+    _graph._private.stacks    = {}
+    _graph._private.values_added = 0
     _graph._private.max_value = 1
 
     -- Set methods
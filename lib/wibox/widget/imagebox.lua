@@ -8,24 +8,69 @@
 
 local base = require("wibox.widget.base")
 local surface = require("gears.surface")
+local gdebug = require("gears.debug")
+local cairo = require("lgi").cairo
 local gtable = require("gears.table")
 local setmetatable = setmetatable
 local type = type
 local print = print
+local ipairs = ipairs
 local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
 
 local imagebox = { mt = {} }
 
+--- The maximum number of scaled copies kept for each image.
+-- Images which are shown at more sizes are scaled again when drawn.
+-- @tfield integer wibox.widget.imagebox.scaled_cache_size
+imagebox.scaled_cache_size = 4
+
+-- Image -> list of { width, height, surface }, most recently used first. The
+-- copies are shared between all imageboxes showing the same image.
+imagebox._scaled_cache = setmetatable({}, { __mode = "k" })
+
+-- Get a copy of an image scaled to the given size in device pixels.
+local function get_scaled(image, width, height)
+    local copies = imagebox._scaled_cache[image]
+    if not copies then
+        copies = {}
+        imagebox._scaled_cache[image] = copies
+    end
+
+    for i, copy in ipairs(copies) do
+        if copy[1] == width and copy[2] == height then
+            if i > 1 then
+                table.remove(copies, i)
+                table.insert(copies, 1, copy)
+            end
+            return copy[3]
+        end
+    end
+
+    local scaled = cairo.ImageSurface(cairo.Format.ARGB32, width, height)
+    local cr = cairo.Context(scaled)
+    cr:scale(width / image.width, height / image.height)
+    cr:set_source_surface(image, 0, 0)
+    -- This is done once, so use the best filter for downscaling icons
+    cr:get_source():set_filter(cairo.Filter.BEST)
+    cr:paint()
+    scaled:flush()
+
+    table.insert(copies, 1, { width, height, scaled })
+    copies[imagebox.scaled_cache_size + 1] = nil
+    return scaled
+end
+
 -- Draw an imagebox with the given cairo context in the given geometry.
 function imagebox:draw(_, cr, width, height)
-    if not self._private.image then return end
+    local image = self._private.image
+    if not image then return end
     if width == 0 or height == 0 then return end
 
+    local w, h = self._private.image_width, self._private.image_height
+    local aspect = 1
     if not self._private.resize_forbidden then
         -- Let's scale the image so that it fits into (width, height)
-        local w = self._private.image:get_width()
-        local h = self._private.image:get_height()
-        local aspect = width / w
+        aspect = width / w
         local aspect_h = height / h
         if aspect > aspect_h then aspect = aspect_h end
 
@@ -37,7 +82,19 @@ function imagebox:draw(_, cr, width, height)
         cr:clip(self._private.clip_shape(cr, width, height, unpack(self._private.clip_args)))
     end
 
-    cr:set_source_surface(self._private.image, 0, 0)
+    -- Paint a copy with the size the image has on the device, unless the
+    -- image is rotated or skewed
+    local m = cr.matrix
+    if m.xy == 0 and m.yx == 0 and m.xx > 0 and m.yy > 0 then
+        local sw = math.max(1, math.floor(w * m.xx + 0.5))
+        local sh = math.max(1, math.floor(h * m.yy + 0.5))
+        if sw ~= w or sh ~= h then
+            cr:scale(w / sw, h / sh)
+            image = get_scaled(image, sw, sh)
+        end
+    end
+
+    cr:set_source_surface(image, 0, 0)
     cr:paint()
 end
 
@@ -47,8 +104,14 @@ function imagebox:fit(_, width, height)
         return 0, 0
     end
 
-    local w = self._private.image:get_width()
-    local h = self._private.image:get_height()
+    -- The result only depends on the available space
+    local last = self._private.last_fit
+    if last and last[1] == width and last[2] == height then
+        return last[3], last[4]
+    end
+
+    local w = self._private.image_width
+    local h = self._private.image_height
 
     if w > width then
         h = h * width / w
@@ -60,10 +123,8 @@ function imagebox:fit(_, width, height)
     end
 
     if h == 0 or w == 0 then
-        return 0, 0
-    end
-
-    if not self._private.resize_forbidden then
+        w, h = 0, 0
+    elseif not self._private.resize_forbidden then
         local aspect = width / w
         local aspect_h = height / h
 
@@ -73,6 +134,7 @@ function imagebox:fit(_, width, height)
         w, h = w * aspect, h * aspect
     end
 
+    self._private.last_fit = { width, height, w, h }
     return w, h
 end
 
@@ -81,6 +143,9 @@ end
 -- @param image Either a string or a cairo image surface. A string is
 --   interpreted as the path to a png image file.
 -- @return true on success, false if the image cannot be used
+--
+-- Scaled copies of images are cached. When an image surface is modified, set
+-- it again so that they are updated.
 
 function imagebox:set_image(image)
     if type(image) == "string" then
@@ -103,17 +168,68 @@ function imagebox:set_image(image)
 
     if self._private.image == image then
         -- The image could have been modified, so better redraw
+        if image then
+            imagebox._scaled_cache[image] = nil
+        end
+        self._private.async_token = nil
         self:emit_signal("widget::redraw_needed")
         return true
     end
 
     self._private.image = image
+    self._private.async_token = nil
+    self._private.async_image = nil
+    self._private.image_width = image and image.width
+    self._private.image_height = image and image.height
+    self._private.last_fit = nil
 
     self:emit_signal("widget::redraw_needed")
     self:emit_signal("widget::layout_changed")
     return true
 end
 
+--- The image shown while an `async_image` is being loaded.
+-- @property placeholder
+-- @param placeholder A cairo image surface or nil, for no image. It has to be
+--   set before `async_image`.
+
+function imagebox:set_placeholder(placeholder)
+    self._private.placeholder = placeholder
+end
+
+function imagebox:get_placeholder()
+    return self._private.placeholder
+end
+
+--- Load the image from a file without blocking awesome.
+-- The file is decoded by a worker thread, see `gears.surface.load_async`. The
+-- `placeholder` is shown until this is done, and also when the file cannot be
+-- loaded.
+-- @property async_image
+-- @tparam string path The file name.
+
+function imagebox:set_async_image(path)
+    self:set_image(self._private.placeholder)
+
+    local token = {}
+    self._private.async_token = token
+    self._private.async_image = path
+    surface.load_async(path, function(image, err)
+        -- Another image was set in the meantime
+        if self._private.async_token ~= token then return end
+        if not image then
+            gdebug.print_warning("Failed to load '" .. tostring(path) .. "': " .. tostring(err))
+            return
+        end
+        self:set_image(image)
+        self._private.async_image = path
+    end)
+end
+
+function imagebox:get_async_image()
+    return self._private.async_image
+end
+
 --- Set a clip shape for this imagebox
 -- A clip shape define an area where the content is displayed and one where it
 -- is trimmed.
@@ -145,6 +261,7 @@ end
 
 function imagebox:set_resize(allowed)
     self._private.resize_forbidden = not allowed
+    self._private.last_fit = nil
     self:emit_signal("widget::redraw_needed")
     self:emit_signal("widget::layout_changed")
 end
@@ -6,21 +6,10 @@
 
 local cairo = require("lgi").cairo
 local hierarchy = require("wibox.hierarchy")
+local lazy_require = require("gears.lazy_require")
 
 local widget = {
     base = require("wibox.widget.base");
-    textbox = require("wibox.widget.textbox");
-    imagebox = require("wibox.widget.imagebox");
-    background = require("wibox.widget.background");
-    systray = require("wibox.widget.systray");
-    textclock = require("wibox.widget.textclock");
-    progressbar = require("wibox.widget.progressbar");
-    graph = require("wibox.widget.graph");
-    checkbox = require("wibox.widget.checkbox");
-    piechart = require("wibox.widget.piechart");
-    slider = require("wibox.widget.slider");
-    calendar = require("wibox.widget.calendar");
-    separator = require("wibox.widget.separator");
 }
 
 setmetatable(widget, {
@@ -29,6 +18,21 @@ setmetatable(widget, {
     end
 })
 
+lazy_require(widget, {
+    textbox = "wibox.widget.textbox";
+    imagebox = "wibox.widget.imagebox";
+    background = "wibox.widget.background";
+    systray = "wibox.widget.systray";
+    textclock = "wibox.widget.textclock";
+    progressbar = "wibox.widget.progressbar";
+    graph = "wibox.widget.graph";
+    checkbox = "wibox.widget.checkbox";
+    piechart = "wibox.widget.piechart";
+    slider = "wibox.widget.slider";
+    calendar = "wibox.widget.calendar";
+    separator = "wibox.widget.separator";
+})
+
 --- Draw a widget directly to a given cairo context.
 -- This function creates a temporary `wibox.hierarchy` instance and uses that to
 -- draw the given widget once to the given cairo context.
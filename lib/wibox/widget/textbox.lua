@@ -21,6 +21,12 @@ local textbox = { mt = {} }
 --- The textbox font.
 -- @beautiful beautiful.font
 
+-- Sizes of laid out texts, shared by all textboxes. Tasklists and popups lay
+-- out the same texts at the same sizes over and over again and every layout
+-- run through Pango is expensive.
+local size_cache, size_cache_entries = {}, 0
+local size_cache_max_entries = 1000
+
 --- Set the DPI of a Pango layout
 local function setup_dpi(box, dpi)
     assert(dpi, "No DPI provided")
@@ -31,40 +37,68 @@ local function setup_dpi(box, dpi)
     end
 end
 
+--- Remember the properties of the layout which change its size
+local function update_style_key(box)
+    local p = box._private
+    p.style_key = table.concat({ p.font_key or "", p.ellipsize or "",
+        p.wrap or "", p.align or "" }, "\0")
+end
+
 --- Setup a pango layout for the given textbox and dpi
+-- Width and height are in Pango units.
 local function setup_layout(box, width, height, dpi)
-    box._private.layout.width = Pango.units_from_double(width)
-    box._private.layout.height = Pango.units_from_double(height)
+    box._private.layout.width = width
+    box._private.layout.height = height
     setup_dpi(box, dpi)
 end
 
+--- Get the logical size of the layout in pixels, preferably from the cache.
+-- Width and height are in Pango units.
+local function layout_size(box, width, height, dpi)
+    local p = box._private
+    local key = table.concat({ p.content_key, p.style_key, width, height, dpi }, "\0")
+    local size = size_cache[key]
+    if not size then
+        setup_layout(box, width, height, dpi)
+        local _, logical = p.layout:get_pixel_extents()
+        size = { logical.width, logical.height }
+        if size_cache_entries >= size_cache_max_entries then
+            size_cache, size_cache_entries = {}, 0
+        end
+        size_cache[key] = size
+        size_cache_entries = size_cache_entries + 1
+    end
+    return size[1], size[2]
+end
+
 -- Draw the given textbox on the given cairo context in the given geometry
 function textbox:draw(context, cr, width, height)
-    setup_layout(self, width, height, context.dpi)
+    local w, h = Pango.units_from_double(width), Pango.units_from_double(height)
+    local _, logical_height = layout_size(self, w, h, context.dpi)
+    setup_layout(self, w, h, context.dpi)
     cr:update_layout(self._private.layout)
-    local _, logical = self._private.layout:get_pixel_extents()
     local offset = 0
     if self._private.valign == "center" then
-        offset = (height - logical.height) / 2
+        offset = (height - logical_height) / 2
     elseif self._private.valign == "bottom" then
-        offset = height - logical.height
+        offset = height - logical_height
     end
     cr:move_to(0, offset)
     cr:show_layout(self._private.layout)
 end
 
-local function do_fit_return(self)
-    local _, logical = self._private.layout:get_pixel_extents()
-    if logical.width == 0 or logical.height == 0 then
+local function do_fit_return(self, width, height, dpi)
+    local w, h = layout_size(self, width, height, dpi)
+    if w == 0 or h == 0 then
         return 0, 0
     end
-    return logical.width, logical.height
+    return w, h
 end
 
 -- Fit the given textbox
 function textbox:fit(context, width, height)
-    setup_layout(self, width, height, context.dpi)
-    return do_fit_return(self)
+    return do_fit_return(self, Pango.units_from_double(width),
+        Pango.units_from_double(height), context.dpi)
 end
 
 --- Get the preferred size of a textbox.
@@ -110,10 +144,8 @@ end
 -- @treturn number The preferred height.
 function textbox:get_preferred_size_at_dpi(dpi)
     local max_lines = 2^20
-    setup_dpi(self, dpi)
-    self._private.layout.width = -1 -- no width set
-    self._private.layout.height = -max_lines -- show this many lines per paragraph
-    return do_fit_return(self)
+    -- No width set and show this many lines per paragraph
+    return do_fit_return(self, -1, -max_lines, dpi)
 end
 
 --- Get the preferred height of a textbox at a given width.
@@ -124,13 +156,37 @@ end
 -- @treturn number The needed height.
 function textbox:get_height_for_width_at_dpi(width, dpi)
     local max_lines = 2^20
-    setup_dpi(self, dpi)
-    self._private.layout.width = Pango.units_from_double(width)
-    self._private.layout.height = -max_lines -- show this many lines per paragraph
-    local _, h = do_fit_return(self)
+    -- Show this many lines per paragraph
+    local _, h = do_fit_return(self, Pango.units_from_double(width), -max_lines, dpi)
     return h
 end
 
+local measure_box
+
+--- Get the preferred sizes of several texts.
+-- This is faster than creating a textbox per text: A single Pango layout is
+-- reused and the results are shared with the layout cache of all textboxes.
+-- @tparam table texts An array of texts with Pango markup. Texts with invalid
+--   markup are measured as plain text.
+-- @tparam integer|screen s The screen on which the texts will be displayed.
+-- @tparam[opt=beautiful.font] string font The font to use.
+-- @treturn table An array with a `width` and `height` table for each text.
+-- @function wibox.widget.textbox.get_preferred_sizes
+function textbox.get_preferred_sizes(texts, s, font)
+    measure_box = measure_box or textbox()
+    measure_box:set_font(font or (beautiful and beautiful.font))
+    local dpi = screen[s].dpi
+    local result = {}
+    for i, text in ipairs(texts) do
+        if not measure_box:set_markup_silently(text) then
+            measure_box:set_text(text)
+        end
+        local width, height = measure_box:get_preferred_size_at_dpi(dpi)
+        result[i] = { width = width, height = height }
+    end
+    return result
+end
+
 --- Set the text of the textbox (with
 -- [Pango markup](https://developer.gnome.org/pango/stable/PangoMarkupFormat.html)).
 -- @tparam string text The text to set. This can contain pango markup (e.g.
@@ -151,6 +207,7 @@ function textbox:set_markup_silently(text)
     end
 
     self._private.markup = text
+    self._private.content_key = "m" .. text
     self._private.layout.text = parsed
     self._private.layout.attributes = attr
     self:emit_signal("widget::redraw_needed")
@@ -187,6 +244,7 @@ function textbox:set_text(text)
         return
     end
     self._private.markup = nil
+    self._private.content_key = "t" .. text
     self._private.layout.text = text
     self._private.layout.attributes = nil
     self:emit_signal("widget::redraw_needed")
@@ -208,6 +266,8 @@ function textbox:set_ellipsize(mode)
             return
         end
         self._private.layout:set_ellipsize(allowed[mode])
+        self._private.ellipsize = mode
+        update_style_key(self)
         self:emit_signal("widget::redraw_needed")
         self:emit_signal("widget::layout_changed")
     end
@@ -224,6 +284,8 @@ function textbox:set_wrap(mode)
             return
         end
         self._private.layout:set_wrap(allowed[mode])
+        self._private.wrap = mode
+        update_style_key(self)
         self:emit_signal("widget::redraw_needed")
         self:emit_signal("widget::layout_changed")
     end
@@ -256,6 +318,8 @@ function textbox:set_align(mode)
             return
         end
         self._private.layout:set_alignment(allowed[mode])
+        self._private.align = mode
+        update_style_key(self)
         self:emit_signal("widget::redraw_needed")
         self:emit_signal("widget::layout_changed")
     end
@@ -266,7 +330,10 @@ end
 -- @param font The font description as string
 
 function textbox:set_font(font)
-    self._private.layout:set_font_description(beautiful.get_font(font))
+    local description = beautiful.get_font(font)
+    self._private.layout:set_font_description(description)
+    self._private.font_key = description:to_string()
+    update_style_key(self)
     self:emit_signal("widget::redraw_needed")
     self:emit_signal("widget::layout_changed")
 end
@@ -282,6 +349,8 @@ local function new(text, ignore_markup)
     gtable.crush(ret, textbox, true)
 
     ret._private.dpi = -1
+    ret._private.content_key = "t"
+    update_style_key(ret)
     ret._private.ctx = PangoCairo.font_map_get_default():create_context()
     ret._private.layout = Pango.Layout.new(ret._private.ctx)
 
@@ -41,19 +41,25 @@
 #include "luaa.h"
 #include "globalconf.h"
 #include "awesome.h"
+#include "bytecode.h"
 #include "common/backtrace.h"
+#include "common/pixels.h"
 #include "common/version.h"
 #include "config.h"
+#include "control.h"
 #include "event.h"
 #include "objects/client.h"
 #include "objects/drawable.h"
 #include "objects/drawin.h"
 #include "objects/screen.h"
 #include "objects/tag.h"
+#include "profile.h"
 #include "property.h"
+#include "sampler.h"
 #include "selection.h"
 #include "spawn.h"
 #include "systray.h"
+#include "thumbnail.h"
 #include "xkb.h"
 #include "xrdb.h"
 
@@ -65,6 +71,7 @@
 
 #include <xcb/xcb_atom.h>
 #include <xcb/xcb_aux.h>
+#include <xcb/xcbext.h>
 
 #include <unistd.h> /* for gethostname() */
 
@@ -146,6 +153,13 @@ extern const struct luaL_Reg awesome_mouse_meta[];
  * @signal refresh
  */
 
+/** Emitted at the end of each refresh, after the changes were sent to the X
+ * server.
+ *
+ * `gears.scheduler` uses it for work that should not delay drawing.
+ * @signal refreshed
+ */
+
 /** Awesome is about to enter the event loop.
  *
  * This means all initialization has been done.
@@ -274,6 +288,7 @@ luaA_kill(lua_State *L)
 /** Synchronize with the X11 server. This is needed in the test suite to avoid
  * some race conditions. You should never need to use this function.
  * @function sync
+ * @see after_sync
  */
 static int
 luaA_sync(lua_State *L)
@@ -282,6 +297,86 @@ luaA_sync(lua_State *L)
     return 0;
 }
 
+/** A pending awesome.after_sync() callback */
+typedef struct
+{
+    /** The sequence number of the request marking the fence */
+    unsigned int sequence;
+    /** The callback, in the registry */
+    int callback;
+    /** Was the reply to the request received? */
+    bool done;
+} sync_fence_t;
+
+DO_ARRAY(sync_fence_t, sync_fence, DO_NOTHING)
+
+/** The pending fences, in request order */
+static sync_fence_array_t sync_fences;
+
+/** Call a function once the X server handled all requests sent until now.
+ *
+ * Unlike `awesome.sync`, this does not wait for the X server. A cheap request
+ * is sent and awesome keeps handling events; the function is called from the
+ * main loop once its reply was received. Functions are called in the order
+ * they were given.
+ *
+ * @tparam function callback The function to call, without arguments.
+ * @function after_sync
+ * @see sync
+ */
+static int
+luaA_after_sync(lua_State *L)
+{
+    sync_fence_t fence = { .done = false };
+
+    luaA_registerfct(L, 1, &fence.callback);
+    fence.sequence = xcb_get_input_focus(globalconf.connection).sequence;
+    sync_fence_array_append(&sync_fences, fence);
+    return 0;
+}
+
+/** Collect the replies of the fences which were already received, without
+ * waiting for the X server.
+ * \return True if callbacks are ready to be called.
+ */
+bool
+luaA_sync_fences_poll(void)
+{
+    foreach(fence, sync_fences)
+    {
+        if(fence->done)
+            continue;
+
+        void *reply = NULL;
+        xcb_generic_error_t *error = NULL;
+        /* Replies arrive in request order */
+        if(!xcb_poll_for_reply(globalconf.connection, fence->sequence, &reply, &error))
+            break;
+        p_delete(&reply);
+        p_delete(&error);
+        fence->done = true;
+    }
+    return sync_fences.len > 0 && sync_fences.tab[0].done;
+}
+
+/** Call the callbacks of all fences whose reply was received.
+ * \param L The Lua VM state.
+ */
+void
+luaA_sync_fences_run(lua_State *L)
+{
+    luaA_sync_fences_poll();
+
+    /* Callbacks can add new fences, which are not done yet */
+    while(sync_fences.len > 0 && sync_fences.tab[0].done)
+    {
+        sync_fence_t fence = sync_fence_array_take(&sync_fences, 0);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, fence.callback);
+        luaA_unregister(L, &fence.callback);
+        luaA_dofunction(L, 0, 0);
+    }
+}
+
 /** Translate a GdkPixbuf to a cairo image surface..
  *
  * @param pixbuf The pixbuf as a light user datum.
@@ -330,6 +425,119 @@ luaA_load_image(lua_State *L)
     return 1;
 }
 
+/** Maximum number of threads decoding images for awesome.load_image_async() */
+#define IMAGE_LOAD_THREADS 2
+
+/** An image decoded by awesome.load_image_async() */
+typedef struct
+{
+    /** The file to load */
+    char *path;
+    /** The size to decode it at, or 0 */
+    int width, height;
+    /** The callback, in the registry */
+    int callback;
+    /** The result, set by the worker thread */
+    cairo_surface_t *surface;
+    GError *error;
+} image_load_t;
+
+static GThreadPool *image_load_pool;
+
+/** Call the callback of a loaded image, on the main thread.
+ * \param data The image_load_t.
+ * \return G_SOURCE_REMOVE.
+ */
+static gboolean
+image_load_finish(gpointer data)
+{
+    image_load_t *load = data;
+    lua_State *L = globalconf_get_lua_State();
+    int nargs = 1;
+
+    if (load->surface)
+        /* lua has to make sure to free the ref or we have a leak */
+        lua_pushlightuserdata(L, load->surface);
+    else
+    {
+        lua_pushnil(L);
+        lua_pushstring(L, load->error ? load->error->message : "cannot load image");
+        nargs = 2;
+    }
+    if (load->error)
+        g_error_free(load->error);
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, load->callback);
+    luaA_unregister(L, &load->callback);
+    luaA_dofunction(L, nargs, 0);
+
+    p_delete(&load->path);
+    p_delete(&load);
+    return G_SOURCE_REMOVE;
+}
+
+/** Decode an image, on a worker thread.
+ * \param data The image_load_t.
+ * \param user_data Unused.
+ */
+static void
+image_load_run(gpointer data, gpointer user_data)
+{
+    image_load_t *load = data;
+    GdkPixbuf *buf;
+
+    if (load->width > 0 || load->height > 0)
+        buf = gdk_pixbuf_new_from_file_at_scale(load->path,
+                                                load->width > 0 ? load->width : -1,
+                                                load->height > 0 ? load->height : -1,
+                                                TRUE, &load->error);
+    else
+        buf = gdk_pixbuf_new_from_file(load->path, &load->error);
+
+    if (buf)
+    {
+        load->surface = draw_surface_from_pixbuf(buf);
+        g_object_unref(buf);
+    }
+    g_idle_add(image_load_finish, load);
+}
+
+/** Load an image from a given path without blocking.
+ *
+ * The image is decoded by a worker thread. The callback is called from the
+ * main loop once this is done, never before this function returns.
+ *
+ * @tparam string name The file name.
+ * @tparam function callback Called with a cairo surface as light user datum
+ *   on success, or with nil and an error message.
+ * @tparam[opt] integer width The width to decode the image at. Vector images
+ *   are rendered at this size. The aspect ratio is kept.
+ * @tparam[opt] integer height The height to decode the image at.
+ * @function load_image_async
+ */
+static int
+luaA_load_image_async(lua_State *L)
+{
+    const char *filename = luaL_checkstring(L, 1);
+    int width = luaL_optinteger(L, 3, 0);
+    int height = luaL_optinteger(L, 4, 0);
+    luaA_checkfunction(L, 2);
+
+    image_load_t *load = p_new(image_load_t, 1);
+    load->width = width;
+    load->height = height;
+    load->path = a_strdup(filename);
+    luaA_register(L, 2, &load->callback);
+
+    /* Let the main thread pick the pixel conversion code */
+    pixels_kernels();
+    if (!image_load_pool)
+        image_load_pool = g_thread_pool_new(image_load_run, NULL, IMAGE_LOAD_THREADS,
+                                            FALSE, NULL);
+    g_thread_pool_push(image_load_pool, load, NULL);
+    return 0;
+}
+
 /** Set the preferred size for client icons.
  *
  * The closest equal or bigger size is picked if present, otherwise the closest
@@ -345,6 +553,178 @@ luaA_set_preferred_icon_size(lua_State *L)
     return 0;
 }
 
+/** Enable or disable the merging of redundant X11 events.
+ *
+ * When enabled (the default), events read from the X server in one go are
+ * simplified before being handled: only the last property change per window
+ * and property is handled, configure requests for the same window are merged
+ * and expose events for the same window are merged.
+ *
+ * @tparam boolean enabled Whether events should be merged.
+ * @function set_event_coalescing
+ */
+static int
+luaA_set_event_coalescing(lua_State *L)
+{
+    globalconf.event_coalescing = luaA_checkboolean(L, 1);
+    return 0;
+}
+
+/** Enable or disable always asking the X server for the pointer position.
+ *
+ * By default, `mouse.coords` and `mouse.screen` use the position of the
+ * pointer in the last input event awesome received, or the last position
+ * asked for, as long as awesome did not sleep since. When enabled, every
+ * use asks the X server for the position instead, which is slower, but never
+ * misses movements inside of client windows during long running callbacks.
+ *
+ * @tparam boolean enabled Whether the X server should always be asked.
+ * @function set_pointer_strict
+ * @see mouse.coords
+ */
+static int
+luaA_set_pointer_strict(lua_State *L)
+{
+    globalconf.pointer_strict = luaA_checkboolean(L, 1);
+    return 0;
+}
+
+/** Enable or disable grabbing the server while awesome moves windows.
+ *
+ * When windows are mapped, moved or restacked, the enter and leave events this
+ * generates are ignored. When enabled (the default), the X server is grabbed
+ * meanwhile, so that only awesome can cause events in that time. When
+ * disabled, other clients are not stalled by these grabs, but enter and leave
+ * events caused by them during that time are ignored as well.
+ *
+ * @tparam boolean enabled Whether the server should be grabbed.
+ * @function set_enterleave_grab
+ */
+static int
+luaA_set_enterleave_grab(lua_State *L)
+{
+    globalconf.enter_leave_grab = luaA_checkboolean(L, 1);
+    return 0;
+}
+
+/** Enable or disable the tracing of X replies, see `awesome.xcb_stats`.
+ *
+ * Enabling it does not reset the statistics gathered before.
+ *
+ * @tparam boolean enabled Whether X replies should be traced.
+ * @function set_xcb_tracing
+ */
+static int
+luaA_set_xcb_tracing(lua_State *L)
+{
+    xtrace_enabled = luaA_checkboolean(L, 1);
+    return 0;
+}
+
+/** Set how drawables are rendered.
+ *
+ * The `"xcb"` backend, the default, lets cairo draw to the pixmaps of
+ * drawables in the X server with X RENDER requests. With `"image"`, cairo
+ * draws to client memory and only the refreshed parts are uploaded, through
+ * MIT-SHM if the X server supports it. This is usually faster on remote and
+ * software-rendered X servers.
+ *
+ * With `"threaded"`, drawing is recorded instead. When the drawable is
+ * refreshed, a worker thread replays the recording into client memory and
+ * the main loop uploads the result once it is done, so that big redraws do
+ * not delay event handling. The worker thread cannot talk to the X server,
+ * so everything painted to a threaded drawable has to be in client memory:
+ * its `backdrop` is, and images loaded with `gears.surface` are too.
+ *
+ * Drawables get a surface with the new backend when they are resized, unless
+ * their `backend` property asks for a specific one.
+ *
+ * @tparam string backend `"xcb"`, `"image"` or `"threaded"`.
+ * @function set_drawable_backend
+ */
+static int
+luaA_set_drawable_backend(lua_State *L)
+{
+    drawable_backend_t backend = luaA_checkdrawable_backend(L, 1);
+    luaL_argcheck(L, backend != DRAWABLE_BACKEND_DEFAULT, 1, "expected \"xcb\", \"image\" or \"threaded\"");
+    drawable_set_default_backend(backend);
+    return 0;
+}
+
+/** Set how often client thumbnails are updated at most.
+ *
+ * Changes of a client window are collected and copied to its `thumbnail`
+ * together, at most this many times per second.
+ *
+ * @tparam integer rate The number of updates per second, 10 by default.
+ * @function set_thumbnail_rate
+ * @see client.thumbnail
+ */
+static int
+luaA_set_thumbnail_rate(lua_State *L)
+{
+    int rate = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, rate > 0, 1, "the rate must be positive");
+    thumbnail_set_rate(rate);
+    return 0;
+}
+
+/** Check if X events are waiting to be handled.
+ *
+ * Long running work can use this to stop early and continue in a later main
+ * loop iteration, so that input is not delayed.
+ *
+ * @treturn boolean True if there is at least one event.
+ * @function has_pending_events
+ * @see gears.scheduler
+ */
+static int
+luaA_has_pending_events(lua_State *L)
+{
+    /* The event is kept for the event loop, which looks here first */
+    if(!globalconf.pending_event)
+        globalconf.pending_event = xcb_poll_for_event(globalconf.connection);
+    lua_pushboolean(L, globalconf.pending_event != NULL);
+    return 1;
+}
+
+/** Run another main loop iteration right away.
+ *
+ * Normally, awesome sleeps after a refresh until an event or a timer wakes
+ * it up. After this was called during a refresh, it does not sleep and emits
+ * `refresh` and `refreshed` again.
+ *
+ * @function request_refresh
+ * @see gears.scheduler
+ */
+static int
+luaA_request_refresh(lua_State *L)
+{
+    globalconf.refresh_requested = true;
+    return 0;
+}
+
+/** Run an incremental garbage collection step after each main loop iteration.
+ *
+ * Destroyed clients and drawables only give their memory back once the Lua
+ * garbage collector frees them. By default this happens whenever Lua decides
+ * to collect, which can be a long full cycle at an unfortunate time. With a
+ * step size, a small part of the collection work is done every time awesome
+ * is about to go idle.
+ *
+ * @tparam integer size The amount of work per step, in KiB of allocated
+ *   memory, or 0 to disable the steps (the default).
+ * @function set_gc_step
+ */
+static int
+luaA_set_gc_step(lua_State *L)
+{
+    int size = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, size >= 0, 1, "the step size must not be negative");
+    globalconf.gc_step = size;
+    return 0;
+}
+
 /** UTF-8 aware string length computing.
  * \param L The Lua VM state.
  * \return The number of elements pushed on stack.
@@ -557,6 +937,19 @@ luaA_awesome_emit_signal(lua_State *L)
     return 0;
 }
 
+/** The allocator of the Lua VM, wrapped by luaA_alloc() */
+static lua_Alloc lua_default_alloc;
+static void *lua_default_alloc_ud;
+
+/** Lua allocator counting (re)allocations in a_alloc_count. */
+static void *
+luaA_alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+    if(nsize > 0)
+        a_alloc_count++;
+    return lua_default_alloc(ud, ptr, osize, nsize);
+}
+
 static int
 luaA_panic(lua_State *L)
 {
@@ -793,14 +1186,27 @@ luaA_init(xdgHandle* xdg, string_array_t *searchpath)
         { "quit", luaA_quit },
         { "exec", luaA_exec },
         { "spawn", luaA_spawn },
+        { "spawn_read", luaA_spawn_read },
+        { "control_listen", luaA_control_listen },
+        { "control_close", luaA_control_close },
         { "restart", luaA_restart },
         { "connect_signal", luaA_awesome_connect_signal },
         { "disconnect_signal", luaA_awesome_disconnect_signal },
         { "emit_signal", luaA_awesome_emit_signal },
         { "systray", luaA_systray },
         { "load_image", luaA_load_image },
+        { "load_image_async", luaA_load_image_async },
         { "pixbuf_to_surface", luaA_pixbuf_to_surface },
         { "set_preferred_icon_size", luaA_set_preferred_icon_size },
+        { "set_event_coalescing", luaA_set_event_coalescing },
+        { "set_pointer_strict", luaA_set_pointer_strict },
+        { "set_enterleave_grab", luaA_set_enterleave_grab },
+        { "set_xcb_tracing", luaA_set_xcb_tracing },
+        { "set_drawable_backend", luaA_set_drawable_backend },
+        { "set_gc_step", luaA_set_gc_step },
+        { "set_thumbnail_rate", luaA_set_thumbnail_rate },
+        { "has_pending_events", luaA_has_pending_events },
+        { "request_refresh", luaA_request_refresh },
         { "register_xproperty", luaA_register_xproperty },
         { "set_xproperty", luaA_set_xproperty },
         { "get_xproperty", luaA_get_xproperty },
@@ -812,11 +1218,19 @@ luaA_init(xdgHandle* xdg, string_array_t *searchpath)
         { "xrdb_get_value", luaA_xrdb_get_value},
         { "kill", luaA_kill},
         { "sync", luaA_sync},
+        { "after_sync", luaA_after_sync},
+        { "profile_stats", luaA_profile_stats},
+        { "memory_stats", luaA_memory_stats},
+        { "xcb_stats", luaA_xcb_stats},
         { NULL, NULL }
     };
 
     L = globalconf.L.real_L_dont_use_directly = luaL_newstate();
 
+    /* Count Lua's allocations together with ours */
+    lua_default_alloc = lua_getallocf(L, &lua_default_alloc_ud);
+    lua_setallocf(L, luaA_alloc, lua_default_alloc_ud);
+
     /* Set panic function */
     lua_atpanic(L, luaA_panic);
 
@@ -832,6 +1246,7 @@ luaA_init(xdgHandle* xdg, string_array_t *searchpath)
     /* Export awesome lib */
     luaA_openlib(L, "awesome", awesome_lib, awesome_lib);
     setup_awesome_signals(L);
+    sampler_setup(L);
 
     /* Export root lib */
     luaA_registerlib(L, "root", awesome_root_lib);
@@ -894,6 +1309,9 @@ luaA_init(xdgHandle* xdg, string_array_t *searchpath)
     lua_setfield(L, 1, "cpath"); /* package.cpath = "concatenated string" */
 
     lua_pop(L, 1); /* pop "package" */
+
+    /* Load Lua modules through the bytecode cache */
+    luaA_bytecode_cache_setup(L);
 }
 
 static void
@@ -908,7 +1326,7 @@ static bool
 luaA_loadrc(const char *confpath)
 {
     lua_State *L = globalconf_get_lua_State();
-    if(luaL_loadfile(L, confpath))
+    if(luaA_loadfile_cached(L, confpath))
     {
         const char *err = lua_tostring(L, -1);
         luaA_startup_error(err);
@@ -1024,6 +1442,15 @@ luaA_emit_refresh()
     signal_object_emit(L, &global_signals, "refresh", 0);
 }
 
+void
+luaA_emit_refreshed()
+{
+    lua_State *L = globalconf_get_lua_State();
+    /* Let the X server draw while Lua does more work */
+    xcb_flush(globalconf.connection);
+    signal_object_emit(L, &global_signals, "refreshed", 0);
+}
+
 int
 luaA_default_index(lua_State *L)
 {
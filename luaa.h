@@ -318,6 +318,8 @@ int luaA_class_newindex_miss_property(lua_State *, lua_object_t *);
 int luaA_default_index(lua_State *);
 int luaA_default_newindex(lua_State *);
 void luaA_emit_startup(void);
+bool luaA_sync_fences_poll(void);
+void luaA_sync_fences_run(lua_State *);
 
 void luaA_systray_invalidate(void);
 
@@ -115,10 +115,41 @@ mouse_query_pointer(xcb_window_t window, int16_t *x, int16_t *y, xcb_window_t *c
     return true;
 }
 
+/** Remember the pointer position from an input event.
+ * The position is used by mouse_query_pointer_root() until the main loop
+ * goes to sleep, since the pointer can move without awesome seeing it, e.g.
+ * inside of client windows.
+ * \param x The x coordinate relative to the root window.
+ * \param y The y coordinate relative to the root window.
+ * \param mask The buttons and modifiers state after the event.
+ * \param same_screen False if the pointer is on another X screen.
+ */
+void
+mouse_pointer_update(int16_t x, int16_t y, uint16_t mask, bool same_screen)
+{
+    globalconf.pointer.valid = same_screen;
+    globalconf.pointer.x = x;
+    globalconf.pointer.y = y;
+    globalconf.pointer.mask = mask;
+}
+
+/** Forget the remembered pointer position.
+ * This is needed whenever the pointer could have moved behind awesome's back:
+ * after warping it, (un)grabbing it and when the main loop wakes up.
+ */
+void
+mouse_pointer_invalidate(void)
+{
+    globalconf.pointer.valid = false;
+}
+
 /** Get the pointer position on the screen.
+ * Unless strict mode is enabled, the position remembered from the last input
+ * event or query is used if there is one.
  * \param x This will be set to the Pointer-x-coordinate relative to window.
  * \param y This will be set to the Pointer-y-coordinate relative to window.
- * \param child This will be set to the window under the pointer.
+ * \param child This will be set to the window under the pointer. This
+ * always asks the X server.
  * \param mask This will be set to the current buttons state.
  * \return True on success, false if an error occurred.
  */
@@ -126,8 +157,24 @@ static bool
 mouse_query_pointer_root(int16_t *x, int16_t *y, xcb_window_t *child, uint16_t *mask)
 {
     xcb_window_t root = globalconf.screen->root;
+    uint16_t state;
 
-    return mouse_query_pointer(root, x, y, child, mask);
+    if(!child && !globalconf.pointer_strict && globalconf.pointer.valid)
+    {
+        *x = globalconf.pointer.x;
+        *y = globalconf.pointer.y;
+        if(mask)
+            *mask = globalconf.pointer.mask;
+        return true;
+    }
+
+    if(!mouse_query_pointer(root, x, y, child, &state))
+        return false;
+
+    mouse_pointer_update(*x, *y, state, true);
+    if(mask)
+        *mask = state;
+    return true;
 }
 
 /** Set the pointer position.
@@ -140,6 +187,7 @@ mouse_warp_pointer(xcb_window_t window, int16_t x, int16_t y)
 {
     xcb_warp_pointer(globalconf.connection, XCB_NONE, window,
                      0, 0, 0, 0, x, y);
+    mouse_pointer_invalidate();
 }
 
 /** Mouse library.
@@ -27,6 +27,8 @@
 #include <lua.h>
 
 bool mouse_query_pointer(xcb_window_t, int16_t *, int16_t *, xcb_window_t *, uint16_t *);
+void mouse_pointer_update(int16_t, int16_t, uint16_t, bool);
+void mouse_pointer_invalidate(void);
 int luaA_mouse_pushstatus(lua_State *, int, int, uint16_t);
 
 #endif
@@ -57,6 +57,7 @@ mousegrabber_grab(xcb_cursor_t cursor)
         if((grab_ptr_r = xcb_grab_pointer_reply(globalconf.connection, grab_ptr_c, NULL)))
         {
             p_delete(&grab_ptr_r);
+            mouse_pointer_invalidate();
             return true;
         }
         usleep(1000);
@@ -125,6 +126,7 @@ int
 luaA_mousegrabber_stop(lua_State *L)
 {
     xcb_ungrab_pointer(globalconf.connection, XCB_CURRENT_TIME);
+    mouse_pointer_invalidate();
     luaA_unregister(L, &globalconf.mousegrabber);
     return 0;
 }
@@ -86,48 +86,7 @@ luaA_button_new(lua_State *L)
     return luaA_class_new(L, &button_class);
 }
 
-/** Set a button array with a Lua table.
- * \param L The Lua VM state.
- * \param oidx The index of the object to store items into.
- * \param idx The index of the Lua table.
- * \param buttons The array button to fill.
- */
-void
-luaA_button_array_set(lua_State *L, int oidx, int idx, button_array_t *buttons)
-{
-    luaA_checktable(L, idx);
-
-    foreach(button, *buttons)
-        luaA_object_unref_item(L, oidx, *button);
-
-    button_array_wipe(buttons);
-    button_array_init(buttons);
-
-    lua_pushnil(L);
-    while(lua_next(L, idx))
-        if(luaA_toudata(L, -1, &button_class))
-            button_array_append(buttons, luaA_object_ref_item(L, oidx, -1));
-        else
-            lua_pop(L, 1);
-}
-
-/** Push an array of button as an Lua table onto the stack.
- * \param L The Lua VM state.
- * \param oidx The index of the object to get items from.
- * \param buttons The button array to push.
- * \return The number of elements pushed on stack.
- */
-int
-luaA_button_array_get(lua_State *L, int oidx, button_array_t *buttons)
-{
-    lua_createtable(L, buttons->len, 0);
-    for(int i = 0; i < buttons->len; i++)
-    {
-        luaA_object_push_item(L, oidx, buttons->tab[i]);
-        lua_rawseti(L, -2, i + 1);
-    }
-    return 1;
-}
+OBJECT_SET_FUNCS(button_t, button, button_class, globalconf.bindings_generation++)
 
 LUA_OBJECT_EXPORT_PROPERTY(button, button_t, button, lua_pushinteger);
 LUA_OBJECT_EXPORT_PROPERTY(button, button_t, modifiers, luaA_pushmodifiers);
@@ -136,6 +95,7 @@ static int
 luaA_button_set_modifiers(lua_State *L, button_t *b)
 {
     b->modifiers = luaA_tomodifiers(L, -1);
+    globalconf.bindings_generation++;
     luaA_object_emit_signal(L, -3, "property::modifiers", 0);
     return 0;
 }
@@ -144,6 +104,7 @@ static int
 luaA_button_set_button(lua_State *L, button_t *b)
 {
     b->button = luaL_checkinteger(L, -1);
+    globalconf.bindings_generation++;
     luaA_object_emit_signal(L, -3, "property::button", 0);
     return 0;
 }
@@ -25,6 +25,7 @@
 #include "globalconf.h"
 #include "common/luaclass.h"
 #include "common/luaobject.h"
+#include "common/objectset.h"
 
 #include <stdint.h>
 #include <xcb/xcb.h>
@@ -42,9 +43,8 @@ typedef struct button_t
 lua_class_t button_class;
 LUA_OBJECT_FUNCS(button_class, button_t, button)
 ARRAY_FUNCS(button_t *, button, DO_NOTHING)
+OBJECT_SET_TYPE(button_t, button)
 
-int luaA_button_array_get(lua_State *, int, button_array_t *);
-void luaA_button_array_set(lua_State *, int, int, button_array_t *);
 void button_class_setup(lua_State *);
 
 #endif
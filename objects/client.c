@@ -89,6 +89,7 @@
 
 #include "objects/client.h"
 #include "common/atoms.h"
+#include "common/hash.h"
 #include "common/xutil.h"
 #include "event.h"
 #include "ewmh.h"
@@ -98,6 +99,7 @@
 #include "property.h"
 #include "spawn.h"
 #include "systray.h"
+#include "thumbnail.h"
 #include "xwindow.h"
 
 #include "math.h"
@@ -511,6 +513,44 @@
  *
  * @property content
  * @param surface
+ * @see thumbnail
+ */
+
+/**
+ * A small copy of the client window content, for task switchers and
+ * overviews.
+ *
+ * The thumbnail is only kept up to date while `thumbnail_size` is set. It is
+ * scaled down in the X server and only the parts of the window that changed
+ * are copied again, at most as often as set by `awesome.set_thumbnail_rate`.
+ * Unlike `content`, it can be used for many windows at once. Minimized
+ * clients keep their last thumbnail.
+ *
+ * The property is `nil` until the window was drawn.
+ *
+ *    wibox.widget.imagebox(gears.surface(c.thumbnail))
+ *
+ * **Signal:**
+ *
+ *  * *property::thumbnail* when the thumbnail was updated.
+ *
+ * @property thumbnail
+ * @param surface
+ * @see thumbnail_size
+ */
+
+/**
+ * The maximum width and height of the client's `thumbnail`.
+ *
+ * Set it to 0 (the default) to stop updating the thumbnail. It stays 0 if the
+ * X server does not support the Composite and Damage extensions.
+ *
+ * **Signal:**
+ *
+ *  * *property::thumbnail\_size*
+ *
+ * @property thumbnail_size
+ * @param integer
  */
 
 /**
@@ -929,6 +969,13 @@ typedef enum {
     CLIENT_MAXIMIZED_BOTH = 1 << 2, /* V|H == BOTH, but ~(V|H) != ~(BOTH)... */
 } client_maximized_t;
 
+DO_HASH(xcb_window_t, client_t *, client_window, a_inthash, a_inteq)
+
+/** Window id to client indexes, used by the event handlers. */
+static client_window_hash_t clients_by_window;
+static client_window_hash_t clients_by_frame_window;
+static client_window_hash_t clients_by_nofocus_window;
+
 static area_t titlebar_get_area(client_t *c, client_titlebar_t bar);
 static drawable_t *titlebar_get_drawable(lua_State *L, client_t *c, int cl_idx, client_titlebar_t bar);
 static void client_resize_do(client_t *c, area_t geometry);
@@ -941,9 +988,10 @@ static void client_set_maximized_common(lua_State *L, int cidx, bool s, const ch
 static void
 client_wipe(client_t *c)
 {
-    key_array_wipe(&c->keys);
+    key_set_unref(globalconf_get_lua_State(), 0, &c->keys);
     xcb_icccm_get_wm_protocols_reply_wipe(&c->protocols);
-    cairo_surface_array_wipe(&c->icons);
+    draw_icon_array_wipe(&c->icons);
+    p_delete(&c->icon_reply);
     p_delete(&c->machine);
     p_delete(&c->class);
     p_delete(&c->instance);
@@ -952,6 +1000,7 @@ client_wipe(client_t *c)
     p_delete(&c->name);
     p_delete(&c->alt_name);
     p_delete(&c->startup_id);
+    bitset_wipe(&c->tags);
 }
 
 /** Change the clients urgency flag.
@@ -1075,14 +1124,7 @@ client_set_class_instance(lua_State *L, int cidx, const char *class, const char
 bool
 client_on_selected_tags(client_t *c)
 {
-    if(c->sticky)
-        return true;
-
-    foreach(tag, globalconf.tags)
-        if(tag_get_selected(*tag) && is_client_tagged(c, *tag))
-            return true;
-
-    return false;
+    return c->sticky || bitset_intersects(&c->tags, &globalconf.selected_tags);
 }
 
 /** Get a client by its window.
@@ -1092,21 +1134,19 @@ client_on_selected_tags(client_t *c)
 client_t *
 client_getbywin(xcb_window_t w)
 {
-    foreach(c, globalconf.clients)
-        if((*c)->window == w)
-            return *c;
-
-    return NULL;
+    client_t **c = client_window_hash_lookup(&clients_by_window, w);
+    return c ? *c : NULL;
 }
 
+/** Get a client by its nofocus window.
+ * \param w The client window to find.
+ * \return A client pointer if found, NULL otherwise.
+ */
 client_t *
 client_getbynofocuswin(xcb_window_t w)
 {
-    foreach(c, globalconf.clients)
-        if((*c)->nofocus_window == w)
-            return *c;
-
-    return NULL;
+    client_t **c = client_window_hash_lookup(&clients_by_nofocus_window, w);
+    return c ? *c : NULL;
 }
 
 /** Get a client by its frame window.
@@ -1116,11 +1156,8 @@ client_getbynofocuswin(xcb_window_t w)
 client_t *
 client_getbyframewin(xcb_window_t w)
 {
-    foreach(c, globalconf.clients)
-        if((*c)->frame_window == w)
-            return *c;
-
-    return NULL;
+    client_t **c = client_window_hash_lookup(&clients_by_frame_window, w);
+    return c ? *c : NULL;
 }
 
 /** Unfocus a client (internal).
@@ -1184,22 +1221,31 @@ client_ban(client_t *c)
         client_restore_enterleave_events();
 
         c->isbanned = true;
+        thumbnail_unmap(c);
 
         client_ban_unfocus(c);
     }
 }
 
+/** Whether the server is grabbed for the pending range */
+static bool enter_leave_grabbed;
+
 /** This is part of The Bob Marley Algorithm: we ignore enter and leave window
  * in certain cases, like map/unmap or move, so we don't get spurious events.
  * The implementation works by noting the range of sequence numbers for which we
- * should ignore events. We grab the server to make sure that only we could
- * generate events in this range.
+ * should ignore events. By default, we grab the server to make sure that only
+ * we could generate events in this range. Without the grab, other clients are
+ * not stalled, but crossing events they cause in this range are lost too.
  */
 void
 client_ignore_enterleave_events(void)
 {
     check(globalconf.pending_enter_leave_begin.sequence == 0);
-    globalconf.pending_enter_leave_begin = xcb_grab_server(globalconf.connection);
+    enter_leave_grabbed = globalconf.enter_leave_grab;
+    if(enter_leave_grabbed)
+        globalconf.pending_enter_leave_begin = xcb_grab_server(globalconf.connection);
+    else
+        globalconf.pending_enter_leave_begin = xcb_no_operation(globalconf.connection);
     /* If the connection is broken, we get a request with sequence number 0
      * which would then trigger an assertion in
      * client_restore_enterleave_events(). Handle this nicely.
@@ -1213,14 +1259,14 @@ client_ignore_enterleave_events(void)
 void
 client_restore_enterleave_events(void)
 {
-    sequence_pair_t pair;
+    xcb_void_cookie_t begin = globalconf.pending_enter_leave_begin;
 
-    check(globalconf.pending_enter_leave_begin.sequence != 0);
-    pair.begin = globalconf.pending_enter_leave_begin;
-    pair.end = xcb_no_operation(globalconf.connection);
-    xcb_ungrab_server(globalconf.connection);
+    check(begin.sequence != 0);
+    xcb_void_cookie_t end = xcb_no_operation(globalconf.connection);
+    if(enter_leave_grabbed)
+        xcb_ungrab_server(globalconf.connection);
     globalconf.pending_enter_leave_begin.sequence = 0;
-    sequence_pair_array_append(&globalconf.ignore_enter_leave_events, pair);
+    event_ignore_enterleave(begin, end);
 }
 
 /** Record that a client got focus.
@@ -1281,7 +1327,8 @@ client_get_nofocus_window(client_t *c)
                           -2, -2, 1, 1, 0, XCB_COPY_FROM_PARENT, globalconf.visual->visual_id,
                           0, NULL);
         xcb_map_window(globalconf.connection, c->nofocus_window);
-        xwindow_grabkeys(c->nofocus_window, &c->keys);
+        xwindow_grabkeys(c->nofocus_window, key_set_items(c->keys));
+        client_window_hash_insert(&clients_by_nofocus_window, c->nofocus_window, c);
     }
     return c->nofocus_window;
 }
@@ -1321,87 +1368,102 @@ client_focus_refresh(void)
     globalconf.focus.need_update = false;
 }
 
+/** Send the new geometry of a client to the X server.
+ * A pending border width change is sent in the same request.
+ * \param c The client.
+ * \param ignored_enterleave Set to true once enter and leave events are
+ * ignored, which happens before the first request.
+ */
 static void
-client_border_refresh(void)
+client_geometry_refresh_client(client_t *c, bool *ignored_enterleave)
 {
-    foreach(c, globalconf.clients)
-        window_border_refresh((window_t *) *c);
-}
+    c->geometry_need_refresh = false;
 
-static void
-client_geometry_refresh(void)
-{
-    bool ignored_enterleave = false;
-    foreach(_c, globalconf.clients)
+    /* Compute the client window's and frame window's geometry */
+    area_t geometry = c->geometry;
+    area_t real_geometry = c->geometry;
+    if (!c->fullscreen)
     {
-        client_t *c = *_c;
-
-        /* Compute the client window's and frame window's geometry */
-        area_t geometry = c->geometry;
-        area_t real_geometry = c->geometry;
-        if (!c->fullscreen)
-        {
-            if ((real_geometry.width < c->titlebar[CLIENT_TITLEBAR_LEFT].size
-                    + c->titlebar[CLIENT_TITLEBAR_RIGHT].size) ||
-                    (real_geometry.height < c->titlebar[CLIENT_TITLEBAR_TOP].size
-                    + c->titlebar[CLIENT_TITLEBAR_BOTTOM].size))
-                warn("Resizing a window to a negative size!? Have width %d-%d-%d=%d"
-                        " and height %d-%d-%d=%d", real_geometry.width,
-                        c->titlebar[CLIENT_TITLEBAR_LEFT].size,
+        if ((real_geometry.width < c->titlebar[CLIENT_TITLEBAR_LEFT].size
+                + c->titlebar[CLIENT_TITLEBAR_RIGHT].size) ||
+                (real_geometry.height < c->titlebar[CLIENT_TITLEBAR_TOP].size
+                + c->titlebar[CLIENT_TITLEBAR_BOTTOM].size))
+            warn("Resizing a window to a negative size!? Have width %d-%d-%d=%d"
+                    " and height %d-%d-%d=%d", real_geometry.width,
+                    c->titlebar[CLIENT_TITLEBAR_LEFT].size,
+                    c->titlebar[CLIENT_TITLEBAR_RIGHT].size,
+                    real_geometry.width -
+                        c->titlebar[CLIENT_TITLEBAR_LEFT].size -
                         c->titlebar[CLIENT_TITLEBAR_RIGHT].size,
-                        real_geometry.width -
-                            c->titlebar[CLIENT_TITLEBAR_LEFT].size -
-                            c->titlebar[CLIENT_TITLEBAR_RIGHT].size,
-                        real_geometry.height,
-                        c->titlebar[CLIENT_TITLEBAR_TOP].size,
-                        c->titlebar[CLIENT_TITLEBAR_BOTTOM].size,
-                        real_geometry.height -
-                            c->titlebar[CLIENT_TITLEBAR_TOP].size -
-                            c->titlebar[CLIENT_TITLEBAR_BOTTOM].size);
-
-            real_geometry.x = c->titlebar[CLIENT_TITLEBAR_LEFT].size;
-            real_geometry.y = c->titlebar[CLIENT_TITLEBAR_TOP].size;
-            real_geometry.width -= c->titlebar[CLIENT_TITLEBAR_LEFT].size;
-            real_geometry.width -= c->titlebar[CLIENT_TITLEBAR_RIGHT].size;
-            real_geometry.height -= c->titlebar[CLIENT_TITLEBAR_TOP].size;
-            real_geometry.height -= c->titlebar[CLIENT_TITLEBAR_BOTTOM].size;
-
-            if (real_geometry.width == 0 || real_geometry.height == 0)
-                warn("Resizing a window to size zero!?");
-        } else {
-            real_geometry.x = 0;
-            real_geometry.y = 0;
-        }
-
-        /* Is there anything to do? */
-        if (AREA_EQUAL(geometry, c->x11_frame_geometry)
-                && AREA_EQUAL(real_geometry, c->x11_client_geometry)) {
-            if (c->got_configure_request) {
-                /* ICCCM 4.1.5 / 4.2.3, if nothing was changed, send an event saying so */
-                client_send_configure(c);
-                c->got_configure_request = false;
-            }
-            continue;
-        }
+                    real_geometry.height,
+                    c->titlebar[CLIENT_TITLEBAR_TOP].size,
+                    c->titlebar[CLIENT_TITLEBAR_BOTTOM].size,
+                    real_geometry.height -
+                        c->titlebar[CLIENT_TITLEBAR_TOP].size -
+                        c->titlebar[CLIENT_TITLEBAR_BOTTOM].size);
+
+        real_geometry.x = c->titlebar[CLIENT_TITLEBAR_LEFT].size;
+        real_geometry.y = c->titlebar[CLIENT_TITLEBAR_TOP].size;
+        real_geometry.width -= c->titlebar[CLIENT_TITLEBAR_LEFT].size;
+        real_geometry.width -= c->titlebar[CLIENT_TITLEBAR_RIGHT].size;
+        real_geometry.height -= c->titlebar[CLIENT_TITLEBAR_TOP].size;
+        real_geometry.height -= c->titlebar[CLIENT_TITLEBAR_BOTTOM].size;
+
+        if (real_geometry.width == 0 || real_geometry.height == 0)
+            warn("Resizing a window to size zero!?");
+    } else {
+        real_geometry.x = 0;
+        real_geometry.y = 0;
+    }
 
-        if (!ignored_enterleave) {
-            client_ignore_enterleave_events();
-            ignored_enterleave = true;
+    /* Is there anything to do? */
+    if (AREA_EQUAL(geometry, c->x11_frame_geometry)
+            && AREA_EQUAL(real_geometry, c->x11_client_geometry)) {
+        if (c->got_configure_request) {
+            /* ICCCM 4.1.5 / 4.2.3, if nothing was changed, send an event saying so */
+            client_send_configure(c);
+            c->got_configure_request = false;
         }
+        return;
+    }
 
-        xcb_configure_window(globalconf.connection, c->frame_window,
-                XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
-                (uint32_t[]) { geometry.x, geometry.y, geometry.width, geometry.height });
-        xcb_configure_window(globalconf.connection, c->window,
-                XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
-                (uint32_t[]) { real_geometry.x, real_geometry.y, real_geometry.width, real_geometry.height });
+    if (!*ignored_enterleave) {
+        client_ignore_enterleave_events();
+        *ignored_enterleave = true;
+    }
 
-        c->x11_frame_geometry = geometry;
-        c->x11_client_geometry = real_geometry;
+    uint16_t frame_mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y
+        | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
+    if (c->dirty & WINDOW_DIRTY_BORDER_WIDTH) {
+        frame_mask |= XCB_CONFIG_WINDOW_BORDER_WIDTH;
+        c->dirty &= ~WINDOW_DIRTY_BORDER_WIDTH;
+    }
+    xcb_configure_window(globalconf.connection, c->frame_window, frame_mask,
+            (uint32_t[]) { geometry.x, geometry.y, geometry.width, geometry.height,
+                           c->border_width });
+    xcb_configure_window(globalconf.connection, c->window,
+            XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
+            (uint32_t[]) { real_geometry.x, real_geometry.y, real_geometry.width, real_geometry.height });
+
+    c->x11_frame_geometry = geometry;
+    c->x11_client_geometry = real_geometry;
+
+    /* ICCCM 4.2.3 says something else, but Java always needs this... */
+    client_send_configure(c);
+    c->got_configure_request = false;
+}
 
-        /* ICCCM 4.2.3 says something else, but Java always needs this... */
-        client_send_configure(c);
-        c->got_configure_request = false;
+/** Send the pending geometry and border changes of all clients in one pass.
+ */
+static void
+client_window_refresh(void)
+{
+    bool ignored_enterleave = false;
+    foreach(c, globalconf.clients)
+    {
+        if ((*c)->geometry_need_refresh)
+            client_geometry_refresh_client(*c, &ignored_enterleave);
+        window_border_refresh((window_t *) *c);
     }
     if (ignored_enterleave)
         client_restore_enterleave_events();
@@ -1410,8 +1472,7 @@ client_geometry_refresh(void)
 void
 client_refresh(void)
 {
-    client_geometry_refresh();
-    client_border_refresh();
+    client_window_refresh();
     client_focus_refresh();
 }
 
@@ -1449,73 +1510,126 @@ border_width_callback(client_t *c, uint16_t old_width, uint16_t new_width)
     }
 }
 
-static void
-client_update_properties(lua_State *L, int cidx, client_t *c)
+/** Send all the requests needed for managing a window.
+ * The replies are processed by client_manage().
+ * \param w The window.
+ * \return The cookies of the requests.
+ */
+client_manage_cookies_t
+client_manage_request(xcb_window_t w)
 {
+    client_manage_cookies_t cookies;
+
+    /* Make sure we hear about property changes after our requests were
+     * processed. The full event mask is selected once we managed the window. */
+    xcb_change_window_attributes(globalconf.connection, w, XCB_CW_EVENT_MASK,
+                                 (const uint32_t []) { XCB_EVENT_MASK_PROPERTY_CHANGE });
+
+    cookies.kde_check = systray_iskdedockapp_unchecked(w);
+
+    /* If this is a new client that just has been launched, then request its
+     * startup id. */
+    cookies.startup_id = xcb_get_property(globalconf.connection, false,
+                                          w, _NET_STARTUP_ID,
+                                          XCB_GET_PROPERTY_TYPE_ANY, 0, UINT_MAX);
+
     /* get all hints */
-    xcb_get_property_cookie_t wm_normal_hints   = property_get_wm_normal_hints(c);
-    xcb_get_property_cookie_t wm_hints          = property_get_wm_hints(c);
-    xcb_get_property_cookie_t wm_transient_for  = property_get_wm_transient_for(c);
-    xcb_get_property_cookie_t wm_client_leader  = property_get_wm_client_leader(c);
-    xcb_get_property_cookie_t wm_client_machine = property_get_wm_client_machine(c);
-    xcb_get_property_cookie_t wm_window_role    = property_get_wm_window_role(c);
-    xcb_get_property_cookie_t net_wm_pid        = property_get_net_wm_pid(c);
-    xcb_get_property_cookie_t net_wm_icon       = property_get_net_wm_icon(c);
-    xcb_get_property_cookie_t wm_name           = property_get_wm_name(c);
-    xcb_get_property_cookie_t net_wm_name       = property_get_net_wm_name(c);
-    xcb_get_property_cookie_t wm_icon_name      = property_get_wm_icon_name(c);
-    xcb_get_property_cookie_t net_wm_icon_name  = property_get_net_wm_icon_name(c);
-    xcb_get_property_cookie_t wm_class          = property_get_wm_class(c);
-    xcb_get_property_cookie_t wm_protocols      = property_get_wm_protocols(c);
-    xcb_get_property_cookie_t motif_wm_hints    = property_get_motif_wm_hints(c);
-    xcb_get_property_cookie_t opacity           = xwindow_get_opacity_unchecked(c->window);
+    cookies.wm_normal_hints   = property_get_wm_normal_hints(w);
+    cookies.wm_hints          = property_get_wm_hints(w);
+    cookies.wm_transient_for  = property_get_wm_transient_for(w);
+    cookies.wm_client_leader  = property_get_wm_client_leader(w);
+    cookies.wm_client_machine = property_get_wm_client_machine(w);
+    cookies.wm_window_role    = property_get_wm_window_role(w);
+    cookies.net_wm_pid        = property_get_net_wm_pid(w);
+    cookies.net_wm_icon       = property_get_net_wm_icon(w);
+    cookies.wm_name           = property_get_wm_name(w);
+    cookies.net_wm_name       = property_get_net_wm_name(w);
+    cookies.wm_icon_name      = property_get_wm_icon_name(w);
+    cookies.net_wm_icon_name  = property_get_net_wm_icon_name(w);
+    cookies.wm_class          = property_get_wm_class(w);
+    cookies.wm_protocols      = property_get_wm_protocols(w);
+    cookies.motif_wm_hints    = property_get_motif_wm_hints(w);
+    cookies.opacity           = xwindow_get_opacity_unchecked(w);
+    cookies.strut             = ewmh_get_client_strut(w);
+    cookies.ewmh              = ewmh_client_get_hints(w);
+
+    return cookies;
+}
 
+/** Throw away the replies for a window which is not going to be managed.
+ * \param cookies The cookies returned by client_manage_request().
+ */
+void
+client_manage_discard(client_manage_cookies_t *cookies)
+{
+    xcb_get_property_cookie_t all[] =
+    {
+        cookies->kde_check, cookies->startup_id,
+        cookies->wm_normal_hints, cookies->wm_hints,
+        cookies->wm_transient_for, cookies->wm_client_leader,
+        cookies->wm_client_machine, cookies->wm_window_role,
+        cookies->net_wm_pid, cookies->net_wm_icon,
+        cookies->wm_name, cookies->net_wm_name,
+        cookies->wm_icon_name, cookies->net_wm_icon_name,
+        cookies->wm_class, cookies->wm_protocols,
+        cookies->motif_wm_hints, cookies->opacity, cookies->strut,
+        cookies->ewmh.desktop, cookies->ewmh.state, cookies->ewmh.window_type
+    };
+
+    for(int i = 0; i < countof(all); i++)
+        if(all[i].sequence)
+            xcb_discard_reply(globalconf.connection, all[i].sequence);
+    p_clear(cookies, 1);
+}
+
+static void
+client_update_properties(lua_State *L, int cidx, client_t *c, client_manage_cookies_t *cookies)
+{
     /* update strut */
-    ewmh_process_client_strut(c);
+    ewmh_process_client_strut_reply(c, cookies->strut);
 
     /* Now process all replies */
-    property_update_wm_normal_hints(c, wm_normal_hints);
-    property_update_wm_hints(c, wm_hints);
-    property_update_wm_transient_for(c, wm_transient_for);
-    property_update_wm_client_leader(c, wm_client_leader);
-    property_update_wm_client_machine(c, wm_client_machine);
-    property_update_wm_window_role(c, wm_window_role);
-    property_update_net_wm_pid(c, net_wm_pid);
-    property_update_net_wm_icon(c, net_wm_icon);
-    property_update_wm_name(c, wm_name);
-    property_update_net_wm_name(c, net_wm_name);
-    property_update_wm_icon_name(c, wm_icon_name);
-    property_update_net_wm_icon_name(c, net_wm_icon_name);
-    property_update_wm_class(c, wm_class);
-    property_update_wm_protocols(c, wm_protocols);
-    property_update_motif_wm_hints(c, motif_wm_hints);
-    window_set_opacity(L, cidx, xwindow_get_opacity_from_cookie(opacity));
+    property_update_wm_normal_hints(c, cookies->wm_normal_hints);
+    property_update_wm_hints(c, cookies->wm_hints);
+    property_update_wm_transient_for(c, cookies->wm_transient_for);
+    property_update_wm_client_leader(c, cookies->wm_client_leader);
+    property_update_wm_client_machine(c, cookies->wm_client_machine);
+    property_update_wm_window_role(c, cookies->wm_window_role);
+    property_update_net_wm_pid(c, cookies->net_wm_pid);
+    property_update_net_wm_icon(c, cookies->net_wm_icon);
+    property_update_wm_name(c, cookies->wm_name);
+    property_update_net_wm_name(c, cookies->net_wm_name);
+    property_update_wm_icon_name(c, cookies->wm_icon_name);
+    property_update_net_wm_icon_name(c, cookies->net_wm_icon_name);
+    property_update_wm_class(c, cookies->wm_class);
+    property_update_wm_protocols(c, cookies->wm_protocols);
+    property_update_motif_wm_hints(c, cookies->motif_wm_hints);
+    window_set_opacity(L, cidx, xwindow_get_opacity_from_cookie(cookies->opacity));
 }
 
 /** Manage a new client.
  * \param w The window.
  * \param wgeom Window geometry.
- * \param startup True if we are managing at startup time.
+ * \param wattr Window attributes.
+ * \param cookies The cookies returned by client_manage_request() for w.
  */
 void
-client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_attributes_reply_t *wattr)
+client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_attributes_reply_t *wattr,
+              client_manage_cookies_t *cookies)
 {
     xcb_void_cookie_t reparent_cookie;
     lua_State *L = globalconf_get_lua_State();
     const uint32_t select_input_val[] = { CLIENT_SELECT_INPUT_EVENT_MASK };
 
-    if(systray_iskdedockapp(w))
+    bool kde_dockapp = systray_iskdedockapp_reply(cookies->kde_check);
+    cookies->kde_check.sequence = 0;
+    if(kde_dockapp)
     {
+        client_manage_discard(cookies);
         systray_request_handle(w);
         return;
     }
 
-    /* If this is a new client that just has been launched, then request its
-     * startup id. */
-    xcb_get_property_cookie_t startup_id_q = xcb_get_property(globalconf.connection, false,
-                                                              w, _NET_STARTUP_ID,
-                                                              XCB_GET_PROPERTY_TYPE_ANY, 0, UINT_MAX);
-
     /* Make sure the window is automatically mapped if awesome exits or dies. */
     xcb_change_save_set(globalconf.connection, XCB_SET_MODE_INSERT, w);
     if (globalconf.have_shape)
@@ -1586,6 +1700,8 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     /* Duplicate client and push it in client list */
     lua_pushvalue(L, -1);
     client_array_push(&globalconf.clients, luaA_object_ref(L, -1));
+    client_window_hash_insert(&clients_by_window, c->window, c);
+    client_window_hash_insert(&clients_by_frame_window, c->frame_window, c);
 
     /* Set the right screen */
     screen_client_moveto(c, screen_getbycoord(wgeom->x, wgeom->y), false);
@@ -1597,6 +1713,7 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     c->geometry.y = wgeom->y;
     c->geometry.width = wgeom->width;
     c->geometry.height = wgeom->height;
+    c->geometry_need_refresh = true;
 
     luaA_object_emit_signal(L, -1, "property::x", 0);
     luaA_object_emit_signal(L, -1, "property::y", 0);
@@ -1613,7 +1730,7 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     luaA_object_emit_signal(L, -1, "property::size_hints_honor", 0);
 
     /* update all properties */
-    client_update_properties(L, -1, c);
+    client_update_properties(L, -1, c, cookies);
 
     /* check if this is a TRANSIENT_FOR of another client */
     foreach(oc, globalconf.clients)
@@ -1624,23 +1741,24 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     xwindow_set_state(c->window, XCB_ICCCM_WM_STATE_NORMAL);
 
     /* Then check clients hints */
-    ewmh_client_check_hints(c);
+    ewmh_client_process_hints(c, cookies->ewmh);
 
     /* Push client in stack */
     stack_client_push(c);
 
     /* Request our response */
     xcb_get_property_reply_t *reply =
-        xcb_get_property_reply(globalconf.connection, startup_id_q, NULL);
+        xcb_get_property_reply(globalconf.connection, cookies->startup_id, NULL);
     /* Say spawn that a client has been started, with startup id as argument */
     char *startup_id = xutil_get_text_property_from_reply(reply);
     p_delete(&reply);
 
     if (startup_id == NULL && c->leader_window != XCB_NONE) {
         /* GTK hides this property elsewhere. No idea why. */
-        startup_id_q = xcb_get_property(globalconf.connection, false,
-                                        c->leader_window, _NET_STARTUP_ID,
-                                        XCB_GET_PROPERTY_TYPE_ANY, 0, UINT_MAX);
+        xcb_get_property_cookie_t startup_id_q =
+            xcb_get_property(globalconf.connection, false,
+                             c->leader_window, _NET_STARTUP_ID,
+                             XCB_GET_PROPERTY_TYPE_ANY, 0, UINT_MAX);
         reply = xcb_get_property_reply(globalconf.connection, startup_id_q, NULL);
         startup_id = xutil_get_text_property_from_reply(reply);
         p_delete(&reply);
@@ -1818,6 +1936,8 @@ client_resize_do(client_t *c, area_t geometry)
     /* Also store geometry including border */
     area_t old_geometry = c->geometry;
     c->geometry = geometry;
+    c->geometry_need_refresh = true;
+    c->layout_geometry_valid = false;
 
     luaA_object_push(L, c);
     if (!AREA_EQUAL(old_geometry, geometry))
@@ -1917,7 +2037,7 @@ client_set_minimized(lua_State *L, int cidx, bool s)
     if(c->minimized != s)
     {
         c->minimized = s;
-        banning_need_update();
+        banning_client_need_update(c);
         if(s)
         {
             /* ICCCM: To transition from ICONIC to NORMAL state, the client
@@ -1943,6 +2063,7 @@ client_set_minimized(lua_State *L, int cidx, bool s)
                                          XCB_CW_EVENT_MASK,
                                          no_event);
             xcb_unmap_window(globalconf.connection, c->window);
+            thumbnail_unmap(c);
             xcb_change_window_attributes(globalconf.connection,
                                          globalconf.screen->root,
                                          XCB_CW_EVENT_MASK,
@@ -1961,6 +2082,7 @@ client_set_minimized(lua_State *L, int cidx, bool s)
         {
             xwindow_set_state(c->window, XCB_ICCCM_WM_STATE_NORMAL);
             xcb_map_window(globalconf.connection, c->window);
+            thumbnail_map(c);
         }
         if(strut_has_value(&c->strut))
             screen_update_workarea(c->screen);
@@ -1981,7 +2103,7 @@ client_set_hidden(lua_State *L, int cidx, bool s)
     if(c->hidden != s)
     {
         c->hidden = s;
-        banning_need_update();
+        banning_client_need_update(c);
         if(strut_has_value(&c->strut))
             screen_update_workarea(c->screen);
         luaA_object_emit_signal(L, cidx, "property::hidden", 0);
@@ -2001,7 +2123,7 @@ client_set_sticky(lua_State *L, int cidx, bool s)
     if(c->sticky != s)
     {
         c->sticky = s;
-        banning_need_update();
+        banning_client_need_update(c);
         if(strut_has_value(&c->strut))
             screen_update_workarea(c->screen);
         luaA_object_emit_signal(L, cidx, "property::sticky", 0);
@@ -2065,6 +2187,8 @@ client_set_fullscreen(lua_State *L, int cidx, bool s)
         int abs_cidx = luaA_absindex(L, cidx); \
         lua_pushstring(L, "fullscreen");
         c->fullscreen = s;
+        c->layout_geometry_valid = false;
+        c->geometry_need_refresh = true;
         luaA_object_emit_signal(L, abs_cidx, "request::geometry", 1);
         luaA_object_emit_signal(L, abs_cidx, "property::fullscreen", 0);
         /* Force a client resize, so that titlebars get shown/hidden */
@@ -2255,6 +2379,7 @@ client_unban(client_t *c)
         client_restore_enterleave_events();
 
         c->isbanned = false;
+        thumbnail_map(c);
 
         /* An unbanned client shouldn't be minimized or hidden */
         luaA_object_push(L, c);
@@ -2294,6 +2419,13 @@ client_unmanage(client_t *c, bool window_valid)
             client_array_remove(&globalconf.clients, elem);
             break;
         }
+    client_window_hash_remove(&clients_by_window, c->window);
+    client_window_hash_remove(&clients_by_frame_window, c->frame_window);
+    if(c->nofocus_window != XCB_NONE)
+        client_window_hash_remove(&clients_by_nofocus_window, c->nofocus_window);
+    xwindow_grabkeys_forget(c->window);
+    if(c->nofocus_window != XCB_NONE)
+        xwindow_grabkeys_forget(c->nofocus_window);
     stack_client_remove(c);
     for(int i = 0; i < globalconf.tags.len; i++)
         untag_client(c, globalconf.tags.tab[i]);
@@ -2304,8 +2436,7 @@ client_unmanage(client_t *c, bool window_valid)
 
     luaA_class_emit_signal(L, &client_class, "list", 0);
 
-    if(strut_has_value(&c->strut))
-        screen_update_workarea(c->screen);
+    screen_strut_client_remove(c);
 
     /* Get rid of all titlebars */
     for (client_titlebar_t bar = CLIENT_TITLEBAR_TOP; bar < CLIENT_TITLEBAR_COUNT; bar++) {
@@ -2319,13 +2450,17 @@ client_unmanage(client_t *c, bool window_valid)
             lua_pop(L, 1);
         }
 
-        /* Forget about the drawable */
+        /* Forget about the drawable, and don't wait for the garbage
+         * collector to free its pixmap */
+        drawable_release(c->titlebar[bar].drawable);
         luaA_object_push(L, c);
         luaA_object_unref_item(L, -1, c->titlebar[bar].drawable);
         c->titlebar[bar].drawable = NULL;
         lua_pop(L, 1);
     }
 
+    thumbnail_wipe(c, window_valid);
+
     /* Clear our event mask so that we don't receive any events from now on,
      * especially not for the following requests. */
     if(window_valid)
@@ -2345,7 +2480,7 @@ client_unmanage(client_t *c, bool window_valid)
                 c->geometry.x, c->geometry.y);
     }
 
-    if (c->nofocus_window != XCB_NONE)
+    if(c->nofocus_window != XCB_NONE)
         window_array_append(&globalconf.destroy_later_windows, c->nofocus_window);
     window_array_append(&globalconf.destroy_later_windows, c->frame_window);
 
@@ -2364,6 +2499,17 @@ client_unmanage(client_t *c, bool window_valid)
 
     /* set client as invalid */
     c->window = XCB_NONE;
+    banning_client_forget(c);
+
+    /* The client object can live on in Lua for a long time, but it does not
+     * need its icons and bindings anymore */
+    draw_icon_array_wipe(&c->icons);
+    draw_icon_array_init(&c->icons);
+    p_delete(&c->icon_reply);
+    luaA_object_push(L, c);
+    key_set_unref(L, -1, &c->keys);
+    button_set_unref(L, -1, &c->buttons);
+    lua_pop(L, 1);
 
     luaA_object_unref(L, c);
 }
@@ -2440,6 +2586,142 @@ luaA_client_get(lua_State *L)
     return 1;
 }
 
+/* Filters of client.iterate() */
+enum
+{
+    CLIENT_FILTER_VISIBLE = 1 << 0,
+    CLIENT_FILTER_ON_SELECTED_TAGS = 1 << 1,
+    CLIENT_FILTER_MINIMIZED = 1 << 2,
+    CLIENT_FILTER_FLOATING = 1 << 3,
+};
+
+static const struct
+{
+    const char *name;
+    int flag;
+} client_filters[] =
+{
+    { "visible", CLIENT_FILTER_VISIBLE },
+    { "on_selected_tags", CLIENT_FILTER_ON_SELECTED_TAGS },
+    { "minimized", CLIENT_FILTER_MINIMIZED },
+    { "floating", CLIENT_FILTER_FLOATING },
+};
+
+/** Check a client against the filters of client.iterate().
+ * \param mask The filters to check.
+ * \param values The values the filtered properties must have.
+ */
+static bool
+client_iterate_match(lua_State *L, client_t *c, int mask, int values)
+{
+#define CHECK(flag, value) \
+    if((mask & (flag)) && !(value) != !(values & (flag))) \
+        return false
+    CHECK(CLIENT_FILTER_MINIMIZED, c->minimized);
+    CHECK(CLIENT_FILTER_ON_SELECTED_TAGS, client_on_selected_tags(c));
+    CHECK(CLIENT_FILTER_VISIBLE, client_isvisible(c));
+#undef CHECK
+
+    /* The floating state is managed by awful */
+    if(mask & CLIENT_FILTER_FLOATING)
+    {
+        luaA_object_push(L, c);
+        lua_getfield(L, -1, "floating");
+        bool floating = lua_toboolean(L, -1);
+        lua_pop(L, 2);
+        if(floating != !!(values & CLIENT_FILTER_FLOATING))
+            return false;
+    }
+    return true;
+}
+
+static int
+luaA_client_iterate_next(lua_State *L)
+{
+    int i = lua_tointeger(L, lua_upvalueindex(1));
+    screen_t *screen = lua_touserdata(L, lua_upvalueindex(2));
+    int mask = lua_tointeger(L, lua_upvalueindex(3));
+    int values = lua_tointeger(L, lua_upvalueindex(4));
+    bool stacked = lua_toboolean(L, lua_upvalueindex(5));
+    client_array_t *list = stacked ? &globalconf.stack : &globalconf.clients;
+
+    /* The length is checked again every time, the filters and the loop body
+     * can run Lua code which changes the list */
+    for(; i < list->len; i++)
+    {
+        client_t *c = list->tab[stacked ? list->len - 1 - i : i];
+        if(screen && c->screen != screen)
+            continue;
+        if(!client_iterate_match(L, c, mask, values))
+            continue;
+
+        lua_pushinteger(L, i + 1);
+        lua_replace(L, lua_upvalueindex(1));
+        luaA_object_push(L, c);
+        return 1;
+    }
+
+    lua_pushinteger(L, i);
+    lua_replace(L, lua_upvalueindex(1));
+    return 0;
+}
+
+/** Iterate over clients without building a table of them.
+ *
+ * The filters are checked in C, so this is cheaper than filtering the result
+ * of `client.get` in Lua:
+ *
+ *    for c in client.iterate({ visible = true, floating = false }, s) do
+ *        -- do something
+ *    end
+ *
+ * @tparam[opt] table filter Only clients whose `visible`, `on_selected_tags`,
+ *   `minimized` and `floating` states have the given boolean values. The
+ *   `visible` state is the same as `isvisible`.
+ * @tparam[opt] screen screen Only clients on this screen.
+ * @tparam[opt=false] boolean stacked Iterate in stacking order (from top to
+ *   bottom)?
+ * @treturn function An iterator giving one client after the other.
+ * @function iterate
+ */
+static int
+luaA_client_iterate(lua_State *L)
+{
+    int mask = 0, values = 0;
+    screen_t *screen = NULL;
+    bool stacked = false;
+
+    if(!lua_isnoneornil(L, 1))
+    {
+        luaL_checktype(L, 1, LUA_TTABLE);
+        for(int i = 0; i < countof(client_filters); i++)
+        {
+            lua_getfield(L, 1, client_filters[i].name);
+            if(!lua_isnil(L, -1))
+            {
+                mask |= client_filters[i].flag;
+                if(lua_toboolean(L, -1))
+                    values |= client_filters[i].flag;
+            }
+            lua_pop(L, 1);
+        }
+    }
+
+    if(!lua_isnoneornil(L, 2))
+        screen = luaA_checkscreen(L, 2);
+
+    if(!lua_isnoneornil(L, 3))
+        stacked = luaA_checkboolean(L, 3);
+
+    lua_pushinteger(L, 0);
+    lua_pushlightuserdata(L, screen);
+    lua_pushinteger(L, mask);
+    lua_pushinteger(L, values);
+    lua_pushboolean(L, stacked);
+    lua_pushcclosure(L, luaA_client_iterate_next, 5);
+    return 1;
+}
+
 /** Check if a client is visible on its screen.
  *
  * @return A boolean value, true if the client is visible, false otherwise.
@@ -2453,15 +2735,39 @@ luaA_client_isvisible(lua_State *L)
     return 1;
 }
 
+/** Get the memory used by the icons of all clients.
+ * This counts both the raw data of _NET_WM_ICON and the decoded surfaces.
+ * \return The number of bytes.
+ */
+size_t
+client_icons_bytes(void)
+{
+    size_t bytes = 0;
+    foreach(c, globalconf.clients)
+        foreach(icon, (*c)->icons)
+        {
+            if(icon->data)
+                bytes += (size_t) icon->width * icon->height * 4;
+            if(icon->surface)
+                bytes += (size_t) cairo_image_surface_get_stride(icon->surface)
+                    * cairo_image_surface_get_height(icon->surface);
+        }
+    return bytes;
+}
+
 /** Set client icons.
- * \param L The Lua VM state.
+ * \param c The client.
  * \param array Array of icons to set.
+ * \param reply The property reply holding the data of the icons, or NULL.
+ * The client takes ownership of both.
  */
 void
-client_set_icons(client_t *c, cairo_surface_array_t array)
+client_set_icons(client_t *c, draw_icon_array_t array, xcb_get_property_reply_t *reply)
 {
-    cairo_surface_array_wipe(&c->icons);
+    draw_icon_array_wipe(&c->icons);
+    p_delete(&c->icon_reply);
     c->icons = array;
+    c->icon_reply = reply;
 
     lua_State *L = globalconf_get_lua_State();
     luaA_object_push(L, c);
@@ -2478,11 +2784,18 @@ client_set_icons(client_t *c, cairo_surface_array_t array)
 static void
 client_set_icon(client_t *c, cairo_surface_t *s)
 {
-    cairo_surface_array_t array;
-    cairo_surface_array_init(&array);
+    draw_icon_array_t array;
+    draw_icon_array_init(&array);
     if (s && cairo_surface_status(s) == CAIRO_STATUS_SUCCESS)
-        cairo_surface_array_push(&array, draw_dup_image_surface(s));
-    client_set_icons(c, array);
+    {
+        cairo_surface_t *dup = draw_dup_image_surface(s);
+        draw_icon_array_push(&array, (draw_icon_t) {
+                .width = cairo_image_surface_get_width(dup),
+                .height = cairo_image_surface_get_height(dup),
+                .surface = dup
+        });
+    }
+    client_set_icons(c, array, NULL);
 }
 
 
@@ -2626,27 +2939,29 @@ luaA_client_tags(lua_State *L)
     if(lua_gettop(L) == 2)
     {
         luaA_checktable(L, 2);
+
+        /* Build a set of the wanted tags */
+        lua_newtable(L);
+        lua_pushnil(L);
+        while(lua_next(L, 2))
+        {
+            lua_pushboolean(L, true);
+            lua_rawset(L, 3);
+        }
+
+        /* Only untag if we aren't going to add this tag again */
         for(int i = 0; i < globalconf.tags.len; i++)
         {
-            /* Only untag if we aren't going to add this tag again */
-            bool found = false;
-            lua_pushnil(L);
-            while(lua_next(L, 2))
-            {
-                tag_t *t = lua_touserdata(L, -1);
-                /* Pop the value from lua_next */
-                lua_pop(L, 1);
-                if (t != globalconf.tags.tab[i])
-                    continue;
-
-                /* Pop the key from lua_next */
-                lua_pop(L, 1);
-                found = true;
-                break;
-            }
-            if(!found)
+            if(!is_client_tagged(c, globalconf.tags.tab[i]))
+                continue;
+            luaA_object_push(L, globalconf.tags.tab[i]);
+            lua_rawget(L, 3);
+            if(!lua_toboolean(L, -1))
                 untag_client(c, globalconf.tags.tab[i]);
+            lua_pop(L, 1);
         }
+        lua_pop(L, 1);
+
         lua_pushnil(L);
         while(lua_next(L, 2))
             tag_client(L, c);
@@ -2831,10 +3146,12 @@ client_refresh_titlebar_partial(client_t *c, client_titlebar_t bar, int16_t x, i
 
 #define HANDLE_TITLEBAR_REFRESH(name, index)                                                \
 static void                                                                                 \
-client_refresh_titlebar_ ## name(client_t *c)                                               \
+client_refresh_titlebar_ ## name(client_t *c, const area_t *rects, int count)               \
 {                                                                                           \
     area_t area = titlebar_get_area(c, index);                                              \
-    client_refresh_titlebar_partial(c, index, area.x, area.y, area.width, area.height);     \
+    for (int i = 0; i < count; i++)                                                         \
+        client_refresh_titlebar_partial(c, index, area.x + rects[i].x, area.y + rects[i].y, \
+                                        rects[i].width, rects[i].height);                   \
 }
 HANDLE_TITLEBAR_REFRESH(top, CLIENT_TITLEBAR_TOP)
 HANDLE_TITLEBAR_REFRESH(right, CLIENT_TITLEBAR_RIGHT)
@@ -2993,6 +3310,212 @@ luaA_client_geometry(lua_State *L)
     return luaA_pusharea(L, c->geometry);
 }
 
+/** Get the size a layout has to reserve for a client.
+ * This is what `apply_size_hints` gives for the size without the border and
+ * the gap, plus the border and the gap.
+ */
+static void
+client_layout_size(client_t *c, lua_Number *width, lua_Number *height, lua_Number gap)
+{
+    int bw = c->border_width;
+    area_t geometry = c->geometry;
+
+    if(!client_isfixed(c))
+    {
+        geometry.width = ceil(MIN(MAX(*width - 2 * bw - gap, 1), MAX_X11_SIZE));
+        geometry.height = ceil(MIN(MAX(*height - 2 * bw - gap, 1), MAX_X11_SIZE));
+    }
+
+    if(c->size_hints_honor)
+        geometry = client_apply_size_hints(c, geometry);
+
+    *width = geometry.width + 2 * bw + gap;
+    *height = geometry.height + 2 * bw + gap;
+}
+
+static lua_Number
+luaA_getfield_number(lua_State *L, int idx, const char *name)
+{
+    lua_getfield(L, idx, name);
+    lua_Number n = lua_tonumber(L, -1);
+    lua_pop(L, 1);
+    return n;
+}
+
+/** Tile a column (or row) of clients for the tile layouts.
+ *
+ * This computes the geometries of a group of clients, distributing the space
+ * according to their window factors and making room for their size hints,
+ * without going through their Lua properties one by one.
+ *
+ * @tparam table geometries The layout geometries, indexed by client.
+ * @tparam table clients The clients of the layout.
+ * @tparam table workarea The layout workarea.
+ * @tparam boolean vertical True if the group is a row (top and bottom
+ *   layouts), false for a column.
+ * @tparam table fact The window factors of the group. Missing ones are set.
+ * @tparam integer first The index of the first client of the group.
+ * @tparam integer last The index of the last client of the group.
+ * @tparam number coord The position of the group.
+ * @tparam number size The wanted size of the group.
+ * @tparam number useless_gap The gap between clients.
+ * @treturn number The size used by the group.
+ * @function tile_group
+ */
+static int
+luaA_client_tile_group(lua_State *L)
+{
+    luaA_checktable(L, 1);
+    luaA_checktable(L, 2);
+    luaA_checktable(L, 3);
+    bool vertical = lua_toboolean(L, 4);
+    luaA_checktable(L, 5);
+    int first = luaL_checkinteger(L, 6);
+    int last = luaL_checkinteger(L, 7);
+    lua_Number group_coord = luaL_checknumber(L, 8);
+    lua_Number size = luaL_checknumber(L, 9);
+    lua_Number gap = luaL_checknumber(L, 10);
+
+    /* Get our orientation right */
+    const char *width = vertical ? "height" : "width";
+    const char *height = vertical ? "width" : "height";
+    const char *x = vertical ? "y" : "x";
+    const char *y = vertical ? "x" : "y";
+
+    lua_Number available = luaA_getfield_number(L, 3, width)
+        - (group_coord - luaA_getfield_number(L, 3, x));
+
+    /* Find our total values */
+    lua_Number total_fact = 0, min_fact = 1;
+    for(int i = 1; i <= last - first + 1; i++)
+    {
+        lua_rawgeti(L, 2, first + i - 1);
+        client_t *c = luaA_checkudata(L, -1, &client_class);
+        lua_pop(L, 1);
+
+        /* Determine the width/height based on the size hint */
+        int32_t size_hint = 0;
+        if(c->size_hints.flags & XCB_ICCCM_SIZE_HINT_P_MIN_SIZE)
+            size_hint = vertical ? c->size_hints.min_height : c->size_hints.min_width;
+        else if(c->size_hints.flags & XCB_ICCCM_SIZE_HINT_BASE_SIZE)
+            size_hint = vertical ? c->size_hints.base_height : c->size_hints.base_width;
+        size = MAX(size_hint, size);
+
+        /* Calculate the height */
+        lua_Number fact = min_fact;
+        lua_rawgeti(L, 5, i);
+        if(!lua_toboolean(L, -1))
+        {
+            lua_pushnumber(L, fact);
+            lua_rawseti(L, 5, i);
+        }
+        else
+        {
+            fact = lua_tonumber(L, -1);
+            min_fact = MIN(fact, min_fact);
+        }
+        lua_pop(L, 1);
+        total_fact += fact;
+    }
+    size = MAX(1, MIN(size, available));
+
+    lua_Number coord = luaA_getfield_number(L, 3, y);
+    lua_Number unused = luaA_getfield_number(L, 3, height);
+    lua_Number used_size = 0;
+    for(int i = 1; i <= last - first + 1; i++)
+    {
+        lua_rawgeti(L, 5, i);
+        lua_Number fact = lua_tonumber(L, -1);
+        lua_pop(L, 1);
+
+        lua_Number geom_height = MAX(1, floor(unused * fact / total_fact));
+
+        lua_rawgeti(L, 2, first + i - 1);
+        client_t *c = luaA_checkudata(L, -1, &client_class);
+        lua_createtable(L, 0, 4);
+        lua_pushnumber(L, size);
+        lua_setfield(L, -2, width);
+        lua_pushnumber(L, geom_height);
+        lua_setfield(L, -2, height);
+        lua_pushnumber(L, group_coord);
+        lua_setfield(L, -2, x);
+        lua_pushnumber(L, coord);
+        lua_setfield(L, -2, y);
+        lua_rawset(L, 1);
+
+        lua_Number hint_width = vertical ? geom_height : size;
+        lua_Number hint_height = vertical ? size : geom_height;
+        client_layout_size(c, &hint_width, &hint_height, gap);
+        if(vertical)
+        {
+            lua_Number tmp = hint_width;
+            hint_width = hint_height;
+            hint_height = tmp;
+        }
+
+        coord += hint_height;
+        unused -= hint_height;
+        total_fact -= fact;
+        used_size = MAX(used_size, hint_width);
+    }
+
+    lua_pushnumber(L, used_size);
+    return 1;
+}
+
+/** Apply the geometries computed by a layout.
+ *
+ * The geometries include the border and the gap of each client. A client is
+ * not resized again if it was given the same geometry by the last call and
+ * has not changed since.
+ *
+ * @tparam table geometries The geometries, indexed by client.
+ * @tparam number useless_gap The gap around each client.
+ * @function apply_layout
+ */
+static int
+luaA_client_apply_layout(lua_State *L)
+{
+    luaA_checktable(L, 1);
+    lua_Number gap = luaL_checknumber(L, 2);
+
+    lua_pushnil(L);
+    while(lua_next(L, 1))
+    {
+        client_t *c = luaA_checkudata(L, -2, &client_class);
+        int bw = c->border_width;
+        area_t geometry;
+
+        luaA_checktable(L, -1);
+        geometry.x = round(MIN(MAX(luaA_getfield_number(L, -1, "x") + gap,
+                                   MIN_X11_COORDINATE), MAX_X11_COORDINATE));
+        geometry.y = round(MIN(MAX(luaA_getfield_number(L, -1, "y") + gap,
+                                   MIN_X11_COORDINATE), MAX_X11_COORDINATE));
+        if(client_isfixed(c))
+        {
+            geometry.width = c->geometry.width;
+            geometry.height = c->geometry.height;
+        }
+        else
+        {
+            lua_Number width = luaA_getfield_number(L, -1, "width") - bw * 2 - gap * 2;
+            lua_Number height = luaA_getfield_number(L, -1, "height") - bw * 2 - gap * 2;
+            geometry.width = ceil(MIN(MAX(width, 1), MAX_X11_SIZE));
+            geometry.height = ceil(MIN(MAX(height, 1), MAX_X11_SIZE));
+        }
+        lua_pop(L, 1);
+
+        if(c->layout_geometry_valid && AREA_EQUAL(c->layout_geometry, geometry))
+            continue;
+
+        client_resize(c, geometry, c->size_hints_honor);
+        c->layout_geometry = geometry;
+        c->layout_geometry_valid = true;
+    }
+
+    return 0;
+}
+
 /** Apply size hints to a size.
  *
  * @param width Desired width of client
@@ -3107,6 +3630,7 @@ static int
 luaA_client_set_size_hints_honor(lua_State *L, client_t *c)
 {
     c->size_hints_honor = luaA_checkboolean(L, -1);
+    c->layout_geometry_valid = false;
     luaA_object_emit_signal(L, -3, "property::size_hints_honor", 0);
     return 0;
 }
@@ -3297,6 +3821,38 @@ luaA_client_get_content(lua_State *L, client_t *c)
     return 1;
 }
 
+static int
+luaA_client_get_thumbnail(lua_State *L, client_t *c)
+{
+    cairo_surface_t *surface = thumbnail_get_surface(c);
+    if(!surface)
+        return 0;
+
+    /* lua has to make sure to free the ref or we have a leak */
+    lua_pushlightuserdata(L, cairo_surface_reference(surface));
+    return 1;
+}
+
+static int
+luaA_client_get_thumbnail_size(lua_State *L, client_t *c)
+{
+    lua_pushinteger(L, thumbnail_get_size(c));
+    return 1;
+}
+
+static int
+luaA_client_set_thumbnail_size(lua_State *L, client_t *c)
+{
+    int size = luaL_checkinteger(L, -1);
+    int old = thumbnail_get_size(c);
+    if(size < 0)
+        return 0;
+    thumbnail_set_size(c, size);
+    if(thumbnail_get_size(c) != old)
+        luaA_object_emit_signal(L, -3, "property::thumbnail_size", 0);
+    return 0;
+}
+
 static int
 luaA_client_get_icon(lua_State *L, client_t *c)
 {
@@ -3304,16 +3860,16 @@ luaA_client_get_icon(lua_State *L, client_t *c)
         return 0;
 
     /* Pick the closest available size, only picking a smaller icon if no bigger
-     * one is available.
+     * one is available. Only the chosen size gets decoded.
      */
-    cairo_surface_t *found = NULL;
+    draw_icon_t *found = NULL;
     int found_size = 0;
     int preferred_size = globalconf.preferred_icon_size;
 
-    foreach(surf, c->icons)
+    foreach(icon, c->icons)
     {
-        int width = cairo_image_surface_get_width(*surf);
-        int height = cairo_image_surface_get_height(*surf);
+        int width = icon->width;
+        int height = icon->height;
         int size = MAX(width, height);
 
         /* pick the icon if it's a better match than the one we already have */
@@ -3325,13 +3881,16 @@ luaA_client_get_icon(lua_State *L, client_t *c)
             size >= preferred_size && size < found_size;
         if (!icon_empty && (better_because_bigger || better_because_smaller || found_size == 0))
         {
-            found = *surf;
+            found = icon;
             found_size = size;
         }
     }
 
+    if(!found)
+        return 0;
+
     /* lua gets its own reference which it will have to destroy */
-    lua_pushlightuserdata(L, cairo_surface_reference(found));
+    lua_pushlightuserdata(L, cairo_surface_reference(draw_icon_get_surface(found)));
     return 1;
 }
 
@@ -3622,18 +4181,19 @@ static int
 luaA_client_keys(lua_State *L)
 {
     client_t *c = luaA_checkudata(L, 1, &client_class);
-    key_array_t *keys = &c->keys;
 
     if(lua_gettop(L) == 2)
     {
-        luaA_key_array_set(L, 1, 2, keys);
+        key_set_t *keys = luaA_key_set_get(L, 1, 2);
+        key_set_unref(L, 1, &c->keys);
+        c->keys = keys;
         luaA_object_emit_signal(L, 1, "property::keys", 0);
-        xwindow_grabkeys(c->window, keys);
+        xwindow_grabkeys(c->window, key_set_items(c->keys));
         if (c->nofocus_window)
-            xwindow_grabkeys(c->nofocus_window, &c->keys);
+            xwindow_grabkeys(c->nofocus_window, key_set_items(c->keys));
     }
 
-    return luaA_key_array_get(L, 1, keys);
+    return luaA_key_set_push(L, 1, c->keys);
 }
 
 static int
@@ -3642,14 +4202,14 @@ luaA_client_get_icon_sizes(lua_State *L, client_t *c)
     int index = 1;
 
     lua_newtable(L);
-    foreach (s, c->icons) {
+    foreach (icon, c->icons) {
         /* Create a table { width, height } and append it to the table */
         lua_createtable(L, 2, 0);
 
-        lua_pushinteger(L, cairo_image_surface_get_width(*s));
+        lua_pushinteger(L, icon->width);
         lua_rawseti(L, -2, 1);
 
-        lua_pushinteger(L, cairo_image_surface_get_height(*s));
+        lua_pushinteger(L, icon->height);
         lua_rawseti(L, -2, 2);
 
         lua_rawseti(L, -2, index++);
@@ -3675,7 +4235,8 @@ luaA_client_get_some_icon(lua_State *L)
     int index = luaL_checkinteger(L, 2);
     luaL_argcheck(L, (index >= 1 && index <= c->icons.len), 2,
             "invalid icon index");
-    lua_pushlightuserdata(L, cairo_surface_reference(c->icons.tab[index-1]));
+    cairo_surface_t *surface = draw_icon_get_surface(&c->icons.tab[index-1]);
+    lua_pushlightuserdata(L, cairo_surface_reference(surface));
     return 1;
 }
 
@@ -3741,6 +4302,9 @@ client_class_setup(lua_State *L)
     {
         LUA_CLASS_METHODS(client)
         { "get", luaA_client_get },
+        { "iterate", luaA_client_iterate },
+        { "tile_group", luaA_client_tile_group },
+        { "apply_layout", luaA_client_apply_layout },
         { "__index", luaA_client_module_index },
         { "__newindex", luaA_client_module_newindex },
         { NULL, NULL }
@@ -3791,6 +4355,14 @@ client_class_setup(lua_State *L)
                             NULL,
                             (lua_class_propfunc_t) luaA_client_get_content,
                             NULL);
+    luaA_class_add_property(&client_class, "thumbnail",
+                            NULL,
+                            (lua_class_propfunc_t) luaA_client_get_thumbnail,
+                            NULL);
+    luaA_class_add_property(&client_class, "thumbnail_size",
+                            (lua_class_propfunc_t) luaA_client_set_thumbnail_size,
+                            (lua_class_propfunc_t) luaA_client_get_thumbnail_size,
+                            (lua_class_propfunc_t) luaA_client_set_thumbnail_size);
     luaA_class_add_property(&client_class, "type",
                             NULL,
                             (lua_class_propfunc_t) luaA_window_get_type,
@@ -24,6 +24,8 @@
 
 #include "stack.h"
 #include "objects/window.h"
+#include "common/bitset.h"
+#include "ewmh.h"
 
 #define CLIENT_SELECT_INPUT_EVENT_MASK (XCB_EVENT_MASK_STRUCTURE_NOTIFY \
                                         | XCB_EVENT_MASK_PROPERTY_CHANGE \
@@ -89,6 +91,32 @@ typedef struct {
     uint32_t status;
 } motif_wm_hints_t;
 
+/** The requests sent by client_manage_request(), so that the replies for many
+ * windows can be waited for at once. */
+typedef struct
+{
+    xcb_get_property_cookie_t kde_check;
+    xcb_get_property_cookie_t startup_id;
+    xcb_get_property_cookie_t wm_normal_hints;
+    xcb_get_property_cookie_t wm_hints;
+    xcb_get_property_cookie_t wm_transient_for;
+    xcb_get_property_cookie_t wm_client_leader;
+    xcb_get_property_cookie_t wm_client_machine;
+    xcb_get_property_cookie_t wm_window_role;
+    xcb_get_property_cookie_t net_wm_pid;
+    xcb_get_property_cookie_t net_wm_icon;
+    xcb_get_property_cookie_t wm_name;
+    xcb_get_property_cookie_t net_wm_name;
+    xcb_get_property_cookie_t wm_icon_name;
+    xcb_get_property_cookie_t net_wm_icon_name;
+    xcb_get_property_cookie_t wm_class;
+    xcb_get_property_cookie_t wm_protocols;
+    xcb_get_property_cookie_t motif_wm_hints;
+    xcb_get_property_cookie_t opacity;
+    xcb_get_property_cookie_t strut;
+    ewmh_client_hints_cookies_t ewmh;
+} client_manage_cookies_t;
+
 /** client_t type */
 struct client_t
 {
@@ -108,6 +136,8 @@ struct client_t
     area_t x11_frame_geometry;
     /** Got a configure request and have to call client_send_configure() if its ignored? */
     bool got_configure_request;
+    /** Do the X11 geometries have to be checked in the next refresh? */
+    bool geometry_need_refresh;
     /** Startup ID */
     char *startup_id;
     /** True if the client is sticky */
@@ -140,6 +170,10 @@ struct client_t
      * Note that the geometry remains unchanged and that the window is still mapped.
      */
     bool isbanned;
+    /** Indexes of the tags of this client */
+    bitset_t tags;
+    /** True if the client is in the set of clients banning_refresh() checks */
+    bool banning_dirty;
     /** true if the client must be skipped from task bar client list */
     bool skip_taskbar;
     /** True if the client cannot have focus */
@@ -156,10 +190,12 @@ struct client_t
     xcb_window_t leader_window;
     /** Client's WM_PROTOCOLS property */
     xcb_icccm_get_wm_protocols_reply_t protocols;
-    /** Key bindings */
-    key_array_t keys;
+    /** Key bindings, shared with other clients using the same keys */
+    key_set_t *keys;
     /** Icons */
-    cairo_surface_array_t icons;
+    draw_icon_array_t icons;
+    /** The _NET_WM_ICON reply holding the data of icons, if any */
+    xcb_get_property_reply_t *icon_reply;
     /** True if we ever got an icon from _NET_WM_ICON */
     bool have_ewmh_icon;
     /** Size hints */
@@ -168,6 +204,10 @@ struct client_t
     xcb_visualtype_t *visualtype;
     /** Do we honor the client's size hints? */
     bool size_hints_honor;
+    /** The geometry requested by the last layout arrange */
+    area_t layout_geometry;
+    /** Is layout_geometry still the result of the current state? */
+    bool layout_geometry_valid;
     /** Machine the client is running on. */
     char *machine;
     /** Role of the client */
@@ -187,6 +227,8 @@ struct client_t
     } titlebar[CLIENT_TITLEBAR_COUNT];
     /** Motif WM hints, with an additional MWM_HINTS_AWESOME_SET bit */
     motif_wm_hints_t motif_wm_hints;
+    /** The thumbnail of the window, if enabled */
+    struct client_thumbnail_t *thumbnail;
 };
 
 ARRAY_FUNCS(client_t *, client, DO_NOTHING)
@@ -204,7 +246,10 @@ client_t * client_getbyframewin(xcb_window_t);
 void client_ban(client_t *);
 void client_ban_unfocus(client_t *);
 void client_unban(client_t *);
-void client_manage(xcb_window_t, xcb_get_geometry_reply_t *, xcb_get_window_attributes_reply_t *);
+client_manage_cookies_t client_manage_request(xcb_window_t);
+void client_manage_discard(client_manage_cookies_t *);
+void client_manage(xcb_window_t, xcb_get_geometry_reply_t *, xcb_get_window_attributes_reply_t *,
+                   client_manage_cookies_t *);
 bool client_resize(client_t *, area_t, bool);
 void client_unmanage(client_t *, bool);
 void client_kill(client_t *);
@@ -231,7 +276,8 @@ void client_set_name(lua_State *L, int, char *);
 void client_set_startup_id(lua_State *L, int, char *);
 void client_set_alt_name(lua_State *L, int, char *);
 void client_set_group_window(lua_State *, int, xcb_window_t);
-void client_set_icons(client_t *, cairo_surface_array_t);
+void client_set_icons(client_t *, draw_icon_array_t, xcb_get_property_reply_t *);
+size_t client_icons_bytes(void);
 void client_set_icon_from_pixmaps(client_t *, xcb_pixmap_t, xcb_pixmap_t);
 void client_set_skip_taskbar(lua_State *, int, bool);
 void client_set_motif_wm_hints(lua_State *, int, motif_wm_hints_t);
@@ -35,10 +35,25 @@
 #include "globalconf.h"
 
 #include <cairo-xcb.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+/** Maximum number of unused pixmaps kept for reuse */
+#define DRAWABLE_POOL_SIZE 8
+/** Maximum number of pixels of all unused pixmaps kept for reuse */
+#define DRAWABLE_POOL_MAX_PIXELS (4 * 1024 * 1024)
 
 /** Drawable object.
  *
  * @field surface The drawable's cairo surface.
+ * @field backend How the drawable is rendered, see
+ *   `awesome.set_drawable_backend`. Changing it gives the drawable a new,
+ *   empty surface. The surface of a `"threaded"` drawable changes after every
+ *   refresh, so it has to be fetched again for drawing.
+ * @field motion_rate The maximum number of `mouse::move` signals per second,
+ *   0 (the default) for no limit. Motion in between is held back and the
+ *   last position is emitted once the limit allows it, unless the pointer
+ *   left the drawable meanwhile.
  * @function drawable
  */
 
@@ -86,6 +101,14 @@
  * @signal property::surface
  */
 
+/**
+ * @signal property::backend
+ */
+
+/**
+ * @signal property::motion_rate
+ */
+
 /** Get the number of instances.
  *
  * @return The number of drawable objects alive.
@@ -106,6 +129,425 @@ static lua_class_t drawable_class;
 
 LUA_OBJECT_FUNCS(drawable_class, drawable_t, drawable)
 
+DO_ARRAY(drawable_t *, drawable, DO_NOTHING)
+
+/** Drawables with damage that was not copied to the screen yet */
+static drawable_array_t drawable_damaged;
+
+/** Threaded drawables waiting for the X server to read their last upload
+ * before their frames are rasterized */
+static drawable_array_t drawable_fenced;
+
+/** An unused pixmap that can be handed out again */
+typedef struct
+{
+    xcb_pixmap_t pixmap;
+    uint16_t width, height;
+} drawable_pooled_pixmap_t;
+
+static void
+drawable_pooled_pixmap_wipe(drawable_pooled_pixmap_t *p)
+{
+    xcb_free_pixmap(globalconf.connection, p->pixmap);
+}
+
+DO_ARRAY(drawable_pooled_pixmap_t, drawable_pooled_pixmap, drawable_pooled_pixmap_wipe)
+
+/** Pixmaps of drawables which were resized or destroyed, oldest first.
+ * Resizing animations and popups would otherwise create and free a pixmap for
+ * every frame.
+ */
+static struct
+{
+    drawable_pooled_pixmap_array_t pixmaps;
+    /** Number of pixels of all pixmaps in the pool */
+    unsigned long pixels;
+    /** Number of pixmap requests served from the pool */
+    unsigned long hits;
+    /** Number of pixmap requests which had to create a new pixmap */
+    unsigned long misses;
+    /** Number of pixmaps used by drawables, and their number of pixels */
+    unsigned long live_pixmaps, live_pixels;
+    /** Size of the image surfaces used by drawables */
+    unsigned long live_image_bytes;
+} drawable_pool;
+
+/** The backend of drawables which do not ask for a specific one */
+static drawable_backend_t drawable_default_backend = DRAWABLE_BACKEND_XCB;
+
+/** Can the X server attach our MIT-SHM segments? -1 if not known yet */
+static int drawable_shm_usable = -1;
+
+/* Linux allows the X server to attach a segment which was already marked for
+ * removal. Elsewhere, a segment can only be removed after the X server
+ * attached it, so each attach must be checked. */
+#ifdef __linux__
+#define DRAWABLE_SHM_CHECK_EVERY_ATTACH false
+#else
+#define DRAWABLE_SHM_CHECK_EVERY_ATTACH true
+#endif
+
+static const char *const drawable_backend_names[] =
+{
+    [DRAWABLE_BACKEND_DEFAULT] = "default",
+    [DRAWABLE_BACKEND_XCB] = "xcb",
+    [DRAWABLE_BACKEND_IMAGE] = "image",
+    [DRAWABLE_BACKEND_THREADED] = "threaded",
+};
+
+/** Maximum number of threads rasterizing threaded drawables */
+#define DRAWABLE_RASTER_THREADS 4
+
+/** The rasterization of the frames of a threaded drawable */
+typedef struct drawable_raster_job_t
+{
+    /** The drawable, or NULL if it lost its surface in the meantime */
+    drawable_t *drawable;
+    /** The image to rasterize to */
+    cairo_surface_t *raster;
+    /** The frames to rasterize, oldest first */
+    drawable_frame_array_t frames;
+    /** Set by the worker thread under drawable_raster_lock */
+    bool done;
+} drawable_raster_job_t;
+
+static gboolean drawable_raster_job_finish(gpointer);
+
+static GThreadPool *drawable_raster_pool;
+static GMutex drawable_raster_lock;
+static GCond drawable_raster_cond;
+
+/** Round a pixmap dimension up to its pool bucket.
+ * Only the three most significant bits are kept, so a pixmap wastes less than
+ * a quarter of its size in each dimension.
+ */
+static uint16_t
+drawable_pool_bucket(uint16_t size)
+{
+    int shift = 0;
+
+    while((size >> shift) >= 8)
+        shift++;
+    uint32_t rounded = ((uint32_t) size + (1 << shift) - 1) >> shift << shift;
+    return MIN(rounded, UINT16_MAX);
+}
+
+/** Get a pixmap of at least the given size.
+ * A pixmap from the pool is used if one is in the same bucket as the
+ * requested size. Otherwise a new pixmap with the size of the bucket is
+ * created, so that it can be reused for slightly bigger sizes later on.
+ */
+static drawable_pooled_pixmap_t
+drawable_pool_get(uint16_t width, uint16_t height)
+{
+    uint16_t bucket_width = drawable_pool_bucket(width);
+    uint16_t bucket_height = drawable_pool_bucket(height);
+
+    /* Prefer the most recently released pixmaps */
+    for(int i = drawable_pool.pixmaps.len - 1; i >= 0; i--)
+    {
+        drawable_pooled_pixmap_t *p = &drawable_pool.pixmaps.tab[i];
+        if(p->width >= width && p->width <= bucket_width
+           && p->height >= height && p->height <= bucket_height)
+        {
+            drawable_pooled_pixmap_t found =
+                drawable_pooled_pixmap_array_take(&drawable_pool.pixmaps, i);
+            drawable_pool.pixels -= (unsigned long) found.width * found.height;
+            drawable_pool.hits++;
+            return found;
+        }
+    }
+
+    drawable_pool.misses++;
+    drawable_pooled_pixmap_t p = {
+        .pixmap = xcb_generate_id(globalconf.connection),
+        .width = bucket_width,
+        .height = bucket_height
+    };
+    xcb_create_pixmap(globalconf.connection, globalconf.default_depth, p.pixmap,
+                      globalconf.screen->root, p.width, p.height);
+    return p;
+}
+
+/** Give a pixmap obtained from drawable_pool_get() back to the pool. */
+static void
+drawable_pool_put(drawable_pooled_pixmap_t p)
+{
+    unsigned long pixels = (unsigned long) p.width * p.height;
+
+    if(pixels > DRAWABLE_POOL_MAX_PIXELS)
+    {
+        drawable_pooled_pixmap_wipe(&p);
+        return;
+    }
+
+    /* Evict the oldest pixmaps to make room */
+    while(drawable_pool.pixmaps.len >= DRAWABLE_POOL_SIZE
+          || drawable_pool.pixels + pixels > DRAWABLE_POOL_MAX_PIXELS)
+    {
+        drawable_pooled_pixmap_t old =
+            drawable_pooled_pixmap_array_take(&drawable_pool.pixmaps, 0);
+        drawable_pool.pixels -= (unsigned long) old.width * old.height;
+        drawable_pooled_pixmap_wipe(&old);
+    }
+
+    drawable_pooled_pixmap_array_append(&drawable_pool.pixmaps, p);
+    drawable_pool.pixels += pixels;
+}
+
+/** Push a table with statistics about the pixmap pool.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_drawable_pool_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 4);
+    lua_pushinteger(L, drawable_pool.hits);
+    lua_setfield(L, -2, "hits");
+    lua_pushinteger(L, drawable_pool.misses);
+    lua_setfield(L, -2, "misses");
+    lua_pushinteger(L, drawable_pool.pixmaps.len);
+    lua_setfield(L, -2, "pixmaps");
+    lua_pushinteger(L, drawable_pool.pixels);
+    lua_setfield(L, -2, "pixels");
+    return 1;
+}
+
+/** Push the memory used by the pixmaps of drawables.
+ * Pixmaps live in the X server, they are counted with four bytes per pixel.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_drawable_memory_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 4);
+    lua_pushinteger(L, drawable_pool.live_pixmaps);
+    lua_setfield(L, -2, "pixmaps");
+    lua_pushinteger(L, drawable_pool.live_pixels * 4);
+    lua_setfield(L, -2, "bytes");
+    lua_pushinteger(L, drawable_pool.pixels * 4);
+    lua_setfield(L, -2, "pool_bytes");
+    lua_pushinteger(L, drawable_pool.live_image_bytes);
+    lua_setfield(L, -2, "image_bytes");
+    return 1;
+}
+
+/** Check if image surfaces can be uploaded to pixmaps as they are.
+ * This needs pixmaps with cairo's 32 bit per pixel layout, in the byte order
+ * of this machine.
+ */
+static bool
+drawable_image_supported(void)
+{
+    static int supported = -1;
+
+    if (supported >= 0)
+        return supported;
+
+    const xcb_setup_t *setup = xcb_get_setup(globalconf.connection);
+    const xcb_visualtype_t *v = globalconf.visual;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    uint8_t order = XCB_IMAGE_ORDER_MSB_FIRST;
+#else
+    uint8_t order = XCB_IMAGE_ORDER_LSB_FIRST;
+#endif
+
+    supported = false;
+    if (setup->image_byte_order == order
+        && (globalconf.default_depth == 24 || globalconf.default_depth == 32)
+        && v->red_mask == 0xff0000 && v->green_mask == 0xff00 && v->blue_mask == 0xff)
+        for (xcb_format_iterator_t it = xcb_setup_pixmap_formats_iterator(setup);
+             it.rem; xcb_format_next(&it))
+            if (it.data->depth == globalconf.default_depth)
+                supported = it.data->bits_per_pixel == 32;
+
+    if (!supported)
+        warn("The X server's pixmap format does not allow image drawables, using xcb instead");
+    return supported;
+}
+
+/** Give a drawable a MIT-SHM segment shared with the X server.
+ * \param d The drawable.
+ * \param size The size of the segment.
+ * \return True if the segment was attached.
+ */
+static bool
+drawable_shm_attach(drawable_t *d, size_t size)
+{
+    if (drawable_shm_usable == 0)
+        return false;
+    if (drawable_shm_usable < 0)
+    {
+        const xcb_query_extension_reply_t *ext =
+            xcb_get_extension_data(globalconf.connection, &xcb_shm_id);
+        if (!ext || !ext->present)
+        {
+            drawable_shm_usable = 0;
+            return false;
+        }
+    }
+
+    int id = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (id < 0)
+        return false;
+    void *data = shmat(id, NULL, 0);
+    if (data == (void *) -1)
+    {
+        shmctl(id, IPC_RMID, NULL);
+        return false;
+    }
+
+    xcb_shm_seg_t seg = xcb_generate_id(globalconf.connection);
+    if (drawable_shm_usable < 0 || DRAWABLE_SHM_CHECK_EVERY_ATTACH)
+    {
+        /* A remote X server cannot attach our memory */
+        xcb_generic_error_t *error = xcb_request_check(globalconf.connection,
+                xcb_shm_attach_checked(globalconf.connection, seg, id, false));
+        if (drawable_shm_usable < 0 && error)
+            warn("The X server cannot use MIT-SHM, image drawables are uploaded with PutImage");
+        drawable_shm_usable = error == NULL;
+        p_delete(&error);
+    }
+    else
+        xcb_shm_attach(globalconf.connection, seg, id, false);
+
+    /* The memory is freed once neither side has it attached anymore */
+    shmctl(id, IPC_RMID, NULL);
+
+    if (!drawable_shm_usable)
+    {
+        shmdt(data);
+        return false;
+    }
+    d->shm_seg = seg;
+    d->shm_data = data;
+    return true;
+}
+
+/** Wait until the X server read the last upload from the MIT-SHM segment of a
+ * drawable, so that it can be drawn to again.
+ * \param d The drawable.
+ */
+static void
+drawable_shm_wait(drawable_t *d)
+{
+    if (!d->shm_fence_pending)
+        return;
+    d->shm_fence_pending = false;
+    xcb_get_input_focus_reply_t *reply =
+        xcb_get_input_focus_reply(globalconf.connection, d->shm_fence, NULL);
+    p_delete(&reply);
+}
+
+/** Check without blocking whether the X server read the last upload from the
+ * MIT-SHM segment of a drawable.
+ * \param d The drawable.
+ * \return True if the segment can be drawn to again.
+ */
+static bool
+drawable_shm_done(drawable_t *d)
+{
+    if (!d->shm_fence_pending)
+        return true;
+
+    void *reply = NULL;
+    xcb_generic_error_t *error = NULL;
+    if (!xcb_poll_for_reply(globalconf.connection, d->shm_fence.sequence, &reply, &error))
+        return false;
+    p_delete(&reply);
+    p_delete(&error);
+    d->shm_fence_pending = false;
+    return true;
+}
+
+static void
+drawable_shm_detach(drawable_t *d)
+{
+    if (d->shm_fence_pending)
+        xcb_discard_reply(globalconf.connection, d->shm_fence.sequence);
+    d->shm_fence_pending = false;
+    if (!d->shm_data)
+        return;
+    xcb_shm_detach(globalconf.connection, d->shm_seg);
+    shmdt(d->shm_data);
+    d->shm_seg = XCB_NONE;
+    d->shm_data = NULL;
+}
+
+/** Upload a rectangle of an image surface without MIT-SHM.
+ * The rectangle is split into bands which fit into a request.
+ * \param d The drawable.
+ * \param image The image surface with the drawable's content.
+ * \param r The rectangle, in drawable coordinates.
+ */
+static void
+drawable_put_image(drawable_t *d, cairo_surface_t *image, const area_t *r)
+{
+    const uint8_t *data = cairo_image_surface_get_data(image);
+    size_t stride = cairo_image_surface_get_stride(image);
+    size_t row_len = (size_t) r->width * 4;
+    size_t max_len = (size_t) xcb_get_maximum_request_length(globalconf.connection) * 4
+        - sizeof(xcb_put_image_request_t);
+    int rows = MAX(1, MIN(r->height, (int) (max_len / row_len)));
+    uint8_t *buffer = NULL;
+
+    /* Rows which are not contiguous in the surface are copied together */
+    if (row_len != stride)
+        buffer = p_new(uint8_t, row_len * rows);
+
+    for (int y = 0; y < r->height; y += rows)
+    {
+        int count = MIN(rows, r->height - y);
+        const uint8_t *src = data + (r->y + y) * stride + r->x * 4;
+        if (buffer)
+        {
+            for (int i = 0; i < count; i++)
+                memcpy(buffer + i * row_len, src + i * stride, row_len);
+            src = buffer;
+        }
+        xcb_put_image(globalconf.connection, XCB_IMAGE_FORMAT_Z_PIXMAP, d->pixmap,
+                      globalconf.gc, r->width, count, r->x, r->y + y, 0,
+                      globalconf.default_depth, count * row_len, src);
+    }
+    p_delete(&buffer);
+}
+
+/** Copy the given rectangles of an image surface to the drawable's pixmap.
+ * \param d The drawable.
+ * \param rects The rectangles, in drawable coordinates.
+ * \param count The number of rectangles.
+ */
+static void
+drawable_upload(drawable_t *d, const area_t *rects, int count)
+{
+    cairo_surface_t *image = d->raster ? d->raster : d->surface;
+
+    cairo_surface_flush(image);
+    for (int i = 0; i < count; i++)
+    {
+        const area_t *r = &rects[i];
+        if (d->shm_data)
+            xcb_shm_put_image(globalconf.connection, d->pixmap, globalconf.gc,
+                              cairo_image_surface_get_stride(image) / 4,
+                              cairo_image_surface_get_height(image), r->x, r->y, r->width, r->height,
+                              r->x, r->y, globalconf.default_depth,
+                              XCB_IMAGE_FORMAT_Z_PIXMAP, false, d->shm_seg, 0);
+        else
+            drawable_put_image(d, image, r);
+    }
+
+    /* The X server reads the segment while handling the requests above */
+    if (d->shm_data)
+    {
+        if (d->shm_fence_pending)
+            xcb_discard_reply(globalconf.connection, d->shm_fence.sequence);
+        d->shm_fence = xcb_get_input_focus_unchecked(globalconf.connection);
+        d->shm_fence_pending = true;
+    }
+}
+
 drawable_t *
 drawable_allocator(lua_State *L, drawable_refresh_callback *callback, void *data)
 {
@@ -115,25 +557,352 @@ drawable_allocator(lua_State *L, drawable_refresh_callback *callback, void *data
     d->refreshed = false;
     d->surface = NULL;
     d->pixmap = XCB_NONE;
+    d->damage = NULL;
+    d->damaged = false;
+    d->backdrop = NULL;
+    d->backend = DRAWABLE_BACKEND_DEFAULT;
+    d->surface_backend = DRAWABLE_BACKEND_XCB;
+    d->shm_seg = XCB_NONE;
+    d->shm_data = NULL;
+    d->shm_fence_pending = false;
+    d->raster = NULL;
+    drawable_frame_array_init(&d->frames);
+    d->job = NULL;
+    d->fenced = false;
     return d;
 }
 
+/** Rasterize the frames of a job, on a worker thread.
+ * Lua redraws the complete damaged area, so the recording replaces the old
+ * content there.
+ */
+static void
+drawable_raster_job_run(gpointer data, gpointer user_data)
+{
+    drawable_raster_job_t *job = data;
+    cairo_t *cr = cairo_create(job->raster);
+
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    foreach(frame, job->frames)
+    {
+        cairo_save(cr);
+        for (int i = 0; i < cairo_region_num_rectangles(frame->damage); i++)
+        {
+            cairo_rectangle_int_t rect;
+            cairo_region_get_rectangle(frame->damage, i, &rect);
+            cairo_rectangle(cr, rect.x, rect.y, rect.width, rect.height);
+        }
+        cairo_clip(cr);
+        cairo_set_source_surface(cr, frame->recording, 0, 0);
+        cairo_paint(cr);
+        cairo_restore(cr);
+    }
+    cairo_destroy(cr);
+    cairo_surface_flush(job->raster);
+
+    g_mutex_lock(&drawable_raster_lock);
+    job->done = true;
+    g_cond_broadcast(&drawable_raster_cond);
+    g_mutex_unlock(&drawable_raster_lock);
+
+    g_idle_add(drawable_raster_job_finish, job);
+}
+
+/** Start rasterizing the recorded frames of a threaded drawable, unless this
+ * is already being done.
+ * \param d The drawable.
+ */
+static void
+drawable_raster_start(drawable_t *d)
+{
+    if (d->job || d->fenced || d->frames.len == 0)
+        return;
+
+    /* The X server might still read the image from the last upload.
+     * drawable_fences_poll() starts the job once it is done. */
+    if (!drawable_shm_done(d))
+    {
+        d->fenced = true;
+        drawable_array_append(&drawable_fenced, d);
+        return;
+    }
+
+    drawable_raster_job_t *job = p_new(drawable_raster_job_t, 1);
+    job->drawable = d;
+    job->raster = cairo_surface_reference(d->raster);
+    job->frames = d->frames;
+    drawable_frame_array_init(&d->frames);
+    d->job = job;
+
+    if (!drawable_raster_pool)
+        drawable_raster_pool = g_thread_pool_new(drawable_raster_job_run, NULL,
+                                                 MIN(g_get_num_processors(),
+                                                     DRAWABLE_RASTER_THREADS),
+                                                 FALSE, NULL);
+    g_thread_pool_push(drawable_raster_pool, job, NULL);
+}
+
+/** Start rasterizing the frames of the threaded drawables whose last upload
+ * was read by the X server in the meantime.
+ */
+void
+drawable_fences_poll(void)
+{
+    for (int i = 0; i < drawable_fenced.len; )
+    {
+        drawable_t *d = drawable_fenced.tab[i];
+        if (!drawable_shm_done(d))
+        {
+            i++;
+            continue;
+        }
+        drawable_array_take(&drawable_fenced, i);
+        d->fenced = false;
+        drawable_raster_start(d);
+    }
+}
+
+/** Wait for the rasterization of a threaded drawable, so that its surfaces
+ * can be freed. The result is not uploaded.
+ * \param d The drawable.
+ */
+static void
+drawable_raster_wait(drawable_t *d)
+{
+    if (d->fenced)
+        foreach(item, drawable_fenced)
+            if (*item == d)
+            {
+                drawable_array_remove(&drawable_fenced, item);
+                break;
+            }
+    d->fenced = false;
+    if (!d->job)
+        return;
+
+    g_mutex_lock(&drawable_raster_lock);
+    while (!d->job->done)
+        g_cond_wait(&drawable_raster_cond, &drawable_raster_lock);
+    g_mutex_unlock(&drawable_raster_lock);
+
+    /* drawable_raster_job_finish() only frees it */
+    d->job->drawable = NULL;
+    d->job = NULL;
+}
+
 static void
 drawable_unset_surface(drawable_t *d)
 {
+    cairo_surface_t *image = d->raster;
+
+    /* The new surface needs a new refresh */
+    if (d->damage)
+        cairo_region_destroy(d->damage);
+    d->damage = NULL;
+    drawable_raster_wait(d);
+    drawable_frame_array_wipe(&d->frames);
+    if (d->surface && d->surface_backend == DRAWABLE_BACKEND_IMAGE)
+        image = d->surface;
+    if (image)
+        drawable_pool.live_image_bytes -= (unsigned long)
+            cairo_image_surface_get_stride(image) * cairo_image_surface_get_height(image);
     cairo_surface_finish(d->surface);
     cairo_surface_destroy(d->surface);
+    if (d->raster)
+    {
+        cairo_surface_finish(d->raster);
+        cairo_surface_destroy(d->raster);
+    }
+    d->raster = NULL;
+    drawable_shm_detach(d);
     if (d->pixmap)
-        xcb_free_pixmap(globalconf.connection, d->pixmap);
+    {
+        drawable_pool.live_pixmaps--;
+        drawable_pool.live_pixels -= (unsigned long) d->pixmap_width * d->pixmap_height;
+        drawable_pool_put((drawable_pooled_pixmap_t) {
+                .pixmap = d->pixmap,
+                .width = d->pixmap_width,
+                .height = d->pixmap_height
+        });
+    }
     d->refreshed = false;
     d->surface = NULL;
     d->pixmap = XCB_NONE;
 }
 
+/** Create a surface recording the drawing of a threaded drawable.
+ * \param d The drawable.
+ * \return The new surface.
+ */
+static cairo_surface_t *
+drawable_new_recording(drawable_t *d)
+{
+    cairo_rectangle_t extents = { 0, 0, d->geometry.width, d->geometry.height };
+    return cairo_recording_surface_create(cairo_surface_get_content(d->raster), &extents);
+}
+
+/** Create the pixmap and surface of a drawable for its current geometry.
+ * \param d The drawable, which must not have a surface.
+ */
 static void
-drawable_wipe(drawable_t *d)
+drawable_create_surface(drawable_t *d)
+{
+    area_t geom = d->geometry;
+
+    /* The pixmap might be bigger than geom, the surface clips to it */
+    drawable_pooled_pixmap_t p = drawable_pool_get(geom.width, geom.height);
+    d->pixmap = p.pixmap;
+    d->pixmap_width = p.width;
+    d->pixmap_height = p.height;
+    drawable_pool.live_pixmaps++;
+    drawable_pool.live_pixels += (unsigned long) p.width * p.height;
+
+    d->surface_backend = d->backend;
+    if (d->surface_backend == DRAWABLE_BACKEND_DEFAULT)
+        d->surface_backend = drawable_default_backend;
+    if (d->surface_backend != DRAWABLE_BACKEND_XCB && !drawable_image_supported())
+        d->surface_backend = DRAWABLE_BACKEND_XCB;
+
+    if (d->surface_backend != DRAWABLE_BACKEND_XCB)
+    {
+        /* Depth 24 pixmaps ignore the alpha byte */
+        cairo_format_t format = globalconf.default_depth == 32
+            ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24;
+        int stride = cairo_format_stride_for_width(format, geom.width);
+        cairo_surface_t *image;
+        if (drawable_shm_attach(d, (size_t) stride * geom.height))
+            image = cairo_image_surface_create_for_data(d->shm_data, format,
+                                                        geom.width, geom.height, stride);
+        else
+            image = cairo_image_surface_create(format, geom.width, geom.height);
+        drawable_pool.live_image_bytes += (unsigned long) stride * geom.height;
+
+        if (d->surface_backend == DRAWABLE_BACKEND_THREADED)
+        {
+            d->raster = image;
+            d->surface = drawable_new_recording(d);
+        }
+        else
+            d->surface = image;
+    }
+    else
+        d->surface = cairo_xcb_surface_create(globalconf.connection,
+                                              d->pixmap, globalconf.visual,
+                                              geom.width, geom.height);
+}
+
+/** Free the surface, pixmap and backdrop of a drawable.
+ * This is done when a drawable is no longer shown, instead of waiting for
+ * the garbage collector to collect it. It stays without a surface until it
+ * gets a new geometry.
+ * \param d The drawable.
+ */
+void
+drawable_release(drawable_t *d)
 {
     drawable_unset_surface(d);
+    if (d->backdrop)
+        cairo_surface_destroy(d->backdrop);
+    d->backdrop = NULL;
+    if (d->damaged)
+        foreach(item, drawable_damaged)
+            if (*item == d)
+            {
+                drawable_array_remove(&drawable_damaged, item);
+                break;
+            }
+    d->damaged = false;
+}
+
+static void
+drawable_wipe(drawable_t *d)
+{
+    drawable_release(d);
+}
+
+/** Copy the damaged parts of a drawable to the screen.
+ * \param d The drawable.
+ * \param damage The damaged region, which is destroyed.
+ */
+static void
+drawable_copy_damage(drawable_t *d, cairo_region_t *damage)
+{
+    int count = cairo_region_num_rectangles(damage);
+    area_t *rects = p_alloca(area_t, count);
+    for (int i = 0; i < count; i++)
+    {
+        cairo_rectangle_int_t rect;
+        cairo_region_get_rectangle(damage, i, &rect);
+        rects[i] = (area_t) { .x = rect.x, .y = rect.y,
+                              .width = rect.width, .height = rect.height };
+    }
+    cairo_region_destroy(damage);
+
+    if (count > 0 && d->surface_backend != DRAWABLE_BACKEND_XCB && d->surface)
+        drawable_upload(d, rects, count);
+    if (count > 0)
+        (*d->refresh_callback)(d->refresh_data, rects, count);
+}
+
+/** Upload the frames rasterized by a worker thread, on the main thread.
+ * \param data The job.
+ * \return G_SOURCE_REMOVE.
+ */
+static gboolean
+drawable_raster_job_finish(gpointer data)
+{
+    drawable_raster_job_t *job = data;
+    drawable_t *d = job->drawable;
+
+    if (d)
+    {
+        cairo_region_t *damage = cairo_region_create();
+        foreach(frame, job->frames)
+            cairo_region_union(damage, frame->damage);
+        d->job = NULL;
+        drawable_copy_damage(d, damage);
+        /* Frames recorded in the meantime */
+        drawable_raster_start(d);
+    }
+
+    drawable_frame_array_wipe(&job->frames);
+    cairo_surface_destroy(job->raster);
+    p_delete(&job);
+    return G_SOURCE_REMOVE;
+}
+
+/** Copy the damaged parts of all drawables to the screen.
+ * All calls to drawable:refresh() since the last refresh cycle are handled
+ * together, so that overlapping damage is only copied once. Threaded
+ * drawables are copied once a worker thread rasterized them.
+ */
+void
+drawable_refresh(void)
+{
+    foreach(item, drawable_damaged)
+    {
+        drawable_t *d = *item;
+        cairo_region_t *damage = d->damage;
+
+        d->damaged = false;
+        d->damage = NULL;
+        if (!damage)
+            continue;
+
+        if (d->surface_backend == DRAWABLE_BACKEND_THREADED && d->surface)
+        {
+            /* Lua draws the next frame to a new recording */
+            drawable_frame_array_append(&d->frames, (drawable_frame_t) {
+                    .recording = d->surface,
+                    .damage = damage
+            });
+            d->surface = drawable_new_recording(d);
+            drawable_raster_start(d);
+        }
+        else
+            drawable_copy_damage(d, damage);
+    }
+    drawable_damaged.len = 0;
 }
 
 void
@@ -141,6 +910,7 @@ drawable_set_geometry(lua_State *L, int didx, area_t geom)
 {
     drawable_t *d = luaA_checkudata(L, didx, &drawable_class);
     area_t old = d->geometry;
+
     d->geometry = geom;
 
     bool size_changed = (old.width != geom.width) || (old.height != geom.height);
@@ -148,12 +918,7 @@ drawable_set_geometry(lua_State *L, int didx, area_t geom)
         drawable_unset_surface(d);
     if (size_changed && geom.width > 0 && geom.height > 0)
     {
-        d->pixmap = xcb_generate_id(globalconf.connection);
-        xcb_create_pixmap(globalconf.connection, globalconf.default_depth, d->pixmap,
-                          globalconf.screen->root, geom.width, geom.height);
-        d->surface = cairo_xcb_surface_create(globalconf.connection,
-                                              d->pixmap, globalconf.visual,
-                                              geom.width, geom.height);
+        drawable_create_surface(d);
         luaA_object_emit_signal(L, didx, "property::surface", 0);
     }
 
@@ -177,6 +942,9 @@ drawable_set_geometry(lua_State *L, int didx, area_t geom)
 static int
 luaA_drawable_get_surface(lua_State *L, drawable_t *drawable)
 {
+    /* Lua is about to draw to it */
+    if (drawable->surface_backend == DRAWABLE_BACKEND_IMAGE)
+        drawable_shm_wait(drawable);
     if (drawable->surface)
         /* Lua gets its own reference which it will have to destroy */
         lua_pushlightuserdata(L, cairo_surface_reference(drawable->surface));
@@ -185,21 +953,298 @@ luaA_drawable_get_surface(lua_State *L, drawable_t *drawable)
     return 1;
 }
 
+/** Get how a drawable is rendered.
+ * \param L The Lua VM state.
+ * \param drawable The drawable object.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_drawable_get_backend(lua_State *L, drawable_t *drawable)
+{
+    drawable_backend_t backend = drawable->surface ? drawable->surface_backend : drawable->backend;
+    lua_pushstring(L, drawable_backend_names[backend]);
+    return 1;
+}
+
+/** Check that a Lua value is the name of a drawable backend.
+ * \param L The Lua VM state.
+ * \param idx The index of the value.
+ * \return The backend.
+ */
+drawable_backend_t
+luaA_checkdrawable_backend(lua_State *L, int idx)
+{
+    const char *name = luaL_checkstring(L, idx);
+    for (int i = 0; i < countof(drawable_backend_names); i++)
+        if (A_STREQ(name, drawable_backend_names[i]))
+            return i;
+    luaL_argerror(L, idx, "expected \"default\", \"xcb\", \"image\" or \"threaded\"");
+    return DRAWABLE_BACKEND_DEFAULT;
+}
+
+/** Set how a drawable is rendered.
+ * \param L The Lua VM state.
+ * \param drawable The drawable object.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_drawable_set_backend(lua_State *L, drawable_t *drawable)
+{
+    drawable_backend_t backend = luaA_checkdrawable_backend(L, -1);
+
+    if (backend == drawable->backend)
+        return 0;
+    drawable->backend = backend;
+
+    if (drawable->surface)
+    {
+        drawable_unset_surface(drawable);
+        drawable_create_surface(drawable);
+        luaA_object_emit_signal(L, -3, "property::surface", 0);
+    }
+    luaA_object_emit_signal(L, -3, "property::backend", 0);
+    return 0;
+}
+
+/** Set the backend of drawables which do not ask for a specific one.
+ * \param backend The backend, not DRAWABLE_BACKEND_DEFAULT.
+ */
+void
+drawable_set_default_backend(drawable_backend_t backend)
+{
+    drawable_default_backend = backend;
+}
+
+/** Check if a drawable has handlers for mouse::move.
+ * \param d The drawable.
+ * \return True if motion has to be emitted on it.
+ */
+bool
+drawable_wants_motion(drawable_t *d)
+{
+    return luaA_object_has_signal(&drawable_class, d, "mouse::move");
+}
+
+/** Drop the motion held back by the rate limit of a drawable.
+ * \param L The Lua VM state.
+ * \param d The drawable.
+ */
+void
+drawable_cancel_motion(lua_State *L, drawable_t *d)
+{
+    if (!d->motion_source)
+        return;
+    g_source_remove(d->motion_source);
+    d->motion_source = 0;
+    luaA_object_unref(L, d);
+}
+
+static gboolean
+drawable_motion_timeout(gpointer data)
+{
+    lua_State *L = globalconf_get_lua_State();
+    drawable_t *d = data;
+
+    d->motion_source = 0;
+    d->motion_time = g_get_monotonic_time();
+    luaA_object_push(L, d);
+    lua_pushinteger(L, d->motion_x);
+    lua_pushinteger(L, d->motion_y);
+    luaA_object_emit_signal(L, -3, "mouse::move", 2);
+    lua_pop(L, 1);
+    /* Taken by drawable_emit_motion() */
+    luaA_object_unref(L, d);
+
+    return G_SOURCE_REMOVE;
+}
+
+/** Emit mouse::move on a drawable, respecting its motion_rate.
+ * Nothing is done if there are no handlers.
+ * \param L The Lua VM state.
+ * \param ud The index of the drawable on the stack.
+ * \param x The x coordinate of the pointer inside the drawable.
+ * \param y The y coordinate of the pointer inside the drawable.
+ */
+void
+drawable_emit_motion(lua_State *L, int ud, int x, int y)
+{
+    drawable_t *d = luaA_checkudata(L, ud, &drawable_class);
+    int64_t now = g_get_monotonic_time();
+
+    if (!drawable_wants_motion(d))
+        return;
+
+    if (d->motion_rate > 0)
+    {
+        int64_t wait = d->motion_time + G_USEC_PER_SEC / d->motion_rate - now;
+        if (wait > 0)
+        {
+            d->motion_x = x;
+            d->motion_y = y;
+            if (!d->motion_source)
+            {
+                /* Keep the drawable alive until the timeout ran */
+                lua_pushvalue(L, ud);
+                luaA_object_ref(L, -1);
+                d->motion_source = g_timeout_add(wait / 1000 + 1, drawable_motion_timeout, d);
+            }
+            return;
+        }
+    }
+
+    /* This motion replaces the held back one */
+    drawable_cancel_motion(L, d);
+    d->motion_time = now;
+    lua_pushvalue(L, ud);
+    lua_pushinteger(L, x);
+    lua_pushinteger(L, y);
+    luaA_object_emit_signal(L, -3, "mouse::move", 2);
+    lua_pop(L, 1);
+}
+
+/** Get the motion rate limit of a drawable.
+ * \param L The Lua VM state.
+ * \param drawable The drawable object.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_drawable_get_motion_rate(lua_State *L, drawable_t *drawable)
+{
+    lua_pushinteger(L, drawable->motion_rate);
+    return 1;
+}
+
+/** Set the motion rate limit of a drawable.
+ * \param L The Lua VM state.
+ * \param drawable The drawable object.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_drawable_set_motion_rate(lua_State *L, drawable_t *drawable)
+{
+    int rate = luaL_checkinteger(L, -1);
+
+    if (rate < 0 || rate == drawable->motion_rate)
+        return 0;
+    drawable->motion_rate = rate;
+    luaA_object_emit_signal(L, -3, "property::motion_rate", 0);
+    return 0;
+}
+
 /** Refresh a drawable's content. This has to be called whenever some drawing to
  * the drawable's surface has been done and should become visible.
  *
+ * The damaged parts are copied to the screen at the end of the current main
+ * loop iteration.
+ *
+ * @tparam[opt] table damage An array of rectangles (tables with `x`, `y`,
+ *   `width` and `height` in drawable coordinates) which were drawn to. The
+ *   whole drawable is refreshed if this is not given.
  * @function refresh
  */
 static int
 luaA_drawable_refresh(lua_State *L)
 {
     drawable_t *drawable = luaA_checkudata(L, 1, &drawable_class);
+    cairo_rectangle_int_t extents = {
+        .x = 0, .y = 0,
+        .width = drawable->geometry.width,
+        .height = drawable->geometry.height
+    };
+
     drawable->refreshed = true;
-    (*drawable->refresh_callback)(drawable->refresh_data);
+    if (!drawable->surface)
+        return 0;
+
+    if (!drawable->damage)
+        drawable->damage = cairo_region_create();
+    if (lua_isnoneornil(L, 2))
+        cairo_region_union_rectangle(drawable->damage, &extents);
+    else
+    {
+        luaA_checktable(L, 2);
+        for (int i = 1; i <= (int) luaA_rawlen(L, 2); i++)
+        {
+            lua_rawgeti(L, 2, i);
+            luaA_checktable(L, -1);
+            cairo_rectangle_int_t rect = {
+                .x = luaA_getopt_integer(L, -1, "x", 0),
+                .y = luaA_getopt_integer(L, -1, "y", 0),
+                .width = luaA_getopt_integer(L, -1, "width", 0),
+                .height = luaA_getopt_integer(L, -1, "height", 0)
+            };
+            lua_pop(L, 1);
+            if (rect.width > 0 && rect.height > 0)
+                cairo_region_union_rectangle(drawable->damage, &rect);
+        }
+        cairo_region_intersect_rectangle(drawable->damage, &extents);
+    }
+
+    if (!drawable->damaged)
+    {
+        drawable->damaged = true;
+        drawable_array_append(&drawable_damaged, drawable);
+    }
 
     return 0;
 }
 
+/** Get the part of the wallpaper that is below the drawable.
+ *
+ * This is used for pseudo-transparency. The surface has the size of the
+ * drawable and is only created again after the wallpaper changed or the
+ * drawable was moved or resized.
+ *
+ * @treturn[opt] surface A lightuserdata for a cairo surface. This reference
+ * must be destroyed! Nothing is returned if there is no wallpaper.
+ * @function backdrop
+ */
+static int
+luaA_drawable_backdrop(lua_State *L)
+{
+    drawable_t *d = luaA_checkudata(L, 1, &drawable_class);
+
+    if (!globalconf.wallpaper || d->geometry.width == 0 || d->geometry.height == 0)
+        return 0;
+
+    /* A worker thread replays the recordings of a threaded drawable and must
+     * not touch the X connection, so it gets a copy in client memory. */
+    cairo_surface_type_t type = d->surface_backend == DRAWABLE_BACKEND_THREADED
+        ? CAIRO_SURFACE_TYPE_IMAGE : cairo_surface_get_type(globalconf.wallpaper);
+
+    if (!d->backdrop
+        || d->backdrop_generation != globalconf.wallpaper_generation
+        || !AREA_EQUAL(d->backdrop_geometry, d->geometry)
+        || cairo_surface_get_type(d->backdrop) != type)
+    {
+        if (d->backdrop)
+            cairo_surface_destroy(d->backdrop);
+
+        if (type == CAIRO_SURFACE_TYPE_IMAGE)
+            d->backdrop = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+                                                     d->geometry.width,
+                                                     d->geometry.height);
+        else
+            /* This is a pixmap too, so the copy stays inside the X server */
+            d->backdrop = cairo_surface_create_similar(globalconf.wallpaper,
+                                                       CAIRO_CONTENT_COLOR,
+                                                       d->geometry.width,
+                                                       d->geometry.height);
+        cairo_t *cr = cairo_create(d->backdrop);
+        cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+        cairo_set_source_surface(cr, globalconf.wallpaper, -d->geometry.x, -d->geometry.y);
+        cairo_paint(cr);
+        cairo_destroy(cr);
+
+        d->backdrop_geometry = d->geometry;
+        d->backdrop_generation = globalconf.wallpaper_generation;
+    }
+
+    /* Lua gets its own reference which it will have to destroy */
+    lua_pushlightuserdata(L, cairo_surface_reference(d->backdrop));
+    return 1;
+}
+
 /** Get drawable geometry. The geometry consists of x, y, width and height.
  *
  * @treturn table A table with drawable coordinates and geometry.
@@ -227,6 +1272,7 @@ drawable_class_setup(lua_State *L)
         LUA_CLASS_META
         { "refresh", luaA_drawable_refresh },
         { "geometry", luaA_drawable_geometry },
+        { "backdrop", luaA_drawable_backdrop },
         { NULL, NULL },
     };
 
@@ -239,6 +1285,14 @@ drawable_class_setup(lua_State *L)
                             NULL,
                             (lua_class_propfunc_t) luaA_drawable_get_surface,
                             NULL);
+    luaA_class_add_property(&drawable_class, "backend",
+                            (lua_class_propfunc_t) luaA_drawable_set_backend,
+                            (lua_class_propfunc_t) luaA_drawable_get_backend,
+                            (lua_class_propfunc_t) luaA_drawable_set_backend);
+    luaA_class_add_property(&drawable_class, "motion_rate",
+                            (lua_class_propfunc_t) luaA_drawable_set_motion_rate,
+                            (lua_class_propfunc_t) luaA_drawable_get_motion_rate,
+                            (lua_class_propfunc_t) luaA_drawable_set_motion_rate);
 }
 
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -26,7 +26,41 @@
 #include "common/luaclass.h"
 #include "draw.h"
 
-typedef void drawable_refresh_callback(void *);
+#include <xcb/shm.h>
+
+/** Copy the given rectangles (in drawable coordinates) to the screen */
+typedef void drawable_refresh_callback(void *, const area_t *, int);
+
+/** How drawables are rendered */
+typedef enum
+{
+    /** Use the default set with awesome.set_drawable_backend() */
+    DRAWABLE_BACKEND_DEFAULT,
+    /** cairo draws to the pixmap with X RENDER requests */
+    DRAWABLE_BACKEND_XCB,
+    /** cairo draws to client memory, damaged parts are uploaded */
+    DRAWABLE_BACKEND_IMAGE,
+    /** Drawing is recorded and rasterized to client memory by a thread */
+    DRAWABLE_BACKEND_THREADED
+} drawable_backend_t;
+
+/** Drawing recorded for a threaded drawable between two refresh cycles */
+typedef struct
+{
+    /** The recording surface Lua drew to */
+    cairo_surface_t *recording;
+    /** The parts of it which were refreshed */
+    cairo_region_t *damage;
+} drawable_frame_t;
+
+static inline void
+drawable_frame_wipe(drawable_frame_t *frame)
+{
+    cairo_surface_destroy(frame->recording);
+    cairo_region_destroy(frame->damage);
+}
+
+DO_ARRAY(drawable_frame_t, drawable_frame, drawable_frame_wipe)
 
 /** drawable type */
 struct drawable_t
@@ -34,12 +68,48 @@ struct drawable_t
     LUA_OBJECT_HEADER
     /** The pixmap we are drawing to. */
     xcb_pixmap_t pixmap;
+    /** The size of the pixmap, which can be bigger than the geometry. */
+    uint16_t pixmap_width, pixmap_height;
     /** Surface for drawing. */
     cairo_surface_t *surface;
+    /** The backend asked for, and the one the surface uses. */
+    drawable_backend_t backend, surface_backend;
+    /** The MIT-SHM segment an image surface uses, or XCB_NONE. */
+    xcb_shm_seg_t shm_seg;
+    /** The memory of the MIT-SHM segment. */
+    void *shm_data;
+    /** Request after the last upload from the segment, if not done yet. */
+    xcb_get_input_focus_cookie_t shm_fence;
+    bool shm_fence_pending;
+    /** The image a threaded drawable is rasterized to, NULL otherwise. */
+    cairo_surface_t *raster;
+    /** Frames of a threaded drawable which were not rasterized yet. */
+    drawable_frame_array_t frames;
+    /** The rasterization running on a worker thread, or NULL. */
+    struct drawable_raster_job_t *job;
+    /** Is the next rasterization waiting for shm_fence? */
+    bool fenced;
     /** The geometry of the drawable (in root window coordinates). */
     area_t geometry;
     /** Surface contents are undefined if this is false. */
     bool refreshed;
+    /** Parts of the surface which were refreshed, but not copied yet. */
+    cairo_region_t *damage;
+    /** Is this drawable in the list of drawables to refresh? */
+    bool damaged;
+    /** The part of the wallpaper below the drawable, or NULL. */
+    cairo_surface_t *backdrop;
+    /** The geometry and wallpaper generation the backdrop was made for. */
+    area_t backdrop_geometry;
+    unsigned int backdrop_generation;
+    /** Maximum number of mouse::move signals per second, 0 for no limit. */
+    int motion_rate;
+    /** When mouse::move was last emitted, in monotonic microseconds. */
+    int64_t motion_time;
+    /** Timeout emitting the motion held back by the rate limit, or 0. */
+    unsigned int motion_source;
+    /** The position of the held back motion. */
+    int motion_x, motion_y;
     /** Callback for refreshing. */
     drawable_refresh_callback *refresh_callback;
     /** Data for refresh callback. */
@@ -49,7 +119,16 @@ typedef struct drawable_t drawable_t;
 
 drawable_t *drawable_allocator(lua_State *, drawable_refresh_callback *, void *);
 void drawable_set_geometry(lua_State *, int, area_t);
+void drawable_release(drawable_t *);
+void drawable_fences_poll(void);
 void drawable_class_setup(lua_State *);
+int luaA_drawable_pool_stats(lua_State *);
+int luaA_drawable_memory_stats(lua_State *);
+drawable_backend_t luaA_checkdrawable_backend(lua_State *, int);
+void drawable_set_default_backend(drawable_backend_t);
+bool drawable_wants_motion(drawable_t *);
+void drawable_emit_motion(lua_State *, int, int, int);
+void drawable_cancel_motion(lua_State *, drawable_t *);
 
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
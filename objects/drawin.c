@@ -32,6 +32,7 @@
 
 #include "drawin.h"
 #include "common/atoms.h"
+#include "common/hash.h"
 #include "common/xcursor.h"
 #include "common/xutil.h"
 #include "event.h"
@@ -146,6 +147,11 @@
 
 LUA_OBJECT_FUNCS(drawin_class, drawin_t, drawin)
 
+DO_HASH(xcb_window_t, drawin_t *, drawin_window, a_inthash, a_inteq)
+
+/** Window id to drawin index of all visible drawins. */
+static drawin_window_hash_t drawins_by_window;
+
 /** Kick out systray windows.
  */
 static void
@@ -199,11 +205,15 @@ drawin_update_drawing(lua_State *L, int widx)
 
 /** Refresh the window content by copying its pixmap data to its window.
  * \param w The drawin to refresh.
+ * \param rects The damaged rectangles.
+ * \param count The number of rectangles.
  */
-static inline void
-drawin_refresh_pixmap(drawin_t *w)
+static void
+drawin_refresh_pixmap(drawin_t *w, const area_t *rects, int count)
 {
-    drawin_refresh_pixmap_partial(w, 0, 0, w->geometry.width, w->geometry.height);
+    for (int i = 0; i < count; i++)
+        drawin_refresh_pixmap_partial(w, rects[i].x, rects[i].y,
+                                      rects[i].width, rects[i].height);
 }
 
 static void
@@ -213,16 +223,25 @@ drawin_apply_moveresize(drawin_t *w)
         return;
 
     w->geometry_dirty = false;
+
+    /* Send a pending border width change in the same request */
+    uint16_t mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y
+        | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
+    if(w->dirty & WINDOW_DIRTY_BORDER_WIDTH)
+    {
+        mask |= XCB_CONFIG_WINDOW_BORDER_WIDTH;
+        w->dirty &= ~WINDOW_DIRTY_BORDER_WIDTH;
+    }
+
     client_ignore_enterleave_events();
-    xcb_configure_window(globalconf.connection, w->window,
-                         XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y
-                         | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
+    xcb_configure_window(globalconf.connection, w->window, mask,
                          (const uint32_t [])
                          {
                              w->geometry.x,
                              w->geometry.y,
                              w->geometry.width,
-                             w->geometry.height
+                             w->geometry.height,
+                             w->border_width
                          });
     client_restore_enterleave_events();
 }
@@ -327,6 +346,8 @@ drawin_map(lua_State *L, int widx)
     drawin_t *drawin = luaA_checkudata(L, widx, &drawin_class);
     /* Apply any pending changes */
     drawin_apply_moveresize(drawin);
+    /* The compositor must know the opacity before the window is shown */
+    window_border_refresh((window_t *) drawin);
     /* Activate BMA */
     client_ignore_enterleave_events();
     /* Map the drawin */
@@ -337,6 +358,7 @@ drawin_map(lua_State *L, int widx)
     stack_windows();
     /* Add it to the list of visible drawins */
     drawin_array_append(&globalconf.drawins, drawin);
+    drawin_window_hash_insert(&drawins_by_window, drawin->window, drawin);
     /* Make sure it has a surface */
     if(drawin->drawable->surface == NULL)
         drawin_update_drawing(L, widx);
@@ -352,6 +374,7 @@ drawin_unmap(drawin_t *drawin)
             drawin_array_remove(&globalconf.drawins, item);
             break;
         }
+    drawin_window_hash_remove(&drawins_by_window, drawin->window);
 }
 
 /** Get a drawin by its window.
@@ -361,10 +384,8 @@ drawin_unmap(drawin_t *drawin)
 drawin_t *
 drawin_getbywin(xcb_window_t win)
 {
-    foreach(w, globalconf.drawins)
-        if((*w)->window == win)
-            return *w;
-    return NULL;
+    drawin_t **w = drawin_window_hash_lookup(&drawins_by_window, win);
+    return w ? *w : NULL;
 }
 
 /** Set a drawin visible or not.
@@ -35,6 +35,7 @@
  */
 
 #include "objects/key.h"
+#include "globalconf.h"
 #include "common/xutil.h"
 #include "xkb.h"
 
@@ -94,6 +95,7 @@ luaA_keystore(lua_State *L, int ud, const char *str, ssize_t len)
         return;
 
     keyb_t *key = luaA_checkudata(L, ud, &key_class);
+    globalconf.bindings_generation++;
 
     if(len == 1)
     {
@@ -176,48 +178,7 @@ luaA_key_new(lua_State *L)
     return luaA_class_new(L, &key_class);
 }
 
-/** Set a key array with a Lua table.
- * \param L The Lua VM state.
- * \param oidx The index of the object to store items into.
- * \param idx The index of the Lua table.
- * \param keys The array key to fill.
- */
-void
-luaA_key_array_set(lua_State *L, int oidx, int idx, key_array_t *keys)
-{
-    luaA_checktable(L, idx);
-
-    foreach(key, *keys)
-        luaA_object_unref_item(L, oidx, *key);
-
-    key_array_wipe(keys);
-    key_array_init(keys);
-
-    lua_pushnil(L);
-    while(lua_next(L, idx))
-        if(luaA_toudata(L, -1, &key_class))
-            key_array_append(keys, luaA_object_ref_item(L, oidx, -1));
-        else
-            lua_pop(L, 1);
-}
-
-/** Push an array of key as an Lua table onto the stack.
- * \param L The Lua VM state.
- * \param oidx The index of the object to get items from.
- * \param keys The key array to push.
- * \return The number of elements pushed on stack.
- */
-int
-luaA_key_array_get(lua_State *L, int oidx, key_array_t *keys)
-{
-    lua_createtable(L, keys->len, 0);
-    for(int i = 0; i < keys->len; i++)
-    {
-        luaA_object_push_item(L, oidx, keys->tab[i]);
-        lua_rawseti(L, -2, i + 1);
-    }
-    return 1;
-}
+OBJECT_SET_FUNCS(keyb_t, key, key_class, globalconf.bindings_generation++)
 
 /** Push a modifier set to a Lua table.
  * \param L The Lua VM state.
@@ -268,6 +229,7 @@ static int
 luaA_key_set_modifiers(lua_State *L, keyb_t *k)
 {
     k->modifiers = luaA_tomodifiers(L, -1);
+    globalconf.bindings_generation++;
     luaA_object_emit_signal(L, -3, "property::modifiers", 0);
     return 0;
 }
@@ -23,6 +23,7 @@
 #define AWESOME_OBJECTS_KEY_H
 
 #include "common/luaobject.h"
+#include "common/objectset.h"
 
 typedef struct keyb_t
 {
@@ -38,12 +39,10 @@ typedef struct keyb_t
 lua_class_t key_class;
 LUA_OBJECT_FUNCS(key_class, keyb_t, key)
 DO_ARRAY(keyb_t *, key, DO_NOTHING)
+OBJECT_SET_TYPE(keyb_t, key)
 
 void key_class_setup(lua_State *);
 
-void luaA_key_array_set(lua_State *, int, int, key_array_t *);
-int luaA_key_array_get(lua_State *, int, key_array_t *);
-
 int luaA_pushmodifiers(lua_State *, uint16_t);
 uint16_t luaA_tomodifiers(lua_State *L, int ud);
 
@@ -53,6 +53,8 @@
 
 #include <stdio.h>
 
+#include <glib.h>
+
 #include <xcb/xcb.h>
 #include <xcb/xinerama.h>
 #include <xcb/randr.h>
@@ -225,6 +227,8 @@ screen_output_wipe(screen_output_t *output)
 ARRAY_FUNCS(screen_output_t, screen_output, screen_output_wipe)
 
 static lua_class_t screen_class;
+
+static void screen_update_primary_reply(xcb_randr_get_output_primary_cookie_t);
 LUA_OBJECT_FUNCS(screen_class, screen_t, screen)
 
 /** Collect a screen. */
@@ -259,6 +263,118 @@ luaA_checkscreen(lua_State *L, int sidx)
         return luaA_checkudata(L, sidx, &screen_class);
 }
 
+/** A grid over all screen edges, used by screen_getbycoord().
+ * The sorted, distinct left and right edges of the screens split the X axis
+ * into columns and likewise for the Y axis. Each cell of the resulting grid is
+ * covered by the same screens, so it can store the first of them.
+ */
+static struct
+{
+    /** Is the grid up to date with globalconf.screens? */
+    bool valid;
+    /** The distinct screen edges */
+    int *xs, *ys;
+    int nx, ny;
+    /** (nx - 1) * (ny - 1) cells, NULL where no screen is */
+    screen_t **cells;
+    /** The cell of the last successful lookup */
+    area_t last_cell;
+    screen_t *last_screen;
+} screen_index;
+
+/** Mark the screen index as outdated.
+ * This must be called whenever the screen list or a screen geometry changes.
+ */
+static void
+screen_index_invalidate(void)
+{
+    screen_index.valid = false;
+    screen_index.last_screen = NULL;
+}
+
+/** Insert a value into a sorted array of distinct values.
+ * \param values The array, with enough space for one more value.
+ * \param len The number of values in the array, updated.
+ * \param value The value to insert.
+ */
+static void
+screen_index_add_edge(int *values, int *len, int value)
+{
+    int i = *len;
+    while(i > 0 && values[i - 1] > value)
+        i--;
+    if(i > 0 && values[i - 1] == value)
+        return;
+    memmove(&values[i + 1], &values[i], (*len - i) * sizeof(*values));
+    values[i] = value;
+    (*len)++;
+}
+
+/** Find the grid column containing a value.
+ * \return The index of the last edge not after value, or -1.
+ */
+static int
+screen_index_find(const int *values, int len, int value)
+{
+    int low = 0, high = len;
+
+    while(low < high)
+    {
+        int mid = (low + high) / 2;
+        if(values[mid] <= value)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low - 1;
+}
+
+static void
+screen_index_rebuild(void)
+{
+    int len = globalconf.screens.len;
+
+    p_delete(&screen_index.xs);
+    p_delete(&screen_index.ys);
+    p_delete(&screen_index.cells);
+    screen_index.xs = p_new(int, 2 * len);
+    screen_index.ys = p_new(int, 2 * len);
+    screen_index.nx = screen_index.ny = 0;
+
+    foreach(s, globalconf.screens)
+    {
+        area_t geo = (*s)->geometry;
+        if(geo.width == 0 || geo.height == 0)
+            continue;
+        screen_index_add_edge(screen_index.xs, &screen_index.nx, geo.x);
+        screen_index_add_edge(screen_index.xs, &screen_index.nx, geo.x + geo.width);
+        screen_index_add_edge(screen_index.ys, &screen_index.ny, geo.y);
+        screen_index_add_edge(screen_index.ys, &screen_index.ny, geo.y + geo.height);
+    }
+
+    int columns = MAX(screen_index.nx - 1, 0);
+    int rows = MAX(screen_index.ny - 1, 0);
+    screen_index.cells = p_new(screen_t *, MAX(columns * rows, 1));
+
+    /* Earlier screens win, like in a linear search over the list */
+    foreach(s, globalconf.screens)
+    {
+        area_t geo = (*s)->geometry;
+        if(geo.width == 0 || geo.height == 0)
+            continue;
+        int x1 = screen_index_find(screen_index.xs, screen_index.nx, geo.x);
+        int x2 = screen_index_find(screen_index.xs, screen_index.nx, geo.x + geo.width);
+        int y1 = screen_index_find(screen_index.ys, screen_index.ny, geo.y);
+        int y2 = screen_index_find(screen_index.ys, screen_index.ny, geo.y + geo.height);
+        for(int y = y1; y < y2; y++)
+            for(int x = x1; x < x2; x++)
+                if(!screen_index.cells[y * columns + x])
+                    screen_index.cells[y * columns + x] = *s;
+    }
+
+    screen_index.valid = true;
+}
+
 static void
 screen_deduplicate(lua_State *L, screen_array_t *screens)
 {
@@ -316,13 +432,21 @@ screen_scan_randr_monitors(lua_State *L, screen_array_t *screens)
         return;
     }
 
+    /* Ask for all monitor names before waiting for any of them */
+    xcb_get_atom_name_cookie_t name_c[MAX(xcb_randr_get_monitors_monitors_length(monitors_r), 1)];
+    int monitor_idx = 0;
+    for(monitor_iter = xcb_randr_get_monitors_monitors_iterator(monitors_r);
+            monitor_iter.rem; xcb_randr_monitor_info_next(&monitor_iter))
+        if(xcb_randr_monitor_info_outputs_length(monitor_iter.data))
+            name_c[monitor_idx++] = xcb_get_atom_name_unchecked(globalconf.connection, monitor_iter.data->name);
+
+    monitor_idx = 0;
     for(monitor_iter = xcb_randr_get_monitors_monitors_iterator(monitors_r);
             monitor_iter.rem; xcb_randr_monitor_info_next(&monitor_iter))
     {
         screen_t *new_screen;
         screen_output_t output;
         xcb_randr_output_t *randr_outputs;
-        xcb_get_atom_name_cookie_t name_c;
         xcb_get_atom_name_reply_t *name_r;
 
         if(!xcb_randr_monitor_info_outputs_length(monitor_iter.data))
@@ -338,8 +462,7 @@ screen_scan_randr_monitors(lua_State *L, screen_array_t *screens)
         output.mm_width = monitor_iter.data->width_in_millimeters;
         output.mm_height = monitor_iter.data->height_in_millimeters;
 
-        name_c = xcb_get_atom_name_unchecked(globalconf.connection, monitor_iter.data->name);
-        name_r = xcb_get_atom_name_reply(globalconf.connection, name_c, NULL);
+        name_r = xcb_get_atom_name_reply(globalconf.connection, name_c[monitor_idx++], NULL);
         if (name_r) {
             const char *name = xcb_get_atom_name_name(name_r);
             size_t len = xcb_get_atom_name_name_length(name_r);
@@ -385,36 +508,62 @@ screen_scan_randr_crtcs(lua_State *L, screen_array_t *screens)
 
     /* We go through CRTC, and build a screen for each one. */
     xcb_randr_crtc_t *randr_crtcs = xcb_randr_get_screen_resources_crtcs(screen_res_r);
+    int num_crtcs = screen_res_r->num_crtcs;
+    xcb_randr_get_crtc_info_cookie_t crtc_info_c[MAX(num_crtcs, 1)];
+    xcb_randr_get_crtc_info_reply_t *crtc_info_r[MAX(num_crtcs, 1)];
+    int num_outputs = 0;
+
+    /* Send all requests before waiting for any reply: first for the CRTCs,
+     * then for the outputs of all of them. */
+    for(int i = 0; i < num_crtcs; i++)
+        crtc_info_c[i] = xcb_randr_get_crtc_info(globalconf.connection, randr_crtcs[i], XCB_CURRENT_TIME);
+    for(int i = 0; i < num_crtcs; i++)
+    {
+        crtc_info_r[i] = xcb_randr_get_crtc_info_reply(globalconf.connection, crtc_info_c[i], NULL);
+        if(!crtc_info_r[i])
+            warn("RANDR GetCRTCInfo failed; this should not be possible");
+        else
+            num_outputs += xcb_randr_get_crtc_info_outputs_length(crtc_info_r[i]);
+    }
 
-    for(int i = 0; i < screen_res_r->num_crtcs; i++)
+    xcb_randr_get_output_info_cookie_t output_info_c[MAX(num_outputs, 1)];
+    int output_idx = 0;
+    for(int i = 0; i < num_crtcs; i++)
     {
-        /* Get info on the output crtc */
-        xcb_randr_get_crtc_info_cookie_t crtc_info_c = xcb_randr_get_crtc_info(globalconf.connection, randr_crtcs[i], XCB_CURRENT_TIME);
-        xcb_randr_get_crtc_info_reply_t *crtc_info_r = xcb_randr_get_crtc_info_reply(globalconf.connection, crtc_info_c, NULL);
+        if(!crtc_info_r[i])
+            continue;
+        xcb_randr_output_t *randr_outputs = xcb_randr_get_crtc_info_outputs(crtc_info_r[i]);
+        for(int j = 0; j < xcb_randr_get_crtc_info_outputs_length(crtc_info_r[i]); j++)
+            output_info_c[output_idx++] = xcb_randr_get_output_info(globalconf.connection, randr_outputs[j], XCB_CURRENT_TIME);
+    }
 
-        if(!crtc_info_r) {
-            warn("RANDR GetCRTCInfo failed; this should not be possible");
+    output_idx = 0;
+    for(int i = 0; i < num_crtcs; i++)
+    {
+        if(!crtc_info_r[i])
             continue;
-        }
 
         /* If CRTC has no OUTPUT, ignore it */
-        if(!xcb_randr_get_crtc_info_outputs_length(crtc_info_r))
+        int crtc_outputs = xcb_randr_get_crtc_info_outputs_length(crtc_info_r[i]);
+        if(!crtc_outputs)
+        {
+            p_delete(&crtc_info_r[i]);
             continue;
+        }
 
         /* Prepare the new screen */
         screen_t *new_screen = screen_add(L, screens);
-        new_screen->geometry.x = crtc_info_r->x;
-        new_screen->geometry.y = crtc_info_r->y;
-        new_screen->geometry.width= crtc_info_r->width;
-        new_screen->geometry.height= crtc_info_r->height;
+        new_screen->geometry.x = crtc_info_r[i]->x;
+        new_screen->geometry.y = crtc_info_r[i]->y;
+        new_screen->geometry.width= crtc_info_r[i]->width;
+        new_screen->geometry.height= crtc_info_r[i]->height;
         new_screen->xid = randr_crtcs[i];
 
-        xcb_randr_output_t *randr_outputs = xcb_randr_get_crtc_info_outputs(crtc_info_r);
+        xcb_randr_output_t *randr_outputs = xcb_randr_get_crtc_info_outputs(crtc_info_r[i]);
 
-        for(int j = 0; j < xcb_randr_get_crtc_info_outputs_length(crtc_info_r); j++)
+        for(int j = 0; j < crtc_outputs; j++)
         {
-            xcb_randr_get_output_info_cookie_t output_info_c = xcb_randr_get_output_info(globalconf.connection, randr_outputs[j], XCB_CURRENT_TIME);
-            xcb_randr_get_output_info_reply_t *output_info_r = xcb_randr_get_output_info_reply(globalconf.connection, output_info_c, NULL);
+            xcb_randr_get_output_info_reply_t *output_info_r = xcb_randr_get_output_info_reply(globalconf.connection, output_info_c[output_idx++], NULL);
             screen_output_t output;
 
             if (!output_info_r) {
@@ -451,11 +600,18 @@ screen_scan_randr_crtcs(lua_State *L, screen_array_t *screens)
                 screen_array_wipe(screens);
                 screen_array_init(screens);
 
+                /* Throw away the replies we are not going to look at */
+                while(output_idx < num_outputs)
+                    xcb_discard_reply(globalconf.connection, output_info_c[output_idx++].sequence);
+                for(; i < num_crtcs; i++)
+                    p_delete(&crtc_info_r[i]);
+                p_delete(&screen_res_r);
+
                 return;
             }
         }
 
-        p_delete(&crtc_info_r);
+        p_delete(&crtc_info_r[i]);
     }
 
     p_delete(&screen_res_r);
@@ -598,6 +754,7 @@ screen_scan(void)
     check(globalconf.screens.len > 0);
 
     screen_deduplicate(L, &globalconf.screens);
+    screen_index_invalidate();
 
     foreach(screen, globalconf.screens) {
         screen_added(L, *screen);
@@ -632,6 +789,7 @@ screen_modified(screen_t *existing_screen, screen_t *other_screen)
     if(!AREA_EQUAL(existing_screen->geometry, other_screen->geometry)) {
         area_t old_geometry = existing_screen->geometry;
         existing_screen->geometry = other_screen->geometry;
+        screen_index_invalidate();
         luaA_object_push(L, existing_screen);
         luaA_pusharea(L, old_geometry);
         luaA_object_emit_signal(L, -2, "property::geometry", 1);
@@ -661,11 +819,213 @@ screen_modified(screen_t *existing_screen, screen_t *other_screen)
     }
 }
 
+/** Managed clients with struts. Only these can affect a workarea, so there is
+ * no need to look at all the other clients.
+ */
+static client_array_t strut_clients;
+
+/** Mark the workarea of a screen as outdated.
+ * The workarea is recomputed once during the next refresh, or when it is
+ * queried before that, no matter how many struts changed in the meantime.
+ * \param screen The screen, may be NULL.
+ */
 void
-screen_refresh(void)
+screen_update_workarea(screen_t *screen)
+{
+    if(screen)
+        screen->need_workarea_update = true;
+}
+
+/** Update the list of strut providers after the struts of a client changed.
+ * \param c The client.
+ */
+void
+screen_strut_client_changed(client_t *c)
+{
+    bool found = false;
+
+    foreach(elem, strut_clients)
+        if(*elem == c)
+        {
+            found = true;
+            if(!strut_has_value(&c->strut))
+                client_array_remove(&strut_clients, elem);
+            break;
+        }
+    if(!found && strut_has_value(&c->strut))
+        client_array_append(&strut_clients, c);
+
+    screen_update_workarea(c->screen);
+}
+
+/** Forget about the struts of a client which is being unmanaged.
+ * \param c The client.
+ */
+void
+screen_strut_client_remove(client_t *c)
+{
+    foreach(elem, strut_clients)
+        if(*elem == c)
+        {
+            client_array_remove(&strut_clients, elem);
+            screen_update_workarea(c->screen);
+            break;
+        }
+}
+
+/** Recompute the workarea of a screen if it was marked as outdated.
+ * \param screen The screen.
+ */
+static void
+screen_refresh_workarea(screen_t *screen)
+{
+    if(!screen->need_workarea_update)
+        return;
+    screen->need_workarea_update = false;
+
+    area_t area = screen->geometry;
+    uint16_t top = 0, bottom = 0, left = 0, right = 0;
+
+#define COMPUTE_STRUT(o) \
+    { \
+        if((o)->strut.top_start_x || (o)->strut.top_end_x || (o)->strut.top) \
+        { \
+            if((o)->strut.top) \
+                top = MAX(top, (o)->strut.top); \
+            else \
+                top = MAX(top, ((o)->geometry.y - area.y) + (o)->geometry.height); \
+        } \
+        if((o)->strut.bottom_start_x || (o)->strut.bottom_end_x || (o)->strut.bottom) \
+        { \
+            if((o)->strut.bottom) \
+                bottom = MAX(bottom, (o)->strut.bottom); \
+            else \
+                bottom = MAX(bottom, (area.y + area.height) - (o)->geometry.y); \
+        } \
+        if((o)->strut.left_start_y || (o)->strut.left_end_y || (o)->strut.left) \
+        { \
+            if((o)->strut.left) \
+                left = MAX(left, (o)->strut.left); \
+            else \
+                left = MAX(left, ((o)->geometry.x - area.x) + (o)->geometry.width); \
+        } \
+        if((o)->strut.right_start_y || (o)->strut.right_end_y || (o)->strut.right) \
+        { \
+            if((o)->strut.right) \
+                right = MAX(right, (o)->strut.right); \
+            else \
+                right = MAX(right, (area.x + area.width) - (o)->geometry.x); \
+        } \
+    }
+
+    foreach(c, strut_clients)
+        if((*c)->screen == screen && client_isvisible(*c))
+            COMPUTE_STRUT(*c)
+
+    foreach(drawin, globalconf.drawins)
+        if((*drawin)->visible)
+        {
+            screen_t *d_screen =
+                screen_getbycoord((*drawin)->geometry.x, (*drawin)->geometry.y);
+            if (d_screen == screen)
+                COMPUTE_STRUT(*drawin)
+        }
+
+#undef COMPUTE_STRUT
+
+    area.x += left;
+    area.y += top;
+    area.width -= MIN(area.width, left + right);
+    area.height -= MIN(area.height, top + bottom);
+
+    if (AREA_EQUAL(area, screen->workarea))
+        return;
+
+    area_t old_workarea = screen->workarea;
+    screen->workarea = area;
+    lua_State *L = globalconf_get_lua_State();
+    luaA_object_push(L, screen);
+    luaA_pusharea(L, old_workarea);
+    luaA_object_emit_signal(L, -2, "property::workarea", 1);
+    lua_pop(L, 1);
+}
+
+/** Recompute all outdated workareas. */
+static void
+screen_refresh_workareas(void)
+{
+    foreach(screen, globalconf.screens)
+        screen_refresh_workarea(*screen);
+}
+
+/** Is the workarea of a screen outdated? Struts changed by Lua code run
+ * during a refresh are only seen by the next one, which then has to come
+ * without waiting for an event.
+ * \return True if a workarea has to be recomputed.
+ */
+bool
+screen_need_workarea_refresh(void)
+{
+    foreach(screen, globalconf.screens)
+        if((*screen)->need_workarea_update)
+            return true;
+    return false;
+}
+
+/** Time in microseconds to wait after the last RandR event before the
+ * screens are scanned again. Plugging or unplugging monitors sends a burst
+ * of events, which then only causes one scan. */
+#define SCREEN_REFRESH_DEBOUNCE 50000
+
+/** When screen_schedule_refresh() was last called */
+static int64_t screen_refresh_requested;
+/** The timeout waking up the main loop once the debounce time is over */
+static guint screen_refresh_timeout_id;
+
+static gboolean
+screen_refresh_timeout(gpointer data)
+{
+    screen_refresh_timeout_id = 0;
+    return FALSE;
+}
+
+/** Scan the screens again in one of the next refreshes, once no RandR event
+ * arrived for a while.
+ */
+void
+screen_schedule_refresh(void)
+{
+    globalconf.screen_need_refresh = true;
+    screen_refresh_requested = g_get_monotonic_time();
+}
+
+/** Find a screen by its RandR id.
+ * \param screens The screens to look at.
+ * \param xid The id.
+ * \return The screen, or NULL.
+ */
+static screen_t *
+screen_getbyxid(screen_array_t *screens, uint32_t xid)
+{
+    foreach(screen, *screens)
+        if((*screen)->xid == xid)
+            return *screen;
+    return NULL;
+}
+
+static void
+screen_refresh_randr(void)
 {
     if(!globalconf.screen_need_refresh || !globalconf.have_randr_13)
         return;
+
+    int64_t wait = screen_refresh_requested + SCREEN_REFRESH_DEBOUNCE - g_get_monotonic_time();
+    if(wait > 0)
+    {
+        if(!screen_refresh_timeout_id)
+            screen_refresh_timeout_id = g_timeout_add(wait / 1000 + 1, screen_refresh_timeout, NULL);
+        return;
+    }
     globalconf.screen_need_refresh = false;
 
     screen_array_t new_screens;
@@ -673,6 +1033,10 @@ screen_refresh(void)
     lua_State *L = globalconf_get_lua_State();
     bool list_changed = false;
 
+    /* Its reply arrives while the screens are scanned */
+    xcb_randr_get_output_primary_cookie_t primary_c =
+        xcb_randr_get_output_primary(globalconf.connection, globalconf.screen->root);
+
     screen_array_init(&new_screens);
     if (globalconf.have_randr_15)
         screen_scan_randr_monitors(L, &new_screens);
@@ -687,11 +1051,9 @@ screen_refresh(void)
 
     /* Add new screens */
     foreach(new_screen, new_screens) {
-        bool found = false;
-        foreach(old_screen, globalconf.screens)
-            found |= (*new_screen)->xid == (*old_screen)->xid;
-        if(!found) {
+        if(!screen_getbyxid(&globalconf.screens, (*new_screen)->xid)) {
             screen_array_append(&globalconf.screens, *new_screen);
+            screen_index_invalidate();
             screen_added(L, *new_screen);
             /* Get an extra reference since both new_screens and
              * globalconf.screens reference this screen now */
@@ -706,11 +1068,10 @@ screen_refresh(void)
     screen_array_init(&removed_screens);
     for(int i = 0; i < globalconf.screens.len; i++) {
         screen_t *old_screen = globalconf.screens.tab[i];
-        bool found = old_screen->xid == FAKE_SCREEN_XID;
-        foreach(new_screen, new_screens)
-            found |= (*new_screen)->xid == old_screen->xid;
-        if(!found) {
+        if(old_screen->xid != FAKE_SCREEN_XID
+           && !screen_getbyxid(&new_screens, old_screen->xid)) {
             screen_array_take(&globalconf.screens, i);
+            screen_index_invalidate();
             i--;
 
             screen_array_append(&removed_screens, old_screen);
@@ -726,22 +1087,32 @@ screen_refresh(void)
     }
     screen_array_wipe(&removed_screens);
 
-    /* Update changed screens */
+    /* Update changed screens; screen_modified() only emits signals for what
+     * actually changed. Screens which were just added are already up to date. */
     foreach(existing_screen, globalconf.screens)
-        foreach(new_screen, new_screens)
-            if((*existing_screen)->xid == (*new_screen)->xid)
-                screen_modified(*existing_screen, *new_screen);
+    {
+        screen_t *new_screen = screen_getbyxid(&new_screens, (*existing_screen)->xid);
+        if(new_screen && new_screen != *existing_screen)
+            screen_modified(*existing_screen, new_screen);
+    }
 
     foreach(screen, new_screens)
         luaA_object_unref(L, *screen);
     screen_array_wipe(&new_screens);
 
-    screen_update_primary();
+    screen_update_primary_reply(primary_c);
 
     if (list_changed)
         luaA_class_emit_signal(L, &screen_class, "list", 0);
 }
 
+void
+screen_refresh(void)
+{
+    screen_refresh_randr();
+    screen_refresh_workareas();
+}
+
 /** Return the squared distance of the given screen to the coordinates.
  * \param screen The screen
  * \param x X coordinate
@@ -782,9 +1153,33 @@ screen_get_distance_squared(screen_t *s, int x, int y)
 screen_t *
 screen_getbycoord(int x, int y)
 {
-    foreach(s, globalconf.screens)
-        if(screen_coord_in_screen(*s, x, y))
-            return *s;
+    /* The pointer usually stays on the same screen */
+    if(screen_index.last_screen
+       && x >= screen_index.last_cell.x
+       && x < screen_index.last_cell.x + screen_index.last_cell.width
+       && y >= screen_index.last_cell.y
+       && y < screen_index.last_cell.y + screen_index.last_cell.height)
+        return screen_index.last_screen;
+
+    if(!screen_index.valid)
+        screen_index_rebuild();
+
+    int column = screen_index_find(screen_index.xs, screen_index.nx, x);
+    int row = screen_index_find(screen_index.ys, screen_index.ny, y);
+    if(column >= 0 && column < screen_index.nx - 1
+       && row >= 0 && row < screen_index.ny - 1)
+    {
+        screen_t *s = screen_index.cells[row * (screen_index.nx - 1) + column];
+        if(s)
+        {
+            screen_index.last_cell.x = screen_index.xs[column];
+            screen_index.last_cell.y = screen_index.ys[row];
+            screen_index.last_cell.width = screen_index.xs[column + 1] - screen_index.xs[column];
+            screen_index.last_cell.height = screen_index.ys[row + 1] - screen_index.ys[row];
+            screen_index.last_screen = s;
+            return s;
+        }
+    }
 
     /* No screen found, find nearest screen. */
     screen_t *nearest_screen = NULL;
@@ -828,75 +1223,6 @@ screen_area_in_screen(screen_t *s, area_t geom)
                && (geom.y + geom.height > s->geometry.y);
 }
 
-void screen_update_workarea(screen_t *screen)
-{
-    area_t area = screen->geometry;
-    uint16_t top = 0, bottom = 0, left = 0, right = 0;
-
-#define COMPUTE_STRUT(o) \
-    { \
-        if((o)->strut.top_start_x || (o)->strut.top_end_x || (o)->strut.top) \
-        { \
-            if((o)->strut.top) \
-                top = MAX(top, (o)->strut.top); \
-            else \
-                top = MAX(top, ((o)->geometry.y - area.y) + (o)->geometry.height); \
-        } \
-        if((o)->strut.bottom_start_x || (o)->strut.bottom_end_x || (o)->strut.bottom) \
-        { \
-            if((o)->strut.bottom) \
-                bottom = MAX(bottom, (o)->strut.bottom); \
-            else \
-                bottom = MAX(bottom, (area.y + area.height) - (o)->geometry.y); \
-        } \
-        if((o)->strut.left_start_y || (o)->strut.left_end_y || (o)->strut.left) \
-        { \
-            if((o)->strut.left) \
-                left = MAX(left, (o)->strut.left); \
-            else \
-                left = MAX(left, ((o)->geometry.x - area.x) + (o)->geometry.width); \
-        } \
-        if((o)->strut.right_start_y || (o)->strut.right_end_y || (o)->strut.right) \
-        { \
-            if((o)->strut.right) \
-                right = MAX(right, (o)->strut.right); \
-            else \
-                right = MAX(right, (area.x + area.width) - (o)->geometry.x); \
-        } \
-    }
-
-    foreach(c, globalconf.clients)
-        if((*c)->screen == screen && client_isvisible(*c))
-            COMPUTE_STRUT(*c)
-
-    foreach(drawin, globalconf.drawins)
-        if((*drawin)->visible)
-        {
-            screen_t *d_screen =
-                screen_getbycoord((*drawin)->geometry.x, (*drawin)->geometry.y);
-            if (d_screen == screen)
-                COMPUTE_STRUT(*drawin)
-        }
-
-#undef COMPUTE_STRUT
-
-    area.x += left;
-    area.y += top;
-    area.width -= MIN(area.width, left + right);
-    area.height -= MIN(area.height, top + bottom);
-
-    if (AREA_EQUAL(area, screen->workarea))
-        return;
-
-    area_t old_workarea = screen->workarea;
-    screen->workarea = area;
-    lua_State *L = globalconf_get_lua_State();
-    luaA_object_push(L, screen);
-    luaA_pusharea(L, old_workarea);
-    luaA_object_emit_signal(L, -2, "property::workarea", 1);
-    lua_pop(L, 1);
-}
-
 /** Move a client to a virtual screen.
  * \param c The client to move.
  * \param new_screen The destination screen.
@@ -919,6 +1245,12 @@ screen_client_moveto(client_t *c, screen_t *new_screen, bool doresize)
 
     c->screen = new_screen;
 
+    if(strut_has_value(&c->strut))
+    {
+        screen_update_workarea(old_screen);
+        screen_update_workarea(new_screen);
+    }
+
     if(!doresize)
     {
         luaA_object_push(L, c);
@@ -996,11 +1328,19 @@ screen_update_primary(void)
     if (!globalconf.have_randr_13)
         return;
 
+    screen_update_primary_reply(
+            xcb_randr_get_output_primary(globalconf.connection, globalconf.screen->root));
+}
+
+/** Update the primary screen from a GetOutputPrimary reply.
+ * \param cookie The request's cookie.
+ */
+static void
+screen_update_primary_reply(xcb_randr_get_output_primary_cookie_t cookie)
+{
     screen_t *primary_screen = NULL;
     xcb_randr_get_output_primary_reply_t *primary =
-        xcb_randr_get_output_primary_reply(globalconf.connection,
-                xcb_randr_get_output_primary(globalconf.connection, globalconf.screen->root),
-                NULL);
+        xcb_randr_get_output_primary_reply(globalconf.connection, cookie, NULL);
 
     if (!primary)
         return;
@@ -1130,6 +1470,7 @@ luaA_screen_get_outputs(lua_State *L, screen_t *s)
 static int
 luaA_screen_get_workarea(lua_State *L, screen_t *s)
 {
+    screen_refresh_workarea(s);
     luaA_pusharea(L, s->workarea);
     return 1;
 }
@@ -1180,6 +1521,7 @@ luaA_screen_fake_add(lua_State *L)
     s->geometry.width = width;
     s->geometry.height = height;
     s->xid = FAKE_SCREEN_XID;
+    screen_index_invalidate();
 
     screen_added(L, s);
     luaA_class_emit_signal(L, &screen_class, "list", 0);
@@ -1206,6 +1548,7 @@ luaA_screen_fake_remove(lua_State *L)
     }
 
     screen_array_take(&globalconf.screens, idx);
+    screen_index_invalidate();
     luaA_object_push(L, s);
     screen_removed(L, -1);
     lua_pop(L, 1);
@@ -1237,6 +1580,7 @@ luaA_screen_fake_resize(lua_State *L)
     screen->geometry.y = y;
     screen->geometry.width = width;
     screen->geometry.height = height;
+    screen_index_invalidate();
 
     screen_update_workarea(screen);
 
@@ -1274,6 +1618,7 @@ luaA_screen_swap(lua_State *L)
         /* swap ! */
         *ref_s = swap;
         *ref_swap = s;
+        screen_index_invalidate();
 
         luaA_class_emit_signal(L, &screen_class, "list", 0);
 
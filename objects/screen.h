@@ -43,6 +43,8 @@ struct a_screen
     screen_output_array_t outputs;
     /** Some XID identifying this screen */
     uint32_t xid;
+    /** Does the workarea need to be recomputed? */
+    bool need_workarea_update;
 };
 ARRAY_FUNCS(screen_t *, screen, DO_NOTHING)
 
@@ -54,7 +56,11 @@ bool screen_area_in_screen(screen_t *, area_t);
 int screen_get_index(screen_t *);
 void screen_client_moveto(client_t *, screen_t *, bool);
 void screen_update_primary(void);
+void screen_schedule_refresh(void);
 void screen_update_workarea(screen_t *);
+bool screen_need_workarea_refresh(void);
+void screen_strut_client_changed(client_t *);
+void screen_strut_client_remove(client_t *);
 screen_t *screen_get_primary(void);
 
 screen_t *luaA_checkscreen(lua_State *, int);
@@ -261,11 +261,28 @@ tag_unref_simplified(tag_t **tag)
     luaA_object_unref(L, *tag);
 }
 
+/** Indexes used by the existing tags */
+static bitset_t tag_indexes;
+
+static tag_t *
+tag_allocator(lua_State *L)
+{
+    tag_t *tag = tag_new(L);
+    tag->index = bitset_first_unset(&tag_indexes);
+    bitset_set(&tag_indexes, tag->index);
+    return tag;
+}
+
 static void
 tag_wipe(tag_t *tag)
 {
     client_array_wipe(&tag->clients);
     p_delete(&tag->name);
+    /* The index is handed out again, no client may still have it */
+    foreach(c, globalconf.clients)
+        bitset_unset(&(*c)->tags, tag->index);
+    bitset_unset(&globalconf.selected_tags, tag->index);
+    bitset_unset(&tag_indexes, tag->index);
 }
 
 OBJECT_EXPORT_PROPERTY(tag, tag_t, selected)
@@ -283,7 +300,14 @@ tag_view(lua_State *L, int udx, bool view)
     if(tag->selected != view)
     {
         tag->selected = view;
-        banning_need_update();
+        if(tag->activated)
+        {
+            if(view)
+                bitset_set(&globalconf.selected_tags, tag->index);
+            else
+                bitset_unset(&globalconf.selected_tags, tag->index);
+        }
+        banning_tag_need_update(tag);
         foreach(screen, globalconf.screens)
             screen_update_workarea(*screen);
 
@@ -325,8 +349,9 @@ tag_client(lua_State *L, client_t *c)
     }
 
     client_array_append(&t->clients, c);
+    bitset_set(&c->tags, t->index);
     ewmh_client_update_desktop(c);
-    banning_need_update();
+    banning_client_need_update(c);
     screen_update_workarea(c->screen);
 
     tag_client_emit_signal(t, c, "tagged");
@@ -339,12 +364,16 @@ tag_client(lua_State *L, client_t *c)
 void
 untag_client(client_t *c, tag_t *t)
 {
+    if(!is_client_tagged(c, t))
+        return;
+
     for(int i = 0; i < t->clients.len; i++)
         if(t->clients.tab[i] == c)
         {
             lua_State *L = globalconf_get_lua_State();
             client_array_take(&t->clients, i);
-            banning_need_update();
+            bitset_unset(&c->tags, t->index);
+            banning_client_need_update(c);
             ewmh_client_update_desktop(c);
             screen_update_workarea(c->screen);
             tag_client_emit_signal(t, c, "untagged");
@@ -361,11 +390,7 @@ untag_client(client_t *c, tag_t *t)
 bool
 is_client_tagged(client_t *c, tag_t *t)
 {
-    for(int i = 0; i < t->clients.len; i++)
-        if(t->clients.tab[i] == c)
-            return true;
-
-    return false;
+    return bitset_test(&c->tags, t->index);
 }
 
 /** Get the index of the tag with focused client or first selected
@@ -423,27 +448,30 @@ luaA_tag_clients(lua_State *L)
     if(lua_gettop(L) == 2)
     {
         luaA_checktable(L, 2);
-        foreach(c, tag->clients)
+
+        /* Build a set of the wanted clients */
+        lua_newtable(L);
+        lua_pushnil(L);
+        while(lua_next(L, 2))
         {
-            /* Only untag if we aren't going to add this tag again */
-            bool found = false;
-            lua_pushnil(L);
-            while(lua_next(L, 2))
-            {
-                client_t *tc = luaA_checkudata(L, -1, &client_class);
-                /* Pop the value from lua_next */
-                lua_pop(L, 1);
-                if (tc != *c)
-                    continue;
-
-                /* Pop the key from lua_next */
-                lua_pop(L, 1);
-                found = true;
-                break;
-            }
+            luaA_checkudata(L, -1, &client_class);
+            lua_pushboolean(L, true);
+            lua_rawset(L, 3);
+        }
+
+        /* Only untag if we aren't going to add this tag again. Untagging
+         * removes the client from the array, so walk it backwards. */
+        foreach_reverse(c, tag->clients)
+        {
+            luaA_object_push(L, *c);
+            lua_rawget(L, 3);
+            bool found = lua_toboolean(L, -1);
+            lua_pop(L, 1);
             if(!found)
                 untag_client(*c, tag);
         }
+        lua_pop(L, 1);
+
         lua_pushnil(L);
         while(lua_next(L, 2))
         {
@@ -514,6 +542,11 @@ luaA_tag_set_activated(lua_State *L, tag_t *tag)
     {
         lua_pushvalue(L, -3);
         tag_array_append(&globalconf.tags, luaA_object_ref_class(L, -1, &tag_class));
+        if(tag->selected)
+        {
+            bitset_set(&globalconf.selected_tags, tag->index);
+            banning_tag_need_update(tag);
+        }
     }
     else
     {
@@ -527,8 +560,9 @@ luaA_tag_set_activated(lua_State *L, tag_t *tag)
         if (tag->selected)
         {
             tag->selected = false;
+            bitset_unset(&globalconf.selected_tags, tag->index);
             luaA_object_emit_signal(L, -3, "property::selected", 0);
-            banning_need_update();
+            banning_tag_need_update(tag);
         }
         luaA_object_unref(L, tag);
     }
@@ -559,7 +593,7 @@ tag_class_setup(lua_State *L)
     };
 
     luaA_class_setup(L, &tag_class, "tag", NULL,
-                     (lua_class_allocator_t) tag_new,
+                     (lua_class_allocator_t) tag_allocator,
                      (lua_class_collector_t) tag_wipe,
                      NULL,
                      luaA_class_index_miss_property, luaA_class_newindex_miss_property,
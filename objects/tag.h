@@ -44,6 +44,8 @@ struct tag
     bool selected;
     /** clients in this tag */
     client_array_t clients;
+    /** Index of this tag in the tag bit sets, stable for its lifetime */
+    int index;
 };
 
 lua_class_t tag_class;
@@ -52,6 +52,7 @@
  */
 
 #include "objects/window.h"
+#include "objects/client.h"
 #include "common/atoms.h"
 #include "common/xutil.h"
 #include "ewmh.h"
@@ -72,7 +73,7 @@ window_get(window_t *window)
 static void
 window_wipe(window_t *window)
 {
-    button_array_wipe(&window->buttons);
+    button_set_unref(globalconf_get_lua_State(), 0, &window->buttons);
 }
 
 /** Get or set mouse buttons bindings on a window.
@@ -86,12 +87,14 @@ luaA_window_buttons(lua_State *L)
 
     if(lua_gettop(L) == 2)
     {
-        luaA_button_array_set(L, 1, 2, &window->buttons);
+        button_set_t *buttons = luaA_button_set_get(L, 1, 2);
+        button_set_unref(L, 1, &window->buttons);
+        window->buttons = buttons;
         luaA_object_emit_signal(L, 1, "property::buttons", 0);
-        xwindow_buttons_grab(window->window, &window->buttons);
+        xwindow_buttons_grab(window->window, button_set_items(window->buttons));
     }
 
-    return luaA_button_array_get(L, 1, &window->buttons);
+    return luaA_button_set_push(L, 1, window->buttons);
 }
 
 /** Return window struts (reserved space at the edge of the screen).
@@ -108,9 +111,13 @@ luaA_window_struts(lua_State *L)
         luaA_tostrut(L, 2, &window->strut);
         ewmh_update_strut(window->window, &window->strut);
         luaA_object_emit_signal(L, 1, "property::struts", 0);
-        /* We don't know the correct screen, update them all */
-        foreach(s, globalconf.screens)
-            screen_update_workarea(*s);
+        client_t *c = luaA_toudata(L, 1, &client_class);
+        if(c)
+            screen_strut_client_changed(c);
+        else
+            /* We don't know the correct screen, update them all */
+            foreach(s, globalconf.screens)
+                screen_update_workarea(*s);
     }
 
     return luaA_pushstrut(L, window->strut);
@@ -129,7 +136,7 @@ window_set_opacity(lua_State *L, int idx, double opacity)
     if(window->opacity != opacity)
     {
         window->opacity = opacity;
-        xwindow_set_opacity(window_get(window), opacity);
+        window->dirty |= WINDOW_DIRTY_OPACITY;
         luaA_object_emit_signal(L, idx, "property::opacity", 0);
     }
 }
@@ -169,17 +176,26 @@ luaA_window_get_opacity(lua_State *L, window_t *window)
     return 1;
 }
 
+/** Send the pending changes of a window to the X server.
+ * Callers which configure the window anyway should include its border width
+ * and clear WINDOW_DIRTY_BORDER_WIDTH first, so that no separate request is
+ * needed for it.
+ * \param window The window object.
+ */
 void
 window_border_refresh(window_t *window)
 {
-    if(!window->border_need_update)
+    if(!window->dirty)
         return;
-    window->border_need_update = false;
-    xwindow_set_border_color(window_get(window), &window->border_color);
-    if(window->window)
+    if(window->dirty & WINDOW_DIRTY_BORDER_COLOR)
+        xwindow_set_border_color(window_get(window), &window->border_color);
+    if((window->dirty & WINDOW_DIRTY_BORDER_WIDTH) && window->window)
         xcb_configure_window(globalconf.connection, window_get(window),
                              XCB_CONFIG_WINDOW_BORDER_WIDTH,
                              (uint32_t[]) { window->border_width });
+    if(window->dirty & WINDOW_DIRTY_OPACITY)
+        xwindow_set_opacity(window_get(window), window->opacity);
+    window->dirty = 0;
 }
 
 /** Set the window border color.
@@ -196,7 +212,7 @@ luaA_window_set_border_color(lua_State *L, window_t *window)
     if(color_name &&
        color_init_reply(color_init_unchecked(&window->border_color, color_name, len, globalconf.visual)))
     {
-        window->border_need_update = true;
+        window->dirty |= WINDOW_DIRTY_BORDER_COLOR;
         luaA_object_emit_signal(L, -3, "property::border_color", 0);
     }
 
@@ -217,7 +233,7 @@ window_set_border_width(lua_State *L, int idx, int width)
     if(width == window->border_width || width < 0)
         return;
 
-    window->border_need_update = true;
+    window->dirty |= WINDOW_DIRTY_BORDER_WIDTH;
     window->border_width = width;
 
     if(window->border_width_callback)
@@ -61,10 +61,10 @@ typedef enum
     double opacity; \
     /** Strut */ \
     strut_t strut; \
-    /** Button bindings */ \
-    button_array_t buttons; \
-    /** Do we have pending border changes? */ \
-    bool border_need_update; \
+    /** Button bindings, shared with other windows using the same buttons */ \
+    button_set_t *buttons; \
+    /** Pending changes, a combination of window_dirty_t */ \
+    uint8_t dirty; \
     /** Border color */ \
     color_t border_color; \
     /** Border width */ \
@@ -80,6 +80,14 @@ typedef struct
     WINDOW_OBJECT_HEADER
 } window_t;
 
+/** Changes of a window which are sent to the X server on the next refresh */
+typedef enum
+{
+    WINDOW_DIRTY_BORDER_COLOR = 1 << 0,
+    WINDOW_DIRTY_BORDER_WIDTH = 1 << 1,
+    WINDOW_DIRTY_OPACITY = 1 << 2,
+} window_dirty_t;
+
 lua_class_t window_class;
 
 void window_class_setup(lua_State *);
@@ -0,0 +1,494 @@
+/*
+ * profile.c - main loop refresh profiling
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/**
+ * @module awesome
+ */
+
+#include "profile.h"
+#include "globalconf.h"
+#include "objects/client.h"
+#include "objects/drawable.h"
+#include "spawn.h"
+#include "common/lualib.h"
+
+#include <stdint.h>
+#include <time.h>
+
+/** Number of refresh cycles kept in the history ring buffer */
+#define PROFILE_HISTORY_SIZE 256
+/** Number of log2(microseconds) buckets in the exit histogram */
+#define PROFILE_HISTOGRAM_BUCKETS 24
+
+typedef struct
+{
+    /** Time spent in the stage */
+    uint64_t time_ns;
+    /** X11 requests sent by the stage (only with --profile) */
+    uint32_t requests;
+    /** Lua functions called by the stage */
+    uint32_t lua_calls;
+    /** Memory allocations done by the stage */
+    uint32_t allocations;
+} profile_sample_t;
+
+static const char * const profile_stage_names[PROFILE_STAGE_COUNT] =
+{
+    [PROFILE_STAGE_XKB] = "xkb",
+    [PROFILE_STAGE_SCREEN] = "screen",
+    [PROFILE_STAGE_LUA_REFRESH] = "lua_refresh",
+    [PROFILE_STAGE_DRAWIN] = "drawin",
+    [PROFILE_STAGE_CLIENT] = "client",
+    [PROFILE_STAGE_DRAWABLE] = "drawable",
+    [PROFILE_STAGE_BANNING] = "banning",
+    [PROFILE_STAGE_STACK] = "stack",
+    [PROFILE_STAGE_DESTROY_LATER] = "destroy_later",
+    [PROFILE_STAGE_LUA_REFRESHED] = "lua_refreshed",
+};
+
+static struct
+{
+    /** Was --profile given? */
+    bool enabled;
+    /** awesome_refresh() nesting depth; only the outermost call is recorded */
+    int depth;
+    /** Start of the currently running stage */
+    uint64_t stage_start;
+    /** Sequence number of the request preceding the current stage */
+    unsigned int stage_sequence;
+    /** lualib_dofunction_count at the start of the current stage */
+    unsigned int stage_lua_calls;
+    /** a_alloc_count at the start of the current stage */
+    unsigned long stage_allocations;
+    /** The last refresh cycles */
+    profile_sample_t history[PROFILE_HISTORY_SIZE][PROFILE_STAGE_COUNT];
+    /** Number of recorded refresh cycles */
+    unsigned long cycles;
+    /** Lifetime totals per stage */
+    uint64_t total_ns[PROFILE_STAGE_COUNT];
+    uint64_t max_ns[PROFILE_STAGE_COUNT];
+    unsigned long total_requests[PROFILE_STAGE_COUNT];
+    unsigned long total_lua_calls[PROFILE_STAGE_COUNT];
+    unsigned long total_allocations[PROFILE_STAGE_COUNT];
+    unsigned long histogram[PROFILE_STAGE_COUNT][PROFILE_HISTOGRAM_BUCKETS];
+    /** When profile_init() was called */
+    uint64_t init_time;
+    /** Start of the startup scan */
+    uint64_t scan_start;
+    /** Time spent managing the existing windows at startup */
+    uint64_t scan_ns;
+    /** Time from profile_init() to the end of the startup scan */
+    uint64_t startup_ns;
+    /** Number of windows managed by the startup scan */
+    unsigned int scan_windows;
+} profile;
+
+static uint64_t
+profile_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/** Get the sequence number of the last request sent.
+ * This is done by sending a NoOperation request, since XCB does not export
+ * its request counter.
+ */
+static unsigned int
+profile_sequence(void)
+{
+    return xcb_no_operation(globalconf.connection).sequence;
+}
+
+static int
+profile_histogram_bucket(uint64_t time_ns)
+{
+    uint64_t us = time_ns / 1000;
+    int bucket = 0;
+
+    while(us && bucket < PROFILE_HISTOGRAM_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/** Initialize the profiler.
+ * \param enabled Was --profile given? This enables counting X11 requests per
+ * stage and dumping a histogram on exit.
+ */
+void
+profile_init(bool enabled)
+{
+    p_clear(&profile, 1);
+    profile.enabled = enabled;
+    xtrace_enabled = enabled;
+    profile.init_time = profile_now();
+}
+
+/** Start a new refresh cycle. */
+void
+profile_cycle_begin(void)
+{
+    if(profile.depth++)
+        return;
+
+    profile.stage_lua_calls = lualib_dofunction_count;
+    profile.stage_allocations = a_alloc_count;
+    if(profile.enabled)
+        profile.stage_sequence = profile_sequence();
+    profile.stage_start = profile_now();
+}
+
+/** Account for a stage of the refresh cycle that just finished.
+ * \param stage The stage.
+ */
+void
+profile_stage_end(profile_stage_t stage)
+{
+    if(profile.depth != 1)
+        return;
+
+    uint64_t now = profile_now();
+    profile_sample_t *sample =
+        &profile.history[profile.cycles % PROFILE_HISTORY_SIZE][stage];
+
+    sample->time_ns = now - profile.stage_start;
+    sample->lua_calls = lualib_dofunction_count - profile.stage_lua_calls;
+    profile.stage_lua_calls = lualib_dofunction_count;
+    sample->allocations = a_alloc_count - profile.stage_allocations;
+    profile.stage_allocations = a_alloc_count;
+    if(profile.enabled)
+    {
+        unsigned int sequence = profile_sequence();
+        /* Don't count our own NoOperation request */
+        sample->requests = sequence - profile.stage_sequence - 1;
+        profile.stage_sequence = sequence;
+    }
+
+    profile.total_ns[stage] += sample->time_ns;
+    profile.max_ns[stage] = MAX(profile.max_ns[stage], sample->time_ns);
+    profile.total_requests[stage] += sample->requests;
+    profile.total_lua_calls[stage] += sample->lua_calls;
+    profile.total_allocations[stage] += sample->allocations;
+    profile.histogram[stage][profile_histogram_bucket(sample->time_ns)]++;
+
+    profile.stage_start = profile_now();
+}
+
+/** Finish the current refresh cycle. */
+void
+profile_cycle_end(void)
+{
+    if(--profile.depth)
+        return;
+
+    profile.cycles++;
+}
+
+/** Start timing the management of the existing windows at startup. */
+void
+profile_scan_begin(void)
+{
+    profile.scan_start = profile_now();
+}
+
+/** Finish timing the startup scan.
+ * \param windows The number of windows which were managed.
+ */
+void
+profile_scan_end(unsigned int windows)
+{
+    uint64_t now = profile_now();
+
+    profile.scan_ns = now - profile.scan_start;
+    profile.startup_ns = now - profile.init_time;
+    profile.scan_windows = windows;
+}
+
+/** Print the per-stage histogram to stderr if --profile was given. */
+void
+profile_dump(void)
+{
+    if(!profile.enabled)
+        return;
+
+    xtrace_dump(stderr);
+
+    fprintf(stderr, "Startup took %.3f ms, managing %u windows took %.3f ms\n",
+            profile.startup_ns / 1e6, profile.scan_windows, profile.scan_ns / 1e6);
+
+    if(!profile.cycles)
+        return;
+
+    fprintf(stderr, "Refresh profile over %lu cycles:\n", profile.cycles);
+    for(int stage = 0; stage < PROFILE_STAGE_COUNT; stage++)
+    {
+        fprintf(stderr, "  %-14s mean %10.3f us, max %10.3f us, %lu requests, %lu Lua calls, %lu allocations\n",
+                profile_stage_names[stage],
+                profile.total_ns[stage] / 1e3 / profile.cycles,
+                profile.max_ns[stage] / 1e3,
+                profile.total_requests[stage],
+                profile.total_lua_calls[stage],
+                profile.total_allocations[stage]);
+        for(int bucket = 0; bucket < PROFILE_HISTOGRAM_BUCKETS; bucket++)
+        {
+            if(!profile.histogram[stage][bucket])
+                continue;
+            fprintf(stderr, "    < %8lu us: %lu\n", 1UL << bucket,
+                    profile.histogram[stage][bucket]);
+        }
+    }
+}
+
+/** Get timing statistics about the main loop refresh stages.
+ *
+ * The returned table has a `cycles` entry with the number of recorded
+ * refresh cycles and contains an entry per stage (`xkb`, `screen`,
+ * `lua_refresh`, `drawin`, `client`, `drawable`, `banning`, `stack`,
+ * `destroy_later` and `lua_refreshed`).
+ * Each stage is described by a table with the fields `total` and `max`
+ * (times in seconds), `lua_calls`, `allocations` (memory allocations by
+ * awesome and Lua), `requests` (only available when awesome was started with
+ * `--profile`) and `history`, an array of the last cycles (oldest first) with
+ * the fields `time`, `lua_calls`, `allocations` and `requests`.
+ *
+ * The `startup` entry has the fields `total` (the time from the start of
+ * awesome until all existing windows were managed), `scan` (the time spent
+ * managing the existing windows) and `windows` (their number).
+ *
+ * The `pixmap_pool` entry describes the pool of pixmaps reused when drawables
+ * are resized: `hits` and `misses` count the pixmaps taken from the pool and
+ * the newly created ones, `pixmaps` and `pixels` describe the current pool
+ * content.
+ *
+ * The `arena` entry describes the memory for temporary data which is released
+ * after every refresh: `allocations` counts the allocations from it, `peak`
+ * is the most bytes used in one main loop iteration and `chunks` the
+ * number of memory blocks it currently holds.
+ *
+ * The `spawn` entry counts the `spawned` and `reaped` processes and the ones
+ * still `running` with an exit callback. `reap_latency_mean` and
+ * `reap_latency_max` are the times in seconds from SIGCHLD to the exit
+ * callbacks.
+ *
+ * @function profile_stats
+ * @treturn table The statistics.
+ */
+int
+luaA_profile_stats(lua_State *L)
+{
+    unsigned long history_len = MIN(profile.cycles, PROFILE_HISTORY_SIZE);
+
+    lua_createtable(L, 0, PROFILE_STAGE_COUNT + 5);
+    lua_pushinteger(L, profile.cycles);
+    lua_setfield(L, -2, "cycles");
+
+    lua_createtable(L, 0, 3);
+    lua_pushnumber(L, profile.startup_ns / 1e9);
+    lua_setfield(L, -2, "total");
+    lua_pushnumber(L, profile.scan_ns / 1e9);
+    lua_setfield(L, -2, "scan");
+    lua_pushinteger(L, profile.scan_windows);
+    lua_setfield(L, -2, "windows");
+    lua_setfield(L, -2, "startup");
+
+    luaA_drawable_pool_stats(L);
+    lua_setfield(L, -2, "pixmap_pool");
+
+    luaA_spawn_stats(L);
+    lua_setfield(L, -2, "spawn");
+
+    int chunks = 0;
+    for(arena_chunk_t *chunk = globalconf.arena.chunks; chunk; chunk = chunk->next)
+        chunks++;
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, globalconf.arena.allocations);
+    lua_setfield(L, -2, "allocations");
+    lua_pushinteger(L, MAX(globalconf.arena.peak, globalconf.arena.used));
+    lua_setfield(L, -2, "peak");
+    lua_pushinteger(L, chunks);
+    lua_setfield(L, -2, "chunks");
+    lua_setfield(L, -2, "arena");
+
+    for(int stage = 0; stage < PROFILE_STAGE_COUNT; stage++)
+    {
+        lua_createtable(L, 0, 6);
+
+        lua_pushnumber(L, profile.total_ns[stage] / 1e9);
+        lua_setfield(L, -2, "total");
+        lua_pushnumber(L, profile.max_ns[stage] / 1e9);
+        lua_setfield(L, -2, "max");
+        lua_pushinteger(L, profile.total_lua_calls[stage]);
+        lua_setfield(L, -2, "lua_calls");
+        lua_pushinteger(L, profile.total_allocations[stage]);
+        lua_setfield(L, -2, "allocations");
+        if(profile.enabled)
+        {
+            lua_pushinteger(L, profile.total_requests[stage]);
+            lua_setfield(L, -2, "requests");
+        }
+
+        lua_createtable(L, history_len, 0);
+        for(unsigned long i = 0; i < history_len; i++)
+        {
+            unsigned long cycle = profile.cycles - history_len + i;
+            profile_sample_t *sample =
+                &profile.history[cycle % PROFILE_HISTORY_SIZE][stage];
+
+            lua_createtable(L, 0, 4);
+            lua_pushnumber(L, sample->time_ns / 1e9);
+            lua_setfield(L, -2, "time");
+            lua_pushinteger(L, sample->lua_calls);
+            lua_setfield(L, -2, "lua_calls");
+            lua_pushinteger(L, sample->allocations);
+            lua_setfield(L, -2, "allocations");
+            if(profile.enabled)
+            {
+                lua_pushinteger(L, sample->requests);
+                lua_setfield(L, -2, "requests");
+            }
+            lua_rawseti(L, -2, i + 1);
+        }
+        lua_setfield(L, -2, "history");
+
+        lua_setfield(L, -2, profile_stage_names[stage]);
+    }
+
+    return 1;
+}
+
+/** Get statistics about the memory used by awesome.
+ *
+ * The result has the following entries, sizes are in bytes:
+ *
+ * * `lua`: The size of the Lua heap.
+ * * `classes`: For each object class, the number of live `instances` and of
+ *   the `signal_handlers` connected to them.
+ * * `icons`: The memory held by the icons of all clients.
+ * * `drawables`: The number of `pixmaps` used by drawables, their size in
+ *   `bytes` and the size of the unused pixmaps kept for reuse as `pool_bytes`.
+ *   Drawables using the image backend also use `image_bytes` of client
+ *   memory.
+ * * `wallpaper`: The size of the cached wallpaper.
+ *
+ * Pixmaps and the wallpaper live in the X server and are counted with four
+ * bytes per pixel.
+ *
+ * @function memory_stats
+ * @treturn table The statistics.
+ */
+int
+luaA_memory_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 5);
+
+    lua_pushinteger(L, (lua_Integer) lua_gc(L, LUA_GCCOUNT, 0) * 1024
+                    + lua_gc(L, LUA_GCCOUNTB, 0));
+    lua_setfield(L, -2, "lua");
+
+    luaA_class_stats(L);
+    lua_setfield(L, -2, "classes");
+
+    lua_pushinteger(L, client_icons_bytes());
+    lua_setfield(L, -2, "icons");
+
+    luaA_drawable_memory_stats(L);
+    lua_setfield(L, -2, "drawables");
+
+    lua_pushinteger(L, globalconf.wallpaper
+                    ? (lua_Integer) globalconf.wallpaper_width * globalconf.wallpaper_height * 4
+                    : 0);
+    lua_setfield(L, -2, "wallpaper");
+
+    return 1;
+}
+
+/** Get statistics about the X replies awesome waited for.
+ *
+ * Tracing has to be enabled with `awesome.set_xcb_tracing` or by starting
+ * awesome with `--profile`. A reply is `blocking` when it was not received
+ * yet when awesome asked for it, so that it had to wait for a round trip to
+ * the X server.
+ *
+ * The result has the totals `replies`, `blocking` and `wait` (in seconds)
+ * and `sites`, an array with an entry per place in the code with the fields
+ * `request` (e.g. `"GetProperty"`), `location` (`"file:line"`), `replies`,
+ * `blocking` and `wait`.
+ *
+ * Sending `SIGUSR2` to awesome prints the same statistics to stderr.
+ *
+ * @tparam[opt=false] boolean reset Reset the statistics after getting them.
+ * @function xcb_stats
+ * @treturn table The statistics.
+ */
+int
+luaA_xcb_stats(lua_State *L)
+{
+    bool reset = lua_toboolean(L, 1);
+    unsigned long replies = 0, blocking = 0;
+    uint64_t wait_ns = 0;
+    int i = 0;
+
+    lua_createtable(L, 0, 5);
+    lua_pushboolean(L, xtrace_enabled);
+    lua_setfield(L, -2, "enabled");
+
+    lua_newtable(L);
+    for(xtrace_site_t *site = xtrace_sites; site; site = site->next)
+    {
+        if(!site->replies)
+            continue;
+        lua_createtable(L, 0, 5);
+        lua_pushstring(L, site->request);
+        lua_setfield(L, -2, "request");
+        lua_pushfstring(L, "%s:%d", site->file, site->line);
+        lua_setfield(L, -2, "location");
+        lua_pushinteger(L, site->replies);
+        lua_setfield(L, -2, "replies");
+        lua_pushinteger(L, site->blocking);
+        lua_setfield(L, -2, "blocking");
+        lua_pushnumber(L, site->wait_ns / 1e9);
+        lua_setfield(L, -2, "wait");
+        lua_rawseti(L, -2, ++i);
+
+        replies += site->replies;
+        blocking += site->blocking;
+        wait_ns += site->wait_ns;
+    }
+    lua_setfield(L, -2, "sites");
+
+    lua_pushinteger(L, replies);
+    lua_setfield(L, -2, "replies");
+    lua_pushinteger(L, blocking);
+    lua_setfield(L, -2, "blocking");
+    lua_pushnumber(L, wait_ns / 1e9);
+    lua_setfield(L, -2, "wait");
+
+    if(reset)
+        xtrace_reset();
+
+    return 1;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
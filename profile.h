@@ -0,0 +1,66 @@
+/*
+ * profile.h - main loop refresh profiling header
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_PROFILE_H
+#define AWESOME_PROFILE_H
+
+#include <stdbool.h>
+#include <lua.h>
+
+/** The stages of awesome_refresh(), in execution order */
+typedef enum
+{
+    PROFILE_STAGE_XKB,
+    PROFILE_STAGE_SCREEN,
+    PROFILE_STAGE_LUA_REFRESH,
+    PROFILE_STAGE_DRAWIN,
+    PROFILE_STAGE_CLIENT,
+    PROFILE_STAGE_DRAWABLE,
+    PROFILE_STAGE_BANNING,
+    PROFILE_STAGE_STACK,
+    PROFILE_STAGE_DESTROY_LATER,
+    PROFILE_STAGE_LUA_REFRESHED,
+    PROFILE_STAGE_COUNT
+} profile_stage_t;
+
+void profile_init(bool);
+void profile_cycle_begin(void);
+void profile_stage_end(profile_stage_t);
+void profile_cycle_end(void);
+void profile_scan_begin(void);
+void profile_scan_end(unsigned int);
+void profile_dump(void);
+
+int luaA_profile_stats(lua_State *);
+int luaA_memory_stats(lua_State *);
+int luaA_xcb_stats(lua_State *);
+
+/** Run one stage of the refresh pipeline and account for it.
+ * Stages must be run in the order of profile_stage_t.
+ */
+#define PROFILE_STAGE(stage, call) \
+    do { \
+        call; \
+        profile_stage_end(stage); \
+    } while(0)
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
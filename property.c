@@ -21,6 +21,7 @@
 
 #include "property.h"
 #include "common/atoms.h"
+#include "common/hash.h"
 #include "common/xutil.h"
 #include "ewmh.h"
 #include "objects/client.h"
@@ -31,11 +32,11 @@
 
 #define HANDLE_TEXT_PROPERTY(funcname, atom, setfunc) \
     xcb_get_property_cookie_t \
-    property_get_##funcname(client_t *c) \
+    property_get_##funcname(xcb_window_t window) \
     { \
         return xcb_get_property(globalconf.connection, \
                                 false, \
-                                c->window, \
+                                window, \
                                 atom, \
                                 XCB_GET_PROPERTY_TYPE_ANY, \
                                 0, \
@@ -52,14 +53,11 @@
         lua_pop(L, 1); \
         p_delete(&reply); \
     } \
-    static int \
-    property_handle_##funcname(uint8_t state, \
-                               xcb_window_t window) \
+    static void \
+    property_handle_##funcname(xcb_property_notify_event_t *ev, client_t *c) \
     { \
-        client_t *c = client_getbywin(window); \
         if(c) \
-            property_update_##funcname(c, property_get_##funcname(c));\
-        return 0; \
+            property_update_##funcname(c, property_get_##funcname(c->window));\
     }
 
 
@@ -73,14 +71,11 @@ HANDLE_TEXT_PROPERTY(wm_window_role, WM_WINDOW_ROLE, client_set_role)
 #undef HANDLE_TEXT_PROPERTY
 
 #define HANDLE_PROPERTY(name) \
-    static int \
-    property_handle_##name(uint8_t state, \
-                           xcb_window_t window) \
+    static void \
+    property_handle_##name(xcb_property_notify_event_t *ev, client_t *c) \
     { \
-        client_t *c = client_getbywin(window); \
         if(c) \
-            property_update_##name(c, property_get_##name(c));\
-        return 0; \
+            property_update_##name(c, property_get_##name(c->window));\
     }
 
 HANDLE_PROPERTY(wm_protocols)
@@ -96,9 +91,9 @@ HANDLE_PROPERTY(motif_wm_hints)
 #undef HANDLE_PROPERTY
 
 xcb_get_property_cookie_t
-property_get_wm_transient_for(client_t *c)
+property_get_wm_transient_for(xcb_window_t window)
 {
-    return xcb_icccm_get_wm_transient_for_unchecked(globalconf.connection, c->window);
+    return xcb_icccm_get_wm_transient_for_unchecked(globalconf.connection, window);
 }
 
 void
@@ -128,9 +123,9 @@ property_update_wm_transient_for(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_wm_client_leader(client_t *c)
+property_get_wm_client_leader(xcb_window_t window)
 {
-    return xcb_get_property_unchecked(globalconf.connection, false, c->window,
+    return xcb_get_property_unchecked(globalconf.connection, false, window,
                                       WM_CLIENT_LEADER, XCB_ATOM_WINDOW, 0, 32);
 }
 
@@ -153,9 +148,9 @@ property_update_wm_client_leader(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_wm_normal_hints(client_t *c)
+property_get_wm_normal_hints(xcb_window_t window)
 {
-    return xcb_icccm_get_wm_normal_hints_unchecked(globalconf.connection, c->window);
+    return xcb_icccm_get_wm_normal_hints_unchecked(globalconf.connection, window);
 }
 
 /** Update the size hints of a client.
@@ -170,6 +165,7 @@ property_update_wm_normal_hints(client_t *c, xcb_get_property_cookie_t cookie)
     xcb_icccm_get_wm_normal_hints_reply(globalconf.connection,
 					cookie,
 					&c->size_hints, NULL);
+    c->layout_geometry_valid = false;
 
     luaA_object_push(L, c);
     luaA_object_emit_signal(L, -1, "property::size_hints", 0);
@@ -177,9 +173,9 @@ property_update_wm_normal_hints(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_wm_hints(client_t *c)
+property_get_wm_hints(xcb_window_t window)
 {
-    return xcb_icccm_get_wm_hints_unchecked(globalconf.connection, c->window);
+    return xcb_icccm_get_wm_hints_unchecked(globalconf.connection, window);
 }
 
 /** Update the WM hints of a client.
@@ -223,9 +219,9 @@ property_update_wm_hints(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_wm_class(client_t *c)
+property_get_wm_class(xcb_window_t window)
 {
-    return xcb_icccm_get_wm_class_unchecked(globalconf.connection, c->window);
+    return xcb_icccm_get_wm_class_unchecked(globalconf.connection, window);
 }
 
 /** Update WM_CLASS of a client.
@@ -250,41 +246,47 @@ property_update_wm_class(client_t *c, xcb_get_property_cookie_t cookie)
     xcb_icccm_get_wm_class_reply_wipe(&hint);
 }
 
-static int
-property_handle_net_wm_strut_partial(uint8_t state,
-                                     xcb_window_t window)
+static void
+property_handle_net_wm_strut_partial(xcb_property_notify_event_t *ev, client_t *c)
 {
-    client_t *c = client_getbywin(window);
-
     if(c)
         ewmh_process_client_strut(c);
-
-    return 0;
 }
 
 xcb_get_property_cookie_t
-property_get_net_wm_icon(client_t *c)
+property_get_net_wm_icon(xcb_window_t window)
 {
-    return ewmh_window_icon_get_unchecked(c->window);
+    return ewmh_window_icon_get_unchecked(window);
 }
 
 void
 property_update_net_wm_icon(client_t *c, xcb_get_property_cookie_t cookie)
 {
-    cairo_surface_array_t array = ewmh_window_icon_get_reply(cookie);
-    if (array.len == 0)
+    draw_icon_array_t array;
+    xcb_get_property_reply_t *reply = ewmh_window_icon_get_reply(cookie, &array);
+    if (!reply)
+        return;
+    c->have_ewmh_icon = true;
+
+    /* Some applications keep setting the same icons. Keep the icons which
+     * were already decoded and do not emit any signal in this case. */
+    if (c->icon_reply
+        && xcb_get_property_value_length(c->icon_reply) == xcb_get_property_value_length(reply)
+        && !memcmp(xcb_get_property_value(c->icon_reply), xcb_get_property_value(reply),
+                   xcb_get_property_value_length(reply)))
     {
-        cairo_surface_array_wipe(&array);
+        draw_icon_array_wipe(&array);
+        p_delete(&reply);
         return;
     }
-    c->have_ewmh_icon = true;
-    client_set_icons(c, array);
+
+    client_set_icons(c, array, reply);
 }
 
 xcb_get_property_cookie_t
-property_get_net_wm_pid(client_t *c)
+property_get_net_wm_pid(xcb_window_t window)
 {
-    return xcb_get_property_unchecked(globalconf.connection, false, c->window, _NET_WM_PID, XCB_ATOM_CARDINAL, 0L, 1L);
+    return xcb_get_property_unchecked(globalconf.connection, false, window, _NET_WM_PID, XCB_ATOM_CARDINAL, 0L, 1L);
 }
 
 void
@@ -310,9 +312,9 @@ property_update_net_wm_pid(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_motif_wm_hints(client_t *c)
+property_get_motif_wm_hints(xcb_window_t window)
 {
-    return xcb_get_property_unchecked(globalconf.connection, false, c->window, _MOTIF_WM_HINTS, _MOTIF_WM_HINTS, 0L, 5L);
+    return xcb_get_property_unchecked(globalconf.connection, false, window, _MOTIF_WM_HINTS, _MOTIF_WM_HINTS, 0L, 5L);
 }
 
 void
@@ -345,10 +347,10 @@ property_update_motif_wm_hints(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_wm_protocols(client_t *c)
+property_get_wm_protocols(xcb_window_t window)
 {
     return xcb_icccm_get_wm_protocols_unchecked(globalconf.connection,
-						c->window, WM_PROTOCOLS);
+						window, WM_PROTOCOLS);
 }
 
 /** Update the list of supported protocols for a client.
@@ -371,19 +373,18 @@ property_update_wm_protocols(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 /** The property notify event handler.
- * \param state currently unused
- * \param window The window to obtain update the property with.
+ * \param ev The event.
+ * \param c The client of the window, or NULL.
  */
-static int
-property_handle_xembed_info(uint8_t state,
-                            xcb_window_t window)
+static void
+property_handle_xembed_info(xcb_property_notify_event_t *ev, client_t *c)
 {
-    xembed_window_t *emwin = xembed_getbywin(&globalconf.embedded, window);
+    xembed_window_t *emwin = xembed_getbywin(&globalconf.embedded, ev->window);
 
     if(emwin)
     {
         xcb_get_property_cookie_t cookie =
-            xcb_get_property(globalconf.connection, 0, window, _XEMBED_INFO,
+            xcb_get_property(globalconf.connection, 0, ev->window, _XEMBED_INFO,
                              XCB_GET_PROPERTY_TYPE_ANY, 0, 3);
         xcb_get_property_reply_t *propr =
             xcb_get_property_reply(globalconf.connection, cookie, 0);
@@ -391,58 +392,50 @@ property_handle_xembed_info(uint8_t state,
                                globalconf.timestamp, propr);
         p_delete(&propr);
     }
-
-    return 0;
 }
 
-static int
-property_handle_net_wm_opacity(uint8_t state,
-                               xcb_window_t window)
+static void
+property_handle_net_wm_opacity(xcb_property_notify_event_t *ev, client_t *c)
 {
     lua_State *L = globalconf_get_lua_State();
-    drawin_t *drawin = drawin_getbywin(window);
 
-    if(drawin)
+    if(c)
     {
-        luaA_object_push(L, drawin);
-        window_set_opacity(L, -1, xwindow_get_opacity(drawin->window));
-        lua_pop(L, -1);
+        luaA_object_push(L, c);
+        window_set_opacity(L, -1, xwindow_get_opacity(c->window));
+        lua_pop(L, 1);
     }
     else
     {
-        client_t *c = client_getbywin(window);
-        if(c)
+        drawin_t *drawin = drawin_getbywin(ev->window);
+        if(drawin)
         {
-            luaA_object_push(L, c);
-            window_set_opacity(L, -1, xwindow_get_opacity(c->window));
+            luaA_object_push(L, drawin);
+            window_set_opacity(L, -1, xwindow_get_opacity(drawin->window));
             lua_pop(L, 1);
         }
     }
-
-    return 0;
 }
 
-static int
-property_handle_xrootpmap_id(uint8_t state,
-                             xcb_window_t window)
+static void
+property_handle_xrootpmap_id(xcb_property_notify_event_t *ev, client_t *c)
 {
     lua_State *L = globalconf_get_lua_State();
     root_update_wallpaper();
     signal_object_emit(L, &global_signals, "wallpaper_changed", 0);
-    return 0;
 }
 
 /** The property notify event handler handling xproperties.
  * \param ev The event.
+ * \param c The client of the window, or NULL.
  */
 static void
-property_handle_propertynotify_xproperty(xcb_property_notify_event_t *ev)
+property_handle_propertynotify_xproperty(xcb_property_notify_event_t *ev, client_t *c)
 {
     lua_State *L = globalconf_get_lua_State();
     xproperty_t *prop;
     xproperty_t lookup = { .atom = ev->atom };
-    buffer_t buf;
-    void *obj;
+    void *obj = c;
 
     prop = xproperty_array_lookup(&globalconf.xproperties, &lookup);
     if(!prop)
@@ -451,86 +444,91 @@ property_handle_propertynotify_xproperty(xcb_property_notify_event_t *ev)
 
     if (ev->window != globalconf.screen->root)
     {
-        obj = client_getbywin(ev->window);
         if(!obj)
             obj = drawin_getbywin(ev->window);
         if(!obj)
             return;
-    } else
-        obj = NULL;
-
-    /* Get us the name of the property */
-    buffer_inita(&buf, a_strlen(prop->name) + a_strlen("xproperty::") + 1);
-    buffer_addf(&buf, "xproperty::%s", prop->name);
+    }
 
     /* And emit the right signal */
     if (obj)
     {
         luaA_object_push(L, obj);
-        luaA_object_emit_signal(L, -1, buf.s, 0);
+        luaA_object_emit_signal(L, -1, prop->signal, 0);
         lua_pop(L, 1);
     } else
-        signal_object_emit(L, &global_signals, buf.s, 0);
-    buffer_wipe(&buf);
+        signal_object_emit(L, &global_signals, prop->signal, 0);
 }
 
-/** The property notify event handler.
- * \param ev The event.
- */
-void
-property_handle_propertynotify(xcb_property_notify_event_t *ev)
-{
-    int (*handler)(uint8_t state,
-                   xcb_window_t window) = NULL;
+typedef void property_handler_t(xcb_property_notify_event_t *, client_t *);
 
-    globalconf.timestamp = ev->time;
+DO_HASH(xcb_atom_t, property_handler_t *, property_handler, a_inthash, a_inteq)
 
-    property_handle_propertynotify_xproperty(ev);
+/** The handlers of the properties awesome watches, by atom */
+static property_handler_hash_t property_handlers;
 
-    /* Find the correct event handler */
+/** Fill the table of property handlers.
+ * Must be called once the atoms are known.
+ */
+void
+property_init(void)
+{
 #define HANDLE(atom_, cb) \
-    if (ev->atom == atom_) \
-    { \
-        handler = cb; \
-    } else
-#define END return
+    property_handler_hash_insert(&property_handlers, atom_, cb)
 
     /* Xembed stuff */
-    HANDLE(_XEMBED_INFO, property_handle_xembed_info)
+    HANDLE(_XEMBED_INFO, property_handle_xembed_info);
 
     /* ICCCM stuff */
-    HANDLE(XCB_ATOM_WM_TRANSIENT_FOR, property_handle_wm_transient_for)
-    HANDLE(WM_CLIENT_LEADER, property_handle_wm_client_leader)
-    HANDLE(XCB_ATOM_WM_NORMAL_HINTS, property_handle_wm_normal_hints)
-    HANDLE(XCB_ATOM_WM_HINTS, property_handle_wm_hints)
-    HANDLE(XCB_ATOM_WM_NAME, property_handle_wm_name)
-    HANDLE(XCB_ATOM_WM_ICON_NAME, property_handle_wm_icon_name)
-    HANDLE(XCB_ATOM_WM_CLASS, property_handle_wm_class)
-    HANDLE(WM_PROTOCOLS, property_handle_wm_protocols)
-    HANDLE(XCB_ATOM_WM_CLIENT_MACHINE, property_handle_wm_client_machine)
-    HANDLE(WM_WINDOW_ROLE, property_handle_wm_window_role)
+    HANDLE(XCB_ATOM_WM_TRANSIENT_FOR, property_handle_wm_transient_for);
+    HANDLE(WM_CLIENT_LEADER, property_handle_wm_client_leader);
+    HANDLE(XCB_ATOM_WM_NORMAL_HINTS, property_handle_wm_normal_hints);
+    HANDLE(XCB_ATOM_WM_HINTS, property_handle_wm_hints);
+    HANDLE(XCB_ATOM_WM_NAME, property_handle_wm_name);
+    HANDLE(XCB_ATOM_WM_ICON_NAME, property_handle_wm_icon_name);
+    HANDLE(XCB_ATOM_WM_CLASS, property_handle_wm_class);
+    HANDLE(WM_PROTOCOLS, property_handle_wm_protocols);
+    HANDLE(XCB_ATOM_WM_CLIENT_MACHINE, property_handle_wm_client_machine);
+    HANDLE(WM_WINDOW_ROLE, property_handle_wm_window_role);
 
     /* EWMH stuff */
-    HANDLE(_NET_WM_NAME, property_handle_net_wm_name)
-    HANDLE(_NET_WM_ICON_NAME, property_handle_net_wm_icon_name)
-    HANDLE(_NET_WM_STRUT_PARTIAL, property_handle_net_wm_strut_partial)
-    HANDLE(_NET_WM_ICON, property_handle_net_wm_icon)
-    HANDLE(_NET_WM_PID, property_handle_net_wm_pid)
-    HANDLE(_NET_WM_WINDOW_OPACITY, property_handle_net_wm_opacity)
+    HANDLE(_NET_WM_NAME, property_handle_net_wm_name);
+    HANDLE(_NET_WM_ICON_NAME, property_handle_net_wm_icon_name);
+    HANDLE(_NET_WM_STRUT_PARTIAL, property_handle_net_wm_strut_partial);
+    HANDLE(_NET_WM_ICON, property_handle_net_wm_icon);
+    HANDLE(_NET_WM_PID, property_handle_net_wm_pid);
+    HANDLE(_NET_WM_WINDOW_OPACITY, property_handle_net_wm_opacity);
 
     /* MOTIF hints */
-    HANDLE(_MOTIF_WM_HINTS, property_handle_motif_wm_hints)
+    HANDLE(_MOTIF_WM_HINTS, property_handle_motif_wm_hints);
 
     /* background change */
-    HANDLE(_XROOTPMAP_ID, property_handle_xrootpmap_id)
-
-    /* If nothing was found, return */
-    END;
+    HANDLE(_XROOTPMAP_ID, property_handle_xrootpmap_id);
 
 #undef HANDLE
-#undef END
+}
 
-    (*handler)(ev->state, ev->window);
+/** The property notify event handler.
+ * \param ev The event.
+ */
+void
+property_handle_propertynotify(xcb_property_notify_event_t *ev)
+{
+    property_handler_t **handler;
+    client_t *c = NULL;
+
+    globalconf.timestamp = ev->time;
+
+    /* Both the xproperty signals and the handlers mostly need the client */
+    if (ev->window != globalconf.screen->root)
+        c = client_getbywin(ev->window);
+
+    property_handle_propertynotify_xproperty(ev, c);
+
+    /* Find the correct event handler */
+    handler = property_handler_hash_lookup(&property_handlers, ev->atom);
+    if (handler)
+        (**handler)(ev, c);
 }
 
 /** Register a new xproperty.
@@ -579,6 +577,11 @@ luaA_register_xproperty(lua_State *L)
     else
     {
         property.name = a_strdup(name);
+        /* The signal is emitted for every change, so its name is kept */
+        buffer_t buf;
+        buffer_init(&buf);
+        buffer_addf(&buf, "xproperty::%s", name);
+        property.signal = buffer_detach(&buf);
         xproperty_array_insert(&globalconf.xproperties, property);
     }
 
@@ -25,7 +25,7 @@
 #include "objects/client.h"
 
 #define PROPERTY(funcname) \
-    xcb_get_property_cookie_t property_get_##funcname(client_t *c); \
+    xcb_get_property_cookie_t property_get_##funcname(xcb_window_t window); \
     void property_update_##funcname(client_t *c, xcb_get_property_cookie_t cookie)
 
 PROPERTY(wm_name);
@@ -46,6 +46,7 @@ PROPERTY(motif_wm_hints);
 
 #undef PROPERTY
 
+void property_init(void);
 void property_handle_propertynotify(xcb_property_notify_event_t *ev);
 int luaA_register_xproperty(lua_State *L);
 int luaA_set_xproperty(lua_State *L);
@@ -54,6 +55,8 @@ int luaA_get_xproperty(lua_State *L);
 struct xproperty {
     xcb_atom_t atom;
     const char *name;
+    /** The name of the signal emitted when the property changes */
+    const char *signal;
     enum {
         /* UTF8_STRING */
         PROP_STRING,
@@ -133,6 +133,11 @@ root_set_wallpaper(cairo_pattern_t *pattern)
     /* Tell Lua that the wallpaper changed */
     cairo_surface_destroy(globalconf.wallpaper);
     globalconf.wallpaper = surface;
+    globalconf.wallpaper_pixmap = p;
+    globalconf.wallpaper_width = width;
+    globalconf.wallpaper_height = height;
+    globalconf.wallpaper_owned = true;
+    globalconf.wallpaper_generation++;
     signal_object_emit(L, &global_signals, "wallpaper_changed", 0);
 
     result = true;
@@ -142,6 +147,69 @@ disconnect:
     return result;
 }
 
+/** Paint a pattern to an area of the current wallpaper.
+ * The pixmap of the wallpaper is changed in place, so unlike
+ * root_set_wallpaper() this needs neither a second connection nor a round
+ * trip, and only the area is painted and sent to the X server.
+ * This is only done for pixmaps created by root_set_wallpaper(). What happens
+ * when drawing to the pixmap of another program is undefined: it might free
+ * or reuse the pixmap at any time, or share it with others.
+ * \param pattern The pattern, its origin is the top left corner of the area.
+ * \param x The area, in root window coordinates.
+ * \return False if there is no wallpaper of ours covering the whole root
+ * window.
+ */
+static bool
+root_set_wallpaper_area(cairo_pattern_t *pattern, int x, int y, int width, int height)
+{
+    lua_State *L = globalconf_get_lua_State();
+    xcb_connection_t *c = globalconf.connection;
+    const xcb_screen_t *screen = globalconf.screen;
+    int x1 = MAX(x, 0), y1 = MAX(y, 0);
+    int x2 = MIN(x + width, screen->width_in_pixels);
+    int y2 = MIN(y + height, screen->height_in_pixels);
+
+    if (!globalconf.wallpaper || !globalconf.wallpaper_owned
+        || globalconf.wallpaper_width != screen->width_in_pixels
+        || globalconf.wallpaper_height != screen->height_in_pixels)
+        return false;
+
+    if (x1 >= x2 || y1 >= y2)
+        return true;
+    area_t area = { .x = x1, .y = y1, .width = x2 - x1, .height = y2 - y1 };
+
+    cairo_t *cr = cairo_create(globalconf.wallpaper);
+    cairo_rectangle(cr, area.x, area.y, area.width, area.height);
+    cairo_clip(cr);
+    cairo_translate(cr, x, y);
+    cairo_set_source(cr, pattern);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+    cairo_surface_flush(globalconf.wallpaper);
+
+    /* The X server may have copied the background pixmap when it was set, so
+     * set it again for the change to show up, see the X protocol on
+     * ChangeWindowAttributes */
+    xcb_change_window_attributes(c, screen->root, XCB_CW_BACK_PIXMAP,
+                                 &globalconf.wallpaper_pixmap);
+    xcb_clear_area(c, 0, screen->root, area.x, area.y, area.width, area.height);
+
+    /* Setting _XROOTPMAP_ID again tells pseudo-transparent clients to redraw,
+     * without sending us a PropertyNotify event */
+    xcb_grab_server(c);
+    xcb_change_window_attributes(c, screen->root, XCB_CW_EVENT_MASK, (uint32_t[]) { 0 });
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, screen->root, _XROOTPMAP_ID,
+                        XCB_ATOM_PIXMAP, 32, 1, &globalconf.wallpaper_pixmap);
+    xcb_change_window_attributes(c, screen->root, XCB_CW_EVENT_MASK, ROOT_WINDOW_EVENT_MASK);
+    xcb_ungrab_server(c);
+    xcb_flush(c);
+
+    globalconf.wallpaper_generation++;
+    signal_object_emit(L, &global_signals, "wallpaper_changed", 0);
+    return true;
+}
+
 void
 root_update_wallpaper(void)
 {
@@ -153,6 +221,10 @@ root_update_wallpaper(void)
 
     cairo_surface_destroy(globalconf.wallpaper);
     globalconf.wallpaper = NULL;
+    globalconf.wallpaper_pixmap = XCB_NONE;
+    globalconf.wallpaper_width = globalconf.wallpaper_height = 0;
+    globalconf.wallpaper_owned = false;
+    globalconf.wallpaper_generation++;
 
     prop_c = xcb_get_property_unchecked(globalconf.connection, false,
             globalconf.screen->root, _XROOTPMAP_ID, XCB_ATOM_PIXMAP, 0, 1);
@@ -189,6 +261,9 @@ root_update_wallpaper(void)
                                                     globalconf.default_visual,
                                                     geom_r->width,
                                                     geom_r->height);
+    globalconf.wallpaper_pixmap = *rootpix;
+    globalconf.wallpaper_width = geom_r->width;
+    globalconf.wallpaper_height = geom_r->height;
 
     p_delete(&prop_r);
     p_delete(&geom_r);
@@ -349,6 +424,7 @@ luaA_root_keys(lua_State *L)
 
         key_array_wipe(&globalconf.keys);
         key_array_init(&globalconf.keys);
+        globalconf.bindings_generation++;
 
         lua_pushnil(L);
         while(lua_next(L, 1))
@@ -389,6 +465,7 @@ luaA_root_buttons(lua_State *L)
 
         button_array_wipe(&globalconf.buttons);
         button_array_init(&globalconf.buttons);
+        globalconf.bindings_generation++;
 
         lua_pushnil(L);
         while(lua_next(L, 1))
@@ -457,14 +534,36 @@ luaA_root_drawins(lua_State *L)
 }
 
 /** Get the wallpaper as a cairo surface or set it as a cairo pattern.
+ *
+ * When an area is given, only this area of the current wallpaper is replaced
+ * by the pattern, whose origin is then the top left corner of the area. This
+ * fails if there is no wallpaper, if it does not cover the root window or if
+ * it was set by another program.
  *
  * @param pattern A cairo pattern as light userdata
- * @return A cairo surface or nothing.
+ * @tparam[opt] integer x The area to set.
+ * @tparam[opt] integer y
+ * @tparam[opt] integer width
+ * @tparam[opt] integer height
+ * @return A cairo surface or nothing, or whether the wallpaper was set.
  * @function wallpaper
  */
 static int
 luaA_root_wallpaper(lua_State *L)
 {
+    if(lua_gettop(L) == 5)
+    {
+        cairo_pattern_t *pattern = (cairo_pattern_t *)lua_touserdata(L, 1);
+        int x = luaL_checkinteger(L, 2);
+        int y = luaL_checkinteger(L, 3);
+        int width = luaL_checkinteger(L, 4);
+        int height = luaL_checkinteger(L, 5);
+        if(width <= 0 || height <= 0)
+            luaL_error(L, "invalid wallpaper area size %dx%d", width, height);
+        lua_pushboolean(L, root_set_wallpaper_area(pattern, x, y, width, height));
+        return 1;
+    }
+
     if(lua_gettop(L) == 1)
     {
         cairo_pattern_t *pattern = (cairo_pattern_t *)lua_touserdata(L, -1);
@@ -0,0 +1,336 @@
+/*
+ * sampler.c - sampling profiler for Lua code
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* While the sampler runs, an ITIMER_PROF timer sends SIGPROF for every
+ * interval of CPU time used by awesome. The signal handler only sets a flag.
+ * A Lua count hook checks it every SAMPLER_HOOK_COUNT instructions and, when
+ * set, records the Lua stack together with the name of the signal whose
+ * handlers are running.
+ *
+ * Samples for which no Lua code ran since the previous one are counted as
+ * SAMPLER_FRAME_C, so that time spent drawing or talking to the X server is
+ * not attributed to the next Lua function which happens to run.
+ */
+
+#include "sampler.h"
+#include "globalconf.h"
+#include "common/buffer.h"
+#include "common/hash.h"
+#include "common/luaobject.h"
+
+#include <lauxlib.h>
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+/** Lua VM instructions between two checks for a pending sample */
+#define SAMPLER_HOOK_COUNT 1000
+/** The number of innermost Lua frames recorded per sample */
+#define SAMPLER_MAX_DEPTH 64
+/** The default sampling interval in seconds */
+#define SAMPLER_DEFAULT_INTERVAL 0.001
+/** Root frame of samples taken while no Lua code ran */
+#define SAMPLER_FRAME_C "[awesome]"
+/** Root frame of samples taken outside of signal handlers */
+#define SAMPLER_FRAME_NO_SIGNAL "[main]"
+
+static inline uint32_t
+sampler_strhash(const char *s)
+{
+    return a_inthash(a_strhash((const unsigned char *) s));
+}
+
+DO_HASH(char *, unsigned int, sampler_stack, sampler_strhash, A_STREQ)
+
+static struct
+{
+    /** Is the timer running? */
+    bool running;
+    /** The SIGPROF action before the sampler was started */
+    struct sigaction old_action;
+    /** Folded stack -> number of samples */
+    sampler_stack_hash_t stacks;
+    /** Set by the signal handler, cleared when the hook took a sample */
+    volatile sig_atomic_t pending;
+    /** Set by the hook, cleared by the signal handler */
+    volatile sig_atomic_t hook_ran;
+    /** Samples taken while no Lua code ran */
+    volatile sig_atomic_t c_samples;
+} sampler;
+
+static void
+sampler_signal(int signum)
+{
+    if(sampler.hook_ran)
+    {
+        sampler.hook_ran = 0;
+        sampler.pending = 1;
+    }
+    else
+        sampler.c_samples++;
+}
+
+/** Append a stack frame to a folded stack.
+ * Semicolons separate the frames, so they are replaced in the frame name.
+ */
+static void
+sampler_add_frame(buffer_t *buf, lua_Debug *ar)
+{
+    int start = buf->len;
+
+    if(buf->len)
+        buffer_addc(buf, ';');
+    if(*ar->what == 'C')
+        buffer_addf(buf, "%s [C]", NONULL(ar->name));
+    else if(*ar->what == 'm')
+        buffer_addf(buf, "%s", ar->short_src);
+    else
+        buffer_addf(buf, "%s@%s:%d", ar->name ? ar->name : "?",
+                    ar->short_src, ar->linedefined);
+
+    for(int i = start + 1; i < buf->len; i++)
+        if(buf->s[i] == ';')
+            buf->s[i] = ':';
+}
+
+/** Record the current Lua stack as one sample. */
+static void
+sampler_record(lua_State *L)
+{
+    lua_Debug frames[SAMPLER_MAX_DEPTH], ar;
+    int depth = 0;
+    buffer_t buf;
+
+    while(depth < SAMPLER_MAX_DEPTH && lua_getstack(L, depth, &frames[depth]))
+        depth++;
+
+    buffer_init(&buf);
+    if(signal_current_name)
+        buffer_addf(&buf, "[%s]", signal_current_name);
+    else
+        buffer_addsl(&buf, SAMPLER_FRAME_NO_SIGNAL);
+    if(depth == SAMPLER_MAX_DEPTH && lua_getstack(L, depth, &ar))
+        buffer_addsl(&buf, ";...");
+
+    /* Folded stacks go from the outermost to the innermost frame */
+    for(int i = depth - 1; i >= 0; i--)
+    {
+        lua_getinfo(L, "Sn", &frames[i]);
+        sampler_add_frame(&buf, &frames[i]);
+    }
+
+    unsigned int *count = sampler_stack_hash_lookup(&sampler.stacks, buf.s);
+    if(count)
+        (*count)++;
+    else
+        sampler_stack_hash_insert(&sampler.stacks, a_strdup(buf.s), 1);
+
+    buffer_wipe(&buf);
+}
+
+static void
+sampler_hook(lua_State *L, lua_Debug *ar)
+{
+    sampler.hook_ran = 1;
+    if(!sampler.pending)
+        return;
+    sampler.pending = 0;
+    sampler_record(L);
+}
+
+static void
+sampler_clear(void)
+{
+    hash_foreach(slot, sampler.stacks)
+        p_delete(&slot->key);
+    sampler_stack_hash_clear(&sampler.stacks);
+    sampler.c_samples = 0;
+}
+
+static void
+sampler_set_timer(double interval)
+{
+    struct itimerval timer;
+    timer.it_interval.tv_sec = interval;
+    timer.it_interval.tv_usec = (interval - timer.it_interval.tv_sec) * 1e6;
+    /* A zero interval would stop the timer */
+    if(!timer.it_interval.tv_sec && !timer.it_interval.tv_usec)
+        timer.it_interval.tv_usec = 1;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+/** Stop the timer and the hook, the samples are kept. */
+static void
+sampler_end(void)
+{
+    lua_State *L = globalconf_get_lua_State();
+
+    if(!sampler.running)
+        return;
+
+    setitimer(ITIMER_PROF, &(struct itimerval) { { 0, 0 }, { 0, 0 } }, NULL);
+    sigaction(SIGPROF, &sampler.old_action, NULL);
+    /* The hook might have been replaced with debug.sethook() */
+    if(lua_gethook(L) == sampler_hook)
+        lua_sethook(L, NULL, 0, 0);
+    sampler.running = false;
+    sampler.pending = 0;
+}
+
+/** Start the sampling profiler.
+ *
+ * The samples of a previous run are discarded. Every `interval` seconds of
+ * CPU time used by awesome, the running Lua code is recorded together with
+ * the name of the signal whose handlers run it. Time spent while no Lua code
+ * runs, e.g. while drawing or in a long running C function, is recorded as
+ * `[awesome]`.
+ *
+ * The sampler uses a Lua hook, which replaces any hook set with
+ * `debug.sethook`. Coroutines created before the sampler was started are not
+ * sampled.
+ *
+ * @tparam[opt=0.001] number interval The time between two samples in seconds.
+ * @function profiler.start
+ * @see profiler.stop
+ */
+static int
+luaA_profiler_start(lua_State *L)
+{
+    double interval = luaL_optnumber(L, 1, SAMPLER_DEFAULT_INTERVAL);
+    luaL_argcheck(L, interval > 0, 1, "the interval must be positive");
+
+    sampler_end();
+    sampler_clear();
+
+    struct sigaction sa = { .sa_handler = sampler_signal, .sa_flags = SA_RESTART };
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, &sampler.old_action);
+
+    sampler.hook_ran = 0;
+    lua_sethook(globalconf_get_lua_State(), sampler_hook, LUA_MASKCOUNT, SAMPLER_HOOK_COUNT);
+    sampler_set_timer(interval);
+    sampler.running = true;
+
+    return 0;
+}
+
+/** Stop the sampling profiler and get its samples.
+ *
+ * The samples are returned as folded stacks: one line per distinct stack,
+ * with the frames from the outermost to the innermost one separated by
+ * semicolons, followed by a space and the number of samples. The outermost
+ * frame is the name of the signal in brackets, or `[main]` outside of signal
+ * handlers. This is the input format of flame graph tools like
+ * `flamegraph.pl`.
+ *
+ * @tparam[opt] string path Write the samples to this file instead of
+ *   returning them.
+ * @treturn string|boolean The samples, or true once they were written to
+ *   `path`.
+ * @treturn[opt] string The error message if the file could not be written.
+ * @function profiler.stop
+ * @see profiler.start
+ */
+static int
+luaA_profiler_stop(lua_State *L)
+{
+    const char *path = luaL_optstring(L, 1, NULL);
+    buffer_t buf;
+
+    sampler_end();
+
+    buffer_init(&buf);
+    hash_foreach(slot, sampler.stacks)
+        buffer_addf(&buf, "%s %u\n", slot->key, slot->value);
+    if(sampler.c_samples)
+        buffer_addf(&buf, SAMPLER_FRAME_C " %d\n", (int) sampler.c_samples);
+
+    if(!path)
+    {
+        lua_pushlstring(L, buf.s, buf.len);
+        buffer_wipe(&buf);
+        return 1;
+    }
+
+    FILE *file = fopen(path, "w");
+    bool ok = file && fwrite(buf.s, 1, buf.len, file) == (size_t) buf.len;
+    int saved_errno = errno;
+    if(file && fclose(file) != 0 && ok)
+    {
+        ok = false;
+        saved_errno = errno;
+    }
+    buffer_wipe(&buf);
+
+    if(!ok)
+    {
+        lua_pushnil(L);
+        lua_pushfstring(L, "%s: %s", path, strerror(saved_errno));
+        return 2;
+    }
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+/** Check if the sampling profiler is running.
+ *
+ * @treturn boolean True between `profiler.start` and `profiler.stop`.
+ * @function profiler.is_running
+ */
+static int
+luaA_profiler_is_running(lua_State *L)
+{
+    lua_pushboolean(L, sampler.running);
+    return 1;
+}
+
+/** Set up the awesome.profiler table.
+ * \param L The Lua VM state.
+ */
+void
+sampler_setup(lua_State *L)
+{
+    static const struct luaL_Reg profiler_lib[] =
+    {
+        { "start", luaA_profiler_start },
+        { "stop", luaA_profiler_stop },
+        { "is_running", luaA_profiler_is_running },
+        { NULL, NULL }
+    };
+
+    lua_getglobal(L, "awesome");
+    lua_pushstring(L, "profiler");
+    lua_newtable(L);
+    for(const struct luaL_Reg *reg = profiler_lib; reg->name; reg++)
+    {
+        lua_pushcfunction(L, reg->func);
+        lua_setfield(L, -2, reg->name);
+    }
+    /* The awesome table has a __newindex metamethod */
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
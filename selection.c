@@ -75,7 +75,12 @@ luaA_selection_get(lua_State *L)
 
     while(true)
     {
-        event = xcb_wait_for_event(globalconf.connection);
+        /* The refresh below may have read an event already, e.g. for
+         * awesome.has_pending_events(). It might be the one we wait for. */
+        event = globalconf.pending_event;
+        globalconf.pending_event = NULL;
+        if(!event)
+            event = xcb_wait_for_event(globalconf.connection);
 
         if(!event)
             return 0;
@@ -52,15 +52,22 @@
  */
 
 #include "spawn.h"
+#include "common/buffer.h"
+#include "common/hash.h"
 
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <glib.h>
+#include <glib-unix.h>
 
 /** 20 seconds timeout */
 #define AWESOME_SPAWN_TIMEOUT 20.0
+/** How much is read from a pipe at once */
+#define AWESOME_SPAWN_READ_SIZE 4096
 
 /** Wrapper for unrefing startup sequence.
  */
@@ -75,20 +82,39 @@ DO_ARRAY(SnStartupSequence *, SnStartupSequence, a_sn_startup_sequence_unref)
 /** The array of startup sequence running */
 static SnStartupSequence_array_t sn_waits;
 
-typedef struct {
-    GPid pid;
-    int exit_callback;
-} running_child_t;
+/** The running children with an exit callback, by pid */
+DO_HASH(GPid, int, running_child, a_inthash, a_inteq)
 
-static int
-compare_pids(const void *a, const void *b)
+static running_child_hash_t running_children;
+
+/** Statistics about spawned and reaped children */
+static struct
 {
-    return ((running_child_t *) a)->pid - ((running_child_t *) b)->pid;
-}
+    unsigned long spawned;
+    unsigned long reaped;
+    /** Time from SIGCHLD to the exit callbacks, in microseconds */
+    int64_t reap_latency_total;
+    int64_t reap_latency_max;
+} spawn_stats;
+
+typedef struct
+{
+    int exit_callback;
+    int status;
+} exited_child_t;
 
-DO_BARRAY(running_child_t, running_child, DO_NOTHING, compare_pids)
+DO_ARRAY(exited_child_t, exited_child, DO_NOTHING)
 
-static running_child_array_t running_children;
+/** An output pipe of a spawned process which is being read */
+typedef struct
+{
+    /** Called for each line, or LUA_REFNIL to collect the whole output */
+    int line_callback;
+    /** Called at end of file */
+    int done_callback;
+    /** Incomplete last line, or all the output read so far */
+    buffer_t buffer;
+} spawn_reader_t;
 
 /** Remove a SnStartupSequence pointer from an array and forget about it.
  * \param s The startup sequence to found, remove and unref.
@@ -120,13 +146,7 @@ spawn_monitor_timeout(gpointer sequence)
              lua_createtable(L, 0, 2);
              lua_pushstring(L, sn_startup_sequence_get_id(sequence));
              lua_setfield(L, -2, "id");
-             foreach(func, sig->sigfuncs)
-             {
-                 lua_pushvalue(L, -1);
-                 luaA_object_push(L, (void *) *func);
-                 luaA_dofunction(L, 1, 0);
-             }
-             lua_pop(L, 1);
+             signal_object_emit(L, &global_signals, "spawn::timeout", 1);
          }
     }
     sn_startup_sequence_unref(sequence);
@@ -219,18 +239,7 @@ spawn_monitor_event(SnMonitorEvent *event, void *data)
     }
 
     /* send the signal */
-    signal_t *sig = signal_array_getbyname(&global_signals, event_type_str);
-
-    if(sig)
-    {
-        foreach(func, sig->sigfuncs)
-        {
-            lua_pushvalue(L, -1);
-            luaA_object_push(L, (void *) *func);
-            luaA_dofunction(L, 1, 0);
-        }
-        lua_pop(L, 1);
-    }
+    signal_object_emit(L, &global_signals, event_type_str, 1);
 }
 
 /** Tell the spawn module that an app has been started.
@@ -375,35 +384,190 @@ parse_command(lua_State *L, int idx, GError **error)
     return argv;
 }
 
-/** Callback for when a spawned process exits. */
+/** Callback for when spawned processes exited.
+ * All children are looked up before any exit callback runs, so that the
+ * callbacks can spawn new processes.
+ * \param exits The reaped children.
+ * \param signal_time When SIGCHLD was received, from g_get_monotonic_time().
+ */
 void
-spawn_child_exited(pid_t pid, int status)
+spawn_children_exited(spawn_exit_array_t *exits, int64_t signal_time)
 {
-    int exit_callback;
-    running_child_t needle = { .pid = pid };
+    exited_child_array_t children;
+    lua_State *L = globalconf_get_lua_State();
+
+    exited_child_array_init(&children);
+    foreach(reaped, *exits)
+    {
+        int *exit_callback = running_child_hash_lookup(&running_children, reaped->pid);
+        if (exit_callback == NULL) {
+            warn("Unknown child %d exited with status %d", (int) reaped->pid, reaped->status);
+            continue;
+        }
+        exited_child_array_append(&children,
+                (exited_child_t) { .exit_callback = *exit_callback, .status = reaped->status });
+        running_child_hash_remove(&running_children, reaped->pid);
+    }
+
+    if(children.len)
+    {
+        int64_t latency = g_get_monotonic_time() - signal_time;
+        spawn_stats.reaped += children.len;
+        spawn_stats.reap_latency_total += latency * children.len;
+        spawn_stats.reap_latency_max = MAX(spawn_stats.reap_latency_max, latency);
+    }
+
+    foreach(child, children)
+    {
+        /* 'Decode' the exit status */
+        if (WIFEXITED(child->status)) {
+            lua_pushliteral(L, "exit");
+            lua_pushinteger(L, WEXITSTATUS(child->status));
+        } else {
+            check(WIFSIGNALED(child->status));
+            lua_pushliteral(L, "signal");
+            lua_pushinteger(L, WTERMSIG(child->status));
+        }
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, child->exit_callback);
+        luaA_dofunction(L, 2, 0);
+        luaA_unregister(L, &child->exit_callback);
+    }
+    exited_child_array_wipe(&children);
+}
+
+/** Push statistics about spawned processes.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_spawn_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 5);
+    lua_pushinteger(L, spawn_stats.spawned);
+    lua_setfield(L, -2, "spawned");
+    lua_pushinteger(L, spawn_stats.reaped);
+    lua_setfield(L, -2, "reaped");
+    lua_pushinteger(L, running_children.len);
+    lua_setfield(L, -2, "running");
+    lua_pushnumber(L, spawn_stats.reaped
+                   ? spawn_stats.reap_latency_total / 1e6 / spawn_stats.reaped : 0);
+    lua_setfield(L, -2, "reap_latency_mean");
+    lua_pushnumber(L, spawn_stats.reap_latency_max / 1e6);
+    lua_setfield(L, -2, "reap_latency_max");
+    return 1;
+}
+
+/** Pass all complete lines of a reader to its line callback.
+ * \param L The Lua VM state.
+ * \param reader The reader.
+ * \param eof Also pass an incomplete last line?
+ */
+static void
+spawn_reader_lines(lua_State *L, spawn_reader_t *reader, bool eof)
+{
+    const char *start = reader->buffer.s;
+    const char *end = reader->buffer.s + reader->buffer.len;
+    const char *newline;
+
+    while((newline = memchr(start, '\n', end - start)))
+    {
+        lua_pushlstring(L, start, newline - start);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, reader->line_callback);
+        luaA_dofunction(L, 1, 0);
+        start = newline + 1;
+    }
+    if(eof && start < end)
+    {
+        lua_pushlstring(L, start, end - start);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, reader->line_callback);
+        luaA_dofunction(L, 1, 0);
+        start = end;
+    }
+
+    buffer_splice(&reader->buffer, 0, start - reader->buffer.s, "", 0);
+}
+
+/** Read what is available on the pipe of a reader. */
+static gboolean
+spawn_reader_ready(gint fd, GIOCondition condition, gpointer data)
+{
+    spawn_reader_t *reader = data;
     lua_State *L = globalconf_get_lua_State();
+    ssize_t length;
+
+    buffer_ensure(&reader->buffer, reader->buffer.len + AWESOME_SPAWN_READ_SIZE);
+    length = read(fd, reader->buffer.s + reader->buffer.len, AWESOME_SPAWN_READ_SIZE);
+    if(length < 0 && (errno == EAGAIN || errno == EINTR))
+        return G_SOURCE_CONTINUE;
+    if(length < 0)
+        warn("Error reading output of spawned process: %s", strerror(errno));
 
-    running_child_t *child = running_child_array_lookup(&running_children, &needle);
-    if (child == NULL) {
-        warn("Unknown child %d exited with status %d", (int) pid, status);
-        return;
+    if(length > 0)
+    {
+        reader->buffer.len += length;
+        reader->buffer.s[reader->buffer.len] = '\0';
+        if(reader->line_callback != LUA_REFNIL)
+            spawn_reader_lines(L, reader, false);
+        return G_SOURCE_CONTINUE;
     }
-    exit_callback = child->exit_callback;
-    running_child_array_remove(&running_children, child);
-
-    /* 'Decode' the exit status */
-    if (WIFEXITED(status)) {
-        lua_pushliteral(L, "exit");
-        lua_pushinteger(L, WEXITSTATUS(status));
-    } else {
-        check(WIFSIGNALED(status));
-        lua_pushliteral(L, "signal");
-        lua_pushinteger(L, WTERMSIG(status));
+
+    /* End of file or error */
+    close(fd);
+    if(reader->line_callback != LUA_REFNIL)
+        spawn_reader_lines(L, reader, true);
+    else
+        lua_pushlstring(L, reader->buffer.s, reader->buffer.len);
+    if(reader->done_callback != LUA_REFNIL)
+    {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, reader->done_callback);
+        luaA_dofunction(L, reader->line_callback == LUA_REFNIL ? 1 : 0, 0);
     }
+    else if(reader->line_callback == LUA_REFNIL)
+        lua_pop(L, 1);
+
+    luaA_unregister(L, &reader->line_callback);
+    luaA_unregister(L, &reader->done_callback);
+    buffer_wipe(&reader->buffer);
+    p_delete(&reader);
+    return G_SOURCE_REMOVE;
+}
 
-    lua_rawgeti(L, LUA_REGISTRYINDEX, exit_callback);
-    luaA_dofunction(L, 2, 0);
-    luaA_unregister(L, &exit_callback);
+/** Asynchronously read the output of a spawned program.
+ * The file descriptor is read in the main loop and closed at end of file.
+ * Lines are split without going through Lua; when no line callback is
+ * given, the whole output is collected and only passed to the done callback.
+ *
+ * @tparam integer fd The file descriptor, as returned by `spawn`.
+ * @tparam[opt=nil] function line_callback Function called with each line of
+ *   output, without the trailing newline.
+ * @tparam[opt=nil] function done_callback Function called at end of file.
+ *   Without a line callback, its argument is the whole output.
+ * @function spawn_read
+ */
+int
+luaA_spawn_read(lua_State *L)
+{
+    int fd = luaL_checkinteger(L, 1);
+    if(!lua_isnoneornil(L, 2))
+        luaA_checkfunction(L, 2);
+    if(!lua_isnoneornil(L, 3))
+        luaA_checkfunction(L, 3);
+
+    int flags = fcntl(fd, F_GETFL);
+    if(flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)
+        return luaL_error(L, "spawn_read: invalid file descriptor %d", fd);
+
+    spawn_reader_t *reader = p_new(spawn_reader_t, 1);
+    reader->line_callback = reader->done_callback = LUA_REFNIL;
+    buffer_init(&reader->buffer);
+    if(!lua_isnoneornil(L, 2))
+        luaA_registerfct(L, 2, &reader->line_callback);
+    if(!lua_isnoneornil(L, 3))
+        luaA_registerfct(L, 3, &reader->done_callback);
+
+    g_unix_fd_add(fd, G_IO_IN | G_IO_HUP | G_IO_ERR, spawn_reader_ready, reader);
+    return 0;
 }
 
 /** Spawn a program.
@@ -515,10 +679,11 @@ luaA_spawn(lua_State *L)
     if(flags & G_SPAWN_DO_NOT_REAP_CHILD)
     {
         /* Only do this down here to avoid leaks in case of errors */
-        running_child_t child = { .pid = pid, .exit_callback = LUA_REFNIL };
-        luaA_registerfct(L, 6, &child.exit_callback);
-        running_child_array_insert(&running_children, child);
+        int exit_callback = LUA_REFNIL;
+        luaA_registerfct(L, 6, &exit_callback);
+        running_child_hash_insert(&running_children, pid, exit_callback);
     }
+    spawn_stats.spawned++;
 
     /* push pid on stack */
     lua_pushinteger(L, pid);
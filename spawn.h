@@ -23,13 +23,25 @@
 #define AWESOME_SPAWN_H
 
 #include "objects/client.h"
+#include "common/array.h"
 
 #include <lua.h>
+#include <stdint.h>
+
+typedef struct
+{
+    pid_t pid;
+    int status;
+} spawn_exit_t;
+
+DO_ARRAY(spawn_exit_t, spawn_exit, DO_NOTHING)
 
 void spawn_init(void);
 void spawn_start_notify(client_t *, const char *);
 int luaA_spawn(lua_State *);
-void spawn_child_exited(pid_t, int);
+int luaA_spawn_read(lua_State *);
+void spawn_children_exited(spawn_exit_array_t *, int64_t);
+int luaA_spawn_stats(lua_State *);
 
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
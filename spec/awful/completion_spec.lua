@@ -182,6 +182,17 @@ describe("awful.completion.shell", function()
         assert.same(shell('true', 5, 1, nil), {'true', 5, {'true'}})
     end)
 
+    it("completes executables added to PATH", function()
+        assert.same(shell('newcomm', 8, 1, nil), {'newcomm', 8})
+        local command = Gio.File.new_for_path(test_path .. '/newcommand')
+        command:create(Gio.FileCreateFlags.NONE)
+        command:set_attribute_uint32("unix::mode", tonumber("755", 8),
+                                     Gio.FileQueryInfoFlags.NONE)
+        assert.same(shell('newcomm', 8, 1, nil), {'newcommand', 11, {'newcommand'}})
+        assert.True(os.remove(test_path .. '/newcommand'))
+        assert.same(shell('newcomm', 8, 1, nil), {'newcomm', 8})
+    end)
+
     if has_bash then
         it("does not complete local directory not starting with ./ (bash)", function()
             assert.same(shell('just_a', 7, 1, 'bash'), {'just_a', 7})
@@ -259,6 +259,66 @@ insulate('main', function ()
         end)
     end)
 
+    describe('history', function()
+        local path
+
+        local function read_file()
+            local f = assert(io.open(path))
+            local content = f:read("*a")
+            f:close()
+            return content
+        end
+
+        local function execute(command)
+            prompt.run{
+                textbox = atextbox,
+                history_path = path,
+                history_max = 3,
+            }
+            enter_text(prompt_callback, command)
+            prompt_callback({}, 'Return', 'press')
+        end
+
+        before_each(function()
+            path = os.tmpname()
+            gfs.make_parent_directories = function() return true end
+        end)
+
+        after_each(function()
+            os.remove(path)
+        end)
+
+        it('appends commands and compacts the file', function()
+            execute('a')
+            execute('b')
+            execute('a')
+            assert.are_equal('a\nb\na\n', read_file())
+
+            execute('c')
+            execute('d')
+            execute('e')
+            assert.are_equal('a\nb\na\nc\nd\ne\n', read_file())
+
+            -- Twice history_max lines: rewritten with the newest entries
+            execute('f')
+            assert.are_equal('d\ne\nf\n', read_file())
+        end)
+
+        it('keeps the last occurrence when loading', function()
+            local f = assert(io.open(path, "w"))
+            f:write('x\ny\nx\nz\n')
+            f:close()
+
+            prompt.run{ textbox = atextbox, history_path = path }
+            prompt_callback({}, 'Up', 'press')
+            assert.are_equal('z ', get_prompt_text(markup))
+            prompt_callback({}, 'Up', 'press')
+            assert.are_equal('x ', get_prompt_text(markup))
+            prompt_callback({}, 'Up', 'press')
+            assert.are_equal('y ', get_prompt_text(markup))
+        end)
+    end)
+
     describe('hooks', function()
         it('callback called', function()
             local callback_arg = ''
@@ -0,0 +1,139 @@
+---------------------------------------------------------------------------
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+---------------------------------------------------------------------------
+
+local async = require("gears.async")
+local glib = require("lgi").GLib
+
+describe("gears.async", function()
+    -- An operation which is finished by calling the returned function
+    local function operation()
+        local finish, cancelled
+        local function start(resume)
+            finish = resume
+            return function() cancelled = true end
+        end
+        return start, function(...) finish(...) end, function() return cancelled end
+    end
+
+    it("suspends and resumes tasks", function()
+        local start, finish = operation()
+        local t = async.run(function(a)
+            local b = async.await(start)
+            return a + b
+        end, 1)
+        assert.is.equal("running", t.status)
+        finish(2)
+        assert.is.equal("done", t.status)
+        assert.is.equal(3, t:get_result())
+    end)
+
+    it("handles operations finishing right away", function()
+        local t = async.run(function()
+            return async.await(function(resume) resume("now") end)
+        end)
+        assert.is.equal("done", t.status)
+        assert.is.equal("now", t:get_result())
+    end)
+
+    it("cancels the awaited operation", function()
+        local start, finish, is_cancelled = operation()
+        local cleaned_up = false
+        local t = async.run(function()
+            local ok, err = async.pcall(async.await, start)
+            cleaned_up = not ok and err == async.cancelled
+            async.await(start)
+        end)
+        t:cancel()
+        assert.is_true(is_cancelled())
+        assert.is_true(cleaned_up)
+        assert.is.equal("cancelled", t.status)
+        -- Late results are ignored
+        finish()
+        assert.is.equal("cancelled", t.status)
+    end)
+
+    it("catches errors of functions which wait", function()
+        local start, finish = operation()
+        local t = async.run(function()
+            local ok, err = async.pcall(function()
+                local v = async.await(start)
+                error(v, 0)
+            end)
+            return ok, err, async.pcall(async.await, function(resume) resume("fine") end)
+        end)
+        finish("oops")
+        assert.is.same({ false, "oops", true, "fine" }, { t:get_result() })
+    end)
+
+    it("reports errors", function()
+        local t = async.run(function() error("oops", 0) end)
+        assert.is.equal("failed", t.status)
+        assert.is.equal("oops", t:get_result())
+    end)
+
+    it("can only wait inside of tasks", function()
+        assert.has_error(function() async.sleep(0) end)
+    end)
+
+    it("sleeps in the main loop", function()
+        local t = async.run(function() async.sleep(0.001) return true end)
+        local context = glib.MainContext.default()
+        while not t:is_finished() do
+            context:iteration(true)
+        end
+        assert.is.equal("done", t.status)
+    end)
+
+    it("waits for other tasks", function()
+        local start, finish = operation()
+        local other = async.run(function() return async.await(start) end)
+        local t = async.run(function() return async.wait(other) end)
+        finish(42)
+        assert.is.same({ "done", 42 }, { t:get_result() })
+    end)
+
+    describe("group", function()
+        local function run_ops(g, count)
+            local finishers, tasks = {}, {}
+            for i = 1, count do
+                local start, finish = operation()
+                finishers[i] = finish
+                tasks[i] = g:run(function() return async.await(start) end)
+            end
+            return tasks, finishers
+        end
+
+        it("queues tasks beyond the limit", function()
+            local tasks, finishers = run_ops(async.group { limit = 2 }, 3)
+            assert.is.same({ "running", "running", "pending" },
+                           { tasks[1].status, tasks[2].status, tasks[3].status })
+            finishers[1]()
+            assert.is.equal("running", tasks[3].status)
+        end)
+
+        it("keeps only the newest waiting task when coalescing", function()
+            local tasks, finishers = run_ops(async.group { policy = "coalesce" }, 3)
+            assert.is.same({ "running", "cancelled", "pending" },
+                           { tasks[1].status, tasks[2].status, tasks[3].status })
+            finishers[1]()
+            assert.is.equal("running", tasks[3].status)
+        end)
+
+        it("cancels running tasks when replacing", function()
+            local tasks = run_ops(async.group { policy = "replace" }, 3)
+            assert.is.same({ "cancelled", "cancelled", "running" },
+                           { tasks[1].status, tasks[2].status, tasks[3].status })
+        end)
+
+        it("cancels all of its tasks", function()
+            local g = async.group()
+            local tasks = run_ops(g, 2)
+            g:cancel()
+            assert.is.same({ "cancelled", "cancelled" }, { tasks[1].status, tasks[2].status })
+        end)
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
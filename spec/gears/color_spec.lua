@@ -266,6 +266,22 @@ describe("gears.color", function()
             -- "#00ff00" into the cache
             assert.is_not.equal(color.create_pattern_uncached("#00ff00"), color.create_pattern_uncached("#00ff00"))
         end)
+
+        it("is bounded", function()
+            local first = color("#010203")
+            for i = 1, 1000 do
+                color(string.format("#%06x", i))
+            end
+            assert.is_not.equal(first, color("#010203"))
+        end)
+
+        it("keeps used patterns", function()
+            local first = color("#010204")
+            for i = 1, 1000 do
+                color(string.format("#%06x", i))
+                assert.is.equal(first, color("#010204"))
+            end
+        end)
     end)
 
     describe("ensure_pango_color", function()
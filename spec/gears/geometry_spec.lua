@@ -194,6 +194,57 @@ describe("gears.geometry", function()
             test(expected, areas, elem)
         end)
     end)
+
+    describe("rectangle.free_areas", function()
+        local area = { x = 0, y = 0, width = 100, height = 100 }
+
+        it("nothing removed", function()
+            assert.is.same({ area }, geo.rectangle.free_areas(area, {}))
+        end)
+
+        it("center", function()
+            local elems = {{ x = 25, y = 25, width = 50, height = 50 }}
+            assert.is.same({
+                { x = 0, y = 0, width = 25, height = 100 },
+                { x = 0, y = 0, width = 100, height = 25 },
+                { x = 75, y = 0, width = 25, height = 100 },
+                { x = 0, y = 75, width = 100, height = 25 },
+            }, geo.rectangle.free_areas(area, elems))
+        end)
+
+        it("only maximal areas", function()
+            -- Two windows in the top corners leave a strip below them and
+            -- a gap between them
+            local elems = {
+                { x = 0, y = 0, width = 25, height = 50 },
+                { x = 75, y = 0, width = 25, height = 50 },
+            }
+            assert.is.same({
+                { x = 0, y = 50, width = 100, height = 50 },
+                { x = 25, y = 0, width = 50, height = 100 },
+            }, geo.rectangle.free_areas(area, elems))
+        end)
+
+        it("many windows", function()
+            local elems = {}
+            for i = 0, 9 do
+                table.insert(elems, { x = i * 10, y = i * 10, width = 5, height = 5 })
+            end
+            local areas = geo.rectangle.free_areas(area, elems)
+            for i, a in ipairs(areas) do
+                for _, elem in ipairs(elems) do
+                    assert.is_false(geo.rectangle.area_intersect_area(a, elem))
+                end
+                for j, b in ipairs(areas) do
+                    if i ~= j then
+                        assert.is_false(b.x <= a.x and b.y <= a.y
+                            and b.x + b.width >= a.x + a.width
+                            and b.y + b.height >= a.y + a.height)
+                    end
+                end
+            end
+        end)
+    end)
 end)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,49 @@
+---------------------------------------------------------------------------
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+---------------------------------------------------------------------------
+
+local lazy_require = require("gears.lazy_require")
+
+describe("gears.lazy_require", function()
+    local loaded
+    before_each(function()
+        loaded = {}
+        package.preload["lazy_spec.a"] = function()
+            table.insert(loaded, "a")
+            return { name = "a" }
+        end
+    end)
+    after_each(function()
+        package.preload["lazy_spec.a"] = nil
+        package.loaded["lazy_spec.a"] = nil
+    end)
+
+    it("requires on first access only", function()
+        local t = lazy_require({}, { a = "lazy_spec.a" })
+        assert.is_same(loaded, {})
+        assert.is.equal(t.a.name, "a")
+        assert.is.equal(rawget(t, "a"), t.a)
+        assert.is_same(loaded, { "a" })
+    end)
+
+    it("returns nil for other keys", function()
+        local t = lazy_require({ b = 1 }, { a = "lazy_spec.a" })
+        assert.is.equal(t.b, 1)
+        assert.is_nil(t.c)
+        assert.is_same(loaded, {})
+    end)
+
+    it("keeps an existing metatable", function()
+        local t = setmetatable({}, {
+            __call = function() return "called" end,
+            __index = { c = 3 },
+        })
+        lazy_require(t, { a = "lazy_spec.a" })
+        assert.is.equal(t(), "called")
+        assert.is.equal(t.c, 3)
+        assert.is.equal(t.a.name, "a")
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
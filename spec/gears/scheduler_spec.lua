@@ -0,0 +1,121 @@
+---------------------------------------------------------------------------
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+---------------------------------------------------------------------------
+
+describe("gears.scheduler", function()
+    local scheduler
+    local handlers, pending_events, refresh_requests
+
+    local function emit(name)
+        for _, handler in ipairs(handlers[name] or {}) do
+            handler()
+        end
+    end
+
+    before_each(function()
+        handlers, pending_events, refresh_requests = {}, false, 0
+        _G.awesome.connect_signal = function(name, handler)
+            handlers[name] = handlers[name] or {}
+            table.insert(handlers[name], handler)
+        end
+        _G.awesome.has_pending_events = function() return pending_events end
+        _G.awesome.request_refresh = function() refresh_requests = refresh_requests + 1 end
+
+        package.loaded["gears.scheduler"] = nil
+        scheduler = require("gears.scheduler")
+    end)
+
+    after_each(function()
+        _G.awesome.connect_signal = nil
+        _G.awesome.has_pending_events = nil
+        _G.awesome.request_refresh = nil
+        package.loaded["gears.scheduler"] = nil
+    end)
+
+    it("runs the priorities in their signals", function()
+        local calls = {}
+        scheduler.queue("idle", function() table.insert(calls, "idle") end)
+        scheduler.queue("after_paint", function() table.insert(calls, "after") end)
+        scheduler.queue("before_paint", function(a, b) table.insert(calls, a .. b) end, "be", "fore")
+
+        emit("refresh")
+        assert.is.same({ "before" }, calls)
+        emit("refreshed")
+        assert.is.same({ "before", "after", "idle" }, calls)
+        assert.is_false(scheduler.is_pending())
+        assert.is.equal(1, refresh_requests)
+    end)
+
+    it("runs before_paint work queued meanwhile", function()
+        local count = 0
+        local function f()
+            count = count + 1
+            if count < 3 then
+                scheduler.queue("before_paint", f)
+            end
+        end
+        scheduler.queue("before_paint", f)
+        emit("refresh")
+        assert.is.equal(3, count)
+    end)
+
+    it("yields to pending events", function()
+        local count = 0
+        for _ = 1, 3 do
+            scheduler.queue("idle", function() count = count + 1 end)
+        end
+        pending_events = true
+
+        -- At least one function runs per iteration
+        emit("refreshed")
+        assert.is.equal(1, count)
+        assert.is_true(scheduler.is_pending("idle"))
+        assert.is.equal(1, refresh_requests)
+
+        pending_events = false
+        emit("refreshed")
+        assert.is.equal(3, count)
+    end)
+
+    it("keeps to the budget", function()
+        scheduler.budget.after_paint = 0
+        local count = 0
+        for _ = 1, 3 do
+            scheduler.queue("after_paint", function() count = count + 1 end)
+        end
+        scheduler.queue("idle", function() count = count + 10 end)
+
+        emit("refreshed")
+        assert.is.equal(1, count)
+        emit("refreshed")
+        -- idle work waits for all after_paint work
+        assert.is.equal(2, count)
+        emit("refreshed")
+        assert.is.equal(13, count)
+    end)
+
+    it("deduplicates by key", function()
+        local calls = {}
+        local function f(v) table.insert(calls, v) end
+        scheduler.queue_unique("idle", "k", f, 1)
+        scheduler.queue_unique("idle", "k", f, 2)
+        emit("refreshed")
+        assert.is.same({ 2 }, calls)
+
+        -- A higher priority moves the work
+        scheduler.queue_unique("idle", "k", f, 3)
+        scheduler.queue_unique("before_paint", "k", f, 4)
+        emit("refresh")
+        assert.is.same({ 2, 4 }, calls)
+        emit("refreshed")
+        assert.is.same({ 2, 4 }, calls)
+
+        -- Once run, the key can be queued again
+        scheduler.queue_unique("idle", "k", f, 5)
+        emit("refreshed")
+        assert.is.same({ 2, 4, 5 }, calls)
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
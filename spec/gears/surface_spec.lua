@@ -0,0 +1,106 @@
+---------------------------------------------------------------------------
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+---------------------------------------------------------------------------
+
+local surface = require("gears.surface")
+local cairo = require("lgi").cairo
+
+describe("gears.surface", function()
+    local files = {}
+    local budget = surface.cache_budget
+
+    local function png(size)
+        local path = os.tmpname()
+        cairo.ImageSurface(cairo.Format.ARGB32, size, size):write_to_png(path)
+        table.insert(files, path)
+        return path
+    end
+
+    -- Like the shims of the documentation examples
+    setup(function()
+        _G.awesome.pixbuf_to_surface = function(_, path)
+            return cairo.ImageSurface.create_from_png(path)
+        end
+    end)
+
+    teardown(function()
+        _G.awesome.pixbuf_to_surface = nil
+    end)
+
+    local function collect()
+        collectgarbage("collect")
+        collectgarbage("collect")
+    end
+
+    after_each(function()
+        surface.cache_budget = budget
+        for _, path in ipairs(files) do
+            os.remove(path)
+        end
+        files = {}
+    end)
+
+    describe("cache", function()
+        it("keeps recently used images within its budget", function()
+            surface.cache_budget = 2 * 16 * 16 * 4
+            local probes = setmetatable({}, { __mode = "v" })
+            probes.a = surface.load(png(16))
+            probes.b = surface.load(png(16))
+            probes.c = surface.load(png(16))
+            collect()
+
+            assert.is_nil(probes.a)
+            assert.is_not_nil(probes.b)
+            assert.is_not_nil(probes.c)
+        end)
+
+        it("drops unused images without a budget", function()
+            surface.cache_budget = 0
+            local probes = setmetatable({ surface.load(png(16)) }, { __mode = "v" })
+            collect()
+            assert.is_nil(probes[1])
+        end)
+
+        it("returns the cached surface", function()
+            local path = png(16)
+            assert.is.equal(surface.load(path), surface.load(path))
+        end)
+    end)
+
+    describe("load_async", function()
+        it("delivers the surface to all callbacks", function()
+            local path = png(8)
+            local results = {}
+            for i = 1, 2 do
+                surface.load_async(path, function(surf)
+                    results[i] = surf
+                end)
+            end
+            assert.is_not_nil(results[1])
+            assert.is.equal(results[1], results[2])
+            assert.is.equal(8, results[1].width)
+        end)
+
+        it("decodes at the requested size", function()
+            local path = png(8)
+            local small, full
+            surface.load_async(path, function(surf) small = surf end, { width = 4 })
+            surface.load_async(path, function(surf) full = surf end)
+            assert.is.equal(4, small.width)
+            assert.is.equal(4, small.height)
+            assert.is.equal(8, full.width)
+        end)
+
+        it("reports errors", function()
+            local result, err = true, nil
+            surface.load_async("/nonexistent/image.png", function(surf, e)
+                result, err = surf, e
+            end)
+            assert.is_nil(result)
+            assert.is_string(err)
+        end)
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,65 @@
+---------------------------------------------------------------------------
+-- @author awesome contributors
+-- @copyright 2026 awesome contributors
+---------------------------------------------------------------------------
+
+local search_index = require("menubar.search_index")
+
+describe("menubar.search_index", function()
+    local firefox = { name = "Firefox", cmdline = "firefox %u",
+                      generic_name = "Web Browser", keywords = { "Internet", "WWW" } }
+    local files = { name = "Files", cmdline = "nautilus --new-window",
+                    generic_name = "File Manager" }
+    local term = { name = "XTerm", cmdline = "xterm" }
+    local entries = { firefox, files, term }
+
+    local function names(matches)
+        local ret = {}
+        for _, entry in ipairs(matches) do
+            table.insert(ret, entry.name)
+        end
+        return ret
+    end
+
+    it("matches everything for an empty query", function()
+        local index = search_index.new(entries)
+        assert.is.same({ "Firefox", "Files", "XTerm" }, names(index:search("")))
+    end)
+
+    it("matches names, generic names, keywords and cmdlines", function()
+        local index = search_index.new(entries)
+        assert.is.same({ "Firefox" }, names(index:search("browser")))
+        assert.is.same({ "Firefox" }, names(index:search("www")))
+        assert.is.same({ "Files" }, names(index:search("nautilus")))
+        assert.is.same({ "Firefox", "Files" }, names(index:search("fi")))
+        assert.is.same({}, names(index:search("emacs")))
+    end)
+
+    it("is case-insensitive", function()
+        local index = search_index.new(entries)
+        assert.is.same({ "XTerm" }, names(index:search("xTERM")))
+    end)
+
+    it("reports prefix matches of names and cmdlines only", function()
+        local index = search_index.new(entries)
+        local _, prefix = index:search("file")
+        assert.is_nil(prefix[firefox])
+        assert.is_true(prefix[files])
+
+        _, prefix = index:search("nau")
+        assert.is_true(prefix[files])
+
+        _, prefix = index:search("web")
+        assert.is_nil(prefix[firefox])
+    end)
+
+    it("gives the same results when typing and deleting", function()
+        local index = search_index.new(entries)
+        for _, query in ipairs { "f", "fi", "fil", "file", "fil", "fi", "x", "xt", "" } do
+            local fresh = search_index.new(entries)
+            assert.is.same(names(fresh:search(query)), names(index:search(query)))
+        end
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -3,6 +3,8 @@
 -- @copyright 2017 Zach Peltzer
 ---------------------------------------------------------------------------
 
+package.loaded["gears.scheduler"] = { queue = function() end }
+
 local utils = require("menubar.utils")
 local theme = require("beautiful")
 local glib = require("lgi").GLib
@@ -112,4 +114,60 @@ describe("menubar.utils lookup_icon_uncached", function()
     end)
 end)
 
+describe("menubar.utils parse_dir", function()
+    local gio = require("lgi").Gio
+    local dir, path
+
+    local function write_entry(name, mtime)
+        local f = assert(io.open(path, "w"))
+        f:write("[Desktop Entry]\nType=Application\nName=" .. name .. "\nExec=true\n")
+        f:close()
+        local file = gio.File.new_for_path(path)
+        assert(file:set_attribute_uint64(gio.FILE_ATTRIBUTE_TIME_MODIFIED, mtime,
+                                         gio.FileQueryInfoFlags.NONE))
+        assert(file:set_attribute_uint32(gio.FILE_ATTRIBUTE_TIME_MODIFIED_USEC, 0,
+                                         gio.FileQueryInfoFlags.NONE))
+    end
+
+    local function parse()
+        local loop, result = glib.MainLoop(), nil
+        utils.parse_dir(dir, function(programs)
+            result = programs
+            loop:quit()
+        end)
+        if not result then loop:run() end
+        return result
+    end
+
+    before_each(function()
+        dir = glib.dir_make_tmp("awesome-menubar-XXXXXX")
+        path = dir .. "/entry.desktop"
+    end)
+
+    after_each(function()
+        os.remove(path)
+        os.remove(dir)
+    end)
+
+    it("reuses the parsed keys of unchanged files", function()
+        write_entry("First", 1000000000)
+        assert.is.equal("First", parse()[1].Name)
+
+        -- Same modification time: the cached keys are used
+        write_entry("Second", 1000000000)
+        assert.is.equal("First", parse()[1].Name)
+
+        -- A new modification time makes it parse the file again
+        write_entry("Second", 1000000001)
+        assert.is.equal("Second", parse()[1].Name)
+    end)
+
+    it("forgets removed files", function()
+        write_entry("Removed", 1000000000)
+        assert.is.equal(1, #parse())
+        os.remove(path)
+        assert.is.equal(0, #parse())
+    end)
+end)
+
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
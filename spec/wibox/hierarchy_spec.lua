@@ -5,7 +5,8 @@
 
 local hierarchy = require("wibox.hierarchy")
 
-local Region = require("lgi").cairo.Region
+local cairo = require("lgi").cairo
+local Region = cairo.Region
 local matrix = require("gears.matrix")
 local utils = require("wibox.test_utils")
 
@@ -258,6 +259,30 @@ describe("wibox.hierarchy", function()
             -- Intermediate drew to 4, 0, 5, 2 (and so does new_intermediate)
             assert.is.same({ rect.x, rect.y, rect.width, rect.height }, { 4, 0, 5, 2 })
         end)
+
+        it("widget inserted at the front", function()
+            local new_child = make_widget(nil)
+            local old_hierarchy = instance:get_children()[1]
+            parent.layout = function()
+                return {
+                    make_child(new_child, 4, 2, matrix.create_translate(0, 0)),
+                    make_child(intermediate, 5, 2, matrix.create_translate(4, 0))
+                }
+            end
+            parent:emit_signal("widget::layout_changed")
+
+            local region = instance:update(context, parent, 15, 16)
+            local children = instance:get_children()
+            assert.is.equal(#children, 2)
+            assert.is.equal(children[2], old_hierarchy)
+            assert.is.equal(children[2]:get_widget(), intermediate)
+
+            -- Only the parent and the new child were laid out
+            assert.is.same(instance:get_update_stats(), { updated = 2, nodes = 4 })
+            assert.is.equal(region:num_rectangles(), 1)
+            local rect = region:get_rectangle(0)
+            assert.is.same({ rect.x, rect.y, rect.width, rect.height }, { 0, 0, 4, 2 })
+        end)
     end)
 
     describe("widget counts", function()
@@ -320,6 +345,87 @@ describe("wibox.hierarchy", function()
             assert.is.equal(0, #weak)
         end)
     end)
+
+    describe("retained", function()
+        local context, draws, child, parent, instance, cr
+        before_each(function()
+            local function nop() end
+            context = {}
+            draws = 0
+            child = make_widget(nil)
+            child.draw = function()
+                draws = draws + 1
+            end
+            child._private.retained = true
+            parent = make_widget({ make_child(child, 10, 20, matrix.create_translate(5, 5)) })
+            local function opaque() return 1 end
+            child.get_opacity, parent.get_opacity = opaque, opaque
+            instance = hierarchy.new(context, parent, 15, 25, nop, nop)
+            cr = cairo.Context(cairo.ImageSurface(cairo.Format.ARGB32, 20, 30))
+        end)
+
+        it("draws once", function()
+            instance:draw(context, cr)
+            instance:draw(context, cr)
+            assert.is.equal(1, draws)
+        end)
+
+        it("redraw_needed", function()
+            instance:draw(context, cr)
+            child:emit_signal("widget::redraw_needed")
+            instance:draw(context, cr)
+            assert.is.equal(2, draws)
+        end)
+
+        it("scale changed", function()
+            instance:draw(context, cr)
+            cr:scale(2, 2)
+            instance:draw(context, cr)
+            assert.is.equal(2, draws)
+        end)
+
+        it("not retained", function()
+            child._private.retained = false
+            instance:draw(context, cr)
+            instance:draw(context, cr)
+            assert.is.equal(2, draws)
+        end)
+    end)
+
+    describe("get_children_at", function()
+        local function nop() end
+        local function make_row(count)
+            local children = {}
+            for i = 1, count do
+                children[i] = make_child(make_widget(nil), 10, 10,
+                    matrix.create_translate(10 * (i - 1), 0))
+            end
+            return hierarchy.new({}, make_widget(children), 10 * count, 10, nop, nop)
+        end
+
+        for _, count in ipairs { 3, 20 } do
+            it(count .. " children", function()
+                local instance = make_row(count)
+                local children = instance:get_children()
+
+                assert.is.same({ children[3] }, instance:get_children_at(25, 5))
+                assert.is.same({}, instance:get_children_at(25, 15))
+                assert.is.same({}, instance:get_children_at(-5, 5))
+                -- Adjacent widgets share their border
+                assert.is.same({ children[1], children[2] }, instance:get_children_at(10, 5))
+            end)
+        end
+
+        it("vertical", function()
+            local children = {}
+            for i = 1, 20 do
+                children[i] = make_child(make_widget(nil), 10, 10,
+                    matrix.create_translate(0, 10 * (i - 1)))
+            end
+            local instance = hierarchy.new({}, make_widget(children), 10, 200, nop, nop)
+            assert.is.same({ instance:get_children()[16] }, instance:get_children_at(5, 155))
+        end)
+    end)
 end)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -47,6 +47,53 @@ describe("wibox.widget.base", function()
             collectgarbage("collect")
             assert.is.equal(0, #alive)
         end)
+
+        describe("invalidation", function()
+            local context = { "fake context" }
+            local child_size, parent_fits
+            before_each(function()
+                child_size, parent_fits = 5, 0
+                widget2.fit = function()
+                    return child_size, child_size
+                end
+                widget1.fit = function(self, ctx, width, height)
+                    parent_fits = parent_fits + 1
+                    local w, h = base.fit_widget(self, ctx, widget2, width, height)
+                    return w + 1, h + 1
+                end
+            end)
+
+            it("child size unchanged", function()
+                assert.is.same({ 6, 6 }, { base.fit_widget(no_parent, context, widget1, 20, 20) })
+                widget2:emit_signal("widget::layout_changed")
+                assert.is.same({ 6, 6 }, { base.fit_widget(no_parent, context, widget1, 20, 20) })
+                assert.is.equal(1, parent_fits)
+            end)
+
+            it("child size changed", function()
+                assert.is.same({ 6, 6 }, { base.fit_widget(no_parent, context, widget1, 20, 20) })
+                child_size = 7
+                widget2:emit_signal("widget::layout_changed")
+                assert.is.same({ 8, 8 }, { base.fit_widget(no_parent, context, widget1, 20, 20) })
+                assert.is.equal(2, parent_fits)
+            end)
+
+            it("grandparent", function()
+                local widget3 = base.make_widget()
+                widget3.fit = function(self, ctx, width, height)
+                    return base.fit_widget(self, ctx, widget1, width, height)
+                end
+                assert.is.same({ 6, 6 }, { base.fit_widget(no_parent, context, widget3, 20, 20) })
+                widget2:emit_signal("widget::layout_changed")
+                assert.is.same({ 6, 6 }, { base.fit_widget(no_parent, context, widget3, 20, 20) })
+                assert.is.equal(1, parent_fits)
+
+                child_size = 9
+                widget2:emit_signal("widget::layout_changed")
+                assert.is.same({ 10, 10 }, { base.fit_widget(no_parent, context, widget3, 20, 20) })
+                assert.is.equal(2, parent_fits)
+            end)
+        end)
     end)
 
     describe("setup", function()
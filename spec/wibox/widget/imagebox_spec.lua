@@ -41,6 +41,106 @@ describe("wibox.widget.imagebox", function()
             assert.is.equal(2, layout_changed)
         end)
     end)
+
+    describe("async_image", function()
+        local placeholder, pending
+        before_each(function()
+            placeholder = cairo.ImageSurface(cairo.Format.ARGB32, 10, 10)
+            pending = {}
+            _G.awesome.load_image_async = function(path, callback)
+                table.insert(pending, { path = path, callback = callback })
+            end
+        end)
+
+        after_each(function()
+            _G.awesome.load_image_async = nil
+        end)
+
+        it("shows the placeholder until the image is loaded", function()
+            widget.placeholder = placeholder
+            widget.async_image = "/nonexistent/a.png"
+            assert.is.equal(placeholder, widget._private.image)
+            assert.is.equal(1, #pending)
+            assert.is.equal("/nonexistent/a.png", widget.async_image)
+
+            -- Errors keep the placeholder
+            stub(require("gears.debug"), "print_warning")
+            pending[1].callback(nil, "no such file")
+            assert.is.equal(placeholder, widget._private.image)
+            require("gears.debug").print_warning:revert()
+        end)
+
+        it("is cancelled by setting another image", function()
+            widget.async_image = "/nonexistent/b.png"
+            local img = cairo.ImageSurface(cairo.Format.ARGB32, 20, 20)
+            widget:set_image(img)
+            assert.is_nil(widget.async_image)
+
+            stub(require("gears.debug"), "print_warning")
+            pending[1].callback(nil, "no such file")
+            assert.stub(require("gears.debug").print_warning).was_not_called()
+            require("gears.debug").print_warning:revert()
+            assert.is.equal(img, widget._private.image)
+        end)
+    end)
+
+    describe("scaled copies", function()
+        local img, target
+        before_each(function()
+            img = cairo.ImageSurface(cairo.Format.ARGB32, 256, 256)
+            target = cairo.ImageSurface(cairo.Format.ARGB32, 64, 64)
+        end)
+
+        local function draw(box, size, scale)
+            local cr = cairo.Context(target)
+            cr:scale(scale or 1, scale or 1)
+            box:draw({}, cr, size, size)
+        end
+
+        local function sizes()
+            local ret = {}
+            for _, copy in ipairs(imagebox._scaled_cache[img] or {}) do
+                table.insert(ret, copy[1] .. "x" .. copy[2])
+            end
+            return ret
+        end
+
+        it("are shared between imageboxes", function()
+            widget:set_image(img)
+            local other = imagebox(img)
+            draw(widget, 16)
+            draw(other, 16)
+            assert.is.same({ "16x16" }, sizes())
+
+            -- The device scale is part of the size
+            draw(widget, 16, 2)
+            assert.is.same({ "32x32", "16x16" }, sizes())
+        end)
+
+        it("are not made for unscaled images", function()
+            widget:set_image(img)
+            widget:set_resize(false)
+            draw(widget, 16)
+            assert.is.same({}, sizes())
+        end)
+
+        it("are dropped when the image is set again", function()
+            widget:set_image(img)
+            draw(widget, 16)
+            assert.is.same({ "16x16" }, sizes())
+            widget:set_image(img)
+            assert.is.same({}, sizes())
+        end)
+
+        it("are limited per image", function()
+            widget:set_image(img)
+            for size = 10, 20 do
+                draw(widget, size)
+            end
+            assert.is.equal(imagebox.scaled_cache_size, #sizes())
+            assert.is.equal("20x20", sizes()[1])
+        end)
+    end)
 end)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -113,6 +113,34 @@ describe("wibox.widget.textbox", function()
             assert.is.equal(2, layout_changed)
         end)
     end)
+
+    describe("layout cache", function()
+        local function fit(box, width, height)
+            return box:fit({ dpi = 96 }, width, height)
+        end
+
+        it("is shared", function()
+            widget:set_markup("cached <b>text</b>")
+            local other = textbox("cached <b>text</b>")
+            local w, h = fit(widget, 100, 100)
+            assert.is.equal(w, fit(other, 100, 100))
+            assert.is.equal(h, select(2, fit(other, 100, 100)))
+        end)
+
+        it("notices changes", function()
+            widget:set_text("some text")
+            local w1 = fit(widget, 1000, 100)
+            widget:set_text("some longer text")
+            local w2 = fit(widget, 1000, 100)
+            assert.is_true(w2 > w1)
+
+            widget:set_font("sans 40")
+            local w3 = fit(widget, 1000, 100)
+            assert.is_true(w3 > w2)
+
+            assert.is_true(widget:get_preferred_size_at_dpi(192) > w3)
+        end)
+    end)
 end)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
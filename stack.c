@@ -21,19 +21,36 @@
 
 #include "stack.h"
 #include "ewmh.h"
+#include "common/hash.h"
 #include "objects/client.h"
 #include "objects/drawin.h"
 
-void
-stack_client_remove(client_t *c)
+DO_HASH(xcb_window_t, int, stack_position, a_inthash, a_inteq)
+
+static bool need_stack_refresh = false;
+static bool need_client_list_stacking_update = false;
+
+/** Remove a client from the stack without scheduling any update.
+ * \param c The client to remove.
+ * \return True if the client was on the stack.
+ */
+static bool
+stack_client_take(client_t *c)
 {
     foreach(client, globalconf.stack)
         if(*client == c)
         {
             client_array_remove(&globalconf.stack, client);
-            break;
+            return true;
         }
-    ewmh_update_net_client_list_stacking();
+    return false;
+}
+
+void
+stack_client_remove(client_t *c)
+{
+    if(stack_client_take(c))
+        need_client_list_stacking_update = true;
     stack_windows();
 }
 
@@ -43,9 +60,12 @@ stack_client_remove(client_t *c)
 void
 stack_client_push(client_t *c)
 {
-    stack_client_remove(c);
-    client_array_push(&globalconf.stack, c);
-    ewmh_update_net_client_list_stacking();
+    if(!globalconf.stack.len || globalconf.stack.tab[0] != c)
+    {
+        stack_client_take(c);
+        client_array_push(&globalconf.stack, c);
+        need_client_list_stacking_update = true;
+    }
     stack_windows();
 }
 
@@ -55,14 +75,15 @@ stack_client_push(client_t *c)
 void
 stack_client_append(client_t *c)
 {
-    stack_client_remove(c);
-    client_array_append(&globalconf.stack, c);
-    ewmh_update_net_client_list_stacking();
+    if(!globalconf.stack.len || globalconf.stack.tab[globalconf.stack.len - 1] != c)
+    {
+        stack_client_take(c);
+        client_array_append(&globalconf.stack, c);
+        need_client_list_stacking_update = true;
+    }
     stack_windows();
 }
 
-static bool need_stack_refresh = false;
-
 void
 stack_windows(void)
 {
@@ -87,24 +108,24 @@ stack_window_above(xcb_window_t w, xcb_window_t previous)
                          (uint32_t[]) { previous, XCB_STACK_MODE_ABOVE });
 }
 
+/** The windows in stacking order (bottom first), as computed by
+ * stack_compute_order(). */
+static window_array_t stack_order;
+/** Clients with a transient_for, in stack order */
+static client_array_t stack_transients;
+
 /** Stack a client above.
  * \param c The client.
- * \param previous The previous client on the stack.
- * \return The next-previous!
  */
-static xcb_window_t
-stack_client_above(client_t *c, xcb_window_t previous)
+static void
+stack_client_above(client_t *c)
 {
-    stack_window_above(c->frame_window, previous);
-
-    previous = c->frame_window;
+    window_array_append(&stack_order, c->frame_window);
 
     /* stack transient window on top of their parents */
-    foreach(node, globalconf.stack)
+    foreach(node, stack_transients)
         if((*node)->transient_for == c)
-            previous = stack_client_above(*node, previous);
-
-    return previous;
+            stack_client_above(*node);
 }
 
 /** Stacking layout layers */
@@ -155,48 +176,151 @@ client_layer_translator(client_t *c)
     return WINDOW_LAYER_NORMAL;
 }
 
-/** Restack clients.
- * \todo It might be worth stopping to restack everyone and only stack `c'
- * relatively to the first matching in the list.
+/** The position of each window in the last applied stacking order */
+static stack_position_hash_t stack_applied;
+/** Scratch hash used for removing duplicates from stack_order */
+static stack_position_hash_t stack_seen;
+/** Clients per layer, in stack order */
+static client_array_t stack_layers[WINDOW_LAYER_COUNT];
+
+/** Compute the wanted stacking order into stack_order.
+ * Every client is assigned to its layer in one pass over the stack, then the
+ * layers and drawins are emitted bottom to top.
  */
-void
-stack_refresh()
+static void
+stack_compute_order(void)
 {
-    if(!need_stack_refresh)
-        return;
+    stack_order.len = 0;
+    stack_transients.len = 0;
+    for(window_layer_t layer = 0; layer < WINDOW_LAYER_COUNT; layer++)
+        stack_layers[layer].len = 0;
 
-    xcb_window_t next = XCB_NONE;
+    foreach(node, globalconf.stack)
+    {
+        client_array_append(&stack_layers[client_layer_translator(*node)], *node);
+        if((*node)->transient_for)
+            client_array_append(&stack_transients, *node);
+    }
 
     /* stack desktop windows */
-    for(window_layer_t layer = WINDOW_LAYER_DESKTOP; layer < WINDOW_LAYER_BELOW; layer++)
-        foreach(node, globalconf.stack)
-            if(client_layer_translator(*node) == layer)
-                next = stack_client_above(*node, next);
+    foreach(node, stack_layers[WINDOW_LAYER_DESKTOP])
+        stack_client_above(*node);
 
     /* first stack not ontop drawin window */
     foreach(drawin, globalconf.drawins)
         if(!(*drawin)->ontop)
-        {
-            stack_window_above((*drawin)->window, next);
-            next = (*drawin)->window;
-        }
+            window_array_append(&stack_order, (*drawin)->window);
 
     /* then stack clients */
     for(window_layer_t layer = WINDOW_LAYER_BELOW; layer < WINDOW_LAYER_COUNT; layer++)
-        foreach(node, globalconf.stack)
-            if(client_layer_translator(*node) == layer)
-                next = stack_client_above(*node, next);
+        foreach(node, stack_layers[layer])
+            stack_client_above(*node);
 
     /* then stack ontop drawin window */
     foreach(drawin, globalconf.drawins)
         if((*drawin)->ontop)
+            window_array_append(&stack_order, (*drawin)->window);
+
+    /* Transients with a layer of their own are stacked twice. Since every
+     * window is stacked right above the previous one, only the last
+     * occurrence matters. */
+    if(!stack_transients.len)
+        return;
+
+    stack_position_hash_clear(&stack_seen);
+    int len = 0;
+    for(int i = stack_order.len - 1; i >= 0; i--)
+    {
+        xcb_window_t w = stack_order.tab[i];
+        if(stack_position_hash_lookup(&stack_seen, w))
+            continue;
+        stack_position_hash_insert(&stack_seen, w, i);
+        stack_order.tab[stack_order.len - 1 - len++] = w;
+    }
+    memmove(stack_order.tab, stack_order.tab + stack_order.len - len,
+            len * sizeof(*stack_order.tab));
+    stack_order.len = len;
+}
+
+/** Restack clients.
+ * The windows forming the longest subsequence of the wanted order that is
+ * already correctly stacked are left alone, only the others are moved.
+ * Raising a single client thus costs a single request.
+ */
+void
+stack_refresh()
+{
+    ewmh_refresh_client_list();
+
+    if(need_client_list_stacking_update)
+    {
+        ewmh_update_net_client_list_stacking();
+        need_client_list_stacking_update = false;
+    }
+
+    if(!need_stack_refresh)
+        return;
+
+    stack_compute_order();
+
+    int n = stack_order.len;
+    int *tails = p_alloca(int, n);
+    int *prev = p_alloca(int, n);
+    int *pos = p_alloca(int, n);
+    bool *keep = p_alloca(bool, n);
+    int kept = 0;
+
+    /* Find the longest increasing subsequence of the previous positions */
+    for(int i = 0; i < n; i++)
+    {
+        int *applied = stack_position_hash_lookup(&stack_applied, stack_order.tab[i]);
+
+        keep[i] = false;
+        prev[i] = -1;
+        if(!applied)
+            continue;
+        pos[i] = *applied;
+
+        int l = 0, r = kept;
+        while(l < r)
         {
-            stack_window_above((*drawin)->window, next);
-            next = (*drawin)->window;
+            int m = (l + r) / 2;
+            if(pos[tails[m]] < pos[i])
+                l = m + 1;
+            else
+                r = m;
         }
+        if(l > 0)
+            prev[i] = tails[l - 1];
+        tails[l] = i;
+        if(l == kept)
+            kept++;
+    }
+    for(int i = kept ? tails[kept - 1] : -1; i >= 0; i = prev[i])
+        keep[i] = true;
+
+    /* The bottom window cannot be stacked above anything, so put it below the
+     * lowest window which stays in place */
+    if(n && !keep[0])
+        for(int i = 1; i < n; i++)
+            if(keep[i])
+            {
+                xcb_configure_window(globalconf.connection, stack_order.tab[0],
+                                     XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE,
+                                     (uint32_t[]) { stack_order.tab[i], XCB_STACK_MODE_BELOW });
+                break;
+            }
+
+    /* Going up, every moved window lands on an already correct one */
+    for(int i = 1; i < n; i++)
+        if(!keep[i])
+            stack_window_above(stack_order.tab[i], stack_order.tab[i - 1]);
+
+    stack_position_hash_clear(&stack_applied);
+    for(int i = 0; i < n; i++)
+        stack_position_hash_insert(&stack_applied, stack_order.tab[i], i);
 
     need_stack_refresh = false;
 }
 
-
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
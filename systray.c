@@ -44,6 +44,8 @@ systray_init(void)
 
     globalconf.systray.window = xcb_generate_id(globalconf.connection);
     globalconf.systray.background_pixel = xscreen->black_pixel;
+    globalconf.systray.x = globalconf.systray.y = -1;
+    globalconf.systray.width = globalconf.systray.height = 1;
     xcb_create_window(globalconf.connection, xscreen->root_depth,
                       globalconf.systray.window,
                       xscreen->root,
@@ -142,6 +144,7 @@ systray_request_handle(xcb_window_t embed_win)
     if(xembed_getbywin(&globalconf.embedded, embed_win))
         return -1;
 
+    p_clear(&em, 1);
     p_clear(&em_cookie, 1);
 
     em_cookie = xembed_info_get_unchecked(globalconf.connection, embed_win);
@@ -204,23 +207,30 @@ systray_process_client_message(xcb_client_message_event_t *ev)
     return ret;
 }
 
-/** Check if a window is a KDE tray.
+/** Send the request for checking if a window is a KDE tray.
  * \param w The window to check.
+ * \return The cookie to pass to systray_iskdedockapp_reply().
+ */
+xcb_get_property_cookie_t
+systray_iskdedockapp_unchecked(xcb_window_t w)
+{
+    /* Check if that is a KDE tray because it does not respect fdo standards,
+     * thanks KDE. */
+    return xcb_get_property_unchecked(globalconf.connection, false, w,
+                                      _KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR,
+                                      XCB_ATOM_WINDOW, 0, 1);
+}
+
+/** Check if a window is a KDE tray.
+ * \param kde_check_q The cookie returned by systray_iskdedockapp_unchecked().
  * \return True if it is, false otherwise.
  */
 bool
-systray_iskdedockapp(xcb_window_t w)
+systray_iskdedockapp_reply(xcb_get_property_cookie_t kde_check_q)
 {
-    xcb_get_property_cookie_t kde_check_q;
     xcb_get_property_reply_t *kde_check;
     bool ret;
 
-    /* Check if that is a KDE tray because it does not respect fdo standards,
-     * thanks KDE. */
-    kde_check_q = xcb_get_property_unchecked(globalconf.connection, false, w,
-                                             _KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR,
-                                             XCB_ATOM_WINDOW, 0, 1);
-
     kde_check = xcb_get_property_reply(globalconf.connection, kde_check_q, NULL);
 
     /* it's a KDE systray ?*/
@@ -267,10 +277,17 @@ luaA_systray_invalidate(void)
     signal_object_emit(L, &global_signals, "systray::update", 0);
 
     /* Unmap now if the systray became empty */
-    if(systray_num_visible_entries() == 0)
+    if(systray_num_visible_entries() == 0 && globalconf.systray.mapped)
+    {
         xcb_unmap_window(globalconf.connection, globalconf.systray.window);
+        globalconf.systray.mapped = false;
+    }
 }
 
+/** Lay out the embedded windows.
+ * Only the windows whose position, size or mapping changed since the last
+ * layout are reconfigured.
+ */
 static void
 systray_update(int base_size, bool horizontal, bool reverse, int spacing, bool force_redraw)
 {
@@ -279,19 +296,24 @@ systray_update(int base_size, bool horizontal, bool reverse, int spacing, bool f
 
     /* Give the systray window the correct size */
     int num_entries = systray_num_visible_entries();
-    uint32_t config_vals[4] = { base_size, base_size, 0, 0 };
+    int width = base_size, height = base_size;
     if(horizontal)
-        config_vals[0] = base_size * num_entries + spacing * (num_entries - 1);
+        width = base_size * num_entries + spacing * (num_entries - 1);
     else
-        config_vals[1] = base_size * num_entries + spacing * (num_entries - 1);
-    xcb_configure_window(globalconf.connection,
-                         globalconf.systray.window,
-                         XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
-                         config_vals);
+        height = base_size * num_entries + spacing * (num_entries - 1);
+    if(globalconf.systray.width != width || globalconf.systray.height != height)
+    {
+        uint32_t config_vals[] = { width, height };
+        xcb_configure_window(globalconf.connection,
+                             globalconf.systray.window,
+                             XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
+                             config_vals);
+        globalconf.systray.width = width;
+        globalconf.systray.height = height;
+    }
 
     /* Now resize each embedded window */
-    config_vals[0] = config_vals[1] = 0;
-    config_vals[2] = config_vals[3] = base_size;
+    int x = 0, y = 0;
     for(int i = 0; i < globalconf.embedded.len; i++)
     {
         xembed_window_t *em;
@@ -303,20 +325,35 @@ systray_update(int base_size, bool horizontal, bool reverse, int spacing, bool f
 
         if (!(em->info.flags & XEMBED_MAPPED))
         {
-            xcb_unmap_window(globalconf.connection, em->win);
+            if(em->mapped)
+            {
+                xcb_unmap_window(globalconf.connection, em->win);
+                em->mapped = false;
+            }
             continue;
         }
 
-        xcb_configure_window(globalconf.connection, em->win,
-                             XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
-                             config_vals);
-        xcb_map_window(globalconf.connection, em->win);
+        if(em->x != x || em->y != y || em->size != base_size)
+        {
+            uint32_t config_vals[] = { x, y, base_size, base_size };
+            xcb_configure_window(globalconf.connection, em->win,
+                                 XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
+                                 config_vals);
+            em->x = x;
+            em->y = y;
+            em->size = base_size;
+        }
+        if(!em->mapped)
+        {
+            xcb_map_window(globalconf.connection, em->win);
+            em->mapped = true;
+        }
         if (force_redraw)
             xcb_clear_area(globalconf.connection, 1, em->win, 0, 0, 0, 0);
         if(horizontal)
-            config_vals[0] += base_size + spacing;
+            x += base_size + spacing;
         else
-            config_vals[1] += base_size + spacing;
+            y += base_size + spacing;
     }
 }
 
@@ -372,7 +409,7 @@ luaA_systray(lua_State *L)
                                 globalconf.systray.window,
                                 w->window,
                                 x, y);
-        else
+        else if(globalconf.systray.x != x || globalconf.systray.y != y)
         {
             uint32_t config_vals[2] = { x, y };
             xcb_configure_window(globalconf.connection,
@@ -382,12 +419,18 @@ luaA_systray(lua_State *L)
         }
 
         globalconf.systray.parent = w;
+        globalconf.systray.x = x;
+        globalconf.systray.y = y;
 
         if(systray_num_visible_entries() != 0)
         {
             systray_update(base_size, horiz, revers, spacing, force_redraw);
-            xcb_map_window(globalconf.connection,
-                           globalconf.systray.window);
+            if(!globalconf.systray.mapped)
+            {
+                xcb_map_window(globalconf.connection,
+                               globalconf.systray.window);
+                globalconf.systray.mapped = true;
+            }
         }
     }
 
@@ -0,0 +1,160 @@
+/*
+ * A micro benchmark for the pixel format conversions of common/pixels.c.
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *
+ * Every implementation usable on this CPU is first checked against a
+ * floating point reference and then timed on a 256x256 icon, once with
+ * random alpha and once fully opaque. The process fails if an implementation
+ * gives wrong results.
+ */
+
+#include "common/pixels.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SIZE (256 * 256)
+#define ITERATIONS 200
+
+static uint32_t
+reference(uint8_t a, uint8_t r, uint8_t g, uint8_t b)
+{
+    r = lround(r * a / 255.0);
+    g = lround(g * a / 255.0);
+    b = lround(b * a / 255.0);
+    return (uint32_t) a << 24 | (uint32_t) r << 16 | (uint32_t) g << 8 | b;
+}
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool
+check(const pixels_kernels_t *k, const uint32_t *argb, const uint8_t *rgba,
+      const uint8_t *rgb, size_t n)
+{
+    uint32_t *out = calloc(n, sizeof(*out));
+    bool ok = true;
+
+    /* Sizes which are not a multiple of the vector width */
+    for(size_t len = n - 17; len <= n && ok; len++)
+    {
+        k->premultiply_argb(out, argb, len);
+        for(size_t i = 0; i < len && ok; i++)
+        {
+            uint32_t p = argb[i];
+            ok = out[i] == reference(p >> 24, p >> 16, p >> 8, p);
+        }
+
+        k->premultiply_rgba(out, rgba, len);
+        for(size_t i = 0; i < len && ok; i++)
+        {
+            const uint8_t *p = rgba + i * 4;
+            ok = out[i] == reference(p[3], p[0], p[1], p[2]);
+        }
+
+        k->convert_rgb(out, rgb, len);
+        for(size_t i = 0; i < len && ok; i++)
+        {
+            const uint8_t *p = rgb + i * 3;
+            ok = out[i] == ((uint32_t) p[0] << 16 | (uint32_t) p[1] << 8 | p[2]);
+        }
+    }
+
+    free(out);
+    return ok;
+}
+
+#define TIME(label, call)                                                  \
+    do {                                                                   \
+        double start = now();                                              \
+        for(int i = 0; i < ITERATIONS; i++)                                \
+            call;                                                          \
+        printf("%-8s %-16s %8.1f us\n", k->name, label,                     \
+               (now() - start) / ITERATIONS * 1e6);                        \
+    } while(0)
+
+int
+main(void)
+{
+    uint32_t *argb = malloc(SIZE * sizeof(*argb));
+    uint32_t *opaque = malloc(SIZE * sizeof(*opaque));
+    uint8_t *rgba = malloc(SIZE * 4);
+    uint8_t *rgba_opaque = malloc(SIZE * 4);
+    uint8_t *rgb = malloc(SIZE * 3);
+    uint32_t *out = malloc(SIZE * sizeof(*out));
+    size_t count;
+    const pixels_kernels_t *all = pixels_kernels_all(&count);
+    int ret = EXIT_SUCCESS;
+
+    srand(42);
+    for(size_t i = 0; i < SIZE * 4; i++)
+        rgba[i] = rand();
+    for(size_t i = 0; i < SIZE * 3; i++)
+        rgb[i] = rand();
+    memcpy(argb, rgba, SIZE * 4);
+    for(size_t i = 0; i < SIZE; i++)
+    {
+        /* Fully transparent and opaque pixels take other paths */
+        if(i % 7 == 0)
+            argb[i] &= 0x00ffffff;
+        if(i % 5 == 0)
+            argb[i] |= 0xff000000;
+        opaque[i] = argb[i] | 0xff000000;
+        rgba[i * 4 + 3] = argb[i] >> 24;
+    }
+    memcpy(rgba_opaque, rgba, SIZE * 4);
+    for(size_t i = 0; i < SIZE; i++)
+        rgba_opaque[i * 4 + 3] = 0xff;
+
+    for(size_t j = 0; j < count; j++)
+    {
+        const pixels_kernels_t *k = &all[j];
+        if(!check(k, argb, rgba, rgb, SIZE))
+        {
+            printf("%-8s gives wrong results\n", k->name);
+            ret = EXIT_FAILURE;
+            continue;
+        }
+        TIME("argb", k->premultiply_argb(out, argb, SIZE));
+        TIME("argb opaque", k->premultiply_argb(out, opaque, SIZE));
+        TIME("rgba", k->premultiply_rgba(out, rgba, SIZE));
+        TIME("rgba opaque", k->premultiply_rgba(out, rgba_opaque, SIZE));
+        TIME("rgb", k->convert_rgb(out, rgb, SIZE));
+    }
+    printf("Using %s\n", pixels_kernels()->name);
+
+    free(argb);
+    free(opaque);
+    free(rgba);
+    free(rgba_opaque);
+    free(rgb);
+    free(out);
+    return ret;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
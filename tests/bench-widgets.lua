@@ -0,0 +1,355 @@
+--- Headless rendering benchmarks for wibox widgets.
+--
+-- The widget trees are laid out with `wibox.hierarchy` and drawn into cairo
+-- image surfaces, so neither X nor awesome are needed, only Lua and lgi:
+--
+--     lua tests/bench-widgets.lua [options]
+--
+-- Options:
+--
+--  * `--json FILE`: Also write the results to FILE as JSON, `-` for stdout.
+--  * `--filter PATTERN`: Only run benchmarks whose name matches the Lua
+--    pattern.
+--  * `--samples N`: Number of samples per benchmark (default 30).
+--  * `--sample-time SEC`: Minimum duration of a sample (default 0.01).
+--  * `--warmup SEC`: Time spent running a benchmark before measuring it
+--    (default 0.2).
+--
+-- Every sample runs a benchmark as many times as fits into the sample time
+-- and records the average duration of one iteration. The reported
+-- percentiles are over these samples.
+
+local source_dir = (arg and arg[0] or ""):match("^(.*)/tests/[^/]*$") or "."
+package.path = source_dir .. "/lib/?.lua;" .. source_dir .. "/lib/?/init.lua;" .. package.path
+
+local lgi = require("lgi")
+local GLib = lgi.GLib
+local cairo = lgi.cairo
+
+-- The widgets only need a few things from the C API
+_G.awesome = _G.awesome or { version = "benchmark" }
+require("beautiful").init{}
+
+-- Only the widget modules are loaded, `wibox` itself needs the C API
+local hierarchy = require("wibox.hierarchy")
+local declarative = require("wibox.widget.base").make_widget_declarative
+local textbox = require("wibox.widget.textbox")
+local imagebox = require("wibox.widget.imagebox")
+local progressbar = require("wibox.widget.progressbar")
+local graph_widget = require("wibox.widget.graph")
+local fixed = require("wibox.layout.fixed")
+local flex = require("wibox.layout.flex")
+local align = require("wibox.layout.align")
+local grid = require("wibox.layout.grid")
+local margin = require("wibox.container.margin")
+local background = require("wibox.container.background")
+local constraint = require("wibox.container.constraint")
+local place = require("wibox.container.place")
+
+local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
+
+-- {{{ Options
+local options = {
+    json = nil,
+    filter = nil,
+    samples = 30,
+    sample_time = 0.01,
+    warmup = 0.2,
+}
+
+do
+    local i = 1
+    local args = arg or {}
+    while args[i] do
+        local name, value = args[i], args[i + 1]
+        if name == "--json" then
+            options.json = value
+        elseif name == "--filter" then
+            options.filter = value
+        elseif name == "--samples" then
+            options.samples = assert(tonumber(value), "--samples needs a number")
+        elseif name == "--sample-time" then
+            options.sample_time = assert(tonumber(value), "--sample-time needs a number")
+        elseif name == "--warmup" then
+            options.warmup = assert(tonumber(value), "--warmup needs a number")
+        else
+            io.stderr:write("Unknown argument: ", name, "\n")
+            os.exit(1)
+        end
+        i = i + 2
+    end
+end
+-- }}}
+
+-- {{{ Measuring
+local function now()
+    return GLib.get_monotonic_time() / 1e6
+end
+
+-- Run f iters times and return the time per iteration.
+local function run(f, iters)
+    local start = now()
+    for _ = 1, iters do
+        f()
+    end
+    return (now() - start) / iters
+end
+
+local function percentile(sorted, p)
+    local rank = math.max(1, math.ceil(p / 100 * #sorted))
+    return sorted[math.min(rank, #sorted)]
+end
+
+local function measure(f)
+    -- Warm up caches, JIT-less Lua still benefits from a settled GC
+    local iters = 1
+    local deadline = now() + options.warmup
+    repeat
+        local per_iter = run(f, iters)
+        if per_iter * iters < options.sample_time then
+            iters = math.max(iters + 1,
+                math.ceil(options.sample_time / math.max(per_iter, 1e-9)))
+        end
+    until now() >= deadline
+
+    collectgarbage("collect")
+    local samples, sum = {}, 0
+    for i = 1, options.samples do
+        samples[i] = run(f, iters)
+        sum = sum + samples[i]
+    end
+
+    local mean = sum / #samples
+    local variance = 0
+    for _, v in ipairs(samples) do
+        variance = variance + (v - mean) ^ 2
+    end
+    table.sort(samples)
+
+    return {
+        iterations = iters,
+        samples = #samples,
+        mean = mean,
+        stddev = math.sqrt(variance / #samples),
+        min = samples[1],
+        p50 = percentile(samples, 50),
+        p90 = percentile(samples, 90),
+        p99 = percentile(samples, 99),
+        max = samples[#samples],
+    }
+end
+-- }}}
+
+-- {{{ Widget trees
+local context = { dpi = 96 }
+
+local function icon(size)
+    local img = cairo.ImageSurface.create(cairo.Format.ARGB32, size, size)
+    local cr = cairo.Context(img)
+    cr:set_source_rgb(0.2, 0.4, 0.8)
+    cr:arc(size / 2, size / 2, size / 2, 0, 2 * math.pi)
+    cr:fill()
+    return img
+end
+
+local function textboxes(count, prefix)
+    local ret = {}
+    for i = 1, count do
+        ret[i] = textbox(prefix .. i)
+    end
+    return ret
+end
+
+-- Every tree returns its root widget, its size and a leaf which is changed
+-- for the relayout benchmarks.
+local trees = {}
+
+trees["fixed/textbox"] = function()
+    local boxes = textboxes(30, "tag ")
+    local root = fixed.horizontal(unpack(boxes))
+    return root, 1920, 24, boxes[15]
+end
+
+trees["flex/progressbar"] = function()
+    local root = flex.horizontal()
+    local bars = {}
+    for i = 1, 8 do
+        bars[i] = declarative { value = i / 8, max_value = 1, widget = progressbar }
+        root:add(bars[i])
+    end
+    return root, 1920, 24, bars[4]
+end
+
+trees["align/wibar"] = function()
+    local clock = textbox("Tue Oct 14, 12:34")
+    local icons = fixed.horizontal()
+    for _ = 1, 10 do
+        icons:add(imagebox(icon(24)))
+    end
+    icons:add(clock)
+    local root = declarative {
+        fixed.horizontal(unpack(textboxes(9, ""))),
+        textbox(("A long client title "):rep(4)),
+        icons,
+        layout = align.horizontal,
+    }
+    return root, 1920, 24, clock
+end
+
+trees["grid/imagebox"] = function()
+    local root = grid()
+    root.forced_num_cols = 8
+    root.homogeneous = true
+    local image = icon(48)
+    local first
+    for _ = 1, 64 do
+        local box = imagebox(image)
+        first = first or box
+        root:add(box)
+    end
+    return root, 400, 400, first
+end
+
+trees["containers/textbox"] = function()
+    local text = textbox("Notification body text")
+    local root = declarative {
+        {
+            {
+                {
+                    text,
+                    margins = 4,
+                    widget = margin,
+                },
+                bg = "#335577",
+                shape_border_width = 1,
+                widget = background,
+            },
+            width = 300,
+            strategy = "max",
+            widget = constraint,
+        },
+        widget = place,
+    }
+    return root, 400, 100, text
+end
+
+trees["graph"] = function()
+    local graph = declarative { max_value = 1, step_width = 1, widget = graph_widget }
+    for i = 1, 200 do
+        graph:add_value((math.sin(i / 10) + 1) / 2)
+    end
+    local root = background(margin(graph, 2, 2, 2, 2), "#000000")
+    return root, 200, 50, graph
+end
+-- }}}
+
+-- {{{ Benchmarks
+local function noop() end
+
+local benchmarks = {}
+
+local tree_names = {}
+for name in pairs(trees) do
+    table.insert(tree_names, name)
+end
+table.sort(tree_names)
+
+for _, name in ipairs(tree_names) do
+    local root, width, height, leaf = trees[name]()
+    local surface = cairo.ImageSurface.create(cairo.Format.ARGB32, width, height)
+    local h = hierarchy.new(context, root, width, height, noop, noop, {})
+
+    table.insert(benchmarks, { name = name .. ":layout", run = function()
+        hierarchy.new(context, root, width, height, noop, noop, {})
+    end })
+
+    table.insert(benchmarks, { name = name .. ":relayout", run = function()
+        leaf:emit_signal("widget::layout_changed")
+        h:update(context, root, width, height)
+    end })
+
+    table.insert(benchmarks, { name = name .. ":draw", run = function()
+        local cr = cairo.Context(surface)
+        cr.operator = cairo.Operator.CLEAR
+        cr:paint()
+        cr.operator = cairo.Operator.OVER
+        h:draw(context, cr)
+    end })
+end
+-- }}}
+
+-- {{{ Reporting
+local function json_string(s)
+    return '"' .. s:gsub('[%c"\\]', function(c)
+        return string.format("\\u%04x", c:byte())
+    end) .. '"'
+end
+
+local function json_value(v)
+    local t = type(v)
+    if t == "table" then
+        local parts = {}
+        if #v > 0 then
+            for _, item in ipairs(v) do
+                table.insert(parts, json_value(item))
+            end
+            return "[" .. table.concat(parts, ",") .. "]"
+        end
+        local keys = {}
+        for k in pairs(v) do
+            table.insert(keys, k)
+        end
+        table.sort(keys)
+        for _, k in ipairs(keys) do
+            table.insert(parts, json_string(k) .. ":" .. json_value(v[k]))
+        end
+        return "{" .. table.concat(parts, ",") .. "}"
+    elseif t == "string" then
+        return json_string(v)
+    elseif t == "number" then
+        return string.format("%.9g", v)
+    end
+    return tostring(v)
+end
+
+local function us(v)
+    return string.format("%10.2f", v * 1e6)
+end
+
+print(string.format("%-30s %10s %10s %10s %10s %10s %8s",
+                    "benchmark", "min us", "p50 us", "p90 us", "p99 us", "stddev", "iters"))
+
+local results = {}
+for _, b in ipairs(benchmarks) do
+    if not options.filter or b.name:find(options.filter) then
+        local r = measure(b.run)
+        r.name = b.name
+        table.insert(results, r)
+        print(string.format("%-30s %s %s %s %s %s %8d", b.name,
+                            us(r.min), us(r.p50), us(r.p90), us(r.p99), us(r.stddev),
+                            r.iterations))
+    end
+end
+
+if options.json then
+    local data = json_value {
+        lua = _VERSION,
+        time = os.time(),
+        options = {
+            samples = options.samples,
+            sample_time = options.sample_time,
+            warmup = options.warmup,
+        },
+        results = results,
+    }
+    if options.json == "-" then
+        print(data)
+    else
+        local file = assert(io.open(options.json, "w"))
+        file:write(data, "\n")
+        file:close()
+    end
+end
+-- }}}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
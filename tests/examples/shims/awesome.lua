@@ -56,6 +56,14 @@ end
 
 awesome.load_image = lgi.cairo.ImageSurface.create_from_png
 
+-- The templates emit "refresh" and "refreshed" themselves
+function awesome.request_refresh()
+end
+
+function awesome.has_pending_events()
+    return false
+end
+
 function awesome.pixbuf_to_surface(_, path)
     return awesome.load_image(path)
 end
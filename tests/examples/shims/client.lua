@@ -165,6 +165,94 @@ function client.get(s)
     return ret
 end
 
+local function on_selected_tags(c)
+    if c.sticky then return true end
+    for _, t in ipairs(c:tags()) do
+        if t.selected then return true end
+    end
+    return false
+end
+
+-- Like the C version, without the stacking order
+function client.iterate(filter, s)
+    local cls, i = client.get(s), 0
+    filter = filter or {}
+    local function matches(c, name, value)
+        return filter[name] == nil or (not filter[name]) == (not value)
+    end
+    return function()
+        while i < #cls do
+            i = i + 1
+            local c = cls[i]
+            if matches(c, "visible", c:isvisible())
+                and matches(c, "on_selected_tags", on_selected_tags(c))
+                and matches(c, "minimized", c.minimized)
+                and matches(c, "floating", c.floating) then
+                return c
+            end
+        end
+    end
+end
+
+-- Like the C version, the fake clients have no size hints to apply
+function client.tile_group(gs, cls, wa, vertical, fact, first, last, group_coord, size, _)
+    -- get our orientation right
+    local width = vertical and "height" or "width"
+    local height = vertical and "width" or "height"
+    local x = vertical and "y" or "x"
+    local y = vertical and "x" or "y"
+
+    local available = wa[width] - (group_coord - wa[x])
+
+    -- find our total values
+    local total_fact = 0
+    local min_fact = 1
+    for c = first, last do
+        local i = c - first + 1
+        local size_hints = cls[c].size_hints
+        local size_hint = size_hints["min_"..width] or size_hints["base_"..width] or 0
+        size = math.max(size_hint, size)
+
+        if not fact[i] then
+            fact[i] = min_fact
+        else
+            min_fact = math.min(fact[i], min_fact)
+        end
+        total_fact = total_fact + fact[i]
+    end
+    size = math.max(1, math.min(size, available))
+
+    local coord = wa[y]
+    local used_size = 0
+    local unused = wa[height]
+    for c = first, last do
+        local i = c - first + 1
+        local geom = {}
+        geom[width] = size
+        geom[height] = math.max(1, math.floor(unused * fact[i] / total_fact))
+        geom[x] = group_coord
+        geom[y] = coord
+        gs[cls[c]] = geom
+        coord = coord + geom[height]
+        unused = unused - geom[height]
+        total_fact = total_fact - fact[i]
+        used_size = math.max(used_size, geom[width])
+    end
+
+    return used_size
+end
+
+function client.apply_layout(geometries, useless_gap)
+    for c, g in pairs(geometries) do
+        c:geometry {
+            x      = g.x + useless_gap,
+            y      = g.y + useless_gap,
+            width  = math.max(1, g.width - c.border_width * 2 - useless_gap * 2),
+            height = math.max(1, g.height - c.border_width * 2 - useless_gap * 2),
+        }
+    end
+end
+
 return client
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
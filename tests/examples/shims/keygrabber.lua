@@ -12,6 +12,7 @@ end
 keygrabber = {
     run       = run,
     stop      = stop,
+    filter    = function() end,
     isrunning = function() return keygrabber._current_grabber ~= nil end,
 }
 
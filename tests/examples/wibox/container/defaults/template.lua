@@ -65,6 +65,7 @@ local container = wibox.widget {
 -- Emulate the event loop for 10 iterations
 for _ = 1, 10 do
     awesome:emit_signal("refresh")
+    awesome:emit_signal("refreshed")
 end
 
 -- Get the example fallback size (the tests can return a size if the want)
@@ -0,0 +1,46 @@
+--- Tests for awesome.after_sync()
+
+local runner = require("_runner")
+
+local calls = {}
+
+local steps = {
+    function()
+        awesome.after_sync(function()
+            table.insert(calls, 1)
+            -- Fences added from a callback are handled later
+            awesome.after_sync(function()
+                table.insert(calls, 3)
+            end)
+        end)
+        awesome.after_sync(function()
+            table.insert(calls, 2)
+        end)
+
+        -- The callbacks are never called right away
+        assert(#calls == 0)
+        return true
+    end,
+
+    function()
+        if #calls < 3 then
+            return
+        end
+
+        assert(#calls == 3, #calls)
+        for i = 1, 3 do
+            assert(calls[i] == i, calls[i])
+        end
+        return true
+    end,
+
+    function()
+        -- Invalid arguments are rejected
+        assert(not pcall(awesome.after_sync, 42))
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -334,6 +334,40 @@ test_rule {
 
 
 
+-- The rule index must give the same results as checking every rule, in
+-- order, including after the rules were modified in place.
+do
+    local list = {
+        { rule = { class = "^Firefox$" } },
+        { rule = { class = "term" } },
+        { rule_any = { instance = { "foo", "^ba.$" } }, except = { role = "popup" } },
+        { rule = { class = "Fire", role = "browser" } },
+        { rule = {} },
+        { except = { class = "Firefox" } },
+    }
+    local function matched(c)
+        local ret = {}
+        for _, entry in ipairs(awful.rules.matching_rules(c, list)) do
+            table.insert(ret, gears.table.hasitem(list, entry))
+        end
+        return table.concat(ret, ",")
+    end
+
+    assert(matched { class = "Firefox", role = "browser" } == "1,4,5")
+    assert(matched { class = "Firefox-esr", role = "browser" } == "4,5")
+    assert(matched { class = "xterm", instance = "bar" } == "2,3,5")
+    assert(matched { class = "xterm", instance = "bar", role = "popup" } == "2,5")
+    assert(matched { class = "^Firefox$" } == "1,5")
+    assert(awful.rules.matches_list({ instance = "foo" }, list))
+
+    list[2].rule.class = "fox"
+    list[3].rule_any.instance[2] = "qux"
+    assert(matched { class = "Firefox", instance = "bar" } == "1,2,5")
+    table.remove(list, 5)
+    assert(matched { class = "xterm", instance = "bar" } == "")
+    assert(not awful.rules.matches_list({ instance = "bar" }, list))
+end
+
 -- Wait until all the auto-generated clients are ready
 local function spawn_clients()
     if #client.get() >= #tests then
@@ -106,6 +106,19 @@ local steps = {
 
             assert(not found)
 
+            -- A new tag can get the index of the deleted one once it was
+            -- collected; the client must not end up tagged with it
+            t = nil
+            collectgarbage("collect")
+            collectgarbage("collect")
+            local new_tag = awful.tag.add("New")
+            for _, v in ipairs(c:tags()) do
+                assert(v ~= new_tag)
+            end
+            assert(#new_tag:clients() == 0)
+            new_tag:delete()
+            tags = mouse.screen.tags
+
             -- Test selected tags, view only and selected()
 
             t = tags[2]
@@ -0,0 +1,59 @@
+--- Tests that renaming a tag only updates its taglist entry
+
+local runner = require("_runner")
+local awful = require("awful")
+local wibox = require("wibox")
+
+local tl, entries
+local full_updates = 0
+
+runner.run_steps{
+    function()
+        tl = awful.widget.taglist {
+            screen  = screen[1],
+            filter  = awful.widget.taglist.filter.all,
+            widget_template = {
+                {
+                    id     = "text_role",
+                    widget = wibox.widget.textbox,
+                },
+                id     = "background_role",
+                widget = wibox.container.background,
+            },
+        }
+
+        -- Count the updates rebuilding the whole list
+        local update_now = tl._do_taglist_update_now
+        tl._do_taglist_update_now = function(...)
+            full_updates = full_updates + 1
+            return update_now(...)
+        end
+        return true
+    end,
+
+    function()
+        local tags = screen[1].tags
+        if #tags < 2 or #tl:get_children() ~= #tags then return end
+
+        entries = tl:get_children()
+        full_updates = 0
+        tags[2].name = "renamed"
+        return true
+    end,
+
+    function()
+        local tb = entries[2]:get_children_by_id("text_role")[1]
+        if not tb.text:find("renamed", 1, true) then return end
+
+        -- The entry was relabelled in place, the others were kept
+        assert(full_updates == 0, full_updates)
+        local children = tl:get_children()
+        assert(#children == #entries)
+        for i, entry in ipairs(entries) do
+            assert(children[i] == entry)
+        end
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
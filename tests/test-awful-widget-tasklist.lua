@@ -0,0 +1,58 @@
+--- Tests that a client property change only updates its tasklist entry
+
+local runner = require("_runner")
+local awful = require("awful")
+local wibox = require("wibox")
+local test_client = require("_client")
+
+local tl, entry
+local full_updates = 0
+
+runner.run_steps{
+    function()
+        tl = awful.widget.tasklist {
+            screen = screen[1],
+            filter = awful.widget.tasklist.filter.allscreen,
+            widget_template = {
+                {
+                    id     = "text_role",
+                    widget = wibox.widget.textbox,
+                },
+                id     = "background_role",
+                widget = wibox.container.background,
+            },
+        }
+
+        -- Count the updates rebuilding the whole list
+        local update_now = tl._do_tasklist_update_now
+        tl._do_tasklist_update_now = function(...)
+            full_updates = full_updates + 1
+            return update_now(...)
+        end
+
+        test_client("tasklist")
+        return true
+    end,
+
+    function()
+        local c = client.get()[1]
+        if not c or #tl:get_children() ~= 1 then return end
+
+        entry = tl:get_children()[1]
+        full_updates = 0
+        c.name = "renamed"
+        return true
+    end,
+
+    function()
+        local tb = entry:get_children_by_id("text_role")[1]
+        if not tb.text:find("renamed", 1, true) then return end
+
+        -- The entry was relabelled in place
+        assert(full_updates == 0, full_updates)
+        assert(tl:get_children()[1] == entry)
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -2,8 +2,15 @@
 
 local runner = require("_runner")
 local watch = require("awful.widget.watch")
+local wibox = require("wibox")
+local timer = require("gears.timer")
 
 local callbacks_done = 0
+local outputs = {}
+local unplaced_calls = 0
+local hidden_calls = 0
+local hidden_wibox, calls_when_hidden
+local waited = false
 
 local steps = {
     function(count)
@@ -24,7 +31,71 @@ local steps = {
         if callbacks_done > 1 then  -- timer fired at least twice
             return true
         end
-    end
+    end,
+
+    function(count)
+        -- Watches of the same command share its runs. Every run of the shell
+        -- prints another pid.
+        if count == 1 then
+            local command = { "sh", "-c", "echo $$" }
+            for i = 1, 2 do
+                outputs[i] = {}
+                watch(command, 0.1, function(_, stdout)
+                    table.insert(outputs[i], stdout)
+                end, "widget " .. i)
+            end
+        end
+        if #outputs[2] > 2 then
+            for i, stdout in ipairs(outputs[2]) do
+                assert(outputs[1][i] == stdout, stdout)
+            end
+            return true
+        end
+    end,
+
+    function(count)
+        -- A textbox which was never shown is updated, it might be placed
+        -- somewhere later
+        if count == 1 then
+            watch("echo unplaced", 0.1, function()
+                unplaced_calls = unplaced_calls + 1
+            end, wibox.widget.textbox())
+        end
+        if unplaced_calls > 2 then
+            return true
+        end
+    end,
+
+    function(count)
+        -- A textbox which was shown and is hidden now is not updated
+        if count == 1 then
+            local widget = watch("echo shown", 0.1, function()
+                hidden_calls = hidden_calls + 1
+            end)
+            hidden_wibox = wibox {
+                x = 0, y = 0, width = 100, height = 20,
+                visible = true, widget = widget,
+            }
+        end
+        if hidden_calls > 1 then
+            hidden_wibox.visible = false
+            calls_when_hidden = hidden_calls
+            return true
+        end
+    end,
+
+    function(count)
+        if count == 1 then
+            timer.start_new(0.3, function()
+                waited = true
+            end)
+        end
+        if waited then
+            -- A run which started before it was hidden is still delivered
+            assert(hidden_calls <= calls_when_hidden + 1, hidden_calls)
+            return true
+        end
+    end,
 }
 runner.run_steps(steps)
 
@@ -0,0 +1,57 @@
+--- Tests for deferring property signals with obj:batch()
+
+local runner = require("_runner")
+
+local steps = {
+    function()
+        local d = drawin {}
+        local counts, changed = {}, nil
+
+        for _, name in ipairs { "x", "y", "width", "geometry" } do
+            d:connect_signal("property::" .. name, function()
+                counts[name] = (counts[name] or 0) + 1
+            end)
+        end
+        d:connect_signal("property::changed", function(_, keys)
+            assert(not changed)
+            changed = keys
+        end)
+
+        d:batch(function()
+            d:geometry { x = 10, y = 10, width = 10, height = 10 }
+            d:batch(function()
+                d.x = 20
+                d.width = 20
+            end)
+            -- Nested batches do not emit anything
+            assert(not changed)
+            d.x = 30
+        end)
+
+        assert(counts.x == 1, counts.x)
+        assert(counts.y == 1, counts.y)
+        assert(counts.width == 1, counts.width)
+        assert(counts.geometry == 1, counts.geometry)
+        assert(changed.x and changed.y and changed.width and changed.geometry)
+        assert(d.x == 30)
+
+        -- Signals are emitted right away again after the batch
+        d.y = 30
+        assert(counts.y == 2)
+
+        -- Errors are raised after the signals were emitted
+        changed = nil
+        local ok = pcall(d.batch, d, function()
+            d.x = 40
+            error("failed")
+        end)
+        assert(not ok)
+        assert(counts.x == 2 and changed.x)
+
+        return true
+    end
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,70 @@
+-- Measure how long loading the libraries and drawing a first wibar takes.
+-- This reloads the libraries like a fresh start of awesome would, so the
+-- modules loaded by awesomerc.lua stay loaded but are no longer used.
+
+local runner = require("_runner")
+local GLib = require("lgi").GLib
+
+local prefixes = { "awful", "wibox", "gears", "beautiful", "naughty", "menubar" }
+
+local function unload_libraries()
+    for name in pairs(package.loaded) do
+        for _, prefix in ipairs(prefixes) do
+            if name == prefix or name:sub(1, #prefix + 1) == prefix .. "." then
+                package.loaded[name] = nil
+            end
+        end
+    end
+end
+
+local timer = GLib.Timer()
+local times = {}
+
+local function report(msg, elapsed)
+    print(string.format("%25s: %-10.6g sec", msg, elapsed))
+end
+
+runner.run_steps({
+    function()
+        unload_libraries()
+        timer:start()
+        local gears = require("gears")
+        local awful = require("awful")
+        local wibox = require("wibox")
+        local beautiful = require("beautiful")
+        times.require = timer:elapsed()
+
+        -- What awesomerc.lua needs for its wibar
+        beautiful.init(gears.filesystem.get_themes_dir() .. "default/theme.lua")
+        local bar = awful.wibar { position = "top", screen = screen.primary }
+        bar:setup {
+            layout = wibox.layout.align.horizontal,
+            awful.widget.taglist {
+                screen = screen.primary,
+                filter = awful.widget.taglist.filter.all,
+            },
+            awful.widget.tasklist {
+                screen = screen.primary,
+                filter = awful.widget.tasklist.filter.currenttags,
+            },
+            {
+                layout = wibox.layout.fixed.horizontal,
+                wibox.widget.systray(),
+                wibox.widget.textclock(),
+            },
+        }
+        times.setup = timer:elapsed()
+
+        awesome.emit_signal("refresh")
+        times.first_frame = timer:elapsed()
+
+        report("require libraries", times.require)
+        report("theme and wibar", times.setup - times.require)
+        report("time to first frame", times.first_frame)
+
+        bar.visible = false
+        return true
+    end
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
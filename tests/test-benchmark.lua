@@ -3,6 +3,7 @@
 
 local runner = require("_runner")
 local awful = require("awful")
+local test_client = require("_client")
 local GLib = require("lgi").GLib
 local create_wibox = require("_wibox_helper").create_wibox
 
@@ -77,6 +78,92 @@ benchmark(relayout_textclock, "relayout textclock")
 benchmark(redraw_textclock, "redraw textclock")
 benchmark(e2e_tag_switch, "tag switch")
 
-runner.run_steps({ function() return true end })
+-- The same visible bar with both drawable backends, since the backend decides
+-- how drawing reaches the X server. See awesome.set_drawable_backend.
+for _, backend in ipairs { "xcb", "image", "threaded" } do
+    awesome.set_drawable_backend(backend)
+    local bar, clock = create_wibox()
+    bar.visible = true
+    do_pending_repaint()
+    -- Client-side backends fall back to xcb if the X server cannot use them
+    local name = bar.drawin.drawable.backend
+
+    benchmark(function()
+        clock:emit_signal("widget::redraw_needed")
+        do_pending_repaint()
+    end, "redraw textclock (" .. name .. ")")
+    benchmark(function()
+        bar._drawable._do_complete_repaint()
+        do_pending_repaint()
+    end, "redraw wibox (" .. name .. ")")
+    bar.visible = false
+end
+awesome.set_drawable_backend("xcb")
+
+-- The matrix operations done for every node of a widget hierarchy, with the
+-- translations used by layouts and with a rotation.
+do
+    local matrix = require("gears.matrix")
+    for name, m in pairs { translate = matrix.create_translate(12, 3),
+                           rotate = matrix.create_rotate_at(10, 10, 0.5) } do
+        local to_device = matrix.create_translate(100, 0)
+        benchmark(function()
+            for _ = 1, 1000 do
+                local m2 = m * to_device
+                m2:invert():transform_point(5, 5)
+                m2:transform_rectangle(0, 0, 20, 10)
+                matrix.equals(m2, to_device)
+            end
+        end, "matrix ops (" .. name .. ")")
+    end
+end
+
+-- Tag switching with clients spread over all tags, which is what banning and
+-- restacking have to deal with on a populated setup.
+local num_clients = tonumber(os.getenv("BENCHMARK_CLIENTS")) or (BENCHMARK_EXACT and 100 or 10)
+
+runner.run_steps({
+    function(count)
+        if count == 1 then
+            for _ = 1, num_clients do
+                test_client()
+            end
+        end
+        if #client.get() >= num_clients then
+            return true
+        end
+    end,
+
+    function()
+        local tags = awful.screen.focused().tags
+        for i, c in ipairs(client.get()) do
+            c:move_to_tag(tags[(i - 1) % #tags + 1])
+        end
+        do_pending_repaint()
+
+        benchmark(e2e_tag_switch, string.format("tag switch (%d clients)", num_clients))
+
+        -- Matching a client against a growing rule list, as done when it is
+        -- managed.
+        local c = client.get()[1]
+        for _, num_rules in ipairs { 10, 100, 300 } do
+            local rule_list = {}
+            for i = 1, num_rules do
+                if i % 3 == 0 then
+                    table.insert(rule_list, { rule_any = { class = { "App"..i }, role = { "role"..i } } })
+                elseif i % 3 == 1 then
+                    table.insert(rule_list, { rule = { class = "^App"..i.."$" } })
+                else
+                    table.insert(rule_list, { rule = { instance = "app"..i, name = "Window" } })
+                end
+            end
+            table.insert(rule_list, { rule = {} })
+
+            benchmark(function() awful.rules.matching_rules(c, rule_list) end,
+                      string.format("match %d rules", num_rules))
+        end
+        return true
+    end,
+})
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,66 @@
+--- Tests that the key and button bindings of clients and drawins fire
+
+local runner = require("_runner")
+local awful = require("awful")
+local wibox = require("wibox")
+local test_client = require("_client")
+
+local key_presses, button_presses, drawin_presses = 0, 0, 0
+local w
+
+runner.run_steps{
+    function(count)
+        if count == 1 then
+            test_client("bindings")
+        end
+        local c = client.get()[1]
+        if not c then return end
+
+        c:keys(awful.key({}, "F12", function(cl)
+            assert(cl == c)
+            key_presses = key_presses + 1
+        end))
+        c:buttons(awful.button({}, 1, function(cl)
+            assert(cl == c)
+            button_presses = button_presses + 1
+        end))
+        client.focus = c
+        return true
+    end,
+
+    function(count)
+        local c = client.get()[1]
+        if count == 1 then
+            root.fake_input("key_press", "F12")
+            root.fake_input("key_release", "F12")
+            local geo = c:geometry()
+            mouse.coords({ x = geo.x + geo.width / 2, y = geo.y + geo.height / 2 })
+            root.fake_input("button_press", 1)
+            root.fake_input("button_release", 1)
+        end
+        if key_presses == 1 and button_presses == 1 then
+            return true
+        end
+    end,
+
+    function(count)
+        if count == 1 then
+            w = wibox {
+                x = 10, y = 10, width = 50, height = 50,
+                ontop = true, visible = true,
+            }
+            w:buttons(awful.button({}, 1, function()
+                drawin_presses = drawin_presses + 1
+            end))
+            mouse.coords({ x = 35, y = 35 })
+            root.fake_input("button_press", 1)
+            root.fake_input("button_release", 1)
+        end
+        if drawin_presses == 1 then
+            w.visible = false
+            return true
+        end
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
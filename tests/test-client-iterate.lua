@@ -0,0 +1,56 @@
+--- Tests for client.iterate
+
+local runner = require("_runner")
+local test_client = require("_client")
+local awful = require("awful")
+
+local function collect(...)
+    local ret = {}
+    for c in client.iterate(...) do
+        table.insert(ret, c)
+    end
+    return ret
+end
+
+runner.run_steps{
+    function(count)
+        if count == 1 then
+            test_client("iterate_a")
+            test_client("iterate_b")
+        end
+        if #client.get() == 2 then
+            return true
+        end
+    end,
+
+    function()
+        local all = client.get()
+        assert(#collect() == 2)
+        assert(#collect(nil, screen[1]) == #client.get(screen[1]))
+
+        -- Same order as client.get()
+        local stacked, iterated = client.get(nil, true), collect(nil, nil, true)
+        for i, c in ipairs(stacked) do
+            assert(iterated[i] == c)
+        end
+
+        all[1].minimized = true
+        all[2].floating = true
+        local visible = collect { visible = true }
+        assert(#visible == 1 and visible[1] == all[2])
+        local minimized = collect { minimized = true }
+        assert(#minimized == 1 and minimized[1] == all[1])
+        assert(#collect { floating = true, visible = true } == 1)
+        assert(#collect { floating = false, visible = true } == 0)
+        assert(#awful.client.visible() == 1)
+        assert(#screen[1].hidden_clients == 1)
+
+        -- Killing clients in the loop body is fine
+        for c in client.iterate() do
+            c:kill()
+        end
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
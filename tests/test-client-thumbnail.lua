@@ -0,0 +1,53 @@
+--- Tests for client thumbnails
+
+local runner = require("_runner")
+local test_client = require("_client")
+local surface = require("gears.surface")
+
+local c, updates = nil, 0
+
+runner.run_steps{
+    function(count)
+        if count == 1 then
+            test_client("thumbnail")
+        end
+        c = client.get()[1]
+        if c then
+            return true
+        end
+    end,
+
+    function()
+        awesome.set_thumbnail_rate(30)
+        assert(not pcall(awesome.set_thumbnail_rate, 0))
+
+        assert(c.thumbnail_size == 0)
+        assert(c.thumbnail == nil)
+
+        c:connect_signal("property::thumbnail", function() updates = updates + 1 end)
+        -- The X server might not support it, then it stays 0
+        c.thumbnail_size = 64
+        return true
+    end,
+
+    function()
+        if c.thumbnail_size == 0 then
+            return true
+        end
+        if updates == 0 then
+            return
+        end
+
+        local thumbnail = surface(c.thumbnail)
+        local w, h = surface.get_size(thumbnail)
+        assert(w > 0 and h > 0 and w <= 64 and h <= 64, w .. "x" .. h)
+
+        -- Disabling it forgets the thumbnail
+        c.thumbnail_size = 0
+        assert(c.thumbnail == nil)
+        c:kill()
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
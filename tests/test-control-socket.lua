@@ -0,0 +1,85 @@
+--- Tests for the control socket
+
+local runner = require("_runner")
+local lgi = require("lgi")
+local Gio = lgi.Gio
+local GLib = lgi.GLib
+
+local path = os.tmpname()
+os.remove(path)
+
+local function frame(...)
+    local data = table.concat({ ... }, "\0")
+    local n = #data
+    return string.char(math.floor(n / 2^24) % 256, math.floor(n / 2^16) % 256,
+                       math.floor(n / 2^8) % 256, n % 256) .. data
+end
+
+local connection
+local received = ""
+local replies = {}
+
+local function read_replies()
+    connection:get_input_stream():read_bytes_async(4096, GLib.PRIORITY_DEFAULT, nil, function(stream, res)
+        local bytes = stream:read_bytes_finish(res)
+        if not bytes or bytes:get_size() == 0 then
+            return
+        end
+        received = received .. bytes.data
+        while #received >= 4 do
+            local b1, b2, b3, b4 = received:byte(1, 4)
+            local n = ((b1 * 256 + b2) * 256 + b3) * 256 + b4
+            if #received < 4 + n then
+                break
+            end
+            table.insert(replies, received:sub(5, 4 + n))
+            received = received:sub(5 + n)
+        end
+        read_replies()
+    end)
+end
+
+runner.run_steps{
+    function()
+        assert(awesome.control_listen(path))
+        local client = Gio.SocketClient()
+        client:connect_async(Gio.UnixSocketAddress.new(path), nil, function(_, res)
+            connection = assert(client:connect_finish(res))
+        end)
+        return true
+    end,
+
+    function()
+        if not connection then return end
+
+        -- All requests are sent at once, the replies come in order
+        local requests = frame("return 1 + 1")
+            .. frame("return ...", "a", "b")
+            .. frame("error('boom', 0)")
+            .. frame("this is not Lua")
+            .. frame("return { 1, 2, { x = true } }, nil, 'a\"\\n'")
+            .. frame("return ...", "c", "d")
+        assert(connection:get_output_stream():write_all(requests))
+        read_replies()
+        return true
+    end,
+
+    function()
+        if #replies < 6 then return end
+
+        assert(replies[1] == '{"ok":true,"result":[2]}', replies[1])
+        assert(replies[2] == '{"ok":true,"result":["a","b"]}', replies[2])
+        assert(replies[3] == '{"ok":false,"error":"boom"}', replies[3])
+        assert(replies[4]:find('^{"ok":false,"error":"control:1:'), replies[4])
+        assert(replies[5] == '{"ok":true,"result":[[1,2,{"x":true}],null,"a\\"\\u000a"]}', replies[5])
+        -- The cached chunk gets the new arguments
+        assert(replies[6] == '{"ok":true,"result":["c","d"]}', replies[6])
+
+        awesome.control_close()
+        assert(not GLib.file_test(path, GLib.FileTest.EXISTS), "the socket was not removed")
+        connection:close()
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,85 @@
+--- Tests for the image backend of drawables
+
+local runner = require("_runner")
+local wibox = require("wibox")
+
+local w, backend_changes
+
+local steps = {
+    function()
+        w = wibox { x = 10, y = 10, width = 100, height = 20, visible = true,
+                    backend = "image", bg = "#ff0000" }
+        w:set_widget(wibox.widget.textbox("image backend"))
+
+        -- The X server might not support it, then xcb is used
+        local d = w.drawin.drawable
+        assert(d.backend == "image" or d.backend == "xcb", d.backend)
+        if d.backend == "image" then
+            assert(awesome.memory_stats().drawables.image_bytes >= 100 * 20 * 4)
+        end
+
+        backend_changes = 0
+        d:connect_signal("property::backend", function()
+            backend_changes = backend_changes + 1
+        end)
+        return true
+    end,
+
+    function()
+        -- Switching back gives a new surface which is fully redrawn
+        local d = w.drawin.drawable
+        local surface_changed = false
+        d:connect_signal("property::surface", function() surface_changed = true end)
+        d.backend = "xcb"
+        assert(d.backend == "xcb")
+        assert(backend_changes == 1)
+        assert(surface_changed)
+
+        -- Setting the same backend again does nothing
+        d.backend = "xcb"
+        assert(backend_changes == 1)
+
+        assert(not pcall(function() d.backend = "opengl" end))
+        assert(not pcall(awesome.set_drawable_backend, "default"))
+        return true
+    end,
+
+    function()
+        w.visible = false
+        w = nil
+
+        -- Several threaded wiboxes repainting at the same time
+        w = {}
+        for i = 1, 3 do
+            w[i] = wibox { x = 10, y = 10 + 30 * i, width = 200, height = 20,
+                           visible = true, backend = "threaded" }
+            w[i]:set_widget(wibox.widget.textbox("threaded " .. i))
+        end
+        return true
+    end,
+
+    function(count)
+        local d = w[1].drawin.drawable
+        assert(d.backend == "threaded" or d.backend == "xcb", d.backend)
+
+        -- Keep them busy for a few iterations of the main loop
+        for _, wb in ipairs(w) do
+            wb:get_widget():set_text("frame " .. count)
+        end
+        if count < 5 then
+            return
+        end
+
+        -- Drawables can go away while a worker thread rasterizes them
+        for _, wb in ipairs(w) do
+            wb.visible = false
+        end
+        w = nil
+        collectgarbage("collect")
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
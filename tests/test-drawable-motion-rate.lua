@@ -0,0 +1,67 @@
+--- Tests for the motion_rate of drawables
+
+local runner = require("_runner")
+local wibox = require("wibox")
+
+local wb = wibox {
+    x = 0, y = 0, width = 200, height = 200,
+    visible = true,
+    motion_rate = 2,
+}
+
+local moves = {}
+wb:connect_signal("mouse::move", function(_, x, y)
+    table.insert(moves, { x = x, y = y })
+end)
+
+local steps = {
+    function()
+        local d = wb.drawin.drawable
+        assert(d.motion_rate == 2)
+
+        local changed = false
+        d:connect_signal("property::motion_rate", function() changed = true end)
+        d.motion_rate = -1
+        assert(d.motion_rate == 2 and not changed)
+        d.motion_rate = 4
+        assert(d.motion_rate == 4 and changed)
+
+        mouse.coords { x = 10, y = 10 }
+        return true
+    end,
+
+    function()
+        if #moves == 0 then return end
+
+        -- These come faster than the limit, only the last one is emitted
+        mouse.coords { x = 20, y = 20 }
+        mouse.coords { x = 30, y = 30 }
+        return true
+    end,
+
+    function()
+        local last = moves[#moves]
+        if last.x ~= 30 or last.y ~= 30 then return end
+        assert(#moves <= 3, #moves)
+        return true
+    end,
+}
+
+-- Hold back motions a few more times. Each of them takes a reference to the
+-- drawable, which must leave the Lua stack as it was.
+for round = 1, 3 do
+    table.insert(steps, function(count)
+        if count == 1 then
+            mouse.coords { x = 40 + round, y = 40 }
+            mouse.coords { x = 50 + round, y = 50 }
+        end
+        local last = moves[#moves]
+        if last.x == 50 + round and last.y == 50 then
+            return true
+        end
+    end)
+end
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,45 @@
+--- Tests that adding hotkeys to a hotkeys_popup group only invalidates it
+
+local runner = require("_runner")
+local awful = require("awful")
+local hotkeys_widget = require("awful.hotkeys_popup.widget")
+
+runner.run_steps{
+    function()
+        local popup = hotkeys_widget.new()
+        popup:add_hotkeys {
+            ["Test A"] = {{ modifiers = { "Mod4" }, keys = { a = "first a" } }},
+            ["Test B"] = {{ modifiers = {}, keys = { b = "first b" } }},
+        }
+
+        -- Build the popup of both groups once
+        local grabber = popup:show_help(nil, screen[1])
+        awful.keygrabber.stop(grabber)
+        for _, help_wibox in pairs(popup._cached_wiboxes[screen[1]]) do
+            help_wibox:hide()
+        end
+
+        local items_a = popup:_get_group_items("Test A")
+        local items_b = popup:_get_group_items("Test B")
+        assert(#items_a == 1 and #items_b == 1)
+        assert(popup:_get_group_items("Test A") == items_a)
+        assert(next(popup._cached_wiboxes[screen[1]]))
+
+        popup:add_hotkeys {
+            ["Test A"] = {{ modifiers = { "Mod4" }, keys = { c = "second a" } }},
+        }
+
+        -- Only the changed group is rendered again
+        assert(popup:_get_group_items("Test B") == items_b)
+        local new_a = popup:_get_group_items("Test A")
+        assert(new_a ~= items_a and #new_a == 2, #new_a)
+
+        -- The popups showing it are dropped
+        for _, help_wibox in pairs(popup._cached_wiboxes[screen[1]]) do
+            assert(not help_wibox.groups["Test A"])
+        end
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,59 @@
+--- Tests that the keygrabber filter drops events before they reach Lua
+
+local runner = require("_runner")
+
+local events = {}
+
+local function record(_, key, event)
+    table.insert(events, key .. ":" .. event)
+end
+
+runner.run_steps{
+    function()
+        keygrabber.run(record, {
+            ignore_release = true,
+            ignore_modifiers = true,
+            stop_keys = { "Escape" },
+        })
+
+        root.fake_input("key_press", "Shift_L")
+        root.fake_input("key_release", "Shift_L")
+        root.fake_input("key_press", "a")
+        root.fake_input("key_release", "a")
+        root.fake_input("key_press", "Escape")
+        root.fake_input("key_release", "Escape")
+        return true
+    end,
+
+    function()
+        if #events < 3 then return end
+
+        -- Only the press of "a" and both events of the stop key get through
+        assert(#events == 3, table.concat(events, ", "))
+        assert(events[1] == "a:press")
+        assert(events[2] == "Escape:press")
+        assert(events[3] == "Escape:release")
+
+        -- Replace the filter of the running grabber
+        events = {}
+        keygrabber.filter{ keys = { "b" } }
+        root.fake_input("key_press", "a")
+        root.fake_input("key_release", "a")
+        root.fake_input("key_press", "b")
+        root.fake_input("key_release", "b")
+        return true
+    end,
+
+    function()
+        if #events < 2 then return end
+
+        assert(#events == 2, table.concat(events, ", "))
+        assert(events[1] == "b:press")
+        assert(events[2] == "b:release")
+
+        keygrabber.stop()
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
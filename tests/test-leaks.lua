@@ -9,6 +9,8 @@ local wibox = require("wibox")
 local prepare_for_collect = nil
 local function emit_refresh()
     awesome.emit_signal("refresh")
+    awesome.emit_signal("refreshed")
+    awesome.emit_signal("refresh")
 end
 
 -- Make the layoutbox in the default config GC'able
@@ -81,6 +83,16 @@ collectable(awful.widget.tasklist{screen=1, filter=awful.widget.tasklist.filter.
 prepare_for_collect = emit_refresh
 collectable(create_wibox())
 
+-- A button whose function refers to its wibox must not keep the wibox alive
+local function wibox_with_button()
+    local w = wibox { x = 0, y = 0, width = 20, height = 20 }
+    w:buttons(awful.button({}, 1, function() return w end))
+    return w, w.drawin
+end
+
+prepare_for_collect = emit_refresh
+collectable(wibox_with_button())
+
 runner.run_steps({ function() return true end })
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,47 @@
+--- Tests for awesome.memory_stats()
+
+local runner = require("_runner")
+local wibox = require("wibox")
+
+local w, before
+
+runner.run_steps({
+    function()
+        local stats = awesome.memory_stats()
+        assert(stats.lua > 0, stats.lua)
+        assert(stats.icons >= 0 and stats.wallpaper >= 0)
+        assert(stats.drawables.pixmaps >= 0)
+        assert(stats.drawables.bytes >= 0 and stats.drawables.pool_bytes >= 0)
+        for _, name in ipairs { "client", "drawin", "drawable", "screen", "tag" } do
+            local class = stats.classes[name]
+            assert(class, name)
+            assert(class.instances >= 0 and class.signal_handlers >= 0)
+        end
+
+        before = stats
+        w = wibox { x = 0, y = 0, width = 100, height = 20, visible = true }
+        return true
+    end,
+    function()
+        -- A new visible wibox needs a drawin and a pixmap
+        local stats = awesome.memory_stats()
+        local drawin = stats.classes.drawin
+        assert(drawin.instances == before.classes.drawin.instances + 1)
+        assert(stats.drawables.pixmaps == before.drawables.pixmaps + 1)
+        assert(stats.drawables.bytes >= before.drawables.bytes + 100 * 20 * 4)
+
+        -- Handlers connected to objects are counted for their class
+        local function handler() end
+        w.drawin:connect_signal("property::x", handler)
+        stats = awesome.memory_stats()
+        assert(stats.classes.drawin.signal_handlers == drawin.signal_handlers + 1)
+        w.drawin:disconnect_signal("property::x", handler)
+        stats = awesome.memory_stats()
+        assert(stats.classes.drawin.signal_handlers == drawin.signal_handlers)
+
+        w.visible = false
+        return true
+    end
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,33 @@
+--- Tests for the remembered pointer position
+
+local runner = require("_runner")
+
+runner.run_steps{
+    function()
+        mouse.coords { x = 10, y = 20 }
+        -- Warping forgets the old position, so this is the new one
+        local coords = mouse.coords()
+        assert(coords.x == 10 and coords.y == 20, coords.x .. "x" .. coords.y)
+        assert(mouse.screen == screen[1])
+
+        mouse.coords { x = 40, y = 50 }
+        coords = mouse.coords()
+        assert(coords.x == 40 and coords.y == 50, coords.x .. "x" .. coords.y)
+
+        return true
+    end,
+
+    function()
+        -- Strict mode gives the same answer, straight from the X server
+        local coords = mouse.coords()
+        awesome.set_pointer_strict(true)
+        local strict = mouse.coords()
+        assert(strict.x == coords.x and strict.y == coords.y)
+        assert(mouse.screen == screen[1])
+        awesome.set_pointer_strict(false)
+
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,70 @@
+--- Tests the rate limit and the deduplication of D-Bus notifications
+
+local runner = require("_runner")
+local naughty = require("naughty")
+local lgi = require("lgi")
+local Gio = lgi.Gio
+local GLib = lgi.GLib
+
+local bus = Gio.bus_get_sync(Gio.BusType.SESSION)
+local ids = {}
+
+-- Send a notification like notify-send and record the returned id
+local function notify(appname, title, text)
+    local index = #ids + 1
+    ids[index] = false
+    bus:call("org.freedesktop.Notifications", "/org/freedesktop/Notifications",
+             "org.freedesktop.Notifications", "Notify",
+             GLib.Variant("(susssasa{sv}i)", { appname, 0, "", title, text, {}, {}, -1 }),
+             GLib.VariantType("(u)"), Gio.DBusCallFlags.NONE, -1, nil,
+             function(conn, res)
+                 ids[index] = conn:call_finish(res)[1]
+             end)
+end
+
+local function all_answered()
+    for _, id in ipairs(ids) do
+        if id == false then return false end
+    end
+    return true
+end
+
+runner.run_steps{
+    function()
+        naughty.dbus.config.dedup_window = 60
+        naughty.dbus.config.rate_limit = { rate = 0, burst = 3 }
+
+        notify("dedup", "title", "same")
+        notify("dedup", "title", "same")
+        for i = 1, 5 do
+            notify("flood", "title", "text " .. i)
+        end
+        return true
+    end,
+
+    function()
+        if not all_answered() then return end
+
+        -- The duplicate got the id of the shown notification, and the
+        -- flooding application got id 0 for what did not fit in its bucket
+        assert(ids[1] ~= 0)
+        assert(ids[2] == ids[1], tostring(ids[2]))
+        for i = 3, 5 do
+            assert(ids[i] ~= 0)
+        end
+        assert(ids[6] == 0 and ids[7] == 0)
+
+        assert(naughty.dbus.stats.merged == 1, naughty.dbus.stats.merged)
+        assert(naughty.dbus.stats.dropped == 2, naughty.dbus.stats.dropped)
+
+        local shown = naughty.getById(ids[1])
+        assert(shown and shown.textbox.text:find("(2)", 1, true))
+
+        naughty.dbus.config.dedup_window = nil
+        naughty.dbus.config.rate_limit = nil
+        naughty.destroy_all_notifications()
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
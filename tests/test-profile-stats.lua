@@ -0,0 +1,64 @@
+--- Tests for awesome.profile_stats()
+
+local runner = require("_runner")
+local wibox = require("wibox")
+
+local stages = { "xkb", "screen", "lua_refresh", "drawin", "client",
+                 "drawable", "banning", "stack", "destroy_later", "lua_refreshed" }
+
+local refresh_calls = 0
+local function on_refresh()
+    refresh_calls = refresh_calls + 1
+end
+
+runner.run_steps({
+    function()
+        awesome.connect_signal("refresh", on_refresh)
+        return true
+    end,
+    function()
+        if refresh_calls < 2 then
+            return
+        end
+        awesome.disconnect_signal("refresh", on_refresh)
+
+        local stats = awesome.profile_stats()
+        assert(stats.cycles > 0, stats.cycles)
+        for _, name in ipairs(stages) do
+            local stage = stats[name]
+            assert(stage, name)
+            assert(stage.total >= 0 and stage.max >= 0)
+            assert(stage.max <= stage.total)
+            assert(#stage.history > 0)
+            assert(#stage.history <= stats.cycles)
+            local last = stage.history[#stage.history]
+            assert(last.time >= 0 and last.time <= stage.max)
+        end
+
+        assert(stats.startup.total >= stats.startup.scan)
+        assert(stats.startup.windows >= 0)
+
+        local pool = stats.pixmap_pool
+        assert(pool.hits >= 0 and pool.misses >= 0)
+        assert(pool.pixmaps >= 0 and pool.pixels >= 0)
+
+        -- Our "refresh" handler ran inside the Lua refresh stage
+        assert(stats.lua_refresh.lua_calls >= refresh_calls)
+        return true
+    end,
+    function()
+        -- Growing a drawable a little reuses its old pixmap
+        local w = wibox { x = 0, y = 0, width = 100, height = 20, visible = true }
+        local before = awesome.profile_stats().pixmap_pool
+        w.width = 101
+        w.width = 102
+        local after = awesome.profile_stats().pixmap_pool
+        assert(after.hits == before.hits + 2, after.hits - before.hits)
+        assert(after.misses == before.misses, after.misses - before.misses)
+
+        w.visible = false
+        return true
+    end
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,70 @@
+--- Tests for awesome.profiler
+
+local runner = require("_runner")
+
+local function busy()
+    local x = 0
+    for i = 1, 1e5 do
+        x = x + math.sqrt(i)
+    end
+    return x
+end
+
+-- Handlers are called from C, so only functions they call have a name
+local function handler()
+    busy()
+end
+
+local path = os.tmpname()
+
+runner.run_steps{
+    function()
+        assert(not awesome.profiler.is_running())
+        awesome.profiler.start(0.0005)
+        assert(awesome.profiler.is_running())
+
+        awesome.connect_signal("test::profiler", handler)
+        local deadline = os.clock() + 0.2
+        while os.clock() < deadline do
+            awesome.emit_signal("test::profiler")
+        end
+        awesome.disconnect_signal("test::profiler", handler)
+
+        local folded = awesome.profiler.stop()
+        assert(not awesome.profiler.is_running())
+
+        local total, in_signal = 0, 0
+        for stack, count in folded:gmatch("([^\n]+) (%d+)\n") do
+            total = total + tonumber(count)
+            if stack:find("^%[test::profiler%];") and stack:find("busy@", 1, true) then
+                in_signal = in_signal + tonumber(count)
+            end
+        end
+        assert(total > 0, folded)
+        assert(in_signal > 0, folded)
+
+        return true
+    end,
+
+    function()
+        awesome.profiler.start()
+        busy()
+        assert(awesome.profiler.stop(path) == true)
+
+        local file = assert(io.open(path))
+        local content = file:read("*a")
+        file:close()
+        os.remove(path)
+        for line in content:gmatch("[^\n]+") do
+            assert(line:find("^.+ %d+$"), line)
+        end
+
+        -- Stopping again is fine, but this file cannot be written
+        local ok, err = awesome.profiler.stop("/nonexistent/dir/file")
+        assert(ok == nil and err:find("/nonexistent/dir/file", 1, true), err)
+
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -59,6 +59,10 @@ local steps = {
         assert(wb.y == 110, wb.y)
         assert(wb.width == 600, wb.width)
 
+        -- Overlapping screens are looked up in list order
+        mouse.coords { x = 150, y = 160 }
+        assert(mouse.screen == real_screen, tostring(mouse.screen))
+
         -- Test screen order changes
         assert(list_count == 0)
         assert(screen[1] == real_screen)
@@ -67,6 +71,7 @@ local steps = {
         assert(list_count == 1)
         assert(screen[2] == real_screen)
         assert(screen[1] == fake_screen)
+        assert(mouse.screen == fake_screen, tostring(mouse.screen))
 
         return true
     end,
@@ -0,0 +1,79 @@
+--- Tests shapes sent as rectangles and the shared client shape masks
+
+local runner = require("_runner")
+local wibox = require("wibox")
+local gshape = require("gears.shape")
+local surface = require("gears.surface")
+local test_client = require("_client")
+
+local function rounded(cr, w, h)
+    gshape.rounded_rect(cr, w, h, 30)
+end
+
+local wb = wibox {
+    x = 0, y = 100, width = 100, height = 100,
+    shape = rounded,
+    visible = true,
+}
+
+local presses = 0
+wb:connect_signal("button::press", function()
+    presses = presses + 1
+end)
+
+local function click(x, y)
+    mouse.coords{x=x, y=y}
+    root.fake_input("button_press", 1)
+    root.fake_input("button_release", 1)
+    awesome.sync()
+end
+
+runner.run_steps{
+    -- The rounded corners are cut out of the rectangles, the middle is not
+    function()
+        click(1, 101)
+        click(98, 198)
+        return true
+    end,
+
+    function()
+        assert(presses == 0, presses)
+        click(50, 150)
+        return true
+    end,
+
+    function()
+        if presses ~= 1 then return end
+        wb.visible = false
+        return true
+    end,
+
+    -- Clients of the same size get the same shape
+    function(count)
+        if count == 1 then
+            test_client("shape1")
+            test_client("shape2")
+        end
+        local cls = client.get()
+        if #cls ~= 2 then return end
+
+        for _, c in ipairs(cls) do
+            c.border_width = 0
+            c:geometry { width = 200, height = 150 }
+            c.shape = rounded
+        end
+        return true
+    end,
+
+    function()
+        for _, c in ipairs(client.get()) do
+            local bounding = surface.load_silently(c.shape_bounding, false)
+            if not bounding then return end
+            local w, h = surface.get_size(bounding)
+            assert(w == 200 and h == 150, w .. "x" .. h)
+        end
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
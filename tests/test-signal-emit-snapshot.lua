@@ -0,0 +1,46 @@
+--- Tests that an emission calls the handlers connected when it started
+
+local runner = require("_runner")
+
+runner.run_steps{
+    function()
+        local calls = {}
+        local second
+        local function first()
+            table.insert(calls, "first")
+            -- Disconnected handlers are still called by this emission
+            awesome.disconnect_signal("test::snapshot", second)
+            second = nil
+            collectgarbage("collect")
+            -- Handlers connected now are only called by the next one
+            awesome.connect_signal("test::snapshot", function()
+                table.insert(calls, "third")
+            end)
+        end
+        second = function()
+            table.insert(calls, "second")
+        end
+
+        awesome.connect_signal("test::snapshot", first)
+        awesome.connect_signal("test::snapshot", second)
+        awesome.emit_signal("test::snapshot")
+        assert(table.concat(calls, ",") == "first,second", table.concat(calls, ","))
+
+        -- Object signals go through the handler list of the object
+        local count = 0
+        local function b() count = count + 1 end
+        local function a()
+            count = count + 1
+            screen[1]:disconnect_signal("test::snapshot", b)
+        end
+        screen[1]:connect_signal("test::snapshot", a)
+        screen[1]:connect_signal("test::snapshot", b)
+        screen[1]:emit_signal("test::snapshot")
+        assert(count == 2, count)
+        screen[1]:disconnect_signal("test::snapshot", a)
+
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
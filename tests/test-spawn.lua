@@ -6,6 +6,7 @@ local spawn = require("awful.spawn")
 local spawns_done = 0
 local async_spawns_done = 0
 local exit_yay, exit_snd = nil, nil
+local pool_done = 0
 
 -- * Using spawn with array is already covered by the test client.
 -- * spawn with startup notification is covered by test-spawn-snid.lua
@@ -51,6 +52,14 @@ local steps = {
                     async_spawns_done = async_spawns_done + 1
                 end
             end)
+            spawn.easy_async({ "sh", "-c", "printf 'a\\nb' ; echo err >&2 ; exit 3" },
+                function(stdout, stderr, reason, code)
+                    assert(stdout == "a\nb\n", stdout)
+                    assert(stderr == "err\n", stderr)
+                    assert(reason == "exit")
+                    assert(code == 3)
+                    async_spawns_done = async_spawns_done + 1
+                end)
             local steps_yay = 0
             spawn.with_line_callback("echo yay", {
                                      stdout = function(line)
@@ -120,10 +129,39 @@ local steps = {
                                      end
                                  })
         end
-        if spawns_done == 3 then
+        if spawns_done == 3 and async_spawns_done == 3 then
             assert(exit_yay == 0)
             assert(exit_snd == 42)
-            assert(async_spawns_done == 2)
+            return true
+        end
+    end,
+
+    function(count)
+        if count == 1 then
+            local pool = spawn.pool { size = 1, timeout = 1 }
+            pool:run("printf 'a\\nb' ; echo err >&2 ; exit 3", function(stdout, stderr, reason, code)
+                assert(stdout == "a\nb\n", stdout)
+                assert(stderr == "err\n", stderr)
+                assert(reason == "exit")
+                assert(code == 3)
+                pool_done = pool_done + 1
+            end)
+            -- Queued behind the first command, and killed after the timeout
+            pool:run("echo slow ; sleep 10", function(stdout, _, reason)
+                assert(pool_done == 1)
+                assert(stdout == "slow\n", stdout)
+                assert(reason == "timeout")
+                pool_done = pool_done + 1
+            end)
+            -- The worker is replaced after it was killed
+            pool:run("cd / ; echo $PWD", function(stdout, _, reason, code)
+                assert(pool_done == 2)
+                assert(stdout == "/\n", stdout)
+                assert(reason == "exit" and code == 0)
+                pool_done = pool_done + 1
+            end)
+        end
+        if pool_done == 3 then
             return true
         end
     end
@@ -0,0 +1,82 @@
+--- Tests titlebars sharing the rendering of a bgimage function
+
+local runner = require("_runner")
+local awful = require("awful")
+local gcolor = require("gears.color")
+local test_client = require("_client")
+
+local renders = 0
+local function bgimage(_, cr)
+    renders = renders + 1
+    cr:set_source_rgb(0, 0.5, 1)
+    cr:paint()
+end
+
+local c1, c2, normal_painter
+local bars = {}
+
+local function add_titlebar(c)
+    c.border_width = 0
+    c:geometry { width = 300 }
+    bars[c] = awful.titlebar(c, {
+        size = 20,
+        bg_normal = "#111111",
+        bg_focus = "#222222",
+        bgimage_normal = bgimage,
+        bgimage_focus = bgimage,
+    })
+end
+
+runner.run_steps{
+    function(count)
+        if count == 1 then
+            awful.titlebar.shared_bgimage = true
+            test_client("titlebar1")
+            test_client("titlebar2")
+        end
+        local cls = client.get()
+        if #cls ~= 2 then return end
+
+        c1, c2 = cls[1], cls[2]
+        add_titlebar(c1)
+        add_titlebar(c2)
+        client.focus = c1
+        return true
+    end,
+
+    -- Give both titlebars the time to be drawn
+    function(count)
+        if count < 3 or renders == 0 then return end
+
+        -- One rendering per focus state at most, not one per titlebar draw
+        assert(renders <= 2, renders)
+        assert(bars[c1].background_color == gcolor("#222222"))
+        assert(bars[c2].background_color == gcolor("#111111"))
+        normal_painter = bars[c2].background_image
+
+        client.focus = c2
+        return true
+    end,
+
+    function()
+        if client.focus ~= c2 then return end
+
+        -- The colors follow the focus and the painters are shared
+        assert(bars[c1].background_color == gcolor("#111111"))
+        assert(bars[c2].background_color == gcolor("#222222"))
+        assert(bars[c1].background_image == normal_painter)
+        assert(bars[c2].background_image ~= normal_painter)
+        return true
+    end,
+
+    function(count)
+        if count < 3 then return end
+
+        -- Both states were rendered before, nothing is rendered again
+        assert(renders <= 2, renders)
+        awful.titlebar.shared_bgimage = false
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -133,6 +133,69 @@ end
 return true
 end)
 
+local backdrop_wibox, old_backdrop, old_backdrop_surface
+table.insert(steps, function()
+    -- The backdrop of a drawable is cached until the wallpaper changes
+    backdrop_wibox = require("wibox") { x = 10, y = 10, width = 20, height = 20 }
+    local d = backdrop_wibox._drawable.drawable
+    old_backdrop = d:backdrop()
+    local second = d:backdrop()
+    assert(old_backdrop and old_backdrop == second)
+    -- Keep a reference so that the old surface stays alive
+    old_backdrop_surface = surface.load_silently(old_backdrop, false)
+    surface.load_silently(second, false)
+
+    wp.set("#123456")
+    return true
+end)
+
+table.insert(steps, function()
+    local new_backdrop = backdrop_wibox._drawable.drawable:backdrop()
+    assert(new_backdrop and new_backdrop ~= old_backdrop)
+    surface.load_silently(new_backdrop, false)
+    return true
+end)
+
+local wallpaper_file = os.tmpname()
+local changes = 0
+table.insert(steps, function()
+    img:write_to_png(wallpaper_file)
+    awesome.connect_signal("wallpaper_changed", function() changes = changes + 1 end)
+
+    -- Only the area of the screen is set
+    wp.maximized(wallpaper_file, screen[1])
+    return true
+end)
+
+table.insert(steps, function()
+    assert(changes == 1, changes)
+
+    -- The same wallpaper is not drawn again, another one is
+    wp.maximized(wallpaper_file, screen[1])
+    wp.centered(wallpaper_file, screen[1], "#00ff00")
+    return true
+end)
+
+table.insert(steps, function()
+    assert(changes == 2, changes)
+    wp.centered(wallpaper_file, screen[1], "#00ff00")
+    return true
+end)
+
+table.insert(steps, function()
+    assert(changes == 2, changes)
+
+    -- Setting all screens forgets what was drawn
+    wp.set("#000000")
+    wp.centered(wallpaper_file, screen[1], "#00ff00")
+    return true
+end)
+
+table.insert(steps, function()
+    assert(changes == 4, changes)
+    os.remove(wallpaper_file)
+    return true
+end)
 
 runner.run_steps(steps)
 
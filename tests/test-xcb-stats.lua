@@ -0,0 +1,63 @@
+--- Tests for awesome.xcb_stats(): count the X round trips of common actions.
+--
+-- The limits are a budget: when a change needs more blocking replies, the
+-- failure lists the places in the code that waited for the X server.
+
+local runner = require("_runner")
+local awful = require("awful")
+local test_client = require("_client")
+
+awesome.set_xcb_tracing(true)
+
+local function assert_round_trips(what, limit)
+    local stats = awesome.xcb_stats(true)
+    assert(stats.enabled)
+    if stats.blocking <= limit then
+        return
+    end
+
+    local lines = {}
+    for _, site in ipairs(stats.sites) do
+        if site.blocking > 0 then
+            table.insert(lines, string.format("  %s at %s: %d", site.request,
+                                              site.location, site.blocking))
+        end
+    end
+    error(string.format("%s needed %d round trips, expected at most %d:\n%s",
+                        what, stats.blocking, limit, table.concat(lines, "\n")))
+end
+
+local steps = {
+    function(count)
+        if count == 1 then
+            awesome.xcb_stats(true)
+            test_client("xcb_stats")
+        elseif #client.get() > 0 then
+            assert_round_trips("Managing a client", 16)
+            return true
+        end
+    end,
+
+    function()
+        awful.tag.viewnext()
+        awful.tag.viewprev()
+        awesome.emit_signal("refresh")
+        assert_round_trips("Switching tags", 2)
+        return true
+    end,
+
+    function()
+        local c = client.get()[1]
+        client.focus = nil
+        awesome.emit_signal("refresh")
+        client.focus = c
+        awesome.emit_signal("refresh")
+        assert(client.focus == c)
+        assert_round_trips("Focusing a client", 2)
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
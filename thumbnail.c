@@ -0,0 +1,405 @@
+/*
+ * thumbnail.c - client thumbnails
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Thumbnails are small copies of the content of client windows, for task
+ * switchers and overviews.
+ *
+ * The client window is redirected with Composite, which has no visible effect
+ * with automatic redirection, and the pixmap holding its content is named.
+ * A Damage object reports the parts of the window that change. At most
+ * thumbnail_rate times per second, only these parts are scaled down into the
+ * thumbnail. All of this happens in the X server, so the content of the
+ * window is never copied to awesome.
+ *
+ * The pixmap is only named after the first damage was reported, because
+ * naming the pixmap of a window which is not viewable fails. The window gets
+ * a new pixmap when it becomes viewable again, so the named one is released
+ * when the client is banned or minimized and the next damage names the new
+ * one. The thumbnail itself is kept meanwhile.
+ */
+
+#include "thumbnail.h"
+#include "globalconf.h"
+#include "objects/client.h"
+
+#include <math.h>
+#include <cairo-xcb.h>
+#include <xcb/composite.h>
+
+struct client_thumbnail_t
+{
+    /** The maximum width and height of the thumbnail */
+    int size;
+    /** The damage object of the window */
+    xcb_damage_damage_t damage;
+    /** The named pixmap of the window and a surface for it, or XCB_NONE */
+    xcb_pixmap_t pixmap;
+    cairo_surface_t *source;
+    /** The size of the window when the pixmap was named */
+    int width, height;
+    /** The thumbnail, or NULL until it is first drawn */
+    cairo_surface_t *surface;
+    /** The scale from the window to the thumbnail */
+    double scale;
+    /** The part of the window damaged since the thumbnail was drawn */
+    area_t damaged;
+    /** Does the thumbnail have to be drawn? */
+    bool dirty;
+};
+
+/** Minimum time between two updates of the thumbnails, in milliseconds */
+static guint thumbnail_interval = 100;
+/** The timeout updating the thumbnails, or 0 */
+static guint thumbnail_source;
+
+/** Check for the Composite and Damage extensions.
+ */
+void
+thumbnail_init(void)
+{
+    xcb_connection_t *conn = globalconf.connection;
+    const xcb_query_extension_reply_t *composite =
+        xcb_get_extension_data(conn, &xcb_composite_id);
+    const xcb_query_extension_reply_t *damage =
+        xcb_get_extension_data(conn, &xcb_damage_id);
+
+    if (!composite || !composite->present || !damage || !damage->present)
+        return;
+
+    /* Both extensions must be told which version we speak */
+    xcb_composite_query_version_cookie_t composite_c =
+        xcb_composite_query_version_unchecked(conn, 0, 2);
+    xcb_damage_query_version_cookie_t damage_c =
+        xcb_damage_query_version_unchecked(conn, 1, 1);
+    xcb_composite_query_version_reply_t *composite_r =
+        xcb_composite_query_version_reply(conn, composite_c, NULL);
+    xcb_damage_query_version_reply_t *damage_r =
+        xcb_damage_query_version_reply(conn, damage_c, NULL);
+
+    /* NameWindowPixmap is new in Composite 0.2 */
+    globalconf.have_composite = composite_r && damage_r
+        && (composite_r->major_version > 0 || composite_r->minor_version >= 2);
+
+    p_delete(&composite_r);
+    p_delete(&damage_r);
+}
+
+/** Set how often thumbnails are updated at most.
+ * \param rate The number of updates per second.
+ */
+void
+thumbnail_set_rate(int rate)
+{
+    thumbnail_interval = MAX(1, 1000 / rate);
+}
+
+static void
+thumbnail_window_size(client_t *c, int *width, int *height)
+{
+    /* Just the client size without decorations, like client.content */
+    *width = c->geometry.width
+        - c->titlebar[CLIENT_TITLEBAR_LEFT].size - c->titlebar[CLIENT_TITLEBAR_RIGHT].size;
+    *height = c->geometry.height
+        - c->titlebar[CLIENT_TITLEBAR_TOP].size - c->titlebar[CLIENT_TITLEBAR_BOTTOM].size;
+}
+
+static void
+thumbnail_release_pixmap(client_thumbnail_t *t)
+{
+    if (t->source)
+    {
+        cairo_surface_finish(t->source);
+        cairo_surface_destroy(t->source);
+        t->source = NULL;
+    }
+    if (t->pixmap != XCB_NONE)
+    {
+        xcb_free_pixmap(globalconf.connection, t->pixmap);
+        t->pixmap = XCB_NONE;
+    }
+}
+
+static void
+thumbnail_release_surface(client_thumbnail_t *t)
+{
+    if (t->surface)
+    {
+        cairo_surface_destroy(t->surface);
+        t->surface = NULL;
+    }
+}
+
+/** Name the pixmap of the window, unless the named one is still current.
+ * The window gets a new pixmap whenever it is resized.
+ */
+static void
+thumbnail_name_pixmap(client_t *c)
+{
+    client_thumbnail_t *t = c->thumbnail;
+    int width, height;
+
+    thumbnail_window_size(c, &width, &height);
+    if (t->source && t->width == width && t->height == height)
+        return;
+    if (c->minimized || c->isbanned || width <= 0 || height <= 0)
+        return;
+
+    thumbnail_release_pixmap(t);
+    t->pixmap = xcb_generate_id(globalconf.connection);
+    xcb_composite_name_window_pixmap(globalconf.connection, c->window, t->pixmap);
+    t->source = cairo_xcb_surface_create(globalconf.connection, t->pixmap,
+                                         c->visualtype, width, height);
+
+    /* The scale changed, so the whole thumbnail has to be drawn again */
+    if (t->width != width || t->height != height)
+        thumbnail_release_surface(t);
+    t->width = width;
+    t->height = height;
+}
+
+/** Draw the damaged part of a thumbnail.
+ */
+static void
+thumbnail_draw(client_t *c)
+{
+    client_thumbnail_t *t = c->thumbnail;
+    area_t damaged = t->damaged;
+
+    thumbnail_name_pixmap(c);
+    if (!t->source)
+    {
+        /* Not viewable, thumbnail_map() draws it again once it is */
+        xcb_damage_subtract(globalconf.connection, t->damage, XCB_NONE, XCB_NONE);
+        t->damaged = (area_t) { .x = 0, .y = 0, .width = 0, .height = 0 };
+        t->dirty = false;
+        return;
+    }
+
+    if (!t->surface)
+    {
+        t->scale = MIN(1.0, MIN((double) t->size / t->width, (double) t->size / t->height));
+        t->surface = cairo_surface_create_similar(t->source,
+                                                  cairo_surface_get_content(t->source),
+                                                  MAX(1, lround(t->width * t->scale)),
+                                                  MAX(1, lround(t->height * t->scale)));
+        damaged = (area_t) { .x = 0, .y = 0, .width = t->width, .height = t->height };
+    }
+
+    /* Damage is only reported again once it was subtracted. This has to
+     * happen before drawing, or damage in between would be lost. */
+    xcb_damage_subtract(globalconf.connection, t->damage, XCB_NONE, XCB_NONE);
+    t->damaged = (area_t) { .x = 0, .y = 0, .width = 0, .height = 0 };
+    t->dirty = false;
+
+    /* The damaged part of the thumbnail, with a pixel more for the filter */
+    double x1 = floor(AREA_LEFT(damaged) * t->scale) - 1;
+    double y1 = floor(AREA_TOP(damaged) * t->scale) - 1;
+    double x2 = ceil(AREA_RIGHT(damaged) * t->scale) + 1;
+    double y2 = ceil(AREA_BOTTOM(damaged) * t->scale) + 1;
+
+    cairo_t *cr = cairo_create(t->surface);
+    cairo_rectangle(cr, x1, y1, x2 - x1, y2 - y1);
+    cairo_clip(cr);
+    cairo_scale(cr, t->scale, t->scale);
+    cairo_set_source_surface(cr, t->source, 0, 0);
+    /* The X server can only do bilinear filtering, better filters would read
+     * the whole window back to awesome */
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_BILINEAR);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+    cairo_surface_flush(t->surface);
+}
+
+static gboolean
+thumbnail_update(gpointer data)
+{
+    lua_State *L = globalconf_get_lua_State();
+    int count = 0;
+
+    thumbnail_source = 0;
+
+    /* The clients stay on the stack, so that Lua code run by the signals
+     * cannot free them */
+    luaL_checkstack(L, globalconf.clients.len, "too many thumbnails");
+    foreach(_c, globalconf.clients)
+    {
+        client_t *c = *_c;
+        if (!c->thumbnail || !c->thumbnail->dirty)
+            continue;
+        thumbnail_draw(c);
+        luaA_object_push(L, c);
+        count++;
+    }
+    xcb_flush(globalconf.connection);
+
+    for (int i = count; i > 0; i--)
+        luaA_object_emit_signal(L, -i, "property::thumbnail", 0);
+    lua_pop(L, count);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+thumbnail_schedule(void)
+{
+    if (!thumbnail_source)
+        thumbnail_source = g_timeout_add(thumbnail_interval, thumbnail_update, NULL);
+}
+
+void
+thumbnail_handle_damage(xcb_damage_notify_event_t *ev)
+{
+    client_t *c = client_getbywin(ev->drawable);
+    if (!c || !c->thumbnail || c->thumbnail->damage != ev->damage)
+        return;
+
+    client_thumbnail_t *t = c->thumbnail;
+    area_t area = { .x = ev->area.x, .y = ev->area.y,
+                    .width = ev->area.width, .height = ev->area.height };
+
+    if (t->damaged.width == 0 || t->damaged.height == 0)
+        t->damaged = area;
+    else
+    {
+        int x1 = MIN(AREA_LEFT(t->damaged), AREA_LEFT(area));
+        int y1 = MIN(AREA_TOP(t->damaged), AREA_TOP(area));
+        int x2 = MAX(AREA_RIGHT(t->damaged), AREA_RIGHT(area));
+        int y2 = MAX(AREA_BOTTOM(t->damaged), AREA_BOTTOM(area));
+        t->damaged = (area_t) { .x = x1, .y = y1, .width = x2 - x1, .height = y2 - y1 };
+    }
+    t->dirty = true;
+    thumbnail_schedule();
+}
+
+/** Set the size of the thumbnail of a client.
+ * \param c The client.
+ * \param size The maximum width and height of the thumbnail, or 0 to stop
+ * updating it.
+ * \return False if thumbnails are not supported by the X server.
+ */
+bool
+thumbnail_set_size(client_t *c, int size)
+{
+    client_thumbnail_t *t = c->thumbnail;
+
+    if (size <= 0)
+    {
+        thumbnail_wipe(c, true);
+        return true;
+    }
+    if (!globalconf.have_composite)
+        return false;
+
+    if (!t)
+    {
+        t = c->thumbnail = p_new(client_thumbnail_t, 1);
+        /* Automatic redirection changes nothing visible. The damage object
+         * reports the whole window right away if it is viewable. */
+        xcb_composite_redirect_window(globalconf.connection, c->window,
+                                      XCB_COMPOSITE_REDIRECT_AUTOMATIC);
+        t->damage = xcb_generate_id(globalconf.connection);
+        xcb_damage_create(globalconf.connection, t->damage, c->window,
+                          XCB_DAMAGE_REPORT_LEVEL_BOUNDING_BOX);
+    }
+
+    if (t->size != size)
+    {
+        t->size = size;
+        thumbnail_release_surface(t);
+        /* Without a pixmap, the window was not viewable yet */
+        if (t->source)
+        {
+            t->dirty = true;
+            thumbnail_schedule();
+        }
+    }
+    return true;
+}
+
+int
+thumbnail_get_size(client_t *c)
+{
+    return c->thumbnail ? c->thumbnail->size : 0;
+}
+
+/** Get the thumbnail of a client.
+ * \param c The client.
+ * \return The thumbnail, or NULL if it was not drawn yet.
+ */
+cairo_surface_t *
+thumbnail_get_surface(client_t *c)
+{
+    return c->thumbnail ? c->thumbnail->surface : NULL;
+}
+
+/** Release the named pixmap of a client whose window is no longer viewable.
+ * \param c The client.
+ */
+void
+thumbnail_unmap(client_t *c)
+{
+    if (c->thumbnail)
+        thumbnail_release_pixmap(c->thumbnail);
+}
+
+/** Draw the whole thumbnail of a client whose window became viewable again.
+ * \param c The client.
+ */
+void
+thumbnail_map(client_t *c)
+{
+    client_thumbnail_t *t = c->thumbnail;
+    int width, height;
+    if (!t)
+        return;
+
+    thumbnail_window_size(c, &width, &height);
+    if (width <= 0 || height <= 0)
+        return;
+    t->damaged = (area_t) { .x = 0, .y = 0, .width = width, .height = height };
+    t->dirty = true;
+    thumbnail_schedule();
+}
+
+/** Stop updating the thumbnail of a client and free it.
+ * \param c The client.
+ * \param window_valid Does the window still exist?
+ */
+void
+thumbnail_wipe(client_t *c, bool window_valid)
+{
+    client_thumbnail_t *t = c->thumbnail;
+    if (!t)
+        return;
+
+    if (window_valid)
+    {
+        xcb_damage_destroy(globalconf.connection, t->damage);
+        xcb_composite_unredirect_window(globalconf.connection, c->window,
+                                        XCB_COMPOSITE_REDIRECT_AUTOMATIC);
+    }
+    thumbnail_release_pixmap(t);
+    thumbnail_release_surface(t);
+    p_delete(&c->thumbnail);
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,43 @@
+/*
+ * thumbnail.h - client thumbnails header
+ *
+ * Copyright © 2026 awesome contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_THUMBNAIL_H
+#define AWESOME_THUMBNAIL_H
+
+#include <stdbool.h>
+#include <cairo.h>
+#include <xcb/damage.h>
+
+typedef struct client_t client_t;
+typedef struct client_thumbnail_t client_thumbnail_t;
+
+void thumbnail_init(void);
+void thumbnail_set_rate(int);
+bool thumbnail_set_size(client_t *, int);
+int thumbnail_get_size(client_t *);
+cairo_surface_t *thumbnail_get_surface(client_t *);
+void thumbnail_map(client_t *);
+void thumbnail_unmap(client_t *);
+void thumbnail_wipe(client_t *, bool);
+void thumbnail_handle_damage(xcb_damage_notify_event_t *);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
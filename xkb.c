@@ -29,6 +29,8 @@
 #include "objects/client.h"
 #include "common/atoms.h"
 
+#include <glib.h>
+
 #include <xcb/xkb.h>
 #include <xkbcommon/xkbcommon.h>
 #include <xkbcommon/xkbcommon-x11.h>
@@ -185,10 +187,175 @@ fill_rmlvo_from_root(struct xkb_rule_names *xkb_names)
     return true;
 }
 
+/** Number of compiled keymaps kept around by xkb_keymap_cache_get() */
+#define XKB_KEYMAP_CACHE_SIZE 4
+
+/** Time in microseconds to wait after the last keymap change before the
+ * keymap is reloaded, so that bursts of notifications cause one reload. */
+#define XKB_RELOAD_DEBOUNCE 20000
+
+/** A compiled keymap and what it was compiled for */
+typedef struct
+{
+    struct xkb_rule_names names;
+    int32_t device_id;
+    struct xkb_keymap *keymap;
+} xkb_keymap_cache_entry_t;
+
+/** Keymaps compiled for a keyboard, most recently used first */
+static xkb_keymap_cache_entry_t xkb_keymap_cache[XKB_KEYMAP_CACHE_SIZE];
+
+/** Was a keymap changed by a MapNotify, or its keycodes by a
+ * NewKeyboardNotify, since the last reload? Such a keymap may differ from
+ * what its RMLVO names describe (e.g. after xmodmap, or for another keyboard
+ * behind the same core keyboard device). */
+static bool xkb_keymap_modified;
+
+/** When the last keymap change was seen */
+static int64_t xkb_reload_requested;
+/** The timeout waking up the main loop once the debounce time is over */
+static guint xkb_reload_timeout_id;
+
+static void
+xkb_rule_names_wipe(struct xkb_rule_names *names)
+{
+    p_delete(&names->rules);
+    p_delete(&names->model);
+    p_delete(&names->layout);
+    p_delete(&names->variant);
+    p_delete(&names->options);
+}
+
+static void
+xkb_keymap_cache_entry_wipe(xkb_keymap_cache_entry_t *entry)
+{
+    xkb_rule_names_wipe(&entry->names);
+    xkb_keymap_unref(entry->keymap);
+    p_clear(entry, 1);
+}
+
+/** Remove all keymaps from the cache. */
+static void
+xkb_keymap_cache_wipe(void)
+{
+    for(int i = 0; i < XKB_KEYMAP_CACHE_SIZE; i++)
+        if(xkb_keymap_cache[i].keymap)
+            xkb_keymap_cache_entry_wipe(&xkb_keymap_cache[i]);
+}
+
+/** Find the index of a cache entry.
+ * \return The index, or -1.
+ */
+static int
+xkb_keymap_cache_find(struct xkb_rule_names *names, int32_t device_id)
+{
+    for(int i = 0; i < XKB_KEYMAP_CACHE_SIZE; i++)
+    {
+        xkb_keymap_cache_entry_t *entry = &xkb_keymap_cache[i];
+        if(entry->keymap && entry->device_id == device_id
+           && A_STREQ(entry->names.rules, names->rules)
+           && A_STREQ(entry->names.model, names->model)
+           && A_STREQ(entry->names.layout, names->layout)
+           && A_STREQ(entry->names.variant, names->variant)
+           && A_STREQ(entry->names.options, names->options))
+            return i;
+    }
+    return -1;
+}
+
+/** Move a cache entry to the front, dropping the last entry if needed.
+ * \param idx The index of the entry, or -1 to make room for a new one.
+ * \return The front entry.
+ */
+static xkb_keymap_cache_entry_t *
+xkb_keymap_cache_to_front(int idx)
+{
+    if(idx < 0)
+    {
+        idx = XKB_KEYMAP_CACHE_SIZE - 1;
+        if(xkb_keymap_cache[idx].keymap)
+            xkb_keymap_cache_entry_wipe(&xkb_keymap_cache[idx]);
+    }
+    xkb_keymap_cache_entry_t entry = xkb_keymap_cache[idx];
+    memmove(&xkb_keymap_cache[1], &xkb_keymap_cache[0], idx * sizeof(entry));
+    xkb_keymap_cache[0] = entry;
+    return &xkb_keymap_cache[0];
+}
+
+/** Compile the keymap of a keyboard.
+ * \param device_id The XKB device, or -1 to use the RMLVO names.
+ * \param names The RMLVO names from the root window.
+ * \return A new reference to the keymap.
+ */
+static struct xkb_keymap *
+xkb_keymap_compile(int32_t device_id, struct xkb_rule_names *names)
+{
+    struct xkb_keymap *xkb_keymap;
+
+    if (device_id != -1)
+    {
+        xkb_keymap = xkb_x11_keymap_new_from_device(globalconf.xkb_ctx,
+                                                    globalconf.connection,
+                                                    device_id,
+                                                    XKB_KEYMAP_COMPILE_NO_FLAGS);
+        if (!xkb_keymap)
+            fatal("Failed while getting XKB keymap from device");
+    }
+    else
+        xkb_keymap = xkb_keymap_new_from_names(globalconf.xkb_ctx, names, 0);
+
+    return xkb_keymap;
+}
+
+/** Get the keymap of a keyboard, compiling it unless it is in the cache.
+ * \param device_id The XKB device, or -1.
+ * \param use_cache False if the server's keymap may not match its names.
+ * \return A new reference to the keymap.
+ */
+static struct xkb_keymap *
+xkb_keymap_cache_get(int32_t device_id, bool use_cache)
+{
+    struct xkb_rule_names names = { NULL, NULL, NULL, NULL, NULL };
+    if (!fill_rmlvo_from_root(&names))
+    {
+        if (device_id == -1)
+            warn("Could not get _XKB_RULES_NAMES from root window, falling back to defaults.");
+        else
+            /* Without names there is nothing to tell keymaps apart */
+            use_cache = false;
+    }
+
+    int idx = xkb_keymap_cache_find(&names, device_id);
+    if (use_cache && idx >= 0)
+    {
+        xkb_rule_names_wipe(&names);
+        return xkb_keymap_ref(xkb_keymap_cache_to_front(idx)->keymap);
+    }
+
+    struct xkb_keymap *xkb_keymap = xkb_keymap_compile(device_id, &names);
+
+    /* A keymap which may not match its names must not be found later */
+    if (!use_cache)
+    {
+        if (idx >= 0)
+            xkb_keymap_cache_entry_wipe(&xkb_keymap_cache[idx]);
+        xkb_rule_names_wipe(&names);
+        return xkb_keymap;
+    }
+
+    xkb_keymap_cache_entry_t *entry = xkb_keymap_cache_to_front(idx);
+    entry->names = names;
+    entry->device_id = device_id;
+    entry->keymap = xkb_keymap_ref(xkb_keymap);
+    return xkb_keymap;
+}
+
 /** Fill globalconf.xkb_state based on connection and context
+ * \param use_cache False if the keymap may not match its RMLVO names.
+ * \return False if the keymap did not change and the state was kept.
 */
-static void
-xkb_fill_state(void)
+static bool
+xkb_fill_state(bool use_cache)
 {
     xcb_connection_t *conn = globalconf.connection;
 
@@ -200,49 +367,35 @@ xkb_fill_state(void)
             warn("Failed while getting XKB device id");
     }
 
-    if (device_id != -1)
-    {
-        struct xkb_keymap *xkb_keymap = xkb_x11_keymap_new_from_device(
-                                    globalconf.xkb_ctx,
-                                    conn,
-                                    device_id,
-                                    XKB_KEYMAP_COMPILE_NO_FLAGS);
-
+    struct xkb_keymap *xkb_keymap = xkb_keymap_cache_get(device_id, use_cache);
 
-        if (!xkb_keymap)
-            fatal("Failed while getting XKB keymap from device");
+    /* The same keymap as before: the current state is still up to date */
+    if (globalconf.xkb_state && xkb_state_get_keymap(globalconf.xkb_state) == xkb_keymap)
+    {
+        xkb_keymap_unref(xkb_keymap);
+        return false;
+    }
 
+    xkb_state_unref(globalconf.xkb_state);
+    if (device_id != -1)
+    {
         globalconf.xkb_state = xkb_x11_state_new_from_device(xkb_keymap,
                                                              conn,
                                                              device_id);
         if (!globalconf.xkb_state)
             fatal("Failed while getting XKB state from device");
-
-        /* xkb_keymap is no longer referenced directly; decreasing refcount */
-        xkb_keymap_unref(xkb_keymap);
     }
     else
     {
-        struct xkb_rule_names names = { NULL, NULL, NULL, NULL, NULL };
-        if (!fill_rmlvo_from_root(&names))
-            warn("Could not get _XKB_RULES_NAMES from root window, falling back to defaults.");
-
-        struct xkb_keymap *xkb_keymap = xkb_keymap_new_from_names(globalconf.xkb_ctx, &names, 0);
-
         globalconf.xkb_state = xkb_state_new(xkb_keymap);
         if (!globalconf.xkb_state)
             fatal("Failed while creating XKB state");
-
-        /* xkb_keymap is no longer referenced directly; decreasing refcount */
-        xkb_keymap_unref(xkb_keymap);
-        p_delete(&names.rules);
-        p_delete(&names.model);
-        p_delete(&names.layout);
-        p_delete(&names.variant);
-        p_delete(&names.options);
     }
-}
 
+    /* xkb_keymap is no longer referenced directly; decreasing refcount */
+    xkb_keymap_unref(xkb_keymap);
+    return true;
+}
 
 /** Loads xkb context, state and keymap to globalconf.
  * These variables should be freed by xkb_free_keymap() afterwards
@@ -254,7 +407,8 @@ xkb_init_keymap(void)
     if (!globalconf.xkb_ctx)
         fatal("Failed while getting XKB context");
 
-    xkb_fill_state();
+    globalconf.xkb_state = NULL;
+    xkb_fill_state(true);
 }
 
 /** Frees xkb context, state and keymap from globalconf.
@@ -264,6 +418,7 @@ static void
 xkb_free_keymap(void)
 {
     xkb_state_unref(globalconf.xkb_state);
+    xkb_keymap_cache_wipe();
     xkb_context_unref(globalconf.xkb_ctx);
 }
 
@@ -276,12 +431,18 @@ xkb_reload_keymap(void)
 {
     assert(globalconf.have_xkb);
 
-    xkb_state_unref(globalconf.xkb_state);
-    xkb_fill_state();
+    bool use_cache = !xkb_keymap_modified;
+    xkb_keymap_modified = false;
+
+    /* Nothing to do when e.g. the same keyboard was plugged in again */
+    if (!xkb_fill_state(use_cache))
+        return;
 
     /* Free and then allocate the key symbols */
     xcb_key_symbols_free(globalconf.keysyms);
     globalconf.keysyms = xcb_key_symbols_alloc(globalconf.connection);
+    /* The keycodes of the key bindings may have changed */
+    globalconf.bindings_generation++;
 
     /* Regrab key bindings on the root window */
     xcb_screen_t *s = globalconf.screen;
@@ -291,19 +452,39 @@ xkb_reload_keymap(void)
     foreach(_c, globalconf.clients)
     {
         client_t *c = *_c;
-        xwindow_grabkeys(c->window, &c->keys);
+        xwindow_grabkeys(c->window, key_set_items(c->keys));
         if (c->nofocus_window)
-            xwindow_grabkeys(c->nofocus_window, &c->keys);
+            xwindow_grabkeys(c->nofocus_window, key_set_items(c->keys));
     }
 }
 
+static gboolean
+xkb_reload_timeout(gpointer data)
+{
+    xkb_reload_timeout_id = 0;
+    return FALSE;
+}
+
 void
 xkb_refresh(void)
 {
     lua_State *L = globalconf_get_lua_State();
 
+    /* Wait until a burst of keymap changes is over */
     if (globalconf.xkb_reload_keymap)
+    {
+        int64_t wait = xkb_reload_requested + XKB_RELOAD_DEBOUNCE - g_get_monotonic_time();
+        if (wait > 0)
+        {
+            if (!xkb_reload_timeout_id)
+                xkb_reload_timeout_id = g_timeout_add(wait / 1000 + 1, xkb_reload_timeout, NULL);
+            if (globalconf.xkb_group_changed)
+                signal_object_emit(L, &global_signals, "xkb::group_changed", 0);
+            globalconf.xkb_group_changed = false;
+            return;
+        }
         xkb_reload_keymap();
+    }
     if (globalconf.xkb_map_changed)
           signal_object_emit(L, &global_signals, "xkb::map_changed", 0);
     if (globalconf.xkb_group_changed)
@@ -332,15 +513,21 @@ event_handle_xkb_notify(xcb_generic_event_t* event)
           xcb_xkb_new_keyboard_notify_event_t *new_keyboard_event = (void*)event;
 
           globalconf.xkb_reload_keymap = true;
+          xkb_reload_requested = g_get_monotonic_time();
 
           if (new_keyboard_event->changed & XCB_XKB_NKN_DETAIL_KEYCODES)
+          {
               globalconf.xkb_map_changed = true;
+              xkb_keymap_modified = true;
+          }
           break;
         }
       case XCB_XKB_MAP_NOTIFY:
         {
           globalconf.xkb_reload_keymap = true;
           globalconf.xkb_map_changed = true;
+          xkb_keymap_modified = true;
+          xkb_reload_requested = g_get_monotonic_time();
           break;
         }
       case XCB_XKB_STATE_NOTIFY:
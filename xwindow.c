@@ -21,6 +21,7 @@
 
 #include "xwindow.h"
 #include "common/atoms.h"
+#include "common/hash.h"
 #include "objects/button.h"
 
 #include <xcb/xcb.h>
@@ -30,6 +31,9 @@
 /** Mask shorthands */
 #define BUTTONMASK     (XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE)
 
+/** Maximum number of rectangles for sending a shape without a pixmap */
+#define SHAPE_MAX_RECTANGLES 256
+
 /** Set client state (WM_STATE) property.
  * \param win The window to set state.
  * \param state The state to set.
@@ -118,37 +122,203 @@ xwindow_buttons_grab(xcb_window_t win, button_array_t *buttons)
                         (*b)->button, (*b)->modifiers);
 }
 
-/** Grab key on a window.
+/** A set of passive key grabs. Windows with the same keys share one set. */
+typedef struct
+{
+    int refcount;
+    /** Sorted, distinct keycode << 16 | modifiers values */
+    uint32_t *grabs;
+    int len;
+} xwindow_key_grabs_t;
+
+#define KEY_GRAB(keycode, modifiers) ((uint32_t) (keycode) << 16 | (modifiers))
+#define KEY_GRAB_KEYCODE(grab) ((xcb_keycode_t) ((grab) >> 16))
+#define KEY_GRAB_MODIFIERS(grab) ((uint16_t) (grab))
+
+static void
+xwindow_key_grabs_unref(xwindow_key_grabs_t **grabs)
+{
+    if(*grabs && --(*grabs)->refcount == 0)
+    {
+        p_delete(&(*grabs)->grabs);
+        p_delete(grabs);
+    }
+    *grabs = NULL;
+}
+
+DO_HASH(xcb_window_t, xwindow_key_grabs_t *, xwindow_key_grabs, a_inthash, a_inteq)
+
+/** The key grabs currently set on each window */
+static xwindow_key_grabs_hash_t window_key_grabs;
+
+/** The last computed set of grabs, reused for windows with the same keys */
+static struct
+{
+    keyb_t **keys;
+    int len;
+    unsigned int generation;
+    xwindow_key_grabs_t *grabs;
+} last_key_grabs;
+
+static int
+xwindow_key_grab_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static void
+xwindow_key_grabs_add(uint32_t **grabs, int *len, int *size, uint32_t grab)
+{
+    if(*len == *size)
+    {
+        *size = *size ? *size * 2 : 16;
+        p_realloc(grabs, *size);
+    }
+    (*grabs)[(*len)++] = grab;
+}
+
+/** Get the grabs needed for some keys.
+ * \param keys The keys.
+ * \return A new reference to the set of grabs.
+ */
+static xwindow_key_grabs_t *
+xwindow_key_grabs_get(key_array_t *keys)
+{
+    if(last_key_grabs.grabs
+       && last_key_grabs.generation == globalconf.bindings_generation
+       && last_key_grabs.len == keys->len
+       && !memcmp(last_key_grabs.keys, keys->tab, keys->len * sizeof(*keys->tab)))
+    {
+        last_key_grabs.grabs->refcount++;
+        return last_key_grabs.grabs;
+    }
+
+    xwindow_key_grabs_t *grabs = p_new(xwindow_key_grabs_t, 1);
+    int size = 0;
+
+    foreach(_k, *keys)
+    {
+        keyb_t *k = *_k;
+        if(k->keycode)
+            xwindow_key_grabs_add(&grabs->grabs, &grabs->len, &size,
+                                  KEY_GRAB(k->keycode, k->modifiers));
+        else if(k->keysym)
+        {
+            xcb_keycode_t *keycodes = xcb_key_symbols_get_keycode(globalconf.keysyms, k->keysym);
+            if(keycodes)
+            {
+                for(xcb_keycode_t *kc = keycodes; *kc; kc++)
+                    xwindow_key_grabs_add(&grabs->grabs, &grabs->len, &size,
+                                          KEY_GRAB(*kc, k->modifiers));
+                p_delete(&keycodes);
+            }
+        }
+    }
+
+    if(grabs->len)
+        qsort(grabs->grabs, grabs->len, sizeof(*grabs->grabs), xwindow_key_grab_cmp);
+    int len = 0;
+    for(int i = 0; i < grabs->len; i++)
+        if(len == 0 || grabs->grabs[len - 1] != grabs->grabs[i])
+            grabs->grabs[len++] = grabs->grabs[i];
+    grabs->len = len;
+    grabs->refcount = 2;
+
+    xwindow_key_grabs_unref(&last_key_grabs.grabs);
+    p_delete(&last_key_grabs.keys);
+    last_key_grabs.keys = p_dup(keys->tab, keys->len);
+    last_key_grabs.len = keys->len;
+    last_key_grabs.generation = globalconf.bindings_generation;
+    last_key_grabs.grabs = grabs;
+
+    return grabs;
+}
+
+static bool
+xwindow_key_grabs_contains(xwindow_key_grabs_t *grabs, uint32_t grab)
+{
+    return bsearch(&grab, grabs->grabs, grabs->len, sizeof(*grabs->grabs),
+                   xwindow_key_grab_cmp) != NULL;
+}
+
+/** Change the passive key grabs of a window from one set to another.
  * \param win The window.
- * \param k The key.
+ * \param from The grabs currently set.
+ * \param to The wanted grabs.
  */
 static void
-xwindow_grabkey(xcb_window_t win, keyb_t *k)
+xwindow_key_grabs_update(xcb_window_t win, xwindow_key_grabs_t *from, xwindow_key_grabs_t *to)
 {
-    if(k->keycode)
-        xcb_grab_key(globalconf.connection, true, win,
-                     k->modifiers, k->keycode, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-    else if(k->keysym)
-    {
-        xcb_keycode_t *keycodes = xcb_key_symbols_get_keycode(globalconf.keysyms, k->keysym);
-        if(keycodes)
+    /* Ungrabbing a key also affects grabs of the same key with AnyModifier
+     * or, for AnyModifier, with all other modifiers. Grab everything again
+     * for keys that were ungrabbed. */
+    bool touched[256] = { false };
+
+    for(int i = 0; i < from->len; i++)
+        if(!xwindow_key_grabs_contains(to, from->grabs[i]))
         {
-            for(xcb_keycode_t *kc = keycodes; *kc; kc++)
-                xcb_grab_key(globalconf.connection, true, win,
-                             k->modifiers, *kc, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-            p_delete(&keycodes);
+            xcb_keycode_t keycode = KEY_GRAB_KEYCODE(from->grabs[i]);
+            xcb_ungrab_key(globalconf.connection, keycode, win,
+                           KEY_GRAB_MODIFIERS(from->grabs[i]));
+            touched[keycode] = true;
         }
+
+    for(int i = 0; i < to->len; i++)
+    {
+        xcb_keycode_t keycode = KEY_GRAB_KEYCODE(to->grabs[i]);
+        if(touched[keycode] || !xwindow_key_grabs_contains(from, to->grabs[i]))
+            xcb_grab_key(globalconf.connection, true, win,
+                         KEY_GRAB_MODIFIERS(to->grabs[i]), keycode,
+                         XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
     }
 }
 
+/** Set the passive key grabs of a window.
+ * Only the difference to the grabs currently set is sent to the X server.
+ * \param win The window.
+ * \param keys The keys to grab.
+ */
 void
 xwindow_grabkeys(xcb_window_t win, key_array_t *keys)
 {
-    /* Ungrab everything first */
-    xcb_ungrab_key(globalconf.connection, XCB_GRAB_ANY, win, XCB_BUTTON_MASK_ANY);
+    xwindow_key_grabs_t *grabs = xwindow_key_grabs_get(keys);
+    xwindow_key_grabs_t **current = xwindow_key_grabs_hash_lookup(&window_key_grabs, win);
+
+    if(!current)
+    {
+        /* We don't know what is grabbed, ungrab everything first */
+        xcb_ungrab_key(globalconf.connection, XCB_GRAB_ANY, win, XCB_BUTTON_MASK_ANY);
+
+        for(int i = 0; i < grabs->len; i++)
+            xcb_grab_key(globalconf.connection, true, win,
+                         KEY_GRAB_MODIFIERS(grabs->grabs[i]),
+                         KEY_GRAB_KEYCODE(grabs->grabs[i]),
+                         XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+        xwindow_key_grabs_hash_insert(&window_key_grabs, win, grabs);
+        return;
+    }
+
+    if(*current != grabs)
+        xwindow_key_grabs_update(win, *current, grabs);
+    xwindow_key_grabs_unref(current);
+    *current = grabs;
+}
 
-    foreach(k, *keys)
-        xwindow_grabkey(win, *k);
+/** Forget the key grabs of a window, e.g. because it is being destroyed.
+ * The next xwindow_grabkeys() call for it will start from scratch.
+ * \param win The window.
+ */
+void
+xwindow_grabkeys_forget(xcb_window_t win)
+{
+    xwindow_key_grabs_t **current = xwindow_key_grabs_hash_lookup(&window_key_grabs, win);
+
+    if(current)
+    {
+        xwindow_key_grabs_unref(current);
+        xwindow_key_grabs_hash_remove(&window_key_grabs, win);
+    }
 }
 
 /** Send a request for a window's opacity.
@@ -375,6 +545,92 @@ xwindow_shape_pixmap(int width, int height, cairo_surface_t *surf)
     return pixmap;
 }
 
+/** Get a pixel of a row of an A1 image surface */
+static inline bool
+xwindow_shape_bit(const uint32_t *row, int x)
+{
+    /* The bit order of A1 matches the endianness of the platform */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (row[x / 32] >> (31 - x % 32)) & 1;
+#else
+    return (row[x / 32] >> (x % 32)) & 1;
+#endif
+}
+
+/** Turn an A1 image surface into a list of YX-banded rectangles.
+ * Rows with the same pixels as the row above extend its rectangles, so that
+ * e.g. rounded rectangles only need a few rectangles per corner.
+ * \param width The width of the shape.
+ * \param height The height of the shape.
+ * \param surf The surface to convert.
+ * \param rects Array of SHAPE_MAX_RECTANGLES rectangles to fill.
+ * \return The number of rectangles, or -1 if the surface is not an A1 image or
+ * needs more than SHAPE_MAX_RECTANGLES rectangles.
+ */
+static int
+xwindow_shape_rectangles(int width, int height, cairo_surface_t *surf, xcb_rectangle_t *rects)
+{
+    if (cairo_surface_get_type(surf) != CAIRO_SURFACE_TYPE_IMAGE
+            || cairo_image_surface_get_format(surf) != CAIRO_FORMAT_A1)
+        return -1;
+
+    cairo_surface_flush(surf);
+    const unsigned char *data = cairo_image_surface_get_data(surf);
+    int stride = cairo_image_surface_get_stride(surf);
+    width = MIN(width, cairo_image_surface_get_width(surf));
+    height = MIN(height, cairo_image_surface_get_height(surf));
+
+    int num_rects = 0, band_start = 0, band_len = 0;
+    for (int y = 0; y < height; y++)
+    {
+        const uint32_t *row = (const uint32_t *) (data + y * stride);
+        int row_start = num_rects, x = 0;
+
+        while (x < width)
+        {
+            /* Skip words which are completely unset */
+            if (x % 32 == 0 && row[x / 32] == 0)
+            {
+                x += 32;
+                continue;
+            }
+            if (!xwindow_shape_bit(row, x))
+            {
+                x++;
+                continue;
+            }
+            int start = x;
+            while (x < width && xwindow_shape_bit(row, x))
+                x++;
+            if (num_rects == SHAPE_MAX_RECTANGLES)
+                return -1;
+            rects[num_rects++] = (xcb_rectangle_t) {
+                .x = start, .y = y, .width = x - start, .height = 1
+            };
+        }
+
+        /* Is this row the same as the rows above? */
+        int row_len = num_rects - row_start;
+        bool same = row_len == band_len && y > 0;
+        for (int i = 0; same && i < row_len; i++)
+            same = rects[row_start + i].x == rects[band_start + i].x
+                && rects[row_start + i].width == rects[band_start + i].width;
+        if (same)
+        {
+            for (int i = 0; i < band_len; i++)
+                rects[band_start + i].height++;
+            num_rects = row_start;
+        }
+        else
+        {
+            band_start = row_start;
+            band_len = row_len;
+        }
+    }
+
+    return num_rects;
+}
+
 /** Set one of a window's shapes */
 void
 xwindow_set_shape(xcb_window_t win, int width, int height, enum xcb_shape_sk_t kind, cairo_surface_t *surf, int offset)
@@ -385,6 +641,19 @@ xwindow_set_shape(xcb_window_t win, int width, int height, enum xcb_shape_sk_t k
         return;
 
     xcb_pixmap_t pixmap = XCB_NONE;
+    if (surf && width > 0 && height > 0)
+    {
+        /* Simple shapes are cheaper to send as rectangles */
+        xcb_rectangle_t rects[SHAPE_MAX_RECTANGLES];
+        int num_rects = xwindow_shape_rectangles(width, height, surf, rects);
+        if (num_rects >= 0)
+        {
+            xcb_shape_rectangles(globalconf.connection, XCB_SHAPE_SO_SET, kind,
+                                 XCB_CLIP_ORDERING_YX_BANDED, win, offset, offset,
+                                 num_rects, rects);
+            return;
+        }
+    }
     if (surf)
         pixmap = xwindow_shape_pixmap(width, height, surf);
 
@@ -37,6 +37,7 @@ double xwindow_get_opacity(xcb_window_t);
 double xwindow_get_opacity_from_cookie(xcb_get_property_cookie_t);
 void xwindow_set_opacity(xcb_window_t, double);
 void xwindow_grabkeys(xcb_window_t, key_array_t *);
+void xwindow_grabkeys_forget(xcb_window_t);
 void xwindow_takefocus(xcb_window_t);
 void xwindow_set_cursor(xcb_window_t, xcb_cursor_t);
 void xwindow_set_border_color(xcb_window_t, color_t *);